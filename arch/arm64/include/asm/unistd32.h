@@ -935,6 +935,10 @@ __SYSCALL(__NR_process_ksm_enable, sys_process_ksm_enable)
 __SYSCALL(__NR_process_ksm_disable, sys_process_ksm_disable)
 #define __NR_process_ksm_status 464
 __SYSCALL(__NR_process_ksm_status, sys_process_ksm_status)
+#define __NR_futex_wakev 465
+__SYSCALL(__NR_futex_wakev, sys_futex_wakev)
+#define __NR_futex_requeuev 466
+__SYSCALL(__NR_futex_requeuev, sys_futex_requeuev)
 
 /*
  * Please add new compat syscalls above this comment and update
@@ -158,7 +158,7 @@ static struct workqueue_struct *tau_workq;
 static void tau_work_func(struct work_struct *work)
 {
 	msleep(shrink_timer);
-	on_each_cpu(tau_timeout, NULL, 0);
+	on_each_cpu_lazy(tau_timeout, NULL);
 	/* schedule ourselves to be run again */
 	queue_work(tau_workq, work);
 }
@@ -11,6 +11,9 @@
 #include <asm/vvar.h>
 
 DEFINE_VVAR(struct vdso_data, _vdso_data);
+#ifdef CONFIG_VDSO_GETRANDOM
+DEFINE_VVAR_SINGLE(vdso_rng_data, _vdso_rng_data);
+#endif
 /*
  * Update the vDSO data page to keep in sync with kernel timekeeping.
  */
@@ -27,6 +27,9 @@
 #define DECLARE_VVAR(offset, type, name) \
 	EMIT_VVAR(name, offset)
 
+#define DECLARE_VVAR_SINGLE(offset, tag, name) \
+	EMIT_VVAR(name, offset)
+
 #else
 
 extern char __vvar_page;
@@ -37,6 +40,11 @@ extern char __vvar_page;
 	extern type timens_ ## name[CS_BASES]				\
 	__attribute__((visibility("hidden")));				\
 
+/* A single struct @tag rather than one per clocksource base */
+#define DECLARE_VVAR_SINGLE(offset, tag, name)				\
+	extern __attribute__((visibility("hidden"))) struct tag	\
+	vvar_ ## name, timens_ ## name;
+
 #define VVAR(name) (vvar_ ## name)
 #define TIMENS(name) (timens_ ## name)
 
@@ -44,12 +52,18 @@ extern char __vvar_page;
 	type name[CS_BASES]						\
 	__attribute__((section(".vvar_" #name), aligned(16))) __visible
 
+#define DEFINE_VVAR_SINGLE(tag, name)					\
+	struct tag name __section(".vvar_" #name) __aligned(16) __visible
+
 #endif
 
 /* DECLARE_VVAR(offset, type, name) */
 
 DECLARE_VVAR(128, struct vdso_data, _vdso_data)
 
+DECLARE_VVAR_SINGLE(640, vdso_rng_data, _vdso_rng_data)
+
 #undef DECLARE_VVAR
+#undef DECLARE_VVAR_SINGLE
 
 #endif
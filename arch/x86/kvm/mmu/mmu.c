@@ -6772,11 +6772,8 @@ void kvm_mmu_zap_collapsible_sptes(struct kvm *kvm,
 		write_unlock(&kvm->mmu_lock);
 	}
 
-	if (tdp_mmu_enabled) {
-		read_lock(&kvm->mmu_lock);
+	if (tdp_mmu_enabled)
 		kvm_tdp_mmu_zap_collapsible_sptes(kvm, slot);
-		read_unlock(&kvm->mmu_lock);
-	}
 }
 
 void kvm_mmu_slot_leaf_clear_dirty(struct kvm *kvm,
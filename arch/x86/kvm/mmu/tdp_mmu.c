@@ -9,8 +9,17 @@
 #include "spte.h"
 
 #include <asm/cmpxchg.h>
+#include <linux/moduleparam.h>
+#include <linux/workqueue.h>
 #include <trace/events/kvm.h>
 
+/*
+ * Number of threads zapping collapsible SPTEs of a memslot in parallel, once
+ * dirty logging is disabled on it.
+ */
+static unsigned int __read_mostly zap_collapsible_workers = 1;
+module_param(zap_collapsible_workers, uint, 0644);
+
 /* Initializes the TDP MMU for the VM, if enabled. */
 void kvm_mmu_init_tdp_mmu(struct kvm *kvm)
 {
@@ -1671,10 +1680,11 @@ void kvm_tdp_mmu_clear_dirty_pt_masked(struct kvm *kvm,
 
 static void zap_collapsible_spte_range(struct kvm *kvm,
 				       struct kvm_mmu_page *root,
-				       const struct kvm_memory_slot *slot)
+				       const struct kvm_memory_slot *slot,
+				       gfn_t start, gfn_t end)
 {
-	gfn_t start = slot->base_gfn;
-	gfn_t end = start + slot->npages;
+	gfn_t slot_start = slot->base_gfn;
+	gfn_t slot_end = slot_start + slot->npages;
 	struct tdp_iter iter;
 	int max_mapping_level;
 
@@ -1704,7 +1714,7 @@ static void zap_collapsible_spte_range(struct kvm *kvm,
 		 * to query that info from slot->arch.lpage_info will cause an
 		 * out-of-bounds access.
 		 */
-		if (iter.gfn < start || iter.gfn >= end)
+		if (iter.gfn < slot_start || iter.gfn >= slot_end)
 			continue;
 
 		max_mapping_level = kvm_mmu_max_mapping_level(kvm, slot,
@@ -1720,18 +1730,82 @@ static void zap_collapsible_spte_range(struct kvm *kvm,
 	rcu_read_unlock();
 }
 
+static void __zap_collapsible_sptes(struct kvm *kvm,
+				    const struct kvm_memory_slot *slot,
+				    gfn_t start, gfn_t end)
+{
+	struct kvm_mmu_page *root;
+
+	read_lock(&kvm->mmu_lock);
+	for_each_valid_tdp_mmu_root_yield_safe(kvm, root, slot->as_id)
+		zap_collapsible_spte_range(kvm, root, slot, start, end);
+	read_unlock(&kvm->mmu_lock);
+}
+
+struct zap_collapsible_work {
+	struct work_struct work;
+	struct kvm *kvm;
+	const struct kvm_memory_slot *slot;
+	gfn_t start;
+	gfn_t end;
+};
+
+static void zap_collapsible_work_fn(struct work_struct *work)
+{
+	struct zap_collapsible_work *zw;
+
+	zw = container_of(work, struct zap_collapsible_work, work);
+	__zap_collapsible_sptes(zw->kvm, zw->slot, zw->start, zw->end);
+}
+
 /*
  * Zap non-leaf SPTEs (and free their associated page tables) which could
- * be replaced by huge pages, for GFNs within the slot.
+ * be replaced by huge pages, for GFNs within the slot.  mmu_lock is taken
+ * for read.
+ *
+ * Large slots are split in up to zap_collapsible_workers ranges, aligned to
+ * the largest huge page size so that no SPTE that can be collapsed spans two
+ * ranges, which are zapped concurrently by workqueue threads.  The caller
+ * holds slots_lock, keeping the slot alive until all of them are done.
  */
 void kvm_tdp_mmu_zap_collapsible_sptes(struct kvm *kvm,
 				       const struct kvm_memory_slot *slot)
 {
-	struct kvm_mmu_page *root;
+	const gfn_t align = KVM_PAGES_PER_HPAGE(KVM_MAX_HUGEPAGE_LEVEL);
+	gfn_t start = slot->base_gfn;
+	gfn_t end = start + slot->npages;
+	struct zap_collapsible_work *works = NULL;
+	unsigned int i, nr = READ_ONCE(zap_collapsible_workers);
+	gfn_t per, first_end;
+
+	nr = clamp_t(u64, DIV_ROUND_UP(slot->npages, align), 1, max(nr, 1U));
+	if (nr > 1)
+		works = kcalloc(nr - 1, sizeof(*works), GFP_KERNEL_ACCOUNT);
+	if (!works) {
+		__zap_collapsible_sptes(kvm, slot, start, end);
+		return;
+	}
 
-	lockdep_assert_held_read(&kvm->mmu_lock);
-	for_each_valid_tdp_mmu_root_yield_safe(kvm, root, slot->as_id)
-		zap_collapsible_spte_range(kvm, root, slot);
+	per = round_up(DIV_ROUND_UP(slot->npages, nr), align);
+	first_end = min(end, round_down(start, align) + per);
+
+	for (i = 0; i < nr - 1; i++) {
+		struct zap_collapsible_work *zw = &works[i];
+
+		zw->kvm = kvm;
+		zw->slot = slot;
+		zw->start = min(end, first_end + i * per);
+		zw->end = min(end, zw->start + per);
+		INIT_WORK(&zw->work, zap_collapsible_work_fn);
+		if (zw->start < zw->end)
+			queue_work(system_unbound_wq, &zw->work);
+	}
+
+	__zap_collapsible_sptes(kvm, slot, start, first_end);
+
+	for (i = 0; i < nr - 1; i++)
+		flush_work(&works[i].work);
+	kfree(works);
 }
 
 /*
@@ -28,8 +28,20 @@ static struct page *pq_scribble_page;
 
 #define MAX_DISKS 255
 
+/*
+ * Compute the syndrome on the CPU instead of spinning for a descriptor when
+ * the channel has none left, i.e. when the engine is already saturated
+ */
+static bool cpu_fallback;
+module_param(cpu_fallback, bool, 0644);
+MODULE_PARM_DESC(cpu_fallback,
+		 "Generate the syndrome on the CPU when the DMA channel is busy");
+
 /*
  * do_async_gen_syndrome - asynchronously calculate P and/or Q
+ *
+ * Returns NULL, with nothing submitted, if cpu_fallback is set and the
+ * channel is out of descriptors for the first operation of the chain.
  */
 static __async_inline struct dma_async_tx_descriptor *
 do_async_gen_syndrome(struct dma_chan *chan,
@@ -82,6 +94,12 @@ do_async_gen_syndrome(struct dma_chan *chan,
 						     dma_flags);
 			if (likely(tx))
 				break;
+			if (!src_off && READ_ONCE(cpu_fallback)) {
+				submit->flags = flags_orig;
+				submit->cb_fn = cb_fn_orig;
+				submit->cb_param = cb_param_orig;
+				return NULL;
+			}
 			async_tx_quiesce(&submit->depend_tx);
 			dma_async_issue_pending(chan);
 		}
@@ -242,8 +260,14 @@ async_gen_syndrome(struct page **blocks, unsigned int *offsets, int disks,
 		}
 
 		tx = do_async_gen_syndrome(chan, coefs, j, unmap, dma_flags, submit);
-		dmaengine_unmap_put(unmap);
-		return tx;
+		if (likely(tx)) {
+			dmaengine_unmap_put(unmap);
+			return tx;
+		}
+
+		/* the channel is busy, balance the load onto the cpu */
+		pr_debug("%s: (busy) disks: %d len: %zu\n",
+			 __func__, disks, len);
 	}
 
 	dmaengine_unmap_put(unmap);
@@ -217,12 +217,21 @@ static void binder_lru_freelist_add(struct binder_alloc *alloc,
 	}
 }
 
-static int binder_install_single_page(struct binder_alloc *alloc,
-				      struct binder_lru_page *lru_page,
-				      unsigned long addr)
+/* Maximum number of pages installed under one mmap_lock acquisition */
+#define BINDER_INSTALL_BATCH	16
+
+/*
+ * Install up to @nr missing pages starting at @addr with a single
+ * vm_insert_pages() call. Pages that another task installed in the
+ * meantime end the run early; the caller rechecks and calls again.
+ */
+static int binder_install_pages(struct binder_alloc *alloc,
+				unsigned long addr, unsigned long nr)
 {
-	struct page *page;
-	int ret = 0;
+	unsigned long index = (addr - alloc->buffer) / PAGE_SIZE;
+	struct page *pages[BINDER_INSTALL_BATCH];
+	unsigned long i, num;
+	int ret = 0, err;
 
 	if (!mmget_not_zero(alloc->mm))
 		return -ESRCH;
@@ -232,7 +241,12 @@ static int binder_install_single_page(struct binder_alloc *alloc,
 	 * might race to install the same page.
 	 */
 	mmap_write_lock(alloc->mm);
-	if (binder_get_installed_page(lru_page))
+	for (i = 0; i < nr; i++) {
+		if (binder_get_installed_page(&alloc->pages[index + i]))
+			break;
+	}
+	nr = i;
+	if (!nr)
 		goto out;
 
 	if (!alloc->vma) {
@@ -241,24 +255,33 @@ static int binder_install_single_page(struct binder_alloc *alloc,
 		goto out;
 	}
 
-	page = alloc_page(GFP_KERNEL | __GFP_HIGHMEM | __GFP_ZERO);
-	if (!page) {
-		pr_err("%d: failed to allocate page\n", alloc->pid);
-		ret = -ENOMEM;
-		goto out;
+	for (i = 0; i < nr; i++) {
+		pages[i] = alloc_page(GFP_KERNEL | __GFP_HIGHMEM | __GFP_ZERO);
+		if (!pages[i]) {
+			pr_err("%d: failed to allocate page\n", alloc->pid);
+			ret = -ENOMEM;
+			break;
+		}
 	}
-
-	ret = vm_insert_page(alloc->vma, addr, page);
-	if (ret) {
-		pr_err("%d: %s failed to insert page at offset %lx with %d\n",
-		       alloc->pid, __func__, addr - alloc->buffer, ret);
-		__free_page(page);
-		ret = -ENOMEM;
+	nr = i;
+	if (!nr)
 		goto out;
+
+	/* On return, num is the number of pages that were not inserted */
+	num = nr;
+	err = vm_insert_pages(alloc->vma, addr, pages, &num);
+	if (err) {
+		pr_err("%d: %s failed to insert page at offset %lx: %d\n",
+		       alloc->pid, __func__,
+		       addr + (nr - num) * PAGE_SIZE - alloc->buffer, err);
+		ret = err;
 	}
 
 	/* Mark page installation complete and safe to use */
-	binder_set_installed_page(lru_page, page);
+	for (i = 0; i < nr - num; i++)
+		binder_set_installed_page(&alloc->pages[index + i], pages[i]);
+	for (; i < nr; i++)
+		__free_page(pages[i]);
 out:
 	mmap_write_unlock(alloc->mm);
 	mmput_async(alloc->mm);
@@ -269,26 +292,33 @@ static int binder_install_buffer_pages(struct binder_alloc *alloc,
 				       struct binder_buffer *buffer,
 				       size_t size)
 {
-	struct binder_lru_page *page;
 	unsigned long start, final;
 	unsigned long page_addr;
 
 	start = buffer->user_data & PAGE_MASK;
 	final = PAGE_ALIGN(buffer->user_data + size);
 
-	for (page_addr = start; page_addr < final; page_addr += PAGE_SIZE) {
-		unsigned long index;
+	page_addr = start;
+	while (page_addr < final) {
+		unsigned long index, nr;
 		int ret;
 
 		index = (page_addr - alloc->buffer) / PAGE_SIZE;
-		page = &alloc->pages[index];
-
-		if (binder_get_installed_page(page))
+		if (binder_get_installed_page(&alloc->pages[index])) {
+			page_addr += PAGE_SIZE;
 			continue;
+		}
+
+		/* Gather the run of missing pages starting here */
+		for (nr = 1; nr < BINDER_INSTALL_BATCH &&
+			     page_addr + nr * PAGE_SIZE < final; nr++) {
+			if (binder_get_installed_page(&alloc->pages[index + nr]))
+				break;
+		}
 
 		trace_binder_alloc_page_start(alloc, index);
 
-		ret = binder_install_single_page(alloc, page, page_addr);
+		ret = binder_install_pages(alloc, page_addr, nr);
 		if (ret)
 			return ret;
 
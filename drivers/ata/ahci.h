@@ -72,6 +72,8 @@ enum {
 	HOST_IRQ_STAT		= 0x08, /* interrupt status */
 	HOST_PORTS_IMPL		= 0x0c, /* bitmap of implemented ports */
 	HOST_VERSION		= 0x10, /* AHCI spec. version compliancy */
+	HOST_CCC_CTL		= 0x14, /* Command Completion Coalescing Control */
+	HOST_CCC_PORTS		= 0x18, /* ports coalesced by CCC */
 	HOST_EM_LOC		= 0x1c, /* Enclosure Management location */
 	HOST_EM_CTL		= 0x20, /* Enclosure Management Control */
 	HOST_CAP2		= 0x24, /* host capabilities, extended */
@@ -82,6 +84,13 @@ enum {
 	HOST_MRSM		= BIT(2),  /* MSI Revert to Single Message */
 	HOST_AHCI_EN		= BIT(31), /* AHCI enabled */
 
+	/* HOST_CCC_CTL bits */
+	HOST_CCC_EN		= BIT(0),  /* CCC enable */
+	HOST_CCC_INT_SHIFT	= 3,	   /* interrupt used by CCC */
+	HOST_CCC_INT_MASK	= 0x1f,
+	HOST_CCC_CC_SHIFT	= 8,	   /* command completions */
+	HOST_CCC_TV_SHIFT	= 16,	   /* timeout value in ms */
+
 	/* HOST_CAP bits */
 	HOST_CAP_SXS		= BIT(5),  /* Supports External SATA */
 	HOST_CAP_EMS		= BIT(6),  /* Enclosure Management support */
@@ -343,6 +352,9 @@ struct ahci_host_priv {
 	u32			em_buf_sz;	/* EM buffer size in byte */
 	u32			em_msg_type;	/* EM message type */
 	u32			remapped_nvme;	/* NVMe remapped device count */
+	u32			ccc_ports;	/* ports coalesced by CCC */
+	u32			ccc_ctl;	/* HOST_CCC_CTL when enabled */
+	unsigned int		ccc_int;	/* IS bit of CCC interrupts */
 	bool			got_runtime_pm; /* Did we do pm_runtime_get? */
 	unsigned int		n_clks;
 	struct clk_bulk_data	*clks;		/* Optional */
@@ -100,6 +100,11 @@ static ssize_t ahci_store_em_buffer(struct device *dev,
 				    const char *buf, size_t size);
 static ssize_t ahci_show_em_supported(struct device *dev,
 				      struct device_attribute *attr, char *buf);
+static ssize_t ahci_show_ccc(struct device *dev,
+			     struct device_attribute *attr, char *buf);
+static ssize_t ahci_store_ccc(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t size);
 static irqreturn_t ahci_single_level_irq_intr(int irq, void *dev_instance);
 
 static DEVICE_ATTR(ahci_host_caps, S_IRUGO, ahci_show_host_caps, NULL);
@@ -109,6 +114,7 @@ static DEVICE_ATTR(ahci_port_cmd, S_IRUGO, ahci_show_port_cmd, NULL);
 static DEVICE_ATTR(em_buffer, S_IWUSR | S_IRUGO,
 		   ahci_read_em_buffer, ahci_store_em_buffer);
 static DEVICE_ATTR(em_message_supported, S_IRUGO, ahci_show_em_supported, NULL);
+static DEVICE_ATTR(ahci_ccc, 0644, ahci_show_ccc, ahci_store_ccc);
 
 static struct attribute *ahci_shost_attrs[] = {
 	&dev_attr_link_power_management_policy.attr,
@@ -120,6 +126,7 @@ static struct attribute *ahci_shost_attrs[] = {
 	&dev_attr_ahci_port_cmd.attr,
 	&dev_attr_em_buffer.attr,
 	&dev_attr_em_message_supported.attr,
+	&dev_attr_ahci_ccc.attr,
 	NULL
 };
 
@@ -302,6 +309,84 @@ static ssize_t ahci_show_port_cmd(struct device *dev,
 	return ret;
 }
 
+/*
+ * Program Command Completion Coalescing from hpriv.  CC and TV may only be
+ * changed while CCC is disabled.  Called with the host lock held or while
+ * the host is being (re)initialized.
+ */
+static void ahci_ccc_write(struct ahci_host_priv *hpriv)
+{
+	void __iomem *mmio = hpriv->mmio;
+
+	writel(readl(mmio + HOST_CCC_CTL) & ~HOST_CCC_EN, mmio + HOST_CCC_CTL);
+	writel(hpriv->ccc_ports, mmio + HOST_CCC_PORTS);
+	if (hpriv->ccc_ports)
+		writel(hpriv->ccc_ctl | HOST_CCC_EN, mmio + HOST_CCC_CTL);
+	readl(mmio + HOST_CCC_CTL); /* flush */
+}
+
+static ssize_t ahci_show_ccc(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	struct Scsi_Host *shost = class_to_shost(dev);
+	struct ata_port *ap = ata_shost_to_port(shost);
+	struct ahci_host_priv *hpriv = ap->host->private_data;
+
+	if (!(hpriv->ccc_ports & BIT(ap->port_no)))
+		return sprintf(buf, "0\n");
+
+	return sprintf(buf, "%u %u\n",
+		       (hpriv->ccc_ctl >> HOST_CCC_CC_SHIFT) & 0xff,
+		       hpriv->ccc_ctl >> HOST_CCC_TV_SHIFT);
+}
+
+/*
+ * "<completions> <timeout in ms>" coalesces the completion interrupts of the
+ * port until that many commands completed or the oldest completion is that
+ * old.  The values are shared by all the coalesced ports of the host.
+ * "0" stops coalescing the port.
+ */
+static ssize_t ahci_store_ccc(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t size)
+{
+	struct Scsi_Host *shost = class_to_shost(dev);
+	struct ata_port *ap = ata_shost_to_port(shost);
+	struct ahci_host_priv *hpriv = ap->host->private_data;
+	unsigned int cc, tv = 0;
+	unsigned long flags;
+	int n;
+
+	/* The CCC interrupt is a single host-wide one */
+	if (!(hpriv->cap & HOST_CAP_CCC) ||
+	    hpriv->irq_handler != ahci_single_level_irq_intr ||
+	    (hpriv->flags & AHCI_HFLAG_MULTI_MSI))
+		return -EOPNOTSUPP;
+
+	n = sscanf(buf, "%u %u", &cc, &tv);
+	if (n < 1 || (n == 1 && cc) || cc > 0xff || (n == 2 && (!tv || tv > 0xffff)))
+		return -EINVAL;
+
+	ahci_rpm_get_port(ap);
+	spin_lock_irqsave(ap->lock, flags);
+
+	if (tv) {
+		hpriv->ccc_ctl = tv << HOST_CCC_TV_SHIFT |
+				 cc << HOST_CCC_CC_SHIFT;
+		hpriv->ccc_ports |= BIT(ap->port_no);
+	} else {
+		hpriv->ccc_ports &= ~BIT(ap->port_no);
+	}
+	hpriv->ccc_int = (readl(hpriv->mmio + HOST_CCC_CTL) >>
+			  HOST_CCC_INT_SHIFT) & HOST_CCC_INT_MASK;
+	ahci_ccc_write(hpriv);
+
+	spin_unlock_irqrestore(ap->lock, flags);
+	ahci_rpm_put_port(ap);
+
+	return size;
+}
+
 static ssize_t ahci_read_em_buffer(struct device *dev,
 				   struct device_attribute *attr, char *buf)
 {
@@ -1309,6 +1394,10 @@ void ahci_init_controller(struct ata_host *host)
 		ahci_port_init(host->dev, ap, i, mmio, port_mmio);
 	}
 
+	/* Coalescing set up through sysfs doesn't survive a host reset */
+	if (hpriv->ccc_ports)
+		ahci_ccc_write(hpriv);
+
 	tmp = readl(mmio + HOST_CTL);
 	dev_dbg(host->dev, "HOST_CTL 0x%x\n", tmp);
 	writel(tmp | HOST_IRQ_EN, mmio + HOST_CTL);
@@ -2019,6 +2108,10 @@ static irqreturn_t ahci_single_level_irq_intr(int irq, void *dev_instance)
 
 	irq_masked = irq_stat & hpriv->port_map;
 
+	/* Coalesced completions only raise the CCC interrupt */
+	if (hpriv->ccc_ports && (irq_stat & BIT(hpriv->ccc_int)))
+		irq_masked |= hpriv->ccc_ports;
+
 	spin_lock(&host->lock);
 
 	rc = ahci_handle_port_intr(host, irq_masked);
@@ -7,6 +7,9 @@
 
 #include <linux/moduleparam.h>
 #include <linux/sched.h>
+#include <linux/sched/clock.h>
+#include <linux/random.h>
+#include <linux/percpu.h>
 #include <linux/fs.h>
 #include <linux/init.h>
 #include "null_blk.h"
@@ -452,6 +455,8 @@ NULLB_DEVICE_ATTR(virt_boundary, bool, NULL);
 NULLB_DEVICE_ATTR(no_sched, bool, NULL);
 NULLB_DEVICE_ATTR(shared_tags, bool, NULL);
 NULLB_DEVICE_ATTR(shared_tag_bitmap, bool, NULL);
+NULLB_DEVICE_ATTR(cpu_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(latency_stats, bool, NULL);
 
 static ssize_t nullb_device_power_show(struct config_item *item, char *page)
 {
@@ -570,6 +575,159 @@ static ssize_t nullb_device_zone_offline_store(struct config_item *item,
 }
 CONFIGFS_ATTR_WO(nullb_device_, zone_offline);
 
+static ssize_t nullb_device_latency_dist_show(struct config_item *item,
+					      char *page)
+{
+	struct nullb_device *dev = to_nullb_device(item);
+	unsigned int i;
+	ssize_t len = 0;
+
+	for (i = 0; i < dev->nr_lat_dist; i++)
+		len += scnprintf(page + len, PAGE_SIZE - len, "%s%llu-%llu:%u",
+				 i ? "," : "", dev->lat_dist[i].lo,
+				 dev->lat_dist[i].hi, dev->lat_dist[i].weight);
+	len += scnprintf(page + len, PAGE_SIZE - len, "\n");
+	return len;
+}
+
+/*
+ * "lo[-hi]:weight,..." completes the given share of the requests with a
+ * latency drawn uniformly from each range of nanoseconds, in timer mode,
+ * instead of completion_nsec. An empty string goes back to completion_nsec.
+ */
+static ssize_t nullb_device_latency_dist_store(struct config_item *item,
+					       const char *page, size_t count)
+{
+	struct nullb_device *dev = to_nullb_device(item);
+	struct nullb_lat_range dist[NULLB_LAT_DIST_MAX];
+	unsigned int nr = 0, total = 0;
+	char *orig, *buf, *tok;
+	int ret = -EINVAL;
+
+	if (test_bit(NULLB_DEV_FL_CONFIGURED, &dev->flags))
+		return -EBUSY;
+
+	orig = kstrndup(page, count, GFP_KERNEL);
+	if (!orig)
+		return -ENOMEM;
+
+	buf = strstrip(orig);
+	while ((tok = strsep(&buf, ",")) && *tok) {
+		struct nullb_lat_range *r = &dist[nr];
+		char *weight, *hi;
+
+		if (nr == NULLB_LAT_DIST_MAX)
+			goto out;
+		weight = strchr(tok, ':');
+		if (!weight)
+			goto out;
+		*weight++ = '\0';
+		hi = strchr(tok, '-');
+		if (hi)
+			*hi++ = '\0';
+
+		if (kstrtoull(tok, 0, &r->lo) ||
+		    kstrtoull(hi ?: tok, 0, &r->hi) ||
+		    kstrtouint(weight, 0, &r->weight))
+			goto out;
+		if (r->lo > r->hi || r->hi - r->lo >= U32_MAX || !r->weight ||
+		    check_add_overflow(total, r->weight, &total))
+			goto out;
+		nr++;
+	}
+
+	memcpy(dev->lat_dist, dist, nr * sizeof(*dist));
+	dev->lat_dist_weight = total;
+	dev->nr_lat_dist = nr;
+	ret = count;
+out:
+	kfree(orig);
+	return ret;
+}
+CONFIGFS_ATTR(nullb_device_, latency_dist);
+
+static unsigned int null_lat_bucket(u64 ns)
+{
+	unsigned int shift;
+
+	if (ns < 8)
+		return ns;
+	shift = ilog2(ns) - 2;
+	return (shift + 1) * 4 + ((ns >> shift) & 3);
+}
+
+/* The lowest latency of bucket @b */
+static u64 null_lat_bucket_ns(unsigned int b)
+{
+	if (b < 8)
+		return b;
+	return (u64)(4 + b % 4) << (b / 4 - 1);
+}
+
+static ssize_t nullb_device_latency_show(struct config_item *item, char *page)
+{
+	static const unsigned int permyriads[] = { 5000, 9000, 9900, 9990, 9999 };
+	struct nullb_device *dev = to_nullb_device(item);
+	unsigned int b, p = 0, max = 0;
+	u64 total = 0, sum = 0;
+	struct nullb_lat_hist *hist;
+	ssize_t len;
+	int cpu;
+
+	hist = kzalloc(sizeof(*hist), GFP_KERNEL);
+	if (!hist)
+		return -ENOMEM;
+
+	/* Racy against completions, good enough for statistics */
+	for_each_possible_cpu(cpu) {
+		struct nullb_lat_hist *h = per_cpu_ptr(dev->lat_hist, cpu);
+
+		for (b = 0; b < NULLB_LAT_BUCKETS; b++)
+			hist->buckets[b] += READ_ONCE(h->buckets[b]);
+	}
+	for (b = 0; b < NULLB_LAT_BUCKETS; b++) {
+		total += hist->buckets[b];
+		if (hist->buckets[b])
+			max = b;
+	}
+
+	len = scnprintf(page, PAGE_SIZE, "count %llu\n", total);
+	if (!total)
+		goto out;
+
+	/* Percentiles are given as the lowest latency of their bucket */
+	for (b = 0; b < NULLB_LAT_BUCKETS && p < ARRAY_SIZE(permyriads); b++) {
+		sum += hist->buckets[b];
+		while (p < ARRAY_SIZE(permyriads) &&
+		       sum * 10000 >= total * permyriads[p]) {
+			len += scnprintf(page + len, PAGE_SIZE - len,
+					 "p%u.%02u %llu\n", permyriads[p] / 100,
+					 permyriads[p] % 100,
+					 null_lat_bucket_ns(b));
+			p++;
+		}
+	}
+	len += scnprintf(page + len, PAGE_SIZE - len, "max %llu\n",
+			 null_lat_bucket_ns(max));
+out:
+	kfree(hist);
+	return len;
+}
+
+/* Writing anything clears the latency histogram */
+static ssize_t nullb_device_latency_store(struct config_item *item,
+					  const char *page, size_t count)
+{
+	struct nullb_device *dev = to_nullb_device(item);
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(dev->lat_hist, cpu), 0,
+		       sizeof(struct nullb_lat_hist));
+	return count;
+}
+CONFIGFS_ATTR(nullb_device_, latency);
+
 static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_size,
 	&nullb_device_attr_completion_nsec,
@@ -602,6 +760,10 @@ static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_no_sched,
 	&nullb_device_attr_shared_tags,
 	&nullb_device_attr_shared_tag_bitmap,
+	&nullb_device_attr_cpu_nsec,
+	&nullb_device_attr_latency_stats,
+	&nullb_device_attr_latency_dist,
+	&nullb_device_attr_latency,
 	NULL,
 };
 
@@ -681,8 +843,9 @@ static ssize_t memb_group_features_show(struct config_item *item, char *page)
 {
 	return snprintf(page, PAGE_SIZE,
 			"badblocks,blocking,blocksize,cache_size,"
-			"completion_nsec,discard,home_node,hw_queue_depth,"
-			"irqmode,max_sectors,mbps,memory_backed,no_sched,"
+			"completion_nsec,cpu_nsec,discard,home_node,"
+			"hw_queue_depth,irqmode,latency,latency_dist,"
+			"latency_stats,max_sectors,mbps,memory_backed,no_sched,"
 			"poll_queues,power,queue_mode,shared_tag_bitmap,"
 			"shared_tags,size,submit_queues,use_per_node_hctx,"
 			"virt_boundary,zoned,zone_capacity,zone_max_active,"
@@ -738,7 +901,13 @@ static struct nullb_device *null_alloc_dev(void)
 
 	INIT_RADIX_TREE(&dev->data, GFP_ATOMIC);
 	INIT_RADIX_TREE(&dev->cache, GFP_ATOMIC);
+	dev->lat_hist = alloc_percpu(struct nullb_lat_hist);
+	if (!dev->lat_hist) {
+		kfree(dev);
+		return NULL;
+	}
 	if (badblocks_init(&dev->badblocks, 0)) {
+		free_percpu(dev->lat_hist);
 		kfree(dev);
 		return NULL;
 	}
@@ -781,20 +950,50 @@ static void null_free_dev(struct nullb_device *dev)
 
 	null_free_zoned_dev(dev);
 	badblocks_exit(&dev->badblocks);
+	free_percpu(dev->lat_hist);
 	kfree(dev);
 }
 
+static void null_record_latency(struct nullb_cmd *cmd)
+{
+	u64 lat;
+
+	if (!cmd->start_ns)
+		return;
+	lat = ktime_get_ns() - cmd->start_ns;
+	this_cpu_inc(cmd->nq->dev->lat_hist->buckets[null_lat_bucket(lat)]);
+}
+
 static enum hrtimer_restart null_cmd_timer_expired(struct hrtimer *timer)
 {
 	struct nullb_cmd *cmd = container_of(timer, struct nullb_cmd, timer);
 
+	null_record_latency(cmd);
 	blk_mq_end_request(blk_mq_rq_from_pdu(cmd), cmd->error);
 	return HRTIMER_NORESTART;
 }
 
+/* Draw a completion latency from latency_dist, or use completion_nsec */
+static u64 null_cmd_latency(struct nullb_device *dev)
+{
+	const struct nullb_lat_range *r = dev->lat_dist;
+	unsigned int w;
+
+	if (!dev->nr_lat_dist)
+		return dev->completion_nsec;
+
+	w = get_random_u32_below(dev->lat_dist_weight);
+	while (w >= r->weight) {
+		w -= r->weight;
+		r++;
+	}
+
+	return r->lo + get_random_u32_below(r->hi - r->lo + 1);
+}
+
 static void null_cmd_end_timer(struct nullb_cmd *cmd)
 {
-	ktime_t kt = cmd->nq->dev->completion_nsec;
+	ktime_t kt = null_cmd_latency(cmd->nq->dev);
 
 	hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_REL);
 }
@@ -803,6 +1002,7 @@ static void null_complete_rq(struct request *rq)
 {
 	struct nullb_cmd *cmd = blk_mq_rq_to_pdu(rq);
 
+	null_record_latency(cmd);
 	blk_mq_end_request(rq, cmd->error);
 }
 
@@ -1325,6 +1525,7 @@ static inline void nullb_complete_cmd(struct nullb_cmd *cmd)
 		blk_mq_complete_request(rq);
 		break;
 	case NULL_IRQ_NONE:
+		null_record_latency(cmd);
 		blk_mq_end_request(rq, cmd->error);
 		break;
 	case NULL_IRQ_TIMER:
@@ -1520,6 +1721,7 @@ static int null_poll(struct blk_mq_hw_ctx *hctx, struct io_comp_batch *iob)
 		cmd = blk_mq_rq_to_pdu(req);
 		cmd->error = null_process_cmd(cmd, req_op(req), blk_rq_pos(req),
 						blk_rq_sectors(req));
+		null_record_latency(cmd);
 		if (!blk_mq_add_to_batch(req, iob, (__force int) cmd->error,
 					blk_mq_end_request_batch))
 			blk_mq_end_request(req, cmd->error);
@@ -1580,6 +1782,7 @@ static blk_status_t null_queue_rq(struct blk_mq_hw_ctx *hctx,
 	}
 	cmd->error = BLK_STS_OK;
 	cmd->nq = nq;
+	cmd->start_ns = nq->dev->latency_stats ? ktime_get_ns() : 0;
 	cmd->fake_timeout = should_timeout_request(rq) ||
 		blk_should_fake_timeout(rq->q);
 
@@ -1613,6 +1816,14 @@ static blk_status_t null_queue_rq(struct blk_mq_hw_ctx *hctx,
 	if (cmd->fake_timeout)
 		return BLK_STS_OK;
 
+	/* Emulate the CPU cost of a driver submitting to real hardware */
+	if (nq->dev->cpu_nsec) {
+		u64 start = local_clock();
+
+		while (local_clock() - start < nq->dev->cpu_nsec)
+			cpu_relax();
+	}
+
 	null_handle_cmd(cmd, sector, nr_sectors, req_op(rq));
 	return BLK_STS_OK;
 }
@@ -20,6 +20,7 @@ struct nullb_cmd {
 	bool fake_timeout;
 	struct nullb_queue *nq;
 	struct hrtimer timer;
+	u64 start_ns; /* submission time, if latency_stats */
 };
 
 struct nullb_queue {
@@ -50,6 +51,21 @@ struct nullb_zone {
 	unsigned int capacity;
 };
 
+/* A range of completion latencies and its weight, see latency_dist */
+struct nullb_lat_range {
+	u64 lo;
+	u64 hi;
+	unsigned int weight;
+};
+
+#define NULLB_LAT_DIST_MAX	16
+/* Log-linear latency histogram, 4 buckets per power of 2 of nanoseconds */
+#define NULLB_LAT_BUCKETS	256
+
+struct nullb_lat_hist {
+	u64 buckets[NULLB_LAT_BUCKETS];
+};
+
 struct nullb_device {
 	struct nullb *nullb;
 	struct config_group group;
@@ -104,6 +120,15 @@ struct nullb_device {
 	bool no_sched; /* no IO scheduler for the device */
 	bool shared_tags; /* share tag set between devices for blk-mq */
 	bool shared_tag_bitmap; /* use hostwide shared tags */
+	unsigned long cpu_nsec; /* CPU time in ns to submit a request */
+	bool latency_stats; /* record the latency of requests */
+
+	/* completion latency distribution in timer mode, if nr_lat_dist */
+	unsigned int nr_lat_dist;
+	unsigned int lat_dist_weight; /* sum of the weights */
+	struct nullb_lat_range lat_dist[NULLB_LAT_DIST_MAX];
+
+	struct nullb_lat_hist __percpu *lat_hist; /* summed by the reader */
 };
 
 struct nullb {
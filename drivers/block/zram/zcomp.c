@@ -12,6 +12,8 @@
 #include <linux/cpu.h>
 #include <linux/crypto.h>
 #include <linux/vmalloc.h>
+#include <linux/scatterlist.h>
+#include <crypto/acompress.h>
 
 #include "zcomp.h"
 
@@ -34,28 +36,167 @@ static const char * const backends[] = {
 #endif
 };
 
+#ifdef CONFIG_ZRAM_ZSTD_DICT
+/* Same level the crypto zstd backend compresses at */
+#define ZCOMP_ZSTD_LEVEL	3
+
+static bool zcomp_has_dict(struct zcomp *comp)
+{
+	return comp->zstd.cdict;
+}
+
+static void zcomp_dict_free(struct zcomp *comp)
+{
+	if (comp->zstd.percpu_dctx)
+		zstd_percpu_dctx_put();
+	kvfree(comp->zstd.cdict_mem);
+	kvfree(comp->zstd.ddict_mem);
+	memset(&comp->zstd, 0, sizeof(comp->zstd));
+}
+
+/*
+ * Digest @dict for compression and decompression. Only zstd knows about
+ * dictionaries; other algorithms ignore it.
+ */
+static int zcomp_dict_init(struct zcomp *comp, const void *dict, size_t dict_sz)
+{
+	size_t csz, dsz;
+
+	if (!dict || strcmp(comp->name, "zstd"))
+		return 0;
+
+	comp->zstd.params = zstd_get_params(ZCOMP_ZSTD_LEVEL, PAGE_SIZE);
+	csz = zstd_cdict_workspace_bound(dict_sz, &comp->zstd.params.cParams);
+	dsz = zstd_ddict_workspace_bound(dict_sz);
+
+	comp->zstd.cdict_mem = kvmalloc(csz, GFP_KERNEL);
+	comp->zstd.ddict_mem = kvmalloc(dsz, GFP_KERNEL);
+	if (!comp->zstd.cdict_mem || !comp->zstd.ddict_mem) {
+		zcomp_dict_free(comp);
+		return -ENOMEM;
+	}
+
+	comp->zstd.cdict = zstd_init_cdict(comp->zstd.cdict_mem, csz, dict,
+					   dict_sz, &comp->zstd.params.cParams);
+	comp->zstd.ddict = zstd_init_ddict(comp->zstd.ddict_mem, dsz, dict,
+					   dict_sz);
+	if (!comp->zstd.cdict || !comp->zstd.ddict) {
+		zcomp_dict_free(comp);
+		return -EINVAL;
+	}
+
+	/* Decompression uses the contexts shared with other zstd users */
+	if (zstd_percpu_dctx_get()) {
+		zcomp_dict_free(comp);
+		return -ENOMEM;
+	}
+	comp->zstd.percpu_dctx = true;
+	return 0;
+}
+
+static void zcomp_strm_zstd_free(struct zcomp_strm *zstrm)
+{
+	vfree(zstrm->zstd.cwksp);
+	memset(&zstrm->zstd, 0, sizeof(zstrm->zstd));
+}
+
+static int zcomp_strm_zstd_init(struct zcomp_strm *zstrm, struct zcomp *comp)
+{
+	size_t csz = zstd_cctx_workspace_bound(&comp->zstd.params.cParams);
+
+	zstrm->zstd.cwksp = vzalloc(csz);
+	zstrm->zstd.cctx = zstd_init_cctx(zstrm->zstd.cwksp, csz);
+	if (!zstrm->zstd.cctx)
+		goto error;
+
+	zstrm->zstd.cdict = comp->zstd.cdict;
+	zstrm->zstd.ddict = comp->zstd.ddict;
+	return 0;
+
+error:
+	zcomp_strm_zstd_free(zstrm);
+	return -ENOMEM;
+}
+
+static int zcomp_zstd_compress(struct zcomp_strm *zstrm,
+		const void *src, unsigned int *dst_len)
+{
+	size_t ret;
+
+	ret = zstd_compress_using_cdict(zstrm->zstd.cctx, zstrm->buffer,
+					PAGE_SIZE * 2, src, PAGE_SIZE,
+					zstrm->zstd.cdict);
+	if (zstd_is_error(ret))
+		return -EINVAL;
+
+	*dst_len = ret;
+	return 0;
+}
+
+static int zcomp_zstd_decompress(struct zcomp_strm *zstrm,
+		const void *src, unsigned int src_len, void *dst)
+{
+	size_t ret;
+
+	ret = zstd_decompress_percpu(dst, PAGE_SIZE, src, src_len,
+				     zstrm->zstd.ddict);
+	if (zstd_is_error(ret) || ret != PAGE_SIZE)
+		return -EINVAL;
+	return 0;
+}
+#else
+static bool zcomp_has_dict(struct zcomp *comp) { return false; }
+static void zcomp_dict_free(struct zcomp *comp) {}
+static int zcomp_dict_init(struct zcomp *comp, const void *dict, size_t dict_sz)
+{
+	return 0;
+}
+static void zcomp_strm_zstd_free(struct zcomp_strm *zstrm) {}
+static int zcomp_strm_zstd_init(struct zcomp_strm *zstrm, struct zcomp *comp)
+{
+	return -EINVAL;
+}
+static int zcomp_zstd_compress(struct zcomp_strm *zstrm,
+		const void *src, unsigned int *dst_len)
+{
+	return -EINVAL;
+}
+static int zcomp_zstd_decompress(struct zcomp_strm *zstrm,
+		const void *src, unsigned int src_len, void *dst)
+{
+	return -EINVAL;
+}
+#endif
+
 static void zcomp_strm_free(struct zcomp_strm *zstrm)
 {
 	if (!IS_ERR_OR_NULL(zstrm->tfm))
 		crypto_free_comp(zstrm->tfm);
+	zcomp_strm_zstd_free(zstrm);
 	vfree(zstrm->buffer);
 	zstrm->tfm = NULL;
 	zstrm->buffer = NULL;
 }
 
 /*
- * Initialize zcomp_strm structure with ->tfm initialized by backend, and
- * ->buffer. Return a negative value on error.
+ * Initialize zcomp_strm structure with ->tfm initialized by backend (or
+ * zstd contexts when there is a dictionary), and ->buffer. Return a
+ * negative value on error.
  */
 static int zcomp_strm_init(struct zcomp_strm *zstrm, struct zcomp *comp)
 {
-	zstrm->tfm = crypto_alloc_comp(comp->name, 0, 0);
+	int ret = 0;
+
+	if (zcomp_has_dict(comp))
+		ret = zcomp_strm_zstd_init(zstrm, comp);
+	else
+		zstrm->tfm = crypto_alloc_comp(comp->name, 0, 0);
 	/*
 	 * allocate 2 pages. 1 for compressed data, plus 1 extra for the
 	 * case when compressed size is larger than the original one
 	 */
 	zstrm->buffer = vzalloc(2 * PAGE_SIZE);
-	if (IS_ERR_OR_NULL(zstrm->tfm) || !zstrm->buffer) {
+	if (ret || IS_ERR(zstrm->tfm) || !zstrm->buffer) {
 		zcomp_strm_free(zstrm);
 		return -ENOMEM;
 	}
@@ -134,16 +275,79 @@ int zcomp_compress(struct zcomp_strm *zstrm,
 	 */
 	*dst_len = PAGE_SIZE * 2;
 
+	if (!zstrm->tfm)
+		return zcomp_zstd_compress(zstrm, src, dst_len);
+
 	return crypto_comp_compress(zstrm->tfm,
 			src, PAGE_SIZE,
 			zstrm->buffer, dst_len);
 }
 
+/*
+ * Take an idle asynchronous stream. Returns NULL if the algorithm has no
+ * asynchronous implementation, or if all of its streams are in flight; the
+ * caller then compresses on a per-CPU stream.
+ */
+struct zcomp_strm *zcomp_astream_get(struct zcomp *comp)
+{
+	struct zcomp_strm *zstrm;
+
+	if (!comp->atfm)
+		return NULL;
+
+	spin_lock(&comp->astream_lock);
+	zstrm = list_first_entry_or_null(&comp->astream_idle,
+					 struct zcomp_strm, node);
+	if (zstrm)
+		list_del(&zstrm->node);
+	spin_unlock(&comp->astream_lock);
+
+	return zstrm;
+}
+
+void zcomp_astream_put(struct zcomp *comp, struct zcomp_strm *zstrm)
+{
+	spin_lock(&comp->astream_lock);
+	list_add(&zstrm->node, &comp->astream_idle);
+	spin_unlock(&comp->astream_lock);
+}
+
+/*
+ * Compress @page into zstrm->buffer on an asynchronous stream and wait for
+ * the result. Must be called from a context that can sleep. Requests are
+ * not backlogged: -EBUSY means the accelerator's queue is full and the page
+ * should be compressed on the CPU instead.
+ */
+int zcomp_acompress(struct zcomp_strm *zstrm,
+		struct page *page, unsigned int *dst_len)
+{
+	struct scatterlist input, output;
+	int ret;
+
+	sg_init_table(&input, 1);
+	sg_set_page(&input, page, PAGE_SIZE, 0);
+	sg_init_one(&output, zstrm->buffer, PAGE_SIZE * 2);
+	acomp_request_set_params(zstrm->req, &input, &output,
+				 PAGE_SIZE, PAGE_SIZE * 2);
+
+	ret = crypto_acomp_compress(zstrm->req);
+	if (ret == -EBUSY || ret == -ENOSPC)
+		return -EBUSY;
+
+	ret = crypto_wait_req(ret, &zstrm->wait);
+	if (!ret)
+		*dst_len = zstrm->req->dlen;
+	return ret;
+}
+
 int zcomp_decompress(struct zcomp_strm *zstrm,
 		const void *src, unsigned int src_len, void *dst)
 {
 	unsigned int dst_len = PAGE_SIZE;
 
+	if (!zstrm->tfm)
+		return zcomp_zstd_decompress(zstrm, src, src_len, dst);
+
 	return crypto_comp_decompress(zstrm->tfm,
 			src, src_len,
 			dst, &dst_len);
@@ -174,6 +378,79 @@ int zcomp_cpu_dead(unsigned int cpu, struct hlist_node *node)
 	return 0;
 }
 
+static void zcomp_astreams_free(struct zcomp *comp)
+{
+	unsigned int i;
+
+	for (i = 0; i < comp->nr_astreams; i++) {
+		acomp_request_free(comp->astreams[i].req);
+		kfree(comp->astreams[i].buffer);
+	}
+	kfree(comp->astreams);
+	crypto_free_acomp(comp->atfm);
+	comp->astreams = NULL;
+	comp->nr_astreams = 0;
+	comp->atfm = NULL;
+}
+
+/*
+ * Set up one asynchronous stream per online CPU if an asynchronous
+ * implementation of the algorithm exists. Synchronous acomp implementations
+ * are skipped, the per-CPU streams serve those better. Failing here is not
+ * fatal, zcomp then just runs on the CPU.
+ */
+static void zcomp_astreams_init(struct zcomp *comp)
+{
+	struct crypto_acomp *atfm;
+	unsigned int i, nr;
+
+	spin_lock_init(&comp->astream_lock);
+	INIT_LIST_HEAD(&comp->astream_idle);
+
+	/* No acomp implementation knows about our dictionary */
+	if (zcomp_has_dict(comp))
+		return;
+
+	atfm = crypto_alloc_acomp(comp->name, CRYPTO_ALG_ASYNC, CRYPTO_ALG_ASYNC);
+	if (IS_ERR(atfm))
+		return;
+
+	nr = num_online_cpus();
+	comp->astreams = kcalloc(nr, sizeof(*comp->astreams), GFP_KERNEL);
+	if (!comp->astreams) {
+		crypto_free_acomp(atfm);
+		return;
+	}
+	comp->atfm = atfm;
+
+	for (i = 0; i < nr; i++) {
+		struct zcomp_strm *zstrm = &comp->astreams[i];
+
+		zstrm->buffer = kmalloc(PAGE_SIZE * 2, GFP_KERNEL);
+		zstrm->req = acomp_request_alloc(atfm);
+		if (!zstrm->buffer || !zstrm->req) {
+			kfree(zstrm->buffer);
+			if (zstrm->req)
+				acomp_request_free(zstrm->req);
+			break;
+		}
+
+		crypto_init_wait(&zstrm->wait);
+		acomp_request_set_callback(zstrm->req, CRYPTO_TFM_REQ_MAY_SLEEP,
+					   crypto_req_done, &zstrm->wait);
+		list_add(&zstrm->node, &comp->astream_idle);
+		comp->nr_astreams++;
+	}
+
+	if (!comp->nr_astreams) {
+		zcomp_astreams_free(comp);
+		return;
+	}
+
+	pr_info("%s: using %u %s streams\n", comp->name, comp->nr_astreams,
+		crypto_tfm_alg_driver_name(crypto_acomp_tfm(atfm)));
+}
+
 static int zcomp_init(struct zcomp *comp)
 {
 	int ret;
@@ -185,6 +462,8 @@ static int zcomp_init(struct zcomp *comp)
 	ret = cpuhp_state_add_instance(CPUHP_ZCOMP_PREPARE, &comp->node);
 	if (ret < 0)
 		goto cleanup;
+
+	zcomp_astreams_init(comp);
 	return 0;
 
 cleanup:
@@ -194,8 +473,11 @@ static int zcomp_init(struct zcomp *comp)
 
 void zcomp_destroy(struct zcomp *comp)
 {
+	if (comp->atfm)
+		zcomp_astreams_free(comp);
 	cpuhp_state_remove_instance(CPUHP_ZCOMP_PREPARE, &comp->node);
 	free_percpu(comp->stream);
+	zcomp_dict_free(comp);
 	kfree(comp);
 }
 
@@ -205,9 +487,10 @@ void zcomp_destroy(struct zcomp *comp)
  * backend pointer or ERR_PTR if things went bad. ERR_PTR(-EINVAL)
  * if requested algorithm is not supported, ERR_PTR(-ENOMEM) in
  * case of allocation error, or any other error potentially
- * returned by zcomp_init().
+ * returned by zcomp_init(). @dict, if not NULL, is a zstd dictionary
+ * used when @alg is zstd.
  */
-struct zcomp *zcomp_create(const char *alg)
+struct zcomp *zcomp_create(const char *alg, const void *dict, size_t dict_sz)
 {
 	struct zcomp *comp;
 	int error;
@@ -225,8 +508,15 @@ struct zcomp *zcomp_create(const char *alg)
 		return ERR_PTR(-ENOMEM);
 
 	comp->name = alg;
+	error = zcomp_dict_init(comp, dict, dict_sz);
+	if (error) {
+		kfree(comp);
+		return ERR_PTR(error);
+	}
+
 	error = zcomp_init(comp);
 	if (error) {
+		zcomp_dict_free(comp);
 		kfree(comp);
 		return ERR_PTR(error);
 	}
@@ -6,6 +6,8 @@
 #ifndef _ZCOMP_H_
 #define _ZCOMP_H_
 #include <linux/local_lock.h>
+#include <linux/crypto.h>
+#include <linux/zstd.h>
 
 struct zcomp_strm {
 	/* The members ->buffer and ->tfm are protected by ->lock. */
@@ -13,6 +15,19 @@ struct zcomp_strm {
 	/* compression/decompression buffer */
 	void *buffer;
 	struct crypto_comp *tfm;
+	/* asynchronous streams only, owned by whoever took it off the list */
+	struct acomp_req *req;
+	struct crypto_wait wait;
+	struct list_head node;
+#ifdef CONFIG_ZRAM_ZSTD_DICT
+	/* used instead of ->tfm when the device has a zstd dictionary */
+	struct {
+		void *cwksp;
+		zstd_cctx *cctx;
+		const zstd_cdict *cdict;
+		const zstd_ddict *ddict;
+	} zstd;
+#endif
 };
 
 /* dynamic per-device compression frontend */
@@ -20,6 +35,31 @@ struct zcomp {
 	struct zcomp_strm __percpu *stream;
 	const char *name;
 	struct hlist_node node;
+	/*
+	 * Compression streams of an asynchronous (hardware) implementation
+	 * of the algorithm, if there is one. Decompression always uses the
+	 * per-CPU streams.
+	 */
+	struct crypto_acomp *atfm;
+	struct zcomp_strm *astreams;
+	unsigned int nr_astreams;
+	spinlock_t astream_lock;
+	struct list_head astream_idle;
+#ifdef CONFIG_ZRAM_ZSTD_DICT
+	/*
+	 * The dictionary digested once for all streams. It references the
+	 * raw dictionary passed to zcomp_create(), which must outlive us.
+	 */
+	struct {
+		zstd_parameters params;
+		void *cdict_mem;
+		void *ddict_mem;
+		const zstd_cdict *cdict;
+		const zstd_ddict *ddict;
+		/* holds a reference on the shared decompression contexts */
+		bool percpu_dctx;
+	} zstd;
+#endif
 };
 
 int zcomp_cpu_up_prepare(unsigned int cpu, struct hlist_node *node);
@@ -27,7 +67,7 @@ int zcomp_cpu_dead(unsigned int cpu, struct hlist_node *node);
 ssize_t zcomp_available_show(const char *comp, char *buf);
 bool zcomp_available_algorithm(const char *comp);
 
-struct zcomp *zcomp_create(const char *alg);
+struct zcomp *zcomp_create(const char *alg, const void *dict, size_t dict_sz);
 void zcomp_destroy(struct zcomp *comp);
 
 struct zcomp_strm *zcomp_stream_get(struct zcomp *comp);
@@ -36,6 +76,12 @@ void zcomp_stream_put(struct zcomp *comp);
 int zcomp_compress(struct zcomp_strm *zstrm,
 		const void *src, unsigned int *dst_len);
 
+struct zcomp_strm *zcomp_astream_get(struct zcomp *comp);
+void zcomp_astream_put(struct zcomp *comp, struct zcomp_strm *zstrm);
+
+int zcomp_acompress(struct zcomp_strm *zstrm,
+		struct page *page, unsigned int *dst_len);
+
 int zcomp_decompress(struct zcomp_strm *zstrm,
 		const void *src, unsigned int src_len, void *dst);
 
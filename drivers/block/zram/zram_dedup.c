@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Sharing of identical compressed objects between zram slots.
+ *
+ * Every object stored while dedup is enabled is indexed by the xxhash of
+ * its compressed content. A write whose compressed page matches an
+ * indexed object takes a reference on it instead of allocating its own,
+ * and zram_free_page() frees the object with the last reference.
+ */
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/xxhash.h>
+#include <linux/zsmalloc.h>
+
+#include "zram_drv.h"
+
+/* Average number of stored pages per hash bucket */
+#define ZRAM_DEDUP_PAGES_PER_BUCKET	16
+
+struct zram_dedup_entry {
+	struct hlist_node node;
+	u64 hash;
+	unsigned long handle;
+	unsigned int len;
+	/* number of slots referencing handle, protected by bucket lock */
+	unsigned int refcount;
+};
+
+struct zram_dedup_bucket {
+	spinlock_t lock;
+	struct hlist_head head;
+};
+
+static struct zram_dedup_bucket *zram_dedup_bucket(struct zram *zram, u64 hash)
+{
+	return &zram->dedup_buckets[hash & zram->dedup_mask];
+}
+
+static bool zram_dedup_match(struct zram *zram, struct zram_dedup_entry *entry,
+			     const void *mem)
+{
+	void *obj;
+	bool match;
+
+	obj = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+	match = !memcmp(obj, mem, entry->len);
+	zs_unmap_object(zram->mem_pool, entry->handle);
+
+	return match;
+}
+
+/*
+ * Look up an object identical to the @len bytes at @mem. On a hit its
+ * handle is returned with a reference taken for the caller. The hash of
+ * @mem is returned in @hash either way, for zram_dedup_insert().
+ *
+ * Must not be called with another zsmalloc object mapped.
+ */
+unsigned long zram_dedup_find(struct zram *zram, const void *mem,
+		unsigned int len, u64 *hash)
+{
+	struct zram_dedup_bucket *bucket;
+	struct zram_dedup_entry *entry;
+	unsigned long handle = 0;
+
+	*hash = xxh64(mem, len, 0);
+	bucket = zram_dedup_bucket(zram, *hash);
+
+	spin_lock(&bucket->lock);
+	hlist_for_each_entry(entry, &bucket->head, node) {
+		if (entry->hash != *hash || entry->len != len)
+			continue;
+		if (!zram_dedup_match(zram, entry, mem))
+			continue;
+
+		entry->refcount++;
+		handle = entry->handle;
+		break;
+	}
+	spin_unlock(&bucket->lock);
+
+	if (handle)
+		atomic64_add(len, &zram->stats.dup_data_size);
+	return handle;
+}
+
+/*
+ * Index a newly stored object so that later writes can share it. Returns
+ * false if the index entry could not be allocated, in which case the
+ * object is simply not shared.
+ */
+bool zram_dedup_insert(struct zram *zram, unsigned long handle,
+		unsigned int len, u64 hash)
+{
+	struct zram_dedup_bucket *bucket;
+	struct zram_dedup_entry *entry;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return false;
+
+	entry->hash = hash;
+	entry->handle = handle;
+	entry->len = len;
+	entry->refcount = 1;
+
+	bucket = zram_dedup_bucket(zram, hash);
+	spin_lock(&bucket->lock);
+	hlist_add_head(&entry->node, &bucket->head);
+	spin_unlock(&bucket->lock);
+
+	return true;
+}
+
+/*
+ * Drop a slot's reference to an indexed object. Returns true if it was
+ * the last one and the caller should free the object.
+ */
+bool zram_dedup_put(struct zram *zram, unsigned long handle,
+		unsigned int len)
+{
+	struct zram_dedup_bucket *bucket;
+	struct zram_dedup_entry *entry;
+	bool last = false;
+	void *obj;
+	u64 hash;
+
+	obj = zs_map_object(zram->mem_pool, handle, ZS_MM_RO);
+	hash = xxh64(obj, len, 0);
+	zs_unmap_object(zram->mem_pool, handle);
+
+	bucket = zram_dedup_bucket(zram, hash);
+	spin_lock(&bucket->lock);
+	hlist_for_each_entry(entry, &bucket->head, node) {
+		if (entry->handle != handle)
+			continue;
+
+		if (--entry->refcount == 0) {
+			hlist_del(&entry->node);
+			last = true;
+		}
+		break;
+	}
+	spin_unlock(&bucket->lock);
+
+	if (WARN_ON_ONCE(!entry))
+		return true;
+
+	if (last)
+		kfree(entry);
+	else
+		atomic64_sub(len, &zram->stats.dup_data_size);
+	return last;
+}
+
+int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	size_t nr, i;
+
+	if (!zram->use_dedup)
+		return 0;
+
+	nr = roundup_pow_of_two(max_t(size_t, num_pages /
+				ZRAM_DEDUP_PAGES_PER_BUCKET, 1));
+	zram->dedup_buckets = vmalloc(array_size(nr,
+					sizeof(*zram->dedup_buckets)));
+	if (!zram->dedup_buckets)
+		return -ENOMEM;
+
+	for (i = 0; i < nr; i++) {
+		spin_lock_init(&zram->dedup_buckets[i].lock);
+		INIT_HLIST_HEAD(&zram->dedup_buckets[i].head);
+	}
+	zram->dedup_mask = nr - 1;
+	return 0;
+}
+
+/* All slots must have been freed, which empties the index */
+void zram_dedup_fini(struct zram *zram)
+{
+	vfree(zram->dedup_buckets);
+	zram->dedup_buckets = NULL;
+	zram->dedup_mask = 0;
+}
@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#ifndef _ZRAM_DEDUP_H_
+#define _ZRAM_DEDUP_H_
+
+#include <linux/types.h>
+
+struct zram;
+
+#ifdef CONFIG_ZRAM_DEDUP
+unsigned long zram_dedup_find(struct zram *zram, const void *mem,
+		unsigned int len, u64 *hash);
+bool zram_dedup_insert(struct zram *zram, unsigned long handle,
+		unsigned int len, u64 hash);
+bool zram_dedup_put(struct zram *zram, unsigned long handle,
+		unsigned int len);
+
+int zram_dedup_init(struct zram *zram, size_t num_pages);
+void zram_dedup_fini(struct zram *zram);
+#else
+static inline unsigned long zram_dedup_find(struct zram *zram,
+		const void *mem, unsigned int len, u64 *hash)
+{
+	return 0;
+}
+static inline bool zram_dedup_insert(struct zram *zram, unsigned long handle,
+		unsigned int len, u64 hash)
+{
+	return false;
+}
+static inline bool zram_dedup_put(struct zram *zram, unsigned long handle,
+		unsigned int len)
+{
+	return true;
+}
+
+static inline int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	return 0;
+}
+static inline void zram_dedup_fini(struct zram *zram) {}
+#endif
+
+#endif /* _ZRAM_DEDUP_H_ */
@@ -33,6 +33,9 @@
 #include <linux/debugfs.h>
 #include <linux/cpuhotplug.h>
 #include <linux/part_stat.h>
+#include <linux/sort.h>
+#include <linux/kernel_read_file.h>
+#include <linux/sizes.h>
 
 #include "zram_drv.h"
 
@@ -601,64 +604,143 @@ static void read_from_bdev_async(struct zram *zram, struct page *page,
 #define IDLE_WRITEBACK			(1<<1)
 #define INCOMPRESSIBLE_WRITEBACK	(1<<2)
 
-static ssize_t writeback_store(struct device *dev,
-		struct device_attribute *attr, const char *buf, size_t len)
+#ifdef CONFIG_ZRAM_TRACK_ENTRY_ACTIME
+#define AGE_WRITEBACK			(1<<3)
+#else
+#define AGE_WRITEBACK			0
+#endif
+
+/* Max pages written back per batch, contiguous blocks share one bio */
+#define ZRAM_WB_BATCH			32
+
+struct zram_wb_batch {
+	struct page *pages[ZRAM_WB_BATCH];
+	u32 index[ZRAM_WB_BATCH];
+	unsigned long blk_idx[ZRAM_WB_BATCH];
+	int nr;
+};
+
+/* Whether writeback_limit leaves room for @nr more pages */
+static bool zram_wb_limit_ok(struct zram *zram, int nr)
 {
-	struct zram *zram = dev_to_zram(dev);
-	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
-	unsigned long index = 0;
-	struct bio bio;
-	struct bio_vec bio_vec;
-	struct page *page;
-	ssize_t ret = len;
-	int mode, err;
-	unsigned long blk_idx = 0;
+	bool ok;
 
-	if (sysfs_streq(buf, "idle"))
-		mode = IDLE_WRITEBACK;
-	else if (sysfs_streq(buf, "huge"))
-		mode = HUGE_WRITEBACK;
-	else if (sysfs_streq(buf, "huge_idle"))
-		mode = IDLE_WRITEBACK | HUGE_WRITEBACK;
-	else if (sysfs_streq(buf, "incompressible"))
-		mode = INCOMPRESSIBLE_WRITEBACK;
-	else {
-		if (strncmp(buf, PAGE_WB_SIG, sizeof(PAGE_WB_SIG) - 1))
-			return -EINVAL;
+	spin_lock(&zram->wb_limit_lock);
+	ok = !zram->wb_limit_enable ||
+	     zram->bd_wb_limit >= (u64)nr << (PAGE_SHIFT - 12);
+	spin_unlock(&zram->wb_limit_lock);
 
-		if (kstrtol(buf + sizeof(PAGE_WB_SIG) - 1, 10, &index) ||
-				index >= nr_pages)
-			return -EINVAL;
+	return ok;
+}
 
-		nr_pages = 1;
-		mode = PAGE_WRITEBACK;
+static void zram_wb_finish(struct zram *zram, u32 index,
+			   unsigned long blk_idx, int err)
+{
+	zram_slot_lock(zram, index);
+	/*
+	 * We released zram_slot_lock so need to check if the slot was
+	 * changed. If there is freeing for the slot, we can catch it
+	 * easily by zram_allocated.
+	 * A subtle case is the slot is freed/reallocated/marked as
+	 * ZRAM_IDLE again. To close the race, idle_store doesn't
+	 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
+	 * Thus, we could close the race by checking ZRAM_IDLE bit.
+	 */
+	if (err || !zram_allocated(zram, index) ||
+	    !zram_test_flag(zram, index, ZRAM_IDLE)) {
+		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+		zram_clear_flag(zram, index, ZRAM_IDLE);
+		zram_slot_unlock(zram, index);
+		free_block_bdev(zram, blk_idx);
+		return;
 	}
 
-	down_read(&zram->init_lock);
-	if (!init_done(zram)) {
-		ret = -EINVAL;
-		goto release_init_lock;
-	}
+	zram_free_page(zram, index);
+	zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+	zram_set_flag(zram, index, ZRAM_WB);
+	zram_set_element(zram, index, blk_idx);
+	atomic64_inc(&zram->stats.pages_stored);
+	spin_lock(&zram->wb_limit_lock);
+	if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
+		zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
+	spin_unlock(&zram->wb_limit_lock);
+	zram_slot_unlock(zram, index);
+}
 
-	if (!zram->backing_dev) {
-		ret = -ENODEV;
-		goto release_init_lock;
+/*
+ * Write out the batched pages, merging runs of contiguous blocks into a
+ * single bio. Returns the most recent bio error, if any.
+ */
+static int zram_wb_flush(struct zram *zram, struct zram_wb_batch *wb)
+{
+	int i, j, start, err, ret = 0;
+	struct bio *bio;
+
+	for (start = 0; start < wb->nr; start = i) {
+		for (i = start + 1; i < wb->nr; i++) {
+			if (wb->blk_idx[i] != wb->blk_idx[i - 1] + 1)
+				break;
+		}
+
+		bio = bio_alloc(file_bdev(zram->bdev_file), i - start,
+				REQ_OP_WRITE | REQ_SYNC, GFP_NOIO);
+		bio->bi_iter.bi_sector = wb->blk_idx[start] * (PAGE_SIZE >> 9);
+		for (j = start; j < i; j++)
+			__bio_add_page(bio, wb->pages[j], PAGE_SIZE, 0);
+
+		err = submit_bio_wait(bio);
+		bio_put(bio);
+		if (!err)
+			atomic64_add(i - start, &zram->stats.bd_writes);
+
+		for (j = start; j < i; j++)
+			zram_wb_finish(zram, wb->index[j], wb->blk_idx[j], err);
+		/*
+		 * BIO errors are not fatal, we continue and simply
+		 * attempt to writeback the remaining objects (pages).
+		 * At the same time we need to signal user-space that
+		 * some writes (at least one, but also could be all of
+		 * them) were not successful and we do so by returning
+		 * the most recent BIO error.
+		 */
+		if (err)
+			ret = err;
 	}
+	wb->nr = 0;
 
-	page = alloc_page(GFP_KERNEL);
-	if (!page) {
-		ret = -ENOMEM;
-		goto release_init_lock;
+	return ret;
+}
+
+/*
+ * Write back the slots in [index, index + nr_pages) selected by @mode, for
+ * AGE_WRITEBACK those last accessed in [@since, @cutoff). Callers should hold
+ * the zram init lock in read mode and have checked for a backing device.
+ */
+static int zram_writeback_slots(struct zram *zram, unsigned long index,
+				unsigned long nr_pages, int mode,
+				ktime_t since, ktime_t cutoff)
+{
+	struct zram_wb_batch *wb;
+	unsigned long blk_idx = 0;
+	int i, err, ret = 0;
+
+	wb = kzalloc(sizeof(*wb), GFP_KERNEL);
+	if (!wb)
+		return -ENOMEM;
+
+	for (i = 0; i < ZRAM_WB_BATCH; i++) {
+		wb->pages[i] = alloc_page(GFP_KERNEL);
+		if (!wb->pages[i]) {
+			ret = -ENOMEM;
+			goto out;
+		}
 	}
 
 	for (; nr_pages != 0; index++, nr_pages--) {
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && !zram->bd_wb_limit) {
-			spin_unlock(&zram->wb_limit_lock);
+		if (!zram_wb_limit_ok(zram, wb->nr + 1)) {
 			ret = -EIO;
 			break;
 		}
-		spin_unlock(&zram->wb_limit_lock);
 
 		if (!blk_idx) {
 			blk_idx = alloc_block_bdev(zram);
@@ -686,6 +768,12 @@ static ssize_t writeback_store(struct device *dev,
 		if (mode & INCOMPRESSIBLE_WRITEBACK &&
 		    !zram_test_flag(zram, index, ZRAM_INCOMPRESSIBLE))
 			goto next;
+#ifdef CONFIG_ZRAM_TRACK_ENTRY_ACTIME
+		if (mode & AGE_WRITEBACK &&
+		    (!ktime_after(cutoff, zram->table[index].ac_time) ||
+		     ktime_before(zram->table[index].ac_time, since)))
+			goto next;
+#endif
 
 		/*
 		 * Clearing ZRAM_UNDER_WB is duty of caller.
@@ -695,7 +783,7 @@ static ssize_t writeback_store(struct device *dev,
 		/* Need for hugepage writeback racing */
 		zram_set_flag(zram, index, ZRAM_IDLE);
 		zram_slot_unlock(zram, index);
-		if (zram_read_page(zram, page, index, NULL)) {
+		if (zram_read_page(zram, wb->pages[wb->nr], index, NULL)) {
 			zram_slot_lock(zram, index);
 			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
 			zram_clear_flag(zram, index, ZRAM_IDLE);
@@ -703,74 +791,219 @@ static ssize_t writeback_store(struct device *dev,
 			continue;
 		}
 
-		bio_init(&bio, file_bdev(zram->bdev_file), &bio_vec, 1,
-			 REQ_OP_WRITE | REQ_SYNC);
-		bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
-		__bio_add_page(&bio, page, PAGE_SIZE, 0);
-
-		/*
-		 * XXX: A single page IO would be inefficient for write
-		 * but it would be not bad as starter.
-		 */
-		err = submit_bio_wait(&bio);
-		if (err) {
-			zram_slot_lock(zram, index);
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			zram_slot_unlock(zram, index);
-			/*
-			 * BIO errors are not fatal, we continue and simply
-			 * attempt to writeback the remaining objects (pages).
-			 * At the same time we need to signal user-space that
-			 * some writes (at least one, but also could be all of
-			 * them) were not successful and we do so by returning
-			 * the most recent BIO error.
-			 */
-			ret = err;
-			continue;
-		}
-
-		atomic64_inc(&zram->stats.bd_writes);
-		/*
-		 * We released zram_slot_lock so need to check if the slot was
-		 * changed. If there is freeing for the slot, we can catch it
-		 * easily by zram_allocated.
-		 * A subtle case is the slot is freed/reallocated/marked as
-		 * ZRAM_IDLE again. To close the race, idle_store doesn't
-		 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
-		 * Thus, we could close the race by checking ZRAM_IDLE bit.
-		 */
-		zram_slot_lock(zram, index);
-		if (!zram_allocated(zram, index) ||
-			  !zram_test_flag(zram, index, ZRAM_IDLE)) {
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			goto next;
-		}
-
-		zram_free_page(zram, index);
-		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-		zram_set_flag(zram, index, ZRAM_WB);
-		zram_set_element(zram, index, blk_idx);
+		wb->index[wb->nr] = index;
+		wb->blk_idx[wb->nr] = blk_idx;
 		blk_idx = 0;
-		atomic64_inc(&zram->stats.pages_stored);
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
-			zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
-		spin_unlock(&zram->wb_limit_lock);
+		if (++wb->nr == ZRAM_WB_BATCH) {
+			err = zram_wb_flush(zram, wb);
+			if (err)
+				ret = err;
+		}
+		continue;
 next:
 		zram_slot_unlock(zram, index);
 	}
 
+	if (wb->nr) {
+		err = zram_wb_flush(zram, wb);
+		if (err)
+			ret = err;
+	}
 	if (blk_idx)
 		free_block_bdev(zram, blk_idx);
-	__free_page(page);
+out:
+	for (i = 0; i < ZRAM_WB_BATCH && wb->pages[i]; i++)
+		__free_page(wb->pages[i]);
+	kfree(wb);
+
+	return ret;
+}
+
+static ssize_t writeback_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long index = 0;
+	ssize_t ret = len;
+	int mode, err;
+
+	if (sysfs_streq(buf, "idle"))
+		mode = IDLE_WRITEBACK;
+	else if (sysfs_streq(buf, "huge"))
+		mode = HUGE_WRITEBACK;
+	else if (sysfs_streq(buf, "huge_idle"))
+		mode = IDLE_WRITEBACK | HUGE_WRITEBACK;
+	else if (sysfs_streq(buf, "incompressible"))
+		mode = INCOMPRESSIBLE_WRITEBACK;
+	else {
+		if (strncmp(buf, PAGE_WB_SIG, sizeof(PAGE_WB_SIG) - 1))
+			return -EINVAL;
+
+		if (kstrtol(buf + sizeof(PAGE_WB_SIG) - 1, 10, &index) ||
+				index >= nr_pages)
+			return -EINVAL;
+
+		nr_pages = 1;
+		mode = PAGE_WRITEBACK;
+	}
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto release_init_lock;
+	}
+
+	if (!zram->backing_dev) {
+		ret = -ENODEV;
+		goto release_init_lock;
+	}
+
+	err = zram_writeback_slots(zram, index, nr_pages, mode, 0, 0);
+	if (err)
+		ret = err;
 release_init_lock:
 	up_read(&zram->init_lock);
 
 	return ret;
 }
 
+/*
+ * Writeback daemon: every wb_interval seconds, write back the pages that
+ * haven't been accessed for longer than the youngest configured age tier.
+ * Each tier covers the ages from its own up to the next older tier's, and
+ * the tiers are written oldest first, so that a tight writeback_limit is
+ * spent on the coldest pages and each pass only scans for its own window.
+ */
+static void zram_wb_daemon(struct work_struct *work)
+{
+	struct zram *zram = container_of(to_delayed_work(work), struct zram,
+					 wb_work);
+	ktime_t now, since = 0, cutoff;
+	unsigned int interval;
+	int i, err;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram) || !zram->backing_dev)
+		goto out;
+
+	now = ktime_get_boottime();
+	for (i = 0; i < zram->nr_wb_tiers; i++, since = cutoff) {
+		cutoff = ktime_sub(now, ns_to_ktime((u64)zram->wb_tiers[i] *
+						    NSEC_PER_SEC));
+		err = zram_writeback_slots(zram, 0, zram->disksize >> PAGE_SHIFT,
+					   AGE_WRITEBACK, since, cutoff);
+		/* Out of writeback budget or backing device space */
+		if (err == -EIO || err == -ENOSPC || err == -ENOMEM)
+			break;
+	}
+out:
+	up_read(&zram->init_lock);
+
+	interval = READ_ONCE(zram->wb_interval);
+	if (interval)
+		queue_delayed_work(system_unbound_wq, &zram->wb_work,
+				   interval * HZ);
+}
+
+static void zram_wb_daemon_stop(struct zram *zram)
+{
+	WRITE_ONCE(zram->wb_interval, 0);
+	cancel_delayed_work_sync(&zram->wb_work);
+}
+
+static ssize_t writeback_interval_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(zram->wb_interval));
+}
+
+static ssize_t writeback_interval_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned int val;
+
+	if (kstrtouint(buf, 10, &val))
+		return -EINVAL;
+
+	if (!val) {
+		zram_wb_daemon_stop(zram);
+		return len;
+	}
+
+	WRITE_ONCE(zram->wb_interval, val);
+	mod_delayed_work(system_unbound_wq, &zram->wb_work, val * HZ);
+	return len;
+}
+
+static ssize_t writeback_tiers_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t sz = 0;
+	int i;
+
+	down_read(&zram->init_lock);
+	for (i = 0; i < zram->nr_wb_tiers; i++)
+		sz += scnprintf(buf + sz, PAGE_SIZE - sz, "%u ",
+				zram->wb_tiers[i]);
+	up_read(&zram->init_lock);
+
+	sz += scnprintf(buf + sz, PAGE_SIZE - sz, "\n");
+	return sz;
+}
+
+static int wb_tier_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? 1 : x > y ? -1 : 0;
+}
+
+/*
+ * Up to ZRAM_WB_MAX_TIERS ages in seconds, e.g. "86400 3600". Requires
+ * CONFIG_ZRAM_TRACK_ENTRY_ACTIME.
+ */
+static ssize_t writeback_tiers_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	u32 tiers[ZRAM_WB_MAX_TIERS];
+	char *args, *arg, *p;
+	int nr = 0, ret = len;
+
+	if (!IS_ENABLED(CONFIG_ZRAM_TRACK_ENTRY_ACTIME))
+		return -EINVAL;
+
+	args = kstrdup(buf, GFP_KERNEL);
+	if (!args)
+		return -ENOMEM;
+
+	p = strim(args);
+	while ((arg = strsep(&p, " ")) != NULL) {
+		if (!*arg)
+			continue;
+		if (nr == ZRAM_WB_MAX_TIERS || kstrtou32(arg, 10, &tiers[nr])) {
+			ret = -EINVAL;
+			goto out;
+		}
+		nr++;
+	}
+
+	sort(tiers, nr, sizeof(tiers[0]), wb_tier_cmp, NULL);
+
+	down_write(&zram->init_lock);
+	memcpy(zram->wb_tiers, tiers, nr * sizeof(tiers[0]));
+	zram->nr_wb_tiers = nr;
+	up_write(&zram->init_lock);
+out:
+	kfree(args);
+	return ret;
+}
+
 struct zram_work {
 	struct work_struct work;
 	struct zram *zram;
@@ -827,6 +1060,7 @@ static int read_from_bdev(struct zram *zram, struct page *page,
 }
 #else
 static inline void reset_bdev(struct zram *zram) {};
+static inline void zram_wb_daemon_stop(struct zram *zram) {};
 static int read_from_bdev(struct zram *zram, struct page *page,
 			unsigned long entry, struct bio *parent)
 {
@@ -958,6 +1192,27 @@ static ssize_t max_comp_streams_store(struct device *dev,
 	return len;
 }
 
+static ssize_t async_write_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", READ_ONCE(zram->async_write));
+}
+
+static ssize_t async_write_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	if (kstrtobool(buf, &val))
+		return -EINVAL;
+
+	WRITE_ONCE(zram->async_write, val);
+	return len;
+}
+
 static void comp_algorithm_set(struct zram *zram, u32 prio, const char *alg)
 {
 	/* Do not free statically defined compression algorithms */
@@ -1034,6 +1289,122 @@ static ssize_t comp_algorithm_store(struct device *dev,
 	return ret ? ret : len;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t use_dedup_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	down_read(&zram->init_lock);
+	val = zram->use_dedup;
+	up_read(&zram->init_lock);
+
+	return sysfs_emit(buf, "%d\n", val);
+}
+
+static ssize_t use_dedup_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	if (kstrtobool(buf, &val))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup for initialized device\n");
+		return -EBUSY;
+	}
+	zram->use_dedup = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+#endif
+
+#ifdef CONFIG_ZRAM_ZSTD_DICT
+/* Dictionaries much larger than this don't pay off for 4K pages */
+#define ZRAM_DICT_MAX_SIZE	SZ_1M
+
+static void comp_dict_set(struct zram *zram, void *dict, size_t sz)
+{
+	vfree(zram->comp_dict);
+	zram->comp_dict = dict;
+	zram->comp_dict_sz = sz;
+}
+
+static ssize_t comp_dict_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	ret = sysfs_emit(buf, "%zu\n", zram->comp_dict_sz);
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+/*
+ * Load a zstd dictionary from the file at the given path, or drop the
+ * current one on an empty write. It is used by every zstd comp of the
+ * device, both for compression and decompression.
+ */
+static ssize_t comp_dict_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char *path, *p;
+	void *dict = NULL;
+	ssize_t sz = 0;
+
+	path = kstrndup(buf, PATH_MAX, GFP_KERNEL);
+	if (!path)
+		return -ENOMEM;
+
+	p = strim(path);
+	if (*p) {
+		sz = kernel_read_file_from_path(p, 0, &dict, ZRAM_DICT_MAX_SIZE,
+						NULL, READING_UNKNOWN);
+		if (sz < 0) {
+			kfree(path);
+			return sz;
+		}
+	}
+	kfree(path);
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		vfree(dict);
+		pr_info("Can't change dictionary for initialized device\n");
+		return -EBUSY;
+	}
+
+	comp_dict_set(zram, dict, sz);
+	up_write(&zram->init_lock);
+	return len;
+}
+
+static const void *zram_comp_dict(struct zram *zram, size_t *sz)
+{
+	*sz = zram->comp_dict_sz;
+	return zram->comp_dict;
+}
+#else
+static void comp_dict_set(struct zram *zram, void *dict, size_t sz) {}
+static const void *zram_comp_dict(struct zram *zram, size_t *sz)
+{
+	*sz = 0;
+	return NULL;
+}
+#endif
+
 #ifdef CONFIG_ZRAM_MULTI_COMP
 static ssize_t recomp_algorithm_show(struct device *dev,
 				     struct device_attribute *attr,
@@ -1151,7 +1522,7 @@ static ssize_t mm_stat_show(struct device *dev,
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
 
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
@@ -1160,7 +1531,8 @@ static ssize_t mm_stat_show(struct device *dev,
 			(u64)atomic64_read(&zram->stats.same_pages),
 			atomic_long_read(&pool_stats.pages_compacted),
 			(u64)atomic64_read(&zram->stats.huge_pages),
-			(u64)atomic64_read(&zram->stats.huge_pages_since));
+			(u64)atomic64_read(&zram->stats.huge_pages_since),
+			(u64)atomic64_read(&zram->stats.dup_data_size));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1195,10 +1567,12 @@ static ssize_t debug_stat_show(struct device *dev,
 
 	down_read(&zram->init_lock);
 	ret = scnprintf(buf, PAGE_SIZE,
-			"version: %d\n%8llu %8llu\n",
+			"version: %d\n%8llu %8llu %8llu %8llu\n",
 			version,
 			(u64)atomic64_read(&zram->stats.writestall),
-			(u64)atomic64_read(&zram->stats.miss_free));
+			(u64)atomic64_read(&zram->stats.miss_free),
+			(u64)atomic64_read(&zram->stats.async_writes),
+			(u64)atomic64_read(&zram->stats.async_comp_busy));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1220,6 +1594,7 @@ static void zram_meta_free(struct zram *zram, u64 disksize)
 	for (index = 0; index < num_pages; index++)
 		zram_free_page(zram, index);
 
+	zram_dedup_fini(zram);
 	zs_destroy_pool(zram->mem_pool);
 	vfree(zram->table);
 }
@@ -1239,6 +1614,12 @@ static bool zram_meta_alloc(struct zram *zram, u64 disksize)
 		return false;
 	}
 
+	if (zram_dedup_init(zram, num_pages)) {
+		zs_destroy_pool(zram->mem_pool);
+		vfree(zram->table);
+		return false;
+	}
+
 	if (!huge_class_size)
 		huge_class_size = zs_huge_class_size(zram->mem_pool);
 	return true;
@@ -1289,6 +1670,14 @@ static void zram_free_page(struct zram *zram, size_t index)
 	if (!handle)
 		return;
 
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		zram_clear_flag(zram, index, ZRAM_DEDUP);
+		/* Other slots still reference the object */
+		if (!zram_dedup_put(zram, handle,
+				    zram_get_obj_size(zram, index)))
+			goto out;
+	}
+
 	zs_free(zram->mem_pool, handle);
 
 	atomic64_sub(zram_get_obj_size(zram, index),
@@ -1405,6 +1794,123 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 	return zram_read_page(zram, bvec->bv_page, index, bio);
 }
 
+/*
+ * Look up an object identical to the one just compressed into @zstrm, or
+ * to @page itself if it is stored uncompressed. On a hit the caller owns a
+ * reference to the returned handle and drops anything it allocated for
+ * the new object.
+ */
+static unsigned long zram_dedup_lookup(struct zram *zram,
+				       struct zcomp_strm *zstrm,
+				       struct page *page,
+				       unsigned int comp_len, u64 *hash)
+{
+	unsigned long handle;
+	void *src;
+
+	*hash = 0;
+	if (!zram_dedup_enabled(zram))
+		return 0;
+
+	src = zstrm->buffer;
+	if (comp_len == PAGE_SIZE)
+		src = kmap_local_page(page);
+	handle = zram_dedup_find(zram, src, comp_len, hash);
+	if (comp_len == PAGE_SIZE)
+		kunmap_local(src);
+
+	return handle;
+}
+
+/*
+ * Compress @page on an asynchronous stream of the primary compressor and
+ * store it. Returns -EAGAIN if there is no such stream available or the
+ * accelerator is busy, so that the caller falls back to the per-CPU streams.
+ */
+static int zram_write_page_async(struct zram *zram, struct page *page,
+				 unsigned long *handlep, unsigned int *comp_lenp,
+				 bool *dedupp)
+{
+	struct zcomp *comp = zram->comps[ZRAM_PRIMARY_COMP];
+	unsigned long alloced_pages, handle;
+	struct zcomp_strm *zstrm;
+	unsigned int comp_len;
+	void *src, *dst;
+	u64 hash;
+	int ret;
+
+	zstrm = zcomp_astream_get(comp);
+	if (!zstrm)
+		return -EAGAIN;
+
+	ret = zcomp_acompress(zstrm, page, &comp_len);
+	if (unlikely(ret)) {
+		zcomp_astream_put(comp, zstrm);
+		if (ret == -EBUSY) {
+			atomic64_inc(&zram->stats.async_comp_busy);
+			return -EAGAIN;
+		}
+		pr_err("Compression failed! err=%d\n", ret);
+		return ret;
+	}
+
+	if (comp_len >= huge_class_size)
+		comp_len = PAGE_SIZE;
+
+	handle = zram_dedup_lookup(zram, zstrm, page, comp_len, &hash);
+	if (handle) {
+		zcomp_astream_put(comp, zstrm);
+		*dedupp = true;
+		goto out;
+	}
+
+	/* No per-cpu stream is held, so the slow path needn't recompress */
+	handle = zs_malloc(zram->mem_pool, comp_len,
+			__GFP_KSWAPD_RECLAIM |
+			__GFP_NOWARN |
+			__GFP_HIGHMEM |
+			__GFP_MOVABLE);
+	if (IS_ERR_VALUE(handle)) {
+		atomic64_inc(&zram->stats.writestall);
+		handle = zs_malloc(zram->mem_pool, comp_len,
+				GFP_NOIO | __GFP_HIGHMEM |
+				__GFP_MOVABLE);
+		if (IS_ERR_VALUE(handle)) {
+			zcomp_astream_put(comp, zstrm);
+			return PTR_ERR((void *)handle);
+		}
+	}
+
+	alloced_pages = zs_get_total_pages(zram->mem_pool);
+	update_used_max(zram, alloced_pages);
+
+	if (zram->limit_pages && alloced_pages > zram->limit_pages) {
+		zcomp_astream_put(comp, zstrm);
+		zs_free(zram->mem_pool, handle);
+		return -ENOMEM;
+	}
+
+	dst = zs_map_object(zram->mem_pool, handle, ZS_MM_WO);
+
+	src = zstrm->buffer;
+	if (comp_len == PAGE_SIZE)
+		src = kmap_local_page(page);
+	memcpy(dst, src, comp_len);
+	if (comp_len == PAGE_SIZE)
+		kunmap_local(src);
+
+	zcomp_astream_put(comp, zstrm);
+	zs_unmap_object(zram->mem_pool, handle);
+	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	if (zram_dedup_enabled(zram))
+		*dedupp = zram_dedup_insert(zram, handle, comp_len, hash);
+out:
+	*handlep = handle;
+	*comp_lenp = comp_len;
+	return 0;
+}
+
 static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 {
 	int ret = 0;
@@ -1415,6 +1921,9 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	struct zcomp_strm *zstrm;
 	unsigned long element = 0;
 	enum zram_pageflags flags = 0;
+	unsigned long dup;
+	bool dedup = false;
+	u64 hash;
 
 	mem = kmap_local_page(page);
 	if (page_same_filled(mem, &element)) {
@@ -1426,6 +1935,13 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	}
 	kunmap_local(mem);
 
+	ret = zram_write_page_async(zram, page, &handle, &comp_len, &dedup);
+	if (!ret)
+		goto out;
+	if (ret != -EAGAIN)
+		return ret;
+	ret = 0;
+
 compress_again:
 	zstrm = zcomp_stream_get(zram->comps[ZRAM_PRIMARY_COMP]);
 	src = kmap_local_page(page);
@@ -1441,6 +1957,16 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 
 	if (comp_len >= huge_class_size)
 		comp_len = PAGE_SIZE;
+
+	dup = zram_dedup_lookup(zram, zstrm, page, comp_len, &hash);
+	if (dup) {
+		zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
+		/* from the slow path, the handle may be allocated already */
+		zs_free(zram->mem_pool, handle);
+		handle = dup;
+		dedup = true;
+		goto out;
+	}
 	/*
 	 * handle allocation has 2 paths:
 	 * a) fast path is executed with preemption disabled (for
@@ -1502,6 +2028,9 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
 	zs_unmap_object(zram->mem_pool, handle);
 	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	if (zram_dedup_enabled(zram))
+		dedup = zram_dedup_insert(zram, handle, comp_len, hash);
 out:
 	/*
 	 * Free memory associated with this sector
@@ -1522,6 +2051,8 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	}  else {
 		zram_set_handle(zram, index, handle);
 		zram_set_obj_size(zram, index, comp_len);
+		if (dedup)
+			zram_set_flag(zram, index, ZRAM_DEDUP);
 	}
 	zram_slot_unlock(zram, index);
 
@@ -1807,6 +2338,10 @@ static ssize_t recompress_store(struct device *dev,
 		    zram_test_flag(zram, index, ZRAM_INCOMPRESSIBLE))
 			goto next;
 
+		/* Recompressing one user of a shared object saves nothing */
+		if (zram_test_flag(zram, index, ZRAM_DEDUP))
+			goto next;
+
 		err = zram_recompress(zram, index, page, threshold,
 				      prio, prio_max);
 next:
@@ -1925,6 +2460,46 @@ static void zram_bio_write(struct zram *zram, struct bio *bio)
 	bio_endio(bio);
 }
 
+struct zram_write_work {
+	struct work_struct work;
+	struct zram *zram;
+	struct bio *bio;
+};
+
+static void zram_bio_write_work(struct work_struct *work)
+{
+	struct zram_write_work *zw;
+
+	zw = container_of(work, struct zram_write_work, work);
+	zram_bio_write(zw->zram, zw->bio);
+	atomic64_inc(&zw->zram->stats.async_writes);
+	kfree(zw);
+}
+
+/*
+ * In async_write mode, write bios are compressed by the per-device unbound
+ * workqueue, so that a single submitter (e.g. kswapd) is no longer limited
+ * to the compression throughput of its own CPU. Returns false, and the bio
+ * is handled synchronously, if no work item could be allocated.
+ */
+static bool zram_bio_write_async(struct zram *zram, struct bio *bio)
+{
+	struct zram_write_work *zw;
+
+	if (!READ_ONCE(zram->async_write))
+		return false;
+
+	zw = kmalloc(sizeof(*zw), GFP_NOWAIT | __GFP_NOWARN);
+	if (!zw)
+		return false;
+
+	INIT_WORK(&zw->work, zram_bio_write_work);
+	zw->zram = zram;
+	zw->bio = bio;
+	queue_work(zram->async_wq, &zw->work);
+	return true;
+}
+
 /*
  * Handler function for all zram I/O requests.
  */
@@ -1937,7 +2512,8 @@ static void zram_submit_bio(struct bio *bio)
 		zram_bio_read(zram, bio);
 		break;
 	case REQ_OP_WRITE:
-		zram_bio_write(zram, bio);
+		if (!zram_bio_write_async(zram, bio))
+			zram_bio_write(zram, bio);
 		break;
 	case REQ_OP_DISCARD:
 	case REQ_OP_WRITE_ZEROES:
@@ -1983,9 +2559,16 @@ static void zram_destroy_comps(struct zram *zram)
 
 static void zram_reset_device(struct zram *zram)
 {
+	/* The daemon takes init_lock, stop it first */
+	zram_wb_daemon_stop(zram);
+
 	down_write(&zram->init_lock);
 
+	/* Async writes don't hold init_lock, wait for them here */
+	flush_workqueue(zram->async_wq);
+
 	zram->limit_pages = 0;
+	comp_dict_set(zram, NULL, 0);
 
 	if (!init_done(zram)) {
 		up_write(&zram->init_lock);
@@ -2012,6 +2595,8 @@ static ssize_t disksize_store(struct device *dev,
 	u64 disksize;
 	struct zcomp *comp;
 	struct zram *zram = dev_to_zram(dev);
+	const void *dict;
+	size_t dict_sz;
 	int err;
 	u32 prio;
 
@@ -2032,11 +2617,12 @@ static ssize_t disksize_store(struct device *dev,
 		goto out_unlock;
 	}
 
+	dict = zram_comp_dict(zram, &dict_sz);
 	for (prio = 0; prio < ZRAM_MAX_COMPS; prio++) {
 		if (!zram->comp_algs[prio])
 			continue;
 
-		comp = zcomp_create(zram->comp_algs[prio]);
+		comp = zcomp_create(zram->comp_algs[prio], dict, dict_sz);
 		if (IS_ERR(comp)) {
 			pr_err("Cannot initialise %s compressing backend\n",
 			       zram->comp_algs[prio]);
@@ -2128,12 +2714,21 @@ static DEVICE_ATTR_WO(mem_limit);
 static DEVICE_ATTR_WO(mem_used_max);
 static DEVICE_ATTR_WO(idle);
 static DEVICE_ATTR_RW(max_comp_streams);
+static DEVICE_ATTR_RW(async_write);
 static DEVICE_ATTR_RW(comp_algorithm);
+#ifdef CONFIG_ZRAM_ZSTD_DICT
+static DEVICE_ATTR_RW(comp_dict);
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR_RW(use_dedup);
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 static DEVICE_ATTR_RW(backing_dev);
 static DEVICE_ATTR_WO(writeback);
 static DEVICE_ATTR_RW(writeback_limit);
 static DEVICE_ATTR_RW(writeback_limit_enable);
+static DEVICE_ATTR_RW(writeback_interval);
+static DEVICE_ATTR_RW(writeback_tiers);
 #endif
 #ifdef CONFIG_ZRAM_MULTI_COMP
 static DEVICE_ATTR_RW(recomp_algorithm);
@@ -2149,12 +2744,21 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_mem_used_max.attr,
 	&dev_attr_idle.attr,
 	&dev_attr_max_comp_streams.attr,
+	&dev_attr_async_write.attr,
 	&dev_attr_comp_algorithm.attr,
+#ifdef CONFIG_ZRAM_ZSTD_DICT
+	&dev_attr_comp_dict.attr,
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_use_dedup.attr,
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 	&dev_attr_backing_dev.attr,
 	&dev_attr_writeback.attr,
 	&dev_attr_writeback_limit.attr,
 	&dev_attr_writeback_limit_enable.attr,
+	&dev_attr_writeback_interval.attr,
+	&dev_attr_writeback_tiers.attr,
 #endif
 	&dev_attr_io_stat.attr,
 	&dev_attr_mm_stat.attr,
@@ -2214,6 +2818,7 @@ static int zram_add(void)
 	init_rwsem(&zram->init_lock);
 #ifdef CONFIG_ZRAM_WRITEBACK
 	spin_lock_init(&zram->wb_limit_lock);
+	INIT_DELAYED_WORK(&zram->wb_work, zram_wb_daemon);
 #endif
 
 	/* gendisk structure */
@@ -2233,6 +2838,13 @@ static int zram_add(void)
 	zram->disk->private_data = zram;
 	snprintf(zram->disk->disk_name, 16, "zram%d", device_id);
 
+	zram->async_wq = alloc_workqueue("%s_wq", WQ_UNBOUND | WQ_MEM_RECLAIM,
+					 0, zram->disk->disk_name);
+	if (!zram->async_wq) {
+		ret = -ENOMEM;
+		goto out_cleanup_disk;
+	}
+
 	/* Actual capacity set using sysfs (/sys/block/zram<id>/disksize */
 	set_capacity(zram->disk, 0);
 	/* zram devices sort of resembles non-rotational disks */
@@ -2241,7 +2853,7 @@ static int zram_add(void)
 	blk_queue_flag_set(QUEUE_FLAG_STABLE_WRITES, zram->disk->queue);
 	ret = device_add_disk(NULL, zram->disk, zram_disk_groups);
 	if (ret)
-		goto out_cleanup_disk;
+		goto out_destroy_wq;
 
 	comp_algorithm_set(zram, ZRAM_PRIMARY_COMP, default_compressor);
 
@@ -2249,6 +2861,8 @@ static int zram_add(void)
 	pr_info("Added device: %s\n", zram->disk->disk_name);
 	return device_id;
 
+out_destroy_wq:
+	destroy_workqueue(zram->async_wq);
 out_cleanup_disk:
 	put_disk(zram->disk);
 out_free_idr:
@@ -2301,6 +2915,7 @@ static int zram_remove(struct zram *zram)
 	 */
 	zram_reset_device(zram);
 
+	destroy_workqueue(zram->async_wq);
 	put_disk(zram->disk);
 	kfree(zram);
 	return 0;
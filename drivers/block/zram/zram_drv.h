@@ -16,10 +16,12 @@
 #define _ZRAM_DRV_H_
 
 #include <linux/rwsem.h>
+#include <linux/workqueue.h>
 #include <linux/zsmalloc.h>
 #include <linux/crypto.h>
 
 #include "zcomp.h"
+#include "zram_dedup.h"
 
 #define SECTORS_PER_PAGE_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
 #define SECTORS_PER_PAGE	(1 << SECTORS_PER_PAGE_SHIFT)
@@ -43,6 +45,9 @@
 /* Only 2 bits are allowed for comp priority index */
 #define ZRAM_COMP_PRIORITY_MASK	0x3
 
+/* Max number of idle age tiers of the writeback daemon */
+#define ZRAM_WB_MAX_TIERS	4
+
 /* Flags for zram pages (table[page_no].flags) */
 enum zram_pageflags {
 	/* zram slot is locked */
@@ -53,6 +58,7 @@ enum zram_pageflags {
 	ZRAM_HUGE,	/* Incompressible page */
 	ZRAM_IDLE,	/* not accessed page since last idle marking */
 	ZRAM_INCOMPRESSIBLE, /* none of the algorithms could compress it */
+	ZRAM_DEDUP,	/* handle may be shared with other slots */
 
 	ZRAM_COMP_PRIORITY_BIT1, /* First bit of comp priority index */
 	ZRAM_COMP_PRIORITY_BIT2, /* Second bit of comp priority index */
@@ -86,6 +92,9 @@ struct zram_stats {
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t writestall;		/* no. of write slow paths */
 	atomic64_t miss_free;		/* no. of missed free */
+	atomic64_t async_writes;	/* no. of bios written by async_wq */
+	atomic64_t async_comp_busy;	/* no. of async compressions rejected */
+	atomic64_t dup_data_size;	/* compressed bytes saved by dedup */
 #ifdef	CONFIG_ZRAM_WRITEBACK
 	atomic64_t bd_count;		/* no. of pages in backing device */
 	atomic64_t bd_reads;		/* no. of reads from backing device */
@@ -123,10 +132,27 @@ struct zram {
 	u64 disksize;	/* bytes */
 	const char *comp_algs[ZRAM_MAX_COMPS];
 	s8 num_active_comps;
+#ifdef CONFIG_ZRAM_DEDUP
+	/* index of stored objects, allocated with the table if use_dedup */
+	bool use_dedup;
+	struct zram_dedup_bucket *dedup_buckets;
+	unsigned long dedup_mask;
+#endif
+#ifdef CONFIG_ZRAM_ZSTD_DICT
+	/* zstd dictionary, set before init and referenced by comps */
+	void *comp_dict;
+	size_t comp_dict_sz;
+#endif
 	/*
 	 * zram is claimed so open request will be failed
 	 */
 	bool claim; /* Protected by disk->open_mutex */
+	/*
+	 * Write bios are handed to async_wq instead of being compressed
+	 * in the submitting context
+	 */
+	bool async_write;
+	struct workqueue_struct *async_wq;
 #ifdef CONFIG_ZRAM_WRITEBACK
 	struct file *backing_dev;
 	spinlock_t wb_limit_lock;
@@ -135,9 +161,24 @@ struct zram {
 	struct file *bdev_file;
 	unsigned long *bitmap;
 	unsigned long nr_pages;
+	/* writeback daemon, runs every wb_interval seconds when non-zero */
+	struct delayed_work wb_work;
+	unsigned int wb_interval;
+	/* idle ages in seconds, oldest first, protected by init_lock */
+	u32 wb_tiers[ZRAM_WB_MAX_TIERS];
+	int nr_wb_tiers;
 #endif
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
 	struct dentry *debugfs_dir;
 #endif
 };
+
+static inline bool zram_dedup_enabled(struct zram *zram)
+{
+#ifdef CONFIG_ZRAM_DEDUP
+	return zram->dedup_buckets;
+#else
+	return false;
+#endif
+}
 #endif
@@ -61,6 +61,10 @@
 #include <asm/irq.h>
 #include <asm/irq_regs.h>
 #include <asm/io.h>
+#ifdef CONFIG_VDSO_GETRANDOM
+#include <vdso/getrandom.h>
+#include <vdso/datapage.h>
+#endif
 
 /*********************************************************************
  *
@@ -114,6 +118,9 @@ EXPORT_SYMBOL(rng_is_initialized);
 static void __cold crng_set_ready(struct work_struct *work)
 {
 	static_branch_enable(&crng_is_ready);
+#ifdef CONFIG_VDSO_GETRANDOM
+	WRITE_ONCE(_vdso_rng_data.is_ready, true);
+#endif
 }
 
 /* Used by wait_for_random_bytes(), and considered an entropy collector, below. */
@@ -271,6 +278,15 @@ static void crng_reseed(struct work_struct *work)
 	if (next_gen == ULONG_MAX)
 		++next_gen;
 	WRITE_ONCE(base_crng.generation, next_gen);
+#ifdef CONFIG_VDSO_GETRANDOM
+	/*
+	 * The vDSO states are invalid when their generation is 0, while the
+	 * per-cpu crngs are invalid when it is ULONG_MAX, so add one. Order
+	 * this after the new key is in base_crng, pairing with the smp_rmb()
+	 * before the vDSO fetches a new key with the syscall.
+	 */
+	smp_store_release(&_vdso_rng_data.generation, next_gen + 1);
+#endif
 	if (!static_branch_likely(&crng_is_ready))
 		crng_init = CRNG_READY;
 	spin_unlock_irqrestore(&base_crng.lock, flags);
@@ -100,6 +100,7 @@ static struct cpufreq_driver amd_pstate_epp_driver;
 static int cppc_state = AMD_PSTATE_UNDEFINED;
 static bool cppc_enabled;
 static bool amd_pstate_prefcore = true;
+static bool amd_pstate_dynamic_epp;
 static struct quirk_entry *quirks;
 
 /*
@@ -294,6 +295,11 @@ static int amd_pstate_set_energy_pref_index(struct amd_cpudata *cpudata,
 		return -EBUSY;
 	}
 
+	if (cpudata->update_util_set) {
+		pr_debug("EPP cannot be set with dynamic EPP\n");
+		return -EBUSY;
+	}
+
 	ret = amd_pstate_set_epp(cpudata, epp);
 
 	return ret;
@@ -518,6 +524,89 @@ static inline bool amd_pstate_sample(struct amd_cpudata *cpudata)
 	return true;
 }
 
+/*
+ * Dynamic EPP: every AMD_DYNAMIC_EPP_INTERVAL_NS, pick the EPP hint of the
+ * core from the share of time it spent in C0 since the previous update.
+ */
+#define AMD_DYNAMIC_EPP_INTERVAL_NS	(10 * NSEC_PER_MSEC)
+#define AMD_DYNAMIC_EPP_BUSY_HIGH	70	/* percent */
+#define AMD_DYNAMIC_EPP_BUSY_LOW	20	/* percent */
+
+/*
+ * Called by the scheduler with interrupts disabled. The request MSR is only
+ * written from the CPU itself, and the cached request is updated with a
+ * cmpxchg so that a concurrent limits update from another CPU never gets
+ * overwritten with stale min/max perf values.
+ */
+static void amd_pstate_update_util_epp(struct update_util_data *data,
+				       u64 time, unsigned int flags)
+{
+	struct amd_cpudata *cpudata = container_of(data, struct amd_cpudata,
+						   update_util);
+	u64 busy, prev, value;
+	u32 epp;
+
+	if (smp_processor_id() != cpudata->cpu || cpudata->suspended)
+		return;
+
+	if (time - cpudata->last_epp_update < AMD_DYNAMIC_EPP_INTERVAL_NS)
+		return;
+	cpudata->last_epp_update = time;
+
+	if (!amd_pstate_sample(cpudata))
+		return;
+
+	busy = div64_u64(cpudata->cur.mperf * 100, cpudata->cur.tsc);
+	if ((flags & SCHED_CPUFREQ_IOWAIT) || busy >= AMD_DYNAMIC_EPP_BUSY_HIGH)
+		epp = epp_values[EPP_INDEX_BALANCE_PERFORMANCE];
+	else if (busy <= AMD_DYNAMIC_EPP_BUSY_LOW)
+		epp = epp_values[EPP_INDEX_POWERSAVE];
+	else
+		epp = epp_values[EPP_INDEX_BALANCE_POWERSAVE];
+
+	prev = READ_ONCE(cpudata->cppc_req_cached);
+	if (((prev & GENMASK_ULL(31, 24)) >> 24) == epp)
+		return;
+
+	value = (prev & ~GENMASK_ULL(31, 24)) | (u64)epp << 24;
+	if (cmpxchg64(&cpudata->cppc_req_cached, prev, value) != prev)
+		return;
+
+	wrmsrl(MSR_AMD_CPPC_REQ, value);
+	cpudata->epp_cached = epp;
+}
+
+static void amd_pstate_set_update_util_hook(struct amd_cpudata *cpudata)
+{
+	if (cpudata->update_util_set)
+		return;
+
+	cpudata->last_epp_update = 0;
+	cpufreq_add_update_util_hook(cpudata->cpu, &cpudata->update_util,
+				     amd_pstate_update_util_epp);
+	cpudata->update_util_set = true;
+}
+
+static void amd_pstate_clear_update_util_hook(struct amd_cpudata *cpudata)
+{
+	if (!cpudata->update_util_set)
+		return;
+
+	cpufreq_remove_update_util_hook(cpudata->cpu);
+	cpudata->update_util_set = false;
+	synchronize_rcu();
+}
+
+/* Dynamic EPP is only used with the MSR interface and the powersave policy */
+static void amd_pstate_update_dynamic_epp(struct amd_cpudata *cpudata)
+{
+	if (amd_pstate_dynamic_epp && boot_cpu_has(X86_FEATURE_CPPC) &&
+	    cpudata->policy == CPUFREQ_POLICY_POWERSAVE)
+		amd_pstate_set_update_util_hook(cpudata);
+	else
+		amd_pstate_clear_update_util_hook(cpudata);
+}
+
 static void amd_pstate_update(struct amd_cpudata *cpudata, u32 min_perf,
 			      u32 des_perf, u32 max_perf, bool fast_switch, int gov_flags)
 {
@@ -1465,6 +1554,7 @@ static int amd_pstate_epp_cpu_exit(struct cpufreq_policy *policy)
 	struct amd_cpudata *cpudata = policy->driver_data;
 
 	if (cpudata) {
+		amd_pstate_clear_update_util_hook(cpudata);
 		kfree(cpudata);
 		policy->driver_data = NULL;
 	}
@@ -1552,6 +1642,7 @@ static int amd_pstate_epp_set_policy(struct cpufreq_policy *policy)
 	cpudata->policy = policy->policy;
 
 	amd_pstate_epp_update_limit(policy);
+	amd_pstate_update_dynamic_epp(cpudata);
 
 	return 0;
 }
@@ -1587,6 +1678,7 @@ static int amd_pstate_epp_cpu_online(struct cpufreq_policy *policy)
 	if (cppc_state == AMD_PSTATE_ACTIVE) {
 		amd_pstate_epp_reenable(cpudata);
 		cpudata->suspended = false;
+		amd_pstate_update_dynamic_epp(cpudata);
 	}
 
 	return 0;
@@ -1627,6 +1719,8 @@ static int amd_pstate_epp_cpu_offline(struct cpufreq_policy *policy)
 
 	pr_debug("AMD CPU Core %d going offline\n", cpudata->cpu);
 
+	amd_pstate_clear_update_util_hook(cpudata);
+
 	if (cpudata->suspended)
 		return 0;
 
@@ -1842,8 +1936,17 @@ static int __init amd_prefcore_param(char *str)
 	return 0;
 }
 
+static int __init amd_dynamic_epp_param(char *str)
+{
+	if (!strcmp(str, "enable"))
+		amd_pstate_dynamic_epp = true;
+
+	return 0;
+}
+
 early_param("amd_pstate", amd_pstate_param);
 early_param("amd_prefcore", amd_prefcore_param);
+early_param("amd_dynamic_epp", amd_dynamic_epp_param);
 
 MODULE_AUTHOR("Huang Rui <ray.huang@amd.com>");
 MODULE_DESCRIPTION("AMD Processor P-state Frequency Driver");
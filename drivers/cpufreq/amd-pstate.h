@@ -9,6 +9,7 @@
 #define _LINUX_AMD_PSTATE_H
 
 #include <linux/pm_qos.h>
+#include <linux/sched/cpufreq.h>
 
 /*********************************************************************
  *                        AMD P-state INTERFACE                       *
@@ -95,6 +96,11 @@ struct amd_cpudata {
 	u32	policy;
 	u64	cppc_cap1_cached;
 	bool	suspended;
+
+	/* Dynamic EPP related attributes */
+	struct update_util_data update_util;
+	u64	last_epp_update;
+	bool	update_util_set;
 };
 
 #endif /* _LINUX_AMD_PSTATE_H */
@@ -16,6 +16,7 @@
 #include <linux/tick.h>
 #include <linux/slab.h>
 #include <linux/sched/cpufreq.h>
+#include <linux/sched/topology.h>
 #include <linux/list.h>
 #include <linux/cpu.h>
 #include <linux/cpufreq.h>
@@ -219,6 +220,7 @@ struct global_params {
  * @last_io_update:	Last time when IO wake flag was set
  * @sched_flags:	Store scheduler flags for possible cross CPU update
  * @hwp_boost_min:	Last HWP boosted min performance
+ * @hwp_uclamp_min:	Last HWP min performance requested through uclamp
  * @suspended:		Whether or not the driver has been suspended.
  * @hwp_notify_work:	workqueue for HWP notifications.
  *
@@ -257,6 +259,7 @@ struct cpudata {
 	u64 last_io_update;
 	unsigned int sched_flags;
 	u32 hwp_boost_min;
+	u32 hwp_uclamp_min;
 	bool suspended;
 	struct delayed_work hwp_notify_work;
 };
@@ -296,6 +299,7 @@ static int hwp_active __read_mostly;
 static int hwp_mode_bdw __read_mostly;
 static bool per_cpu_limits __read_mostly;
 static bool hwp_boost __read_mostly;
+static bool hwp_uclamp __read_mostly;
 static bool hwp_forced __read_mostly;
 
 static struct cpufreq_driver *intel_pstate_driver __read_mostly;
@@ -1023,6 +1027,8 @@ static void intel_pstate_hwp_set(unsigned int cpu)
 skip_epp:
 	WRITE_ONCE(cpu_data->hwp_req_cached, value);
 	wrmsrl_on_cpu(cpu, MSR_HWP_REQUEST, value);
+	/* Have the next utilization update reapply its uclamp floor */
+	cpu_data->hwp_uclamp_min = 0;
 }
 
 static void intel_pstate_disable_hwp_interrupt(struct cpudata *cpudata);
@@ -1474,6 +1480,30 @@ static ssize_t store_hwp_dynamic_boost(struct kobject *a,
 	return count;
 }
 
+static ssize_t show_hwp_uclamp(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", hwp_uclamp);
+}
+
+static ssize_t store_hwp_uclamp(struct kobject *a, struct kobj_attribute *b,
+				const char *buf, size_t count)
+{
+	unsigned int input;
+	int ret;
+
+	ret = kstrtouint(buf, 10, &input);
+	if (ret)
+		return ret;
+
+	mutex_lock(&intel_pstate_driver_lock);
+	hwp_uclamp = !!input;
+	intel_pstate_update_policies();
+	mutex_unlock(&intel_pstate_driver_lock);
+
+	return count;
+}
+
 static ssize_t show_energy_efficiency(struct kobject *kobj, struct kobj_attribute *attr,
 				      char *buf)
 {
@@ -1510,6 +1540,7 @@ define_one_global_rw(min_perf_pct);
 define_one_global_ro(turbo_pct);
 define_one_global_ro(num_pstates);
 define_one_global_rw(hwp_dynamic_boost);
+define_one_global_rw(hwp_uclamp);
 define_one_global_rw(energy_efficiency);
 
 static struct attribute *intel_pstate_attributes[] = {
@@ -1601,6 +1632,9 @@ static void intel_pstate_sysfs_expose_hwp_dynamic_boost(void)
 
 	rc = sysfs_create_file(intel_pstate_kobject, &hwp_dynamic_boost.attr);
 	WARN_ON_ONCE(rc);
+
+	rc = sysfs_create_file(intel_pstate_kobject, &hwp_uclamp.attr);
+	WARN_ON_ONCE(rc);
 }
 
 static void intel_pstate_sysfs_hide_hwp_dynamic_boost(void)
@@ -1609,6 +1643,7 @@ static void intel_pstate_sysfs_hide_hwp_dynamic_boost(void)
 		return;
 
 	sysfs_remove_file(intel_pstate_kobject, &hwp_dynamic_boost.attr);
+	sysfs_remove_file(intel_pstate_kobject, &hwp_uclamp.attr);
 }
 
 /************************** sysfs end ************************/
@@ -2084,6 +2119,47 @@ static void intel_pstate_get_cpu_pstates(struct cpudata *cpu)
  */
 static int hwp_boost_hold_time_ns = 3 * NSEC_PER_MSEC;
 
+/*
+ * Program the HWP min performance from the cached request, raised to the
+ * current boost and uclamp floors.  Called on the local CPU only.
+ */
+static inline void intel_pstate_hwp_write_min(struct cpudata *cpu)
+{
+	u64 hwp_req = READ_ONCE(cpu->hwp_req_cached);
+	u32 max_limit = (hwp_req & 0xff00) >> 8;
+	u32 min_perf;
+
+	min_perf = max3((u32)(hwp_req & 0xff), cpu->hwp_boost_min,
+			cpu->hwp_uclamp_min);
+	min_perf = min(min_perf, max_limit);
+
+	hwp_req = (hwp_req & ~GENMASK_ULL(7, 0)) | min_perf;
+	wrmsrl(MSR_HWP_REQUEST, hwp_req);
+}
+
+/*
+ * Translate the uclamp.min of the runnable tasks into a HWP min performance
+ * floor, and only touch the MSR when that floor changes.
+ */
+static inline void intel_pstate_hwp_update_uclamp(struct cpudata *cpu)
+{
+	unsigned long umin = sched_cpu_uclamp_min(cpu->cpu);
+	u64 hwp_cap = READ_ONCE(cpu->hwp_cap_cached);
+	u32 perf = 0;
+
+	if (umin) {
+		perf = DIV_ROUND_UP(umin * HWP_HIGHEST_PERF(hwp_cap),
+				    arch_scale_cpu_capacity(cpu->cpu));
+		perf = min_t(u32, perf, HWP_HIGHEST_PERF(hwp_cap));
+	}
+
+	if (perf == cpu->hwp_uclamp_min)
+		return;
+
+	cpu->hwp_uclamp_min = perf;
+	intel_pstate_hwp_write_min(cpu);
+}
+
 static inline void intel_pstate_hwp_boost_up(struct cpudata *cpu)
 {
 	u64 hwp_req = READ_ONCE(cpu->hwp_req_cached);
@@ -2126,8 +2202,7 @@ static inline void intel_pstate_hwp_boost_up(struct cpudata *cpu)
 	else
 		return;
 
-	hwp_req = (hwp_req & ~GENMASK_ULL(7, 0)) | cpu->hwp_boost_min;
-	wrmsrl(MSR_HWP_REQUEST, hwp_req);
+	intel_pstate_hwp_write_min(cpu);
 	cpu->last_update = cpu->sample.time;
 }
 
@@ -2140,8 +2215,8 @@ static inline void intel_pstate_hwp_boost_down(struct cpudata *cpu)
 		expired = time_after64(cpu->sample.time, cpu->last_update +
 				       hwp_boost_hold_time_ns);
 		if (expired) {
-			wrmsrl(MSR_HWP_REQUEST, cpu->hwp_req_cached);
 			cpu->hwp_boost_min = 0;
+			intel_pstate_hwp_write_min(cpu);
 		}
 	}
 	cpu->last_update = cpu->sample.time;
@@ -2152,6 +2227,12 @@ static inline void intel_pstate_update_util_hwp_local(struct cpudata *cpu,
 {
 	cpu->sample.time = time;
 
+	if (hwp_uclamp)
+		intel_pstate_hwp_update_uclamp(cpu);
+
+	if (!hwp_boost)
+		return;
+
 	if (cpu->sched_flags & SCHED_CPUFREQ_IOWAIT) {
 		bool do_io = false;
 
@@ -2496,7 +2577,7 @@ static void intel_pstate_set_update_util_hook(unsigned int cpu_num)
 {
 	struct cpudata *cpu = all_cpu_data[cpu_num];
 
-	if (hwp_active && !hwp_boost)
+	if (hwp_active && !hwp_boost && !hwp_uclamp)
 		return;
 
 	if (cpu->update_util_set)
@@ -2626,7 +2707,7 @@ static int intel_pstate_set_policy(struct cpufreq_policy *policy)
 		 * was turned off, in that case we need to clear the
 		 * update util hook.
 		 */
-		if (!hwp_boost)
+		if (!hwp_boost && !hwp_uclamp)
 			intel_pstate_clear_update_util_hook(policy->cpu);
 		intel_pstate_hwp_set(policy->cpu);
 	}
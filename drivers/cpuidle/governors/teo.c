@@ -130,11 +130,23 @@
  * util to the precomputed util threshold. If it's below, it defaults to the
  * TEO metrics mechanism. If it's above, the closest shallower idle state will
  * be selected instead, as long as is not a polling state.
+ *
+ * IRQ timings:
+ *
+ * With CONFIG_CPU_IDLE_GOV_TEO_IRQ_TIMINGS and teo.irq_timings=1, the
+ * interrupt core records the timestamps of interrupts per CPU and per source,
+ * and predicts the next interrupt of each source from its recent intervals.
+ * The earliest of those predictions is then used like the closest timer: the
+ * candidate state is replaced with a shallower one if its target residency
+ * goes beyond it. This keeps periodic device interrupts, e.g. from a NIC, from
+ * being mixed with other wakeups in the intercepts metrics.
  */
 
 #include <linux/cpuidle.h>
+#include <linux/interrupt.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/moduleparam.h>
 #include <linux/sched.h>
 #include <linux/sched/clock.h>
 #include <linux/sched/topology.h>
@@ -142,6 +154,32 @@
 
 #include "gov.h"
 
+#ifdef CONFIG_CPU_IDLE_GOV_TEO_IRQ_TIMINGS
+static bool teo_irq_timings __ro_after_init;
+module_param_named(irq_timings, teo_irq_timings, bool, 0444);
+
+/* Time till the next interrupt predicted from the per-source IRQ timings */
+static s64 teo_irq_next_event_ns(void)
+{
+	u64 now, next;
+
+	if (!teo_irq_timings)
+		return KTIME_MAX;
+
+	now = local_clock();
+	next = irq_timings_next_event(now);
+	if (next == U64_MAX)
+		return KTIME_MAX;
+
+	return next > now ? next - now : 0;
+}
+#else
+static inline s64 teo_irq_next_event_ns(void)
+{
+	return KTIME_MAX;
+}
+#endif
+
 /*
  * The number of bits to shift the CPU's capacity by in order to determine
  * the utilized threshold.
@@ -388,6 +426,7 @@ static int teo_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 	bool alt_intercepts, alt_recent;
 	bool cpu_utilized;
 	s64 duration_ns;
+	s64 irq_ns;
 	int i;
 
 	if (dev->last_state_idx >= 0) {
@@ -601,6 +640,15 @@ static int teo_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 			idx = i;
 	}
 
+	/* Likewise for the next interrupt predicted from the IRQ timings. */
+	irq_ns = teo_irq_next_event_ns();
+	if (irq_ns < duration_ns &&
+	    drv->states[idx].target_residency_ns > irq_ns) {
+		i = teo_find_shallower_state(drv, dev, idx, irq_ns, false);
+		if (teo_state_ok(i, drv))
+			idx = i;
+	}
+
 	/*
 	 * If the selected state's target residency is below the tick length
 	 * and intercepts occurring before the tick length are the majority of
@@ -689,6 +737,11 @@ static struct cpuidle_governor teo_governor = {
 
 static int __init teo_governor_init(void)
 {
+#ifdef CONFIG_CPU_IDLE_GOV_TEO_IRQ_TIMINGS
+	if (teo_irq_timings)
+		irq_timings_enable();
+#endif
+
 	return cpuidle_register_governor(&teo_governor);
 }
 
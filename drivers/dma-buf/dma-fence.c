@@ -479,6 +479,62 @@ int dma_fence_signal(struct dma_fence *fence)
 }
 EXPORT_SYMBOL(dma_fence_signal);
 
+/**
+ * dma_fence_signal_batch - signal completion of several fences at once
+ * @fences: the fences to signal, all from the same context
+ * @count: number of fences in @fences
+ * @seqno: signal the fences up to and including this sequence number
+ *
+ * Signal all the fences of @fences which are not later than @seqno, as if
+ * dma_fence_signal() had been called on each of them, but with a single
+ * timestamp and taking &dma_fence.lock only once for consecutive fences
+ * sharing the same lock, as the fences of one timeline usually do. Fences
+ * later than @seqno and fences already signaled are skipped.
+ *
+ * Returns the number of fences signaled by this call.
+ */
+unsigned int dma_fence_signal_batch(struct dma_fence **fences,
+				    unsigned int count, u64 seqno)
+{
+	spinlock_t *lock = NULL;
+	unsigned int i, signaled = 0;
+	unsigned long flags;
+	ktime_t timestamp;
+	bool tmp;
+
+	if (!count)
+		return 0;
+
+	tmp = dma_fence_begin_signalling();
+	timestamp = ktime_get();
+
+	for (i = 0; i < count; i++) {
+		struct dma_fence *fence = fences[i];
+
+		if (__dma_fence_is_later(fence->seqno, seqno, fence->ops) ||
+		    test_bit(DMA_FENCE_FLAG_SIGNALED_BIT, &fence->flags))
+			continue;
+
+		if (fence->lock != lock) {
+			if (lock)
+				spin_unlock_irqrestore(lock, flags);
+			lock = fence->lock;
+			spin_lock_irqsave(lock, flags);
+		}
+
+		if (!dma_fence_signal_timestamp_locked(fence, timestamp))
+			signaled++;
+	}
+
+	if (lock)
+		spin_unlock_irqrestore(lock, flags);
+
+	dma_fence_end_signalling(tmp);
+
+	return signaled;
+}
+EXPORT_SYMBOL(dma_fence_signal_batch);
+
 /**
  * dma_fence_wait_timeout - sleep until the fence gets signaled
  * or until timeout elapses
@@ -601,6 +601,54 @@ int dma_resv_get_fences(struct dma_resv *obj, enum dma_resv_usage usage,
 }
 EXPORT_SYMBOL_GPL(dma_resv_get_fences);
 
+/**
+ * dma_resv_snapshot_fences - Get an object's fences into an array
+ * @obj: the reservation object
+ * @usage: controls which fences to include, see enum dma_resv_usage.
+ * @fences: array to return the fences in, with a reference held on each
+ * @max_fences: size of @fences
+ * @num_fences: the number of fences returned
+ *
+ * Like dma_resv_get_fences(), but using an array provided by the caller, so
+ * that frequent callers can snapshot the fences of many objects without
+ * allocating memory or taking the reservation lock.
+ *
+ * Returns zero on success or -ENOBUFS, with no fence returned, if the object
+ * has more than @max_fences fences.
+ */
+int dma_resv_snapshot_fences(struct dma_resv *obj, enum dma_resv_usage usage,
+			     struct dma_fence **fences,
+			     unsigned int max_fences,
+			     unsigned int *num_fences)
+{
+	struct dma_resv_iter cursor;
+	struct dma_fence *fence;
+	int ret = 0;
+
+	*num_fences = 0;
+
+	dma_resv_iter_begin(&cursor, obj, usage);
+	dma_resv_for_each_fence_unlocked(&cursor, fence) {
+		if (dma_resv_iter_is_restarted(&cursor)) {
+			while (*num_fences)
+				dma_fence_put(fences[--(*num_fences)]);
+		}
+
+		if (*num_fences == max_fences) {
+			while (*num_fences)
+				dma_fence_put(fences[--(*num_fences)]);
+			ret = -ENOBUFS;
+			break;
+		}
+
+		fences[(*num_fences)++] = dma_fence_get(fence);
+	}
+	dma_resv_iter_end(&cursor);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(dma_resv_snapshot_fences);
+
 /**
  * dma_resv_get_singleton - Get a single fence for all the fences
  * @obj: the reservation object
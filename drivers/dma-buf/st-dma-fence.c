@@ -147,6 +147,50 @@ static int test_signaling(void *arg)
 	return err;
 }
 
+static int test_signal_batch(void *arg)
+{
+	struct dma_fence *f[4] = {};
+	unsigned int n;
+	int err = -EINVAL;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(f); i++) {
+		f[i] = mock_fence();
+		if (!f[i]) {
+			err = -ENOMEM;
+			goto err_free;
+		}
+		f[i]->seqno = i + 1;
+		dma_fence_enable_sw_signaling(f[i]);
+	}
+
+	n = dma_fence_signal_batch(f, ARRAY_SIZE(f), 2);
+	if (n != 2) {
+		pr_err("Batch signaled %u fences, expected 2\n", n);
+		goto err_free;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(f); i++) {
+		if (dma_fence_is_signaled(f[i]) != (i < 2)) {
+			pr_err("Fence %d %ssignaled after batch\n", i,
+			       i < 2 ? "not " : "");
+			goto err_free;
+		}
+	}
+
+	n = dma_fence_signal_batch(f, ARRAY_SIZE(f), ARRAY_SIZE(f));
+	if (n != 2) {
+		pr_err("Second batch signaled %u fences, expected 2\n", n);
+		goto err_free;
+	}
+
+	err = 0;
+err_free:
+	for (i = 0; i < ARRAY_SIZE(f); i++)
+		dma_fence_put(f[i]);
+	return err;
+}
+
 struct simple_cb {
 	struct dma_fence_cb cb;
 	bool seen;
@@ -568,6 +612,7 @@ int dma_fence(void)
 	static const struct subtest tests[] = {
 		SUBTEST(sanitycheck),
 		SUBTEST(test_signaling),
+		SUBTEST(test_signal_batch),
 		SUBTEST(test_add_callback),
 		SUBTEST(test_late_add_callback),
 		SUBTEST(test_rm_callback),
@@ -293,6 +293,67 @@ static int test_get_fences(void *arg)
 	return r;
 }
 
+static int test_snapshot_fences(void *arg)
+{
+	enum dma_resv_usage usage = (unsigned long)arg;
+	struct dma_fence *f, *fences[2];
+	struct dma_resv resv;
+	unsigned int i;
+	int r;
+
+	f = alloc_fence();
+	if (!f)
+		return -ENOMEM;
+
+	dma_fence_enable_sw_signaling(f);
+
+	dma_resv_init(&resv);
+	r = dma_resv_lock(&resv, NULL);
+	if (r) {
+		pr_err("Resv locking failed\n");
+		goto err_resv;
+	}
+
+	r = dma_resv_reserve_fences(&resv, 1);
+	if (r) {
+		pr_err("Resv shared slot allocation failed\n");
+		dma_resv_unlock(&resv);
+		goto err_resv;
+	}
+
+	dma_resv_add_fence(&resv, f, usage);
+	dma_resv_unlock(&resv);
+
+	r = dma_resv_snapshot_fences(&resv, usage, fences, 0, &i);
+	if (r != -ENOBUFS || i) {
+		pr_err("snapshot_fences overflowed an empty array\n");
+		r = -EINVAL;
+		goto err_free;
+	}
+
+	r = dma_resv_snapshot_fences(&resv, usage, fences,
+				     ARRAY_SIZE(fences), &i);
+	if (r) {
+		pr_err("snapshot_fences failed\n");
+		goto err_free;
+	}
+
+	if (i != 1 || fences[0] != f) {
+		pr_err("snapshot_fences returned unexpected fence\n");
+		r = -EINVAL;
+		goto err_free;
+	}
+
+	dma_fence_signal(f);
+err_free:
+	while (i--)
+		dma_fence_put(fences[i]);
+err_resv:
+	dma_resv_fini(&resv);
+	dma_fence_put(f);
+	return r;
+}
+
 int dma_resv(void)
 {
 	static const struct subtest tests[] = {
@@ -301,6 +362,7 @@ int dma_resv(void)
 		SUBTEST(test_for_each),
 		SUBTEST(test_for_each_unlocked),
 		SUBTEST(test_get_fences),
+		SUBTEST(test_snapshot_fences),
 	};
 	enum dma_resv_usage usage;
 	int r;
@@ -155,6 +155,7 @@ int amdgpu_vm_fragment_size = -1;
 int amdgpu_vm_block_size = -1;
 int amdgpu_vm_fault_stop;
 int amdgpu_vm_update_mode = -1;
+int amdgpu_vm_update_sdma_min = 16384;
 int amdgpu_exp_hw_support;
 int amdgpu_dc = -1;
 int amdgpu_sched_jobs = 32;
@@ -443,6 +444,14 @@ module_param_named(vm_fault_stop, amdgpu_vm_fault_stop, int, 0444);
 MODULE_PARM_DESC(vm_update_mode, "VM update using CPU (0 = never (default except for large BAR(LB)), 1 = Graphics only, 2 = Compute only (default for LB), 3 = Both");
 module_param_named(vm_update_mode, amdgpu_vm_update_mode, int, 0444);
 
+/**
+ * DOC: vm_update_sdma_min (int)
+ * Number of page table entries from which a VM otherwise updated by the CPU uses SDMA for an update, so that large
+ * mappings don't stall the CPU. The default is 16384 (64MB of 4K pages), 0 means always use the CPU.
+ */
+MODULE_PARM_DESC(vm_update_sdma_min, "Min PTEs to update by SDMA in CPU updated VMs (16384 = default, 0 = never)");
+module_param_named(vm_update_sdma_min, amdgpu_vm_update_sdma_min, int, 0644);
+
 /**
  * DOC: exp_hw_support (int)
  * Enable experimental hw support (1 = enable). The default is 0 (disabled).
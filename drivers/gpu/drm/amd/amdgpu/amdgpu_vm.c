@@ -836,6 +836,7 @@ int amdgpu_vm_update_pdes(struct amdgpu_device *adev,
 	params.adev = adev;
 	params.vm = vm;
 	params.immediate = immediate;
+	params.funcs = vm->update_funcs;
 
 	r = vm->update_funcs->prepare(&params, NULL, AMDGPU_SYNC_EXPLICIT);
 	if (r)
@@ -949,6 +950,22 @@ int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
 	params.pages_addr = pages_addr;
 	params.unlocked = unlocked;
 	params.allow_override = allow_override;
+	params.funcs = vm->update_funcs;
+
+	/*
+	 * Writing many PTEs from the CPU stalls the caller, large updates of
+	 * CPU updated VMs go through SDMA instead.  Later CPU updates wait for
+	 * the last of those in amdgpu_vm_cpu_prepare().
+	 *
+	 * Updates from page faults and MMU notifiers stay on the CPU and can't
+	 * wait for it, so only VRAM mappings are offloaded: system memory
+	 * mappings, userptrs and SVM ranges among them, are what MMU notifiers
+	 * invalidate and an SDMA job would race with that invalidation.
+	 */
+	if (vm->use_cpu_for_update && !immediate && !unlocked && fence &&
+	    !pages_addr && amdgpu_vm_update_sdma_min > 0 &&
+	    last - start + 1 >= amdgpu_vm_update_sdma_min)
+		params.funcs = &amdgpu_vm_sdma_funcs;
 
 	/* Implicitly sync to command submissions in the same VM before
 	 * unmapping. Sync to moving fences before mapping.
@@ -972,7 +989,7 @@ int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
 		dma_fence_put(tmp);
 	}
 
-	r = vm->update_funcs->prepare(&params, resv, sync_mode);
+	r = params.funcs->prepare(&params, resv, sync_mode);
 	if (r)
 		goto error_free;
 
@@ -1030,7 +1047,12 @@ int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
 		start = tmp;
 	}
 
-	r = vm->update_funcs->commit(&params, fence);
+	r = params.funcs->commit(&params, fence);
+
+	if (!r && params.funcs != vm->update_funcs && *fence) {
+		dma_fence_put(vm->last_sdma_update);
+		vm->last_sdma_update = dma_fence_get(*fence);
+	}
 
 	if (flush_tlb || params.table_freed) {
 		tlb_cb->vm = vm;
@@ -2407,6 +2429,7 @@ int amdgpu_vm_init(struct amdgpu_device *adev, struct amdgpu_vm *vm,
 	vm->last_update = dma_fence_get_stub();
 	vm->last_unlocked = dma_fence_get_stub();
 	vm->last_tlb_flush = dma_fence_get_stub();
+	vm->last_sdma_update = NULL;
 	vm->generation = 0;
 
 	mutex_init(&vm->eviction_lock);
@@ -2568,6 +2591,9 @@ void amdgpu_vm_fini(struct amdgpu_device *adev, struct amdgpu_vm *vm)
 	spin_lock_irqsave(vm->last_tlb_flush->lock, flags);
 	spin_unlock_irqrestore(vm->last_tlb_flush->lock, flags);
 	dma_fence_put(vm->last_tlb_flush);
+	if (vm->last_sdma_update)
+		dma_fence_wait(vm->last_sdma_update, false);
+	dma_fence_put(vm->last_sdma_update);
 
 	list_for_each_entry_safe(mapping, tmp, &vm->freed, list) {
 		if (mapping->flags & AMDGPU_PTE_PRT && prt_fini_needed) {
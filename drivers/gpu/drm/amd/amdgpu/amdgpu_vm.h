@@ -266,6 +266,12 @@ struct amdgpu_vm_update_params {
 	 * to be overridden for NUMA local memory.
 	 */
 	bool allow_override;
+
+	/**
+	 * @funcs: how the PTEs are written, the VM's update_funcs unless a large
+	 * update of a CPU updated VM goes through SDMA
+	 */
+	const struct amdgpu_vm_update_funcs *funcs;
 };
 
 struct amdgpu_vm_update_funcs {
@@ -341,6 +347,9 @@ struct amdgpu_vm {
 	/* Last finished delayed update */
 	atomic64_t		tlb_seq;
 	struct dma_fence	*last_tlb_flush;
+
+	/* Last SDMA update of a VM updated by the CPU, see vm_update_sdma_min */
+	struct dma_fence	*last_sdma_update;
 	atomic64_t		kfd_last_flushed_seq;
 
 	/* How many times we had to re-generate the page tables */
@@ -49,6 +49,23 @@ static int amdgpu_vm_cpu_prepare(struct amdgpu_vm_update_params *p,
 				 struct dma_resv *resv,
 				 enum amdgpu_sync_mode sync_mode)
 {
+	struct amdgpu_vm *vm = p->vm;
+
+	/*
+	 * Large updates may have been written by SDMA, wait for the last one.
+	 * Page fault and MMU notifier updates can't wait for a job; they never
+	 * touch the VRAM mappings that are offloaded, see
+	 * amdgpu_vm_update_range().
+	 */
+	if (vm && !p->immediate && !p->unlocked && vm->last_sdma_update) {
+		long r = dma_fence_wait(vm->last_sdma_update, true);
+
+		if (r)
+			return r;
+		dma_fence_put(vm->last_sdma_update);
+		vm->last_sdma_update = NULL;
+	}
+
 	if (!resv)
 		return 0;
 
@@ -763,8 +763,7 @@ static void amdgpu_vm_pte_update_flags(struct amdgpu_vm_update_params *params,
 	    num_possible_nodes() > 1 && !params->pages_addr && params->allow_override)
 		amdgpu_gmc_override_vm_pte_flags(adev, params->vm, addr, &flags);
 
-	params->vm->update_funcs->update(params, pt, pe, addr, count, incr,
-					 flags);
+	params->funcs->update(params, pt, pe, addr, count, incr, flags);
 }
 
 /**
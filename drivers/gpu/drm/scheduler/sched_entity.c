@@ -514,6 +514,8 @@ struct drm_sched_job *drm_sched_entity_pop_job(struct drm_sched_entity *entity)
 		next = to_drm_sched_job(spsc_queue_peek(&entity->job_queue));
 		if (next)
 			drm_sched_rq_update_fifo(entity, next->submit_ts);
+		else
+			drm_sched_rq_remove_fifo_idle(entity);
 	}
 
 	/* Jobs and entities might have different lifecycles. Since we're
@@ -184,6 +184,29 @@ void drm_sched_rq_update_fifo(struct drm_sched_entity *entity, ktime_t ts)
 	spin_unlock(&entity->rq_lock);
 }
 
+/**
+ * drm_sched_rq_remove_fifo_idle - take an idle entity out of the FIFO tree
+ *
+ * @entity: scheduler entity whose job queue was found empty
+ *
+ * Idle entities would otherwise stay in the tree with the timestamp of
+ * their last job, and be skipped over by every FIFO selection. The queue
+ * is checked again under the locks, as a concurrent drm_sched_entity_push_job()
+ * re-adds the entity through drm_sched_rq_update_fifo() only after its job
+ * is visible.
+ */
+void drm_sched_rq_remove_fifo_idle(struct drm_sched_entity *entity)
+{
+	spin_lock(&entity->rq_lock);
+	spin_lock(&entity->rq->lock);
+
+	if (!spsc_queue_peek(&entity->job_queue))
+		drm_sched_rq_remove_fifo_locked(entity);
+
+	spin_unlock(&entity->rq->lock);
+	spin_unlock(&entity->rq_lock);
+}
+
 /**
  * drm_sched_rq_init - initialize a given run queue struct
  *
@@ -64,6 +64,7 @@ MODULE_PARM_DESC(page_pool_size, "Number of pages in the WC/UC/DMA pool");
 module_param(page_pool_size, ulong, 0644);
 
 static atomic_long_t allocated_pages;
+static atomic_long_t allocated_pages_node[MAX_NUMNODES];
 
 static struct ttm_pool_type global_write_combined[NR_PAGE_ORDERS];
 static struct ttm_pool_type global_uncached[NR_PAGE_ORDERS];
@@ -237,17 +238,40 @@ static void ttm_pool_type_give(struct ttm_pool_type *pt, struct page *p)
 	list_add(&p->lru, &pt->pages);
 	spin_unlock(&pt->lock);
 	atomic_long_add(1 << pt->order, &allocated_pages);
+	atomic_long_add(1 << pt->order, &allocated_pages_node[page_to_nid(p)]);
 }
 
-/* Take pages from a specific pool_type, return NULL when nothing available */
-static struct page *ttm_pool_type_take(struct ttm_pool_type *pt)
+/* Number of pages the shrinker looks at for one on the node it shrinks */
+#define TTM_POOL_NODE_SCAN	16
+
+/*
+ * Take pages from a specific pool_type, return NULL when nothing available.
+ * With @nid set, the first TTM_POOL_NODE_SCAN pages are searched for one on
+ * that node, and the first page is taken if none of them is. This keeps the
+ * time spent under pt->lock bounded and the shrinker making progress.
+ */
+static struct page *ttm_pool_type_take_node(struct ttm_pool_type *pt, int nid)
 {
-	struct page *p;
+	struct page *p, *first;
+	unsigned int scan = 0;
 
 	spin_lock(&pt->lock);
-	p = list_first_entry_or_null(&pt->pages, typeof(*p), lru);
+	first = list_first_entry_or_null(&pt->pages, typeof(*p), lru);
+	p = first;
+	if (first && nid != NUMA_NO_NODE) {
+		list_for_each_entry(p, &pt->pages, lru) {
+			if (page_to_nid(p) == nid)
+				goto found;
+			if (++scan == TTM_POOL_NODE_SCAN)
+				break;
+		}
+		p = first;
+	}
+found:
 	if (p) {
 		atomic_long_sub(1 << pt->order, &allocated_pages);
+		atomic_long_sub(1 << pt->order,
+				&allocated_pages_node[page_to_nid(p)]);
 		list_del(&p->lru);
 	}
 	spin_unlock(&pt->lock);
@@ -255,6 +279,11 @@ static struct page *ttm_pool_type_take(struct ttm_pool_type *pt)
 	return p;
 }
 
+static struct page *ttm_pool_type_take(struct ttm_pool_type *pt)
+{
+	return ttm_pool_type_take_node(pt, NUMA_NO_NODE);
+}
+
 /* Initialize and add a pool type to the global shrinker list */
 static void ttm_pool_type_init(struct ttm_pool_type *pt, struct ttm_pool *pool,
 			       enum ttm_caching caching, unsigned int order)
@@ -317,8 +346,8 @@ static struct ttm_pool_type *ttm_pool_select_type(struct ttm_pool *pool,
 	return NULL;
 }
 
-/* Free pages using the global shrinker list */
-static unsigned int ttm_pool_shrink(void)
+/* Free pages on node @nid, or any node, using the global shrinker list */
+static unsigned int ttm_pool_shrink(int nid)
 {
 	struct ttm_pool_type *pt;
 	unsigned int num_pages;
@@ -330,7 +359,7 @@ static unsigned int ttm_pool_shrink(void)
 	list_move_tail(&pt->shrinker_list, &shrinker_list);
 	spin_unlock(&shrinker_lock);
 
-	p = ttm_pool_type_take(pt);
+	p = ttm_pool_type_take_node(pt, nid);
 	if (p) {
 		ttm_pool_free_page(pt->pool, pt->caching, pt->order, p);
 		num_pages = 1 << pt->order;
@@ -545,7 +574,7 @@ void ttm_pool_free(struct ttm_pool *pool, struct ttm_tt *tt)
 	ttm_pool_free_range(pool, tt, tt->caching, 0, tt->num_pages);
 
 	while (atomic_long_read(&allocated_pages) > page_pool_size)
-		ttm_pool_shrink();
+		ttm_pool_shrink(NUMA_NO_NODE);
 }
 EXPORT_SYMBOL(ttm_pool_free);
 
@@ -630,6 +659,15 @@ void ttm_pool_fini(struct ttm_pool *pool)
 }
 EXPORT_SYMBOL(ttm_pool_fini);
 
+/* Number of pages available on node @nid, or on all nodes */
+static unsigned long ttm_pool_pages(int nid)
+{
+	if (nid == NUMA_NO_NODE)
+		return atomic_long_read(&allocated_pages);
+
+	return atomic_long_read(&allocated_pages_node[nid]);
+}
+
 /* As long as pages are available make sure to release at least one */
 static unsigned long ttm_pool_shrinker_scan(struct shrinker *shrink,
 					    struct shrink_control *sc)
@@ -637,8 +675,8 @@ static unsigned long ttm_pool_shrinker_scan(struct shrinker *shrink,
 	unsigned long num_freed = 0;
 
 	do
-		num_freed += ttm_pool_shrink();
-	while (!num_freed && atomic_long_read(&allocated_pages));
+		num_freed += ttm_pool_shrink(sc->nid);
+	while (!num_freed && ttm_pool_pages(sc->nid));
 
 	return num_freed;
 }
@@ -647,7 +685,7 @@ static unsigned long ttm_pool_shrinker_scan(struct shrinker *shrink,
 static unsigned long ttm_pool_shrinker_count(struct shrinker *shrink,
 					     struct shrink_control *sc)
 {
-	unsigned long num_pages = atomic_long_read(&allocated_pages);
+	unsigned long num_pages = ttm_pool_pages(sc->nid);
 
 	return num_pages ? num_pages : SHRINK_EMPTY;
 }
@@ -764,7 +802,10 @@ EXPORT_SYMBOL(ttm_pool_debugfs);
 /* Test the shrinker functions and dump the result */
 static int ttm_pool_debugfs_shrink_show(struct seq_file *m, void *data)
 {
-	struct shrink_control sc = { .gfp_mask = GFP_NOFS };
+	struct shrink_control sc = {
+		.gfp_mask = GFP_NOFS,
+		.nid = NUMA_NO_NODE,
+	};
 
 	fs_reclaim_acquire(GFP_KERNEL);
 	seq_printf(m, "%lu/%lu\n", ttm_pool_shrinker_count(mm_shrinker, &sc),
@@ -812,7 +853,7 @@ int ttm_pool_mgr_init(unsigned long num_pages)
 			    &ttm_pool_debugfs_shrink_fops);
 #endif
 
-	mm_shrinker = shrinker_alloc(0, "drm-ttm_pool");
+	mm_shrinker = shrinker_alloc(SHRINKER_NUMA_AWARE, "drm-ttm_pool");
 	if (!mm_shrinker)
 		return -ENOMEM;
 
@@ -16,7 +16,8 @@
 /* The anchor node sits above the top of the usable address space */
 #define IOVA_ANCHOR	~0UL
 
-#define IOVA_RANGE_CACHE_MAX_SIZE 6	/* log of max cached IOVA range size (in pages) */
+/* log of max cached IOVA range size (in pages), plus one */
+#define IOVA_RANGE_CACHE_MAX_SIZE (CONFIG_IOMMU_IOVA_RCACHE_MAX_ORDER + 1)
 
 static bool iova_rcache_insert(struct iova_domain *iovad,
 			       unsigned long pfn,
@@ -564,6 +565,13 @@ EXPORT_SYMBOL_GPL(reserve_iova);
  */
 #define IOVA_MAG_SIZE 127
 
+/*
+ * Above this order the magazine depth is halved with each order, so that the
+ * caches of large sizes don't pin down too much IOVA space per CPU.
+ */
+#define IOVA_MAG_FULL_DEPTH_ORDER 5
+#define IOVA_MAG_MIN_DEPTH 8
+
 #define IOVA_DEPOT_DELAY msecs_to_jiffies(100)
 
 struct iova_magazine {
@@ -584,6 +592,7 @@ struct iova_cpu_rcache {
 struct iova_rcache {
 	spinlock_t lock;
 	unsigned int depot_size;
+	unsigned int mag_depth;
 	struct iova_magazine *depot;
 	struct iova_cpu_rcache __percpu *cpu_rcaches;
 	struct iova_domain *iovad;
@@ -636,9 +645,10 @@ iova_magazine_free_pfns(struct iova_magazine *mag, struct iova_domain *iovad)
 	mag->size = 0;
 }
 
-static bool iova_magazine_full(struct iova_magazine *mag)
+static bool iova_magazine_full(struct iova_rcache *rcache,
+			       struct iova_magazine *mag)
 {
-	return mag->size == IOVA_MAG_SIZE;
+	return mag->size >= rcache->mag_depth;
 }
 
 static bool iova_magazine_empty(struct iova_magazine *mag)
@@ -674,7 +684,7 @@ static struct iova_magazine *iova_depot_pop(struct iova_rcache *rcache)
 	struct iova_magazine *mag = rcache->depot;
 
 	rcache->depot = mag->next;
-	mag->size = IOVA_MAG_SIZE;
+	mag->size = rcache->mag_depth;
 	rcache->depot_size--;
 	return mag;
 }
@@ -721,6 +731,11 @@ int iova_domain_init_rcaches(struct iova_domain *iovad)
 
 		rcache = &iovad->rcaches[i];
 		spin_lock_init(&rcache->lock);
+		rcache->mag_depth = IOVA_MAG_SIZE;
+		if (i > IOVA_MAG_FULL_DEPTH_ORDER)
+			rcache->mag_depth = max(IOVA_MAG_SIZE >>
+						(i - IOVA_MAG_FULL_DEPTH_ORDER),
+						IOVA_MAG_MIN_DEPTH);
 		rcache->iovad = iovad;
 		INIT_DELAYED_WORK(&rcache->work, iova_depot_work_func);
 		rcache->cpu_rcaches = __alloc_percpu(sizeof(*cpu_rcache),
@@ -771,9 +786,9 @@ static bool __iova_rcache_insert(struct iova_domain *iovad,
 	cpu_rcache = raw_cpu_ptr(rcache->cpu_rcaches);
 	spin_lock_irqsave(&cpu_rcache->lock, flags);
 
-	if (!iova_magazine_full(cpu_rcache->loaded)) {
+	if (!iova_magazine_full(rcache, cpu_rcache->loaded)) {
 		can_insert = true;
-	} else if (!iova_magazine_full(cpu_rcache->prev)) {
+	} else if (!iova_magazine_full(rcache, cpu_rcache->prev)) {
 		swap(cpu_rcache->prev, cpu_rcache->loaded);
 		can_insert = true;
 	} else {
@@ -498,6 +498,90 @@ int dm_btree_lookup_next(struct dm_btree_info *info, dm_block_t root,
 }
 EXPORT_SYMBOL_GPL(dm_btree_lookup_next);
 
+static int lookup_sorted(struct dm_btree_info *info, dm_block_t block,
+			 uint64_t *keys, unsigned int nr, void *values_le,
+			 int *results)
+{
+	struct dm_block_manager *bm = dm_tm_get_bm(info->tm);
+	size_t value_size = info->value_type.size;
+	uint32_t flags, nr_entries;
+	struct dm_block *node;
+	struct btree_node *n;
+	unsigned int i, j;
+	int r, index, prev;
+
+	r = bn_read_lock(info, block, &node);
+	if (r)
+		return r;
+
+	n = dm_block_data(node);
+	flags = le32_to_cpu(n->header.flags);
+	nr_entries = le32_to_cpu(n->header.nr_entries);
+
+	if (flags & LEAF_NODE) {
+		for (i = 0; i < nr; i++) {
+			index = lower_bound(n, keys[i]);
+			if (index < 0 || index >= nr_entries ||
+			    le64_to_cpu(n->keys[index]) != keys[i]) {
+				results[i] = -ENODATA;
+				continue;
+			}
+
+			memcpy(values_le + i * value_size,
+			       value_ptr(n, index), value_size);
+			results[i] = 0;
+		}
+		goto out;
+	}
+
+	/*
+	 * Issue the reads of all the children this run of keys goes to
+	 * before descending into the first one.
+	 */
+	for (i = 0, prev = -1; i < nr; i++) {
+		index = lower_bound(n, keys[i]);
+		if (index >= 0 && index < nr_entries && index != prev) {
+			dm_bm_prefetch(bm, value64(n, index));
+			prev = index;
+		}
+	}
+
+	for (i = 0; i < nr; i = j) {
+		index = lower_bound(n, keys[i]);
+		for (j = i + 1; j < nr; j++)
+			if (lower_bound(n, keys[j]) != index)
+				break;
+
+		if (index < 0 || index >= nr_entries) {
+			while (i < j)
+				results[i++] = -ENODATA;
+			continue;
+		}
+
+		r = lookup_sorted(info, value64(n, index), keys + i, j - i,
+				  values_le + i * value_size, results + i);
+		if (r)
+			break;
+	}
+out:
+	dm_tm_unlock(info->tm, node);
+	return r;
+}
+
+int dm_btree_lookup_sorted(struct dm_btree_info *info, dm_block_t root,
+			   uint64_t *keys, unsigned int nr, void *values_le,
+			   int *results)
+{
+	if (WARN_ON_ONCE(info->levels > 1))
+		return -EINVAL;
+
+	if (!nr)
+		return 0;
+
+	return lookup_sorted(info, root, keys, nr, values_le, results);
+}
+EXPORT_SYMBOL_GPL(dm_btree_lookup_sorted);
+
 /*----------------------------------------------------------------*/
 
 /*
@@ -1335,6 +1419,117 @@ int dm_btree_insert_notify(struct dm_btree_info *info, dm_block_t root,
 }
 EXPORT_SYMBOL_GPL(dm_btree_insert_notify);
 
+/*
+ * Once btree_insert_raw() has got us to a shadowed leaf for the first key,
+ * the following keys can go in the same leaf, without walking down from the
+ * root again, as long as they are below the key of the next leaf and the
+ * leaf has room for them.  Returns the number of keys after the first one
+ * that belong in the leaf.
+ */
+static unsigned int leaf_run(struct shadow_spine *s, uint64_t *keys,
+			     unsigned int nr)
+{
+	struct btree_node *parent;
+	uint64_t limit;
+	int index;
+	unsigned int i;
+
+	if (shadow_has_parent(s)) {
+		parent = dm_block_data(shadow_parent(s));
+		index = lower_bound(parent, keys[0]);
+
+		if (index + 1 < le32_to_cpu(parent->header.nr_entries))
+			limit = le64_to_cpu(parent->keys[index + 1]);
+		else if (dm_block_location(shadow_parent(s)) == shadow_root(s))
+			limit = ULLONG_MAX;
+		else
+			/* the upper bound is in a node no longer on the spine */
+			return 0;
+	} else {
+		limit = ULLONG_MAX;
+	}
+
+	for (i = 1; i < nr; i++)
+		if (keys[i] >= limit)
+			break;
+
+	return i - 1;
+}
+
+int dm_btree_insert_sorted(struct dm_btree_info *info, dm_block_t root,
+			   uint64_t *keys, unsigned int nr, void *values,
+			   dm_block_t *new_root, unsigned int *nr_inserted)
+{
+	struct dm_btree_value_type *vt = &info->value_type;
+	unsigned int i, run, done = 0, inserted = 0;
+	struct shadow_spine spine;
+	struct btree_node *n;
+	unsigned int index;
+	int r = 0;
+
+	if (WARN_ON_ONCE(info->levels > 1))
+		return -EINVAL;
+
+	while (done < nr) {
+		init_shadow_spine(&spine, info);
+
+		index = -1;
+		r = btree_insert_raw(&spine, root, vt, keys[done], &index);
+		if (r < 0) {
+			exit_shadow_spine(&spine);
+			break;
+		}
+
+		n = dm_block_data(shadow_current(&spine));
+		run = leaf_run(&spine, keys + done, nr - done);
+
+		for (i = 0; i <= run; i++, done++) {
+			void *value = values + done * vt->size;
+			uint64_t key = keys[done];
+
+			if (i) {
+				int lb = lower_bound(n, key);
+
+				if (lb < 0 || le64_to_cpu(n->keys[lb]) != key)
+					lb++;
+				index = lb;
+			}
+
+			if (!need_insert(n, keys + done, 0, index)) {
+				if (vt->dec && (!vt->equal ||
+						!vt->equal(vt->context,
+							   value_ptr(n, index),
+							   value)))
+					vt->dec(vt->context, value_ptr(n, index), 1);
+				memcpy_disk(value_ptr(n, index), value, vt->size);
+				continue;
+			}
+
+			/* a full leaf has to be split by the next walk */
+			if (i && le32_to_cpu(n->header.nr_entries) ==
+				 le32_to_cpu(n->header.max_entries))
+				break;
+
+			r = insert_at(vt->size, n, index, key, value);
+			if (r)
+				break;
+			inserted++;
+		}
+
+		root = shadow_root(&spine);
+		exit_shadow_spine(&spine);
+		if (r)
+			break;
+	}
+
+	*new_root = root;
+	if (nr_inserted)
+		*nr_inserted = inserted;
+
+	return r;
+}
+EXPORT_SYMBOL_GPL(dm_btree_insert_sorted);
+
 /*----------------------------------------------------------------*/
 
 static int find_key(struct ro_spine *s, dm_block_t block, bool find_highest,
@@ -117,6 +117,17 @@ int dm_btree_lookup(struct dm_btree_info *info, dm_block_t root,
 int dm_btree_lookup_next(struct dm_btree_info *info, dm_block_t root,
 			 uint64_t *keys, uint64_t *rkey, void *value_le);
 
+/*
+ * Looks up @nr keys, sorted in ascending order, of a single level btree.
+ * Each node on the way is read once for the whole run, and the children a
+ * run goes to are prefetched together.  The value of keys[i] is copied to
+ * the i'th value of @values_le and results[i] is set to 0, or to -ENODATA
+ * if the key isn't present.  Returns 0, or < 0 if a node can't be read.
+ */
+int dm_btree_lookup_sorted(struct dm_btree_info *info, dm_block_t root,
+			   uint64_t *keys, unsigned int nr, void *values_le,
+			   int *results);
+
 /*
  * Insertion (or overwrite an existing value).  O(ln(n))
  */
@@ -134,6 +145,19 @@ int dm_btree_insert_notify(struct dm_btree_info *info, dm_block_t root,
 			   int *inserted)
 			   __dm_written_to_disk(value);
 
+/*
+ * Inserts (or overwrites) @nr keys, sorted in ascending order, with the
+ * matching values from @values, in a single level btree.  All the keys that
+ * go in the same leaf are inserted by a single walk from the root, so each
+ * touched node is shadowed once per leaf rather than once per key.  The
+ * number of new entries is returned in @nr_inserted, which may be NULL.
+ * On error, some of the keys may already have been inserted and the
+ * transaction should be aborted.
+ */
+int dm_btree_insert_sorted(struct dm_btree_info *info, dm_block_t root,
+			   uint64_t *keys, unsigned int nr, void *values,
+			   dm_block_t *new_root, unsigned int *nr_inserted);
+
 /*
  * Remove a key if present.  This doesn't remove empty sub trees.  Normally
  * subtrees represent a separate entity, like a snapshot map, so this is
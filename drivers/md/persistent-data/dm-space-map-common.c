@@ -417,6 +417,68 @@ int sm_ll_find_common_free_block(struct ll_disk *old_ll, struct ll_disk *new_ll,
 	return r;
 }
 
+/*
+ * The number of consecutive free entries of @ll from @b, up to @max and
+ * within the bitmap block of @b.
+ */
+static int sm_ll_free_run(struct ll_disk *ll, dm_block_t b, unsigned int max,
+			  unsigned int *len)
+{
+	int r;
+	dm_block_t index = b;
+	struct disk_index_entry ie_disk;
+	struct dm_block *blk;
+	unsigned int bit, end;
+
+	bit = do_div(index, ll->entries_per_block);
+	end = bit + min_t(dm_block_t, max, ll->nr_blocks - b);
+	end = min(end, ll->entries_per_block);
+
+	r = ll->load_ie(ll, index, &ie_disk);
+	if (r < 0)
+		return r;
+
+	r = dm_tm_read_lock(ll->tm, le64_to_cpu(ie_disk.blocknr),
+			    &dm_sm_bitmap_validator, &blk);
+	if (r < 0)
+		return r;
+
+	for (*len = 0; bit < end; bit++, (*len)++)
+		if (sm_lookup_bitmap(dm_bitmap_data(blk), bit))
+			break;
+
+	dm_tm_unlock(ll->tm, blk);
+	return 0;
+}
+
+int sm_ll_find_common_free_run(struct ll_disk *old_ll, struct ll_disk *new_ll,
+			       dm_block_t begin, dm_block_t end,
+			       unsigned int max, dm_block_t *b,
+			       unsigned int *len)
+{
+	int r;
+	unsigned int old_len;
+
+	r = sm_ll_find_common_free_block(old_ll, new_ll, begin, end, b);
+	if (r)
+		return r;
+
+	r = sm_ll_free_run(new_ll, *b, max, len);
+	if (r)
+		return r;
+
+	if (*b < old_ll->nr_blocks) {
+		r = sm_ll_free_run(old_ll, *b, *len, &old_len);
+		if (r)
+			return r;
+		*len = old_len;
+	}
+
+	/* *b is known to be free in both, even if the lookups disagree */
+	*len = max(*len, 1U);
+	return 0;
+}
+
 /*----------------------------------------------------------------*/
 
 int sm_ll_insert(struct ll_disk *ll, dm_block_t b,
@@ -123,6 +123,17 @@ int sm_ll_find_free_block(struct ll_disk *ll, dm_block_t begin,
 int sm_ll_find_common_free_block(struct ll_disk *old_ll, struct ll_disk *new_ll,
 				 dm_block_t begin, dm_block_t end, dm_block_t *result);
 
+/*
+ * Finds a block free in both @old_ll and @new_ll like
+ * sm_ll_find_common_free_block(), and returns in @len how many blocks from
+ * it, at most @max, are free in both.  The run doesn't cross a bitmap
+ * block.
+ */
+int sm_ll_find_common_free_run(struct ll_disk *old_ll, struct ll_disk *new_ll,
+			       dm_block_t begin, dm_block_t end,
+			       unsigned int max, dm_block_t *result,
+			       unsigned int *len);
+
 /*
  * The next three functions return (via nr_allocations) the net number of
  * allocations that were made.  This number may be negative if there were
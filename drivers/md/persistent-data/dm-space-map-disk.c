@@ -17,6 +17,12 @@
 
 #define DM_MSG_PREFIX "space map disk"
 
+/*
+ * The most free blocks found by one bitmap scan that new_block hands out
+ * before scanning again.
+ */
+#define SM_DISK_ALLOC_RUN 128
+
 /*----------------------------------------------------------------*/
 
 /*
@@ -30,8 +36,22 @@ struct sm_disk {
 
 	dm_block_t begin;
 	dm_block_t nr_allocated_this_transaction;
+
+	/* [run_begin, run_end) are free in both ll and old_ll */
+	dm_block_t run_begin;
+	dm_block_t run_end;
 };
 
+/*
+ * Forget the cached run of free blocks if [b, e) is being allocated behind
+ * new_block's back.
+ */
+static void sm_disk_drop_run(struct sm_disk *smd, dm_block_t b, dm_block_t e)
+{
+	if (b < smd->run_end && e > smd->run_begin)
+		smd->run_begin = smd->run_end = 0;
+}
+
 static void sm_disk_destroy(struct dm_space_map *sm)
 {
 	struct sm_disk *smd = container_of(sm, struct sm_disk, sm);
@@ -94,6 +114,8 @@ static int sm_disk_set_count(struct dm_space_map *sm, dm_block_t b,
 	int32_t nr_allocations;
 	struct sm_disk *smd = container_of(sm, struct sm_disk, sm);
 
+	if (count)
+		sm_disk_drop_run(smd, b, b + 1);
 	r = sm_ll_insert(&smd->ll, b, count, &nr_allocations);
 	if (!r)
 		smd->nr_allocated_this_transaction += nr_allocations;
@@ -107,6 +129,7 @@ static int sm_disk_inc_blocks(struct dm_space_map *sm, dm_block_t b, dm_block_t
 	int32_t nr_allocations;
 	struct sm_disk *smd = container_of(sm, struct sm_disk, sm);
 
+	sm_disk_drop_run(smd, b, e);
 	r = sm_ll_inc(&smd->ll, b, e, &nr_allocations);
 	if (!r)
 		smd->nr_allocated_this_transaction += nr_allocations;
@@ -132,21 +155,32 @@ static int sm_disk_new_block(struct dm_space_map *sm, dm_block_t *b)
 	int r;
 	int32_t nr_allocations;
 	struct sm_disk *smd = container_of(sm, struct sm_disk, sm);
+	unsigned int len;
 
-	/*
-	 * Any block we allocate has to be free in both the old and current ll.
-	 */
-	r = sm_ll_find_common_free_block(&smd->old_ll, &smd->ll, smd->begin, smd->ll.nr_blocks, b);
-	if (r == -ENOSPC)
+	if (smd->run_begin == smd->run_end) {
 		/*
-		 * There's no free block between smd->begin and the end of the metadata device.
-		 * We search before smd->begin in case something has been freed.
+		 * Any block we allocate has to be free in both the old and current ll.
 		 */
-		r = sm_ll_find_common_free_block(&smd->old_ll, &smd->ll, 0, smd->begin, b);
-
-	if (r)
-		return r;
-
+		r = sm_ll_find_common_free_run(&smd->old_ll, &smd->ll, smd->begin,
+					       smd->ll.nr_blocks, SM_DISK_ALLOC_RUN,
+					       b, &len);
+		if (r == -ENOSPC)
+			/*
+			 * There's no free block between smd->begin and the end of the metadata device.
+			 * We search before smd->begin in case something has been freed.
+			 */
+			r = sm_ll_find_common_free_run(&smd->old_ll, &smd->ll, 0,
+						       smd->begin, SM_DISK_ALLOC_RUN,
+						       b, &len);
+
+		if (r)
+			return r;
+
+		smd->run_begin = *b;
+		smd->run_end = *b + len;
+	}
+
+	*b = smd->run_begin++;
 	smd->begin = *b + 1;
 	r = sm_ll_inc(&smd->ll, *b, *b + 1, &nr_allocations);
 	if (!r)
@@ -167,6 +201,9 @@ static int sm_disk_commit(struct dm_space_map *sm)
 	memcpy(&smd->old_ll, &smd->ll, sizeof(smd->old_ll));
 	smd->nr_allocated_this_transaction = 0;
 
+	/* Hand back whatever is left of the run */
+	smd->run_begin = smd->run_end = 0;
+
 	return 0;
 }
 
@@ -226,6 +263,7 @@ struct dm_space_map *dm_sm_disk_create(struct dm_transaction_manager *tm,
 
 	smd->begin = 0;
 	smd->nr_allocated_this_transaction = 0;
+	smd->run_begin = smd->run_end = 0;
 	memcpy(&smd->sm, &ops, sizeof(smd->sm));
 
 	r = sm_ll_new_disk(&smd->ll, tm);
@@ -260,6 +298,7 @@ struct dm_space_map *dm_sm_disk_open(struct dm_transaction_manager *tm,
 
 	smd->begin = 0;
 	smd->nr_allocated_this_transaction = 0;
+	smd->run_begin = smd->run_end = 0;
 	memcpy(&smd->sm, &ops, sizeof(smd->sm));
 
 	r = sm_ll_open_disk(&smd->ll, tm, root_le, len);
@@ -3067,6 +3067,102 @@ static unsigned char tun_get_addr_len(unsigned short type)
 	}
 }
 
+/* Deliver the skbs tun_get_user() held back for a batch that ended early */
+static void tun_rx_flush(struct tun_struct *tun, struct tun_file *tfile)
+{
+	struct sk_buff_head *queue = &tfile->sk.sk_write_queue;
+	struct sk_buff_head process_queue;
+	struct sk_buff *skb;
+
+	if (tfile->napi_enabled) {
+		local_bh_disable();
+		if (!skb_queue_empty_lockless(queue))
+			napi_schedule(&tfile->napi);
+		local_bh_enable();
+		return;
+	}
+
+	__skb_queue_head_init(&process_queue);
+	spin_lock(&queue->lock);
+	skb_queue_splice_tail_init(queue, &process_queue);
+	spin_unlock(&queue->lock);
+
+	local_bh_disable();
+	while ((skb = __skb_dequeue(&process_queue))) {
+		skb_record_rx_queue(skb, tfile->queue_index);
+		netif_receive_skb(skb);
+	}
+	local_bh_enable();
+}
+
+/* Read or write up to TUN_PKTS_MAX packets, see struct tun_pkts */
+static long tun_chr_ioctl_pkts(struct file *file, unsigned int cmd,
+			       void __user *argp)
+{
+	struct tun_file *tfile = file->private_data;
+	struct tun_pkt __user *upkts;
+	struct tun_struct *tun;
+	struct tun_pkts pkts;
+	int noblock, i;
+	ssize_t ret = 0;
+
+	if (copy_from_user(&pkts, argp, sizeof(pkts)))
+		return -EFAULT;
+	if (pkts.flags || !pkts.count || pkts.count > TUN_PKTS_MAX)
+		return -EINVAL;
+
+	tun = tun_get(tfile);
+	if (!tun)
+		return -EBADFD;
+
+	noblock = !!(file->f_flags & O_NONBLOCK);
+	upkts = u64_to_user_ptr(pkts.pkts);
+
+	for (i = 0; i < pkts.count; i++) {
+		struct iov_iter iter;
+		struct tun_pkt pkt;
+
+		ret = -EFAULT;
+		if (copy_from_user(&pkt, &upkts[i], sizeof(pkt)))
+			break;
+		ret = -EINVAL;
+		if (pkt.flags)
+			break;
+
+		if (cmd == TUNWRITEPKTS) {
+			ret = import_ubuf(ITER_SOURCE, u64_to_user_ptr(pkt.addr),
+					  pkt.len, &iter);
+			if (ret)
+				break;
+			/* Let the batching of the rx path see the whole batch */
+			ret = tun_get_user(tun, tfile, NULL, &iter, noblock,
+					   i + 1 < pkts.count);
+			if (ret < 0)
+				break;
+		} else {
+			ret = import_ubuf(ITER_DEST, u64_to_user_ptr(pkt.addr),
+					  pkt.len, &iter);
+			if (ret)
+				break;
+			/* Only wait for the first packet */
+			ret = tun_do_read(tun, tfile, &iter, noblock || i, NULL);
+			if (ret < 0)
+				break;
+			ret = min_t(ssize_t, ret, pkt.len);
+			if (put_user(ret, &upkts[i].len)) {
+				ret = -EFAULT;
+				break;
+			}
+		}
+	}
+
+	if (cmd == TUNWRITEPKTS && i && i < pkts.count)
+		tun_rx_flush(tun, tfile);
+
+	tun_put(tun);
+	return i ? i : ret;
+}
+
 static long __tun_chr_ioctl(struct file *file, unsigned int cmd,
 			    unsigned long arg, int ifreq_len)
 {
@@ -3101,6 +3197,8 @@ static long __tun_chr_ioctl(struct file *file, unsigned int cmd,
 				TUN_FEATURES, (unsigned int __user*)argp);
 	} else if (cmd == TUNSETQUEUE) {
 		return tun_set_queue(file, &ifr);
+	} else if (cmd == TUNREADPKTS || cmd == TUNWRITEPKTS) {
+		return tun_chr_ioctl_pkts(file, cmd, argp);
 	} else if (cmd == SIOCGSKNS) {
 		if (!ns_capable(net->user_ns, CAP_NET_ADMIN))
 			return -EPERM;
@@ -3419,6 +3517,8 @@ static long tun_chr_compat_ioctl(struct file *file,
 	case TUNSETSNDBUF:
 	case SIOCGIFHWADDR:
 	case SIOCSIFHWADDR:
+	case TUNREADPKTS:
+	case TUNWRITEPKTS:
 		arg = (unsigned long)compat_ptr(arg);
 		break;
 	default:
@@ -38,6 +38,11 @@
 #define VETH_XDP_TX_BULK_SIZE	16
 #define VETH_XDP_BATCH		16
 
+static bool auto_xps;
+module_param(auto_xps, bool, 0644);
+MODULE_PARM_DESC(auto_xps,
+		 "Spread the CPUs over the tx queues, and so the peer's rx queues, on open");
+
 struct veth_stats {
 	u64	rx_drops;
 	/* xdp */
@@ -252,6 +257,32 @@ static void veth_get_channels(struct net_device *dev,
 	channels->max_rx = dev->num_rx_queues;
 }
 
+/* Map each CPU to one tx queue, so that each peer rx ring has few producers */
+static void veth_set_xps(struct net_device *dev)
+{
+#ifdef CONFIG_XPS
+	unsigned int nr = dev->real_num_tx_queues;
+	cpumask_var_t mask;
+	int cpu, i;
+
+	if (!READ_ONCE(auto_xps) || nr < 2)
+		return;
+
+	if (!zalloc_cpumask_var(&mask, GFP_KERNEL))
+		return;
+
+	for (i = 0; i < nr; i++) {
+		cpumask_clear(mask);
+		for_each_possible_cpu(cpu)
+			if (cpu % nr == i)
+				cpumask_set_cpu(cpu, mask);
+		netif_set_xps_queue(dev, mask, i);
+	}
+
+	free_cpumask_var(mask);
+#endif
+}
+
 static int veth_set_channels(struct net_device *dev,
 			     struct ethtool_channels *ch);
 
@@ -343,6 +374,7 @@ static bool veth_skb_is_eligible_for_gro(const struct net_device *dev,
 static netdev_tx_t veth_xmit(struct sk_buff *skb, struct net_device *dev)
 {
 	struct veth_priv *rcv_priv, *priv = netdev_priv(dev);
+	struct netdev_queue *txq;
 	struct veth_rq *rq = NULL;
 	int ret = NETDEV_TX_OK;
 	struct net_device *rcv;
@@ -359,6 +391,7 @@ static netdev_tx_t veth_xmit(struct sk_buff *skb, struct net_device *dev)
 
 	rcv_priv = netdev_priv(rcv);
 	rxq = skb_get_queue_mapping(skb);
+	txq = netdev_get_tx_queue(dev, rxq);
 	if (rxq < rcv->real_num_rx_queues) {
 		rq = &rcv_priv->rq[rxq];
 
@@ -374,14 +407,23 @@ static netdev_tx_t veth_xmit(struct sk_buff *skb, struct net_device *dev)
 	if (likely(veth_forward_skb(rcv, skb, rq, use_napi) == NET_RX_SUCCESS)) {
 		if (!use_napi)
 			dev_sw_netstats_tx_add(dev, 1, length);
-		else
-			__veth_xdp_flush(rq);
 	} else {
 drop:
 		atomic64_inc(&priv->dropped);
 		ret = NET_XMIT_DROP;
 	}
 
+	/*
+	 * Wake up the peer's NAPI once per batch rather than once per skb.
+	 * All skbs of a batch share the txq, and so the rq. The caller ends
+	 * a batch early on a drop or when the txq is stopped or frozen, so
+	 * kick in those cases too.
+	 */
+	if (rq && rcu_access_pointer(rq->napi) &&
+	    (!netdev_xmit_more() || ret != NETDEV_TX_OK ||
+	     netif_xmit_frozen_or_stopped(txq)))
+		__veth_xdp_flush(rq);
+
 	rcu_read_unlock();
 
 	return ret;
@@ -1317,6 +1359,7 @@ static int veth_set_channels(struct net_device *dev,
 		 * to identify the range we have to disable
 		 */
 		veth_disable_range_safe(dev, new_rx_count, old_rx_count);
+		veth_set_xps(dev);
 		netif_carrier_on(dev);
 		if (peer)
 			netif_carrier_on(peer);
@@ -1359,6 +1402,7 @@ static int veth_open(struct net_device *dev)
 		netif_carrier_on(peer);
 	}
 
+	veth_set_xps(dev);
 	veth_set_xdp_features(dev);
 
 	return 0;
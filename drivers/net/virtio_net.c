@@ -105,6 +105,9 @@ struct virtnet_rq_stats {
 	u64_stats_t xdp_redirects;
 	u64_stats_t xdp_drops;
 	u64_stats_t kicks;
+	u64_stats_t refill_bufs;
+	u64_stats_t refill_pages;
+	u64_stats_t refill_oom;
 };
 
 #define VIRTNET_SQ_STAT(m)	offsetof(struct virtnet_sq_stats, m)
@@ -128,6 +131,9 @@ static const struct virtnet_stat_desc virtnet_rq_stats_desc[] = {
 	{ "xdp_redirects",	VIRTNET_RQ_STAT(xdp_redirects) },
 	{ "xdp_drops",		VIRTNET_RQ_STAT(xdp_drops) },
 	{ "kicks",		VIRTNET_RQ_STAT(kicks) },
+	{ "refill_bufs",	VIRTNET_RQ_STAT(refill_bufs) },
+	{ "refill_pages",	VIRTNET_RQ_STAT(refill_pages) },
+	{ "refill_oom",		VIRTNET_RQ_STAT(refill_oom) },
 };
 
 #define VIRTNET_SQ_STATS_LEN	ARRAY_SIZE(virtnet_sq_stats_desc)
@@ -2032,10 +2038,15 @@ static int add_recvbuf_mergeable(struct virtnet_info *vi,
 static bool try_fill_recv(struct virtnet_info *vi, struct receive_queue *rq,
 			  gfp_t gfp)
 {
+	unsigned int bufs = 0, pages = 0;
+	unsigned long flags;
+	bool kick;
 	int err;
 	bool oom;
 
 	do {
+		struct page *frag_page = rq->alloc_frag.page;
+
 		if (vi->mergeable_rx_bufs)
 			err = add_recvbuf_mergeable(vi, rq, gfp);
 		else if (vi->big_packets)
@@ -2043,17 +2054,29 @@ static bool try_fill_recv(struct virtnet_info *vi, struct receive_queue *rq,
 		else
 			err = add_recvbuf_small(vi, rq, gfp);
 
+		/* small and mergeable buffers are carved out of alloc_frag */
+		if (rq->alloc_frag.page != frag_page)
+			pages++;
+
 		oom = err == -ENOMEM;
 		if (err)
 			break;
+		bufs++;
 	} while (rq->vq->num_free);
-	if (virtqueue_kick_prepare(rq->vq) && virtqueue_notify(rq->vq)) {
-		unsigned long flags;
+	kick = virtqueue_kick_prepare(rq->vq) && virtqueue_notify(rq->vq);
 
-		flags = u64_stats_update_begin_irqsave(&rq->stats.syncp);
+	/*
+	 * The refill stats show how many buffers the adaptive buffer size
+	 * packs in a page, and how often the page allocator is hit.
+	 */
+	flags = u64_stats_update_begin_irqsave(&rq->stats.syncp);
+	if (kick)
 		u64_stats_inc(&rq->stats.kicks);
-		u64_stats_update_end_irqrestore(&rq->stats.syncp, flags);
-	}
+	u64_stats_add(&rq->stats.refill_bufs, bufs);
+	u64_stats_add(&rq->stats.refill_pages, pages);
+	if (oom)
+		u64_stats_inc(&rq->stats.refill_oom);
+	u64_stats_update_end_irqrestore(&rq->stats.syncp, flags);
 
 	return !oom;
 }
@@ -253,6 +253,37 @@ static int erofs_fscache_meta_read_folio(struct file *data, struct folio *folio)
 	return ret;
 }
 
+/*
+ * Extend a read of @count bytes at @pos, which lies in the mapped extent
+ * @map, over the following extents as long as they are physically contiguous
+ * on the same blob, so that the whole readahead window is fetched with one
+ * on-demand request rather than one userspace round trip per extent.
+ */
+static size_t erofs_fscache_merge_extents(struct erofs_fscache_rq *req,
+		struct erofs_map_blocks *map, loff_t pos, size_t count)
+{
+	struct inode *inode = req->mapping->host;
+	erofs_off_t lend = map->m_la + map->m_llen;
+	erofs_off_t pend = map->m_pa + map->m_llen;
+	size_t left = req->len - req->submitted;
+
+	while (count < left) {
+		struct erofs_map_blocks next = { .m_la = lend };
+
+		if (erofs_map_blocks(inode, &next) ||
+		    (next.m_flags & (EROFS_MAP_META | EROFS_MAP_MAPPED)) !=
+				EROFS_MAP_MAPPED ||
+		    next.m_deviceid != map->m_deviceid || next.m_pa != pend ||
+		    !next.m_llen || next.m_llen % PAGE_SIZE)
+			break;
+
+		lend += next.m_llen;
+		pend += next.m_llen;
+		count = min_t(size_t, lend - pos, left);
+	}
+	return count;
+}
+
 static int erofs_fscache_data_read_slice(struct erofs_fscache_rq *req)
 {
 	struct address_space *mapping = req->mapping;
@@ -308,6 +339,7 @@ static int erofs_fscache_data_read_slice(struct erofs_fscache_rq *req)
 	}
 
 	count = min_t(size_t, map.m_llen - (pos - map.m_la), count);
+	count = erofs_fscache_merge_extents(req, &map, pos, count);
 	DBG_BUGON(!count || count % PAGE_SIZE);
 
 	mdev = (struct erofs_map_dev) {
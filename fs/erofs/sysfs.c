@@ -57,11 +57,13 @@ static struct erofs_attr erofs_attr_##_name = {			\
 
 #ifdef CONFIG_EROFS_FS_ZIP
 EROFS_ATTR_RW_UI(sync_decompress, erofs_mount_opts);
+EROFS_ATTR_RW_UI(decompress_workers, erofs_mount_opts);
 #endif
 
 static struct attribute *erofs_attrs[] = {
 #ifdef CONFIG_EROFS_FS_ZIP
 	ATTR_LIST(sync_decompress),
+	ATTR_LIST(decompress_workers),
 #endif
 	NULL,
 };
@@ -150,6 +152,9 @@ static ssize_t erofs_attr_store(struct kobject *kobj, struct attribute *attr,
 		if (!strcmp(a->attr.name, "sync_decompress") &&
 		    (t > EROFS_SYNC_DECOMPRESS_FORCE_OFF))
 			return -EINVAL;
+		if (!strcmp(a->attr.name, "decompress_workers") &&
+		    (!t || t > Z_EROFS_MAX_DECOMPRESS_WORKERS))
+			return -EINVAL;
 #endif
 		*(unsigned int *)ptr = t;
 		return len;
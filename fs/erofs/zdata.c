@@ -107,6 +107,7 @@ struct z_erofs_decompressqueue {
 		struct kthread_work kthread_work;
 	} u;
 	bool eio, sync;
+	bool split;		/* a part split off another queue */
 };
 
 static inline bool z_erofs_is_inline_pcluster(struct z_erofs_pcluster *pcl)
@@ -1325,6 +1326,66 @@ static int z_erofs_decompress_pcluster(struct z_erofs_decompress_backend *be,
 	return err;
 }
 
+/* min decompressed bytes per worker to be worth splitting a queue for */
+#define Z_EROFS_SPLIT_MIN_BYTES		(256 * 1024)
+
+static void z_erofs_decompressqueue_work(struct work_struct *work);
+
+/*
+ * Spread the pclusters of a long decompression queue over up to
+ * decompress_workers workers: the chain is cut into segments of about the
+ * same decompressed size, and all segments but the first one are handed to
+ * z_erofs_workqueue.  Each worker has its own page pool, and decompressors
+ * in need of scratch space use the per-CPU buffers of the CPU they run on.
+ */
+static void z_erofs_decompress_split(const struct z_erofs_decompressqueue *io)
+{
+	struct z_erofs_pcluster *cut[Z_EROFS_MAX_DECOMPRESS_WORKERS - 1];
+	struct erofs_sb_info *const sbi = EROFS_SB(io->sb);
+	unsigned int workers = READ_ONCE(sbi->opt.decompress_workers);
+	unsigned long total = 0, size = 0, per;
+	z_erofs_next_pcluster_t owned;
+	struct z_erofs_pcluster *pcl;
+	unsigned int n, nr = 0;
+
+	if (workers <= 1 || io->split)
+		return;
+
+	for (owned = io->head; owned != Z_EROFS_PCLUSTER_TAIL;
+	     owned = READ_ONCE(pcl->next)) {
+		pcl = container_of(owned, struct z_erofs_pcluster, next);
+		total += READ_ONCE(pcl->length);
+	}
+	n = min_t(unsigned long, workers, total / Z_EROFS_SPLIT_MIN_BYTES);
+	if (n < 2)
+		return;
+
+	per = DIV_ROUND_UP(total, n);
+	for (owned = io->head; owned != Z_EROFS_PCLUSTER_TAIL && nr < n - 1;) {
+		pcl = container_of(owned, struct z_erofs_pcluster, next);
+		size += READ_ONCE(pcl->length);
+		owned = READ_ONCE(pcl->next);
+		if (size >= per * (nr + 1) && owned != Z_EROFS_PCLUSTER_TAIL)
+			cut[nr++] = pcl;
+	}
+
+	/* Hand out segments from the tail so that each ends at a cut */
+	while (nr--) {
+		struct z_erofs_decompressqueue *q;
+
+		q = kvzalloc(sizeof(*q), GFP_KERNEL | __GFP_NOWARN);
+		if (!q)
+			return;
+		q->sb = io->sb;
+		q->head = READ_ONCE(cut[nr]->next);
+		q->eio = io->eio;
+		q->split = true;
+		WRITE_ONCE(cut[nr]->next, Z_EROFS_PCLUSTER_TAIL);
+		INIT_WORK(&q->u.work, z_erofs_decompressqueue_work);
+		queue_work(z_erofs_workqueue, &q->u.work);
+	}
+}
+
 static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 				     struct page **pagepool)
 {
@@ -1334,7 +1395,10 @@ static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 		.decompressed_secondary_bvecs =
 			LIST_HEAD_INIT(be.decompressed_secondary_bvecs),
 	};
-	z_erofs_next_pcluster_t owned = io->head;
+	z_erofs_next_pcluster_t owned;
+
+	z_erofs_decompress_split(io);
+	owned = io->head;
 
 	while (owned != Z_EROFS_PCLUSTER_TAIL) {
 		DBG_BUGON(owned == Z_EROFS_PCLUSTER_NIL);
@@ -1536,6 +1600,7 @@ static struct z_erofs_decompressqueue *jobqueue_init(struct super_block *sb,
 	}
 	q->sb = sb;
 	q->head = Z_EROFS_PCLUSTER_TAIL;
+	q->split = false;
 	return q;
 }
 
@@ -1314,6 +1314,12 @@ static int fuse_update_get_attr(struct inode *inode, struct file *file,
 	else
 		sync = time_before64(fi->i_time, get_jiffies_64());
 
+	if (sync && stat && IS_ENABLED(CONFIG_FUSE_PASSTHROUGH) &&
+	    fc->passthrough_getattr && !(request_mask & ~STATX_BASIC_STATS) &&
+	    !(flags & AT_STATX_FORCE_SYNC) &&
+	    !fuse_passthrough_getattr(inode, stat, request_mask))
+		return 0;
+
 	if (sync) {
 		forget_all_cached_acls(inode);
 		/* Try statx if BTIME is requested */
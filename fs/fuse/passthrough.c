@@ -140,6 +140,45 @@ ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
 	return backing_file_mmap(backing_file, vma, &ctx);
 }
 
+/*
+ * Getattr of an inode in passthrough io mode, without a round trip to the
+ * server: the size, blocks and times come from the backing file, which all
+ * io goes to, and the rest from the cached attributes.
+ */
+int fuse_passthrough_getattr(struct inode *inode, struct kstat *stat,
+			     u32 request_mask)
+{
+	struct fuse_inode *fi = get_fuse_inode(inode);
+	const struct cred *old_cred;
+	struct fuse_backing *fb;
+	struct kstat bstat;
+	int err;
+
+	rcu_read_lock();
+	fb = fuse_backing_get(fuse_inode_backing(fi));
+	rcu_read_unlock();
+	if (!fb)
+		return -ENOENT;
+
+	old_cred = override_creds(fb->cred);
+	err = vfs_getattr(&fb->file->f_path, &bstat, STATX_BASIC_STATS,
+			  AT_STATX_SYNC_AS_STAT);
+	revert_creds(old_cred);
+	fuse_backing_put(fb);
+	if (err)
+		return err;
+
+	generic_fillattr(&nop_mnt_idmap, request_mask, inode, stat);
+	stat->mode = fi->orig_i_mode;
+	stat->ino = fi->orig_ino;
+	stat->size = bstat.size;
+	stat->blocks = bstat.blocks;
+	stat->atime = bstat.atime;
+	stat->mtime = bstat.mtime;
+	stat->ctime = bstat.ctime;
+	return 0;
+}
+
 struct fuse_backing *fuse_backing_get(struct fuse_backing *fb)
 {
 	if (fb && refcount_inc_not_zero(&fb->count))
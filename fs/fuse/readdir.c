@@ -327,6 +327,9 @@ static int parse_dirplusfile(char *buf, size_t nbytes, struct file *file,
 	return 0;
 }
 
+/* Largest buffer for a READDIRPLUS request, as a page order */
+#define FUSE_READDIRPLUS_MAX_ORDER	4
+
 static int fuse_readdir_uncached(struct file *file, struct dir_context *ctx)
 {
 	int plus;
@@ -336,22 +339,45 @@ static int fuse_readdir_uncached(struct file *file, struct dir_context *ctx)
 	struct fuse_mount *fm = get_fuse_mount(inode);
 	struct fuse_io_args ia = {};
 	struct fuse_args_pages *ap = &ia.ap;
-	struct fuse_page_desc desc = { .length = PAGE_SIZE };
+	struct page *pages[1 << FUSE_READDIRPLUS_MAX_ORDER];
+	struct fuse_page_desc descs[1 << FUSE_READDIRPLUS_MAX_ORDER];
 	u64 attr_version = 0;
+	unsigned int order = 0, i;
 	bool locked;
 
-	page = alloc_page(GFP_KERNEL);
+	plus = fuse_use_readdirplus(inode, ctx);
+
+	/*
+	 * All the entries of a READDIRPLUS reply are linked into the dcache,
+	 * not only those that fit in @ctx, so a larger buffer saves round
+	 * trips on large directories. The buffer is physically contiguous,
+	 * dirents may cross page boundaries.
+	 */
+	if (plus)
+		order = min_t(unsigned int, FUSE_READDIRPLUS_MAX_ORDER,
+			      ilog2(fm->fc->max_pages));
+	for (;;) {
+		page = alloc_pages(GFP_KERNEL | (order ? __GFP_NOWARN |
+				   __GFP_NORETRY : 0), order);
+		if (page || !order)
+			break;
+		order--;
+	}
 	if (!page)
 		return -ENOMEM;
 
-	plus = fuse_use_readdirplus(inode, ctx);
+	for (i = 0; i < (1U << order); i++) {
+		pages[i] = page + i;
+		descs[i].offset = 0;
+		descs[i].length = PAGE_SIZE;
+	}
 	ap->args.out_pages = true;
-	ap->num_pages = 1;
-	ap->pages = &page;
-	ap->descs = &desc;
+	ap->num_pages = 1U << order;
+	ap->pages = pages;
+	ap->descs = descs;
 	if (plus) {
 		attr_version = fuse_get_attr_version(fm->fc);
-		fuse_read_args_fill(&ia, file, ctx->pos, PAGE_SIZE,
+		fuse_read_args_fill(&ia, file, ctx->pos, PAGE_SIZE << order,
 				    FUSE_READDIRPLUS);
 	} else {
 		fuse_read_args_fill(&ia, file, ctx->pos, PAGE_SIZE,
@@ -375,7 +401,7 @@ static int fuse_readdir_uncached(struct file *file, struct dir_context *ctx)
 		}
 	}
 
-	__free_page(page);
+	__free_pages(page, order);
 	fuse_invalidate_atime(inode);
 	return res;
 }
@@ -152,6 +152,14 @@ do_add_page_to_bio(struct bio *bio, int npg, enum req_op op, sector_t isect,
 	if (end >= map->start + map->len)
 		*len = map->start + map->len - disk_addr;
 
+	/*
+	 * Keep adding to the current bio across extents as long as they are
+	 * contiguous on the same device.
+	 */
+	if (bio && (bio->bi_bdev != map->bdev ||
+		    bio_end_sector(bio) != disk_addr >> SECTOR_SHIFT))
+		bio = bl_submit_bio(bio);
+
 retry:
 	if (!bio) {
 		bio = bio_alloc(map->bdev, bio_max_segs(npg), op, GFP_NOIO);
@@ -259,10 +267,7 @@ bl_read_pagelist(struct nfs_pgio_header *header)
 	/* Code assumes extents are page-aligned */
 	for (i = pg_index; i < header->page_array.npages; i++) {
 		if (extent_length <= 0) {
-			/* We've used up the previous extent */
-			bio = bl_submit_bio(bio);
-
-			/* Get the next one */
+			/* We've used up the previous extent, get the next one */
 			if (!ext_tree_lookup(bl, isect, &be, false)) {
 				header->pnfs_error = -EIO;
 				goto out;
@@ -407,9 +412,7 @@ bl_write_pagelist(struct nfs_pgio_header *header, int sync)
 
 	for (i = pg_index; i < header->page_array.npages; i++) {
 		if (extent_length <= 0) {
-			/* We've used up the previous extent */
-			bio = bl_submit_bio(bio);
-			/* Get the next one */
+			/* We've used up the previous extent, get the next one */
 			if (!ext_tree_lookup(bl, isect, &be, true)) {
 				header->pnfs_error = -EINVAL;
 				goto out;
@@ -36,6 +36,7 @@ enum nfs4_ff_op_type {
 };
 
 static unsigned short io_maxretrans;
+static bool read_mirror_by_latency;
 
 static const struct pnfs_commit_ops ff_layout_commit_ops;
 static void ff_layout_read_record_layoutstats_done(struct rpc_task *task,
@@ -678,10 +679,19 @@ nfs4_ff_layout_stat_io_end_read(struct rpc_task *task,
 		__u64 requested,
 		__u64 completed)
 {
+	ktime_t now = ktime_get();
+	u64 latency = ktime_to_ns(ktime_sub(now, task->tk_start));
+
 	spin_lock(&mirror->lock);
 	nfs4_ff_layout_stat_io_update_completed(&mirror->read_stat,
 			requested, completed,
-			ktime_get(), task->tk_start);
+			now, task->tk_start);
+	/* Moving average of the read latency, with a weight of 1/8 */
+	if (mirror->read_latency)
+		mirror->read_latency += ((s64)latency -
+					 (s64)mirror->read_latency) / 8;
+	else
+		mirror->read_latency = latency ?: 1;
 	set_bit(NFS4_FF_MIRROR_STAT_AVAIL, &mirror->flags);
 	spin_unlock(&mirror->lock);
 }
@@ -738,6 +748,39 @@ ff_layout_mark_ds_reachable(struct pnfs_layout_segment *lseg, u32 idx)
 		nfs4_mark_deviceid_available(devid);
 }
 
+/*
+ * Return the index of the mirror with the lowest expected read latency,
+ * that is the average latency of its reads scaled by the number of reads
+ * in flight on it.  Mirrors with no completed read yet come first so that
+ * they get measured.
+ */
+static u32
+ff_layout_fastest_mirror_for_read(struct pnfs_layout_segment *lseg,
+				  u32 start_idx, bool check_device)
+{
+	struct nfs4_ff_layout_segment *fls = FF_LAYOUT_LSEG(lseg);
+	struct nfs4_ff_layout_mirror *mirror;
+	u64 cost, best_cost = U64_MAX;
+	u32 idx, best = start_idx;
+
+	for (idx = start_idx; idx < fls->mirror_array_cnt; idx++) {
+		mirror = FF_LAYOUT_COMP(lseg, idx);
+		if (check_device && mirror->mirror_ds &&
+		    !IS_ERR(mirror->mirror_ds) &&
+		    nfs4_test_deviceid_unavailable(&mirror->mirror_ds->id_node))
+			continue;
+
+		cost = READ_ONCE(mirror->read_latency) *
+		       (atomic_read(&mirror->read_stat.busy_timer.n_ops) + 1);
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = idx;
+		}
+	}
+
+	return best;
+}
+
 static struct nfs4_pnfs_ds *
 ff_layout_choose_ds_for_read(struct pnfs_layout_segment *lseg,
 			     u32 start_idx, u32 *best_idx,
@@ -748,6 +791,18 @@ ff_layout_choose_ds_for_read(struct pnfs_layout_segment *lseg,
 	struct nfs4_pnfs_ds *ds;
 	u32 idx;
 
+	if (read_mirror_by_latency && fls->mirror_array_cnt > 1) {
+		idx = ff_layout_fastest_mirror_for_read(lseg, start_idx,
+							check_device);
+		mirror = FF_LAYOUT_COMP(lseg, idx);
+		ds = nfs4_ff_layout_prepare_ds(lseg, mirror, false);
+		if (ds && !(check_device &&
+		    nfs4_test_deviceid_unavailable(&mirror->mirror_ds->id_node))) {
+			*best_idx = idx;
+			return ds;
+		}
+	}
+
 	/* mirrors are initially sorted by efficiency */
 	for (idx = start_idx; idx < fls->mirror_array_cnt; idx++) {
 		mirror = FF_LAYOUT_COMP(lseg, idx);
@@ -794,14 +849,24 @@ ff_layout_choose_best_ds_for_read(struct pnfs_layout_segment *lseg,
 
 static struct nfs4_pnfs_ds *
 ff_layout_get_ds_for_read(struct nfs_pageio_descriptor *pgio,
-			  u32 *best_idx)
+			  struct nfs_page *req, u32 *best_idx)
 {
 	struct pnfs_layout_segment *lseg = pgio->pg_lseg;
 	struct nfs4_pnfs_ds *ds;
+	u32 start_idx = pgio->pg_mirror_idx;
 
-	ds = ff_layout_choose_best_ds_for_read(lseg, pgio->pg_mirror_idx,
-					       best_idx);
-	if (ds || !pgio->pg_mirror_idx)
+	/*
+	 * pg_mirror_idx holds the mirror picked for the previous request,
+	 * or the mirror after the failed one when resending.  Only stick
+	 * to it for resends when picking by latency, so that the choice
+	 * can come back to a faster mirror.
+	 */
+	if (read_mirror_by_latency &&
+	    !test_bit(PG_MIRROR_RESEND, &req->wb_flags))
+		start_idx = 0;
+
+	ds = ff_layout_choose_best_ds_for_read(lseg, start_idx, best_idx);
+	if (ds || !start_idx)
 		return ds;
 	return ff_layout_choose_best_ds_for_read(lseg, 0, best_idx);
 }
@@ -853,7 +918,7 @@ ff_layout_pg_init_read(struct nfs_pageio_descriptor *pgio,
 			goto out_nolseg;
 	}
 
-	ds = ff_layout_get_ds_for_read(pgio, &ds_idx);
+	ds = ff_layout_get_ds_for_read(pgio, req, &ds_idx);
 	if (!ds) {
 		if (!ff_layout_no_fallback_to_mds(pgio->pg_lseg))
 			goto out_mds;
@@ -1047,12 +1112,16 @@ static void ff_layout_reset_write(struct nfs_pgio_header *hdr, bool retry_pnfs)
 static void ff_layout_resend_pnfs_read(struct nfs_pgio_header *hdr)
 {
 	u32 idx = hdr->pgio_mirror_idx + 1;
+	struct nfs_page *req;
 	u32 new_idx = 0;
 
 	if (ff_layout_choose_any_ds_for_read(hdr->lseg, idx, &new_idx))
 		ff_layout_send_layouterror(hdr->lseg);
 	else
 		pnfs_error_mark_layout_for_return(hdr->inode, hdr->lseg);
+	/* Have ff_layout_get_ds_for_read() start at new_idx */
+	list_for_each_entry(req, &hdr->pages, wb_list)
+		set_bit(PG_MIRROR_RESEND, &req->wb_flags);
 	pnfs_read_resend_pnfs(hdr, new_idx);
 }
 
@@ -2621,3 +2690,7 @@ module_exit(nfs4flexfilelayout_exit);
 module_param(io_maxretrans, ushort, 0644);
 MODULE_PARM_DESC(io_maxretrans, "The  number of times the NFSv4.1 client "
 			"retries an I/O request before returning an error. ");
+module_param(read_mirror_by_latency, bool, 0644);
+MODULE_PARM_DESC(read_mirror_by_latency, "Read from the mirror with the "
+			"lowest measured latency and load rather than from "
+			"the first available mirror.");
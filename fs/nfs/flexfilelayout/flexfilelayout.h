@@ -88,6 +88,7 @@ struct nfs4_ff_layout_mirror {
 	unsigned long			flags;
 	struct nfs4_ff_layoutstat	read_stat;
 	struct nfs4_ff_layoutstat	write_stat;
+	u64				read_latency;	/* EWMA, in ns */
 	ktime_t				start_time;
 	u32				report_interval;
 };
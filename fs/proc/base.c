@@ -487,6 +487,25 @@ static int proc_pid_schedstat(struct seq_file *m, struct pid_namespace *ns,
 
 	return 0;
 }
+
+#ifdef CONFIG_SCHED_LATENCY_HIST
+/*
+ * Provides /proc/PID/schedstat_hist: one "<upper bound ns> <count>" line per
+ * run delay bucket.
+ */
+static int proc_pid_schedstat_hist(struct seq_file *m, struct pid_namespace *ns,
+				   struct pid *pid, struct task_struct *task)
+{
+	int i;
+
+	for (i = 0; i < SCHED_LAT_HIST_BUCKETS - 1; i++)
+		seq_printf(m, "%llu %u\n", 1024ULL << i,
+			   READ_ONCE(task->sched_info.lat_hist[i]));
+	seq_printf(m, "inf %u\n", READ_ONCE(task->sched_info.lat_hist[i]));
+
+	return 0;
+}
+#endif
 #endif
 
 #ifdef CONFIG_LATENCYTOP
@@ -3303,6 +3322,9 @@ static const struct pid_entry tgid_base_stuff[] = {
 #endif
 #ifdef CONFIG_SCHED_INFO
 	ONE("schedstat",  S_IRUGO, proc_pid_schedstat),
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	ONE("schedstat_hist", 0444, proc_pid_schedstat_hist),
+#endif
 #endif
 #ifdef CONFIG_LATENCYTOP
 	REG("latency",  S_IRUGO, proc_lstats_operations),
@@ -3652,6 +3674,9 @@ static const struct pid_entry tid_base_stuff[] = {
 #endif
 #ifdef CONFIG_SCHED_INFO
 	ONE("schedstat", S_IRUGO, proc_pid_schedstat),
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	ONE("schedstat_hist", 0444, proc_pid_schedstat_hist),
+#endif
 #endif
 #ifdef CONFIG_LATENCYTOP
 	REG("latency",  S_IRUGO, proc_lstats_operations),
@@ -105,9 +105,34 @@ static const struct seq_operations consoles_op = {
 	.show	= show_console_dev
 };
 
+/*
+ * This is handler for /proc/console_stats: the number of records each
+ * console still has to print and the number of records it has lost because
+ * they were overwritten in the ringbuffer before it could print them.
+ */
+static int show_console_stats(struct seq_file *m, void *v)
+{
+	struct console *con = v;
+
+	seq_setwidth(m, 21 - 1);
+	seq_printf(m, "%s%d", con->name, con->index);
+	seq_pad(m, ' ');
+	seq_printf(m, "backlog %llu dropped %lu\n", console_backlog(con),
+		   data_race(READ_ONCE(con->dropped_total)));
+	return 0;
+}
+
+static const struct seq_operations console_stats_op = {
+	.start	= c_start,
+	.next	= c_next,
+	.stop	= c_stop,
+	.show	= show_console_stats
+};
+
 static int __init proc_consoles_init(void)
 {
 	proc_create_seq("consoles", 0, NULL, &consoles_op);
+	proc_create_seq("console_stats", 0, NULL, &console_stats_op);
 	return 0;
 }
 fs_initcall(proc_consoles_init);
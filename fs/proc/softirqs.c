@@ -26,12 +26,39 @@ static int show_softirqs(struct seq_file *p, void *v)
 	return 0;
 }
 
+#ifdef CONFIG_SOFTIRQ_VEC_BUDGET
+/*
+ * /proc/softirq_time  ... display the time spent in softirqs, in nanoseconds
+ */
+static int show_softirq_time(struct seq_file *p, void *v)
+{
+	int i, j;
+
+	seq_puts(p, "                    ");
+	for_each_possible_cpu(i)
+		seq_printf(p, "CPU%-16d", i);
+	seq_putc(p, '\n');
+
+	for (i = 0; i < NR_SOFTIRQS; i++) {
+		seq_printf(p, "%12s:", softirq_to_name[i]);
+		for_each_possible_cpu(j)
+			seq_printf(p, " %18llu", kstat_softirq_time_cpu(i, j));
+		seq_putc(p, '\n');
+	}
+	return 0;
+}
+#endif
+
 static int __init proc_softirqs_init(void)
 {
 	struct proc_dir_entry *pde;
 
 	pde = proc_create_single("softirqs", 0, NULL, show_softirqs);
 	pde_make_permanent(pde);
+#ifdef CONFIG_SOFTIRQ_VEC_BUDGET
+	pde = proc_create_single("softirq_time", 0, NULL, show_softirq_time);
+	pde_make_permanent(pde);
+#endif
 	return 0;
 }
 fs_initcall(proc_softirqs_init);
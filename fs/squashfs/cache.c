@@ -39,12 +39,115 @@
 #include <linux/spinlock.h>
 #include <linux/wait.h>
 #include <linux/pagemap.h>
+#include <linux/shrinker.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
 #include "squashfs.h"
 #include "page_actor.h"
 
+static void **squashfs_cache_alloc_data(struct squashfs_cache *cache,
+	struct squashfs_page_actor **actor, gfp_t gfp)
+{
+	void **data;
+	int j;
+
+	data = kcalloc(cache->pages, sizeof(void *), gfp);
+	if (data == NULL)
+		return NULL;
+
+	for (j = 0; j < cache->pages; j++) {
+		data[j] = kmalloc(PAGE_SIZE, gfp);
+		if (data[j] == NULL)
+			goto failed;
+	}
+
+	*actor = squashfs_page_actor_init(data, cache->pages, 0);
+	if (*actor == NULL)
+		goto failed;
+
+	return data;
+
+failed:
+	for (j = 0; j < cache->pages; j++)
+		kfree(data[j]);
+	kfree(data);
+	return NULL;
+}
+
+
+static void squashfs_cache_free_data(struct squashfs_cache *cache,
+	void **data, struct squashfs_page_actor *actor)
+{
+	int j;
+
+	if (data) {
+		for (j = 0; j < cache->pages; j++)
+			kfree(data[j]);
+		kfree(data);
+	}
+	kfree(actor);
+}
+
+
+/*
+ * Try to add a cache entry, up to cache->max_entries.  Called without the
+ * cache lock held, returns true if an entry was added.
+ */
+static bool squashfs_cache_grow(struct squashfs_cache *cache)
+{
+	struct squashfs_page_actor *actor;
+	void **data;
+	int i;
+
+	data = squashfs_cache_alloc_data(cache, &actor,
+			GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN);
+	if (data == NULL)
+		return false;
+
+	spin_lock(&cache->lock);
+	for (i = 0; i < cache->max_entries; i++) {
+		struct squashfs_cache_entry *entry = &cache->entry[i];
+
+		if (entry->data == NULL) {
+			entry->data = data;
+			entry->actor = actor;
+			entry->block = SQUASHFS_INVALID_BLK;
+			entry->last_used = 0;
+			cache->entries++;
+			cache->unused++;
+			spin_unlock(&cache->lock);
+			return true;
+		}
+	}
+	spin_unlock(&cache->lock);
+
+	squashfs_cache_free_data(cache, data, actor);
+	return false;
+}
+
+
+/*
+ * Return the least recently used unused cache entry, or -1 if all cache
+ * entries are in use.
+ */
+static int squashfs_cache_lru(struct squashfs_cache *cache)
+{
+	int i, lru = -1;
+
+	for (i = 0; i < cache->max_entries; i++) {
+		struct squashfs_cache_entry *entry = &cache->entry[i];
+
+		if (entry->data == NULL || entry->refcount)
+			continue;
+		if (lru < 0 || entry->last_used < cache->entry[lru].last_used)
+			lru = i;
+	}
+
+	return lru;
+}
+
+
 /*
  * Look-up block in cache, and increment usage count.  If not in cache, read
  * and decompress it from disk.
@@ -53,46 +156,50 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 	struct squashfs_cache *cache, u64 block, int length)
 {
 	int i, n;
+	bool grow = true;
 	struct squashfs_cache_entry *entry;
 
 	spin_lock(&cache->lock);
 
 	while (1) {
-		for (i = cache->curr_blk, n = 0; n < cache->entries; n++) {
+		for (i = cache->curr_blk, n = 0; n < cache->max_entries; n++) {
 			if (cache->entry[i].block == block) {
 				cache->curr_blk = i;
 				break;
 			}
-			i = (i + 1) % cache->entries;
+			i = (i + 1) % cache->max_entries;
 		}
 
-		if (n == cache->entries) {
+		if (n == cache->max_entries) {
+			i = squashfs_cache_lru(cache);
+
 			/*
-			 * Block not in cache, if all cache entries are used
-			 * go to sleep waiting for one to become available.
+			 * Block not in cache.  Rather than evicting a cached
+			 * block, or waiting for an entry to become available,
+			 * grow the cache if it is allowed to.
 			 */
-			if (cache->unused == 0) {
-				cache->num_waiters++;
+			if (grow && cache->entries < cache->max_entries &&
+			    (i < 0 ||
+			     cache->entry[i].block != SQUASHFS_INVALID_BLK)) {
 				spin_unlock(&cache->lock);
-				wait_event(cache->wait_queue, cache->unused);
+				grow = squashfs_cache_grow(cache);
 				spin_lock(&cache->lock);
-				cache->num_waiters--;
 				continue;
 			}
 
 			/*
-			 * At least one unused cache entry.  A simple
-			 * round-robin strategy is used to choose the entry to
-			 * be evicted from the cache.
+			 * If all cache entries are used go to sleep waiting
+			 * for one to become available.
 			 */
-			i = cache->next_blk;
-			for (n = 0; n < cache->entries; n++) {
-				if (cache->entry[i].refcount == 0)
-					break;
-				i = (i + 1) % cache->entries;
+			if (i < 0) {
+				cache->num_waiters++;
+				spin_unlock(&cache->lock);
+				wait_event(cache->wait_queue, cache->unused);
+				spin_lock(&cache->lock);
+				cache->num_waiters--;
+				continue;
 			}
 
-			cache->next_blk = (i + 1) % cache->entries;
 			entry = &cache->entry[i];
 
 			/*
@@ -105,6 +212,7 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 			entry->pending = 1;
 			entry->num_waiters = 0;
 			entry->error = 0;
+			entry->last_used = ++cache->clock;
 			spin_unlock(&cache->lock);
 
 			entry->length = squashfs_read_data(sb, block, length,
@@ -141,6 +249,7 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 		if (entry->refcount == 0)
 			cache->unused--;
 		entry->refcount++;
+		entry->last_used = ++cache->clock;
 
 		/*
 		 * If the entry is currently being filled in by another process
@@ -191,24 +300,71 @@ void squashfs_cache_put(struct squashfs_cache_entry *entry)
 	spin_unlock(&cache->lock);
 }
 
+
+/*
+ * Entries added beyond the initial size of the cache can be reclaimed
+ * when they are unused, least recently used first.
+ */
+static unsigned long squashfs_cache_count(struct shrinker *shrink,
+	struct shrink_control *sc)
+{
+	struct squashfs_cache *cache = shrink->private_data;
+	unsigned long count;
+
+	spin_lock(&cache->lock);
+	count = min(cache->unused, cache->entries - cache->min_entries);
+	spin_unlock(&cache->lock);
+
+	return count ?: SHRINK_EMPTY;
+}
+
+
+static unsigned long squashfs_cache_scan(struct shrinker *shrink,
+	struct shrink_control *sc)
+{
+	struct squashfs_cache *cache = shrink->private_data;
+	unsigned long freed = 0;
+	int i;
+
+	spin_lock(&cache->lock);
+	while (freed < sc->nr_to_scan &&
+			cache->entries > cache->min_entries) {
+		struct squashfs_cache_entry *entry;
+
+		i = squashfs_cache_lru(cache);
+		if (i < 0)
+			break;
+
+		entry = &cache->entry[i];
+		squashfs_cache_free_data(cache, entry->data, entry->actor);
+		entry->data = NULL;
+		entry->actor = NULL;
+		entry->block = SQUASHFS_INVALID_BLK;
+		cache->entries--;
+		cache->unused--;
+		freed++;
+	}
+	spin_unlock(&cache->lock);
+
+	return freed ?: SHRINK_STOP;
+}
+
+
 /*
  * Delete cache reclaiming all kmalloced buffers.
  */
 void squashfs_cache_delete(struct squashfs_cache *cache)
 {
-	int i, j;
+	int i;
 
 	if (cache == NULL)
 		return;
 
-	for (i = 0; i < cache->entries; i++) {
-		if (cache->entry[i].data) {
-			for (j = 0; j < cache->pages; j++)
-				kfree(cache->entry[i].data[j]);
-			kfree(cache->entry[i].data);
-		}
-		kfree(cache->entry[i].actor);
-	}
+	shrinker_free(cache->shrinker);
+
+	for (i = 0; i < cache->max_entries; i++)
+		squashfs_cache_free_data(cache, cache->entry[i].data,
+						cache->entry[i].actor);
 
 	kfree(cache->entry);
 	kfree(cache);
@@ -219,11 +375,14 @@ void squashfs_cache_delete(struct squashfs_cache *cache)
  * Initialise cache allocating the specified number of entries, each of
  * size block_size.  To avoid vmalloc fragmentation issues each entry
  * is allocated as a sequence of kmalloced PAGE_SIZE buffers.
+ *
+ * If max_entries is larger than entries, the cache grows on demand up to
+ * max_entries, and shrinks back down to entries under memory pressure.
  */
 struct squashfs_cache *squashfs_cache_init(char *name, int entries,
-	int block_size)
+	int max_entries, int block_size)
 {
-	int i, j;
+	int i;
 	struct squashfs_cache *cache = kzalloc(sizeof(*cache), GFP_KERNEL);
 
 	if (cache == NULL) {
@@ -231,16 +390,19 @@ struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 		return NULL;
 	}
 
-	cache->entry = kcalloc(entries, sizeof(*(cache->entry)), GFP_KERNEL);
+	max_entries = max(entries, max_entries);
+	cache->entry = kcalloc(max_entries, sizeof(*(cache->entry)),
+								GFP_KERNEL);
 	if (cache->entry == NULL) {
 		ERROR("Failed to allocate %s cache\n", name);
 		goto cleanup;
 	}
 
 	cache->curr_blk = 0;
-	cache->next_blk = 0;
 	cache->unused = entries;
 	cache->entries = entries;
+	cache->min_entries = entries;
+	cache->max_entries = max_entries;
 	cache->block_size = block_size;
 	cache->pages = block_size >> PAGE_SHIFT;
 	cache->pages = cache->pages ? cache->pages : 1;
@@ -249,32 +411,33 @@ struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 	spin_lock_init(&cache->lock);
 	init_waitqueue_head(&cache->wait_queue);
 
-	for (i = 0; i < entries; i++) {
+	for (i = 0; i < max_entries; i++) {
 		struct squashfs_cache_entry *entry = &cache->entry[i];
 
 		init_waitqueue_head(&cache->entry[i].wait_queue);
 		entry->cache = cache;
 		entry->block = SQUASHFS_INVALID_BLK;
-		entry->data = kcalloc(cache->pages, sizeof(void *), GFP_KERNEL);
+		if (i >= entries)
+			continue;
+
+		entry->data = squashfs_cache_alloc_data(cache, &entry->actor,
+								GFP_KERNEL);
 		if (entry->data == NULL) {
 			ERROR("Failed to allocate %s cache entry\n", name);
 			goto cleanup;
 		}
+	}
 
-		for (j = 0; j < cache->pages; j++) {
-			entry->data[j] = kmalloc(PAGE_SIZE, GFP_KERNEL);
-			if (entry->data[j] == NULL) {
-				ERROR("Failed to allocate %s buffer\n", name);
-				goto cleanup;
-			}
-		}
-
-		entry->actor = squashfs_page_actor_init(entry->data,
-						cache->pages, 0);
-		if (entry->actor == NULL) {
-			ERROR("Failed to allocate %s cache entry\n", name);
+	if (max_entries > entries) {
+		cache->shrinker = shrinker_alloc(0, "squashfs-%s", name);
+		if (cache->shrinker == NULL) {
+			ERROR("Failed to allocate %s cache shrinker\n", name);
 			goto cleanup;
 		}
+		cache->shrinker->count_objects = squashfs_cache_count;
+		cache->shrinker->scan_objects = squashfs_cache_scan;
+		cache->shrinker->private_data = cache;
+		shrinker_register(cache->shrinker);
 	}
 
 	return cache;
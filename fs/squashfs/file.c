@@ -34,6 +34,7 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -533,6 +534,100 @@ static int squashfs_readahead_fragment(struct page **page,
 	return error;
 }
 
+/*
+ * Full blocks of a readahead window are read in batches of up to
+ * SQUASHFS_RA_BATCH blocks, decompressed in parallel by the readahead
+ * context and unbound workers, when the decompressor has more than one
+ * stream (the "multi" and "percpu" decompressors, or threads=).
+ */
+#define SQUASHFS_RA_BATCH	8
+
+struct squashfs_ra_block {
+	struct work_struct	work;
+	struct inode		*inode;
+	struct page		**pages;
+	unsigned int		nr_pages;
+	unsigned int		expected;
+	bool			last;
+	u64			block;
+	int			bsize;
+	atomic_t		*pending;
+	struct completion	*done;
+};
+
+static void squashfs_readahead_block(struct squashfs_ra_block *b)
+{
+	struct squashfs_sb_info *msblk = b->inode->i_sb->s_fs_info;
+	struct squashfs_page_actor *actor;
+	struct page *last_page = NULL;
+	int i, res = -ENOMEM;
+
+	actor = squashfs_page_actor_init_special(msblk, b->pages, b->nr_pages,
+						 b->expected);
+	if (actor) {
+		res = squashfs_read_data(b->inode->i_sb, b->block, b->bsize,
+					 NULL, actor);
+		last_page = squashfs_page_actor_free(actor);
+	}
+
+	if (res == b->expected) {
+		int bytes;
+
+		/* Last page (if present) may have trailing bytes not filled */
+		bytes = res % PAGE_SIZE;
+		if (b->last && bytes && last_page)
+			memzero_page(last_page, bytes, PAGE_SIZE - bytes);
+
+		for (i = 0; i < b->nr_pages; i++) {
+			flush_dcache_page(b->pages[i]);
+			SetPageUptodate(b->pages[i]);
+		}
+	}
+
+	for (i = 0; i < b->nr_pages; i++) {
+		unlock_page(b->pages[i]);
+		put_page(b->pages[i]);
+	}
+}
+
+static void squashfs_readahead_work(struct work_struct *work)
+{
+	struct squashfs_ra_block *b = container_of(work,
+					struct squashfs_ra_block, work);
+
+	squashfs_readahead_block(b);
+	if (atomic_dec_and_test(b->pending))
+		complete(b->done);
+}
+
+/*
+ * Read the @nr blocks batched up in @blocks, the first one in the calling
+ * context and the others in workers, and wait for all of them.
+ */
+static void squashfs_readahead_batch(struct squashfs_ra_block *blocks,
+				     unsigned int nr)
+{
+	DECLARE_COMPLETION_ONSTACK(done);
+	atomic_t pending;
+	unsigned int i;
+
+	if (!nr)
+		return;
+
+	atomic_set(&pending, nr - 1);
+	for (i = 1; i < nr; i++) {
+		blocks[i].pending = &pending;
+		blocks[i].done = &done;
+		INIT_WORK(&blocks[i].work, squashfs_readahead_work);
+		queue_work(system_unbound_wq, &blocks[i].work);
+	}
+
+	squashfs_readahead_block(&blocks[0]);
+
+	if (nr > 1)
+		wait_for_completion(&done);
+}
+
 static void squashfs_readahead(struct readahead_control *ractl)
 {
 	struct inode *inode = ractl->mapping->host;
@@ -541,25 +636,37 @@ static void squashfs_readahead(struct readahead_control *ractl)
 	unsigned short shift = msblk->block_log - PAGE_SHIFT;
 	loff_t start = readahead_pos(ractl) & ~mask;
 	size_t len = readahead_length(ractl) + readahead_pos(ractl) - start;
-	struct squashfs_page_actor *actor;
-	unsigned int nr_pages = 0;
-	struct page **pages;
+	struct squashfs_ra_block *blocks;
+	unsigned int nr_pages = 0, nr_blocks = 0, batch;
+	struct page **pages, **block_pages;
 	int i;
 	loff_t file_end = i_size_read(inode) >> msblk->block_log;
 	unsigned int max_pages = 1UL << shift;
+	unsigned int pages_per_block = max_pages;
 
 	readahead_expand(ractl, start, (len | mask) + 1);
 
-	pages = kmalloc_array(max_pages, sizeof(void *), GFP_KERNEL);
+	batch = min_t(unsigned int, readahead_length(ractl) >> msblk->block_log,
+		      min(msblk->max_thread_num, SQUASHFS_RA_BATCH));
+	batch = max(batch, 1U);
+
+	pages = kmalloc_array(pages_per_block * batch, sizeof(void *),
+			      GFP_KERNEL);
 	if (!pages)
 		return;
 
+	blocks = kcalloc(batch, sizeof(*blocks), GFP_KERNEL);
+	if (!blocks) {
+		kfree(pages);
+		return;
+	}
+
 	for (;;) {
+		struct squashfs_ra_block *b;
 		pgoff_t index;
 		int res, bsize;
 		u64 block = 0;
 		unsigned int expected;
-		struct page *last_page;
 
 		expected = start >> msblk->block_log == file_end ?
 			   (i_size_read(inode) & (msblk->block_size - 1)) :
@@ -567,21 +674,22 @@ static void squashfs_readahead(struct readahead_control *ractl)
 
 		max_pages = (expected + PAGE_SIZE - 1) >> PAGE_SHIFT;
 
-		nr_pages = __readahead_batch(ractl, pages, max_pages);
+		block_pages = pages + nr_blocks * pages_per_block;
+		nr_pages = __readahead_batch(ractl, block_pages, max_pages);
 		if (!nr_pages)
 			break;
 
 		if (readahead_pos(ractl) >= i_size_read(inode))
 			goto skip_pages;
 
-		index = pages[0]->index >> shift;
+		index = block_pages[0]->index >> shift;
 
-		if ((pages[nr_pages - 1]->index >> shift) != index)
+		if ((block_pages[nr_pages - 1]->index >> shift) != index)
 			goto skip_pages;
 
 		if (index == file_end && squashfs_i(inode)->fragment_block !=
 						SQUASHFS_INVALID_BLK) {
-			res = squashfs_readahead_fragment(pages, nr_pages,
+			res = squashfs_readahead_fragment(block_pages, nr_pages,
 							  expected);
 			if (res)
 				goto skip_pages;
@@ -592,44 +700,33 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		if (bsize == 0)
 			goto skip_pages;
 
-		actor = squashfs_page_actor_init_special(msblk, pages, nr_pages,
-							 expected);
-		if (!actor)
-			goto skip_pages;
-
-		res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
-
-		last_page = squashfs_page_actor_free(actor);
-
-		if (res == expected) {
-			int bytes;
-
-			/* Last page (if present) may have trailing bytes not filled */
-			bytes = res % PAGE_SIZE;
-			if (index == file_end && bytes && last_page)
-				memzero_page(last_page, bytes,
-					     PAGE_SIZE - bytes);
-
-			for (i = 0; i < nr_pages; i++) {
-				flush_dcache_page(pages[i]);
-				SetPageUptodate(pages[i]);
-			}
-		}
-
-		for (i = 0; i < nr_pages; i++) {
-			unlock_page(pages[i]);
-			put_page(pages[i]);
+		b = &blocks[nr_blocks++];
+		b->inode = inode;
+		b->pages = block_pages;
+		b->nr_pages = nr_pages;
+		b->expected = expected;
+		b->last = index == file_end;
+		b->block = block;
+		b->bsize = bsize;
+
+		if (nr_blocks == batch) {
+			squashfs_readahead_batch(blocks, nr_blocks);
+			nr_blocks = 0;
 		}
 	}
 
+	squashfs_readahead_batch(blocks, nr_blocks);
+	kfree(blocks);
 	kfree(pages);
 	return;
 
 skip_pages:
+	squashfs_readahead_batch(blocks, nr_blocks);
 	for (i = 0; i < nr_pages; i++) {
-		unlock_page(pages[i]);
-		put_page(pages[i]);
+		unlock_page(block_pages[i]);
+		put_page(block_pages[i]);
 	}
+	kfree(blocks);
 	kfree(pages);
 }
 
@@ -15,15 +15,18 @@
 struct squashfs_cache {
 	char			*name;
 	int			entries;
+	int			min_entries;
+	int			max_entries;
 	int			curr_blk;
-	int			next_blk;
 	int			num_waiters;
 	int			unused;
 	int			block_size;
 	int			pages;
+	unsigned long		clock;	/* for least recently used eviction */
 	spinlock_t		lock;
 	wait_queue_head_t	wait_queue;
 	struct squashfs_cache_entry *entry;
+	struct shrinker		*shrinker;
 };
 
 struct squashfs_cache_entry {
@@ -34,6 +37,7 @@ struct squashfs_cache_entry {
 	int			pending;
 	int			error;
 	int			num_waiters;
+	unsigned long		last_used;
 	wait_queue_head_t	wait_queue;
 	struct squashfs_cache	*cache;
 	void			**data;
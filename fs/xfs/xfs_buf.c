@@ -1429,7 +1429,9 @@ xfs_buf_ioend_async(
 	struct xfs_buf	*bp)
 {
 	INIT_WORK(&bp->b_ioend_work, xfs_buf_ioend_work);
-	queue_work(bp->b_mount->m_buf_workqueue, &bp->b_ioend_work);
+	/* Run completion where the buffer was last touched */
+	queue_work_hinted(bp->b_mount->m_buf_workqueue, &bp->b_ioend_work,
+			  bp->b_io_cpu);
 }
 
 void
@@ -1743,6 +1745,7 @@ __xfs_buf_submit(
 
 	/* clear the internal error state to avoid spurious errors */
 	bp->b_io_error = 0;
+	bp->b_io_cpu = raw_smp_processor_id();
 
 	/*
 	 * Set the count to 1 initially, this will stop an I/O completion
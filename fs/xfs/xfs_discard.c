@@ -73,6 +73,28 @@
 
 struct workqueue_struct *xfs_discard_wq;
 
+static int
+xfs_discard_extent(
+	struct xfs_mount	*mp,
+	xfs_agnumber_t		agno,
+	xfs_agblock_t		bno,
+	xfs_extlen_t		len,
+	struct bio		**biop)
+{
+	int			error;
+
+	error = __blkdev_issue_discard(mp->m_ddev_targp->bt_bdev,
+			XFS_AGB_TO_DADDR(mp, agno, bno),
+			XFS_FSB_TO_BB(mp, len), GFP_KERNEL, biop);
+	if (error == -EOPNOTSUPP)
+		return 0;
+	if (error)
+		xfs_info(mp,
+	 "discard failed for extent [0x%llx,%u], error %d",
+			 (unsigned long long)bno, len, error);
+	return error;
+}
+
 static void
 xfs_discard_endio_work(
 	struct work_struct	*work)
@@ -103,6 +125,12 @@ xfs_discard_endio(
  * Walk the discard list and issue discards on all the busy extents in the
  * list. We plug and chain the bios so that we only need a single completion
  * call to clear all the busy extents once the discards are complete.
+ *
+ * The list is sorted by the CIL before it gets here, and a checkpoint that
+ * freed a large file typically holds many busy extents that abut each other.
+ * Merge runs of contiguous extents in the same AG into a single discard so
+ * that the device sees a few large discards rather than a storm of small
+ * ones, which many SSDs handle far better.
  */
 int
 xfs_discard_extents(
@@ -112,6 +140,9 @@ xfs_discard_extents(
 	struct xfs_extent_busy	*busyp;
 	struct bio		*bio = NULL;
 	struct blk_plug		plug;
+	xfs_agnumber_t		agno = NULLAGNUMBER;
+	xfs_agblock_t		bno = 0;
+	xfs_extlen_t		len = 0;
 	int			error = 0;
 
 	blk_start_plug(&plug);
@@ -119,19 +150,23 @@ xfs_discard_extents(
 		trace_xfs_discard_extent(mp, busyp->agno, busyp->bno,
 					 busyp->length);
 
-		error = __blkdev_issue_discard(mp->m_ddev_targp->bt_bdev,
-				XFS_AGB_TO_DADDR(mp, busyp->agno, busyp->bno),
-				XFS_FSB_TO_BB(mp, busyp->length),
-				GFP_KERNEL, &bio);
-		if (error && error != -EOPNOTSUPP) {
-			xfs_info(mp,
-	 "discard failed for extent [0x%llx,%u], error %d",
-				 (unsigned long long)busyp->bno,
-				 busyp->length,
-				 error);
-			break;
+		if (busyp->agno == agno && busyp->bno == bno + len &&
+		    len + busyp->length > len) {
+			len += busyp->length;
+			continue;
+		}
+
+		if (len) {
+			error = xfs_discard_extent(mp, agno, bno, len, &bio);
+			if (error)
+				break;
 		}
+		agno = busyp->agno;
+		bno = busyp->bno;
+		len = busyp->length;
 	}
+	if (!error && len)
+		error = xfs_discard_extent(mp, agno, bno, len, &bio);
 
 	if (bio) {
 		bio->bi_private = extents;
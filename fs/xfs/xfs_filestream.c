@@ -332,6 +332,28 @@ xfs_filestream_create_association(
 	return 0;
 }
 
+/*
+ * Parallel writers appending to large files in the same directory share the
+ * directory's AG, so they contend on its AGF and interleave their extents.
+ * Regular files that have grown to at least filestream_inode_mb megabytes are
+ * therefore given a stream of their own, keyed by their own inode number, so
+ * that each of them gets an AG to itself for as long as it keeps being
+ * written.  Small files keep sharing their directory's stream.
+ */
+static bool
+xfs_filestream_own_stream(
+	struct xfs_bmalloca	*ap)
+{
+	struct xfs_inode	*ip = ap->ip;
+	xfs_fsize_t		minsize = (xfs_fsize_t)xfs_fstrm_inode_mb << 20;
+
+	if (!minsize || !S_ISREG(VFS_I(ip)->i_mode))
+		return false;
+
+	return max_t(xfs_fsize_t, ip->i_disk_size,
+		     XFS_FSB_TO_B(ip->i_mount, ap->offset)) >= minsize;
+}
+
 /*
  * Search for an allocation group with a single extent large enough for
  * the request. First we look for an existing association and use that if it
@@ -354,12 +376,18 @@ xfs_filestream_select_ag(
 
 	*longest = 0;
 	args->total = ap->total;
-	pip = xfs_filestream_get_parent(ap->ip);
-	if (pip) {
-		ino = pip->i_ino;
+	if (xfs_filestream_own_stream(ap)) {
+		ino = ap->ip->i_ino;
+	} else {
+		pip = xfs_filestream_get_parent(ap->ip);
+		if (pip) {
+			ino = pip->i_ino;
+			xfs_irele(pip);
+		}
+	}
+	if (ino) {
 		error = xfs_filestream_lookup_association(ap, args, ino,
 				longest);
-		xfs_irele(pip);
 		if (error)
 			return error;
 		if (*longest >= args->maxlen)
@@ -1845,6 +1845,58 @@ xfs_inodegc_inactivate(
 
 }
 
+static struct llist_node *
+xfs_inodegc_merge(
+	struct llist_node	*a,
+	struct llist_node	*b)
+{
+	struct llist_node	*head = NULL, **tail = &head;
+
+	while (a && b) {
+		struct xfs_inode	*ipa = llist_entry(a, struct xfs_inode,
+							   i_gclist);
+		struct xfs_inode	*ipb = llist_entry(b, struct xfs_inode,
+							   i_gclist);
+
+		if (ipa->i_ino <= ipb->i_ino) {
+			*tail = a;
+			a = a->next;
+		} else {
+			*tail = b;
+			b = b->next;
+		}
+		tail = &(*tail)->next;
+	}
+	*tail = a ? a : b;
+	return head;
+}
+
+/*
+ * Sort the inodes to inactivate by inode number, i.e. by AG and then by
+ * location in the AG, so that consecutive inactivations work on the same AGI,
+ * AGF and inode cluster buffers while they are still hot in the buffer cache
+ * instead of bouncing between AGs in unlink order.
+ */
+static struct llist_node *
+xfs_inodegc_sort(
+	struct llist_node	*node)
+{
+	struct llist_node	*a = NULL, *b = NULL, *next;
+
+	if (!node || !node->next)
+		return node;
+
+	while (node) {
+		next = node->next;
+		node->next = a;
+		a = node;
+		node = next;
+		swap(a, b);
+	}
+
+	return xfs_inodegc_merge(xfs_inodegc_sort(a), xfs_inodegc_sort(b));
+}
+
 void
 xfs_inodegc_worker(
 	struct work_struct	*work)
@@ -1877,6 +1929,7 @@ xfs_inodegc_worker(
 	 */
 	nofs_flag = memalloc_nofs_save();
 
+	node = xfs_inodegc_sort(node);
 	ip = llist_entry(node, struct xfs_inode, i_gclist);
 	trace_xfs_inodegc_worker(mp, READ_ONCE(gc->shrinker_hits));
 
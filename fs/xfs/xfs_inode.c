@@ -2718,7 +2718,8 @@ xfs_remove(
 	if (error)
 		goto std_return;
 
-	if (is_dir && xfs_inode_is_filestream(ip))
+	if ((is_dir || (xfs_fstrm_inode_mb && VFS_I(ip)->i_nlink == 0)) &&
+	    xfs_inode_is_filestream(ip))
 		xfs_filestream_deassociate(ip);
 
 	return 0;
@@ -20,6 +20,8 @@
 #include "xfs_icache.h"
 #include "xfs_health.h"
 #include "xfs_trans.h"
+#include "xfs_pwork.h"
+#include "xfs_ag.h"
 
 /*
  * Bulk Stat
@@ -267,6 +269,237 @@ xfs_bulkstat_already_done(
 	       startino != XFS_AGINO_TO_INO(mp, agno, agino);
 }
 
+/*
+ * Parallel Bulk Stat
+ * ==================
+ *
+ * A large request that spans several AGs is split up so that up to
+ * XFS_BULKSTAT_PARALLEL_AGS AGs are walked at once by xfs_pwork threads.
+ * Each thread stats the inodes of its AG into a kernel buffer, and the caller
+ * then hands the buffers to the formatter in AG order, so userspace sees the
+ * same records in the same order as from a single-threaded walk.
+ *
+ * The AGs of a batch are chosen from the allocated inode counts in the AGIs,
+ * so that only the last AG of a batch is expected to fill the request.  If an
+ * AG turns out to have more inodes than we asked it for, the records of the
+ * AGs after it are thrown away and the next batch restarts from its cursor.
+ */
+#define XFS_BULKSTAT_PARALLEL_MIN	(1024U)	/* inodes per request */
+#define XFS_BULKSTAT_PARALLEL_AGS	(8U)	/* AGs per batch */
+#define XFS_BULKSTAT_PARALLEL_RECS	(512U)	/* inodes per AG and batch */
+
+/* Shared by all bulkstat calls, so that they don't each create a workqueue */
+struct workqueue_struct *xfs_bulkstat_wq;
+
+struct xfs_bstat_ag {
+	struct xfs_pwork	pwork;
+	struct xfs_ibulk	breq;
+	struct xfs_bstat_chunk	bc;
+	struct xfs_bulkstat	*recs;
+	xfs_agnumber_t		agno;
+	int			error;
+};
+
+/* Stash the bulkstat information of one inode in the AG's kernel buffer. */
+static int
+xfs_bulkstat_ag_fmt(
+	struct xfs_ibulk		*breq,
+	const struct xfs_bulkstat	*bstat)
+{
+	struct xfs_bstat_ag		*bag;
+
+	bag = container_of(breq, struct xfs_bstat_ag, breq);
+	bag->recs[breq->ocount] = *bstat;
+	return xfs_ibulk_advance(breq, 0);
+}
+
+/* Walk one AG of a parallel bulkstat batch. */
+static int
+xfs_bulkstat_ag_work(
+	struct xfs_mount	*mp,
+	struct xfs_pwork	*pwork)
+{
+	struct xfs_bstat_ag	*bag;
+	struct xfs_trans	*tp;
+	int			error;
+
+	bag = container_of(pwork, struct xfs_bstat_ag, pwork);
+	error = xfs_trans_alloc_empty(mp, &tp);
+	if (!error) {
+		error = xfs_iwalk(mp, tp, bag->breq.startino,
+				XFS_IWALK_SAME_AG, xfs_bulkstat_iwalk,
+				bag->breq.icount, &bag->bc);
+		xfs_trans_cancel(tp);
+	}
+
+	/* Errors are reported in AG order by the caller, don't abort others */
+	bag->error = error == -ECANCELED ? 0 : error;
+	return 0;
+}
+
+/*
+ * Set up the next batch of AGs to walk, starting at @breq->startino, and
+ * return the number of AGs in it.
+ */
+static int
+xfs_bulkstat_plan(
+	struct xfs_ibulk	*breq,
+	struct xfs_trans	*tp,
+	struct xfs_bstat_ag	*bags,
+	unsigned int		*nr)
+{
+	struct xfs_mount	*mp = breq->mp;
+	xfs_agnumber_t		agno = XFS_INO_TO_AGNO(mp, breq->startino);
+	unsigned int		left = breq->icount - breq->ocount;
+	unsigned int		est = 0;
+	int			error = 0;
+
+	for (*nr = 0; *nr < XFS_BULKSTAT_PARALLEL_AGS &&
+		      agno < mp->m_sb.sb_agcount; agno++) {
+		struct xfs_bstat_ag	*bag = &bags[(*nr)++];
+		struct xfs_perag	*pag;
+		struct xfs_buf		*agi_bp;
+		unsigned int		ag_est = 0;
+
+		pag = xfs_perag_get(mp, agno);
+		error = xfs_ialloc_read_agi(pag, tp, &agi_bp);
+		if (!error) {
+			ag_est = pag->pagi_count - pag->pagi_freecount;
+			xfs_trans_brelse(tp, agi_bp);
+		}
+		xfs_perag_put(pag);
+		if (error)
+			break;
+
+		if (!bag->recs) {
+			bag->recs = kvmalloc_array(XFS_BULKSTAT_PARALLEL_RECS,
+					sizeof(struct xfs_bulkstat),
+					GFP_KERNEL);
+			bag->bc.buf = kzalloc(sizeof(struct xfs_bulkstat),
+					GFP_KERNEL | __GFP_RETRY_MAYFAIL);
+			if (!bag->recs || !bag->bc.buf) {
+				error = -ENOMEM;
+				break;
+			}
+		}
+
+		bag->agno = agno;
+		bag->error = 0;
+		bag->bc.formatter = xfs_bulkstat_ag_fmt;
+		bag->bc.breq = &bag->breq;
+		bag->breq = (struct xfs_ibulk) {
+			.mp		= mp,
+			.idmap		= breq->idmap,
+			.startino	= *nr == 1 ? breq->startino :
+					  XFS_AGINO_TO_INO(mp, agno, 0),
+			.icount		= min(left - est,
+					      XFS_BULKSTAT_PARALLEL_RECS),
+			.flags		= breq->flags | XFS_IBULK_SAME_AG,
+		};
+
+		/* This AG is expected to fill the request, or the buffer */
+		if (ag_est >= bag->breq.icount)
+			break;
+		est += ag_est;
+	}
+
+	return error;
+}
+
+/*
+ * Hand the records of a batch to the formatter in AG order and move the
+ * cursor past them.  Returns 1 if the batch was cut short and the next batch
+ * must restart from @breq->startino, 0 to continue with the next AG after
+ * the batch, or a negative error.
+ */
+static int
+xfs_bulkstat_emit(
+	struct xfs_ibulk	*breq,
+	bulkstat_one_fmt_pf	formatter,
+	struct xfs_bstat_ag	*bags,
+	unsigned int		nr)
+{
+	struct xfs_mount	*mp = breq->mp;
+	unsigned int		i, j;
+	int			error;
+
+	for (i = 0; i < nr; i++) {
+		struct xfs_bstat_ag	*bag = &bags[i];
+
+		for (j = 0; j < bag->breq.ocount; j++) {
+			error = formatter(breq, &bag->recs[j]);
+			if (error && error != -ECANCELED)
+				return error;
+			breq->startino = bag->recs[j].bs_ino + 1;
+			if (error)
+				return error;
+		}
+
+		breq->startino = bag->breq.startino;
+		if (bag->error)
+			return bag->error;
+		if (bag->breq.ocount == bag->breq.icount)
+			return 1;
+		if (bag->agno + 1 < mp->m_sb.sb_agcount)
+			breq->startino = XFS_AGINO_TO_INO(mp, bag->agno + 1, 0);
+	}
+
+	return 0;
+}
+
+static int
+xfs_bulkstat_parallel(
+	struct xfs_ibulk	*breq,
+	bulkstat_one_fmt_pf	formatter,
+	struct xfs_trans	*tp)
+{
+	struct xfs_mount	*mp = breq->mp;
+	struct xfs_pwork_ctl	pctl;
+	struct xfs_bstat_ag	*bags;
+	unsigned int		i, nr;
+	int			error = 0;
+
+	bags = kcalloc(XFS_BULKSTAT_PARALLEL_AGS, sizeof(*bags), GFP_KERNEL);
+	if (!bags)
+		return -ENOMEM;
+
+	xfs_pwork_init_shared(mp, &pctl, xfs_bulkstat_ag_work, xfs_bulkstat_wq);
+
+	while (breq->ocount < breq->icount &&
+	       !xfs_bulkstat_already_done(mp, breq->startino)) {
+		error = xfs_bulkstat_plan(breq, tp, bags, &nr);
+		if (error)
+			break;
+
+		if (nr == 1) {
+			xfs_bulkstat_ag_work(mp, &bags[0].pwork);
+		} else {
+			for (i = 0; i < nr; i++)
+				xfs_pwork_queue(&pctl, &bags[i].pwork);
+			xfs_pwork_poll(&pctl);
+		}
+
+		error = xfs_bulkstat_emit(breq, formatter, bags, nr);
+		if (error < 0)
+			break;
+		if (!error && bags[nr - 1].agno + 1 >= mp->m_sb.sb_agcount)
+			break;
+		error = 0;
+		if (fatal_signal_pending(current)) {
+			error = -EINTR;
+			break;
+		}
+	}
+
+	xfs_pwork_destroy(&pctl);
+	for (i = 0; i < XFS_BULKSTAT_PARALLEL_AGS; i++) {
+		kvfree(bags[i].recs);
+		kfree(bags[i].bc.buf);
+	}
+	kfree(bags);
+	return error == -ECANCELED ? 0 : error;
+}
+
 /* Return stat information in bulk (by-inode) for the filesystem. */
 int
 xfs_bulkstat(
@@ -305,8 +538,14 @@ xfs_bulkstat(
 	if (breq->flags & XFS_IBULK_SAME_AG)
 		iwalk_flags |= XFS_IWALK_SAME_AG;
 
-	error = xfs_iwalk(breq->mp, tp, breq->startino, iwalk_flags,
-			xfs_bulkstat_iwalk, breq->icount, &bc);
+	if (!(breq->flags & XFS_IBULK_SAME_AG) &&
+	    breq->icount >= XFS_BULKSTAT_PARALLEL_MIN &&
+	    XFS_INO_TO_AGNO(breq->mp, breq->startino) + 1 <
+			breq->mp->m_sb.sb_agcount)
+		error = xfs_bulkstat_parallel(breq, formatter, tp);
+	else
+		error = xfs_iwalk(breq->mp, tp, breq->startino, iwalk_flags,
+				xfs_bulkstat_iwalk, breq->icount, &bc);
 	xfs_trans_cancel(tp);
 out:
 	kfree(bc.buf);
@@ -47,8 +47,16 @@ xfs_pwork_work(
 	error = pctl->work_fn(pctl->mp, pwork);
 	if (error && !pctl->error)
 		pctl->error = error;
+
+	/*
+	 * Drop our count under the waitqueue lock.  Releasing the lock is
+	 * then our last access to @pctl, which xfs_pwork_destroy() waits out
+	 * by taking the lock itself.
+	 */
+	spin_lock_irq(&pctl->poll_wait.lock);
 	if (atomic_dec_and_test(&pctl->nr_work))
-		wake_up(&pctl->poll_wait);
+		wake_up_locked(&pctl->poll_wait);
+	spin_unlock_irq(&pctl->poll_wait.lock);
 }
 
 /*
@@ -79,12 +87,34 @@ xfs_pwork_init(
 	pctl->work_fn = work_fn;
 	pctl->error = 0;
 	pctl->mp = mp;
+	pctl->shared_wq = false;
 	atomic_set(&pctl->nr_work, 0);
 	init_waitqueue_head(&pctl->poll_wait);
 
 	return 0;
 }
 
+/*
+ * Set up control data for parallel work queued to the existing workqueue
+ * @wq, for callers that run too often to create a workqueue every time.
+ * The parallelism is then that of @wq.
+ */
+void
+xfs_pwork_init_shared(
+	struct xfs_mount	*mp,
+	struct xfs_pwork_ctl	*pctl,
+	xfs_pwork_work_fn	work_fn,
+	struct workqueue_struct	*wq)
+{
+	pctl->wq = wq;
+	pctl->work_fn = work_fn;
+	pctl->error = 0;
+	pctl->mp = mp;
+	pctl->shared_wq = true;
+	atomic_set(&pctl->nr_work, 0);
+	init_waitqueue_head(&pctl->poll_wait);
+}
+
 /* Queue some parallel work. */
 void
 xfs_pwork_queue(
@@ -102,7 +132,14 @@ int
 xfs_pwork_destroy(
 	struct xfs_pwork_ctl	*pctl)
 {
-	destroy_workqueue(pctl->wq);
+	if (pctl->shared_wq) {
+		wait_event(pctl->poll_wait, atomic_read(&pctl->nr_work) == 0);
+		/* Let the last worker finish with poll_wait before it goes. */
+		spin_lock_irq(&pctl->poll_wait.lock);
+		spin_unlock_irq(&pctl->poll_wait.lock);
+	} else {
+		destroy_workqueue(pctl->wq);
+	}
 	pctl->wq = NULL;
 	return pctl->error;
 }
@@ -21,6 +21,7 @@ struct xfs_pwork_ctl {
 	struct wait_queue_head	poll_wait;
 	atomic_t		nr_work;
 	int			error;
+	bool			shared_wq;
 };
 
 /*
@@ -52,6 +53,8 @@ xfs_pwork_want_abort(
 
 int xfs_pwork_init(struct xfs_mount *mp, struct xfs_pwork_ctl *pctl,
 		xfs_pwork_work_fn work_fn, const char *tag);
+void xfs_pwork_init_shared(struct xfs_mount *mp, struct xfs_pwork_ctl *pctl,
+		xfs_pwork_work_fn work_fn, struct workqueue_struct *wq);
 void xfs_pwork_queue(struct xfs_pwork_ctl *pctl, struct xfs_pwork *pwork);
 int xfs_pwork_destroy(struct xfs_pwork_ctl *pctl);
 void xfs_pwork_poll(struct xfs_pwork_ctl *pctl);
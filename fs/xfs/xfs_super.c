@@ -2287,7 +2287,14 @@ xfs_init_workqueues(void)
 	if (!xfs_discard_wq)
 		goto out_free_alloc_wq;
 
+	xfs_bulkstat_wq = alloc_workqueue("xfsbulkstat",
+			XFS_WQFLAGS(WQ_UNBOUND | WQ_FREEZABLE), 0);
+	if (!xfs_bulkstat_wq)
+		goto out_free_discard_wq;
+
 	return 0;
+out_free_discard_wq:
+	destroy_workqueue(xfs_discard_wq);
 out_free_alloc_wq:
 	destroy_workqueue(xfs_alloc_wq);
 	return -ENOMEM;
@@ -2296,6 +2303,7 @@ xfs_init_workqueues(void)
 STATIC void
 xfs_destroy_workqueues(void)
 {
+	destroy_workqueue(xfs_bulkstat_wq);
 	destroy_workqueue(xfs_discard_wq);
 	destroy_workqueue(xfs_alloc_wq);
 }
@@ -97,6 +97,7 @@ extern const struct dax_holder_operations xfs_dax_holder_operations;
 extern void xfs_reinit_percpu_counters(struct xfs_mount *mp);
 
 extern struct workqueue_struct *xfs_discard_wq;
+extern struct workqueue_struct *xfs_bulkstat_wq;
 
 #define XFS_M(sb)		((struct xfs_mount *)((sb)->s_fs_info))
 
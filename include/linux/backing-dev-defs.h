@@ -171,6 +171,7 @@ struct backing_dev_info {
 	unsigned int capabilities; /* Device capabilities */
 	unsigned int min_ratio;
 	unsigned int max_ratio, max_prop_frac;
+	unsigned int dirty_latency_ms;	/* writeback latency target, 0 = none */
 
 	/*
 	 * Sum of avg_write_bw of wbs with dirty inodes.  > 0 if there are
@@ -317,6 +317,7 @@ struct nbcon_write_context {
  * @ospeed:		TTY output speed
  * @seq:		Sequence number of the next ringbuffer record to print
  * @dropped:		Number of unreported dropped ringbuffer records
+ * @dropped_total:	Number of ringbuffer records lost for this console
  * @data:		Driver private data
  * @node:		hlist node for the console list
  *
@@ -341,6 +342,7 @@ struct console {
 	uint			ospeed;
 	u64			seq;
 	unsigned long		dropped;
+	unsigned long		dropped_total;
 	void			*data;
 	struct hlist_node	node;
 
@@ -505,6 +507,7 @@ extern void console_conditional_schedule(void);
 extern void console_unblank(void);
 extern void console_flush_on_panic(enum con_flush_mode mode);
 extern struct tty_driver *console_device(int *);
+extern u64 console_backlog(struct console *con);
 extern void console_stop(struct console *);
 extern void console_start(struct console *);
 extern int is_console_locked(void);
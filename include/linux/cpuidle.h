@@ -265,6 +265,7 @@ static inline void cpuidle_use_deepest_state(u64 latency_limit_ns)
 
 /* kernel/sched/idle.c */
 extern void sched_idle_set_state(struct cpuidle_state *idle_state);
+extern u64 sched_idle_exit_latency(int cpu);
 extern void default_idle_call(void);
 
 #ifdef CONFIG_ARCH_NEEDS_CPU_IDLE_COUPLED
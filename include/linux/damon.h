@@ -105,14 +105,17 @@ struct damon_target {
  * @DAMOS_NOHUGEPAGE:	Call ``madvise()`` for the region with MADV_NOHUGEPAGE.
  * @DAMOS_LRU_PRIO:	Prioritize the region on its LRU lists.
  * @DAMOS_LRU_DEPRIO:	Deprioritize the region on its LRU lists.
+ * @DAMOS_MIGRATE_HOT:	Migrate the regions prioritizing warmer regions.
+ * @DAMOS_MIGRATE_COLD:	Migrate the regions prioritizing colder regions.
  * @DAMOS_STAT:		Do nothing but count the stat.
  * @NR_DAMOS_ACTIONS:	Total number of DAMOS actions
  *
  * The support of each action is up to running &struct damon_operations.
  * &enum DAMON_OPS_VADDR and &enum DAMON_OPS_FVADDR supports all actions except
- * &enum DAMOS_LRU_PRIO and &enum DAMOS_LRU_DEPRIO.  &enum DAMON_OPS_PADDR
- * supports only &enum DAMOS_PAGEOUT, &enum DAMOS_LRU_PRIO, &enum
- * DAMOS_LRU_DEPRIO, and &DAMOS_STAT.
+ * &enum DAMOS_LRU_PRIO, &enum DAMOS_LRU_DEPRIO, &enum DAMOS_MIGRATE_HOT and
+ * &enum DAMOS_MIGRATE_COLD.  &enum DAMON_OPS_PADDR supports only &enum
+ * DAMOS_PAGEOUT, &enum DAMOS_LRU_PRIO, &enum DAMOS_LRU_DEPRIO, &enum
+ * DAMOS_MIGRATE_HOT, &enum DAMOS_MIGRATE_COLD, and &DAMOS_STAT.
  */
 enum damos_action {
 	DAMOS_WILLNEED,
@@ -122,6 +125,8 @@ enum damos_action {
 	DAMOS_NOHUGEPAGE,
 	DAMOS_LRU_PRIO,
 	DAMOS_LRU_DEPRIO,
+	DAMOS_MIGRATE_HOT,
+	DAMOS_MIGRATE_COLD,
 	DAMOS_STAT,		/* Do nothing but only record the stat */
 	NR_DAMOS_ACTIONS,
 };
@@ -370,6 +375,8 @@ struct damos_access_pattern {
  * @pattern:		Access pattern of target regions.
  * @action:		&damo_action to be applied to the target regions.
  * @apply_interval_us:	The time between applying the @action.
+ * @target_nid:		Destination node for &DAMOS_MIGRATE_HOT and
+ *			&DAMOS_MIGRATE_COLD.
  * @quota:		Control the aggressiveness of this scheme.
  * @wmarks:		Watermarks for automated (in)activation of this scheme.
  * @filters:		Additional set of &struct damos_filter for &action.
@@ -382,6 +389,9 @@ struct damos_access_pattern {
  *
  * If @apply_interval_us is zero, &damon_attrs->aggr_interval is used instead.
  *
+ * The migrate actions move the regions to @target_nid, and do nothing if it
+ * is %NUMA_NO_NODE.
+ *
  * To do the work only when needed, schemes can be activated for specific
  * system situations using &wmarks.  If all schemes that registered to the
  * monitoring context are inactive, DAMON stops monitoring either, and just
@@ -406,6 +416,7 @@ struct damos {
 	 */
 	unsigned long next_apply_sis;
 /* public: */
+	int target_nid;
 	struct damos_quota quota;
 	struct damos_watermarks wmarks;
 	struct list_head filters;
@@ -420,12 +431,15 @@ struct damos {
  * @DAMON_OPS_FVADDR:	Monitoring operations for only fixed ranges of virtual
  *			address spaces
  * @DAMON_OPS_PADDR:	Monitoring operations for the physical address space
+ * @DAMON_OPS_PSAMPLE:	Monitoring operations for the physical address space
+ *			using hardware access samples
  * @NR_DAMON_OPS:	Number of monitoring operations implementations
  */
 enum damon_ops_id {
 	DAMON_OPS_VADDR,
 	DAMON_OPS_FVADDR,
 	DAMON_OPS_PADDR,
+	DAMON_OPS_PSAMPLE,
 	NR_DAMON_OPS,
 };
 
@@ -616,6 +630,8 @@ struct damon_ctx {
 	unsigned long next_ops_update_sis;
 	/* for waiting until the execution of the kdamond_fn is started */
 	struct completion kdamond_started;
+	/* data of the operations set, managed by its init and cleanup */
+	void *ops_private;
 
 /* public: */
 	struct task_struct *kdamond;
@@ -724,7 +740,8 @@ struct damos *damon_new_scheme(struct damos_access_pattern *pattern,
 			enum damos_action action,
 			unsigned long apply_interval_us,
 			struct damos_quota *quota,
-			struct damos_watermarks *wmarks);
+			struct damos_watermarks *wmarks,
+			int target_nid);
 void damon_add_scheme(struct damon_ctx *ctx, struct damos *s);
 void damon_destroy_scheme(struct damos *s);
 
@@ -474,6 +474,10 @@ void dma_resv_replace_fences(struct dma_resv *obj, uint64_t context,
 			     enum dma_resv_usage usage);
 int dma_resv_get_fences(struct dma_resv *obj, enum dma_resv_usage usage,
 			unsigned int *num_fences, struct dma_fence ***fences);
+int dma_resv_snapshot_fences(struct dma_resv *obj, enum dma_resv_usage usage,
+			     struct dma_fence **fences,
+			     unsigned int max_fences,
+			     unsigned int *num_fences);
 int dma_resv_get_singleton(struct dma_resv *obj, enum dma_resv_usage usage,
 			   struct dma_fence **fence);
 int dma_resv_copy_fences(struct dma_resv *dst, struct dma_resv *src);
@@ -33,6 +33,10 @@ enum hrtimer_restart {
  * @is_soft:	Set if hrtimer will be expired in soft interrupt context.
  * @is_hard:	Set if hrtimer will be expired in hard interrupt context
  *		even on RT.
+ * @is_grouped:	Set if hrtimer was started with HRTIMER_MODE_GROUP
+ * @group:	timers expiring together with this one (group leader only)
+ * @group_node:	entry in the leader's @group list, the timer is then
+ *		enqueued but not linked in the timerqueue
  *
  * The hrtimer structure must be initialized by hrtimer_init()
  */
@@ -45,6 +49,11 @@ struct hrtimer {
 	u8				is_rel;
 	u8				is_soft;
 	u8				is_hard;
+#ifdef CONFIG_HRTIMER_GROUPS
+	u8				is_grouped;
+	struct hlist_head		group;
+	struct hlist_node		group_node;
+#endif
 };
 
 #endif /* _LINUX_HRTIMER_TYPES_H */
@@ -100,6 +100,8 @@ extern unsigned long transparent_hugepage_flags;
 extern unsigned long huge_anon_orders_always;
 extern unsigned long huge_anon_orders_madvise;
 extern unsigned long huge_anon_orders_inherit;
+extern unsigned long huge_shmem_orders_always;
+extern unsigned long huge_shmem_orders_inherit;
 
 static inline bool hugepage_global_enabled(void)
 {
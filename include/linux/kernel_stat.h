@@ -41,6 +41,9 @@ struct kernel_cpustat {
 struct kernel_stat {
 	unsigned long irqs_sum;
 	unsigned int softirqs[NR_SOFTIRQS];
+#ifdef CONFIG_SOFTIRQ_VEC_BUDGET
+	u64 softirq_time[NR_SOFTIRQS];
+#endif
 };
 
 DECLARE_PER_CPU(struct kernel_stat, kstat);
@@ -68,6 +71,14 @@ static inline unsigned int kstat_softirqs_cpu(unsigned int irq, int cpu)
        return kstat_cpu(cpu).softirqs[irq];
 }
 
+#ifdef CONFIG_SOFTIRQ_VEC_BUDGET
+/* Time spent in the softirq vector, in nanoseconds */
+static inline u64 kstat_softirq_time_cpu(unsigned int irq, int cpu)
+{
+	return kstat_cpu(cpu).softirq_time[irq];
+}
+#endif
+
 static inline unsigned int kstat_cpu_softirqs_sum(int cpu)
 {
 	int i;
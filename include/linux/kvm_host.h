@@ -350,6 +350,7 @@ struct kvm_vcpu {
 	int sigset_active;
 	sigset_t sigset;
 	unsigned int halt_poll_ns;
+	u8 halt_poll_history;	/* one bit per recent halt, set if short */
 	bool valid_wakeup;
 
 #ifdef CONFIG_HAS_IOMEM
@@ -15,6 +15,17 @@
 #define DMA_MAP_TO_DEVICE       1
 #define DMA_MAP_FROM_DEVICE     2
 
+#define DMA_MAP_SINGLE_MODE     0 /* dma_map_single() of granule pages */
+#define DMA_MAP_SG_MODE         1 /* dma_map_sgtable() of granule pages */
+
+#define DMA_MAP_SPREAD_NODES    (-2) /* node: spread threads over nodes */
+
+#define DMA_MAP_IOMMU_NONE      0 /* no IOMMU translation for the device */
+#define DMA_MAP_IOMMU_PASSTHROUGH 1
+#define DMA_MAP_IOMMU_STRICT    2
+#define DMA_MAP_IOMMU_LAZY      3
+#define DMA_MAP_IOMMU_OTHER     4
+
 struct map_benchmark {
 	__u64 avg_map_100ns; /* average map latency in 100ns */
 	__u64 map_stddev; /* standard deviation of map latency */
@@ -27,5 +38,13 @@ struct map_benchmark {
 	__u32 dma_dir; /* DMA data direction */
 	__u32 dma_trans_ns; /* time for DMA transmission in ns */
 	__u32 granule;  /* how many PAGE_SIZE will do map/unmap once a time */
+	__u32 mode; /* DMA_MAP_SINGLE_MODE or DMA_MAP_SG_MODE */
+	__u32 iommu_mode; /* IOMMU domain type of the device, DMA_MAP_IOMMU_* */
+	__u32 reserved;
+	/* latency percentiles in 100ns, upper bounds of power of 2 buckets */
+	__u64 map_p50_100ns;
+	__u64 map_p99_100ns;
+	__u64 unmap_p50_100ns;
+	__u64 unmap_p99_100ns;
 };
 #endif /* _KERNEL_DMA_BENCHMARK_H */
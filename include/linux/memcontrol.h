@@ -55,6 +55,10 @@ enum memcg_memory_event {
 	MEMCG_NR_MEMORY_EVENTS,
 };
 
+/* log4 bins of refault distances in pages, see memory.refault_distance */
+#define NR_REFAULT_DIST_BINS	16
+#define NR_REFAULT_DIST		(ANON_AND_FILE * NR_REFAULT_DIST_BINS)
+
 struct mem_cgroup_reclaim_cookie {
 	pg_data_t *pgdat;
 	unsigned int generation;
@@ -1059,6 +1063,9 @@ static inline unsigned long lruvec_page_state_local(struct lruvec *lruvec,
 void mem_cgroup_flush_stats(struct mem_cgroup *memcg);
 void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg);
 
+void mem_cgroup_record_refault(struct mem_cgroup *memcg, bool file,
+			       unsigned long distance, long nr_pages);
+
 void __mod_memcg_lruvec_state(struct lruvec *lruvec, enum node_stat_item idx,
 			      int val);
 void __mod_lruvec_kmem_state(void *p, enum node_stat_item idx, int val);
@@ -1576,6 +1583,12 @@ static inline void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg)
 {
 }
 
+static inline void mem_cgroup_record_refault(struct mem_cgroup *memcg,
+					     bool file, unsigned long distance,
+					     long nr_pages)
+{
+}
+
 static inline void __mod_memcg_lruvec_state(struct lruvec *lruvec,
 					    enum node_stat_item idx, int val)
 {
@@ -142,14 +142,32 @@ const struct movable_operations *page_movable_ops(struct page *page)
 }
 
 #ifdef CONFIG_NUMA_BALANCING
+/* upper limit of sysctl_numa_balancing_migrate_batch */
+#define NUMA_MIGRATE_BATCH_MAX	32
+
 int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 			   int node);
+bool migrate_misplaced_folio_queue(struct folio *folio,
+				   struct vm_area_struct *vma, int node);
+void migrate_misplaced_flush(void);
+void migrate_misplaced_release(struct task_struct *p);
 #else
 static inline int migrate_misplaced_folio(struct folio *folio,
 					 struct vm_area_struct *vma, int node)
 {
 	return -EAGAIN; /* can't migrate now */
 }
+static inline bool migrate_misplaced_folio_queue(struct folio *folio,
+				struct vm_area_struct *vma, int node)
+{
+	return false;
+}
+static inline void migrate_misplaced_flush(void)
+{
+}
+static inline void migrate_misplaced_release(struct task_struct *p)
+{
+}
 #endif /* CONFIG_NUMA_BALANCING */
 
 #ifdef CONFIG_MIGRATION
@@ -829,6 +829,16 @@ struct mm_struct {
 		 */
 		unsigned long mm_cid_next_scan;
 #endif
+#ifdef CONFIG_RSEQ
+		/*
+		 * @rseq_cid_area: Per-mm_cid scratch area registered by user
+		 * space, set once and published after @rseq_cid_stride and
+		 * @rseq_cid_slots.
+		 */
+		unsigned long rseq_cid_area;
+		unsigned long rseq_cid_stride;
+		unsigned long rseq_cid_slots;
+#endif
 #ifdef CONFIG_MMU
 		atomic_long_t pgtables_bytes;	/* size of all page tables */
 #endif
@@ -970,6 +980,11 @@ struct mm_struct {
 #endif
 		struct work_struct async_put_work;
 
+#ifdef CONFIG_FUTEX
+		/* Hash for private futexes, see futex_private_hash_install() */
+		struct futex_private_hash *futex_phash;
+#endif
+
 #ifdef CONFIG_IOMMU_MM_DATA
 		struct iommu_mm_data *iommu_mm;
 #endif
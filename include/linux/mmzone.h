@@ -563,6 +563,11 @@ void lru_gen_offline_memcg(struct mem_cgroup *memcg);
 void lru_gen_release_memcg(struct mem_cgroup *memcg);
 void lru_gen_soft_reclaim(struct mem_cgroup *memcg, int nid);
 
+/* working set bins: <1s, <10s, <60s and older, see memory.wss */
+#define NR_WSS_BINS	4
+
+void lru_gen_wss(struct mem_cgroup *memcg, unsigned long wss[ANON_AND_FILE][NR_WSS_BINS]);
+
 #else /* !CONFIG_LRU_GEN */
 
 static inline void lru_gen_init_pgdat(struct pglist_data *pgdat)
@@ -683,6 +688,11 @@ enum zone_watermarks {
  */
 #define	PCPF_PREV_FREE_HIGH_ORDER	BIT(0)
 #define	PCPF_FREE_HIGH_BATCH		BIT(1)
+/*
+ * The last refill of the PCP found zone->lock contended. Grow the allocation
+ * batch faster so that the CPU takes the lock less often.
+ */
+#define	PCPF_REFILL_CONTENDED		BIT(2)
 
 struct per_cpu_pages {
 	spinlock_t lock;	/* Protects lists field */
@@ -697,6 +707,8 @@ struct per_cpu_pages {
 	u8 expire;		/* When 0, remote pagesets are drained */
 #endif
 	short free_count;	/* consecutive free count */
+	unsigned long refills;		/* number of rmqueue_bulk() refills */
+	unsigned long refills_contended; /* refills that waited on zone->lock */
 
 	/* Lists of pages, one per migrate type stored on the pcp-lists */
 	struct list_head lists[NR_PCP_LISTS];
@@ -980,6 +992,14 @@ struct zone {
 	unsigned int		compact_considered;
 	unsigned int		compact_defer_shift;
 	int			compact_order_failed;
+
+	/*
+	 * Number of free buddy pages in each pageblock, maintained under
+	 * zone->lock from pageblock_free_base on, see pageblock_free_pages().
+	 */
+	unsigned int		*pageblock_free;
+	unsigned long		pageblock_free_base;
+	unsigned long		pageblock_free_nr;
 #endif
 
 #if defined CONFIG_COMPACTION || defined CONFIG_CMA
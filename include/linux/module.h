@@ -443,6 +443,9 @@ struct module {
 	const s32 *gpl_crcs;
 	bool using_gplonly_symbols;
 
+	/* Entries of the exported symbols in the global export hash. */
+	struct mod_export *exports;
+
 #ifdef CONFIG_MODULE_SIG
 	/* Signature was verified. */
 	bool sig_ok;
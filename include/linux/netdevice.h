@@ -340,6 +340,13 @@ struct gro_list {
  */
 #define GRO_HASH_BUCKETS	8
 
+/*
+ * Upper bound the gro hash of a napi grows to when too many flows are evicted,
+ * each bit of napi_struct::gro_bitmask then covers (1 << gro_hash_shift)
+ * buckets.
+ */
+#define GRO_HASH_BUCKETS_MAX	1024
+
 /*
  * Structure for NAPI scheduling similar to tasklet but with weighting
  */
@@ -364,10 +371,18 @@ struct napi_struct {
 	/* CPU on which NAPI has been scheduled for processing */
 	int			list_owner;
 	struct net_device	*dev;
-	struct gro_list		gro_hash[GRO_HASH_BUCKETS];
+	struct gro_list		*gro_hash;
+	unsigned int		gro_hash_mask;	/* number of buckets - 1 */
+	unsigned int		gro_hash_shift;
+	unsigned int		gro_hash_evicted; /* since the last gro flush */
+	struct gro_list		gro_hash_inline[GRO_HASH_BUCKETS];
 	struct sk_buff		*skb;
 	struct list_head	rx_list; /* Pending GRO_NORMAL skbs */
 	int			rx_count; /* length of rx_list */
+	/* GRO effectiveness: segments per aggregate, flows evicted */
+	unsigned long		gro_aggregates;
+	unsigned long		gro_segments;
+	unsigned long		gro_evictions;
 	unsigned int		napi_id;
 	struct hrtimer		timer;
 	struct task_struct	*thread;
@@ -375,6 +390,8 @@ struct napi_struct {
 	struct list_head	dev_list;
 	struct hlist_node	napi_hash_node;
 	int			irq;
+	/* IRQs stay masked this long (ns) after a busy poll found data */
+	unsigned long		irq_suspend_timeout;
 };
 
 enum {
@@ -3085,6 +3102,8 @@ u16 dev_pick_tx_cpu_id(struct net_device *dev, struct sk_buff *skb,
 
 int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev);
 int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id);
+int __dev_direct_xmit_list(struct sk_buff *skb, u16 queue_id,
+			   struct sk_buff **unsent);
 
 static inline int dev_queue_xmit(struct sk_buff *skb)
 {
@@ -138,6 +138,9 @@ struct padata_shell {
  * @max_threads: Max threads to use for the job, actual number may be less
  *               depending on task size and minimum chunk size.
  * @numa_aware: Distribute jobs to different nodes with CPU in a round robin fashion.
+ * @node_local: Run all the helpers on the CPUs of node @nid, for jobs whose
+ *              memory is on that node.  Takes precedence over @numa_aware.
+ * @nid: The node of the job, only used with @node_local.
  */
 struct padata_mt_job {
 	void (*thread_fn)(unsigned long start, unsigned long end, void *arg);
@@ -148,6 +151,8 @@ struct padata_mt_job {
 	unsigned long		min_chunk;
 	int			max_threads;
 	bool			numa_aware;
+	bool			node_local;
+	int			nid;
 };
 
 /**
@@ -187,12 +192,12 @@ extern void padata_free_shell(struct padata_shell *ps);
 extern int padata_do_parallel(struct padata_shell *ps,
 			      struct padata_priv *padata, int *cb_cpu);
 extern void padata_do_serial(struct padata_priv *padata);
-extern void __init padata_do_multithreaded(struct padata_mt_job *job);
+extern void padata_do_multithreaded(struct padata_mt_job *job);
 extern int padata_set_cpumask(struct padata_instance *pinst, int cpumask_type,
 			      cpumask_var_t cpumask);
 #else
 static inline void __init padata_init(void) {}
-static inline void __init padata_do_multithreaded(struct padata_mt_job *job)
+static inline void padata_do_multithreaded(struct padata_mt_job *job)
 {
 	job->thread_fn(job->start, job->start + job->size, job->fn_arg);
 }
@@ -10,11 +10,14 @@
 #include <linux/lockdep.h>
 
 struct percpu_rw_semaphore {
+	/* Right before rss.gp_state, so readers only load one cacheline */
+	atomic_t		exp_writers;
 	struct rcu_sync		rss;
 	unsigned int __percpu	*read_count;
 	struct rcuwait		writer;
 	wait_queue_head_t	waiters;
 	atomic_t		block;
+	bool			expedited;	/* see percpu_rwsem_enter() */
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
 	struct lockdep_map	dep_map;
 #endif
@@ -26,24 +29,40 @@ struct percpu_rw_semaphore {
 #define __PERCPU_RWSEM_DEP_MAP_INIT(lockname)
 #endif
 
-#define __DEFINE_PERCPU_RWSEM(name, is_static)				\
+#define __DEFINE_PERCPU_RWSEM(name, is_static, is_expedited)		\
 static DEFINE_PER_CPU(unsigned int, __percpu_rwsem_rc_##name);		\
 is_static struct percpu_rw_semaphore name = {				\
+	.exp_writers = ATOMIC_INIT(0),					\
 	.rss = __RCU_SYNC_INITIALIZER(name.rss),			\
 	.read_count = &__percpu_rwsem_rc_##name,			\
 	.writer = __RCUWAIT_INITIALIZER(name.writer),			\
 	.waiters = __WAIT_QUEUE_HEAD_INITIALIZER(name.waiters),		\
 	.block = ATOMIC_INIT(0),					\
+	.expedited = is_expedited,					\
 	__PERCPU_RWSEM_DEP_MAP_INIT(name)				\
 }
 
 #define DEFINE_PERCPU_RWSEM(name)		\
-	__DEFINE_PERCPU_RWSEM(name, /* not static */)
+	__DEFINE_PERCPU_RWSEM(name, /* not static */, false)
 #define DEFINE_STATIC_PERCPU_RWSEM(name)	\
-	__DEFINE_PERCPU_RWSEM(name, static)
+	__DEFINE_PERCPU_RWSEM(name, static, false)
+#define DEFINE_PERCPU_RWSEM_EXPEDITED(name)	\
+	__DEFINE_PERCPU_RWSEM(name, /* not static */, true)
+#define DEFINE_STATIC_PERCPU_RWSEM_EXPEDITED(name)	\
+	__DEFINE_PERCPU_RWSEM(name, static, true)
 
 extern bool __percpu_down_read(struct percpu_rw_semaphore *, bool);
 
+/*
+ * Readers may use the per-cpu fast path unless a writer is pending, or a
+ * writer has recently left and the grace period that makes its critical
+ * section visible to fast path readers has not elapsed yet.
+ */
+static inline bool percpu_rwsem_readers_fast(struct percpu_rw_semaphore *sem)
+{
+	return rcu_sync_is_idle(&sem->rss) && !atomic_read(&sem->exp_writers);
+}
+
 static inline void percpu_down_read(struct percpu_rw_semaphore *sem)
 {
 	might_sleep();
@@ -59,7 +78,7 @@ static inline void percpu_down_read(struct percpu_rw_semaphore *sem)
 	 * and that once the synchronize_rcu() is done, the writer will see
 	 * anything we did within this RCU-sched read-size critical section.
 	 */
-	if (likely(rcu_sync_is_idle(&sem->rss)))
+	if (likely(percpu_rwsem_readers_fast(sem)))
 		this_cpu_inc(*sem->read_count);
 	else
 		__percpu_down_read(sem, false); /* Unconditional memory barrier */
@@ -78,7 +97,7 @@ static inline bool percpu_down_read_trylock(struct percpu_rw_semaphore *sem)
 	/*
 	 * Same as in percpu_down_read().
 	 */
-	if (likely(rcu_sync_is_idle(&sem->rss)))
+	if (likely(percpu_rwsem_readers_fast(sem)))
 		this_cpu_inc(*sem->read_count);
 	else
 		ret = __percpu_down_read(sem, true); /* Unconditional memory barrier */
@@ -102,7 +121,7 @@ static inline void percpu_up_read(struct percpu_rw_semaphore *sem)
 	/*
 	 * Same as in percpu_down_read().
 	 */
-	if (likely(rcu_sync_is_idle(&sem->rss))) {
+	if (likely(percpu_rwsem_readers_fast(sem))) {
 		this_cpu_dec(*sem->read_count);
 	} else {
 		/*
@@ -141,6 +160,15 @@ extern void percpu_free_rwsem(struct percpu_rw_semaphore *);
 	__percpu_init_rwsem(sem, #sem, &rwsem_key);		\
 })
 
+/*
+ * Make writers use expedited grace periods, see percpu_down_write(). Must be
+ * called before the semaphore is first used.
+ */
+static inline void percpu_rwsem_set_expedited(struct percpu_rw_semaphore *sem)
+{
+	sem->expedited = true;
+}
+
 #define percpu_rwsem_is_held(sem)	lockdep_is_held(sem)
 #define percpu_rwsem_assert_held(sem)	lockdep_assert_held(sem)
 
@@ -99,6 +99,12 @@ struct psi_group_cpu {
 	/* Time of last task change in this group (rq_clock) */
 	u64 state_start;
 
+	/* Task count changes not yet applied in psi_lazy mode */
+	int pending[NR_PSI_TASK_COUNTS];
+	int pending_oncpu;
+	struct list_head pending_node;
+	struct psi_group *group;
+
 	/* 2nd cacheline updated by the aggregator */
 
 	/* Delta detection against the sampling buckets */
@@ -72,11 +72,15 @@ static inline void rseq_fork(struct task_struct *t, unsigned long clone_flags)
 		t->rseq_len = 0;
 		t->rseq_sig = 0;
 		t->rseq_event_mask = 0;
+		t->rseq_cid = 0;
+		t->rseq_cid_seq = 0;
 	} else {
 		t->rseq = current->rseq;
 		t->rseq_len = current->rseq_len;
 		t->rseq_sig = current->rseq_sig;
 		t->rseq_event_mask = current->rseq_event_mask;
+		t->rseq_cid = current->rseq_cid;
+		t->rseq_cid_seq = current->rseq_cid_seq;
 	}
 }
 
@@ -86,8 +90,13 @@ static inline void rseq_execve(struct task_struct *t)
 	t->rseq_len = 0;
 	t->rseq_sig = 0;
 	t->rseq_event_mask = 0;
+	t->rseq_cid = 0;
+	t->rseq_cid_seq = 0;
 }
 
+int rseq_set_cid_area(unsigned long addr, unsigned long stride,
+		      unsigned long slots);
+
 #else
 
 static inline void rseq_set_notify_resume(struct task_struct *t)
@@ -113,6 +122,11 @@ static inline void rseq_fork(struct task_struct *t, unsigned long clone_flags)
 static inline void rseq_execve(struct task_struct *t)
 {
 }
+static inline int rseq_set_cid_area(unsigned long addr, unsigned long stride,
+				    unsigned long slots)
+{
+	return -EINVAL;
+}
 
 #endif
 
@@ -383,6 +383,14 @@ struct sched_param {
 	int sched_priority;
 };
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+/*
+ * Run delay histogram buckets: bucket 0 counts delays below 1024ns, bucket
+ * n those below 1024ns << n, the last one everything above.
+ */
+#define SCHED_LAT_HIST_BUCKETS		24
+#endif
+
 struct sched_info {
 #ifdef CONFIG_SCHED_INFO
 	/* Cumulative counters: */
@@ -401,6 +409,10 @@ struct sched_info {
 	/* When were we last queued to run? */
 	unsigned long long		last_queued;
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	/* Distribution of run_delay: */
+	unsigned int			lat_hist[SCHED_LAT_HIST_BUCKETS];
+#endif
 #endif /* CONFIG_SCHED_INFO */
 };
 
@@ -552,6 +564,12 @@ struct sched_entity {
 
 	u64				nr_migrations;
 
+#ifdef CONFIG_SMP
+	/* Latest distinct CPUs this entity ran on, newest first, -1 if unused */
+#define SE_CPU_HISTORY			4
+	int				cpu_history[SE_CPU_HISTORY];
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	int				depth;
 	struct sched_entity		*parent;
@@ -738,6 +756,23 @@ struct wake_q_node {
 	struct wake_q_node *next;
 };
 
+/* Lock contentions in flight, see kernel/locking/lock_contention.c */
+#define LOCK_CONTENTION_DEPTH		4
+
+struct lock_contention_frame {
+	void				*lock;
+	u64				start;
+	unsigned int			flags;
+	unsigned int			gen;
+};
+
+struct lock_contention_wait {
+#ifdef CONFIG_LOCK_CONTENTION_PROFILE
+	unsigned int			depth;
+	struct lock_contention_frame	frames[LOCK_CONTENTION_DEPTH];
+#endif
+};
+
 struct kmap_ctrl {
 #ifdef CONFIG_KMAP_LOCAL
 	int				idx;
@@ -917,6 +952,8 @@ struct task_struct {
 
 	/* Scheduler bits, serialized by scheduler locks: */
 	unsigned			sched_reset_on_fork:1;
+	/* Don't request cpufreq IO wait boosts on wakeup: */
+	unsigned			sched_no_iowait_boost:1;
 	unsigned			sched_contributes_to_load:1;
 	unsigned			sched_migrated:1;
 
@@ -1204,6 +1241,10 @@ struct task_struct {
 	struct held_lock		held_locks[MAX_LOCK_DEPTH];
 #endif
 
+#ifdef CONFIG_LOCK_CONTENTION_PROFILE
+	struct lock_contention_wait	contention_wait;
+#endif
+
 #if defined(CONFIG_UBSAN) && !defined(CONFIG_UBSAN_TRAP)
 	unsigned int			in_ubsan;
 #endif
@@ -1333,6 +1374,9 @@ struct task_struct {
 	unsigned long			numa_faults_locality[3];
 
 	unsigned long			numa_pages_migrated;
+
+	/* misplaced folios queued for migration, see migrate_misplaced_flush() */
+	struct numa_migrate_batch	*numa_migrate_batch;
 #endif /* CONFIG_NUMA_BALANCING */
 
 #ifdef CONFIG_RSEQ
@@ -1344,6 +1388,9 @@ struct task_struct {
 	 * with respect to preemption.
 	 */
 	unsigned long rseq_event_mask;
+	/* Last mm_cid reported to user-space and number of changes */
+	u32 rseq_cid;
+	u32 rseq_cid_seq;
 #endif
 
 #ifdef CONFIG_SCHED_MM_CID
@@ -2203,6 +2250,9 @@ static inline bool owner_on_cpu(struct task_struct *owner)
 unsigned long sched_cpu_util(int cpu);
 #endif /* CONFIG_SMP */
 
+/* Returns the utilization floor requested by the tasks runnable on a CPU */
+unsigned long sched_cpu_uclamp_min(int cpu);
+
 #ifdef CONFIG_SCHED_CORE
 extern void sched_core_free(struct task_struct *tsk);
 extern void sched_core_fork(struct task_struct *p);
@@ -19,14 +19,25 @@ enum hk_type {
 	HK_TYPE_MAX
 };
 
+/* Interruptions of isolated CPUs recorded in strict isolation mode */
+enum isol_intr_type {
+	ISOL_INTR_IPI,
+	ISOL_INTR_TIMER,
+	ISOL_INTR_SOFTIRQ,
+	ISOL_INTR_WORK,
+	ISOL_INTR_MAX
+};
+
 #ifdef CONFIG_CPU_ISOLATION
 DECLARE_STATIC_KEY_FALSE(housekeeping_overridden);
+DECLARE_STATIC_KEY_FALSE(housekeeping_strict_key);
 extern int housekeeping_any_cpu(enum hk_type type);
 extern const struct cpumask *housekeeping_cpumask(enum hk_type type);
 extern bool housekeeping_enabled(enum hk_type type);
 extern void housekeeping_affine(struct task_struct *t, enum hk_type type);
 extern bool housekeeping_test_cpu(int cpu, enum hk_type type);
 extern void __init housekeeping_init(void);
+extern void __isolation_log_intr(enum isol_intr_type type, unsigned long info);
 
 #else
 
@@ -72,4 +83,36 @@ static inline bool cpu_is_isolated(int cpu)
 	       cpuset_cpu_is_isolated(cpu);
 }
 
+static inline bool housekeeping_strict_enabled(void)
+{
+#ifdef CONFIG_CPU_ISOLATION
+	return static_branch_unlikely(&housekeeping_strict_key);
+#else
+	return false;
+#endif
+}
+
+/*
+ * In strict isolation mode ("isolation_strict"), deferrable per-CPU work is
+ * kept away from isolated CPUs, at the price of less precise or less timely
+ * accounting for them.
+ */
+static inline bool cpu_is_isolated_strict(int cpu)
+{
+	return housekeeping_strict_enabled() && cpu_is_isolated(cpu);
+}
+
+/*
+ * Record an interruption of the current CPU, if it is isolated: @info is
+ * the function run for it, or the softirq vector.
+ */
+static inline void isolation_log_intr(enum isol_intr_type type,
+				      unsigned long info)
+{
+#ifdef CONFIG_CPU_ISOLATION
+	if (housekeeping_strict_enabled())
+		__isolation_log_intr(type, info);
+#endif
+}
+
 #endif /* _LINUX_SCHED_ISOLATION_H */
@@ -112,6 +112,12 @@ struct shrinker {
 	int debugfs_id;
 	const char *name;
 	struct dentry *debugfs_entry;
+	/* reclaim statistics, shown in debugfs */
+	atomic_long_t nr_calls;
+	atomic_long_t nr_scanned;
+	atomic_long_t nr_freed;
+	atomic64_t total_ns;
+	atomic64_t max_ns;
 #endif
 	/* objs pending delete, per node */
 	atomic_long_t *nr_deferred;
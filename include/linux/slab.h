@@ -53,6 +53,7 @@ enum _slab_flag_bits {
 #endif
 #ifndef CONFIG_SLUB_TINY
 	_SLAB_RECLAIM_ACCOUNT,
+	_SLAB_SHEAVES,
 #endif
 	_SLAB_OBJECT_POISON,
 	_SLAB_CMPXCHG_DOUBLE,
@@ -202,6 +203,19 @@ enum _slab_flag_bits {
 #endif
 #define SLAB_TEMPORARY		SLAB_RECLAIM_ACCOUNT	/* Objects are short-lived */
 
+/*
+ * Cache freed objects in per-cpu arrays (sheaves) that are exchanged in bulk
+ * with a per-node barn. Meant for caches with high alloc/free rates where
+ * objects are commonly freed on other cpus than they were allocated on, a
+ * sheaf holds up to a few dozen objects per cpu. Ignored when the cache has
+ * debugging enabled.
+ */
+#ifndef CONFIG_SLUB_TINY
+#define SLAB_SHEAVES		__SLAB_FLAG_BIT(_SLAB_SHEAVES)
+#else
+#define SLAB_SHEAVES		__SLAB_FLAG_UNUSED
+#endif
+
 /*
  * ZERO_SIZE_PTR will be returned for zero sized kmalloc requests.
  *
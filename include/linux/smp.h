@@ -43,6 +43,8 @@ do {						\
  * flush_smp_call_function_queue() in detail.
  */
 extern void __smp_call_single_queue(int cpu, struct llist_node *node);
+extern bool __smp_call_single_queue_noipi(int cpu, struct llist_node *node);
+extern void __smp_call_single_ipi_mask(struct cpumask *mask);
 
 /* total number of cpus in this system (may exceed NR_CPUS) */
 extern unsigned int total_cpus;
@@ -166,6 +168,11 @@ void smp_call_function_many(const struct cpumask *mask,
 int smp_call_function_any(const struct cpumask *mask,
 			  smp_call_func_t func, void *info, int wait);
 
+void on_each_cpu_mask_lazy(const struct cpumask *mask, smp_call_func_t func,
+			   void *info);
+void smp_call_function_tick(void);
+void smp_call_function_idle_enter(void);
+
 void kick_all_cpus_sync(void);
 void wake_up_all_idle_cpus(void);
 
@@ -214,6 +221,11 @@ smp_call_function_any(const struct cpumask *mask, smp_call_func_t func,
 	return smp_call_function_single(0, func, info, wait);
 }
 
+#define on_each_cpu_mask_lazy(mask, func, info) \
+			on_each_cpu_mask(mask, func, info, false)
+static inline void smp_call_function_tick(void) { }
+static inline void smp_call_function_idle_enter(void) { }
+
 static inline void kick_all_cpus_sync(void) {  }
 static inline void wake_up_all_idle_cpus(void) {  }
 
@@ -233,6 +245,15 @@ static inline int get_boot_cpu_id(void)
 
 #endif /* !SMP */
 
+/*
+ * Call a function on all processors without requiring it to run right away,
+ * see on_each_cpu_mask_lazy()
+ */
+static inline void on_each_cpu_lazy(smp_call_func_t func, void *info)
+{
+	on_each_cpu_mask_lazy(cpu_online_mask, func, info);
+}
+
 /**
  * raw_processor_id() - get the current (unstable) CPU id
  *
@@ -11,6 +11,7 @@
 #include <uapi/linux/socket.h>
 
 struct file;
+struct msg_recv_batch;
 struct pid;
 struct cred;
 struct socket;
@@ -77,6 +78,7 @@ struct msghdr {
 	struct ubuf_info *msg_ubuf;
 	int (*sg_from_iter)(struct sock *sk, struct sk_buff *skb,
 			    struct iov_iter *from, size_t length);
+	struct msg_recv_batch *msg_batch; /* recvmmsg(MSG_BATCH) only */
 };
 
 struct user_msghdr {
@@ -319,7 +321,9 @@ struct ucred {
 #define MSG_MORE	0x8000	/* Sender will send more */
 #define MSG_WAITFORONE	0x10000	/* recvmmsg(): block until 1+ packets avail */
 #define MSG_SENDPAGE_NOPOLICY 0x10000 /* sendpage() internal : do no apply policy */
-#define MSG_BATCH	0x40000 /* sendmmsg(): more messages coming */
+#define MSG_BATCH	0x40000 /* sendmmsg(): more messages coming
+				 * recvmmsg(): dequeue them in batches
+				 */
 #define MSG_EOF         MSG_FIN
 #define MSG_NO_SHARED_FRAGS 0x80000 /* sendpage() internal : page frags are not shared */
 #define MSG_SENDPAGE_DECRYPTED	0x100000 /* sendpage() internal : page may carry
@@ -384,6 +388,7 @@ struct ucred {
 #define SOL_MCTP	285
 #define SOL_SMC		286
 #define SOL_VSOCK	287
+#define SOL_UNIX	288
 
 /* IPX options */
 #define IPX_TYPE	1
@@ -568,6 +568,13 @@ asmlinkage long sys_futex_wait(void __user *uaddr, unsigned long val, unsigned l
 asmlinkage long sys_futex_requeue(struct futex_waitv __user *waiters,
 				  unsigned int flags, int nr_wake, int nr_requeue);
 
+asmlinkage long sys_futex_wakev(struct futex_waitv __user *waiters,
+				unsigned int nr_futexes, unsigned int flags);
+
+asmlinkage long sys_futex_requeuev(struct futex_waitv __user *waiters,
+				   unsigned int nr_pairs, unsigned int flags,
+				   int nr_wake, int nr_requeue);
+
 asmlinkage long sys_nanosleep(struct __kernel_timespec __user *rqtp,
 			      struct __kernel_timespec __user *rmtp);
 asmlinkage long sys_nanosleep_time32(struct old_timespec32 __user *rqtp,
@@ -378,6 +378,7 @@ struct tcp_sock {
 		fastopen_client_fail:2, /* reason why fastopen failed */
 		frto        : 1;/* F-RTO (RFC5682) activated in CA_Loss */
 	u8	repair_queue;
+	u8	ack_freq;	/* TCP_ACK_FREQUENCY, 0 for the default */
 	u8	save_syn:2,	/* Save headers of SYN packet */
 		syn_data:1,	/* SYN includes data */
 		syn_fastopen:1,	/* SYN includes Fast Open option */
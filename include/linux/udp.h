@@ -44,6 +44,8 @@ enum {
 	UDP_FLAGS_UDPLITE_RECV_CC, /* set via udplite setsockopt */
 };
 
+struct udp_dst_cache;
+
 struct udp_sock {
 	/* inet_sock has to be the first member */
 	struct inet_sock inet;
@@ -95,6 +97,9 @@ struct udp_sock {
 
 	/* Cache friendly copy of sk->sk_peek_off >= 0 */
 	bool		peeking_with_offset;
+
+	/* Routes of unconnected sends, see udp_dst_cache_get() */
+	struct udp_dst_cache	*dst_cache;
 };
 
 #define udp_test_bit(nr, sk)			\
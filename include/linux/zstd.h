@@ -220,6 +220,133 @@ zstd_dctx *zstd_init_dctx(void *workspace, size_t workspace_size);
 size_t zstd_decompress_dctx(zstd_dctx *dctx, void *dst, size_t dst_capacity,
 	const void *src, size_t src_size);
 
+/* ======   Single-pass Dictionary Compression   ====== */
+
+typedef ZSTD_CDict zstd_cdict;
+typedef ZSTD_DDict zstd_ddict;
+
+/**
+ * zstd_cdict_workspace_bound() - memory needed to initialize a zstd_cdict
+ * @dict_size:  The size of the dictionary.
+ * @parameters: The compression parameters the dictionary is digested for.
+ *
+ * Return:      A lower bound on the size of the workspace that is passed to
+ *              zstd_init_cdict().
+ */
+size_t zstd_cdict_workspace_bound(size_t dict_size,
+	const zstd_compression_parameters *parameters);
+
+/**
+ * zstd_init_cdict() - digest a dictionary for compression
+ * @workspace:      The workspace to emplace the dictionary into. It must
+ *                  outlive the returned dictionary.
+ * @workspace_size: The size of workspace. Use zstd_cdict_workspace_bound() to
+ *                  determine how large the workspace must be.
+ * @dict:           The dictionary content. It is referenced, not copied, and
+ *                  must outlive the returned dictionary.
+ * @dict_size:      The size of the dictionary.
+ * @parameters:     The compression parameters to digest the dictionary for.
+ *
+ * Return:          A digested dictionary or NULL on error.
+ */
+const zstd_cdict *zstd_init_cdict(void *workspace, size_t workspace_size,
+	const void *dict, size_t dict_size,
+	const zstd_compression_parameters *parameters);
+
+/**
+ * zstd_compress_using_cdict() - compress src into dst using a dictionary
+ * @cctx:         The context. Must have been initialized with zstd_init_cctx().
+ * @dst:          The buffer to compress src into.
+ * @dst_capacity: The size of the destination buffer.
+ * @src:          The data to compress.
+ * @src_size:     The size of the data to compress.
+ * @cdict:        The dictionary, which also decides the compression parameters.
+ *
+ * Return:        The compressed size or an error, which can be checked using
+ *                zstd_is_error().
+ */
+size_t zstd_compress_using_cdict(zstd_cctx *cctx, void *dst,
+	size_t dst_capacity, const void *src, size_t src_size,
+	const zstd_cdict *cdict);
+
+/**
+ * zstd_ddict_workspace_bound() - memory needed to initialize a zstd_ddict
+ * @dict_size: The size of the dictionary.
+ *
+ * Return:     A lower bound on the size of the workspace that is passed to
+ *             zstd_init_ddict().
+ */
+size_t zstd_ddict_workspace_bound(size_t dict_size);
+
+/**
+ * zstd_init_ddict() - digest a dictionary for decompression
+ * @workspace:      The workspace to emplace the dictionary into. It must
+ *                  outlive the returned dictionary.
+ * @workspace_size: The size of workspace. Use zstd_ddict_workspace_bound() to
+ *                  determine how large the workspace must be.
+ * @dict:           The dictionary content. It is referenced, not copied, and
+ *                  must outlive the returned dictionary.
+ * @dict_size:      The size of the dictionary.
+ *
+ * Return:          A digested dictionary or NULL on error.
+ */
+const zstd_ddict *zstd_init_ddict(void *workspace, size_t workspace_size,
+	const void *dict, size_t dict_size);
+
+/**
+ * zstd_decompress_using_ddict() - decompress src into dst using a dictionary
+ * @dctx:         The decompression context.
+ * @dst:          The buffer to decompress src into.
+ * @dst_capacity: The size of the destination buffer. Must be at least as large
+ *                as the decompressed size.
+ * @src:          The zstd compressed data to decompress.
+ * @src_size:     The exact size of the data to decompress.
+ * @ddict:        The dictionary src was compressed with.
+ *
+ * Return:        The decompressed size or an error, which can be checked using
+ *                zstd_is_error().
+ */
+size_t zstd_decompress_using_ddict(zstd_dctx *dctx, void *dst,
+	size_t dst_capacity, const void *src, size_t src_size,
+	const zstd_ddict *ddict);
+
+/* ======   Shared Single-pass Decompression Contexts   ====== */
+
+/**
+ * zstd_percpu_dctx_get() - take a reference on the shared per-CPU contexts
+ *
+ * Users of zstd_decompress_percpu() must hold a reference, so that the
+ * contexts are allocated, one per possible CPU, only once for all of them
+ * instead of by each user. May sleep.
+ *
+ * Return:        0 or -ENOMEM.
+ */
+int zstd_percpu_dctx_get(void);
+
+/**
+ * zstd_percpu_dctx_put() - drop a reference on the shared per-CPU contexts
+ */
+void zstd_percpu_dctx_put(void);
+
+/**
+ * zstd_decompress_percpu() - decompress src into dst with a shared context
+ * @dst:          The buffer to decompress src into.
+ * @dst_capacity: The size of the destination buffer. Must be at least as large
+ *                as the decompressed size.
+ * @src:          The zstd compressed data to decompress.
+ * @src_size:     The exact size of the data to decompress.
+ * @ddict:        The dictionary src was compressed with, or NULL.
+ *
+ * Decompresses with the context of the local CPU, with preemption disabled.
+ * Meant for small frames, such as pages, whose decompression is dominated by
+ * the context setup and which can't afford a context of their own.
+ *
+ * Return:        The decompressed size or an error, which can be checked using
+ *                zstd_is_error().
+ */
+size_t zstd_decompress_percpu(void *dst, size_t dst_capacity,
+	const void *src, size_t src_size, const zstd_ddict *ddict);
+
 /* ======   Streaming Buffers   ====== */
 
 /**
@@ -382,6 +382,7 @@ struct flow_dissector {
 	unsigned long long  used_keys;
 		/* each bit represents presence of one key id */
 	unsigned short int offset[FLOW_DISSECTOR_KEY_MAX];
+	bool fast_path;	/* keys are all handled by __skb_flow_dissect_fast() */
 };
 
 struct flow_keys_basic {
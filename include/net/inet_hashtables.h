@@ -15,11 +15,14 @@
 #include <linux/ip.h>
 #include <linux/ipv6.h>
 #include <linux/list.h>
+#include <linux/percpu_counter.h>
+#include <linux/seqlock.h>
 #include <linux/slab.h>
 #include <linux/socket.h>
 #include <linux/spinlock.h>
 #include <linux/types.h>
 #include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #include <net/inet_connection_sock.h>
 #include <net/inet_sock.h>
@@ -153,6 +156,12 @@ struct inet_hashinfo {
 	unsigned int			ehash_mask;
 	unsigned int			ehash_locks_mask;
 
+	/* Online growth of ehash, see inet_ehash_resize_work() */
+	struct inet_ehash_bucket	*ehash_future;
+	unsigned int			ehash_future_mask;
+	unsigned int			ehash_resize_pos;
+	seqcount_t			ehash_seq;
+
 	/* Ok, let's try this, I give up, we do need a local binding
 	 * TCP hash as well as the others for fast bind/connect.
 	 */
@@ -171,6 +180,11 @@ struct inet_hashinfo {
 	unsigned int			lhash2_mask;
 	struct inet_listen_hashbucket	*lhash2;
 
+	struct percpu_counter		ehash_count;
+	unsigned int			ehash_resize_target;
+	unsigned int			ehash_resizes;
+	struct work_struct		ehash_resize_work;
+
 	bool				pernet;
 } ____cacheline_aligned_in_smp;
 
@@ -190,11 +204,47 @@ inet_lhash2_bucket(struct inet_hashinfo *h, u32 hash)
 	return &h->lhash2[hash & h->lhash2_mask];
 }
 
+/*
+ * While ehash grows, the chains covered by a bucket lock are moved to
+ * ehash_future all at once, after which ehash_resize_pos is past that lock.
+ * The result is stable with the bucket lock of @hash held. Lockless lookups
+ * must retry a miss if ehash_seq changed, as the socket may have been moved.
+ */
+static inline struct inet_ehash_bucket *__inet_ehash_bucket(
+	const struct inet_hashinfo *hashinfo,
+	unsigned int hash, unsigned int *slot)
+{
+	struct inet_ehash_bucket *future = smp_load_acquire(&hashinfo->ehash_future);
+
+	if (unlikely(future) &&
+	    (hash & hashinfo->ehash_locks_mask) < READ_ONCE(hashinfo->ehash_resize_pos)) {
+		*slot = hash & READ_ONCE(hashinfo->ehash_future_mask);
+		return &future[*slot];
+	}
+
+	/* Paired with smp_store_release() in inet_ehash_resize_work() */
+	*slot = hash & smp_load_acquire(&hashinfo->ehash_mask);
+	return &READ_ONCE(hashinfo->ehash)[*slot];
+}
+
 static inline struct inet_ehash_bucket *inet_ehash_bucket(
 	struct inet_hashinfo *hashinfo,
 	unsigned int hash)
 {
-	return &hashinfo->ehash[hash & hashinfo->ehash_mask];
+	unsigned int slot;
+
+	return __inet_ehash_bucket(hashinfo, hash, &slot);
+}
+
+/* For walks of ehash by slot, with the slot's bucket lock or RCU held */
+static inline unsigned int inet_ehash_mask(const struct inet_hashinfo *hashinfo)
+{
+	return smp_load_acquire(&hashinfo->ehash_mask);
+}
+
+static inline void inet_ehash_count_add(struct inet_hashinfo *hashinfo, s32 n)
+{
+	percpu_counter_add(&hashinfo->ehash_count, n);
 }
 
 static inline spinlock_t *inet_ehash_lockp(
@@ -214,10 +264,16 @@ static inline void inet_hashinfo2_free_mod(struct inet_hashinfo *h)
 
 static inline void inet_ehash_locks_free(struct inet_hashinfo *hashinfo)
 {
+	cancel_work_sync(&hashinfo->ehash_resize_work);
+	percpu_counter_destroy(&hashinfo->ehash_count);
 	kvfree(hashinfo->ehash_locks);
 	hashinfo->ehash_locks = NULL;
 }
 
+extern struct mutex inet_ehash_resize_mutex;
+void inet_ehash_maybe_grow(struct inet_hashinfo *hashinfo,
+			   const struct sock *sk);
+
 struct inet_hashinfo *inet_pernet_hashinfo_alloc(struct inet_hashinfo *hashinfo,
 						 unsigned int ehash_entries);
 void inet_pernet_hashinfo_free(struct inet_hashinfo *hashinfo);
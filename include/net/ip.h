@@ -40,6 +40,7 @@
 extern unsigned int sysctl_fib_sync_mem;
 extern unsigned int sysctl_fib_sync_mem_min;
 extern unsigned int sysctl_fib_sync_mem_max;
+extern int sysctl_fib_trie_accel;
 
 struct sock;
 
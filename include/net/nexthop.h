@@ -93,6 +93,10 @@ struct nh_res_table {
 	u32			idle_timer;
 	u32			unbalanced_timer;
 
+	/* Progress of an upkeep run split over several DW invocations */
+	u32			upkeep_pos;
+	unsigned long		upkeep_deadline;
+
 	u16			num_nh_buckets;
 	struct nh_res_bucket	nh_buckets[] __counted_by(num_nh_buckets);
 };
@@ -103,6 +103,8 @@ struct page_pool_alloc_stats {
  * @ring:	page placed into the ptr ring
  * @ring_full:	page released from page pool because the ptr ring was full
  * @released_refcnt:	page released (and not recycled) because refcnt > 1
+ * @remote:	page placed into a per-cpu return cache off the pool's CPU
+ * @remote_flush:	per-cpu return cache flushed into the ptr ring
  */
 struct page_pool_recycle_stats {
 	u64 cached;
@@ -110,6 +112,8 @@ struct page_pool_recycle_stats {
 	u64 ring;
 	u64 ring_full;
 	u64 released_refcnt;
+	u64 remote;
+	u64 remote_flush;
 };
 
 /**
@@ -295,6 +295,12 @@ struct Qdisc_ops {
 					   struct Qdisc *sch,
 					   struct sk_buff **to_free);
 	struct sk_buff *	(*dequeue)(struct Qdisc *);
+	/* Optional: dequeue up to @bytelimit bytes at once, as a list
+	 * linked through skb->next, and set *@packets to its length.
+	 * Only used on qdiscs for which qdisc_may_bulk() is true.
+	 */
+	struct sk_buff *	(*dequeue_batch)(struct Qdisc *, int bytelimit,
+						 int *packets);
 	struct sk_buff *	(*peek)(struct Qdisc *);
 
 	int			(*init)(struct Qdisc *sch, struct nlattr *arg,
@@ -262,6 +262,8 @@ struct sk_filter;
   *	@sk_allocation: allocation mode
   *	@sk_pacing_rate: Pacing rate (if supported by transport/packet scheduler)
   *	@sk_pacing_status: Pacing status (requested, handled by sch_fq)
+  *	@sk_pacing_next_ns: earliest departure time of the next paced packet,
+  *		shared by sch_fq instances in shared pacing mode
   *	@sk_max_pacing_rate: Maximum pacing rate (%SO_MAX_PACING_RATE)
   *	@sk_sndbuf: size of send buffer in bytes
   *	@sk_no_check_tx: %SO_NO_CHECK setting, set checksum in TX packets
@@ -465,6 +467,7 @@ struct sock {
 	struct timer_list	sk_timer;
 
 	unsigned long		sk_pacing_rate; /* bytes per second */
+	u64			sk_pacing_next_ns;
 	atomic_t		sk_zckey;
 	atomic_t		sk_tskey;
 	__cacheline_group_end(sock_write_tx);
@@ -2659,6 +2662,21 @@ static inline void sock_write_timestamp(struct sock *sk, ktime_t kt)
 #endif
 }
 
+/*
+ * recvmmsg(MSG_BATCH): a protocol may dequeue the datagrams for the @max
+ * messages left at once, and hand them out from @queue. @flush, if set, is
+ * called when recvmmsg() is done, to put back what is left in @queue and
+ * release whatever was deferred.
+ */
+struct msg_recv_batch {
+	struct sk_buff_head	queue;
+	unsigned int		max;
+	unsigned int		size;
+	struct sock		*sk;
+	void			(*flush)(struct sock *sk,
+					 struct msg_recv_batch *batch);
+};
+
 void __sock_recv_timestamp(struct msghdr *msg, struct sock *sk,
 			   struct sk_buff *skb);
 void __sock_recv_wifi_status(struct msghdr *msg, struct sock *sk,
@@ -11,6 +11,7 @@ struct tcf_police_params {
 	u32			tcfp_mtu;
 	s64			tcfp_mtu_ptoks;
 	s64			tcfp_pkt_burst;
+	s64			tcfp_edt_horizon;
 	struct psched_ratecfg	rate;
 	bool			rate_present;
 	struct psched_ratecfg	peak;
@@ -29,6 +30,9 @@ struct tcf_police {
 	s64			tcfp_ptoks;
 	s64			tcfp_pkttoks;
 	s64			tcfp_t_c;
+
+	/* EDT mode: departure time of the next packet, updated locklessly */
+	atomic64_t		tcfp_edt_next ____cacheline_aligned_in_smp;
 };
 
 #define to_police(pc) ((struct tcf_police *)pc)
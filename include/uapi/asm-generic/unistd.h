@@ -851,8 +851,13 @@ __SYSCALL(__NR_process_ksm_disable, sys_process_ksm_disable)
 #define __NR_process_ksm_status 464
 __SYSCALL(__NR_process_ksm_status, sys_process_ksm_status)
 
+#define __NR_futex_wakev 465
+__SYSCALL(__NR_futex_wakev, sys_futex_wakev)
+#define __NR_futex_requeuev 466
+__SYSCALL(__NR_futex_requeuev, sys_futex_requeuev)
+
 #undef __NR_syscalls
-#define __NR_syscalls 465
+#define __NR_syscalls 467
 
 /*
  * 32 bit systems traditionally used different
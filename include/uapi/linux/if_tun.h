@@ -61,6 +61,8 @@
 #define TUNSETFILTEREBPF _IOR('T', 225, int)
 #define TUNSETCARRIER _IOW('T', 226, int)
 #define TUNGETDEVNETNS _IO('T', 227)
+#define TUNREADPKTS  _IOWR('T', 228, struct tun_pkts)
+#define TUNWRITEPKTS _IOW('T', 229, struct tun_pkts)
 
 /* TUNSETIFF ifr flags */
 #define IFF_TUN		0x0001
@@ -100,6 +102,27 @@ struct tun_pi {
 	__be16 proto;
 };
 
+/*
+ * Batched packet I/O (TUNREADPKTS and TUNWRITEPKTS ioctls)
+ * Each packet is laid out in its buffer as for read() and write(), with the
+ * tun_pi and virtio_net_hdr when enabled, so GSO packets are supported.
+ * The ioctls return the number of packets read or written, which is less
+ * than count if a later packet fails or, for reads, no more packets are
+ * queued; an error is returned only if the first packet fails.
+ */
+#define TUN_PKTS_MAX	64	/* Maximum count of a single call */
+struct tun_pkt {
+	__u64	addr;	/* Buffer of the packet */
+	__u32	len;	/* Size of the buffer, set to the length read */
+	__u32	flags;	/* Must be zero */
+};
+
+struct tun_pkts {
+	__u64	pkts;	/* Array of count struct tun_pkt */
+	__u32	count;
+	__u32	flags;	/* Must be zero */
+};
+
 /*
  * Filter spec (used for SETXXFILTER ioctls)
  * This stuff is applicable only to the TAP (Ethernet) devices.
@@ -111,6 +111,8 @@ enum {
 	NETDEV_A_PAGE_POOL_STATS_RECYCLE_RING,
 	NETDEV_A_PAGE_POOL_STATS_RECYCLE_RING_FULL,
 	NETDEV_A_PAGE_POOL_STATS_RECYCLE_RELEASED_REFCNT,
+	NETDEV_A_PAGE_POOL_STATS_RECYCLE_REMOTE,
+	NETDEV_A_PAGE_POOL_STATS_RECYCLE_REMOTE_FLUSH,
 
 	__NETDEV_A_PAGE_POOL_STATS_MAX,
 	NETDEV_A_PAGE_POOL_STATS_MAX = (__NETDEV_A_PAGE_POOL_STATS_MAX - 1)
@@ -121,6 +123,11 @@ enum {
 	NETDEV_A_NAPI_ID,
 	NETDEV_A_NAPI_IRQ,
 	NETDEV_A_NAPI_PID,
+	NETDEV_A_NAPI_GRO_BUCKETS,
+	NETDEV_A_NAPI_GRO_AGGREGATES,
+	NETDEV_A_NAPI_GRO_SEGMENTS,
+	NETDEV_A_NAPI_GRO_EVICTIONS,
+	NETDEV_A_NAPI_IRQ_SUSPEND_TIMEOUT,
 
 	__NETDEV_A_NAPI_MAX,
 	NETDEV_A_NAPI_MAX = (__NETDEV_A_NAPI_MAX - 1)
@@ -164,6 +171,7 @@ enum {
 	NETDEV_CMD_QUEUE_GET,
 	NETDEV_CMD_NAPI_GET,
 	NETDEV_CMD_QSTATS_GET,
+	NETDEV_CMD_NAPI_SET,
 
 	__NETDEV_CMD_MAX,
 	NETDEV_CMD_MAX = (__NETDEV_CMD_MAX - 1)
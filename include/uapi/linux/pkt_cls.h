@@ -196,6 +196,7 @@ enum {
 	TCA_POLICE_PEAKRATE64,
 	TCA_POLICE_PKTRATE64,
 	TCA_POLICE_PKTBURST64,
+	TCA_POLICE_EDT_HORIZON,	/* u32, EDT mode horizon in us */
 	__TCA_POLICE_MAX
 #define TCA_POLICE_RESULT TCA_POLICE_RESULT
 };
@@ -554,6 +555,8 @@ enum {
 	TCA_FLOWER_KEY_SPI,		/* be32 */
 	TCA_FLOWER_KEY_SPI_MASK,	/* be32 */
 
+	TCA_FLOWER_MASK_CACHE,		/* flag */
+
 	__TCA_FLOWER_MAX,
 };
 
@@ -836,6 +836,8 @@ enum {
 
 	TCA_FQ_WEIGHTS,		/* Weights for each band */
 
+	TCA_FQ_SHARED_PACING,	/* keep per-socket pacing state in the socket */
+
 	__TCA_FQ_MAX
 };
 
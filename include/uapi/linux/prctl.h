@@ -306,4 +306,15 @@ struct prctl_mm_map {
 # define PR_RISCV_V_VSTATE_CTRL_NEXT_MASK	0xc
 # define PR_RISCV_V_VSTATE_CTRL_MASK		0x1f
 
+/* Copy the page tables of large anonymous mappings in parallel at fork */
+#define PR_SET_FORK_PARALLEL		71
+#define PR_GET_FORK_PARALLEL		72
+
+/*
+ * Register a per-concurrency-ID scratch area for the memory map: arg2 is its
+ * address, arg3 the size of one slot and arg4 the number of slots. rseq then
+ * points struct rseq::mm_cid_area at the slot of the current mm_cid.
+ */
+#define PR_SET_RSEQ_CID_AREA		73
+
 #endif /* _LINUX_PRCTL_H */
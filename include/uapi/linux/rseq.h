@@ -148,6 +148,28 @@ struct rseq {
 	 */
 	__u32 mm_cid;
 
+	/*
+	 * Restartable sequences mm_cid_seq field. Updated by the kernel. Read
+	 * by user-space with single-copy atomicity semantics. This field
+	 * should only be read by the thread which registered this data
+	 * structure. Aligned on 32-bit. Incremented each time the kernel
+	 * assigns a different concurrency ID to the current thread, so that
+	 * per-concurrency-ID data cached across critical sections can be
+	 * invalidated.
+	 */
+	__u32 mm_cid_seq;
+
+	/*
+	 * Restartable sequences mm_cid_area field. Updated by the kernel.
+	 * Read by user-space with single-copy atomicity semantics. This field
+	 * should only be read by the thread which registered this data
+	 * structure. Aligned on 64-bit. Contains the address of the current
+	 * concurrency ID's slot in the scratch area registered for the memory
+	 * map with prctl(PR_SET_RSEQ_CID_AREA), or 0 if there is no such
+	 * area or it has no slot for the current concurrency ID.
+	 */
+	__u64 mm_cid_area;
+
 	/*
 	 * Flexible array member at end of structure, after last feature field.
 	 */
@@ -497,6 +497,8 @@ enum {
 #define RTAX_CC_ALGO RTAX_CC_ALGO
 	RTAX_FASTOPEN_NO_COOKIE,
 #define RTAX_FASTOPEN_NO_COOKIE RTAX_FASTOPEN_NO_COOKIE
+	RTAX_ACK_FREQ,
+#define RTAX_ACK_FREQ RTAX_ACK_FREQ
 	__RTAX_MAX
 };
 
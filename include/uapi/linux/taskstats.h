@@ -239,6 +239,7 @@ enum {
 	TASKSTATS_CMD_ATTR_TGID,
 	TASKSTATS_CMD_ATTR_REGISTER_CPUMASK,
 	TASKSTATS_CMD_ATTR_DEREGISTER_CPUMASK,
+	TASKSTATS_CMD_ATTR_CGROUP_FD,	/* dump: only tasks in this cgroup */
 	__TASKSTATS_CMD_ATTR_MAX,
 };
 
@@ -134,6 +134,7 @@ enum {
 #define TCP_AO_INFO		40	/* Set/list TCP-AO per-socket options */
 #define TCP_AO_GET_KEYS		41	/* List MKT(s) */
 #define TCP_AO_REPAIR		42	/* Get/Set SNEs and ISNs */
+#define TCP_ACK_FREQUENCY	43	/* ACK every N full-sized segments */
 
 #define TCP_REPAIR_ON		1
 #define TCP_REPAIR_OFF		0
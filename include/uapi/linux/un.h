@@ -13,4 +13,10 @@ struct sockaddr_un {
 
 #define SIOCUNIXFILE (SIOCPROTOPRIVATE + 0) /* open a socket file with O_PATH */
 
+/* 'cmsg_type' field value of 'struct cmsghdr' for notification parsing
+ * when MSG_ZEROCOPY flag is used on transmissions. The 'cmsg_level' is
+ * SOL_UNIX (288).
+ */
+#define UNIX_RECVERR	1
+
 #endif /* _LINUX_UN_H */
@@ -9,6 +9,7 @@
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-mapping.h>
+#include <linux/iommu.h>
 #include <linux/kernel.h>
 #include <linux/kthread.h>
 #include <linux/map_benchmark.h>
@@ -16,9 +17,13 @@
 #include <linux/module.h>
 #include <linux/pci.h>
 #include <linux/platform_device.h>
+#include <linux/scatterlist.h>
 #include <linux/slab.h>
 #include <linux/timekeeping.h>
 
+/* map latency histogram buckets: fls64() of the latency in 100ns */
+#define DMA_MAP_HIST_BUCKETS	64
+
 struct map_benchmark_data {
 	struct map_benchmark bparam;
 	struct device *dev;
@@ -29,21 +34,123 @@ struct map_benchmark_data {
 	atomic64_t sum_sq_map;
 	atomic64_t sum_sq_unmap;
 	atomic64_t loops;
+	atomic64_t map_hist[DMA_MAP_HIST_BUCKETS];
+	atomic64_t unmap_hist[DMA_MAP_HIST_BUCKETS];
 };
 
-static int map_benchmark_thread(void *data)
-{
+struct map_benchmark_buf {
 	void *buf;
+	struct sg_table sgt;
 	dma_addr_t dma_addr;
-	struct map_benchmark_data *map = data;
+};
+
+static void map_benchmark_buf_free(struct map_benchmark_data *map,
+				   struct map_benchmark_buf *b)
+{
+	struct scatterlist *sg;
+	int i;
+
+	if (map->bparam.mode == DMA_MAP_SINGLE_MODE) {
+		free_pages_exact(b->buf, map->bparam.granule * PAGE_SIZE);
+		return;
+	}
+
+	for_each_sgtable_sg(&b->sgt, sg, i) {
+		if (sg_page(sg))
+			__free_page(sg_page(sg));
+	}
+	sg_free_table(&b->sgt);
+}
+
+/*
+ * The scatterlist is made of separately allocated pages, so that it has
+ * granule entries as for a typical block or network device request.
+ */
+static int map_benchmark_buf_alloc(struct map_benchmark_data *map,
+				   struct map_benchmark_buf *b)
+{
 	int npages = map->bparam.granule;
-	u64 size = npages * PAGE_SIZE;
-	int ret = 0;
+	struct scatterlist *sg;
+	int i;
+
+	if (map->bparam.mode == DMA_MAP_SINGLE_MODE) {
+		b->buf = alloc_pages_exact(npages * PAGE_SIZE, GFP_KERNEL);
+		return b->buf ? 0 : -ENOMEM;
+	}
 
-	buf = alloc_pages_exact(size, GFP_KERNEL);
-	if (!buf)
+	if (sg_alloc_table(&b->sgt, npages, GFP_KERNEL))
 		return -ENOMEM;
 
+	for_each_sgtable_sg(&b->sgt, sg, i) {
+		struct page *page = alloc_page(GFP_KERNEL);
+
+		if (!page) {
+			map_benchmark_buf_free(map, b);
+			return -ENOMEM;
+		}
+		sg_set_page(sg, page, PAGE_SIZE, 0);
+	}
+
+	return 0;
+}
+
+static void map_benchmark_buf_stain(struct map_benchmark_data *map,
+				    struct map_benchmark_buf *b)
+{
+	struct scatterlist *sg;
+	int i;
+
+	if (map->bparam.mode == DMA_MAP_SINGLE_MODE) {
+		memset(b->buf, 0x66, map->bparam.granule * PAGE_SIZE);
+		return;
+	}
+
+	for_each_sgtable_sg(&b->sgt, sg, i)
+		memset(sg_virt(sg), 0x66, sg->length);
+}
+
+static int map_benchmark_buf_map(struct map_benchmark_data *map,
+				 struct map_benchmark_buf *b)
+{
+	int ret;
+
+	if (map->bparam.mode == DMA_MAP_SINGLE_MODE) {
+		b->dma_addr = dma_map_single(map->dev, b->buf,
+				map->bparam.granule * PAGE_SIZE, map->dir);
+		if (unlikely(dma_mapping_error(map->dev, b->dma_addr))) {
+			pr_err("dma_map_single failed on %s\n",
+				dev_name(map->dev));
+			return -ENOMEM;
+		}
+		return 0;
+	}
+
+	ret = dma_map_sgtable(map->dev, &b->sgt, map->dir, 0);
+	if (unlikely(ret))
+		pr_err("dma_map_sgtable failed on %s\n", dev_name(map->dev));
+	return ret;
+}
+
+static void map_benchmark_buf_unmap(struct map_benchmark_data *map,
+				    struct map_benchmark_buf *b)
+{
+	if (map->bparam.mode == DMA_MAP_SINGLE_MODE)
+		dma_unmap_single(map->dev, b->dma_addr,
+				 map->bparam.granule * PAGE_SIZE, map->dir);
+	else
+		dma_unmap_sgtable(map->dev, &b->sgt, map->dir, 0);
+}
+
+static int map_benchmark_thread(void *data)
+{
+	struct map_benchmark_buf b = {};
+	struct map_benchmark_data *map = data;
+	int ret;
+
+	ret = map_benchmark_buf_alloc(map, &b);
+	if (ret)
+		return ret;
+
 	while (!kthread_should_stop())  {
 		u64 map_100ns, unmap_100ns, map_sq, unmap_sq;
 		ktime_t map_stime, map_etime, unmap_stime, unmap_etime;
@@ -56,16 +163,12 @@ static int map_benchmark_thread(void *data)
 		 * 66 means evertything goes well! 66 is lucky.
 		 */
 		if (map->dir != DMA_FROM_DEVICE)
-			memset(buf, 0x66, size);
+			map_benchmark_buf_stain(map, &b);
 
 		map_stime = ktime_get();
-		dma_addr = dma_map_single(map->dev, buf, size, map->dir);
-		if (unlikely(dma_mapping_error(map->dev, dma_addr))) {
-			pr_err("dma_map_single failed on %s\n",
-				dev_name(map->dev));
-			ret = -ENOMEM;
+		ret = map_benchmark_buf_map(map, &b);
+		if (ret)
 			goto out;
-		}
 		map_etime = ktime_get();
 		map_delta = ktime_sub(map_etime, map_stime);
 
@@ -73,7 +176,7 @@ static int map_benchmark_thread(void *data)
 		ndelay(map->bparam.dma_trans_ns);
 
 		unmap_stime = ktime_get();
-		dma_unmap_single(map->dev, dma_addr, size, map->dir);
+		map_benchmark_buf_unmap(map, &b);
 		unmap_etime = ktime_get();
 		unmap_delta = ktime_sub(unmap_etime, unmap_stime);
 
@@ -88,19 +191,76 @@ static int map_benchmark_thread(void *data)
 		atomic64_add(unmap_100ns, &map->sum_unmap_100ns);
 		atomic64_add(map_sq, &map->sum_sq_map);
 		atomic64_add(unmap_sq, &map->sum_sq_unmap);
+		atomic64_inc(&map->map_hist[min(fls64(map_100ns),
+					DMA_MAP_HIST_BUCKETS - 1)]);
+		atomic64_inc(&map->unmap_hist[min(fls64(unmap_100ns),
+					DMA_MAP_HIST_BUCKETS - 1)]);
 		atomic64_inc(&map->loops);
 	}
 
 out:
-	free_pages_exact(buf, size);
+	map_benchmark_buf_free(map, &b);
 	return ret;
 }
 
+/* Upper bound of the histogram bucket containing the pct-th percentile */
+static u64 map_benchmark_percentile(atomic64_t *hist, u64 loops,
+				    unsigned int pct)
+{
+	u64 target = div64_u64(loops * pct + 99, 100);
+	u64 sum = 0;
+	int b;
+
+	for (b = 0; b < DMA_MAP_HIST_BUCKETS; b++) {
+		sum += atomic64_read(&hist[b]);
+		if (sum >= target)
+			return b ? (1ULL << b) - 1 : 0;
+	}
+
+	return U64_MAX;
+}
+
+static u32 map_benchmark_iommu_mode(struct device *dev)
+{
+	struct iommu_domain *domain = iommu_get_domain_for_dev(dev);
+
+	if (!domain)
+		return DMA_MAP_IOMMU_NONE;
+
+	switch (domain->type) {
+	case IOMMU_DOMAIN_IDENTITY:
+		return DMA_MAP_IOMMU_PASSTHROUGH;
+	case IOMMU_DOMAIN_DMA:
+		return DMA_MAP_IOMMU_STRICT;
+	case IOMMU_DOMAIN_DMA_FQ:
+		return DMA_MAP_IOMMU_LAZY;
+	default:
+		return DMA_MAP_IOMMU_OTHER;
+	}
+}
+
+/* The node to run thread i on, round-robin over the nodes with CPUs if asked */
+static int map_benchmark_thread_node(struct map_benchmark_data *map, int i)
+{
+	int node, n;
+
+	if (map->bparam.node != DMA_MAP_SPREAD_NODES)
+		return map->bparam.node;
+
+	/* Memory-only nodes have no CPU to bind the thread to */
+	n = i % num_node_state(N_CPU);
+	for_each_node_state(node, N_CPU) {
+		if (!n--)
+			return node;
+	}
+
+	return NUMA_NO_NODE;
+}
+
 static int do_map_benchmark(struct map_benchmark_data *map)
 {
 	struct task_struct **tsk;
 	int threads = map->bparam.threads;
-	int node = map->bparam.node;
 	u64 loops;
 	int ret = 0;
 	int i;
@@ -112,8 +272,10 @@ static int do_map_benchmark(struct map_benchmark_data *map)
 	get_device(map->dev);
 
 	for (i = 0; i < threads; i++) {
+		int node = map_benchmark_thread_node(map, i);
+
 		tsk[i] = kthread_create_on_node(map_benchmark_thread, map,
-				map->bparam.node, "dma-map-benchmark/%d", i);
+				node, "dma-map-benchmark/%d", i);
 		if (IS_ERR(tsk[i])) {
 			pr_err("create dma_map thread failed\n");
 			ret = PTR_ERR(tsk[i]);
@@ -132,6 +294,10 @@ static int do_map_benchmark(struct map_benchmark_data *map)
 	atomic64_set(&map->sum_sq_map, 0);
 	atomic64_set(&map->sum_sq_unmap, 0);
 	atomic64_set(&map->loops, 0);
+	for (i = 0; i < DMA_MAP_HIST_BUCKETS; i++) {
+		atomic64_set(&map->map_hist[i], 0);
+		atomic64_set(&map->unmap_hist[i], 0);
+	}
 
 	for (i = 0; i < threads; i++) {
 		get_task_struct(tsk[i]);
@@ -172,7 +338,17 @@ static int do_map_benchmark(struct map_benchmark_data *map)
 				map->bparam.avg_unmap_100ns;
 		map->bparam.map_stddev = int_sqrt64(map_variance);
 		map->bparam.unmap_stddev = int_sqrt64(unmap_variance);
+
+		map->bparam.map_p50_100ns =
+			map_benchmark_percentile(map->map_hist, loops, 50);
+		map->bparam.map_p99_100ns =
+			map_benchmark_percentile(map->map_hist, loops, 99);
+		map->bparam.unmap_p50_100ns =
+			map_benchmark_percentile(map->unmap_hist, loops, 50);
+		map->bparam.unmap_p99_100ns =
+			map_benchmark_percentile(map->unmap_hist, loops, 99);
 	}
+	map->bparam.iommu_mode = map_benchmark_iommu_mode(map->dev);
 
 out:
 	put_device(map->dev);
@@ -211,6 +387,7 @@ static long map_benchmark_ioctl(struct file *file, unsigned int cmd,
 		}
 
 		if (map->bparam.node != NUMA_NO_NODE &&
+		    map->bparam.node != DMA_MAP_SPREAD_NODES &&
 		    (map->bparam.node < 0 || map->bparam.node >= MAX_NUMNODES ||
 		     !node_possible(map->bparam.node))) {
 			pr_err("invalid numa node\n");
@@ -222,6 +399,12 @@ static long map_benchmark_ioctl(struct file *file, unsigned int cmd,
 			return -EINVAL;
 		}
 
+		if (map->bparam.mode != DMA_MAP_SINGLE_MODE &&
+		    map->bparam.mode != DMA_MAP_SG_MODE) {
+			pr_err("invalid mapping mode\n");
+			return -EINVAL;
+		}
+
 		switch (map->bparam.dma_dir) {
 		case DMA_MAP_BIDIRECTIONAL:
 			map->dir = DMA_BIDIRECTIONAL;
@@ -34,6 +34,7 @@
 #include <linux/init.h>
 #include <linux/memblock.h>
 #include <linux/mm.h>
+#include <linux/moduleparam.h>
 #include <linux/pfn.h>
 #include <linux/rculist.h>
 #include <linux/scatterlist.h>
@@ -82,6 +83,19 @@ struct io_tlb_slot {
 static bool swiotlb_force_bounce;
 static bool swiotlb_force_disable;
 
+/*
+ * Bounces to the device of at least this many bytes are copied with
+ * memcpy_flushcache(), which uses non-temporal stores where the
+ * architecture has them, so that large bounce buffers, which the CPU does
+ * not read back, do not push the working set out of the caches.  This
+ * matters most when every DMA is bounced, as in confidential guests.
+ * Zero disables it.
+ */
+static unsigned long swiotlb_nt_copy_min;
+module_param_named(nt_copy_min, swiotlb_nt_copy_min, ulong, 0644);
+MODULE_PARM_DESC(nt_copy_min,
+		 "Minimum size of a bounce to the device copied with non-temporal stores (0 = off)");
+
 #ifdef CONFIG_SWIOTLB_DYNAMIC
 
 static void swiotlb_dyn_alloc(struct work_struct *work);
@@ -914,7 +928,18 @@ static void swiotlb_bounce(struct device *dev, phys_addr_t tlb_addr, size_t size
 			offset = 0;
 		}
 	} else if (dir == DMA_TO_DEVICE) {
-		memcpy(vaddr, phys_to_virt(orig_addr), size);
+		unsigned long nt_copy_min = READ_ONCE(swiotlb_nt_copy_min);
+
+		if (nt_copy_min && size >= nt_copy_min) {
+			memcpy_flushcache(vaddr, phys_to_virt(orig_addr), size);
+			/*
+			 * Non-temporal stores are weakly ordered, make them
+			 * visible before the driver rings the doorbell.
+			 */
+			wmb();
+		} else {
+			memcpy(vaddr, phys_to_virt(orig_addr), size);
+		}
 	} else {
 		memcpy(phys_to_virt(orig_addr), vaddr, size);
 	}
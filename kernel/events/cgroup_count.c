@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Shared hardware counters for per-cgroup counting
+ *
+ * A cgroup event occupies a hardware counter which perf_cgroup_switch()
+ * takes off and puts back on the PMU whenever the CPU switches between
+ * cgroups. With one event per cgroup for hundreds of cgroups, this both
+ * reprograms the PMU on nearly every context switch and overcommits it.
+ *
+ * Events of the "cgroup_count" PMU instead count the hardware event given by
+ * attr.config2 (the PMU type) and attr.config / attr.config1, by reading a
+ * pinned system-wide counter of that event on their CPU, shared by all of
+ * them. Being software events, scheduling them in and out on cgroup switches
+ * only snapshots the shared counter, and they are scheduled just like any
+ * other cgroup event, so a cgroup's event also counts its descendants.
+ *
+ * They are counting only, and must be CPU events; sampling is better done
+ * by a system-wide event with PERF_SAMPLE_CGROUP.
+ */
+
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/perf_event.h>
+#include <linux/slab.h>
+
+struct cgc_counter {
+	struct list_head	list;
+	refcount_t		refcount;
+	struct perf_event	*event;
+	int			cpu;
+	u32			type;
+	u64			config;
+	u64			config1;
+	u64			exclude;	/* exclude_* bits of the attr */
+};
+
+static LIST_HEAD(cgc_counters);
+static DEFINE_MUTEX(cgc_mutex);
+
+static struct pmu cgc_pmu;
+
+#define CGC_EXCLUDE(attr)					\
+	((u64)(attr)->exclude_user << 0 |			\
+	 (u64)(attr)->exclude_kernel << 1 |			\
+	 (u64)(attr)->exclude_hv << 2 |				\
+	 (u64)(attr)->exclude_idle << 3 |			\
+	 (u64)(attr)->exclude_host << 4 |			\
+	 (u64)(attr)->exclude_guest << 5)
+
+static struct cgc_counter *cgc_counter_get(struct perf_event *event)
+{
+	struct perf_event_attr *attr = &event->attr;
+	struct perf_event_attr hw_attr = {
+		.size		= sizeof(hw_attr),
+		.type		= attr->config2,
+		.config		= attr->config,
+		.config1	= attr->config1,
+		.pinned		= 1,
+		.exclude_user	= attr->exclude_user,
+		.exclude_kernel	= attr->exclude_kernel,
+		.exclude_hv	= attr->exclude_hv,
+		.exclude_idle	= attr->exclude_idle,
+		.exclude_host	= attr->exclude_host,
+		.exclude_guest	= attr->exclude_guest,
+	};
+	struct perf_event *hw_event;
+	struct cgc_counter *c;
+
+	mutex_lock(&cgc_mutex);
+	list_for_each_entry(c, &cgc_counters, list) {
+		if (c->cpu == event->cpu && c->type == hw_attr.type &&
+		    c->config == hw_attr.config &&
+		    c->config1 == hw_attr.config1 &&
+		    c->exclude == CGC_EXCLUDE(attr)) {
+			refcount_inc(&c->refcount);
+			goto unlock;
+		}
+	}
+
+	c = kzalloc(sizeof(*c), GFP_KERNEL);
+	if (!c) {
+		c = ERR_PTR(-ENOMEM);
+		goto unlock;
+	}
+
+	hw_event = perf_event_create_kernel_counter(&hw_attr, event->cpu,
+						    NULL, NULL, NULL);
+	if (IS_ERR(hw_event)) {
+		kfree(c);
+		c = ERR_CAST(hw_event);
+		goto unlock;
+	}
+
+	refcount_set(&c->refcount, 1);
+	c->event = hw_event;
+	c->cpu = event->cpu;
+	c->type = hw_attr.type;
+	c->config = hw_attr.config;
+	c->config1 = hw_attr.config1;
+	c->exclude = CGC_EXCLUDE(attr);
+	list_add(&c->list, &cgc_counters);
+unlock:
+	mutex_unlock(&cgc_mutex);
+
+	return c;
+}
+
+static void cgc_event_destroy(struct perf_event *event)
+{
+	struct cgc_counter *c = event->pmu_private;
+
+	mutex_lock(&cgc_mutex);
+	if (refcount_dec_and_test(&c->refcount)) {
+		list_del(&c->list);
+		perf_event_release_kernel(c->event);
+		kfree(c);
+	}
+	mutex_unlock(&cgc_mutex);
+}
+
+static int cgc_event_init(struct perf_event *event)
+{
+	struct cgc_counter *c;
+
+	if (event->attr.type != cgc_pmu.type)
+		return -ENOENT;
+
+	if (event->cpu < 0 || (event->attach_state & PERF_ATTACH_TASK) ||
+	    is_sampling_event(event) || event->attr.config2 == cgc_pmu.type)
+		return -EINVAL;
+
+	c = cgc_counter_get(event);
+	if (IS_ERR(c))
+		return PTR_ERR(c);
+
+	event->pmu_private = c;
+	event->destroy = cgc_event_destroy;
+	return 0;
+}
+
+/* Called on the event's CPU with interrupts disabled */
+static int cgc_counter_read(struct perf_event *event, u64 *val)
+{
+	struct cgc_counter *c = event->pmu_private;
+
+	return perf_event_read_local(c->event, val, NULL, NULL);
+}
+
+static void cgc_event_update(struct perf_event *event)
+{
+	u64 prev, now;
+
+	if (cgc_counter_read(event, &now))
+		return;
+
+	prev = local64_xchg(&event->hw.prev_count, now);
+	local64_add(now - prev, &event->count);
+}
+
+static void cgc_event_start(struct perf_event *event, int flags)
+{
+	u64 now;
+
+	if (cgc_counter_read(event, &now))
+		now = 0;
+	local64_set(&event->hw.prev_count, now);
+	event->hw.state = 0;
+}
+
+static void cgc_event_stop(struct perf_event *event, int flags)
+{
+	if (event->hw.state & PERF_HES_STOPPED)
+		return;
+
+	cgc_event_update(event);
+	event->hw.state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int cgc_event_add(struct perf_event *event, int flags)
+{
+	event->hw.state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+	if (flags & PERF_EF_START)
+		cgc_event_start(event, flags);
+
+	return 0;
+}
+
+static void cgc_event_del(struct perf_event *event, int flags)
+{
+	cgc_event_stop(event, PERF_EF_UPDATE);
+}
+
+static void cgc_event_read(struct perf_event *event)
+{
+	if (!(event->hw.state & PERF_HES_STOPPED))
+		cgc_event_update(event);
+}
+
+static struct pmu cgc_pmu = {
+	.task_ctx_nr	= perf_sw_context,
+	.capabilities	= PERF_PMU_CAP_NO_INTERRUPT,
+	.event_init	= cgc_event_init,
+	.add		= cgc_event_add,
+	.del		= cgc_event_del,
+	.start		= cgc_event_start,
+	.stop		= cgc_event_stop,
+	.read		= cgc_event_read,
+};
+
+static int __init cgc_init(void)
+{
+	return perf_pmu_register(&cgc_pmu, "cgroup_count", -1);
+}
+device_initcall(cgc_init);
@@ -5702,6 +5702,32 @@ perf_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 	return ret;
 }
 
+/*
+ * splice() the records of the event's ring buffer, which must be mmap()ed,
+ * straight into a pipe, see rb_splice_read().
+ */
+static ssize_t perf_splice_read(struct file *file, loff_t *ppos,
+				struct pipe_inode_info *pipe, size_t len,
+				unsigned int flags)
+{
+	struct perf_event *event = file->private_data;
+	struct perf_buffer *rb;
+	ssize_t ret;
+
+	ret = security_perf_event_read(event);
+	if (ret)
+		return ret;
+
+	rb = ring_buffer_get(event);
+	if (!rb)
+		return -EINVAL;
+
+	ret = rb_splice_read(rb, pipe, len);
+	ring_buffer_put(rb);
+
+	return ret;
+}
+
 static __poll_t perf_poll(struct file *file, poll_table *wait)
 {
 	struct perf_event *event = file->private_data;
@@ -6683,6 +6709,7 @@ static const struct file_operations perf_fops = {
 	.llseek			= no_llseek,
 	.release		= perf_release,
 	.read			= perf_read,
+	.splice_read		= perf_splice_read,
 	.poll			= perf_poll,
 	.unlocked_ioctl		= perf_ioctl,
 	.compat_ioctl		= perf_compat_ioctl,
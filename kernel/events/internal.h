@@ -54,6 +54,12 @@ struct perf_buffer {
 	void				**aux_pages;
 	void				*aux_priv;
 
+	/* splice() from the data area, see rb_splice_read() */
+	spinlock_t			splice_lock;
+	u64				splice_pos;
+	unsigned long			splice_inflight;
+	struct pipe_inode_info		*splice_pipe;
+
 	struct perf_event_mmap_page	*user_page;
 	void				*data_pages[];
 };
@@ -96,6 +102,10 @@ void perf_event_aux_event(struct perf_event *event, unsigned long head,
 extern struct page *
 perf_mmap_to_page(struct perf_buffer *rb, unsigned long pgoff);
 
+struct pipe_inode_info;
+extern ssize_t rb_splice_read(struct perf_buffer *rb,
+			      struct pipe_inode_info *pipe, size_t len);
+
 #ifdef CONFIG_PERF_USE_VMALLOC
 /*
  * Back perf_mmap() with vmalloc memory.
@@ -14,6 +14,8 @@
 #include <linux/circ_buf.h>
 #include <linux/poll.h>
 #include <linux/nospec.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/sched/signal.h>
 
 #include "internal.h"
 
@@ -326,6 +328,7 @@ ring_buffer_init(struct perf_buffer *rb, long watermark, int flags)
 
 	INIT_LIST_HEAD(&rb->event_list);
 	spin_lock_init(&rb->event_lock);
+	spin_lock_init(&rb->splice_lock);
 
 	/*
 	 * perf_output_begin() only checks rb->paused, therefore
@@ -967,3 +970,128 @@ perf_mmap_to_page(struct perf_buffer *rb, unsigned long pgoff)
 
 	return __perf_mmap_to_page(rb, pgoff);
 }
+
+#ifndef CONFIG_PERF_USE_VMALLOC
+/*
+ * The data pages spliced into a pipe are only handed back to the writer, by
+ * advancing data_tail, once the pipe reader is done with them. Pipe buffers
+ * are consumed in order and there is only one pipe at a time, so each
+ * release moves data_tail past the oldest outstanding chunk.
+ */
+static void perf_pipe_buf_release(struct pipe_inode_info *pipe,
+				  struct pipe_buffer *buf)
+{
+	struct perf_buffer *rb = (struct perf_buffer *)buf->private;
+	struct perf_event_mmap_page *up = rb->user_page;
+
+	spin_lock(&rb->splice_lock);
+	/* Done reading the data before the writer may overwrite it */
+	smp_store_release(&up->data_tail, READ_ONCE(up->data_tail) + buf->len);
+	if (!--rb->splice_inflight)
+		rb->splice_pipe = NULL;
+	spin_unlock(&rb->splice_lock);
+
+	put_page(buf->page);
+	ring_buffer_put(rb);
+}
+
+/* Duplicates, by tee(), would advance data_tail twice */
+static bool perf_pipe_buf_get(struct pipe_inode_info *pipe,
+			      struct pipe_buffer *buf)
+{
+	return false;
+}
+
+static const struct pipe_buf_operations perf_pipe_buf_ops = {
+	.release	= perf_pipe_buf_release,
+	.get		= perf_pipe_buf_get,
+};
+
+/*
+ * Move up to @len bytes of records from the data area into @pipe without
+ * copying them, on behalf of a consumer which doesn't read the mmap()ed
+ * buffer itself: the pipe gets references to the data pages, which go back
+ * to the writer when it is done with them. Records are passed on as the raw
+ * byte stream found in the buffer and may be split across pipe buffers.
+ *
+ * Only for buffers which are not overwritten, and with one pipe at a time.
+ * Returns -EAGAIN when there is nothing to read, poll() the event first.
+ * Called with the pipe locked.
+ */
+ssize_t rb_splice_read(struct perf_buffer *rb, struct pipe_inode_info *pipe,
+		       size_t len)
+{
+	unsigned long size = perf_data_size(rb);
+	ssize_t ret = 0;
+	u64 head, pos;
+
+	if (rb->overwrite || !rb->nr_pages)
+		return -EINVAL;
+
+	spin_lock(&rb->splice_lock);
+	if (rb->splice_pipe && rb->splice_pipe != pipe) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	/* Nothing outstanding, pick up where the consumer left data_tail */
+	if (!rb->splice_inflight)
+		rb->splice_pos = READ_ONCE(rb->user_page->data_tail);
+	pos = rb->splice_pos;
+
+	head = READ_ONCE(rb->user_page->data_head);
+	/* Order the data reads after the head, pairs with perf_output_put_handle() */
+	smp_rmb();
+
+	while (len && pos != head) {
+		unsigned long off = pos & (size - 1);
+		unsigned int poff = offset_in_page(off);
+		size_t part = min_t(size_t, min_t(u64, head - pos, len),
+				    PAGE_SIZE - poff);
+		struct page *page = virt_to_page(rb->data_pages[off >> PAGE_SHIFT]);
+		struct pipe_buffer *buf;
+
+		if (!pipe->readers) {
+			send_sig(SIGPIPE, current, 0);
+			if (!ret)
+				ret = -EPIPE;
+			break;
+		}
+		if (pipe_full(pipe->head, pipe->tail, pipe->max_usage))
+			break;
+
+		buf = pipe_head_buf(pipe);
+		*buf = (struct pipe_buffer) {
+			.ops		= &perf_pipe_buf_ops,
+			.page		= page,
+			.offset		= poff,
+			.len		= part,
+			.private	= (unsigned long)rb,
+		};
+		get_page(page);
+		refcount_inc(&rb->refcount);
+		pipe->head++;
+
+		rb->splice_inflight++;
+		rb->splice_pipe = pipe;
+		pos += part;
+		len -= part;
+		ret += part;
+	}
+	rb->splice_pos = pos;
+
+	if (!ret && pos == head)
+		ret = -EAGAIN;
+unlock:
+	spin_unlock(&rb->splice_lock);
+
+	return ret;
+}
+#else
+/* The vmalloc() alias of the data area isn't coherent with the pages' own */
+ssize_t rb_splice_read(struct perf_buffer *rb, struct pipe_inode_info *pipe,
+		       size_t len)
+{
+	return -EOPNOTSUPP;
+}
+#endif
@@ -40,6 +40,7 @@ static struct rb_root uprobes_tree = RB_ROOT;
 #define no_uprobe_events()	RB_EMPTY_ROOT(&uprobes_tree)
 
 static DEFINE_SPINLOCK(uprobes_treelock);	/* serialize rbtree access */
+static seqcount_spinlock_t uprobes_seqcount = SEQCNT_SPINLOCK_ZERO(uprobes_seqcount, &uprobes_treelock);
 
 #define UPROBES_HASH_SZ	13
 /* serialize uprobe->pending_list */
@@ -54,6 +55,7 @@ DEFINE_STATIC_PERCPU_RWSEM(dup_mmap_sem);
 struct uprobe {
 	struct rb_node		rb_node;	/* node in the rb tree */
 	refcount_t		ref;
+	struct rcu_head		rcu;		/* freeing, see find_uprobe_rcu() */
 	struct rw_semaphore	register_rwsem;
 	struct rw_semaphore	consumer_rwsem;
 	struct list_head	pending_list;
@@ -604,7 +606,7 @@ static void put_uprobe(struct uprobe *uprobe)
 		mutex_lock(&delayed_uprobe_lock);
 		delayed_uprobe_remove(uprobe, NULL);
 		mutex_unlock(&delayed_uprobe_lock);
-		kfree(uprobe);
+		kfree_rcu(uprobe, rcu);
 	}
 }
 
@@ -676,11 +678,45 @@ static struct uprobe *find_uprobe(struct inode *inode, loff_t offset)
 	return uprobe;
 }
 
+/*
+ * Find a uprobe corresponding to a given inode:offset without taking
+ * uprobes_treelock, for the breakpoint hit path. Lockless tree walks may miss
+ * a node under concurrent rotations, uprobes_seqcount catches those. A uprobe
+ * found this way may already be on its way out, so only take a reference if
+ * it still has one; it is freed by RCU.
+ */
+static struct uprobe *find_uprobe_rcu(struct inode *inode, loff_t offset)
+{
+	struct __uprobe_key key = {
+		.inode = inode,
+		.offset = offset,
+	};
+	struct rb_node *node;
+	unsigned int seq;
+
+	rcu_read_lock();
+	do {
+		seq = read_seqcount_begin(&uprobes_seqcount);
+		node = rb_find_rcu(&key, &uprobes_tree, __uprobe_cmp_key);
+		/* A false positive is not possible, only a miss */
+		if (node)
+			break;
+	} while (read_seqcount_retry(&uprobes_seqcount, seq));
+
+	if (node && !refcount_inc_not_zero(&__node_2_uprobe(node)->ref))
+		node = NULL;
+	rcu_read_unlock();
+
+	return node ? __node_2_uprobe(node) : NULL;
+}
+
 static struct uprobe *__insert_uprobe(struct uprobe *uprobe)
 {
 	struct rb_node *node;
 
-	node = rb_find_add(&uprobe->rb_node, &uprobes_tree, __uprobe_cmp);
+	write_seqcount_begin(&uprobes_seqcount);
+	node = rb_find_add_rcu(&uprobe->rb_node, &uprobes_tree, __uprobe_cmp);
+	write_seqcount_end(&uprobes_seqcount);
 	if (node)
 		return get_uprobe(__node_2_uprobe(node));
 
@@ -718,10 +754,10 @@ ref_ctr_mismatch_warn(struct uprobe *cur_uprobe, struct uprobe *uprobe)
 		(unsigned long long) uprobe->ref_ctr_offset);
 }
 
-static struct uprobe *alloc_uprobe(struct inode *inode, loff_t offset,
-				   loff_t ref_ctr_offset)
+static struct uprobe *__alloc_uprobe(struct inode *inode, loff_t offset,
+				     loff_t ref_ctr_offset)
 {
-	struct uprobe *uprobe, *cur_uprobe;
+	struct uprobe *uprobe;
 
 	uprobe = kzalloc(sizeof(struct uprobe), GFP_KERNEL);
 	if (!uprobe)
@@ -733,6 +769,18 @@ static struct uprobe *alloc_uprobe(struct inode *inode, loff_t offset,
 	init_rwsem(&uprobe->register_rwsem);
 	init_rwsem(&uprobe->consumer_rwsem);
 
+	return uprobe;
+}
+
+static struct uprobe *alloc_uprobe(struct inode *inode, loff_t offset,
+				   loff_t ref_ctr_offset)
+{
+	struct uprobe *uprobe, *cur_uprobe;
+
+	uprobe = __alloc_uprobe(inode, offset, ref_ctr_offset);
+	if (!uprobe)
+		return NULL;
+
 	/* add to uprobes_tree, sorted on inode:offset */
 	cur_uprobe = insert_uprobe(uprobe);
 	/* a uprobe exists for this inode:offset combination */
@@ -936,7 +984,9 @@ static void delete_uprobe(struct uprobe *uprobe)
 		return;
 
 	spin_lock(&uprobes_treelock);
+	write_seqcount_begin(&uprobes_seqcount);
 	rb_erase(&uprobe->rb_node, &uprobes_tree);
+	write_seqcount_end(&uprobes_seqcount);
 	spin_unlock(&uprobes_treelock);
 	RB_CLEAR_NODE(&uprobe->rb_node); /* for uprobe_is_active() */
 	put_uprobe(uprobe);
@@ -1114,6 +1164,53 @@ void uprobe_unregister(struct inode *inode, loff_t offset, struct uprobe_consume
 }
 EXPORT_SYMBOL_GPL(uprobe_unregister);
 
+static int uprobe_check_register(struct inode *inode, loff_t offset,
+				 loff_t ref_ctr_offset, struct uprobe_consumer *uc)
+{
+	/* Uprobe must have at least one set consumer */
+	if (!uc->handler && !uc->ret_handler)
+		return -EINVAL;
+
+	/* copy_insn() uses read_mapping_page() or shmem_read_mapping_page() */
+	if (!inode->i_mapping->a_ops->read_folio &&
+	    !shmem_mapping(inode->i_mapping))
+		return -EIO;
+	/* Racy, just to catch the obvious mistakes */
+	if (offset > i_size_read(inode))
+		return -EINVAL;
+
+	/*
+	 * This ensures that copy_from_page(), copy_to_page() and
+	 * __update_ref_ctr() can't cross page boundary.
+	 */
+	if (!IS_ALIGNED(offset, UPROBE_SWBP_INSN_SIZE))
+		return -EINVAL;
+	if (!IS_ALIGNED(ref_ctr_offset, sizeof(short)))
+		return -EINVAL;
+
+	return 0;
+}
+
+/*
+ * We can race with uprobe_unregister()->delete_uprobe(), in which case
+ * -EAGAIN is returned and the caller has to look @uprobe up again.
+ */
+static int uprobe_add_consumer(struct uprobe *uprobe, struct uprobe_consumer *uc)
+{
+	int ret = -EAGAIN;
+
+	down_write(&uprobe->register_rwsem);
+	if (likely(uprobe_is_active(uprobe))) {
+		consumer_add(uprobe, uc);
+		ret = register_for_each_vma(uprobe, uc);
+		if (ret)
+			__uprobe_unregister(uprobe, uc);
+	}
+	up_write(&uprobe->register_rwsem);
+
+	return ret;
+}
+
 /*
  * __uprobe_register - register a probe
  * @inode: the file in which the probe has to be placed.
@@ -1138,26 +1235,9 @@ static int __uprobe_register(struct inode *inode, loff_t offset,
 	struct uprobe *uprobe;
 	int ret;
 
-	/* Uprobe must have at least one set consumer */
-	if (!uc->handler && !uc->ret_handler)
-		return -EINVAL;
-
-	/* copy_insn() uses read_mapping_page() or shmem_read_mapping_page() */
-	if (!inode->i_mapping->a_ops->read_folio &&
-	    !shmem_mapping(inode->i_mapping))
-		return -EIO;
-	/* Racy, just to catch the obvious mistakes */
-	if (offset > i_size_read(inode))
-		return -EINVAL;
-
-	/*
-	 * This ensures that copy_from_page(), copy_to_page() and
-	 * __update_ref_ctr() can't cross page boundary.
-	 */
-	if (!IS_ALIGNED(offset, UPROBE_SWBP_INSN_SIZE))
-		return -EINVAL;
-	if (!IS_ALIGNED(ref_ctr_offset, sizeof(short)))
-		return -EINVAL;
+	ret = uprobe_check_register(inode, offset, ref_ctr_offset, uc);
+	if (ret)
+		return ret;
 
  retry:
 	uprobe = alloc_uprobe(inode, offset, ref_ctr_offset);
@@ -1166,19 +1246,7 @@ static int __uprobe_register(struct inode *inode, loff_t offset,
 	if (IS_ERR(uprobe))
 		return PTR_ERR(uprobe);
 
-	/*
-	 * We can race with uprobe_unregister()->delete_uprobe().
-	 * Check uprobe_is_active() and retry if it is false.
-	 */
-	down_write(&uprobe->register_rwsem);
-	ret = -EAGAIN;
-	if (likely(uprobe_is_active(uprobe))) {
-		consumer_add(uprobe, uc);
-		ret = register_for_each_vma(uprobe, uc);
-		if (ret)
-			__uprobe_unregister(uprobe, uc);
-	}
-	up_write(&uprobe->register_rwsem);
+	ret = uprobe_add_consumer(uprobe, uc);
 	put_uprobe(uprobe);
 
 	if (unlikely(ret == -EAGAIN))
@@ -1200,6 +1268,117 @@ int uprobe_register_refctr(struct inode *inode, loff_t offset,
 }
 EXPORT_SYMBOL_GPL(uprobe_register_refctr);
 
+/* Drop our reference to @uprobe, and @uprobe itself if we created it for nothing */
+static void uprobe_drop_unused(struct uprobe *uprobe)
+{
+	down_write(&uprobe->register_rwsem);
+	if (!uprobe->consumers && uprobe_is_active(uprobe))
+		delete_uprobe(uprobe);
+	up_write(&uprobe->register_rwsem);
+	put_uprobe(uprobe);
+}
+
+/*
+ * uprobe_register_batch - register probes at several offsets of a file
+ * @inode: the file in which the probes have to be placed.
+ * @regs: the offsets, reference counter offsets and consumers of the probes.
+ * @cnt: number of entries in @regs.
+ *
+ * Like calling uprobe_register_refctr() for each entry of @regs, but all the
+ * uprobes are looked up and inserted into the tree in a single
+ * uprobes_treelock critical section. Either all probes are registered or, on
+ * error, none.
+ */
+int uprobe_register_batch(struct inode *inode, struct uprobe_reg *regs, int cnt)
+{
+	struct uprobe **uprobes, *cur_uprobe;
+	int i, j, ret = 0;
+
+	for (i = 0; i < cnt; i++) {
+		ret = uprobe_check_register(inode, regs[i].offset,
+					    regs[i].ref_ctr_offset, regs[i].uc);
+		if (ret)
+			return ret;
+	}
+
+	uprobes = kvcalloc(cnt, sizeof(*uprobes), GFP_KERNEL);
+	if (!uprobes)
+		return -ENOMEM;
+
+	for (i = 0; i < cnt; i++) {
+		uprobes[i] = __alloc_uprobe(inode, regs[i].offset,
+					    regs[i].ref_ctr_offset);
+		if (!uprobes[i]) {
+			while (--i >= 0)
+				kfree(uprobes[i]);
+			kvfree(uprobes);
+			return -ENOMEM;
+		}
+	}
+
+	spin_lock(&uprobes_treelock);
+	for (i = 0; i < cnt; i++) {
+		cur_uprobe = __insert_uprobe(uprobes[i]);
+		if (cur_uprobe) {
+			kfree(uprobes[i]);
+			uprobes[i] = cur_uprobe;
+		}
+	}
+	spin_unlock(&uprobes_treelock);
+
+	for (i = 0; i < cnt; i++) {
+		struct uprobe *uprobe = uprobes[i];
+
+		uprobes[i] = NULL;
+		if (uprobe->ref_ctr_offset != regs[i].ref_ctr_offset) {
+			pr_warn("ref_ctr_offset mismatch. inode: 0x%lx offset: 0x%llx "
+				"ref_ctr_offset(old): 0x%llx ref_ctr_offset(new): 0x%llx\n",
+				inode->i_ino, (unsigned long long) regs[i].offset,
+				(unsigned long long) uprobe->ref_ctr_offset,
+				(unsigned long long) regs[i].ref_ctr_offset);
+			uprobe_drop_unused(uprobe);
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = uprobe_add_consumer(uprobe, regs[i].uc);
+		put_uprobe(uprobe);
+		/* Lost a race with the unregistration of an existing uprobe */
+		if (unlikely(ret == -EAGAIN))
+			ret = __uprobe_register(inode, regs[i].offset,
+						regs[i].ref_ctr_offset,
+						regs[i].uc);
+		if (ret)
+			break;
+	}
+
+	if (ret) {
+		for (j = i + 1; j < cnt; j++)
+			uprobe_drop_unused(uprobes[j]);
+		while (--i >= 0)
+			uprobe_unregister(inode, regs[i].offset, regs[i].uc);
+	}
+
+	kvfree(uprobes);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(uprobe_register_batch);
+
+/*
+ * uprobe_unregister_batch - unregister probes registered by uprobe_register_batch()
+ * @inode: the file in which the probes have to be removed.
+ * @regs: the same entries as passed to uprobe_register_batch().
+ * @cnt: number of entries in @regs.
+ */
+void uprobe_unregister_batch(struct inode *inode, struct uprobe_reg *regs, int cnt)
+{
+	int i;
+
+	for (i = 0; i < cnt; i++)
+		uprobe_unregister(inode, regs[i].offset, regs[i].uc);
+}
+EXPORT_SYMBOL_GPL(uprobe_unregister_batch);
+
 /*
  * uprobe_apply - unregister an already registered probe.
  * @inode: the file in which the probe has to be removed.
@@ -2049,7 +2228,7 @@ static struct uprobe *find_active_uprobe(unsigned long bp_vaddr, int *is_swbp)
 			struct inode *inode = file_inode(vma->vm_file);
 			loff_t offset = vaddr_to_offset(vma, bp_vaddr);
 
-			uprobe = find_uprobe(inode, offset);
+			uprobe = find_uprobe_rcu(inode, offset);
 		}
 
 		if (!uprobe)
@@ -199,6 +199,29 @@ static inline void free_task_struct(struct task_struct *tsk)
 #define NR_CACHED_STACKS 2
 static DEFINE_PER_CPU(struct vm_struct *, cached_stacks[NR_CACHED_STACKS]);
 
+/*
+ * Even a cached stack still has to be cleared when it is reused. With
+ * fork_stack_cache=<n>, each CPU also keeps up to n stacks which are allocated
+ * and cleared ahead of time by a work item, so that bursts of thread creation
+ * get a ready stack without vmalloc() or memset().
+ */
+#define NR_ZEROED_STACKS_MAX 16
+static DEFINE_PER_CPU(struct vm_struct *, zeroed_stacks[NR_ZEROED_STACKS_MAX]);
+static DEFINE_PER_CPU(struct work_struct, zeroed_stacks_work);
+static unsigned int nr_zeroed_stacks __ro_after_init;
+
+static int __init fork_stack_cache_setup(char *str)
+{
+	unsigned int val;
+
+	if (kstrtouint(str, 0, &val))
+		return 0;
+
+	nr_zeroed_stacks = min_t(unsigned int, val, NR_ZEROED_STACKS_MAX);
+	return 1;
+}
+__setup("fork_stack_cache=", fork_stack_cache_setup);
+
 struct vm_stack {
 	struct rcu_head rcu;
 	struct vm_struct *stack_vm_area;
@@ -249,9 +272,83 @@ static int free_vm_stack_cache(unsigned int cpu)
 		cached_vm_stacks[i] = NULL;
 	}
 
+	for (i = 0; i < nr_zeroed_stacks; i++) {
+		struct vm_struct *vm_stack = per_cpu(zeroed_stacks[i], cpu);
+
+		if (!vm_stack)
+			continue;
+
+		vfree(vm_stack->addr);
+		per_cpu(zeroed_stacks[i], cpu) = NULL;
+	}
+
 	return 0;
 }
 
+static __always_inline void *alloc_vm_stack(int node)
+{
+	/*
+	 * Allocated stacks are cached and later reused by new threads,
+	 * so memcg accounting is performed manually on assigning/releasing
+	 * stacks to tasks. Drop __GFP_ACCOUNT.
+	 */
+	return __vmalloc_node_range(THREAD_SIZE, THREAD_ALIGN,
+				    VMALLOC_START, VMALLOC_END,
+				    THREADINFO_GFP & ~__GFP_ACCOUNT,
+				    PAGE_KERNEL,
+				    0, node, __builtin_return_address(0));
+}
+
+/* Runs on the CPU whose zeroed_stacks are refilled, unless it went offline */
+static void zeroed_stacks_refill(struct work_struct *work)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr_zeroed_stacks; i++) {
+		void *stack;
+
+		if (this_cpu_read(zeroed_stacks[i]))
+			continue;
+
+		/* THREADINFO_GFP has __GFP_ZERO */
+		stack = alloc_vm_stack(numa_node_id());
+		if (!stack)
+			break;
+
+		if (this_cpu_cmpxchg(zeroed_stacks[i], NULL,
+				     find_vm_area(stack)) != NULL)
+			vfree(stack);
+	}
+}
+
+static struct vm_struct *get_zeroed_stack(void)
+{
+	struct vm_struct *s = NULL;
+	struct work_struct *work;
+	int i, cpu;
+
+	if (!nr_zeroed_stacks)
+		return NULL;
+
+	/* The refill fills the pool from the bottom, so take from the top */
+	for (i = nr_zeroed_stacks - 1; i >= 0; i--) {
+		s = this_cpu_xchg(zeroed_stacks[i], NULL);
+		if (s)
+			break;
+	}
+
+	/* Refill in batches, once about half of the pool is used up */
+	if (i <= (int)nr_zeroed_stacks / 2) {
+		cpu = get_cpu();
+		work = per_cpu_ptr(&zeroed_stacks_work, cpu);
+		if (!work_pending(work))
+			schedule_work_on(cpu, work);
+		put_cpu();
+	}
+
+	return s;
+}
+
 static int memcg_charge_kernel_stack(struct vm_struct *vm)
 {
 	int i;
@@ -273,48 +370,48 @@ static int memcg_charge_kernel_stack(struct vm_struct *vm)
 	return ret;
 }
 
-static int alloc_thread_stack_node(struct task_struct *tsk, int node)
+/* Give @tsk a stack taken from a per-cpu cache, @reused if it ran before */
+static int assign_cached_stack(struct task_struct *tsk, struct vm_struct *s,
+			       bool reused)
 {
-	struct vm_struct *vm;
 	void *stack;
-	int i;
 
-	for (i = 0; i < NR_CACHED_STACKS; i++) {
-		struct vm_struct *s;
+	/* Reset stack metadata. */
+	kasan_unpoison_range(s->addr, THREAD_SIZE);
 
-		s = this_cpu_xchg(cached_stacks[i], NULL);
+	stack = kasan_reset_tag(s->addr);
 
-		if (!s)
-			continue;
+	/* Clear stale pointers from reused stack. */
+	if (reused)
+		memset(stack, 0, THREAD_SIZE);
 
-		/* Reset stack metadata. */
-		kasan_unpoison_range(s->addr, THREAD_SIZE);
+	if (memcg_charge_kernel_stack(s)) {
+		vfree(s->addr);
+		return -ENOMEM;
+	}
 
-		stack = kasan_reset_tag(s->addr);
+	tsk->stack_vm_area = s;
+	tsk->stack = stack;
+	return 0;
+}
 
-		/* Clear stale pointers from reused stack. */
-		memset(stack, 0, THREAD_SIZE);
+static int alloc_thread_stack_node(struct task_struct *tsk, int node)
+{
+	struct vm_struct *vm;
+	void *stack;
+	int i;
 
-		if (memcg_charge_kernel_stack(s)) {
-			vfree(s->addr);
-			return -ENOMEM;
-		}
+	vm = get_zeroed_stack();
+	if (vm)
+		return assign_cached_stack(tsk, vm, false);
 
-		tsk->stack_vm_area = s;
-		tsk->stack = stack;
-		return 0;
+	for (i = 0; i < NR_CACHED_STACKS; i++) {
+		vm = this_cpu_xchg(cached_stacks[i], NULL);
+		if (vm)
+			return assign_cached_stack(tsk, vm, true);
 	}
 
-	/*
-	 * Allocated stacks are cached and later reused by new threads,
-	 * so memcg accounting is performed manually on assigning/releasing
-	 * stacks to tasks. Drop __GFP_ACCOUNT.
-	 */
-	stack = __vmalloc_node_range(THREAD_SIZE, THREAD_ALIGN,
-				     VMALLOC_START, VMALLOC_END,
-				     THREADINFO_GFP & ~__GFP_ACCOUNT,
-				     PAGE_KERNEL,
-				     0, node, __builtin_return_address(0));
+	stack = alloc_vm_stack(node);
 	if (!stack)
 		return -ENOMEM;
 
@@ -929,6 +1026,7 @@ void __mmdrop(struct mm_struct *mm)
 	mm_pasid_drop(mm);
 	mm_destroy_cid(mm);
 	percpu_counter_destroy_many(mm->rss_stat, NR_MM_COUNTERS);
+	futex_private_hash_free(mm);
 
 	free_mm(mm);
 }
@@ -1078,6 +1176,9 @@ void __init fork_init(void)
 #ifdef CONFIG_VMAP_STACK
 	cpuhp_setup_state(CPUHP_BP_PREPARE_DYN, "fork:vm_stack_cache",
 			  NULL, free_vm_stack_cache);
+	for_each_possible_cpu(i)
+		INIT_WORK(per_cpu_ptr(&zeroed_stacks_work, i),
+			  zeroed_stacks_refill);
 #endif
 
 	scs_init();
@@ -1287,6 +1388,7 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p,
 #endif
 	mm_init_uprobes_state(mm);
 	hugetlb_count_init(mm);
+	futex_mm_init(mm);
 
 	if (current->mm) {
 		mm->flags = mmf_init_flags(current->mm->flags);
@@ -2395,6 +2497,9 @@ __latent_entropy struct task_struct *copy_process(
 	retval = copy_signal(clone_flags, p);
 	if (retval)
 		goto bad_fork_cleanup_sighand;
+	/* Must happen while the caller is still the only user of its mm */
+	if ((clone_flags & CLONE_THREAD) && current->mm)
+		futex_private_hash_install(current->mm);
 	retval = copy_mm(clone_flags, p);
 	if (retval)
 		goto bad_fork_cleanup_signal;
@@ -54,6 +54,25 @@ static struct {
 #define futex_queues   (__futex_data.queues)
 #define futex_hashsize (__futex_data.hashsize)
 
+/*
+ * With futex_private_hash=1, PTHREAD_PROCESS_PRIVATE futexes of a
+ * multi-threaded process are hashed into a table of its own, allocated on
+ * the node that created the first thread, rather than into the global
+ * futex_queues where unrelated processes collide.
+ */
+struct futex_private_hash {
+	unsigned int			hashmask;
+	struct futex_hash_bucket	queues[];
+};
+
+static bool futex_private_hash_enabled __ro_after_init;
+
+static int __init setup_futex_private_hash(char *str)
+{
+	return kstrtobool(str, &futex_private_hash_enabled) == 0;
+}
+__setup("futex_private_hash=", setup_futex_private_hash);
+
 
 /*
  * Fault injections for futexes.
@@ -107,17 +126,26 @@ late_initcall(fail_futex_debugfs);
 #endif /* CONFIG_FAIL_FUTEX */
 
 /**
- * futex_hash - Return the hash bucket in the global hash
+ * futex_hash - Return the hash bucket for a futex key
  * @key:	Pointer to the futex key for which the hash is calculated
  *
  * We hash on the keys returned from get_futex_key (see below) and return the
- * corresponding hash bucket in the global hash.
+ * corresponding hash bucket in the global hash, or in the mm's own hash for
+ * private futexes if it has one.
  */
 struct futex_hash_bucket *futex_hash(union futex_key *key)
 {
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
 
+	if (!(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED))) {
+		struct futex_private_hash *ph;
+
+		ph = READ_ONCE(key->private.mm->futex_phash);
+		if (ph)
+			return &ph->queues[hash & ph->hashmask];
+	}
+
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
 
@@ -1145,6 +1173,64 @@ void futex_exit_release(struct task_struct *tsk)
 	futex_cleanup_end(tsk, FUTEX_STATE_DEAD);
 }
 
+static void futex_hash_bucket_init(struct futex_hash_bucket *hb)
+{
+	atomic_set(&hb->waiters, 0);
+	plist_head_init(&hb->chain);
+	spin_lock_init(&hb->lock);
+}
+
+/**
+ * futex_private_hash_install - Give @mm its own private futex hash
+ * @mm:		mm about to get a second user
+ *
+ * Called before a CLONE_THREAD child is created.  Switching hashes is only
+ * safe while no private futex of @mm can have waiters, that is while the
+ * caller is the only user of @mm and has no io_uring context, whose futex
+ * waits stay queued without a thread blocking on them.  The table is sized
+ * for the CPUs the caller may run on and is kept until @mm is freed.
+ * Failing to allocate it simply keeps @mm on the global hash.
+ */
+void futex_private_hash_install(struct mm_struct *mm)
+{
+	struct futex_private_hash *ph;
+	unsigned int i, size;
+
+	if (!futex_private_hash_enabled || mm->futex_phash ||
+	    atomic_read(&mm->mm_users) != 1)
+		return;
+
+#ifdef CONFIG_IO_URING
+	/* Async waiters may already sit in the global hash */
+	if (current->io_uring)
+		return;
+#endif
+
+	size = max(16U, 4 * cpumask_weight(current->cpus_ptr));
+	size = min_t(unsigned int, roundup_pow_of_two(size), futex_hashsize);
+
+	ph = kvzalloc_node(struct_size(ph, queues, size), GFP_KERNEL_ACCOUNT,
+			   numa_node_id());
+	if (!ph)
+		return;
+
+	ph->hashmask = size - 1;
+	for (i = 0; i < size; i++)
+		futex_hash_bucket_init(&ph->queues[i]);
+
+	WRITE_ONCE(mm->futex_phash, ph);
+}
+
+void futex_mm_init(struct mm_struct *mm)
+{
+	mm->futex_phash = NULL;
+}
+
+void futex_private_hash_free(struct mm_struct *mm)
+{
+	kvfree(mm->futex_phash);
+}
+
 static int __init futex_init(void)
 {
 	unsigned int futex_shift;
@@ -1162,11 +1248,8 @@ static int __init futex_init(void)
 					       futex_hashsize, futex_hashsize);
 	futex_hashsize = 1UL << futex_shift;
 
-	for (i = 0; i < futex_hashsize; i++) {
-		atomic_set(&futex_queues[i].waiters, 0);
-		plist_head_init(&futex_queues[i].chain);
-		spin_lock_init(&futex_queues[i].lock);
-	}
+	for (i = 0; i < futex_hashsize; i++)
+		futex_hash_bucket_init(&futex_queues[i]);
 
 	return 0;
 }
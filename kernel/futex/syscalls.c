@@ -354,6 +354,45 @@ SYSCALL_DEFINE4(futex_wake,
 	return futex_wake(uaddr, FLAGS_STRICT | flags, nr, mask);
 }
 
+/*
+ * sys_futex_wakev - Wake waiters on a list of futexes
+ * @waiters:	List of futexes to wake, with the number of waiters to wake
+ *		on each in ->val
+ * @nr_futexes:	Length of the list, up to FUTEX_WAITV_MAX
+ * @flags:	unused
+ *
+ * Equivalent to a FUTEX_WAKE of each futex in the list, but every hash
+ * bucket lock is taken once.
+ *
+ * Returns the total number of waiters woken, or an error code.
+ */
+
+SYSCALL_DEFINE3(futex_wakev, struct futex_waitv __user *, waiters,
+		unsigned int, nr_futexes, unsigned int, flags)
+{
+	struct futex_vector *futexv;
+	int ret;
+
+	/* This syscall supports no flags for now */
+	if (flags)
+		return -EINVAL;
+
+	if (!nr_futexes || nr_futexes > FUTEX_WAITV_MAX || !waiters)
+		return -EINVAL;
+
+	futexv = kcalloc(nr_futexes, sizeof(*futexv), GFP_KERNEL);
+	if (!futexv)
+		return -ENOMEM;
+
+	ret = futex_parse_waitv(futexv, waiters, nr_futexes, futex_wake_mark,
+				NULL);
+	if (!ret)
+		ret = futex_wake_multiple(futexv, nr_futexes);
+
+	kfree(futexv);
+	return ret;
+}
+
 /*
  * sys_futex_wait - Wait on a futex
  * @uaddr:	Address of the futex to wait on
@@ -438,6 +477,63 @@ SYSCALL_DEFINE4(futex_requeue,
 			     nr_wake, nr_requeue, &cmpval, 0);
 }
 
+/*
+ * sys_futex_requeuev - Requeue waiters between several pairs of futexes
+ * @waiters:	array of 2 * @nr_pairs entries, each pair describing a source
+ *		and destination futex as for sys_futex_requeue()
+ * @nr_pairs:	number of pairs, up to FUTEX_WAITV_MAX / 2
+ * @flags:	unused
+ * @nr_wake:	number of futexes to wake on each source futex
+ * @nr_requeue:	number of futexes to requeue from each source futex
+ *
+ * The pairs are processed in order, each with the two bucket locks taken
+ * once, and processing stops at the first pair that fails.  Returns the
+ * total number of waiters woken or requeued, or an error code if that is
+ * zero.
+ */
+
+SYSCALL_DEFINE5(futex_requeuev,
+		struct futex_waitv __user *, waiters,
+		unsigned int, nr_pairs,
+		unsigned int, flags,
+		int, nr_wake,
+		int, nr_requeue)
+{
+	struct futex_vector *futexv;
+	unsigned int i;
+	int ret, total = 0;
+
+	if (flags)
+		return -EINVAL;
+
+	if (!nr_pairs || nr_pairs > FUTEX_WAITV_MAX / 2 || !waiters)
+		return -EINVAL;
+
+	futexv = kcalloc(2 * nr_pairs, sizeof(*futexv), GFP_KERNEL);
+	if (!futexv)
+		return -ENOMEM;
+
+	ret = futex_parse_waitv(futexv, waiters, 2 * nr_pairs, futex_wake_mark,
+				NULL);
+	if (ret)
+		goto out;
+
+	for (i = 0; i < nr_pairs; i++) {
+		struct futex_vector *src = &futexv[2 * i], *dst = src + 1;
+		u32 cmpval = src->w.val;
+
+		ret = futex_requeue(u64_to_user_ptr(src->w.uaddr), src->w.flags,
+				    u64_to_user_ptr(dst->w.uaddr), dst->w.flags,
+				    nr_wake, nr_requeue, &cmpval, 0);
+		if (ret < 0)
+			break;
+		total += ret;
+	}
+out:
+	kfree(futexv);
+	return total ? total : ret;
+}
+
 #ifdef CONFIG_COMPAT
 COMPAT_SYSCALL_DEFINE2(set_robust_list,
 		struct compat_robust_list_head __user *, head,
@@ -149,13 +149,42 @@ void futex_wake_mark(struct wake_q_head *wake_q, struct futex_q *q)
 	wake_q_add_safe(wake_q, p);
 }
 
+/*
+ * Mark up to @nr_wake waiters on @key matching @bitset for wakeup. Returns the
+ * number of waiters marked, or -EINVAL if a PI waiter is found on @key.
+ */
+static int futex_wake_locked(struct futex_hash_bucket *hb, union futex_key *key,
+			     int nr_wake, u32 bitset, struct wake_q_head *wake_q)
+{
+	struct futex_q *this, *next;
+	int ret = 0;
+
+	lockdep_assert_held(&hb->lock);
+
+	plist_for_each_entry_safe(this, next, &hb->chain, list) {
+		if (futex_match (&this->key, key)) {
+			if (this->pi_state || this->rt_waiter)
+				return -EINVAL;
+
+			/* Check if one of the bits is set in both bitsets */
+			if (!(this->bitset & bitset))
+				continue;
+
+			this->wake(wake_q, this);
+			if (++ret >= nr_wake)
+				break;
+		}
+	}
+
+	return ret;
+}
+
 /*
  * Wake up waiters matching bitset queued on this futex (uaddr).
  */
 int futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset)
 {
 	struct futex_hash_bucket *hb;
-	struct futex_q *this, *next;
 	union futex_key key = FUTEX_KEY_INIT;
 	DEFINE_WAKE_Q(wake_q);
 	int ret;
@@ -177,27 +206,72 @@ int futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset)
 		return ret;
 
 	spin_lock(&hb->lock);
+	ret = futex_wake_locked(hb, &key, nr_wake, bitset, &wake_q);
+	spin_unlock(&hb->lock);
+	wake_up_q(&wake_q);
+	return ret;
+}
 
-	plist_for_each_entry_safe(this, next, &hb->chain, list) {
-		if (futex_match (&this->key, &key)) {
-			if (this->pi_state || this->rt_waiter) {
-				ret = -EINVAL;
-				break;
-			}
+/**
+ * futex_wake_multiple - Wake waiters on a list of futexes
+ * @vs:		The futex list, ->w.val is the number of waiters to wake on each
+ * @count:	The size of the list
+ *
+ * All futexes that hash to the same bucket are handled under a single
+ * acquisition of its lock, and all waiters are woken together at the end.
+ *
+ * Return: The total number of waiters woken, or an error code if nothing was
+ * woken and a key could not be set up or a futex has PI waiters.
+ */
+int futex_wake_multiple(struct futex_vector *vs, unsigned int count)
+{
+	DECLARE_BITMAP(done, FUTEX_WAITV_MAX) = { };
+	struct futex_hash_bucket *hb;
+	DEFINE_WAKE_Q(wake_q);
+	int i, j, ret, woken = 0, err = 0;
 
-			/* Check if one of the bits is set in both bitsets */
-			if (!(this->bitset & bitset))
+	for (i = 0; i < count; i++) {
+		ret = get_futex_key(u64_to_user_ptr(vs[i].w.uaddr),
+				    vs[i].w.flags, &vs[i].q.key, FUTEX_READ);
+		if (unlikely(ret))
+			return ret;
+
+		/* The waiter is never queued, reuse its lock pointer */
+		vs[i].q.lock_ptr = &futex_hash(&vs[i].q.key)->lock;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (test_bit(i, done))
+			continue;
+
+		hb = container_of(vs[i].q.lock_ptr, struct futex_hash_bucket, lock);
+		if (!futex_hb_waiters_pending(hb)) {
+			__set_bit(i, done);
+			continue;
+		}
+
+		spin_lock(&hb->lock);
+		for (j = i; j < count; j++) {
+			if (test_bit(j, done) || vs[j].q.lock_ptr != &hb->lock)
 				continue;
+			__set_bit(j, done);
 
-			this->wake(&wake_q, this);
-			if (++ret >= nr_wake)
-				break;
+			if (!vs[j].w.val)
+				continue;
+
+			ret = futex_wake_locked(hb, &vs[j].q.key,
+						min_t(u64, vs[j].w.val, INT_MAX),
+						FUTEX_BITSET_MATCH_ANY, &wake_q);
+			if (ret < 0)
+				err = ret;
+			else
+				woken += ret;
 		}
+		spin_unlock(&hb->lock);
 	}
 
-	spin_unlock(&hb->lock);
 	wake_up_q(&wake_q);
-	return ret;
+	return woken ? woken : err;
 }
 
 static int futex_atomic_op_inuser(unsigned int encoded_op, u32 __user *uaddr)
@@ -0,0 +1,392 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Lockdep-free lock contention profiler
+ *
+ * lock_stat needs full lockdep, which is far too heavy for production. This
+ * profiler instead attaches to the lock:contention_begin and
+ * lock:contention_end tracepoints, which the mutex, rwsem, percpu-rwsem,
+ * semaphore, rtmutex, qspinlock and qrwlock slowpaths already emit, and keeps
+ * a per-cpu table of wait time statistics keyed by lock address.
+ *
+ * The tracepoints are static keys, so nothing is paid until the profiler is
+ * enabled through <debugfs>/lock_contention/enable. Only contended
+ * acquisitions ever reach it, and each one costs two local_clock() reads and
+ * a lookup in a small per-cpu hash table with interrupts disabled.
+ *
+ * <debugfs>/lock_contention/stats shows, for each contended lock, the number
+ * of contended acquisitions, the total and maximum wait time in nanoseconds
+ * and a log2 histogram of wait times starting at 1us. Static locks are shown
+ * by symbol. Writing to the file clears the statistics.
+ */
+
+#define pr_fmt(fmt) "lock_contention: " fmt
+
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/hash.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <trace/events/lock.h>
+
+#define LC_HASH_BITS		9
+#define LC_HASH_SIZE		(1U << LC_HASH_BITS)
+#define LC_HASH_PROBES		8
+#define LC_HIST_BUCKETS		16
+#define LC_HIST_SHIFT		10	/* first bucket: below ~1us */
+
+struct lc_entry {
+	unsigned long	lock;
+	unsigned int	flags;
+	u64		count;
+	u64		total_ns;
+	u64		max_ns;
+	u32		hist[LC_HIST_BUCKETS];
+};
+
+struct lc_table {
+	unsigned long	dropped;
+	struct lc_entry	entries[LC_HASH_SIZE];
+};
+
+/* Too big for the percpu allocator, so each cpu's table is kvmalloc'ed */
+static DEFINE_PER_CPU(struct lc_table *, lc_tables);
+static bool lc_allocated;
+
+/* In-flight contention outside of task context: softirq and hardirq */
+static DEFINE_PER_CPU(struct lock_contention_wait, lc_irq_waits[2]);
+static DEFINE_MUTEX(lc_mutex);
+static bool lc_enabled;
+static unsigned int lc_gen;	/* invalidates in-flight waits on (re)enable */
+
+static inline struct lock_contention_wait *lc_get_wait(void)
+{
+	if (in_task())
+		return &current->contention_wait;
+
+	return this_cpu_ptr(&lc_irq_waits[interrupt_context_level() - 1]);
+}
+
+/*
+ * Waits nest: a mutex waiter can contend on the mutex's wait_lock, and an
+ * interrupted irq context can contend on another lock. Keep a small stack of
+ * in-flight waits per context so that the outer wait is not lost.
+ */
+static void lc_contention_begin(void *data, void *lock, unsigned int flags)
+{
+	struct lock_contention_frame *f;
+	struct lock_contention_wait *w;
+	unsigned int gen = READ_ONCE(lc_gen);
+
+	if (in_nmi())
+		return;
+
+	w = lc_get_wait();
+
+	/* Drop frames left over from before the profiler was (re)enabled */
+	if (w->depth && w->frames[w->depth - 1].gen != gen)
+		w->depth = 0;
+
+	/* Mutexes report the switch from spinning to sleeping as a new begin */
+	if (w->depth && w->frames[w->depth - 1].lock == lock)
+		return;
+
+	if (w->depth == LOCK_CONTENTION_DEPTH)
+		return;
+
+	f = &w->frames[w->depth];
+	f->start = local_clock();
+	f->flags = flags;
+	f->gen = gen;
+	f->lock = lock;
+	barrier();	/* publish the frame before an interrupt can see it */
+	w->depth++;
+}
+
+static struct lc_entry *lc_lookup(struct lc_table *t, unsigned long lock)
+{
+	unsigned int i, idx = hash_long(lock, LC_HASH_BITS);
+
+	for (i = 0; i < LC_HASH_PROBES; i++) {
+		struct lc_entry *e = &t->entries[(idx + i) & (LC_HASH_SIZE - 1)];
+
+		if (e->lock == lock)
+			return e;
+		if (!e->lock) {
+			e->lock = lock;
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+static void lc_contention_end(void *data, void *lock, int ret)
+{
+	struct lock_contention_wait *w;
+	struct lc_table *t;
+	struct lc_entry *e;
+	unsigned long irqflags;
+	unsigned int depth, flags;
+	int bucket;
+	u64 delta;
+
+	if (in_nmi())
+		return;
+
+	w = lc_get_wait();
+	for (depth = w->depth; depth; depth--) {
+		if (w->frames[depth - 1].lock == lock)
+			break;
+	}
+	if (!depth)
+		return;
+
+	/* Any frame above the matching one lost its end, discard it too */
+	w->depth = depth - 1;
+	if (w->frames[depth - 1].gen != READ_ONCE(lc_gen))
+		return;
+
+	delta = local_clock() - w->frames[depth - 1].start;
+	flags = w->frames[depth - 1].flags;
+	bucket = delta >> LC_HIST_SHIFT ? ilog2(delta >> LC_HIST_SHIFT) + 1 : 0;
+	bucket = min(bucket, LC_HIST_BUCKETS - 1);
+
+	local_irq_save(irqflags);
+	t = this_cpu_read(lc_tables);
+	if (!t)
+		goto out;
+	e = lc_lookup(t, (unsigned long)lock);
+	if (e) {
+		e->flags |= flags;
+		e->count++;
+		e->total_ns += delta;
+		e->max_ns = max(e->max_ns, delta);
+		e->hist[bucket]++;
+	} else {
+		t->dropped++;
+	}
+out:
+	local_irq_restore(irqflags);
+}
+
+static int lc_alloc_tables(void)
+{
+	int cpu;
+
+	if (lc_allocated)
+		return 0;
+
+	for_each_possible_cpu(cpu) {
+		struct lc_table *t;
+
+		t = kvzalloc_node(sizeof(*t), GFP_KERNEL, cpu_to_node(cpu));
+		if (!t)
+			goto err;
+		per_cpu(lc_tables, cpu) = t;
+	}
+
+	lc_allocated = true;
+	return 0;
+err:
+	for_each_possible_cpu(cpu) {
+		kvfree(per_cpu(lc_tables, cpu));
+		per_cpu(lc_tables, cpu) = NULL;
+	}
+	return -ENOMEM;
+}
+
+static int lc_enable(void)
+{
+	int ret;
+
+	if (lc_enabled)
+		return 0;
+
+	ret = lc_alloc_tables();
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(lc_gen, lc_gen + 1);
+	ret = register_trace_contention_begin(lc_contention_begin, NULL);
+	if (ret)
+		return ret;
+	ret = register_trace_contention_end(lc_contention_end, NULL);
+	if (ret) {
+		unregister_trace_contention_begin(lc_contention_begin, NULL);
+		tracepoint_synchronize_unregister();
+		return ret;
+	}
+
+	lc_enabled = true;
+	return 0;
+}
+
+static void lc_disable(void)
+{
+	if (!lc_enabled)
+		return;
+
+	unregister_trace_contention_end(lc_contention_end, NULL);
+	unregister_trace_contention_begin(lc_contention_begin, NULL);
+	tracepoint_synchronize_unregister();
+	lc_enabled = false;
+}
+
+static int lc_cmp_lock(const void *a, const void *b)
+{
+	const struct lc_entry *l = a, *r = b;
+
+	return l->lock < r->lock ? -1 : l->lock > r->lock;
+}
+
+static int lc_cmp_total(const void *a, const void *b)
+{
+	const struct lc_entry *l = a, *r = b;
+
+	return l->total_ns > r->total_ns ? -1 : l->total_ns < r->total_ns;
+}
+
+static int lc_stats_show(struct seq_file *m, void *v)
+{
+	unsigned long dropped = 0;
+	struct lc_entry *all;
+	unsigned int i, n = 0, nr;
+	int cpu, b;
+
+	mutex_lock(&lc_mutex);
+	if (!lc_allocated) {
+		mutex_unlock(&lc_mutex);
+		return 0;
+	}
+
+	all = kvmalloc_array(num_possible_cpus() * LC_HASH_SIZE, sizeof(*all),
+			     GFP_KERNEL);
+	if (!all) {
+		mutex_unlock(&lc_mutex);
+		return -ENOMEM;
+	}
+
+	/* Racy snapshot of the per-cpu tables, good enough for statistics */
+	for_each_possible_cpu(cpu) {
+		struct lc_table *t = per_cpu(lc_tables, cpu);
+
+		dropped += READ_ONCE(t->dropped);
+		for (i = 0; i < LC_HASH_SIZE; i++) {
+			if (READ_ONCE(t->entries[i].lock))
+				all[n++] = t->entries[i];
+		}
+	}
+	mutex_unlock(&lc_mutex);
+
+	/* Merge the entries of the same lock from different cpus */
+	sort(all, n, sizeof(*all), lc_cmp_lock, NULL);
+	for (i = 0, nr = 0; i < n; i++) {
+		struct lc_entry *e = &all[nr];
+
+		if (nr && all[i].lock == all[nr - 1].lock) {
+			e = &all[nr - 1];
+			e->flags |= all[i].flags;
+			e->count += all[i].count;
+			e->total_ns += all[i].total_ns;
+			e->max_ns = max(e->max_ns, all[i].max_ns);
+			for (b = 0; b < LC_HIST_BUCKETS; b++)
+				e->hist[b] += all[i].hist[b];
+			continue;
+		}
+		if (i != nr)
+			*e = all[i];
+		nr++;
+	}
+	sort(all, nr, sizeof(*all), lc_cmp_total, NULL);
+
+	seq_printf(m, "# dropped: %lu\n", dropped);
+	seq_puts(m, "# lock flags count total_ns max_ns hist[<1us,<2us,<4us,...]\n");
+	for (i = 0; i < nr; i++) {
+		struct lc_entry *e = &all[i];
+
+		seq_printf(m, "%ps %#x %llu %llu %llu", (void *)e->lock,
+			   e->flags, e->count, e->total_ns, e->max_ns);
+		for (b = 0; b < LC_HIST_BUCKETS; b++)
+			seq_printf(m, " %u", e->hist[b]);
+		seq_putc(m, '\n');
+	}
+
+	kvfree(all);
+	return 0;
+}
+
+static int lc_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lc_stats_show, NULL);
+}
+
+static ssize_t lc_stats_write(struct file *file, const char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	mutex_lock(&lc_mutex);
+	if (lc_allocated) {
+		bool enabled = lc_enabled;
+
+		/* Stop updates so that the tables can be cleared safely */
+		lc_disable();
+		for_each_possible_cpu(cpu)
+			memset(per_cpu(lc_tables, cpu), 0,
+			       sizeof(struct lc_table));
+		if (enabled && lc_enable())
+			pr_warn("failed to re-enable\n");
+	}
+	mutex_unlock(&lc_mutex);
+
+	return count;
+}
+
+static const struct file_operations lc_stats_fops = {
+	.owner		= THIS_MODULE,
+	.open		= lc_stats_open,
+	.read		= seq_read,
+	.write		= lc_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int lc_enable_get(void *data, u64 *val)
+{
+	*val = READ_ONCE(lc_enabled);
+	return 0;
+}
+
+static int lc_enable_set(void *data, u64 val)
+{
+	int ret = 0;
+
+	mutex_lock(&lc_mutex);
+	if (val)
+		ret = lc_enable();
+	else
+		lc_disable();
+	mutex_unlock(&lc_mutex);
+
+	return ret;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(lc_enable_fops, lc_enable_get, lc_enable_set,
+			 "%llu\n");
+
+static int __init lock_contention_init(void)
+{
+	struct dentry *d_dir = debugfs_create_dir("lock_contention", NULL);
+
+	debugfs_create_file_unsafe("enable", 0600, d_dir, NULL,
+				   &lc_enable_fops);
+	debugfs_create_file("stats", 0600, d_dir, NULL, &lc_stats_fops);
+	return 0;
+}
+fs_initcall(lock_contention_init);
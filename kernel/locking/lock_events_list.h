@@ -47,6 +47,8 @@ LOCK_EVENT(lock_use_node2)	/* # of locking ops that use 2nd percpu node */
 LOCK_EVENT(lock_use_node3)	/* # of locking ops that use 3rd percpu node */
 LOCK_EVENT(lock_use_node4)	/* # of locking ops that use 4th percpu node */
 LOCK_EVENT(lock_no_node)	/* # of locking ops w/o using percpu node    */
+LOCK_EVENT(lock_cna_reorder)	/* # of CNA moves to the secondary queue     */
+LOCK_EVENT(lock_cna_flush)	/* # of CNA secondary queue fairness flushes */
 #endif /* CONFIG_QUEUED_SPINLOCKS */
 
 /*
@@ -64,6 +66,10 @@ LOCK_EVENT(rwsem_rlock_steal)	/* # of read locks by lock stealing	*/
 LOCK_EVENT(rwsem_rlock_fast)	/* # of fast read locks acquired	*/
 LOCK_EVENT(rwsem_rlock_fail)	/* # of failed read lock acquisitions	*/
 LOCK_EVENT(rwsem_rlock_handoff)	/* # of read lock handoffs		*/
+LOCK_EVENT(rwsem_rspin_lock)	/* # of read locks acquired by spinning	*/
+LOCK_EVENT(rwsem_rspin_fail)	/* # of failed reader optspins		*/
+LOCK_EVENT(rwsem_rspin_timeout)	/* # of reader optspins out of budget	*/
+LOCK_EVENT(rwsem_rspin_skip)	/* # of reader optspins skipped		*/
 LOCK_EVENT(rwsem_wlock)		/* # of write locks acquired		*/
 LOCK_EVENT(rwsem_wlock_fail)	/* # of failed write lock acquisitions	*/
 LOCK_EVENT(rwsem_wlock_handoff)	/* # of write lock handoffs		*/
@@ -22,6 +22,8 @@ int __percpu_init_rwsem(struct percpu_rw_semaphore *sem,
 	rcuwait_init(&sem->writer);
 	init_waitqueue_head(&sem->waiters);
 	atomic_set(&sem->block, 0);
+	sem->expedited = false;
+	atomic_set(&sem->exp_writers, 0);
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
 	debug_check_no_locks_freed((void *)sem, sizeof(*sem));
 	lockdep_init_map(&sem->dep_map, name, key, 0);
@@ -221,6 +223,46 @@ static bool readers_active_check(struct percpu_rw_semaphore *sem)
 	return true;
 }
 
+/*
+ * Expedited writers
+ *
+ * rcu_sync_enter() waits for a normal grace period before the first writer
+ * can go ahead, which can stall readers that are blocked behind it for
+ * milliseconds. Writers of an expedited semaphore instead count themselves in
+ * sem->exp_writers and wait for an expedited grace period, which IPIs the
+ * CPUs that are in a read-side critical section rather than waiting for them
+ * to pass through a quiescent state.
+ *
+ * Readers take the slow path as long as sem->exp_writers is elevated. On
+ * exit, the writer releases sem->block first, so that blocked readers can go
+ * ahead right away, and then waits for another expedited grace period before
+ * readers may use their fast path again. That grace period makes the writer's
+ * critical section visible to the fast path, as in rcu_sync_exit(). Being a
+ * count, a later writer arriving meanwhile keeps readers on the slow path.
+ *
+ * This trades IPIs on every write for lower writer latency, so it is meant
+ * for latency critical semaphores that are write-locked rarely.
+ */
+static void percpu_rwsem_enter(struct percpu_rw_semaphore *sem)
+{
+	if (sem->expedited) {
+		atomic_inc(&sem->exp_writers);
+		synchronize_rcu_expedited();
+	} else {
+		rcu_sync_enter(&sem->rss);
+	}
+}
+
+static void percpu_rwsem_exit(struct percpu_rw_semaphore *sem)
+{
+	if (sem->expedited) {
+		synchronize_rcu_expedited();
+		atomic_dec(&sem->exp_writers);
+	} else {
+		rcu_sync_exit(&sem->rss);
+	}
+}
+
 void __sched percpu_down_write(struct percpu_rw_semaphore *sem)
 {
 	bool contended = false;
@@ -229,7 +271,7 @@ void __sched percpu_down_write(struct percpu_rw_semaphore *sem)
 	rwsem_acquire(&sem->dep_map, 0, 0, _RET_IP_);
 
 	/* Notify readers to take the slow path. */
-	rcu_sync_enter(&sem->rss);
+	percpu_rwsem_enter(sem);
 
 	/*
 	 * Try set sem->block; this provides writer-writer exclusion.
@@ -280,8 +322,9 @@ void percpu_up_write(struct percpu_rw_semaphore *sem)
 	/*
 	 * Once this completes (at least one RCU-sched grace period hence) the
 	 * reader fast path will be available again. Safe to use outside the
-	 * exclusive write lock because its counting.
+	 * exclusive write lock because its counting. Expedited semaphores
+	 * wait for that grace period here, so percpu_up_write() may sleep.
 	 */
-	rcu_sync_exit(&sem->rss);
+	percpu_rwsem_exit(sem);
 }
 EXPORT_SYMBOL_GPL(percpu_up_write);
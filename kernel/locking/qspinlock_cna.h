@@ -0,0 +1,233 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _GEN_CNA_LOCK_SLOWPATH
+#error "do not include this file"
+#endif
+
+#include <linux/kstrtox.h>
+#include <linux/sched/clock.h>
+#include <linux/string.h>
+#include <linux/topology.h>
+
+/*
+ * Implement a NUMA-aware version of the MCS queue (aka CNA, compact NUMA-aware
+ * lock).
+ *
+ * Waiters are kept in two queues: the main queue, which is the regular MCS
+ * queue hanging off the lock tail, and a secondary queue of waiters running on
+ * other NUMA nodes than the lock holder. While the queue head waits for the
+ * lock owner to go away, it moves the waiters in front of the first waiter on
+ * its own node to the tail of the secondary queue, so that the lock, and the
+ * data it protects, is handed over within the node as long as possible.
+ *
+ * The secondary queue is passed from one lock holder to the next in
+ * mcs_spinlock::locked, which holds either 1, meaning no secondary queue, or
+ * the encoded tail of the secondary queue head (which is never 0 or 1). The
+ * secondary queue head also records the last node of the secondary queue and
+ * when the secondary queue was started.
+ *
+ * The secondary queue is put back in front of the main queue when the main
+ * queue runs out of waiters or, for long-term fairness, once the oldest
+ * waiter on it has waited more than numa_spinlock_threshold_ns.
+ *
+ * CNA is selected at boot with numa_spinlock={on,off,auto}. It is enabled
+ * before secondary CPUs are brought up, so that native and CNA waiters never
+ * queue on the same lock. The default, auto, enables it on machines with more
+ * than one online node.
+ */
+
+struct cna_node {
+	struct mcs_spinlock	mcs;
+	u16			numa_node;
+	u16			reserved;
+	u32			encoded_tail;	/* self */
+	u32			sec_tail;	/* secondary queue head only */
+	u32			start_time;	/* secondary queue head only */
+};
+
+static int numa_spinlock_flag __initdata;	/* -1 off, 0 auto, 1 on */
+static u32 cna_threshold_ns __ro_after_init = NSEC_PER_MSEC;
+
+static __always_inline struct cna_node *to_cna_node(struct mcs_spinlock *node)
+{
+	return (struct cna_node *)node;
+}
+
+static __always_inline struct cna_node *cna_sec_head(struct mcs_spinlock *node)
+{
+	u32 val = node->locked;
+
+	return val > 1 ? to_cna_node(decode_tail(val)) : NULL;
+}
+
+static __always_inline bool cna_sec_expired(struct cna_node *head)
+{
+	return (u32)local_clock() - head->start_time > cna_threshold_ns;
+}
+
+static __always_inline void cna_init_node(struct mcs_spinlock *node)
+{
+	to_cna_node(node)->numa_node = numa_node_id();
+}
+
+/*
+ * Move the waiters from @first to @last, which are linked to each other, to
+ * the tail of the secondary queue of @node.
+ */
+static void cna_splice_tail(struct mcs_spinlock *node,
+			    struct mcs_spinlock *first,
+			    struct mcs_spinlock *last)
+{
+	struct cna_node *head = cna_sec_head(node);
+
+	WRITE_ONCE(last->next, NULL);
+
+	if (!head) {
+		head = to_cna_node(first);
+		head->start_time = (u32)local_clock();
+		node->locked = head->encoded_tail;
+	} else {
+		WRITE_ONCE(decode_tail(head->sec_tail)->next, first);
+	}
+	head->sec_tail = to_cna_node(last)->encoded_tail;
+}
+
+/*
+ * Called by the queue head while it waits for the owner and pending bits to
+ * go away: look for a waiter on our node and move all the waiters in front of
+ * it to the secondary queue. The last linked waiter is never moved as it may
+ * be the lock tail.
+ */
+static void cna_order_queue(struct mcs_spinlock *node)
+{
+	struct mcs_spinlock *next = READ_ONCE(node->next);
+	u16 numa_node = to_cna_node(node)->numa_node;
+	struct mcs_spinlock *last, *cur;
+	struct cna_node *head;
+
+	if (!next || to_cna_node(next)->numa_node == numa_node)
+		return;
+
+	/* The secondary queue is due to be flushed, don't make it longer */
+	head = cna_sec_head(node);
+	if (head && cna_sec_expired(head))
+		return;
+
+	last = next;
+	for (;;) {
+		cur = READ_ONCE(last->next);
+		if (!cur)
+			return;
+		if (to_cna_node(cur)->numa_node == numa_node)
+			break;
+		last = cur;
+	}
+
+	cna_splice_tail(node, next, last);
+	WRITE_ONCE(node->next, cur);
+	lockevent_inc(lock_cna_reorder);
+}
+
+static __always_inline u32 cna_wait_head_or_lock(struct qspinlock *lock,
+						 struct mcs_spinlock *node)
+{
+	if (atomic_read(&lock->val) & _Q_LOCKED_PENDING_MASK)
+		cna_order_queue(node);
+
+	return 0;	/* the lock is acquired by the caller */
+}
+
+/*
+ * We are the last waiter on the main queue. If there is a secondary queue,
+ * make its last node the lock tail and hand the MCS lock to its head.
+ */
+static inline bool cna_try_clear_tail(struct qspinlock *lock, u32 val,
+				      struct mcs_spinlock *node)
+{
+	struct cna_node *head = cna_sec_head(node);
+
+	if (!head)
+		return __try_clear_tail(lock, val, node);
+
+	if (!atomic_try_cmpxchg_relaxed(&lock->val, &val,
+					head->sec_tail | _Q_LOCKED_VAL))
+		return false;
+
+	arch_mcs_spin_unlock_contended(&head->mcs.locked);
+	return true;
+}
+
+/*
+ * Hand the MCS lock over to @next along with the secondary queue, or put the
+ * secondary queue back in front of @next if it has waited for too long.
+ */
+static inline void cna_pass_lock(struct mcs_spinlock *node,
+				 struct mcs_spinlock *next)
+{
+	struct cna_node *head = cna_sec_head(node);
+	u32 val = 1;
+
+	if (head) {
+		if (cna_sec_expired(head)) {
+			WRITE_ONCE(decode_tail(head->sec_tail)->next, next);
+			next = &head->mcs;
+			lockevent_inc(lock_cna_flush);
+		} else {
+			val = node->locked;
+		}
+	}
+
+	smp_store_release(&next->locked, val);
+}
+
+static int __init numa_spinlock_setup(char *str)
+{
+	if (!strcmp(str, "on"))
+		numa_spinlock_flag = 1;
+	else if (!strcmp(str, "off"))
+		numa_spinlock_flag = -1;
+	else if (!strcmp(str, "auto"))
+		numa_spinlock_flag = 0;
+	else
+		return 0;
+
+	return 1;
+}
+__setup("numa_spinlock=", numa_spinlock_setup);
+
+static int __init numa_spinlock_threshold_setup(char *str)
+{
+	u32 val;
+
+	if (kstrtou32(str, 0, &val) || !val)
+		return 0;
+
+	/* start_time is 32 bits of nanoseconds, keep well clear of wrapping */
+	cna_threshold_ns = min_t(u32, val, NSEC_PER_SEC);
+	return 1;
+}
+__setup("numa_spinlock_threshold_ns=", numa_spinlock_threshold_setup);
+
+static int __init cna_init(void)
+{
+	int cpu, idx;
+
+	BUILD_BUG_ON(sizeof(struct cna_node) > sizeof(struct qnode));
+
+	if (numa_spinlock_flag < 0 ||
+	    (!numa_spinlock_flag && num_online_nodes() < 2))
+		return 0;
+
+	for_each_possible_cpu(cpu) {
+		for (idx = 0; idx < MAX_NODES; idx++) {
+			struct cna_node *cn;
+
+			cn = to_cna_node(per_cpu_ptr(&qnodes[idx].mcs, cpu));
+			cn->encoded_tail = encode_tail(cpu, idx);
+		}
+	}
+
+	static_branch_enable(&numa_spinlock_key);
+	pr_info("NUMA-aware spinlocks enabled\n");
+	return 0;
+}
+early_initcall(cna_init);
@@ -326,6 +326,7 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 	atomic_long_set(&sem->owner, 0L);
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	osq_lock_init(&sem->osq);
+	sem->rspin_avg = 0;
 #endif
 }
 EXPORT_SYMBOL(__init_rwsem);
@@ -934,6 +935,117 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	return taken;
 }
 
+/*
+ * Reader optimistic spinning on a running writer
+ *
+ * sem->rspin_avg tracks how long spinning readers recently had to wait for
+ * the owning writer to release the lock. It is only updated by readers in
+ * the slowpath, so the lock fast paths pay nothing for it. The spinning
+ * budget is twice that average, starting from RWSEM_RSPIN_INIT_NS and capped
+ * to RWSEM_RSPIN_MAX_NS. A spinner that runs out of budget accounts twice
+ * its budget so that the average quickly grows past the cap for locks with
+ * long write hold times, after which readers go straight to sleep. Each such
+ * reader decays the average a bit so that spinning is retried eventually.
+ */
+#define RWSEM_RSPIN_INIT_NS	(5 * NSEC_PER_USEC)
+#define RWSEM_RSPIN_MAX_NS	(25 * NSEC_PER_USEC)
+
+static inline void rwsem_rspin_account(struct rw_semaphore *sem, u64 wait)
+{
+	unsigned int avg = READ_ONCE(sem->rspin_avg);
+
+	wait = min_t(u64, wait, 4 * RWSEM_RSPIN_MAX_NS);
+	if (!avg)
+		avg = wait;
+	else
+		avg = avg - (avg >> 3) + (wait >> 3);
+	WRITE_ONCE(sem->rspin_avg, avg);
+}
+
+static inline u64 rwsem_rspin_budget(struct rw_semaphore *sem)
+{
+	unsigned int avg = READ_ONCE(sem->rspin_avg);
+
+	if (!avg)
+		return RWSEM_RSPIN_INIT_NS;
+
+	if (avg > RWSEM_RSPIN_MAX_NS) {
+		WRITE_ONCE(sem->rspin_avg, avg - (avg >> 4));
+		return 0;
+	}
+
+	return min_t(u64, 2 * avg, RWSEM_RSPIN_MAX_NS);
+}
+
+/*
+ * Spin for a writer-owned rwsem to be released. The caller has already
+ * added its RWSEM_READER_BIAS to the count, so the read lock is granted as
+ * soon as the writer is gone and no handoff is pending. Return true with
+ * the up-to-date count in *cntp if the lock was acquired.
+ */
+static bool rwsem_reader_optimistic_spin(struct rw_semaphore *sem, long *cntp)
+{
+	struct task_struct *owner;
+	unsigned long flags;
+	bool taken = false;
+	u64 budget, start;
+	int loop = 0;
+	long count;
+
+	budget = rwsem_rspin_budget(sem);
+	if (!budget) {
+		lockevent_inc(rwsem_rspin_skip);
+		return false;
+	}
+
+	if (!osq_lock(&sem->osq))
+		goto done;
+
+	start = sched_clock();
+	for (;;) {
+		count = atomic_long_read(&sem->count);
+		if (!(count & (RWSEM_WRITER_LOCKED | RWSEM_FLAG_HANDOFF))) {
+			/* Provide lock ACQUIRE */
+			smp_acquire__after_ctrl_dep();
+			taken = true;
+			break;
+		}
+		if (count & RWSEM_FLAG_HANDOFF)
+			break;
+
+		/*
+		 * The owner may be NULL for a short while after the writer
+		 * has set RWSEM_WRITER_LOCKED. Preemption is disabled, so
+		 * the task_struct cannot go away while we look at it.
+		 */
+		owner = rwsem_owner_flags(sem, &flags);
+		if (flags & RWSEM_NONSPINNABLE)
+			break;
+		if (owner ? !owner_on_cpu(owner) : rt_task(current))
+			break;
+		if (need_resched())
+			break;
+
+		/* Check the budget once every 16 iterations, as above */
+		if (!(++loop & 0xf) && (sched_clock() - start > budget)) {
+			lockevent_inc(rwsem_rspin_timeout);
+			rwsem_rspin_account(sem, 2 * budget);
+			break;
+		}
+		cpu_relax();
+	}
+	osq_unlock(&sem->osq);
+
+	if (taken) {
+		rwsem_rspin_account(sem, sched_clock() - start);
+		lockevent_inc(rwsem_rspin_lock);
+		*cntp = count;
+	}
+done:
+	lockevent_cond_inc(rwsem_rspin_fail, !taken);
+	return taken;
+}
+
 /*
  * Clear the owner's RWSEM_NONSPINNABLE bit if it is set. This should
  * only be called when the reader count reaches 0.
@@ -955,6 +1067,12 @@ static inline bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	return false;
 }
 
+static inline bool rwsem_reader_optimistic_spin(struct rw_semaphore *sem,
+						long *cntp)
+{
+	return false;
+}
+
 static inline void clear_nonspinnable(struct rw_semaphore *sem) { }
 
 static inline enum owner_state
@@ -1009,6 +1127,14 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 	    (rcnt > 1) && !(count & RWSEM_WRITER_LOCKED))
 		goto queue;
 
+	/*
+	 * If a running writer holds the lock, it may well release it before
+	 * we could go to sleep and be woken up again.
+	 */
+	if ((count & RWSEM_WRITER_LOCKED) && !(count & RWSEM_FLAG_HANDOFF) &&
+	    rwsem_reader_optimistic_spin(sem, &count))
+		rcnt = count >> RWSEM_READER_SHIFT;
+
 	/*
 	 * Reader optimistic lock stealing.
 	 */
@@ -53,6 +53,8 @@
 #include <linux/jump_label.h>
 #include <linux/pfn.h>
 #include <linux/bsearch.h>
+#include <linux/hashtable.h>
+#include <linux/stringhash.h>
 #include <linux/dynamic_debug.h>
 #include <linux/audit.h>
 #include <linux/cfi.h>
@@ -295,6 +297,108 @@ static bool find_exported_symbol_in_section(const struct symsearch *syms,
 	return true;
 }
 
+/*
+ * The exported symbols of all modules, hashed by name, so that resolving a
+ * symbol exported by a module doesn't take a binary search of the exports
+ * of every loaded module.  Exported names are unique, verify_exported_symbols()
+ * refuses modules exporting a symbol that is already exported.  Updated under
+ * module_mutex, looked up under RCU like the modules list.
+ */
+struct mod_export {
+	struct hlist_node node;
+	const struct kernel_symbol *sym;
+	const s32 *crc;
+	struct module *mod;
+	enum mod_license license;
+};
+
+#define MOD_EXPORTS_BITS	12
+static DEFINE_HASHTABLE(mod_exports, MOD_EXPORTS_BITS);
+
+static unsigned int mod_export_hash(const char *name)
+{
+	return full_name_hash(NULL, name, strlen(name));
+}
+
+static int mod_exports_add(struct module *mod)
+{
+	struct mod_export *e;
+	unsigned int i;
+
+	lockdep_assert_held(&module_mutex);
+
+	if (!mod->num_syms && !mod->num_gpl_syms)
+		return 0;
+
+	e = kvcalloc(mod->num_syms + mod->num_gpl_syms, sizeof(*e), GFP_KERNEL);
+	if (!e)
+		return -ENOMEM;
+	mod->exports = e;
+
+	for (i = 0; i < mod->num_syms; i++, e++) {
+		e->sym = &mod->syms[i];
+		e->crc = symversion(mod->crcs, i);
+		e->license = NOT_GPL_ONLY;
+	}
+	for (i = 0; i < mod->num_gpl_syms; i++, e++) {
+		e->sym = &mod->gpl_syms[i];
+		e->crc = symversion(mod->gpl_crcs, i);
+		e->license = GPL_ONLY;
+	}
+
+	for (e = mod->exports; e < mod->exports + mod->num_syms + mod->num_gpl_syms; e++) {
+		e->mod = mod;
+		hash_add_rcu(mod_exports, &e->node,
+			     mod_export_hash(kernel_symbol_name(e->sym)));
+	}
+
+	return 0;
+}
+
+/* The entries are freed by mod_exports_free() after an RCU grace period. */
+static void mod_exports_del(struct module *mod)
+{
+	unsigned int i;
+
+	lockdep_assert_held(&module_mutex);
+
+	if (!mod->exports)
+		return;
+
+	for (i = 0; i < mod->num_syms + mod->num_gpl_syms; i++)
+		hash_del_rcu(&mod->exports[i].node);
+}
+
+static void mod_exports_free(struct module *mod)
+{
+	kvfree(mod->exports);
+	mod->exports = NULL;
+}
+
+static bool find_module_export(struct find_symbol_arg *fsa)
+{
+	unsigned int hash = mod_export_hash(fsa->name);
+	struct mod_export *e;
+
+	hlist_for_each_entry_rcu(e, &mod_exports[hash_min(hash, MOD_EXPORTS_BITS)],
+				 node, lockdep_is_held(&module_mutex)) {
+		if (strcmp(fsa->name, kernel_symbol_name(e->sym)))
+			continue;
+
+		if (e->mod->state == MODULE_STATE_UNFORMED ||
+		    (!fsa->gplok && e->license == GPL_ONLY))
+			return false;
+
+		fsa->owner = e->mod;
+		fsa->crc = e->crc;
+		fsa->sym = e->sym;
+		fsa->license = e->license;
+		return true;
+	}
+
+	return false;
+}
+
 /*
  * Find an exported symbol and return it, along with, (optional) crc and
  * (optional) module which owns it.  Needs preempt disabled or module_mutex.
@@ -308,7 +412,6 @@ bool find_symbol(struct find_symbol_arg *fsa)
 		  __start___kcrctab_gpl,
 		  GPL_ONLY },
 	};
-	struct module *mod;
 	unsigned int i;
 
 	module_assert_mutex_or_preempt();
@@ -317,23 +420,8 @@ bool find_symbol(struct find_symbol_arg *fsa)
 		if (find_exported_symbol_in_section(&arr[i], NULL, fsa))
 			return true;
 
-	list_for_each_entry_rcu(mod, &modules, list,
-				lockdep_is_held(&module_mutex)) {
-		struct symsearch arr[] = {
-			{ mod->syms, mod->syms + mod->num_syms, mod->crcs,
-			  NOT_GPL_ONLY },
-			{ mod->gpl_syms, mod->gpl_syms + mod->num_gpl_syms,
-			  mod->gpl_crcs,
-			  GPL_ONLY },
-		};
-
-		if (mod->state == MODULE_STATE_UNFORMED)
-			continue;
-
-		for (i = 0; i < ARRAY_SIZE(arr); i++)
-			if (find_exported_symbol_in_section(&arr[i], mod, fsa))
-				return true;
-	}
+	if (find_module_export(fsa))
+		return true;
 
 	pr_debug("Failed to find symbol %s\n", fsa->name);
 	return false;
@@ -1269,10 +1357,12 @@ static void free_module(struct module *mod)
 	/* Unlink carefully: kallsyms could be walking list. */
 	list_del_rcu(&mod->list);
 	mod_tree_remove(mod);
+	mod_exports_del(mod);
 	/* Remove this module from bug list, this uses list_del_rcu */
 	module_bug_cleanup(mod);
 	/* Wait for RCU-sched synchronizing before releasing mod->list and buglist. */
 	synchronize_rcu();
+	mod_exports_free(mod);
 	if (try_add_tainted_module(mod))
 		pr_err("%s: adding tainted module to the unloaded tainted modules list failed.\n",
 		       mod->name);
@@ -2752,6 +2842,9 @@ static int complete_formation(struct module *mod, struct load_info *info)
 	if (err)
 		goto out_strict_rwx;
 	err = module_enable_text_rox(mod);
+	if (err)
+		goto out_strict_rwx;
+	err = mod_exports_add(mod);
 	if (err)
 		goto out_strict_rwx;
 
@@ -3030,10 +3123,12 @@ static int load_module(struct load_info *info, const char __user *uargs,
 	/* Unlink carefully: kallsyms could be walking list. */
 	list_del_rcu(&mod->list);
 	mod_tree_remove(mod);
+	mod_exports_del(mod);
 	wake_up_all(&module_wq);
 	/* Wait for RCU-sched synchronizing before releasing mod->list. */
 	synchronize_rcu();
 	mutex_unlock(&module_mutex);
+	mod_exports_free(mod);
  free_module:
 	mod_stat_bump_invalid(info, flags);
 	/* Free lock-classes; relies on the preceding sync_rcu() */
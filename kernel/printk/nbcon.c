@@ -923,6 +923,11 @@ static bool nbcon_emit_next_record(struct nbcon_write_context *wctxt)
 		WRITE_ONCE(con->dropped, dropped);
 	}
 
+	if (pmsg.dropped) {
+		WRITE_ONCE(con->dropped_total,
+			   data_race(con->dropped_total) + pmsg.dropped);
+	}
+
 	nbcon_seq_try_update(ctxt, pmsg.seq + 1);
 
 	return nbcon_context_exit_unsafe(ctxt);
@@ -2851,6 +2851,56 @@ bool printk_get_next_message(struct printk_message *pmsg, u64 seq,
  */
 struct printk_buffers printk_shared_pbufs;
 
+/*
+ * Maximum number of records that legacy consoles write with a single call
+ * of their write() callback. Every write() call of a serial console driver
+ * has a fixed cost (taking the port lock, masking the UART interrupts and
+ * waiting for the transmitter to drain), which adds up during log bursts.
+ * Larger batches also make a waiting printk() caller spin longer before the
+ * console_lock is handed over to it.
+ */
+static unsigned int console_batch = 1;
+module_param(console_batch, uint, 0644);
+MODULE_PARM_DESC(console_batch, "maximum number of records per legacy console write");
+
+/* Used to format the records appended to a batch. Requires the console_lock. */
+static struct printk_buffers printk_batch_pbufs;
+
+/*
+ * Append the records following @pmsg to its output buffer, as long as they
+ * fit and none were lost in between, so that the "dropped" message is still
+ * printed in front of the first record after the gap. @pmsg->seq is updated
+ * to the last appended record.
+ *
+ * Only used for non-extended consoles, whose records are printed as plain
+ * lines of text. Requires the console_lock.
+ */
+static void console_batch_records(struct printk_message *pmsg)
+{
+	struct printk_message bmsg = {
+		.pbufs = &printk_batch_pbufs,
+	};
+	const size_t outbuf_sz = sizeof(pmsg->pbufs->outbuf);
+	char *outbuf = &pmsg->pbufs->outbuf[0];
+	unsigned int batch = READ_ONCE(console_batch);
+	unsigned int nr;
+
+	for (nr = 1; nr < batch; nr++) {
+		if (!printk_get_next_message(&bmsg, pmsg->seq + 1, false, true))
+			break;
+		if (bmsg.dropped)
+			break;
+		if (pmsg->outbuf_len + bmsg.outbuf_len >= outbuf_sz)
+			break;
+
+		memcpy(outbuf + pmsg->outbuf_len, &bmsg.pbufs->outbuf[0],
+		       bmsg.outbuf_len);
+		pmsg->outbuf_len += bmsg.outbuf_len;
+		outbuf[pmsg->outbuf_len] = '\0';
+		pmsg->seq = bmsg.seq;
+	}
+}
+
 /*
  * Print one record for the given console. The record printed is whatever
  * record is the next available record for the given console.
@@ -2881,6 +2931,7 @@ static bool console_emit_next_record(struct console *con, bool *handover, int co
 		return false;
 
 	con->dropped += pmsg.dropped;
+	con->dropped_total += pmsg.dropped;
 
 	/* Skip messages of formatted length 0. */
 	if (pmsg.outbuf_len == 0) {
@@ -2893,6 +2944,9 @@ static bool console_emit_next_record(struct console *con, bool *handover, int co
 		con->dropped = 0;
 	}
 
+	if (!is_extended && console_batch > 1)
+		console_batch_records(&pmsg);
+
 	/*
 	 * While actively printing out messages, if another printk()
 	 * were to occur on another CPU, it may wait for this one to
@@ -2922,6 +2976,29 @@ static bool console_emit_next_record(struct console *con, bool *handover, int co
 	return true;
 }
 
+/**
+ * console_backlog - Number of records not yet printed on a console
+ * @con:	The console to check
+ *
+ * The result is only a snapshot, the console may be printing concurrently.
+ *
+ * Requires the console_list_lock.
+ */
+u64 console_backlog(struct console *con)
+{
+	u64 next_seq = prb_next_seq(prb);
+	u64 seq;
+
+	lockdep_assert_console_list_lock_held();
+
+	if (con->flags & CON_NBCON)
+		seq = nbcon_seq_read(con);
+	else
+		seq = data_race(READ_ONCE(con->seq));
+
+	return next_seq > seq ? next_seq - seq : 0;
+}
+
 #else
 
 static bool console_emit_next_record(struct console *con, bool *handover, int cookie)
@@ -2930,6 +3007,11 @@ static bool console_emit_next_record(struct console *con, bool *handover, int co
 	return false;
 }
 
+u64 console_backlog(struct console *con)
+{
+	return 0;
+}
+
 #endif /* CONFIG_PRINTK */
 
 /*
@@ -3528,6 +3610,7 @@ void register_console(struct console *newcon)
 	}
 
 	newcon->dropped = 0;
+	newcon->dropped_total = 0;
 	console_init_seq(newcon, bootcon_registered);
 
 	if (newcon->flags & CON_NBCON)
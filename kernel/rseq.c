@@ -12,6 +12,8 @@
 #include <linux/uaccess.h>
 #include <linux/syscalls.h>
 #include <linux/rseq.h>
+#include <linux/mm.h>
+#include <linux/overflow.h>
 #include <linux/types.h>
 #include <asm/ptrace.h>
 
@@ -85,6 +87,19 @@
  *   F1. <failure>
  */
 
+static u64 rseq_cid_area(struct task_struct *t, u32 mm_cid)
+{
+	struct mm_struct *mm = t->mm;
+	unsigned long area;
+
+	/* Pairs with the release in rseq_set_cid_area() */
+	area = smp_load_acquire(&mm->rseq_cid_area);
+	if (!area || mm_cid >= mm->rseq_cid_slots)
+		return 0;
+
+	return area + mm_cid * mm->rseq_cid_stride;
+}
+
 static int rseq_update_cpu_node_id(struct task_struct *t)
 {
 	struct rseq __user *rseq = t->rseq;
@@ -104,6 +119,15 @@ static int rseq_update_cpu_node_id(struct task_struct *t)
 	 * need to be conditionally updated only if
 	 * t->rseq_len != ORIG_RSEQ_SIZE.
 	 */
+	if (t->rseq_len != ORIG_RSEQ_SIZE) {
+		if (mm_cid != t->rseq_cid) {
+			t->rseq_cid = mm_cid;
+			t->rseq_cid_seq++;
+		}
+		unsafe_put_user(t->rseq_cid_seq, &rseq->mm_cid_seq, efault_end);
+		unsafe_put_user(rseq_cid_area(t, mm_cid), &rseq->mm_cid_area,
+				efault_end);
+	}
 	user_write_access_end();
 	trace_rseq_update(t);
 	return 0;
@@ -146,6 +170,11 @@ static int rseq_reset_rseq_cpu_node_id(struct task_struct *t)
 	 * need to be conditionally reset only if
 	 * t->rseq_len != ORIG_RSEQ_SIZE.
 	 */
+	if (t->rseq_len != ORIG_RSEQ_SIZE) {
+		if (put_user(0U, &t->rseq->mm_cid_seq) ||
+		    put_user(0ULL, &t->rseq->mm_cid_area))
+			return -EFAULT;
+	}
 	return 0;
 }
 
@@ -423,6 +452,9 @@ SYSCALL_DEFINE4(rseq, struct rseq __user *, rseq, u32, rseq_len,
 	current->rseq = rseq;
 	current->rseq_len = rseq_len;
 	current->rseq_sig = sig;
+	/* Any mm_cid is a change, the first update bumps mm_cid_seq to 1 */
+	current->rseq_cid = U32_MAX;
+	current->rseq_cid_seq = 0;
 	/*
 	 * If rseq was previously inactive, and has just been
 	 * registered, ensure the cpu_id_start and cpu_id fields
@@ -432,3 +464,37 @@ SYSCALL_DEFINE4(rseq, struct rseq __user *, rseq, u32, rseq_len,
 
 	return 0;
 }
+
+/*
+ * Register the per-mm_cid scratch area of current's memory map: @slots slots
+ * of @stride bytes starting at @addr. Concurrency IDs are allocated densely
+ * from 0 and bounded by the number of threads and of allowed CPUs, so user
+ * space allocators can keep per-CPU caches here without sizing them for all
+ * possible CPUs. The area can only be registered once per memory map.
+ */
+int rseq_set_cid_area(unsigned long addr, unsigned long stride,
+		      unsigned long slots)
+{
+	struct mm_struct *mm = current->mm;
+	unsigned long size;
+	int ret = 0;
+
+	if (!addr || !stride || !slots || slots > U32_MAX ||
+	    !IS_ALIGNED(addr | stride, sizeof(u64)) ||
+	    check_mul_overflow(stride, slots, &size) ||
+	    !access_ok((void __user *)addr, size))
+		return -EINVAL;
+
+	if (mmap_write_lock_killable(mm))
+		return -EINTR;
+	if (mm->rseq_cid_area) {
+		ret = -EBUSY;
+	} else {
+		mm->rseq_cid_stride = stride;
+		mm->rseq_cid_slots = slots;
+		smp_store_release(&mm->rseq_cid_area, addr);
+	}
+	mmap_write_unlock(mm);
+
+	return ret;
+}
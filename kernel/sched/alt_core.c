@@ -130,6 +130,38 @@ DEFINE_PER_CPU_ALIGNED(cpumask_t [NR_CPU_AFFINITY_LEVELS], sched_cpu_topo_masks)
 DEFINE_PER_CPU_ALIGNED(cpumask_t *, sched_cpu_llc_mask);
 DEFINE_PER_CPU_ALIGNED(cpumask_t *, sched_cpu_topo_end_mask);
 
+#ifdef CONFIG_SCHED_ALT_LLC_PENDING
+/*
+ * Per-LLC copy of sched_rq_pending_mask. All cpus of a cache domain point at
+ * the instance owned by the domain's first cpu (its sd_llc_id), so pulling
+ * work inside the LLC never touches the global mask's cacheline.
+ */
+static DEFINE_PER_CPU_SHARED_ALIGNED(cpumask_t, sched_llc_pending_masks);
+DEFINE_PER_CPU_READ_MOSTLY(cpumask_t *, sched_llc_pending_mask);
+
+static inline void sched_rq_pending_set(int cpu)
+{
+	cpumask_set_cpu(cpu, &sched_rq_pending_mask);
+	cpumask_set_cpu(cpu, per_cpu(sched_llc_pending_mask, cpu));
+}
+
+static inline void sched_rq_pending_clear(int cpu)
+{
+	cpumask_clear_cpu(cpu, &sched_rq_pending_mask);
+	cpumask_clear_cpu(cpu, per_cpu(sched_llc_pending_mask, cpu));
+}
+#else
+static inline void sched_rq_pending_set(int cpu)
+{
+	cpumask_set_cpu(cpu, &sched_rq_pending_mask);
+}
+
+static inline void sched_rq_pending_clear(int cpu)
+{
+	cpumask_clear_cpu(cpu, &sched_rq_pending_mask);
+}
+#endif /* CONFIG_SCHED_ALT_LLC_PENDING */
+
 #ifdef CONFIG_SCHED_SMT
 DEFINE_STATIC_KEY_FALSE(sched_smt_present);
 EXPORT_SYMBOL_GPL(sched_smt_present);
@@ -654,6 +686,12 @@ unsigned long sched_cpu_util(int cpu)
 }
 #endif /* CONFIG_SMP */
 
+/* No utilization clamping here */
+unsigned long sched_cpu_uclamp_min(int cpu)
+{
+	return 0;
+}
+
 #ifdef CONFIG_CPU_FREQ
 /**
  * cpufreq_update_util - Take a note about CPU utilization changes.
@@ -783,7 +821,7 @@ static inline void dequeue_task(struct task_struct *p, struct rq *rq, int flags)
 	--rq->nr_running;
 #ifdef CONFIG_SMP
 	if (1 == rq->nr_running)
-		cpumask_clear_cpu(cpu_of(rq), &sched_rq_pending_mask);
+		sched_rq_pending_clear(cpu_of(rq));
 #endif
 
 	sched_update_tick_dependency(rq);
@@ -803,7 +841,7 @@ static inline void enqueue_task(struct task_struct *p, struct rq *rq, int flags)
 	++rq->nr_running;
 #ifdef CONFIG_SMP
 	if (2 == rq->nr_running)
-		cpumask_set_cpu(cpu_of(rq), &sched_rq_pending_mask);
+		sched_rq_pending_set(cpu_of(rq));
 #endif
 
 	sched_update_tick_dependency(rq);
@@ -961,9 +999,55 @@ void wake_q_add_safe(struct wake_q_head *head, struct task_struct *task)
 		put_task_struct(task);
 }
 
+#ifdef CONFIG_SMP
+/*
+ * While wake_up_q() batches, __ttwu_queue_wakelist() only queues the wakee on
+ * the target's wakelist and records the target here; the IPIs then go out as
+ * a single multicast once the whole wake_q has been processed.
+ */
+static DEFINE_PER_CPU(bool, ttwu_batching);
+static DEFINE_PER_CPU(cpumask_t, ttwu_batch_mask);
+
+static inline bool ttwu_batch_begin(struct wake_q_head *head)
+{
+	/* Nothing to batch for a single wakeup */
+	if (head->first == WAKE_Q_TAIL ||
+	    head->first->next == WAKE_Q_TAIL)
+		return false;
+
+	preempt_disable();
+	if (__this_cpu_read(ttwu_batching)) {
+		preempt_enable();
+		return false;
+	}
+	__this_cpu_write(ttwu_batching, true);
+
+	return true;
+}
+
+static inline void ttwu_batch_end(void)
+{
+	struct cpumask *mask = this_cpu_ptr(&ttwu_batch_mask);
+	unsigned long flags;
+
+	local_irq_save(flags);
+	__this_cpu_write(ttwu_batching, false);
+	if (!cpumask_empty(mask)) {
+		__smp_call_single_ipi_mask(mask);
+		cpumask_clear(mask);
+	}
+	local_irq_restore(flags);
+	preempt_enable();
+}
+#else
+static inline bool ttwu_batch_begin(struct wake_q_head *head) { return false; }
+static inline void ttwu_batch_end(void) {}
+#endif /* CONFIG_SMP */
+
 void wake_up_q(struct wake_q_head *head)
 {
 	struct wake_q_node *node = head->first;
+	bool batch = ttwu_batch_begin(head);
 
 	while (node != WAKE_Q_TAIL) {
 		struct task_struct *task;
@@ -980,6 +1064,9 @@ void wake_up_q(struct wake_q_head *head)
 		wake_up_process(task);
 		put_task_struct(task);
 	}
+
+	if (batch)
+		ttwu_batch_end();
 }
 
 /*
@@ -989,7 +1076,7 @@ void wake_up_q(struct wake_q_head *head)
  * might also involve a cross-CPU call to trigger the scheduler on
  * the target CPU.
  */
-static inline void resched_curr(struct rq *rq)
+void resched_curr(struct rq *rq)
 {
 	struct task_struct *curr = rq->curr;
 	int cpu;
@@ -1485,7 +1572,8 @@ static void activate_task(struct task_struct *p, struct rq *rq)
 	 * utilization updates, so do it here explicitly with the IOWAIT flag
 	 * passed.
 	 */
-	cpufreq_update_util(rq, SCHED_CPUFREQ_IOWAIT * p->in_iowait);
+	cpufreq_update_util(rq, SCHED_CPUFREQ_IOWAIT *
+			    (p->in_iowait && !p->sched_no_iowait_boost));
 }
 
 /*
@@ -2076,6 +2164,16 @@ preempt_mask_check(cpumask_t *preempt_mask, cpumask_t *allow_mask, int prio)
 	return cpumask_and(preempt_mask, allow_mask, mask);
 }
 
+extern struct static_key_false sched_asym_cpucapacity;
+
+static __always_inline bool sched_asym_cpucap_active(void)
+{
+	return static_branch_unlikely(&sched_asym_cpucapacity);
+}
+
+/* CPUs with the highest arch_scale_cpu_capacity(), set up in sched_init_smp() */
+static cpumask_t sched_cpu_big_mask ____cacheline_aligned_in_smp;
+
 static inline int select_task_rq(struct task_struct *p)
 {
 	cpumask_t allow_mask, mask;
@@ -2083,6 +2181,20 @@ static inline int select_task_rq(struct task_struct *p)
 	if (unlikely(!cpumask_and(&allow_mask, p->cpus_ptr, cpu_active_mask)))
 		return select_fallback_rq(task_cpu(p), p);
 
+	/*
+	 * On asymmetric capacity systems, try to keep the tasks the policy
+	 * favours most on the big CPUs, as long as one of them is idle or
+	 * running something of lower priority.
+	 */
+	if (sched_asym_cpucap_active() && sched_task_prefer_big(p)) {
+		cpumask_t big_mask;
+
+		if (cpumask_and(&big_mask, &allow_mask, &sched_cpu_big_mask) &&
+		    (cpumask_and(&mask, &big_mask, sched_idle_mask) ||
+		     preempt_mask_check(&mask, &big_mask, task_sched_prio(p))))
+			return best_mask_cpu(task_cpu(p), &mask);
+	}
+
 	if (
 #ifdef CONFIG_SCHED_SMT
 	    cpumask_and(&mask, &allow_mask, sched_sg_idle_mask) ||
@@ -2585,6 +2697,11 @@ static void __ttwu_queue_wakelist(struct task_struct *p, int cpu, int wake_flags
 	p->sched_remote_wakeup = !!(wake_flags & WF_MIGRATED);
 
 	WRITE_ONCE(rq->ttwu_pending, 1);
+	if (__this_cpu_read(ttwu_batching)) {
+		if (__smp_call_single_queue_noipi(cpu, &p->wake_entry.llist))
+			cpumask_set_cpu(cpu, this_cpu_ptr(&ttwu_batch_mask));
+		return;
+	}
 	__smp_call_single_queue(cpu, &p->wake_entry.llist);
 }
 
@@ -2651,13 +2768,6 @@ void wake_up_if_idle(int cpu)
 	}
 }
 
-extern struct static_key_false sched_asym_cpucapacity;
-
-static __always_inline bool sched_asym_cpucap_active(void)
-{
-	return static_branch_unlikely(&sched_asym_cpucapacity);
-}
-
 bool cpus_equal_capacity(int this_cpu, int that_cpu)
 {
 	if (!sched_asym_cpucap_active())
@@ -4087,6 +4197,284 @@ unsigned long long task_sched_runtime(struct task_struct *p)
 	return ns;
 }
 
+#ifdef CONFIG_SCHED_CORE
+/*
+ * Core scheduling
+ *
+ * Unlike mainline, SMT siblings don't share a run queue lock and each CPU
+ * still picks for itself. Picks are serialized by a per-core lock, under
+ * which every CPU publishes the cookie and priority of the task it picked.
+ * A CPU only selects a task whose cookie matches what its busy siblings run,
+ * a pick that outranks a conflicting sibling kicks that sibling, and a CPU
+ * left without a compatible task is forced idle until a sibling's pick
+ * changes.
+ */
+DEFINE_STATIC_KEY_FALSE(__sched_core_enabled);
+
+static DEFINE_PER_CPU(raw_spinlock_t, sched_core_locks);
+static DEFINE_MUTEX(sched_core_mutex);
+static atomic_t sched_core_count;
+
+static inline raw_spinlock_t *sched_core_lockp(int cpu)
+{
+	return &per_cpu(sched_core_locks, cpumask_first(cpu_smt_mask(cpu)));
+}
+
+/*
+ * Kick a sibling without taking its rq lock. A kick racing with the sibling's
+ * own context switch can get lost, sched_core_tick() catches that.
+ */
+static inline void sched_core_kick(struct rq *rq)
+{
+	struct task_struct *curr;
+
+	rcu_read_lock();
+	curr = rcu_dereference(rq->curr);
+	if (set_nr_and_not_polling(curr))
+		smp_send_reschedule(cpu_of(rq));
+	rcu_read_unlock();
+}
+
+/*
+ * Whether @p may run next to the siblings' picks. With @preempt, busy siblings
+ * running lower priority tasks don't conflict, they get kicked instead. A
+ * forced idle sibling's claim wins ties against the task that just ran, so
+ * equal priority cookies take turns.
+ */
+static bool sched_core_fits(struct rq *rq, struct task_struct *p, bool preempt)
+{
+	int i, prio = task_sched_prio(p);
+
+	for_each_cpu(i, cpu_smt_mask(cpu_of(rq))) {
+		struct rq *srq = cpu_rq(i);
+
+		if (srq == rq || srq->core_cookie == p->core_cookie)
+			continue;
+		if (srq->core_busy) {
+			if (!preempt || srq->core_prio <= prio)
+				return false;
+		} else if (srq->core_forceidle) {
+			if (srq->core_prio < prio ||
+			    (srq->core_prio == prio && p == rq->curr))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+#ifdef CONFIG_SCHEDSTATS
+/* Charge forced idle time to the tasks running on the siblings */
+static void sched_core_account_forceidle(struct rq *rq)
+{
+	u64 delta, now = rq_clock(rq);
+	int i;
+
+	delta = now - rq->core_forceidle_start;
+	rq->core_forceidle_start = now;
+	if (!schedstat_enabled() || (s64)delta <= 0)
+		return;
+
+	rcu_read_lock();
+	for_each_cpu(i, cpu_smt_mask(cpu_of(rq))) {
+		struct rq *srq = cpu_rq(i);
+
+		if (srq != rq && srq->core_busy)
+			__account_forceidle_time(rcu_dereference(srq->curr), delta);
+	}
+	rcu_read_unlock();
+}
+#else
+static inline void sched_core_account_forceidle(struct rq *rq) {}
+#endif
+
+static struct task_struct *__sched_core_pick(struct rq *rq, struct task_struct *next)
+{
+	raw_spinlock_t *lock = sched_core_lockp(cpu_of(rq));
+	unsigned long old_cookie = rq->core_cookie;
+	bool old_busy = rq->core_busy;
+	struct task_struct *p = next;
+	int i;
+
+	raw_spin_lock(lock);
+
+	if (next != rq->idle && !sched_core_fits(rq, next, true)) {
+		do {
+			p = sched_rq_next_task(p, rq);
+		} while (p != rq->idle && !sched_core_fits(rq, p, false));
+	}
+
+	if (rq->core_forceidle)
+		sched_core_account_forceidle(rq);
+
+	if (p == rq->idle && next != rq->idle) {
+		/* Forced idle, publish the claim of the task we couldn't run */
+		if (!rq->core_forceidle)
+			rq->core_forceidle_start = rq_clock(rq);
+		rq->core_forceidle = true;
+		rq->core_busy = false;
+		rq->core_cookie = next->core_cookie;
+		rq->core_prio = task_sched_prio(next);
+	} else {
+		rq->core_forceidle = false;
+		rq->core_busy = (p != rq->idle);
+		rq->core_cookie = p->core_cookie;
+		rq->core_prio = task_sched_prio(p);
+	}
+
+	for_each_cpu(i, cpu_smt_mask(cpu_of(rq))) {
+		struct rq *srq = cpu_rq(i);
+
+		if (srq == rq)
+			continue;
+		/* Siblings running a lower priority, incompatible task */
+		if (rq->core_busy && srq->core_busy &&
+		    srq->core_cookie != rq->core_cookie)
+			sched_core_kick(srq);
+		/* Forced idle siblings may be able to run again */
+		else if (srq->core_forceidle &&
+			 (old_busy != rq->core_busy || old_cookie != rq->core_cookie))
+			sched_core_kick(srq);
+	}
+
+	raw_spin_unlock(lock);
+
+	return p;
+}
+
+static inline struct task_struct *sched_core_pick(struct rq *rq, struct task_struct *next)
+{
+	if (!sched_core_enabled(rq))
+		return next;
+	return __sched_core_pick(rq, next);
+}
+
+static void sched_core_tick(struct rq *rq)
+{
+	struct task_struct *curr = rq->curr;
+	raw_spinlock_t *lock;
+	int i, prio;
+
+	if (!sched_core_enabled(rq))
+		return;
+
+	lock = sched_core_lockp(cpu_of(rq));
+	raw_spin_lock(lock);
+
+	if (rq->core_forceidle)
+		sched_core_account_forceidle(rq);
+
+	/* Yield to a higher priority, incompatible sibling whose kick got lost */
+	if (!is_idle_task(curr)) {
+		prio = task_sched_prio(curr);
+		for_each_cpu(i, cpu_smt_mask(cpu_of(rq))) {
+			struct rq *srq = cpu_rq(i);
+
+			if (srq != rq && srq->core_busy &&
+			    srq->core_cookie != curr->core_cookie &&
+			    srq->core_prio <= prio) {
+				resched_curr(rq);
+				break;
+			}
+		}
+	}
+
+	raw_spin_unlock(lock);
+}
+
+int sched_core_idle_cpu(int cpu)
+{
+	struct rq *rq = cpu_rq(cpu);
+
+	if (sched_core_enabled(rq) && rq->curr == rq->idle)
+		return 1;
+
+	return idle_cpu(cpu);
+}
+
+static void __sched_core_enable(void)
+{
+	int cpu;
+
+	static_branch_enable(&__sched_core_enabled);
+
+	/* Have every CPU publish its pick */
+	cpus_read_lock();
+	for_each_online_cpu(cpu)
+		resched_cpu(cpu);
+	cpus_read_unlock();
+}
+
+static void __sched_core_disable(void)
+{
+	unsigned long flags;
+	int cpu;
+
+	static_branch_disable(&__sched_core_enabled);
+	/* Picks run with irqs disabled, wait for the ones still in flight */
+	synchronize_rcu();
+
+	cpus_read_lock();
+	for_each_possible_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+		bool forceidle;
+
+		raw_spin_lock_irqsave(sched_core_lockp(cpu), flags);
+		forceidle = rq->core_forceidle;
+		rq->core_cookie = 0;
+		rq->core_busy = false;
+		rq->core_forceidle = false;
+		raw_spin_unlock_irqrestore(sched_core_lockp(cpu), flags);
+
+		if (forceidle && cpu_online(cpu))
+			resched_cpu(cpu);
+	}
+	cpus_read_unlock();
+}
+
+void sched_core_get(void)
+{
+	if (atomic_inc_not_zero(&sched_core_count))
+		return;
+
+	mutex_lock(&sched_core_mutex);
+	if (!atomic_read(&sched_core_count))
+		__sched_core_enable();
+
+	smp_mb__before_atomic();
+	atomic_inc(&sched_core_count);
+	mutex_unlock(&sched_core_mutex);
+}
+
+static void __sched_core_put(struct work_struct *work)
+{
+	if (atomic_dec_and_mutex_lock(&sched_core_count, &sched_core_mutex)) {
+		__sched_core_disable();
+		mutex_unlock(&sched_core_mutex);
+	}
+}
+
+void sched_core_put(void)
+{
+	static DECLARE_WORK(_work, __sched_core_put);
+
+	/*
+	 * Either this is the last one, or we don't actually need to do any
+	 * 'work'. If it is the last *again*, we rely on
+	 * WORK_STRUCT_PENDING_BIT.
+	 */
+	if (!atomic_add_unless(&sched_core_count, -1, 1))
+		schedule_work(&_work);
+}
+#else
+static inline struct task_struct *sched_core_pick(struct rq *rq, struct task_struct *next)
+{
+	return next;
+}
+
+static inline void sched_core_tick(struct rq *rq) {}
+#endif /* CONFIG_SCHED_CORE */
+
 /* This manages tasks that have run out of timeslice during a scheduler_tick */
 static inline void scheduler_task_tick(struct rq *rq)
 {
@@ -4177,6 +4565,7 @@ void scheduler_tick(void)
 	update_rq_clock(rq);
 
 	scheduler_task_tick(rq);
+	sched_core_tick(rq);
 	if (sched_feat(LATENCY_WARN))
 		resched_latency = cpu_resched_latency(rq);
 	calc_global_load_tick(rq);
@@ -4592,36 +4981,122 @@ inline void alt_sched_debug(void) {}
 const_debug unsigned int sysctl_sched_nr_migrate = SCHED_NR_MIGRATE_BREAK;
 
 /*
- * Migrate pending tasks in @rq to @dest_cpu
+ * Tasks which ran within this window are considered cache hot and are not
+ * stolen by idle balancing.
+ */
+const_debug unsigned int sysctl_sched_migration_cost = 500000UL;
+
+static inline bool task_cache_hot(struct task_struct *p, struct rq *rq)
+{
+	return (s64)(rq->clock_task - p->last_ran) < (s64)sysctl_sched_migration_cost;
+}
+
+/*
+ * Steal up to half of the runnable tasks pending in @rq for @dest_cpu in one
+ * pass. Tasks which can't run on @dest_cpu, including migration disabled
+ * ones, and cache hot tasks are left alone.
  */
 static inline int
 migrate_pending_tasks(struct rq *rq, struct rq *dest_rq, const int dest_cpu)
 {
-	struct task_struct *p, *skip = rq->curr;
+	struct task_struct *p, *next;
 	int nr_migrated = 0;
-	int nr_tries = min(rq->nr_running / 2, sysctl_sched_nr_migrate);
+	int nr_steal = min(rq->nr_running / 2, sysctl_sched_nr_migrate);
+	int nr_tries = rq->nr_running;
 
 	/* WA to check rq->curr is still on rq */
-	if (!task_on_rq_queued(skip))
+	if (!task_on_rq_queued(rq->curr))
 		return 0;
 
-	while (skip != rq->idle && nr_tries &&
-	       (p = sched_rq_next_task(skip, rq)) != rq->idle) {
-		skip = sched_rq_next_task(p, rq);
-		if (cpumask_test_cpu(dest_cpu, p->cpus_ptr)) {
-			__SCHED_DEQUEUE_TASK(p, rq, 0, );
-			set_task_cpu(p, dest_cpu);
-			sched_task_sanity_check(p, dest_rq);
-			sched_mm_cid_migrate_to(dest_rq, p, cpu_of(rq));
-			__SCHED_ENQUEUE_TASK(p, dest_rq, 0, );
-			nr_migrated++;
-		}
-		nr_tries--;
+	for (p = sched_rq_next_task(rq->curr, rq);
+	     p != rq->idle && nr_tries && nr_migrated < nr_steal;
+	     p = next, nr_tries--) {
+		next = sched_rq_next_task(p, rq);
+		if (!cpumask_test_cpu(dest_cpu, p->cpus_ptr) ||
+		    task_cache_hot(p, rq))
+			continue;
+
+		/* The preempt masks are updated once, by the caller */
+		__SCHED_DEQUEUE_TASK(p, rq, 0, do { } while (0));
+		set_task_cpu(p, dest_cpu);
+		sched_task_sanity_check(p, dest_rq);
+		sched_mm_cid_migrate_to(dest_rq, p, cpu_of(rq));
+		__SCHED_ENQUEUE_TASK(p, dest_rq, 0, do { } while (0));
+		nr_migrated++;
 	}
 
 	return nr_migrated;
 }
 
+/*
+ * Try to pull pending tasks from @src_rq, whose lock is only ever trylocked
+ * here since the caller already holds @rq->lock.
+ */
+static inline int take_rq_tasks(struct rq *rq, int cpu, struct rq *src_rq)
+{
+	int nr_migrated;
+
+	if (!do_raw_spin_trylock(&src_rq->lock)) {
+		rq->nr_steal_fail++;
+		return 0;
+	}
+	spin_acquire(&src_rq->lock.dep_map, SINGLE_DEPTH_NESTING, 1, _RET_IP_);
+
+	nr_migrated = migrate_pending_tasks(src_rq, rq, cpu);
+	if (nr_migrated) {
+		src_rq->nr_running -= nr_migrated;
+		if (src_rq->nr_running < 2)
+			sched_rq_pending_clear(cpu_of(src_rq));
+
+		spin_release(&src_rq->lock.dep_map, _RET_IP_);
+		do_raw_spin_unlock(&src_rq->lock);
+
+		rq->nr_running += nr_migrated;
+		if (rq->nr_running > 1)
+			sched_rq_pending_set(cpu);
+
+		update_sched_preempt_mask(rq);
+		cpufreq_update_util(rq, 0);
+
+		rq->nr_steal += nr_migrated;
+		return 1;
+	}
+
+	spin_release(&src_rq->lock.dep_map, _RET_IP_);
+	do_raw_spin_unlock(&src_rq->lock);
+
+	rq->nr_steal_fail++;
+	return 0;
+}
+
+#ifdef CONFIG_SCHED_ALT_LLC_PENDING
+/*
+ * take_llc_rq_tasks - pull from the busiest run queue of this cpu's LLC
+ *
+ * The shared per-LLC pending mask and the lockless nr_running reads let us
+ * pick one victim up front, so at most a single remote rq->lock is tried
+ * instead of trylocking every sibling in turn.
+ */
+static inline int take_llc_rq_tasks(struct rq *rq, int cpu)
+{
+	unsigned int nr, max_nr = 1;
+	struct rq *src_rq = NULL;
+	int i;
+
+	for_each_cpu_wrap(i, per_cpu(sched_llc_pending_mask, cpu), cpu) {
+		if (i == cpu)
+			continue;
+		nr = READ_ONCE(cpu_rq(i)->nr_running);
+		if (nr > max_nr) {
+			max_nr = nr;
+			src_rq = cpu_rq(i);
+		}
+	}
+
+	return src_rq ? take_rq_tasks(rq, cpu, src_rq) : 0;
+}
+#endif /* CONFIG_SCHED_ALT_LLC_PENDING */
+
 static inline int take_other_rq_tasks(struct rq *rq, int cpu)
 {
 	cpumask_t *topo_mask, *end_mask, chk;
@@ -4634,44 +5109,23 @@ static inline int take_other_rq_tasks(struct rq *rq, int cpu)
 
 	topo_mask = per_cpu(sched_cpu_topo_masks, cpu);
 	end_mask = per_cpu(sched_cpu_topo_end_mask, cpu);
-	do {
+#ifdef CONFIG_SCHED_ALT_LLC_PENDING
+	if (take_llc_rq_tasks(rq, cpu))
+		return 1;
+	/* Levels up to and including the LLC have just been covered. */
+	topo_mask = per_cpu(sched_cpu_llc_mask, cpu) + 1;
+#endif
+	for (; topo_mask < end_mask; topo_mask++) {
 		int i;
 
 		if (!cpumask_and(&chk, &sched_rq_pending_mask, topo_mask))
 			continue;
 
 		for_each_cpu_wrap(i, &chk, cpu) {
-			int nr_migrated;
-			struct rq *src_rq;
-
-			src_rq = cpu_rq(i);
-			if (!do_raw_spin_trylock(&src_rq->lock))
-				continue;
-			spin_acquire(&src_rq->lock.dep_map,
-				     SINGLE_DEPTH_NESTING, 1, _RET_IP_);
-
-			if ((nr_migrated = migrate_pending_tasks(src_rq, rq, cpu))) {
-				src_rq->nr_running -= nr_migrated;
-				if (src_rq->nr_running < 2)
-					cpumask_clear_cpu(i, &sched_rq_pending_mask);
-
-				spin_release(&src_rq->lock.dep_map, _RET_IP_);
-				do_raw_spin_unlock(&src_rq->lock);
-
-				rq->nr_running += nr_migrated;
-				if (rq->nr_running > 1)
-					cpumask_set_cpu(cpu, &sched_rq_pending_mask);
-
-				update_sched_preempt_mask(rq);
-				cpufreq_update_util(rq, 0);
-
+			if (take_rq_tasks(rq, cpu, cpu_rq(i)))
 				return 1;
-			}
-
-			spin_release(&src_rq->lock.dep_map, _RET_IP_);
-			do_raw_spin_unlock(&src_rq->lock);
 		}
-	} while (++topo_mask < end_mask);
+	}
 
 	return 0;
 }
@@ -4720,12 +5174,13 @@ choose_next_task(struct rq *rq, int cpu)
 #endif
 			schedstat_inc(rq->sched_goidle);
 			/*printk(KERN_INFO "sched: choose_next_task(%d) idle %px\n", cpu, next);*/
-			return next;
+			return sched_core_pick(rq, next);
 #ifdef	CONFIG_SMP
 		}
 		next = sched_rq_first_task(rq);
 #endif
 	}
+	next = sched_core_pick(rq, next);
 #ifdef CONFIG_HIGH_RES_TIMERS
 	hrtick_start(rq, next->time_slice);
 #endif
@@ -5675,7 +6130,7 @@ static int __sched_setscheduler(struct task_struct *p,
 	struct balance_callback *head;
 	unsigned long flags;
 	struct rq *rq;
-	int reset_on_fork;
+	int reset_on_fork, no_iowait_boost;
 	raw_spinlock_t *lock;
 
 	/* The pi code expects interrupts enabled */
@@ -5692,9 +6147,11 @@ static int __sched_setscheduler(struct task_struct *p,
 	/* Double check policy once rq lock held */
 	if (policy < 0) {
 		reset_on_fork = p->sched_reset_on_fork;
+		no_iowait_boost = p->sched_no_iowait_boost;
 		policy = oldpolicy = p->policy;
 	} else {
 		reset_on_fork = !!(attr->sched_flags & SCHED_RESET_ON_FORK);
+		no_iowait_boost = !!(attr->sched_flags & SCHED_FLAG_NO_IOWAIT_BOOST);
 
 		if (policy > SCHED_IDLE)
 			return -EINVAL;
@@ -5761,6 +6218,7 @@ static int __sched_setscheduler(struct task_struct *p,
 			goto change;
 
 		p->sched_reset_on_fork = reset_on_fork;
+		p->sched_no_iowait_boost = no_iowait_boost;
 		retval = 0;
 		goto unlock;
 	}
@@ -5775,6 +6233,7 @@ static int __sched_setscheduler(struct task_struct *p,
 	}
 
 	p->sched_reset_on_fork = reset_on_fork;
+	p->sched_no_iowait_boost = no_iowait_boost;
 
 	newprio = __normal_prio(policy, attr->sched_priority, NICE_TO_PRIO(attr->sched_nice));
 	if (pi) {
@@ -6188,6 +6647,8 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 		kattr.sched_policy = p->policy;
 		if (p->sched_reset_on_fork)
 			kattr.sched_flags |= SCHED_FLAG_RESET_ON_FORK;
+		if (p->sched_no_iowait_boost)
+			kattr.sched_flags |= SCHED_FLAG_NO_IOWAIT_BOOST;
 		get_params(p, &kattr);
 		kattr.sched_flags &= SCHED_FLAG_ALL;
 
@@ -7604,6 +8065,9 @@ static void sched_init_topology_cpumask_early(void)
 		cpumask_copy(tmp, cpu_possible_mask);
 		per_cpu(sched_cpu_llc_mask, cpu) = tmp;
 		per_cpu(sched_cpu_topo_end_mask, cpu) = ++tmp;
+#ifdef CONFIG_SCHED_ALT_LLC_PENDING
+		per_cpu(sched_llc_pending_mask, cpu) = &per_cpu(sched_llc_pending_masks, cpu);
+#endif
 	}
 }
 
@@ -7637,6 +8101,12 @@ static void sched_init_topology_cpumask(void)
 
 		per_cpu(sd_llc_id, cpu) = cpumask_first(cpu_coregroup_mask(cpu));
 		per_cpu(sched_cpu_llc_mask, cpu) = topo;
+#ifdef CONFIG_SCHED_ALT_LLC_PENDING
+		per_cpu(sched_llc_pending_mask, cpu) =
+			&per_cpu(sched_llc_pending_masks, per_cpu(sd_llc_id, cpu));
+		if (cpumask_test_cpu(cpu, &sched_rq_pending_mask))
+			cpumask_set_cpu(cpu, per_cpu(sched_llc_pending_mask, cpu));
+#endif
 		TOPOLOGY_CPUMASK(coregroup, cpu_coregroup_mask(cpu), false);
 
 		TOPOLOGY_CPUMASK(core, topology_core_cpumask(cpu), false);
@@ -7650,6 +8120,28 @@ static void sched_init_topology_cpumask(void)
 			      per_cpu(sched_cpu_topo_masks, cpu)));
 	}
 }
+
+static void sched_init_capacity_cpumask(void)
+{
+	unsigned long cap, max_cap = 0;
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		max_cap = max(max_cap, arch_scale_cpu_capacity(cpu));
+
+	cpumask_clear(&sched_cpu_big_mask);
+	for_each_online_cpu(cpu) {
+		cap = arch_scale_cpu_capacity(cpu);
+		if (cap == max_cap)
+			cpumask_set_cpu(cpu, &sched_cpu_big_mask);
+	}
+
+	if (!cpumask_equal(&sched_cpu_big_mask, cpu_online_mask)) {
+		static_branch_enable(&sched_asym_cpucapacity);
+		pr_info("sched: asym cpu capacity, big cpus: %*pbl\n",
+			cpumask_pr_args(&sched_cpu_big_mask));
+	}
+}
 #endif
 
 void __init sched_init_smp(void)
@@ -7660,6 +8152,7 @@ void __init sched_init_smp(void)
 	current->flags &= ~PF_NO_SETAFFINITY;
 
 	sched_init_topology_cpumask();
+	sched_init_capacity_cpumask();
 
 	sched_smp_initialized = true;
 }
@@ -7730,6 +8223,9 @@ void __init sched_init(void)
 #endif
 
 		raw_spin_lock_init(&rq->lock);
+#ifdef CONFIG_SCHED_CORE
+		raw_spin_lock_init(&per_cpu(sched_core_locks, i));
+#endif
 		rq->nr_running = rq->nr_uninterruptible = 0;
 		rq->calc_load_active = 0;
 		rq->calc_load_update = jiffies + LOAD_FREQ;
@@ -8,6 +8,8 @@
  */
 #include "sched.h"
 #include "linux/sched/debug.h"
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 /*
  * This allows printing both to /proc/sched_debug and
@@ -30,3 +32,30 @@ void proc_sched_show_task(struct task_struct *p, struct pid_namespace *ns,
 
 void proc_sched_set_task(struct task_struct *p)
 {}
+
+#ifdef CONFIG_SMP
+static int sched_steal_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	seq_puts(m, "cpu steal steal_fail\n");
+	for_each_online_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		seq_printf(m, "cpu%d %lu %lu\n", cpu,
+			   READ_ONCE(rq->nr_steal), READ_ONCE(rq->nr_steal_fail));
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(sched_steal);
+#endif /* CONFIG_SMP */
+
+void __init alt_sched_debugfs_init(struct dentry *parent)
+{
+#ifdef CONFIG_SMP
+	debugfs_create_u32("migration_cost_ns", 0644, parent, &sysctl_sched_migration_cost);
+	debugfs_create_u32("nr_migrate", 0644, parent, &sysctl_sched_nr_migrate);
+	debugfs_create_file("steal", 0444, parent, NULL, &sched_steal_fops);
+#endif
+}
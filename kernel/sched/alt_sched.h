@@ -220,6 +220,18 @@ struct rq {
 #endif
 	unsigned int		nr_pinned;
 
+	/* idle balance work stealing stats */
+	unsigned long		nr_steal;
+	unsigned long		nr_steal_fail;
+
+#ifdef CONFIG_SCHED_CORE
+	/* Published pick of this CPU, protected by the per-core lock */
+	unsigned long		core_cookie;
+	int			core_prio;
+	bool			core_busy;
+	bool			core_forceidle;
+	u64			core_forceidle_start;
+#endif
 #endif /* CONFIG_SMP */
 #ifdef CONFIG_IRQ_TIME_ACCOUNTING
 	u64 prev_irq_time;
@@ -293,6 +305,16 @@ struct rq {
 
 extern unsigned int sysctl_sched_base_slice;
 
+#ifdef CONFIG_SMP
+extern const_debug unsigned int sysctl_sched_nr_migrate;
+extern const_debug unsigned int sysctl_sched_migration_cost;
+#endif
+
+#ifdef CONFIG_SCHED_DEBUG
+struct dentry;
+extern void alt_sched_debugfs_init(struct dentry *parent);
+#endif
+
 extern unsigned long rq_load_util(struct rq *rq, unsigned long max);
 
 extern unsigned long calc_load_update;
@@ -397,19 +419,6 @@ static inline u64 rq_clock_task(struct rq *rq)
 	return rq->clock_task;
 }
 
-/*
- * {de,en}queue flags:
- *
- * DEQUEUE_SLEEP  - task is no longer runnable
- * ENQUEUE_WAKEUP - task just became runnable
- *
- */
-
-#define DEQUEUE_SLEEP		0x01
-
-#define ENQUEUE_WAKEUP		0x01
-
-
 /*
  * Below are scheduler API which using in other kernel code
  * It use the dummy rq_flags
@@ -518,6 +527,8 @@ static inline void raw_spin_rq_unlock_irq(struct rq *rq)
 	local_irq_enable();
 }
 
+extern void resched_curr(struct rq *rq);
+
 static inline int task_current(struct rq *rq, struct task_struct *p)
 {
 	return rq->curr == p;
@@ -530,6 +541,29 @@ static inline bool task_on_cpu(struct task_struct *p)
 
 extern int task_running_nice(struct task_struct *p);
 
+#ifdef CONFIG_SCHED_CORE
+DECLARE_STATIC_KEY_FALSE(__sched_core_enabled);
+
+static inline bool sched_core_enabled(struct rq *rq)
+{
+	return static_branch_unlikely(&__sched_core_enabled);
+}
+
+/*
+ * Alt schedule FW keeps no per-core cookie tree, cookies are matched against
+ * the run queue at pick time, see __sched_core_pick(). The hooks below only
+ * exist for core_sched.c.
+ */
+
+static inline bool sched_core_enqueued(struct task_struct *p) { return false; }
+static inline void sched_core_enqueue(struct rq *rq, struct task_struct *p) {}
+static inline void
+sched_core_dequeue(struct rq *rq, struct task_struct *p, int flags) {}
+
+extern void sched_core_get(void);
+extern void sched_core_put(void);
+#endif /* CONFIG_SCHED_CORE */
+
 extern struct static_key_false sched_schedstats;
 
 #ifdef CONFIG_CPU_IDLE
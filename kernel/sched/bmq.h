@@ -96,3 +96,9 @@ static inline void sched_task_deactivate(struct task_struct *p, struct rq *rq)
 {
 	boost_task(p, 1);
 }
+
+/* Tasks past half of the maximum boost prefer high capacity CPUs */
+static inline bool sched_task_prefer_big(const struct task_struct *p)
+{
+	return p->boost_prio <= -MAX_PRIORITY_ADJ / 2;
+}
@@ -1010,9 +1010,55 @@ void wake_q_add_safe(struct wake_q_head *head, struct task_struct *task)
 		put_task_struct(task);
 }
 
+#ifdef CONFIG_SMP
+/*
+ * While wake_up_q() batches, __ttwu_queue_wakelist() only queues the wakee on
+ * the target's wakelist and records the target here; the IPIs then go out as
+ * a single multicast once the whole wake_q has been processed.
+ */
+static DEFINE_PER_CPU(bool, ttwu_batching);
+static DEFINE_PER_CPU(cpumask_t, ttwu_batch_mask);
+
+static inline bool ttwu_batch_begin(struct wake_q_head *head)
+{
+	/* Nothing to batch for a single wakeup */
+	if (!sched_feat(TTWU_BATCH) || head->first == WAKE_Q_TAIL ||
+	    head->first->next == WAKE_Q_TAIL)
+		return false;
+
+	preempt_disable();
+	if (__this_cpu_read(ttwu_batching)) {
+		preempt_enable();
+		return false;
+	}
+	__this_cpu_write(ttwu_batching, true);
+
+	return true;
+}
+
+static inline void ttwu_batch_end(void)
+{
+	struct cpumask *mask = this_cpu_ptr(&ttwu_batch_mask);
+	unsigned long flags;
+
+	local_irq_save(flags);
+	__this_cpu_write(ttwu_batching, false);
+	if (!cpumask_empty(mask)) {
+		__smp_call_single_ipi_mask(mask);
+		cpumask_clear(mask);
+	}
+	local_irq_restore(flags);
+	preempt_enable();
+}
+#else
+static inline bool ttwu_batch_begin(struct wake_q_head *head) { return false; }
+static inline void ttwu_batch_end(void) {}
+#endif /* CONFIG_SMP */
+
 void wake_up_q(struct wake_q_head *head)
 {
 	struct wake_q_node *node = head->first;
+	bool batch = ttwu_batch_begin(head);
 
 	while (node != WAKE_Q_TAIL) {
 		struct task_struct *task;
@@ -1029,6 +1075,9 @@ void wake_up_q(struct wake_q_head *head)
 		wake_up_process(task);
 		put_task_struct(task);
 	}
+
+	if (batch)
+		ttwu_batch_end();
 }
 
 /*
@@ -3938,6 +3987,11 @@ static void __ttwu_queue_wakelist(struct task_struct *p, int cpu, int wake_flags
 	p->sched_remote_wakeup = !!(wake_flags & WF_MIGRATED);
 
 	WRITE_ONCE(rq->ttwu_pending, 1);
+	if (__this_cpu_read(ttwu_batching)) {
+		if (__smp_call_single_queue_noipi(cpu, &p->wake_entry.llist))
+			cpumask_set_cpu(cpu, this_cpu_ptr(&ttwu_batch_mask));
+		return;
+	}
 	__smp_call_single_queue(cpu, &p->wake_entry.llist);
 }
 
@@ -4535,6 +4589,9 @@ static void __sched_fork(unsigned long clone_flags, struct task_struct *p)
 	p->se.vlag			= 0;
 	p->se.slice			= sysctl_sched_base_slice;
 	INIT_LIST_HEAD(&p->se.group_node);
+#ifdef CONFIG_SMP
+	memset(p->se.cpu_history, -1, sizeof(p->se.cpu_history));
+#endif
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	p->se.cfs_rq			= NULL;
@@ -5679,6 +5736,7 @@ void scheduler_tick(void)
 	rq_lock(rq, &rf);
 
 	update_rq_clock(rq);
+	psi_tick(cpu);
 	thermal_pressure = arch_scale_thermal_pressure(cpu_of(rq));
 	update_thermal_load_avg(rq_clock_thermal(rq), rq, thermal_pressure);
 	curr->sched_class->task_tick(rq, curr, 0);
@@ -7568,6 +7626,14 @@ unsigned long sched_cpu_util(int cpu)
 }
 #endif /* CONFIG_SMP */
 
+unsigned long sched_cpu_uclamp_min(int cpu)
+{
+	if (!uclamp_is_used())
+		return 0;
+
+	return uclamp_rq_get(cpu_rq(cpu), UCLAMP_MIN);
+}
+
 /**
  * find_process_by_pid - find a process with a matching PID value.
  * @pid: the pid in question.
@@ -7710,7 +7776,7 @@ static int __sched_setscheduler(struct task_struct *p,
 	const struct sched_class *prev_class;
 	struct balance_callback *head;
 	struct rq_flags rf;
-	int reset_on_fork;
+	int reset_on_fork, no_iowait_boost;
 	int queue_flags = DEQUEUE_SAVE | DEQUEUE_MOVE | DEQUEUE_NOCLOCK;
 	struct rq *rq;
 	bool cpuset_locked = false;
@@ -7721,9 +7787,11 @@ static int __sched_setscheduler(struct task_struct *p,
 	/* Double check policy once rq lock held: */
 	if (policy < 0) {
 		reset_on_fork = p->sched_reset_on_fork;
+		no_iowait_boost = p->sched_no_iowait_boost;
 		policy = oldpolicy = p->policy;
 	} else {
 		reset_on_fork = !!(attr->sched_flags & SCHED_FLAG_RESET_ON_FORK);
+		no_iowait_boost = !!(attr->sched_flags & SCHED_FLAG_NO_IOWAIT_BOOST);
 
 		if (!valid_policy(policy))
 			return -EINVAL;
@@ -7805,6 +7873,7 @@ static int __sched_setscheduler(struct task_struct *p,
 			goto change;
 
 		p->sched_reset_on_fork = reset_on_fork;
+		p->sched_no_iowait_boost = no_iowait_boost;
 		retval = 0;
 		goto unlock;
 	}
@@ -7862,6 +7931,7 @@ static int __sched_setscheduler(struct task_struct *p,
 	}
 
 	p->sched_reset_on_fork = reset_on_fork;
+	p->sched_no_iowait_boost = no_iowait_boost;
 	oldprio = p->prio;
 
 	newprio = __normal_prio(policy, attr->sched_priority, attr->sched_nice);
@@ -8311,6 +8381,8 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 		kattr.sched_policy = p->policy;
 		if (p->sched_reset_on_fork)
 			kattr.sched_flags |= SCHED_FLAG_RESET_ON_FORK;
+		if (p->sched_no_iowait_boost)
+			kattr.sched_flags |= SCHED_FLAG_NO_IOWAIT_BOOST;
 		get_params(p, &kattr);
 		kattr.sched_flags &= SCHED_FLAG_ALL;
 
@@ -10343,8 +10415,27 @@ static inline void alloc_uclamp_sched_group(struct task_group *tg,
 #endif
 }
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+/*
+ * Account a run delay histogram bucket to all groups of @t but the root, which
+ * is covered by /proc/schedstat. Called with @rq locked from sched_info_arrive().
+ */
+void tg_lat_hist_account(struct rq *rq, struct task_struct *t, unsigned int idx)
+{
+	struct task_group *tg;
+
+	for (tg = task_group(t); tg && tg != &root_task_group; tg = tg->parent) {
+		if (tg->lat_hist)
+			per_cpu_ptr(tg->lat_hist, cpu_of(rq))[idx]++;
+	}
+}
+#endif /* CONFIG_SCHED_LATENCY_HIST */
+
 static void sched_free_group(struct task_group *tg)
 {
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	free_percpu(tg->lat_hist);
+#endif
 	free_fair_sched_group(tg);
 	free_rt_sched_group(tg);
 	autogroup_free(tg);
@@ -10382,6 +10473,13 @@ struct task_group *sched_create_group(struct task_group *parent)
 	if (!alloc_rt_sched_group(tg, parent))
 		goto err;
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	tg->lat_hist = __alloc_percpu(sizeof(unsigned long) * SCHED_LAT_HIST_BUCKETS,
+				      __alignof__(unsigned long));
+	if (!tg->lat_hist)
+		goto err;
+#endif
+
 	alloc_uclamp_sched_group(tg, parent);
 
 	return tg;
@@ -11271,6 +11369,10 @@ static int cpu_extra_stat_show(struct seq_file *sf,
 			   cfs_b->nr_periods, cfs_b->nr_throttled,
 			   throttled_usec, cfs_b->nr_burst, burst_usec);
 	}
+#endif
+#ifdef CONFIG_FAIR_GROUP_SCHED
+	seq_printf(sf, "nr_preempt_throttled %ld\n",
+		   atomic_long_read(&css_tg(css)->nr_preempt_throttled));
 #endif
 	return 0;
 }
@@ -11413,6 +11515,78 @@ static ssize_t cpu_max_write(struct kernfs_open_file *of,
 }
 #endif
 
+#ifdef CONFIG_FAIR_GROUP_SCHED
+#define PREEMPT_PERIOD_DEFAULT_USEC	100000UL
+
+static int cpu_preempt_max_show(struct seq_file *sf, void *v)
+{
+	struct task_group *tg = css_tg(seq_css(sf));
+	unsigned int budget = READ_ONCE(tg->preempt_budget);
+	u64 period = READ_ONCE(tg->preempt_period);
+
+	if (budget)
+		seq_printf(sf, "%u", budget);
+	else
+		seq_puts(sf, "max");
+
+	seq_printf(sf, " %llu\n",
+		   period ? div_u64(period, NSEC_PER_USEC) : PREEMPT_PERIOD_DEFAULT_USEC);
+	return 0;
+}
+
+static ssize_t cpu_preempt_max_write(struct kernfs_open_file *of,
+				     char *buf, size_t nbytes, loff_t off)
+{
+	struct task_group *tg = css_tg(of_css(of));
+	u64 period = READ_ONCE(tg->preempt_period);
+	unsigned int budget;
+	char tok[11];	/* UINT_MAX */
+
+	period = period ? div_u64(period, NSEC_PER_USEC) : PREEMPT_PERIOD_DEFAULT_USEC;
+	if (sscanf(buf, "%10s %llu", tok, &period) < 1)
+		return -EINVAL;
+
+	if (!strcmp(tok, "max"))
+		budget = 0;
+	else if (kstrtouint(tok, 10, &budget) || !budget)
+		return -EINVAL;
+
+	/* The budget is refilled into the atomic_t preempt_tokens */
+	if (budget > INT_MAX)
+		return -ERANGE;
+
+	if (period < 1000 || period > USEC_PER_SEC)
+		return -ERANGE;
+
+	WRITE_ONCE(tg->preempt_period, period * NSEC_PER_USEC);
+	atomic_set(&tg->preempt_tokens, budget);
+	WRITE_ONCE(tg->preempt_budget, budget);
+	return nbytes;
+}
+#endif
+
+#ifdef CONFIG_SCHED_LATENCY_HIST
+static int cpu_stat_hist_show(struct seq_file *sf, void *v)
+{
+	struct task_group *tg = css_tg(seq_css(sf));
+	unsigned long hist[SCHED_LAT_HIST_BUCKETS] = { };
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		unsigned long *h = per_cpu_ptr(tg->lat_hist, cpu);
+
+		for (i = 0; i < SCHED_LAT_HIST_BUCKETS; i++)
+			hist[i] += READ_ONCE(h[i]);
+	}
+
+	for (i = 0; i < SCHED_LAT_HIST_BUCKETS - 1; i++)
+		seq_printf(sf, "%llu %lu\n", 1024ULL << i, hist[i]);
+	seq_printf(sf, "inf %lu\n", hist[i]);
+
+	return 0;
+}
+#endif
+
 static struct cftype cpu_files[] = {
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
@@ -11433,6 +11607,19 @@ static struct cftype cpu_files[] = {
 		.read_s64 = cpu_idle_read_s64,
 		.write_s64 = cpu_idle_write_s64,
 	},
+	{
+		.name = "preempt.max",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cpu_preempt_max_show,
+		.write = cpu_preempt_max_write,
+	},
+#endif
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	{
+		.name = "stat.hist",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cpu_stat_hist_show,
+	},
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
@@ -88,7 +88,11 @@ static unsigned long sched_core_update_cookie(struct task_struct *p,
 	 * core has now entered/left forced idle state. Defer accounting to the
 	 * next scheduling edge, rather than always forcing a reschedule here.
 	 */
+#ifdef CONFIG_SCHED_ALT
+	if (task_on_cpu(p))
+#else
 	if (task_on_cpu(rq, p))
+#endif
 		resched_curr(rq);
 
 	task_rq_unlock(rq, p, &rf);
@@ -234,7 +238,7 @@ int sched_core_share_pid(unsigned int cmd, pid_t pid, enum pid_type type,
 	return err;
 }
 
-#ifdef CONFIG_SCHEDSTATS
+#if defined(CONFIG_SCHEDSTATS) && !defined(CONFIG_SCHED_ALT)
 
 /* REQUIRES: rq->core's clock recently updated. */
 void __sched_core_account_forceidle(struct rq *rq)
@@ -297,4 +301,4 @@ void __sched_core_tick(struct rq *rq)
 	__sched_core_account_forceidle(rq);
 }
 
-#endif /* CONFIG_SCHEDSTATS */
+#endif /* CONFIG_SCHEDSTATS && !CONFIG_SCHED_ALT */
@@ -11,6 +11,8 @@
 struct sugov_tunables {
 	struct gov_attr_set	attr_set;
 	unsigned int		rate_limit_us;
+	unsigned int		iowait_boost_rise_us;
+	unsigned int		iowait_boost_decay_us;
 };
 
 struct sugov_policy {
@@ -22,6 +24,9 @@ struct sugov_policy {
 	raw_spinlock_t		update_lock;
 	u64			last_freq_update_time;
 	s64			freq_update_delay_ns;
+	/* IO wait boost ramps, 0 for the default doubling/halving */
+	u64			iowait_rise_ns;
+	u64			iowait_decay_ns;
 	unsigned int		next_freq;
 	unsigned int		cached_raw_freq;
 
@@ -44,6 +49,7 @@ struct sugov_cpu {
 
 	bool			iowait_boost_pending;
 	unsigned int		iowait_boost;
+	u64			iowait_boost_time;
 	u64			last_update;
 
 	unsigned long		util;
@@ -232,10 +238,25 @@ static bool sugov_iowait_reset(struct sugov_cpu *sg_cpu, u64 time,
 
 	sg_cpu->iowait_boost = set_iowait_boost ? IOWAIT_BOOST_MIN : 0;
 	sg_cpu->iowait_boost_pending = set_iowait_boost;
+	sg_cpu->iowait_boost_time = time;
 
 	return true;
 }
 
+/*
+ * Linear IO wait boost ramp: the boost changes by @range over @span_ns. At least
+ * one capacity unit is applied per step so that the boost always moves.
+ */
+static unsigned int sugov_iowait_step(struct sugov_cpu *sg_cpu, u64 time,
+				      unsigned int range, u64 span_ns)
+{
+	u64 delta_ns = time - sg_cpu->iowait_boost_time;
+
+	sg_cpu->iowait_boost_time = time;
+
+	return max_t(u64, div64_u64((u64)range * delta_ns, span_ns), 1);
+}
+
 /**
  * sugov_iowait_boost() - Updates the IO boost status of a CPU.
  * @sg_cpu: the sugov data for the CPU to boost
@@ -269,15 +290,26 @@ static void sugov_iowait_boost(struct sugov_cpu *sg_cpu, u64 time,
 		return;
 	sg_cpu->iowait_boost_pending = true;
 
-	/* Double the boost at each request */
 	if (sg_cpu->iowait_boost) {
-		sg_cpu->iowait_boost =
-			min_t(unsigned int, sg_cpu->iowait_boost << 1, SCHED_CAPACITY_SCALE);
+		u64 rise_ns = sg_cpu->sg_policy->iowait_rise_ns;
+		unsigned int boost;
+
+		/* Ramp up over rise_ns, or double the boost at each request */
+		if (rise_ns)
+			boost = sg_cpu->iowait_boost +
+				sugov_iowait_step(sg_cpu, time,
+						  SCHED_CAPACITY_SCALE - IOWAIT_BOOST_MIN,
+						  rise_ns);
+		else
+			boost = sg_cpu->iowait_boost << 1;
+
+		sg_cpu->iowait_boost = min_t(unsigned int, boost, SCHED_CAPACITY_SCALE);
 		return;
 	}
 
 	/* First wakeup after IO: start with minimum boost */
 	sg_cpu->iowait_boost = IOWAIT_BOOST_MIN;
+	sg_cpu->iowait_boost_time = time;
 }
 
 /**
@@ -310,10 +342,20 @@ static unsigned long sugov_iowait_apply(struct sugov_cpu *sg_cpu, u64 time,
 		return 0;
 
 	if (!sg_cpu->iowait_boost_pending) {
+		u64 decay_ns = sg_cpu->sg_policy->iowait_decay_ns;
+		unsigned int step;
+
 		/*
-		 * No boost pending; reduce the boost value.
+		 * No boost pending; reduce the boost value, either along the
+		 * decay ramp or by halving it.
 		 */
-		sg_cpu->iowait_boost >>= 1;
+		if (decay_ns) {
+			step = sugov_iowait_step(sg_cpu, time, SCHED_CAPACITY_SCALE,
+						 decay_ns);
+			sg_cpu->iowait_boost -= min(step, sg_cpu->iowait_boost);
+		} else {
+			sg_cpu->iowait_boost >>= 1;
+		}
 		if (sg_cpu->iowait_boost < IOWAIT_BOOST_MIN) {
 			sg_cpu->iowait_boost = 0;
 			return 0;
@@ -582,8 +624,64 @@ rate_limit_us_store(struct gov_attr_set *attr_set, const char *buf, size_t count
 
 static struct governor_attr rate_limit_us = __ATTR_RW(rate_limit_us);
 
+static ssize_t iowait_boost_rise_us_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->iowait_boost_rise_us);
+}
+
+static ssize_t
+iowait_boost_rise_us_store(struct gov_attr_set *attr_set, const char *buf, size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+	struct sugov_policy *sg_policy;
+	unsigned int rise_us;
+
+	if (kstrtouint(buf, 10, &rise_us))
+		return -EINVAL;
+
+	tunables->iowait_boost_rise_us = rise_us;
+
+	list_for_each_entry(sg_policy, &attr_set->policy_list, tunables_hook)
+		WRITE_ONCE(sg_policy->iowait_rise_ns, (u64)rise_us * NSEC_PER_USEC);
+
+	return count;
+}
+
+static struct governor_attr iowait_boost_rise_us = __ATTR_RW(iowait_boost_rise_us);
+
+static ssize_t iowait_boost_decay_us_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->iowait_boost_decay_us);
+}
+
+static ssize_t
+iowait_boost_decay_us_store(struct gov_attr_set *attr_set, const char *buf, size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+	struct sugov_policy *sg_policy;
+	unsigned int decay_us;
+
+	if (kstrtouint(buf, 10, &decay_us))
+		return -EINVAL;
+
+	tunables->iowait_boost_decay_us = decay_us;
+
+	list_for_each_entry(sg_policy, &attr_set->policy_list, tunables_hook)
+		WRITE_ONCE(sg_policy->iowait_decay_ns, (u64)decay_us * NSEC_PER_USEC);
+
+	return count;
+}
+
+static struct governor_attr iowait_boost_decay_us = __ATTR_RW(iowait_boost_decay_us);
+
 static struct attribute *sugov_attrs[] = {
 	&rate_limit_us.attr,
+	&iowait_boost_rise_us.attr,
+	&iowait_boost_decay_us.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(sugov);
@@ -837,6 +935,8 @@ static int sugov_start(struct cpufreq_policy *policy)
 	unsigned int cpu;
 
 	sg_policy->freq_update_delay_ns	= sg_policy->tunables->rate_limit_us * NSEC_PER_USEC;
+	sg_policy->iowait_rise_ns	= (u64)sg_policy->tunables->iowait_boost_rise_us * NSEC_PER_USEC;
+	sg_policy->iowait_decay_ns	= (u64)sg_policy->tunables->iowait_boost_decay_us * NSEC_PER_USEC;
 	sg_policy->last_freq_update_time	= 0;
 	sg_policy->next_freq			= 0;
 	sg_policy->work_in_progress		= false;
@@ -380,6 +380,8 @@ static __init int sched_init_debug(void)
 #endif
 
 	debugfs_create_file("debug", 0444, debugfs_sched, NULL, &sched_debug_fops);
+#else
+	alt_sched_debugfs_init(debugfs_sched);
 #endif /* !CONFIG_SCHED_ALT */
 
 	return 0;
@@ -42,6 +42,7 @@
 #include <linux/interrupt.h>
 #include <linux/memory-tiers.h>
 #include <linux/mempolicy.h>
+#include <linux/migrate.h>
 #include <linux/mutex_api.h>
 #include <linux/profile.h>
 #include <linux/psi.h>
@@ -146,6 +147,13 @@ static unsigned int sysctl_sched_cfs_bandwidth_slice		= 5000UL;
 #ifdef CONFIG_NUMA_BALANCING
 /* Restrict the NUMA promotion throughput (MB/s) for each target node. */
 static unsigned int sysctl_numa_balancing_promote_rate_limit = 65536;
+
+/*
+ * Number of misplaced folios a task queues from NUMA hinting faults before
+ * migrating them together, 0 migrates each folio from its fault.
+ */
+unsigned int sysctl_numa_balancing_migrate_batch;
+static unsigned int numa_balancing_migrate_batch_max = NUMA_MIGRATE_BATCH_MAX;
 #endif
 
 #ifdef CONFIG_SYSCTL
@@ -169,6 +177,15 @@ static struct ctl_table sched_fair_sysctls[] = {
 		.proc_handler	= proc_dointvec_minmax,
 		.extra1		= SYSCTL_ZERO,
 	},
+	{
+		.procname	= "numa_balancing_migrate_batch",
+		.data		= &sysctl_numa_balancing_migrate_batch,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= &numa_balancing_migrate_batch_max,
+	},
 #endif /* CONFIG_NUMA_BALANCING */
 	{}
 };
@@ -3244,6 +3261,9 @@ static void task_numa_work(struct callback_head *work)
 	if (p->flags & PF_EXITING)
 		return;
 
+	/* Migrate what the hinting faults since the last scan queued */
+	migrate_misplaced_flush();
+
 	if (!mm->numa_next_scan) {
 		mm->numa_next_scan = now +
 			msecs_to_jiffies(sysctl_numa_balancing_scan_delay);
@@ -3477,6 +3497,7 @@ void init_numa_balancing(unsigned long clone_flags, struct task_struct *p)
 	/* Protect against double add, see task_tick_numa and task_numa_work */
 	p->numa_work.next		= &p->numa_work;
 	p->numa_faults			= NULL;
+	p->numa_migrate_batch		= NULL;
 	p->numa_pages_migrated		= 0;
 	p->total_numa_faults		= 0;
 	RCU_INIT_POINTER(p->numa_group, NULL);
@@ -6766,7 +6787,7 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	 * utilization updates, so do it here explicitly with the IOWAIT flag
 	 * passed.
 	 */
-	if (p->in_iowait)
+	if (p->in_iowait && !p->sched_no_iowait_boost)
 		cpufreq_update_util(rq, SCHED_CPUFREQ_IOWAIT);
 
 	for_each_sched_entity(se) {
@@ -6834,6 +6855,28 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 
 static void set_next_buddy(struct sched_entity *se);
 
+#ifdef CONFIG_SMP
+/*
+ * Remember @cpu as the latest CPU @p ran on, moving it to the front of the
+ * history if it is already present.
+ */
+static void update_cpu_history(struct task_struct *p, int cpu)
+{
+	int *hist = p->se.cpu_history;
+	int i;
+
+	if (hist[0] == cpu)
+		return;
+
+	for (i = 1; i < SE_CPU_HISTORY - 1; i++) {
+		if (hist[i] == cpu)
+			break;
+	}
+	memmove(&hist[1], &hist[0], i * sizeof(*hist));
+	hist[0] = cpu;
+}
+#endif
+
 /*
  * The dequeue_task method is called before nr_running is
  * decreased. We remove the task from the rbtree and
@@ -6849,6 +6892,12 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 
 	util_est_dequeue(&rq->cfs, p);
 
+#ifdef CONFIG_SMP
+	if (sched_feat(SIS_HISTORY) && task_sleep &&
+	    se->sum_exec_runtime != se->prev_sum_exec_runtime)
+		update_cpu_history(p, cpu_of(rq));
+#endif
+
 	for_each_sched_entity(se) {
 		cfs_rq = cfs_rq_of(se);
 		dequeue_entity(cfs_rq, se, flags);
@@ -7536,6 +7585,35 @@ static inline bool asym_fits_cpu(unsigned long util,
 	return true;
 }
 
+/*
+ * Scan the CPUs @p recently ran on for an idle one sharing the LLC with
+ * @target: their private caches are the most likely to still hold part of
+ * the working set of @p.
+ */
+static int select_idle_history(struct task_struct *p, int target,
+			       unsigned long task_util,
+			       unsigned long util_min, unsigned long util_max)
+{
+	int i, cpu;
+
+	for (i = 0; i < SE_CPU_HISTORY; i++) {
+		cpu = p->se.cpu_history[i];
+		if (cpu < 0)
+			break;
+
+		if (cpu == target || !cpu_active(cpu) ||
+		    !cpumask_test_cpu(cpu, p->cpus_ptr) ||
+		    !cpus_share_cache(cpu, target))
+			continue;
+
+		if ((available_idle_cpu(cpu) || sched_idle_cpu(cpu)) &&
+		    asym_fits_cpu(task_util, util_min, util_max, cpu))
+			return cpu;
+	}
+
+	return -1;
+}
+
 /*
  * Try and locate an idle core/thread in the LLC cache domain.
  */
@@ -7614,6 +7692,12 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 		recent_used_cpu = -1;
 	}
 
+	if (sched_feat(SIS_HISTORY)) {
+		i = select_idle_history(p, target, task_util, util_min, util_max);
+		if ((unsigned int)i < nr_cpumask_bits)
+			return i;
+	}
+
 	/*
 	 * For asymmetric CPU capacity systems, our domain of interest is
 	 * sd_asym_cpucapacity rather than sd_llc.
@@ -8313,6 +8397,40 @@ static void set_next_buddy(struct sched_entity *se)
 	}
 }
 
+#ifdef CONFIG_FAIR_GROUP_SCHED
+/*
+ * Take one wakeup preemption token from @p's task group. Once the group has
+ * used up its budget for the current period its wakeups no longer preempt
+ * and are left to the tick, which bounds the context switch rate of groups
+ * with lots of short-sleeping tasks.
+ */
+static bool tg_preempt_budget_take(struct task_struct *p, u64 now)
+{
+	struct task_group *tg = task_group(p);
+	unsigned int budget = READ_ONCE(tg->preempt_budget);
+	s64 refill;
+
+	if (!budget)
+		return true;
+
+	refill = atomic64_read(&tg->preempt_refill);
+	if (now - refill >= READ_ONCE(tg->preempt_period) &&
+	    atomic64_try_cmpxchg(&tg->preempt_refill, &refill, now))
+		atomic_set(&tg->preempt_tokens, budget);
+
+	if (atomic_dec_if_positive(&tg->preempt_tokens) >= 0)
+		return true;
+
+	atomic_long_inc(&tg->nr_preempt_throttled);
+	return false;
+}
+#else
+static inline bool tg_preempt_budget_take(struct task_struct *p, u64 now)
+{
+	return true;
+}
+#endif
+
 /*
  * Preempt the current task with a newly woken task if needed:
  */
@@ -8385,8 +8503,11 @@ static void check_preempt_wakeup_fair(struct rq *rq, struct task_struct *p, int
 	/*
 	 * XXX pick_eevdf(cfs_rq) != se ?
 	 */
-	if (pick_eevdf(cfs_rq) == pse)
+	if (pick_eevdf(cfs_rq) == pse) {
+		if (!tg_preempt_budget_take(p, rq_clock(rq)))
+			return;
 		goto preempt;
+	}
 
 	return;
 
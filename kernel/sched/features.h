@@ -46,11 +46,23 @@ SCHED_FEAT(TTWU_QUEUE, false)
 SCHED_FEAT(TTWU_QUEUE, true)
 #endif
 
+/*
+ * Send the TTWU_QUEUE IPIs of a wake_up_q() as one multicast IPI once the
+ * whole queue has been processed.
+ */
+SCHED_FEAT(TTWU_BATCH, true)
+
 /*
  * When doing wakeups, attempt to limit superfluous scans of the LLC domain.
  */
 SCHED_FEAT(SIS_UTIL, true)
 
+/*
+ * When doing wakeups, first try the idle CPUs of the wakee's recent CPU
+ * history which share the LLC with the target, before scanning it.
+ */
+SCHED_FEAT(SIS_HISTORY, false)
+
 /*
  * Issue a WARN when we do multiple update_rq_clock() calls
  * in a single rq->lock section. Default disabled because the
@@ -19,6 +19,28 @@ void sched_idle_set_state(struct cpuidle_state *idle_state)
 	idle_set_state(this_rq(), idle_state);
 }
 
+/**
+ * sched_idle_exit_latency - Exit latency of the idle state of a CPU.
+ * @cpu: CPU to check.
+ *
+ * Return: the exit latency in ns of the cpuidle state recorded for @cpu, or 0
+ * if the CPU is not in a cpuidle state. The result is only a hint, the CPU
+ * may change state at any time.
+ */
+u64 sched_idle_exit_latency(int cpu)
+{
+	struct cpuidle_state *idle_state;
+	u64 latency = 0;
+
+	rcu_read_lock();
+	idle_state = idle_get_state(cpu_rq(cpu));
+	if (idle_state)
+		latency = READ_ONCE(idle_state->exit_latency_ns);
+	rcu_read_unlock();
+
+	return latency;
+}
+
 static int __read_mostly cpu_idle_force_poll;
 
 void cpu_idle_poll_ctrl(bool enable)
@@ -276,6 +298,18 @@ static void do_idle(void)
 	__current_set_polling();
 	tick_nohz_idle_enter();
 
+	/*
+	 * Order becoming idle_cpu() against smp_call_function_idle_enter()
+	 * reading csd_lazy_pending. Setting the polling bit is an atomic, so
+	 * this is free where the arch has one and atomics are fully ordered.
+	 */
+#ifdef TIF_POLLING_NRFLAG
+	smp_mb__after_atomic();
+#else
+	smp_mb();
+#endif
+	smp_call_function_idle_enter();
+
 	while (!need_resched()) {
 		rmb();
 
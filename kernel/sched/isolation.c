@@ -23,6 +23,10 @@ enum hk_flags {
 DEFINE_STATIC_KEY_FALSE(housekeeping_overridden);
 EXPORT_SYMBOL_GPL(housekeeping_overridden);
 
+DEFINE_STATIC_KEY_FALSE(housekeeping_strict_key);
+EXPORT_SYMBOL_GPL(housekeeping_strict_key);
+static bool housekeeping_strict __initdata;
+
 struct housekeeping {
 	cpumask_var_t cpumasks[HK_TYPE_MAX];
 	unsigned long flags;
@@ -92,6 +96,10 @@ void __init housekeeping_init(void)
 {
 	enum hk_type type;
 
+	/* cpusets can isolate CPUs at runtime, so don't depend on the flags */
+	if (housekeeping_strict)
+		static_branch_enable(&housekeeping_strict_key);
+
 	if (!housekeeping.flags)
 		return;
 
@@ -253,3 +261,130 @@ static int __init housekeeping_isolcpus_setup(char *str)
 	return housekeeping_setup(str, flags);
 }
 __setup("isolcpus=", housekeeping_isolcpus_setup);
+
+static int __init housekeeping_strict_setup(char *str)
+{
+	housekeeping_strict = true;
+	return 1;
+}
+__setup("isolation_strict", housekeeping_strict_setup);
+
+/*
+ * Per-CPU log of the interruptions of isolated CPUs in strict mode. It does
+ * not depend on tracing being set up and running, and keeps the last
+ * ISOL_LOG_SIZE entries along with per-type counters. A nested interruption
+ * may tear an entry, which is fine for a diagnostic log.
+ */
+#define ISOL_LOG_SIZE	64
+
+struct isol_log_entry {
+	u64		time;
+	unsigned long	info;
+	unsigned int	type;
+};
+
+struct isol_log {
+	unsigned int		head;
+	unsigned long		count[ISOL_INTR_MAX];
+	struct isol_log_entry	entries[ISOL_LOG_SIZE];
+};
+
+static DEFINE_PER_CPU(struct isol_log, isol_logs);
+
+static const char * const isol_intr_names[ISOL_INTR_MAX] = {
+	[ISOL_INTR_IPI]		= "ipi",
+	[ISOL_INTR_TIMER]	= "timer",
+	[ISOL_INTR_SOFTIRQ]	= "softirq",
+	[ISOL_INTR_WORK]	= "work",
+};
+
+void __isolation_log_intr(enum isol_intr_type type, unsigned long info)
+{
+	struct isol_log_entry *e;
+	unsigned int idx;
+
+	preempt_disable_notrace();
+	if (cpu_is_isolated(smp_processor_id())) {
+		idx = this_cpu_inc_return(isol_logs.head) - 1;
+		e = this_cpu_ptr(&isol_logs.entries[idx % ISOL_LOG_SIZE]);
+		e->time = local_clock();
+		e->info = info;
+		e->type = type;
+		this_cpu_inc(isol_logs.count[type]);
+	}
+	preempt_enable_notrace();
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int isol_log_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct isol_log *log = per_cpu_ptr(&isol_logs, cpu);
+		unsigned int i, head = READ_ONCE(log->head);
+		int t;
+
+		if (!head)
+			continue;
+
+		seq_printf(m, "cpu%d:", cpu);
+		for (t = 0; t < ISOL_INTR_MAX; t++)
+			seq_printf(m, " %s %lu", isol_intr_names[t],
+				   READ_ONCE(log->count[t]));
+		seq_putc(m, '\n');
+
+		for (i = head > ISOL_LOG_SIZE ? head - ISOL_LOG_SIZE : 0;
+		     i < head; i++) {
+			struct isol_log_entry e = log->entries[i % ISOL_LOG_SIZE];
+
+			if (e.type >= ISOL_INTR_MAX)
+				continue;
+			if (e.type == ISOL_INTR_SOFTIRQ && e.info < NR_SOFTIRQS)
+				seq_printf(m, "  %llu %s %s\n", e.time,
+					   isol_intr_names[e.type],
+					   softirq_to_name[e.info]);
+			else
+				seq_printf(m, "  %llu %s %ps\n", e.time,
+					   isol_intr_names[e.type],
+					   (void *)e.info);
+		}
+	}
+
+	return 0;
+}
+
+static int isol_log_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, isol_log_show, NULL);
+}
+
+/* Writing anything clears the log */
+static ssize_t isol_log_write(struct file *file, const char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(&isol_logs, cpu), 0, sizeof(struct isol_log));
+
+	return count;
+}
+
+static const struct file_operations isol_log_fops = {
+	.open		= isol_log_open,
+	.read		= seq_read,
+	.write		= isol_log_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init isolation_debugfs_init(void)
+{
+	if (housekeeping_strict_enabled())
+		debugfs_create_file("isolation_log", 0600, NULL, NULL,
+				    &isol_log_fops);
+	return 0;
+}
+late_initcall(isolation_debugfs_init);
+#endif /* CONFIG_DEBUG_FS */
@@ -136,3 +136,4 @@ static inline void do_sched_yield_type_1(struct task_struct *p, struct rq *rq)
 
 static inline void sched_task_ttwu(struct task_struct *p) {}
 static inline void sched_task_deactivate(struct task_struct *p, struct rq *rq) {}
+static inline bool sched_task_prefer_big(const struct task_struct *p) { return false; }
@@ -153,6 +153,23 @@ static int __init setup_psi(char *str)
 }
 __setup("psi=", setup_psi);
 
+/*
+ * In lazy mode, task changes are applied right away only to the task's own
+ * cgroup. Ancestors just accumulate the task count deltas, which get folded
+ * in from the tick and before aggregation, so their state changes are only
+ * tick accurate.
+ */
+static DEFINE_STATIC_KEY_FALSE(psi_lazy);
+static bool psi_lazy_enable;
+static int __init setup_psi_lazy(char *str)
+{
+	return kstrtobool(str, &psi_lazy_enable) == 0;
+}
+__setup("psi_lazy=", setup_psi_lazy);
+
+/* Groups with pending changes on each CPU, protected by the rq lock */
+static DEFINE_PER_CPU(struct list_head, psi_pending_groups);
+
 /* Running averages - we need to be higher-res than loadavg */
 #define PSI_FREQ	(2*HZ+1)	/* 2 sec intervals */
 #define EXP_10s		1677		/* 1/exp(2s/10s) as fixed-point */
@@ -174,6 +191,8 @@ struct psi_group psi_system = {
 
 static void psi_avgs_work(struct work_struct *work);
 
+static void psi_flush_all_pending(void);
+
 static void poll_timer_fn(struct timer_list *t);
 
 static void group_init(struct psi_group *group)
@@ -181,8 +200,13 @@ static void group_init(struct psi_group *group)
 	int cpu;
 
 	group->enabled = true;
-	for_each_possible_cpu(cpu)
-		seqcount_init(&per_cpu_ptr(group->pcpu, cpu)->seq);
+	for_each_possible_cpu(cpu) {
+		struct psi_group_cpu *groupc = per_cpu_ptr(group->pcpu, cpu);
+
+		seqcount_init(&groupc->seq);
+		INIT_LIST_HEAD(&groupc->pending_node);
+		groupc->group = group;
+	}
 	group->avg_last_update = sched_clock();
 	group->avg_next_update = group->avg_last_update + psi_period;
 	mutex_init(&group->avgs_lock);
@@ -205,6 +229,8 @@ static void group_init(struct psi_group *group)
 
 void __init psi_init(void)
 {
+	int cpu;
+
 	if (!psi_enable) {
 		static_branch_enable(&psi_disabled);
 		static_branch_disable(&psi_cgroups_enabled);
@@ -216,6 +242,11 @@ void __init psi_init(void)
 
 	psi_period = jiffies_to_nsecs(PSI_FREQ);
 	group_init(&psi_system);
+
+	for_each_possible_cpu(cpu)
+		INIT_LIST_HEAD(per_cpu_ptr(&psi_pending_groups, cpu));
+	if (psi_lazy_enable)
+		static_branch_enable(&psi_lazy);
 }
 
 static bool test_state(unsigned int *tasks, enum psi_states state, bool oncpu)
@@ -343,6 +374,8 @@ static void collect_percpu_times(struct psi_group *group,
 	int cpu;
 	int s;
 
+	psi_flush_all_pending();
+
 	/*
 	 * Collect the per-cpu time buckets and average them into a
 	 * single time sample that is normalized to wallclock time.
@@ -764,13 +797,16 @@ static void record_times(struct psi_group_cpu *groupc, u64 now)
 		groupc->times[PSI_NONIDLE] += delta;
 }
 
+static void psi_group_update_state(struct psi_group *group,
+				   struct psi_group_cpu *groupc, int cpu,
+				   u32 state_mask, u64 now, bool wake_clock);
+
 static void psi_group_change(struct psi_group *group, int cpu,
 			     unsigned int clear, unsigned int set, u64 now,
 			     bool wake_clock)
 {
 	struct psi_group_cpu *groupc;
 	unsigned int t, m;
-	enum psi_states s;
 	u32 state_mask;
 
 	groupc = per_cpu_ptr(group->pcpu, cpu);
@@ -824,6 +860,20 @@ static void psi_group_change(struct psi_group *group, int cpu,
 		if (set & (1 << t))
 			groupc->tasks[t]++;
 
+	psi_group_update_state(group, groupc, cpu, state_mask, now, wake_clock);
+}
+
+/*
+ * Conclude the time spent in the previous state of @groupc and derive the
+ * new one from its task counts. Called with the seqcount held for writing,
+ * which this drops.
+ */
+static void psi_group_update_state(struct psi_group *group,
+				   struct psi_group_cpu *groupc, int cpu,
+				   u32 state_mask, u64 now, bool wake_clock)
+{
+	enum psi_states s;
+
 	if (!group->enabled) {
 		/*
 		 * On the first group change after disabling PSI, conclude
@@ -870,6 +920,119 @@ static void psi_group_change(struct psi_group *group, int cpu,
 		schedule_delayed_work(&group->avgs_work, PSI_FREQ);
 }
 
+/*
+ * psi_lazy: queue a task count change on @group instead of applying it.
+ * ONCPU is tracked as a net count, so that the clear for prev and the set
+ * for next in a common ancestor simply cancel out.
+ */
+static void psi_group_defer(struct psi_group *group, int cpu,
+			    unsigned int clear, unsigned int set)
+{
+	struct psi_group_cpu *groupc = per_cpu_ptr(group->pcpu, cpu);
+	unsigned int t;
+
+	if (clear & TSK_ONCPU) {
+		groupc->pending_oncpu--;
+		clear &= ~TSK_ONCPU;
+	}
+	if (set & TSK_ONCPU) {
+		groupc->pending_oncpu++;
+		set &= ~TSK_ONCPU;
+	}
+
+	for (t = 0; clear; clear &= ~(1 << t), t++)
+		if (clear & (1 << t))
+			groupc->pending[t]--;
+
+	for (t = 0; set; set &= ~(1 << t), t++)
+		if (set & (1 << t))
+			groupc->pending[t]++;
+
+	if (list_empty(&groupc->pending_node))
+		list_add_tail(&groupc->pending_node,
+			      per_cpu_ptr(&psi_pending_groups, cpu));
+}
+
+static void psi_group_flush(struct psi_group_cpu *groupc, int cpu, u64 now)
+{
+	u32 state_mask;
+	int t;
+
+	write_seqcount_begin(&groupc->seq);
+
+	if (groupc->pending_oncpu > 0)
+		state_mask = PSI_ONCPU;
+	else if (groupc->pending_oncpu < 0)
+		state_mask = 0;
+	else
+		state_mask = groupc->state_mask & PSI_ONCPU;
+	groupc->pending_oncpu = 0;
+
+	for (t = 0; t < NR_PSI_TASK_COUNTS; t++) {
+		int tasks = groupc->tasks[t] + groupc->pending[t];
+
+		if (unlikely(tasks < 0)) {
+			if (!psi_bug) {
+				printk_deferred(KERN_ERR "psi: task underflow! cpu=%d t=%d pending=%d\n",
+						cpu, t, groupc->pending[t]);
+				psi_bug = 1;
+			}
+			tasks = 0;
+		}
+		groupc->tasks[t] = tasks;
+		groupc->pending[t] = 0;
+	}
+
+	psi_group_update_state(groupc->group, groupc, cpu, state_mask, now, true);
+}
+
+/*
+ * Fold the pending changes of all groups on @cpu into their state. Called
+ * with @cpu's rq lock held.
+ */
+static void psi_flush_pending(int cpu)
+{
+	struct list_head *head = per_cpu_ptr(&psi_pending_groups, cpu);
+	struct psi_group_cpu *groupc, *tmp;
+	u64 now;
+
+	if (list_empty(head))
+		return;
+
+	now = cpu_clock(cpu);
+	list_for_each_entry_safe(groupc, tmp, head, pending_node) {
+		list_del_init(&groupc->pending_node);
+		psi_group_flush(groupc, cpu, now);
+	}
+}
+
+void psi_tick(int cpu)
+{
+	if (static_branch_unlikely(&psi_lazy))
+		psi_flush_pending(cpu);
+}
+
+/* Flush remote CPUs before aggregating their times */
+static void psi_flush_all_pending(void)
+{
+	int cpu;
+
+	if (!static_branch_unlikely(&psi_lazy))
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+		struct rq_flags rf;
+
+		if (list_empty(per_cpu_ptr(&psi_pending_groups, cpu)))
+			continue;
+
+		rq_lock_irq(rq, &rf);
+		psi_flush_pending(cpu);
+		rq_unlock_irq(rq, &rf);
+	}
+}
+
 static inline struct psi_group *task_psi_group(struct task_struct *task)
 {
 #ifdef CONFIG_CGROUPS
@@ -908,9 +1071,58 @@ void psi_task_change(struct task_struct *task, int clear, int set)
 	now = cpu_clock(cpu);
 
 	group = task_psi_group(task);
-	do {
+	psi_group_change(group, cpu, clear, set, now, true);
+
+	if (static_branch_unlikely(&psi_lazy)) {
+		while ((group = group->parent))
+			psi_group_defer(group, cpu, clear, set);
+		return;
+	}
+
+	while ((group = group->parent))
 		psi_group_change(group, cpu, clear, set, now, true);
-	} while ((group = group->parent));
+}
+
+/*
+ * psi_lazy version of psi_task_switch(): apply the changes to the leaf
+ * groups of both tasks and defer the rest.
+ */
+static void psi_task_switch_lazy(struct task_struct *prev,
+				 struct task_struct *next, bool sleep,
+				 int cpu, u64 now)
+{
+	struct psi_group *group;
+
+	if (next->pid) {
+		psi_flags_change(next, 0, TSK_ONCPU);
+		group = task_psi_group(next);
+		psi_group_change(group, cpu, 0, TSK_ONCPU, now, true);
+		while ((group = group->parent))
+			psi_group_defer(group, cpu, 0, TSK_ONCPU);
+	}
+
+	if (prev->pid) {
+		int clear = TSK_ONCPU, set = 0;
+		bool wake_clock = true;
+
+		if (sleep) {
+			clear |= TSK_RUNNING;
+			if (prev->in_memstall)
+				clear |= TSK_MEMSTALL_RUNNING;
+			if (prev->in_iowait)
+				set |= TSK_IOWAIT;
+
+			if (unlikely((prev->flags & PF_WQ_WORKER) &&
+				     wq_worker_last_func(prev) == psi_avgs_work))
+				wake_clock = false;
+		}
+
+		psi_flags_change(prev, clear, set);
+		group = task_psi_group(prev);
+		psi_group_change(group, cpu, clear, set, now, wake_clock);
+		while ((group = group->parent))
+			psi_group_defer(group, cpu, clear, set);
+	}
 }
 
 void psi_task_switch(struct task_struct *prev, struct task_struct *next,
@@ -920,6 +1132,11 @@ void psi_task_switch(struct task_struct *prev, struct task_struct *next,
 	int cpu = task_cpu(prev);
 	u64 now = cpu_clock(cpu);
 
+	if (static_branch_unlikely(&psi_lazy)) {
+		psi_task_switch_lazy(prev, next, sleep, cpu, now);
+		return;
+	}
+
 	if (next->pid) {
 		psi_flags_change(next, 0, TSK_ONCPU);
 		/*
@@ -1114,6 +1331,19 @@ void psi_cgroup_free(struct cgroup *cgroup)
 		return;
 
 	cancel_delayed_work_sync(&cgroup->psi->avgs_work);
+	if (static_branch_unlikely(&psi_lazy)) {
+		int cpu;
+
+		for_each_possible_cpu(cpu) {
+			struct psi_group_cpu *groupc = per_cpu_ptr(cgroup->psi->pcpu, cpu);
+			struct rq *rq = cpu_rq(cpu);
+			struct rq_flags rf;
+
+			rq_lock_irq(rq, &rf);
+			list_del_init(&groupc->pending_node);
+			rq_unlock_irq(rq, &rf);
+		}
+	}
 	free_percpu(cgroup->psi->pcpu);
 	/* All triggers must be removed by now */
 	WARN_ONCE(cgroup->psi->rtpoll_states, "psi: trigger leak\n");
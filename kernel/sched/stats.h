@@ -113,6 +113,7 @@ void psi_task_change(struct task_struct *task, int clear, int set);
 void psi_task_switch(struct task_struct *prev, struct task_struct *next,
 		     bool sleep);
 void psi_account_irqtime(struct task_struct *task, u32 delta);
+void psi_tick(int cpu);
 
 /*
  * PSI tracks state that persists across sleeps, such as iowaits and
@@ -195,6 +196,7 @@ static inline void psi_sched_switch(struct task_struct *prev,
 				    struct task_struct *next,
 				    bool sleep) {}
 static inline void psi_account_irqtime(struct task_struct *task, u32 delta) {}
+static inline void psi_tick(int cpu) {}
 #endif /* CONFIG_PSI */
 
 #ifdef CONFIG_SCHED_INFO
@@ -218,6 +220,35 @@ static inline void sched_info_dequeue(struct rq *rq, struct task_struct *t)
 	rq_sched_info_dequeue(rq, delta);
 }
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+static inline unsigned int sched_lat_hist_idx(unsigned long long delta)
+{
+	return min_t(unsigned int, fls64(delta >> 10), SCHED_LAT_HIST_BUCKETS - 1);
+}
+
+#if defined(CONFIG_CGROUP_SCHED) && !defined(CONFIG_SCHED_ALT)
+extern void tg_lat_hist_account(struct rq *rq, struct task_struct *t,
+				unsigned int idx);
+#else
+static inline void tg_lat_hist_account(struct rq *rq, struct task_struct *t,
+				       unsigned int idx) { }
+#endif
+
+static inline void
+sched_lat_hist_account(struct rq *rq, struct task_struct *t,
+		       unsigned long long delta)
+{
+	unsigned int idx = sched_lat_hist_idx(delta);
+
+	t->sched_info.lat_hist[idx]++;
+	tg_lat_hist_account(rq, t, idx);
+}
+#else
+static inline void
+sched_lat_hist_account(struct rq *rq, struct task_struct *t,
+		       unsigned long long delta) { }
+#endif /* CONFIG_SCHED_LATENCY_HIST */
+
 /*
  * Called when a task finally hits the CPU.  We can now calculate how
  * long it was waiting to run.  We also note when it began so that we
@@ -236,6 +267,7 @@ static void sched_info_arrive(struct rq *rq, struct task_struct *t)
 	t->sched_info.run_delay += delta;
 	t->sched_info.last_arrival = now;
 	t->sched_info.pcount++;
+	sched_lat_hist_account(rq, t, delta);
 
 	rq_sched_info_arrive(rq, delta);
 }
@@ -24,7 +24,13 @@
 #include <linux/sched/clock.h>
 #include <linux/nmi.h>
 #include <linux/sched/debug.h>
+#include <linux/sched/isolation.h>
 #include <linux/jump_label.h>
+#include <linux/debugfs.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/tick.h>
+#include <linux/timekeeping.h>
 
 #include <trace/events/ipi.h>
 #define CREATE_TRACE_POINTS
@@ -48,6 +54,26 @@ static DEFINE_PER_CPU_SHARED_ALIGNED(struct llist_head, call_single_queue);
 
 static DEFINE_PER_CPU(atomic_t, trigger_backtrace) = ATOMIC_INIT(1);
 
+/*
+ * Set when call_single_queue was made non-empty by a lazy cross-call which
+ * didn't send an IPI. The next urgent sender finding the queue non-empty
+ * must then send the IPI itself, see csd_lazy_kick().
+ */
+static DEFINE_PER_CPU(int, csd_lazy_pending);
+
+/* Cross-call statistics, see <debugfs>/smp_call/ */
+struct csd_stats {
+	unsigned long	ipis;		/* sent by this CPU */
+	unsigned long	lazy;		/* queued by this CPU without an IPI */
+	unsigned long	flushes;	/* of this CPU's queue */
+	u64		lat_total_ns;	/* oldest entry, queue to flush */
+	u64		lat_max_ns;
+};
+
+static DEFINE_STATIC_KEY_FALSE(csd_stats_key);
+static DEFINE_PER_CPU(struct csd_stats, csd_stats);
+static DEFINE_PER_CPU(u64, csd_queue_ts);
+
 static void __flush_smp_call_function_queue(bool warn_cpu_offline);
 
 int smpcfd_prepare_cpu(unsigned int cpu)
@@ -129,6 +155,9 @@ send_call_function_ipi_mask(struct cpumask *mask)
 static __always_inline void
 csd_do_func(smp_call_func_t func, void *info, call_single_data_t *csd)
 {
+	/* Queued callbacks come with an IPI, or at least instead of one */
+	if (csd)
+		isolation_log_intr(ISOL_INTR_IPI, (unsigned long)func);
 	trace_csd_function_entry(func, csd);
 	func(info);
 	trace_csd_function_exit(func, csd);
@@ -346,7 +375,50 @@ static __always_inline void csd_unlock(call_single_data_t *csd)
 
 static DEFINE_PER_CPU_SHARED_ALIGNED(call_single_data_t, csd_data);
 
-void __smp_call_single_queue(int cpu, struct llist_node *node)
+static __always_inline void csd_stats_queue(int cpu)
+{
+	if (static_branch_unlikely(&csd_stats_key)) {
+		u64 *ts = per_cpu_ptr(&csd_queue_ts, cpu);
+
+		if (!READ_ONCE(*ts))
+			cmpxchg(ts, 0, ktime_get_mono_fast_ns() | 1);
+	}
+}
+
+static __always_inline void csd_stats_inc_ipis(int nr)
+{
+	if (static_branch_unlikely(&csd_stats_key))
+		this_cpu_add(csd_stats.ipis, nr);
+}
+
+static void csd_stats_flush(void)
+{
+	struct csd_stats *s = this_cpu_ptr(&csd_stats);
+	u64 ts = this_cpu_xchg(csd_queue_ts, 0);
+
+	s->flushes++;
+	if (ts) {
+		u64 lat = ktime_get_mono_fast_ns() - ts;
+
+		s->lat_total_ns += lat;
+		s->lat_max_ns = max(s->lat_max_ns, lat);
+	}
+}
+
+/*
+ * Called when adding to @cpu's call_single_queue found it non-empty, which
+ * normally means an IPI is already on its way. If the entries ahead of us
+ * were queued lazily there is none, so return true to have the caller send
+ * it. The full barrier of llist_add() pairs with the one in csd_lazy_queue().
+ */
+static __always_inline bool csd_lazy_kick(int cpu)
+{
+	int *pending = per_cpu_ptr(&csd_lazy_pending, cpu);
+
+	return READ_ONCE(*pending) && xchg(pending, 0);
+}
+
+static __always_inline bool smp_call_single_enqueue(int cpu, struct llist_node *node)
 {
 	/*
 	 * We have to check the type of the CSD before queueing it, because
@@ -378,8 +450,46 @@ void __smp_call_single_queue(int cpu, struct llist_node *node)
 	 * locking and barrier primitives. Generic code isn't really
 	 * equipped to do the right thing...
 	 */
+	csd_stats_queue(cpu);
 	if (llist_add(node, &per_cpu(call_single_queue, cpu)))
+		return true;
+
+	return csd_lazy_kick(cpu);
+}
+
+void __smp_call_single_queue(int cpu, struct llist_node *node)
+{
+	if (smp_call_single_enqueue(cpu, node)) {
+		csd_stats_inc_ipis(1);
 		send_call_function_single_ipi(cpu);
+	}
+}
+
+/*
+ * Like __smp_call_single_queue(), but leave the IPI to the caller. Returns
+ * true if @node went onto an empty queue and @cpu therefore needs one, which
+ * can be batched with others through __smp_call_single_ipi_mask().
+ */
+bool __smp_call_single_queue_noipi(int cpu, struct llist_node *node)
+{
+	return smp_call_single_enqueue(cpu, node);
+}
+
+/*
+ * Kick the CPUs in @mask to process their call_single_queue with a single
+ * multicast IPI. CPUs that poll on need_resched are dropped from @mask.
+ */
+void __smp_call_single_ipi_mask(struct cpumask *mask)
+{
+	int cpu;
+
+	for_each_cpu(cpu, mask) {
+		if (!call_function_single_prep_ipi(cpu))
+			__cpumask_clear_cpu(cpu, mask);
+	}
+
+	if (!cpumask_empty(mask))
+		send_call_function_ipi_mask(mask);
 }
 
 /*
@@ -457,9 +567,15 @@ static void __flush_smp_call_function_queue(bool warn_cpu_offline)
 	atomic_set_release(tbt, 1);
 
 	head = this_cpu_ptr(&call_single_queue);
+	/* Whatever was queued lazily so far is about to be run */
+	if (this_cpu_read(csd_lazy_pending))
+		this_cpu_write(csd_lazy_pending, 0);
 	entry = llist_del_all(head);
 	entry = llist_reverse_order(entry);
 
+	if (static_branch_unlikely(&csd_stats_key) && entry)
+		csd_stats_flush();
+
 	/* There shouldn't be any pending callbacks on an offline CPU. */
 	if (unlikely(warn_cpu_offline && !cpu_online(smp_processor_id()) &&
 		     !warned && entry != NULL)) {
@@ -590,6 +706,32 @@ void flush_smp_call_function_queue(void)
 	local_irq_restore(flags);
 }
 
+/**
+ * smp_call_function_tick - Flush lazily queued smp-call-function callbacks
+ *
+ * Called from the scheduler tick with interrupts disabled, this bounds the
+ * delay of on_each_cpu_mask_lazy() callbacks on busy CPUs to one tick.
+ */
+void smp_call_function_tick(void)
+{
+	if (!llist_empty(this_cpu_ptr(&call_single_queue)))
+		__flush_smp_call_function_queue(true);
+}
+
+/**
+ * smp_call_function_idle_enter - Flush lazy callbacks on idle entry
+ *
+ * Lazy cross-calls only send an IPI to CPUs that look idle to them, so run
+ * those whose sender saw us busy, as the tick may stay stopped from now on.
+ * Called from do_idle() after a full barrier, which pairs with the one in
+ * csd_lazy_queue().
+ */
+void smp_call_function_idle_enter(void)
+{
+	if (this_cpu_read(csd_lazy_pending))
+		flush_smp_call_function_queue();
+}
+
 /*
  * smp_call_function_single - Run a function on a specific CPU
  * @func: The function to run. This must be fast and non-blocking.
@@ -749,9 +891,47 @@ EXPORT_SYMBOL_GPL(smp_call_function_any);
  *
  * %SCF_WAIT:		Wait until function execution is completed
  * %SCF_RUN_LOCAL:	Run also locally if local cpu is set in cpumask
+ * %SCF_LAZY:		Don't interrupt busy CPUs, let them run the function
+ *			from their next IPI, tick or idle entry. Ignored with
+ *			%SCF_WAIT.
  */
 #define SCF_WAIT	(1U << 0)
 #define SCF_RUN_LOCAL	(1U << 1)
+#define SCF_LAZY	(1U << 2)
+
+/*
+ * A lazy cross-call still needs an IPI if @cpu won't get to its queue soon:
+ * idle CPUs may stay in idle with the tick stopped and nohz_full CPUs don't
+ * have a tick to speak of. A CPU entering idle after this check sees
+ * csd_lazy_pending, set before it, and flushes its queue in do_idle().
+ */
+static bool csd_lazy_needs_ipi(int cpu)
+{
+	return tick_nohz_full_cpu(cpu) || idle_cpu(cpu);
+}
+
+/*
+ * @csd went onto @cpu's empty queue, return whether it needs an IPI after
+ * all. If anybody queued behind it before seeing csd_lazy_pending, they
+ * didn't send one either, so do it for them. Pairs with csd_lazy_kick().
+ */
+static bool csd_lazy_queue(int cpu, call_single_data_t *csd)
+{
+	struct llist_head *head = &per_cpu(call_single_queue, cpu);
+
+	/* Pairs with csd_lazy_kick() and smp_call_function_idle_enter() */
+	WRITE_ONCE(per_cpu(csd_lazy_pending, cpu), 1);
+	smp_mb();
+	if (READ_ONCE(head->first) != &csd->node.llist)
+		return true;
+
+	if (csd_lazy_needs_ipi(cpu))
+		return true;
+
+	if (static_branch_unlikely(&csd_stats_key))
+		this_cpu_inc(csd_stats.lazy);
+	return false;
+}
 
 static void smp_call_function_many_cond(const struct cpumask *mask,
 					smp_call_func_t func, void *info,
@@ -761,6 +941,7 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 	int cpu, last_cpu, this_cpu = smp_processor_id();
 	struct call_function_data *cfd;
 	bool wait = scf_flags & SCF_WAIT;
+	bool lazy = !wait && (scf_flags & SCF_LAZY);
 	int nr_cpus = 0;
 	bool run_remote = false;
 	bool run_local = false;
@@ -810,6 +991,14 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 				continue;
 			}
 
+			/*
+			 * Our previous csd for @cpu may still sit lazily on its
+			 * queue, whoever queued it, kick it rather than spin in
+			 * csd_lock().
+			 */
+			if (READ_ONCE(csd->node.u_flags) & CSD_FLAG_LOCK)
+				send_call_function_single_ipi(cpu);
+
 			csd_lock(csd);
 			if (wait)
 				csd->node.u_flags |= CSD_TYPE_SYNC;
@@ -820,14 +1009,23 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 			csd->node.dst = cpu;
 #endif
 			trace_csd_queue_cpu(cpu, _RET_IP_, func, csd);
+			csd_stats_queue(cpu);
 
 			if (llist_add(&csd->node.llist, &per_cpu(call_single_queue, cpu))) {
+				if (lazy && !csd_lazy_queue(cpu, csd))
+					continue;
+				__cpumask_set_cpu(cpu, cfd->cpumask_ipi);
+				nr_cpus++;
+				last_cpu = cpu;
+			} else if (!lazy && csd_lazy_kick(cpu)) {
 				__cpumask_set_cpu(cpu, cfd->cpumask_ipi);
 				nr_cpus++;
 				last_cpu = cpu;
 			}
 		}
 
+		csd_stats_inc_ipis(nr_cpus);
+
 		/*
 		 * Choose the most efficient way to send an IPI. Note that the
 		 * number of CPUs might be zero due to concurrent changes to the
@@ -1025,6 +1223,34 @@ void on_each_cpu_cond_mask(smp_cond_func_t cond_func, smp_call_func_t func,
 }
 EXPORT_SYMBOL(on_each_cpu_cond_mask);
 
+/**
+ * on_each_cpu_mask_lazy - Run a function on a set of CPUs, eventually
+ * @mask: The set of CPUs to run on, may include the local CPU.
+ * @func: The function to run. This must be fast and non-blocking.
+ * @info: An arbitrary pointer to pass to the function.
+ *
+ * Like on_each_cpu_mask() without waiting, for callers which don't need
+ * @func to run right away. Busy remote CPUs are not interrupted; @func runs
+ * there from the next cross-call IPI, scheduler tick or idle entry, whichever
+ * comes first, so that bursts of such calls coalesce into fewer IPIs. Idle
+ * and nohz_full CPUs are still sent an IPI. The local CPU, if in @mask, runs
+ * @func before returning.
+ *
+ * @info must stay valid until @func has run everywhere.
+ *
+ * You must not call this function with disabled interrupts or from a
+ * hardware interrupt handler or from a bottom half handler.
+ */
+void on_each_cpu_mask_lazy(const struct cpumask *mask, smp_call_func_t func,
+			   void *info)
+{
+	preempt_disable();
+	smp_call_function_many_cond(mask, func, info,
+				    SCF_RUN_LOCAL | SCF_LAZY, NULL);
+	preempt_enable();
+}
+EXPORT_SYMBOL_GPL(on_each_cpu_mask_lazy);
+
 static void do_nothing(void *unused)
 {
 }
@@ -1123,3 +1349,100 @@ int smp_call_on_cpu(unsigned int cpu, int (*func)(void *), void *par, bool phys)
 	return sscs.ret;
 }
 EXPORT_SYMBOL_GPL(smp_call_on_cpu);
+
+#ifdef CONFIG_DEBUG_FS
+static DEFINE_MUTEX(csd_stats_mutex);
+
+static int csd_stats_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	seq_puts(m, "# cpu ipis lazy flushes lat_total_ns lat_max_ns\n");
+	for_each_online_cpu(cpu) {
+		struct csd_stats *s = per_cpu_ptr(&csd_stats, cpu);
+
+		seq_printf(m, "%d %lu %lu %lu %llu %llu\n", cpu,
+			   READ_ONCE(s->ipis), READ_ONCE(s->lazy),
+			   READ_ONCE(s->flushes), READ_ONCE(s->lat_total_ns),
+			   READ_ONCE(s->lat_max_ns));
+	}
+	return 0;
+}
+
+static int csd_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, csd_stats_show, NULL);
+}
+
+static ssize_t csd_stats_write(struct file *file, const char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	bool enabled;
+	int cpu;
+
+	mutex_lock(&csd_stats_mutex);
+	enabled = static_key_enabled(&csd_stats_key);
+	/* Stop updates, and wait for those in flight, to clear safely */
+	if (enabled) {
+		static_branch_disable(&csd_stats_key);
+		synchronize_rcu();
+	}
+	for_each_possible_cpu(cpu) {
+		memset(per_cpu_ptr(&csd_stats, cpu), 0, sizeof(struct csd_stats));
+		per_cpu(csd_queue_ts, cpu) = 0;
+	}
+	if (enabled)
+		static_branch_enable(&csd_stats_key);
+	mutex_unlock(&csd_stats_mutex);
+
+	return count;
+}
+
+static const struct file_operations csd_stats_fops = {
+	.owner		= THIS_MODULE,
+	.open		= csd_stats_open,
+	.read		= seq_read,
+	.write		= csd_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int csd_stats_enable_get(void *data, u64 *val)
+{
+	*val = static_key_enabled(&csd_stats_key);
+	return 0;
+}
+
+static int csd_stats_enable_set(void *data, u64 val)
+{
+	mutex_lock(&csd_stats_mutex);
+	if (val && !static_key_enabled(&csd_stats_key))
+		static_branch_enable(&csd_stats_key);
+	else if (!val && static_key_enabled(&csd_stats_key))
+		static_branch_disable(&csd_stats_key);
+	mutex_unlock(&csd_stats_mutex);
+
+	return 0;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(csd_stats_enable_fops, csd_stats_enable_get,
+			 csd_stats_enable_set, "%llu\n");
+
+/*
+ * <debugfs>/smp_call/stats shows, for each CPU, the number of cross-call
+ * IPIs it sent, of lazy cross-calls it queued without one, and of flushes of
+ * its own queue along with the total and maximum time the oldest entry had
+ * waited for them. Collection is off until enabled through
+ * <debugfs>/smp_call/enable, writing to stats clears them.
+ */
+static int __init csd_stats_init(void)
+{
+	struct dentry *d_dir = debugfs_create_dir("smp_call", NULL);
+
+	debugfs_create_file_unsafe("enable", 0600, d_dir, NULL,
+				   &csd_stats_enable_fops);
+	debugfs_create_file("stats", 0600, d_dir, NULL, &csd_stats_fops);
+	return 0;
+}
+fs_initcall(csd_stats_init);
+#endif /* CONFIG_DEBUG_FS */
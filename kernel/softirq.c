@@ -21,9 +21,12 @@
 #include <linux/freezer.h>
 #include <linux/kthread.h>
 #include <linux/rcupdate.h>
+#include <linux/sched/clock.h>
+#include <linux/sched/isolation.h>
 #include <linux/ftrace.h>
 #include <linux/smp.h>
 #include <linux/smpboot.h>
+#include <linux/string.h>
 #include <linux/tick.h>
 #include <linux/irq.h>
 #include <linux/wait_bit.h>
@@ -508,11 +511,234 @@ static inline bool lockdep_softirq_start(void) { return false; }
 static inline void lockdep_softirq_end(bool in_hardirq) { }
 #endif
 
+/* Run one vector, returns the time it took if that is accounted */
+static __always_inline u64 softirq_run_vec(struct softirq_action *h)
+{
+	unsigned int vec_nr = h - softirq_vec;
+	int prev_count = preempt_count();
+	u64 delta = 0;
+#ifdef CONFIG_SOFTIRQ_VEC_BUDGET
+	u64 start = local_clock();
+#endif
+
+	kstat_incr_softirqs_this_cpu(vec_nr);
+	isolation_log_intr(ISOL_INTR_SOFTIRQ, vec_nr);
+
+	trace_softirq_entry(vec_nr);
+	h->action(h);
+	trace_softirq_exit(vec_nr);
+#ifdef CONFIG_SOFTIRQ_VEC_BUDGET
+	delta = local_clock() - start;
+	__this_cpu_add(kstat.softirq_time[vec_nr], delta);
+#endif
+	if (unlikely(prev_count != preempt_count())) {
+		pr_err("huh, entered softirq %u %s %p with preempt_count %08x, exited with %08x?\n",
+		       vec_nr, softirq_to_name[vec_nr], h->action,
+		       prev_count, preempt_count());
+		preempt_count_set(prev_count);
+	}
+
+	return delta;
+}
+
+#ifdef CONFIG_SOFTIRQ_VEC_BUDGET
+/*
+ * The vectors in softirq_vec_threaded are handed over to the per-CPU
+ * ksoftirqd_vec thread once they have run for more than their budget in one
+ * round of softirq processing and still have work pending. While deferred,
+ * raising them only marks them in softirq_vec_pending, so that they neither
+ * hold back the other vectors nor keep ksoftirqd busy. The thread hands them
+ * back once it has caught up.
+ */
+static u32 softirq_vec_threaded __ro_after_init =
+	BIT(NET_TX_SOFTIRQ) | BIT(NET_RX_SOFTIRQ);
+static u64 softirq_vec_budget_ns[NR_SOFTIRQS] __ro_after_init = {
+	[0 ... NR_SOFTIRQS - 1] = 2 * NSEC_PER_MSEC
+};
+
+static DEFINE_PER_CPU(u32, softirq_vec_deferred);
+static DEFINE_PER_CPU(u32, softirq_vec_pending);
+static DEFINE_PER_CPU(struct task_struct *, ksoftirqd_vec);
+
+struct softirq_budget {
+	u64	spent[NR_SOFTIRQS];
+	u32	over;
+};
+
+static inline void softirq_vec_charge(struct softirq_budget *b,
+				      unsigned int vec_nr, u64 delta)
+{
+	if (!(softirq_vec_threaded & BIT(vec_nr)))
+		return;
+
+	b->spent[vec_nr] += delta;
+	if (b->spent[vec_nr] > softirq_vec_budget_ns[vec_nr])
+		b->over |= BIT(vec_nr);
+}
+
+/*
+ * Called with interrupts disabled with the vectors still @pending after a
+ * round, defer those over budget and return the others.
+ */
+static inline u32 softirq_vec_defer(struct softirq_budget *b, u32 pending)
+{
+	struct task_struct *tsk = __this_cpu_read(ksoftirqd_vec);
+	u32 defer = b->over & pending;
+
+	if (likely(!defer) || !tsk)
+		return pending;
+
+	__this_cpu_or(softirq_vec_deferred, defer);
+	__this_cpu_or(softirq_vec_pending, defer);
+	pending &= ~defer;
+	set_softirq_pending(pending);
+	b->over = 0;
+	wake_up_process(tsk);
+
+	return pending;
+}
+
+static inline bool softirq_vec_raise(unsigned int nr)
+{
+	if (likely(!(__this_cpu_read(softirq_vec_deferred) & BIT(nr))))
+		return false;
+
+	__this_cpu_or(softirq_vec_pending, BIT(nr));
+	return true;
+}
+
+static int ksoftirqd_vec_should_run(unsigned int cpu)
+{
+	return __this_cpu_read(softirq_vec_pending);
+}
+
+static void run_ksoftirqd_vec(unsigned int cpu)
+{
+	struct softirq_action *h = softirq_vec;
+	bool in_hardirq;
+	int softirq_bit;
+	u32 pending;
+
+	local_irq_disable();
+	pending = this_cpu_xchg(softirq_vec_pending, 0);
+	if (pending) {
+		softirq_handle_begin();
+		in_hardirq = lockdep_softirq_start();
+		account_softirq_enter(current);
+		local_irq_enable();
+
+		while ((softirq_bit = ffs(pending))) {
+			h += softirq_bit - 1;
+			softirq_run_vec(h);
+			h++;
+			pending >>= softirq_bit;
+		}
+		rcu_softirq_qs();
+
+		local_irq_disable();
+		account_softirq_exit(current);
+		lockdep_softirq_end(in_hardirq);
+		softirq_handle_end();
+	}
+
+	/* Caught up, hand the vectors back to regular softirq processing */
+	if (!__this_cpu_read(softirq_vec_pending))
+		__this_cpu_write(softirq_vec_deferred, 0);
+	/* Nothing ran the other vectors raised meanwhile */
+	if (local_softirq_pending())
+		wakeup_softirqd();
+	local_irq_enable();
+	cond_resched();
+}
+
+static void ksoftirqd_vec_park(unsigned int cpu)
+{
+	local_irq_disable();
+	__this_cpu_write(softirq_vec_deferred, 0);
+	or_softirq_pending(this_cpu_xchg(softirq_vec_pending, 0));
+	if (local_softirq_pending())
+		wakeup_softirqd();
+	local_irq_enable();
+}
+
+static struct smp_hotplug_thread softirq_vec_threads = {
+	.store			= &ksoftirqd_vec,
+	.thread_should_run	= ksoftirqd_vec_should_run,
+	.thread_fn		= run_ksoftirqd_vec,
+	.park			= ksoftirqd_vec_park,
+	.thread_comm		= "ksoftirqd_vec/%u",
+};
+
+static __init void spawn_ksoftirqd_vec(void)
+{
+	if (softirq_vec_threaded &&
+	    smpboot_register_percpu_thread(&softirq_vec_threads)) {
+		pr_warn("cannot create ksoftirqd_vec threads\n");
+		softirq_vec_threaded = 0;
+	}
+}
+
+/*
+ * softirq_thread=<vector>[:<budget_us>][,...] selects the vectors which may
+ * be deferred to ksoftirqd_vec and their budgets, or none.
+ */
+static int __init softirq_thread_setup(char *str)
+{
+	u32 mask = 0;
+	char *tok;
+
+	while ((tok = strsep(&str, ","))) {
+		char *budget = strchr(tok, ':');
+		unsigned int i, us;
+
+		if (budget)
+			*budget++ = '\0';
+		if (!*tok || !strcmp(tok, "none"))
+			continue;
+
+		for (i = 0; i < NR_SOFTIRQS; i++) {
+			if (!strcasecmp(tok, softirq_to_name[i]))
+				break;
+		}
+		if (i == NR_SOFTIRQS) {
+			pr_warn("softirq_thread: unknown vector %s\n", tok);
+			continue;
+		}
+		if (budget) {
+			if (kstrtouint(budget, 0, &us) || !us)
+				pr_warn("softirq_thread: bad budget for %s\n", tok);
+			else
+				softirq_vec_budget_ns[i] = (u64)us * NSEC_PER_USEC;
+		}
+		mask |= BIT(i);
+	}
+
+	softirq_vec_threaded = mask;
+	return 1;
+}
+__setup("softirq_thread=", softirq_thread_setup);
+
+#else /* CONFIG_SOFTIRQ_VEC_BUDGET */
+
+struct softirq_budget { };
+
+static inline void softirq_vec_charge(struct softirq_budget *b,
+				      unsigned int vec_nr, u64 delta) { }
+static inline u32 softirq_vec_defer(struct softirq_budget *b, u32 pending)
+{
+	return pending;
+}
+static inline bool softirq_vec_raise(unsigned int nr) { return false; }
+static inline void spawn_ksoftirqd_vec(void) { }
+
+#endif /* !CONFIG_SOFTIRQ_VEC_BUDGET */
+
 static void handle_softirqs(bool ksirqd)
 {
 	unsigned long end = jiffies + MAX_SOFTIRQ_TIME;
 	unsigned long old_flags = current->flags;
 	int max_restart = MAX_SOFTIRQ_RESTART;
+	struct softirq_budget budget = { };
 	struct softirq_action *h;
 	bool in_hardirq;
 	__u32 pending;
@@ -540,25 +766,12 @@ static void handle_softirqs(bool ksirqd)
 	h = softirq_vec;
 
 	while ((softirq_bit = ffs(pending))) {
-		unsigned int vec_nr;
-		int prev_count;
+		u64 delta;
 
 		h += softirq_bit - 1;
 
-		vec_nr = h - softirq_vec;
-		prev_count = preempt_count();
-
-		kstat_incr_softirqs_this_cpu(vec_nr);
-
-		trace_softirq_entry(vec_nr);
-		h->action(h);
-		trace_softirq_exit(vec_nr);
-		if (unlikely(prev_count != preempt_count())) {
-			pr_err("huh, entered softirq %u %s %p with preempt_count %08x, exited with %08x?\n",
-			       vec_nr, softirq_to_name[vec_nr], h->action,
-			       prev_count, preempt_count());
-			preempt_count_set(prev_count);
-		}
+		delta = softirq_run_vec(h);
+		softirq_vec_charge(&budget, h - softirq_vec, delta);
 		h++;
 		pending >>= softirq_bit;
 	}
@@ -568,7 +781,7 @@ static void handle_softirqs(bool ksirqd)
 
 	local_irq_disable();
 
-	pending = local_softirq_pending();
+	pending = softirq_vec_defer(&budget, local_softirq_pending());
 	if (pending) {
 		if (time_before(jiffies, end) && !need_resched() &&
 		    --max_restart)
@@ -697,6 +910,8 @@ void __raise_softirq_irqoff(unsigned int nr)
 {
 	lockdep_assert_irqs_disabled();
 	trace_softirq_raise(nr);
+	if (softirq_vec_raise(nr))
+		return;
 	or_softirq_pending(1UL << nr);
 }
 
@@ -977,6 +1192,7 @@ static __init int spawn_ksoftirqd(void)
 	cpuhp_setup_state_nocalls(CPUHP_SOFTIRQ_DEAD, "softirq:dead", NULL,
 				  takeover_tasklets);
 	BUG_ON(smpboot_register_percpu_thread(&softirq_threads));
+	spawn_ksoftirqd_vec();
 
 	return 0;
 }
@@ -45,6 +45,7 @@
 #include <linux/version.h>
 #include <linux/ctype.h>
 #include <linux/syscall_user_dispatch.h>
+#include <linux/rseq.h>
 
 #include <linux/compat.h>
 #include <linux/syscalls.h>
@@ -2754,6 +2755,24 @@ SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 		error = !!test_bit(MMF_VM_MERGE_ANY, &me->mm->flags);
 		break;
 #endif
+	case PR_SET_FORK_PARALLEL:
+		if (arg3 || arg4 || arg5 || !IS_ENABLED(CONFIG_PADATA))
+			return -EINVAL;
+		if (arg2)
+			set_bit(MMF_FORK_PARALLEL, &me->mm->flags);
+		else
+			clear_bit(MMF_FORK_PARALLEL, &me->mm->flags);
+		break;
+	case PR_GET_FORK_PARALLEL:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = !!test_bit(MMF_FORK_PARALLEL, &me->mm->flags);
+		break;
+	case PR_SET_RSEQ_CID_AREA:
+		if (arg5)
+			return -EINVAL;
+		error = rseq_set_cid_area(arg2, arg3, arg4);
+		break;
 	case PR_RISCV_V_SET_CONTROL:
 		error = RISCV_V_SET_CONTROL(arg2);
 		break;
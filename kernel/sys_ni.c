@@ -88,6 +88,8 @@ COND_SYSCALL(futex_waitv);
 COND_SYSCALL(futex_wake);
 COND_SYSCALL(futex_wait);
 COND_SYSCALL(futex_requeue);
+COND_SYSCALL(futex_wakev);
+COND_SYSCALL(futex_requeuev);
 COND_SYSCALL(kexec_load);
 COND_SYSCALL_COMPAT(kexec_load);
 COND_SYSCALL(init_module);
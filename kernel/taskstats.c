@@ -39,7 +39,8 @@ static const struct nla_policy taskstats_cmd_get_policy[] = {
 	[TASKSTATS_CMD_ATTR_PID]  = { .type = NLA_U32 },
 	[TASKSTATS_CMD_ATTR_TGID] = { .type = NLA_U32 },
 	[TASKSTATS_CMD_ATTR_REGISTER_CPUMASK] = { .type = NLA_STRING },
-	[TASKSTATS_CMD_ATTR_DEREGISTER_CPUMASK] = { .type = NLA_STRING },};
+	[TASKSTATS_CMD_ATTR_DEREGISTER_CPUMASK] = { .type = NLA_STRING },
+	[TASKSTATS_CMD_ATTR_CGROUP_FD] = { .type = NLA_U32 },};
 
 static const struct nla_policy cgroupstats_cmd_get_policy[] = {
 	[CGROUPSTATS_CMD_ATTR_FD] = { .type = NLA_U32 },
@@ -568,6 +569,100 @@ static int taskstats_user_cmd(struct sk_buff *skb, struct genl_info *info)
 		return -EINVAL;
 }
 
+/*
+ * A dump of TASKSTATS_CMD_GET returns one TASKSTATS_TYPE_AGGR_PID record
+ * per task of the caller's pid namespace, optionally restricted to the
+ * tasks of the cgroup (v2) given by TASKSTATS_CMD_ATTR_CGROUP_FD and its
+ * descendants, in a single pass instead of one request per pid.
+ */
+static int taskstats_dump_start(struct netlink_callback *cb)
+{
+#ifdef CONFIG_CGROUPS
+	struct nlattr *na = genl_info_dump(cb)->attrs[TASKSTATS_CMD_ATTR_CGROUP_FD];
+	struct cgroup *cgrp;
+
+	if (!na)
+		return 0;
+
+	cgrp = cgroup_get_from_fd(nla_get_u32(na));
+	if (IS_ERR(cgrp))
+		return PTR_ERR(cgrp);
+	cb->args[1] = (long)cgrp;
+	return 0;
+#else
+	if (genl_info_dump(cb)->attrs[TASKSTATS_CMD_ATTR_CGROUP_FD])
+		return -EOPNOTSUPP;
+	return 0;
+#endif
+}
+
+static int taskstats_dump_done(struct netlink_callback *cb)
+{
+#ifdef CONFIG_CGROUPS
+	struct cgroup *cgrp = (struct cgroup *)cb->args[1];
+
+	if (cgrp)
+		cgroup_put(cgrp);
+#endif
+	return 0;
+}
+
+static int taskstats_user_dump(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	struct pid_namespace *pid_ns = task_active_pid_ns(current);
+	struct cgroup *cgrp = (struct cgroup *)cb->args[1];
+	struct taskstats *stats;
+	struct task_struct *tsk;
+	struct pid *pid;
+	void *reply;
+	pid_t nr;
+
+	for (nr = cb->args[0]; ; nr++) {
+		rcu_read_lock();
+		pid = find_ge_pid(nr, pid_ns);
+		tsk = NULL;
+		if (pid) {
+			nr = pid_nr_ns(pid, pid_ns);
+			tsk = pid_task(pid, PIDTYPE_PID);
+			if (tsk && cgrp && !task_under_cgroup_hierarchy(tsk, cgrp))
+				tsk = NULL;
+			if (tsk)
+				get_task_struct(tsk);
+		}
+		rcu_read_unlock();
+
+		if (!pid)
+			break;
+		if (!tsk) {
+			/* The cgroup filter may skip most of the pid space */
+			cond_resched();
+			continue;
+		}
+
+		reply = genlmsg_put(skb, NETLINK_CB(cb->skb).portid,
+				    cb->nlh->nlmsg_seq, &family, NLM_F_MULTI,
+				    TASKSTATS_CMD_NEW);
+		if (!reply) {
+			put_task_struct(tsk);
+			break;
+		}
+
+		stats = mk_reply(skb, TASKSTATS_TYPE_PID, nr);
+		if (!stats) {
+			genlmsg_cancel(skb, reply);
+			put_task_struct(tsk);
+			break;
+		}
+
+		fill_stats(current_user_ns(), pid_ns, tsk, stats);
+		put_task_struct(tsk);
+		genlmsg_end(skb, reply);
+	}
+	cb->args[0] = nr;
+
+	return skb->len;
+}
+
 static struct taskstats *taskstats_tgid_alloc(struct task_struct *tsk)
 {
 	struct signal_struct *sig = tsk->signal;
@@ -666,8 +761,11 @@ void taskstats_exit(struct task_struct *tsk, int group_dead)
 static const struct genl_ops taskstats_ops[] = {
 	{
 		.cmd		= TASKSTATS_CMD_GET,
-		.validate = GENL_DONT_VALIDATE_STRICT | GENL_DONT_VALIDATE_DUMP,
+		.validate = GENL_DONT_VALIDATE_STRICT,
 		.doit		= taskstats_user_cmd,
+		.start		= taskstats_dump_start,
+		.dumpit		= taskstats_user_dump,
+		.done		= taskstats_dump_done,
 		.policy		= taskstats_cmd_get_policy,
 		.maxattr	= ARRAY_SIZE(taskstats_cmd_get_policy) - 1,
 		.flags		= GENL_ADMIN_PERM,
@@ -1075,6 +1075,92 @@ u64 hrtimer_forward(struct hrtimer *timer, ktime_t now, ktime_t interval)
 }
 EXPORT_SYMBOL_GPL(hrtimer_forward);
 
+#ifdef CONFIG_HRTIMER_GROUPS
+/*
+ * Grouped soft timers whose range contains the expiry time of an already
+ * queued grouped timer do not get their own timerqueue node. They are
+ * hooked on the queued timer, the group leader, and expire along with it.
+ * The leader's expiry time is within [softexpires, expires] of all of its
+ * members, so none of them can fire late, and the leader stays the only node
+ * the tree and the clock event device have to care about.
+ */
+static struct hrtimer *hrtimer_group_find(struct hrtimer_clock_base *base,
+					  struct hrtimer *timer)
+{
+	struct rb_node *rb = base->active.rb_root.rb_root.rb_node;
+	ktime_t soft = hrtimer_get_softexpires_tv64(timer);
+	struct hrtimer *leader = NULL;
+
+	if (!timer->is_grouped)
+		return NULL;
+
+	/* The first queued timer which does not expire before @soft */
+	while (rb) {
+		struct hrtimer *t = rb_entry(rb, struct hrtimer, node.node);
+
+		if (t->node.expires < soft) {
+			rb = rb->rb_right;
+		} else {
+			leader = t;
+			rb = rb->rb_left;
+		}
+	}
+
+	if (leader && leader->is_grouped &&
+	    leader->node.expires <= hrtimer_get_expires_tv64(timer))
+		return leader;
+	return NULL;
+}
+
+/* Returns true if @timer was a group member and is now off its group */
+static inline bool hrtimer_group_del(struct hrtimer *timer)
+{
+	if (hlist_unhashed(&timer->group_node))
+		return false;
+
+	hlist_del_init(&timer->group_node);
+	return true;
+}
+
+/*
+ * A leader which is removed before it expires hands its members back to the
+ * timerqueue. They cannot simply follow a new leader, whose expiry time may
+ * be outside their range.
+ */
+static void hrtimer_group_disband(struct hrtimer *timer,
+				  struct hrtimer_clock_base *base)
+{
+	struct hlist_node *tmp;
+	struct hrtimer *t;
+
+	if (hlist_empty(&timer->group))
+		return;
+
+	hlist_for_each_entry_safe(t, tmp, &timer->group, group_node) {
+		hlist_del_init(&t->group_node);
+		timerqueue_add(&base->active, &t->node);
+	}
+	base->cpu_base->active_bases |= 1 << base->index;
+}
+
+static inline void hrtimer_group_take(struct hrtimer *timer,
+				      struct hlist_head *group)
+{
+	hlist_move_list(&timer->group, group);
+}
+#else
+static inline struct hrtimer *hrtimer_group_find(struct hrtimer_clock_base *base,
+						 struct hrtimer *timer)
+{
+	return NULL;
+}
+static inline bool hrtimer_group_del(struct hrtimer *timer) { return false; }
+static inline void hrtimer_group_disband(struct hrtimer *timer,
+					 struct hrtimer_clock_base *base) { }
+static inline void hrtimer_group_take(struct hrtimer *timer,
+				      struct hlist_head *group) { }
+#endif
+
 /*
  * enqueue_hrtimer - internal function to (re)start a timer
  *
@@ -1087,6 +1173,8 @@ static int enqueue_hrtimer(struct hrtimer *timer,
 			   struct hrtimer_clock_base *base,
 			   enum hrtimer_mode mode)
 {
+	struct hrtimer *leader;
+
 	debug_activate(timer, mode);
 	WARN_ON_ONCE(!base->cpu_base->online);
 
@@ -1095,6 +1183,13 @@ static int enqueue_hrtimer(struct hrtimer *timer,
 	/* Pairs with the lockless read in hrtimer_is_queued() */
 	WRITE_ONCE(timer->state, HRTIMER_STATE_ENQUEUED);
 
+	/* Joining a group never changes the first expiring timer */
+	leader = hrtimer_group_find(base, timer);
+	if (leader) {
+		hlist_add_head(&timer->group_node, &leader->group);
+		return 0;
+	}
+
 	return timerqueue_add(&base->active, &timer->node);
 }
 
@@ -1120,8 +1215,13 @@ static void __remove_hrtimer(struct hrtimer *timer,
 	if (!(state & HRTIMER_STATE_ENQUEUED))
 		return;
 
+	/* Group members are not in the timerqueue */
+	if (hrtimer_group_del(timer))
+		return;
+
 	if (!timerqueue_del(&base->active, &timer->node))
 		cpu_base->active_bases &= ~(1 << base->index);
+	hrtimer_group_disband(timer, base);
 
 	/*
 	 * Note: If reprogram is false we do not update
@@ -1253,6 +1353,9 @@ static int __hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 	tim = hrtimer_update_lowres(timer, tim, mode);
 
 	hrtimer_set_expires_range_ns(timer, tim, delta_ns);
+#ifdef CONFIG_HRTIMER_GROUPS
+	timer->is_grouped = (mode & HRTIMER_MODE_GROUP) && timer->is_soft;
+#endif
 
 	/* Switch the timer base, if necessary: */
 	if (!force_local) {
@@ -1686,6 +1789,7 @@ static void __run_hrtimer(struct hrtimer_cpu_base *cpu_base,
 	 * is dropped.
 	 */
 	raw_spin_unlock_irqrestore(&cpu_base->lock, flags);
+	isolation_log_intr(ISOL_INTR_TIMER, (unsigned long)fn);
 	trace_hrtimer_expire_entry(timer, now);
 	expires_in_hardirq = lockdep_hrtimer_enter(timer);
 
@@ -1721,6 +1825,44 @@ static void __run_hrtimer(struct hrtimer_cpu_base *cpu_base,
 	base->running = NULL;
 }
 
+#ifdef CONFIG_HRTIMER_GROUPS
+/*
+ * Run the members of an expired group, whose leader has just been run with
+ * the same base time. Members which joined a leader that expired at its soft
+ * expiry time may not have reached theirs yet, those are queued back on
+ * their own.
+ */
+static void hrtimer_group_run(struct hrtimer_cpu_base *cpu_base,
+			      struct hrtimer_clock_base *base,
+			      struct hlist_head *group, ktime_t *now,
+			      unsigned long flags, unsigned int active_mask)
+{
+	while (!hlist_empty(group)) {
+		struct hrtimer *timer;
+
+		timer = hlist_entry(group->first, struct hrtimer, group_node);
+
+		if (*now < hrtimer_get_softexpires_tv64(timer)) {
+			hlist_del_init(&timer->group_node);
+			timerqueue_add(&base->active, &timer->node);
+			cpu_base->active_bases |= 1 << base->index;
+			continue;
+		}
+
+		/* Takes @timer off @group through __remove_hrtimer() */
+		__run_hrtimer(cpu_base, base, timer, now, flags);
+		if (active_mask == HRTIMER_ACTIVE_SOFT)
+			hrtimer_sync_wait_running(cpu_base, flags);
+	}
+}
+#else
+static inline void hrtimer_group_run(struct hrtimer_cpu_base *cpu_base,
+				     struct hrtimer_clock_base *base,
+				     struct hlist_head *group, ktime_t *now,
+				     unsigned long flags,
+				     unsigned int active_mask) { }
+#endif
+
 static void __hrtimer_run_queues(struct hrtimer_cpu_base *cpu_base, ktime_t now,
 				 unsigned long flags, unsigned int active_mask)
 {
@@ -1734,6 +1876,7 @@ static void __hrtimer_run_queues(struct hrtimer_cpu_base *cpu_base, ktime_t now,
 		basenow = ktime_add(now, base->offset);
 
 		while ((node = timerqueue_getnext(&base->active))) {
+			HLIST_HEAD(group);
 			struct hrtimer *timer;
 
 			timer = container_of(node, struct hrtimer, node);
@@ -1753,9 +1896,13 @@ static void __hrtimer_run_queues(struct hrtimer_cpu_base *cpu_base, ktime_t now,
 			if (basenow < hrtimer_get_softexpires_tv64(timer))
 				break;
 
+			/* Detach the group before the leader can requeue */
+			hrtimer_group_take(timer, &group);
 			__run_hrtimer(cpu_base, base, timer, &basenow, flags);
 			if (active_mask == HRTIMER_ACTIVE_SOFT)
 				hrtimer_sync_wait_running(cpu_base, flags);
+			hrtimer_group_run(cpu_base, base, &group, &basenow,
+					  flags, active_mask);
 		}
 	}
 }
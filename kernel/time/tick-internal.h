@@ -177,6 +177,15 @@ static inline void timers_update_nohz(void) { }
 
 DECLARE_PER_CPU(struct hrtimer_cpu_base, hrtimer_bases);
 
+struct timer_base_stats {
+	unsigned long	nr_slack;
+	unsigned long	nr_batches;
+	unsigned long	nr_expired;
+};
+
+extern bool timer_base_get_stats(unsigned int cpu, unsigned int idx,
+				 struct timer_base_stats *stats);
+
 extern u64 get_next_timer_interrupt(unsigned long basej, u64 basem);
 u64 timer_base_try_to_set_idle(unsigned long basej, u64 basem, bool *idle);
 void timer_clear_idle(void);
@@ -41,9 +41,11 @@
 #include <linux/sched/sysctl.h>
 #include <linux/sched/nohz.h>
 #include <linux/sched/debug.h>
+#include <linux/sched/isolation.h>
 #include <linux/slab.h>
 #include <linux/compat.h>
 #include <linux/random.h>
+#include <linux/prefetch.h>
 #include <linux/sysctl.h>
 
 #include <linux/uaccess.h>
@@ -247,6 +249,9 @@ EXPORT_SYMBOL(jiffies_64);
  * @vectors:		Array of lists; Each array member reflects a bucket
  *			of the timer wheel. The list contains all timers
  *			which are enqueued into a specific bucket.
+ * @nr_slack:		Number of TIMER_SLACK enqueues whose expiry was moved
+ * @nr_batches:		Number of wheel buckets expired
+ * @nr_expired:		Number of timers expired from those buckets
  */
 struct timer_base {
 	raw_spinlock_t		lock;
@@ -263,6 +268,9 @@ struct timer_base {
 	bool			timers_pending;
 	DECLARE_BITMAP(pending_map, WHEEL_SIZE);
 	struct hlist_head	vectors[WHEEL_SIZE];
+	unsigned long		nr_slack;
+	unsigned long		nr_batches;
+	unsigned long		nr_expired;
 } ____cacheline_aligned;
 
 static DEFINE_PER_CPU(struct timer_base, timer_bases[NR_BASES]);
@@ -620,6 +628,36 @@ static int calc_wheel_index(unsigned long expires, unsigned long clk,
 	return idx;
 }
 
+/*
+ * TIMER_SLACK timers accept to expire up to 1/8 of their timeout late, which
+ * is the worst case granularity of the wheel levels anyway. Pick the expiry
+ * value with the most trailing zero bits within that slack, so that slack
+ * timers with close expiry values end up on the same jiffy, hence in the
+ * same bucket, and are expired as one batch by expire_timers().
+ */
+#define TIMER_SLACK_SHIFT	3
+
+static inline unsigned long timer_slack_expires(struct timer_base *base,
+						struct timer_list *timer,
+						unsigned long expires,
+						unsigned long clk)
+{
+	unsigned long delta = expires - clk;
+	unsigned long limit, mask;
+
+	if (!(timer->flags & TIMER_SLACK) || (long)delta <= 0)
+		return expires;
+
+	limit = expires + (delta >> TIMER_SLACK_SHIFT);
+	mask = expires ^ limit;
+	if (!mask)
+		return expires;
+
+	mask = (1UL << __fls(mask)) - 1;
+	base->nr_slack++;
+	return limit & ~mask;
+}
+
 static void
 trigger_dyntick_cpu(struct timer_base *base, struct timer_list *timer)
 {
@@ -685,7 +723,9 @@ static void internal_add_timer(struct timer_base *base, struct timer_list *timer
 	unsigned long bucket_expiry;
 	unsigned int idx;
 
-	idx = calc_wheel_index(timer->expires, base->clk, &bucket_expiry);
+	idx = calc_wheel_index(timer_slack_expires(base, timer, timer->expires,
+						   base->clk),
+			       base->clk, &bucket_expiry);
 	enqueue_timer(base, timer, idx, bucket_expiry);
 }
 
@@ -1114,7 +1154,9 @@ __mod_timer(struct timer_list *timer, unsigned long expires, unsigned int option
 		}
 
 		clk = base->clk;
-		idx = calc_wheel_index(expires, clk, &bucket_expiry);
+		idx = calc_wheel_index(timer_slack_expires(base, timer, expires,
+							   clk),
+				       clk, &bucket_expiry);
 
 		/*
 		 * Retrieve and compare the array index of the pending
@@ -1789,6 +1831,7 @@ static void call_timer_fn(struct timer_list *timer,
 	 */
 	lock_map_acquire(&lockdep_map);
 
+	isolation_log_intr(ISOL_INTR_TIMER, (unsigned long)fn);
 	trace_timer_expire_entry(timer, baseclk);
 	fn(timer);
 	trace_timer_expire_exit(timer);
@@ -1817,6 +1860,8 @@ static void expire_timers(struct timer_base *base, struct hlist_head *head)
 	 */
 	unsigned long baseclk = base->clk - 1;
 
+	base->nr_batches++;
+
 	while (!hlist_empty(head)) {
 		struct timer_list *timer;
 		void (*fn)(struct timer_list *);
@@ -1825,6 +1870,14 @@ static void expire_timers(struct timer_base *base, struct hlist_head *head)
 
 		base->running_timer = timer;
 		detach_timer(timer, true);
+		base->nr_expired++;
+
+		/*
+		 * The timers of a bucket are usually cold. Fetch the next one
+		 * while the callback of this one runs.
+		 */
+		if (head->first)
+			prefetchw(head->first);
 
 		fn = timer->function;
 
@@ -2483,6 +2536,7 @@ void update_process_times(int user_tick)
 	/* Note: this timer irq context must be accounted for as well. */
 	account_process_tick(p, user_tick);
 	run_local_timers();
+	smp_call_function_tick();
 	rcu_sched_clock_irq(user_tick);
 #ifdef CONFIG_IRQ_WORK
 	if (in_irq())
@@ -2718,8 +2772,29 @@ static void __init init_timer_cpus(void)
 		init_timer_cpu(cpu);
 }
 
+/*
+ * Report the TIMER_SLACK and batching statistics of timer base @idx of @cpu
+ * for /proc/timer_list. Returns false if there is no such base.
+ */
+bool timer_base_get_stats(unsigned int cpu, unsigned int idx,
+			  struct timer_base_stats *stats)
+{
+	struct timer_base *base;
+
+	if (idx >= NR_BASES)
+		return false;
+
+	base = per_cpu_ptr(&timer_bases[idx], cpu);
+	stats->nr_slack = READ_ONCE(base->nr_slack);
+	stats->nr_batches = READ_ONCE(base->nr_batches);
+	stats->nr_expired = READ_ONCE(base->nr_expired);
+	return true;
+}
+
 void __init init_timers(void)
 {
+	BUILD_BUG_ON(NR_CPUS > TIMER_CPUMASK + 1);
+
 	init_timer_cpus();
 	posix_cputimers_init_work();
 	open_softirq(TIMER_SOFTIRQ, run_timer_softirq);
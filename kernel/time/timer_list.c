@@ -174,6 +174,20 @@ static void print_cpu(struct seq_file *m, int cpu, u64 now)
 
 #undef P
 #undef P_ns
+
+	{
+		struct timer_base_stats stats;
+
+		for (i = 0; timer_base_get_stats(cpu, i, &stats); i++) {
+			SEQ_printf(m, " timer base %d:\n", i);
+			SEQ_printf(m, "  .%-15s: %lu\n", "nr_slack",
+				   stats.nr_slack);
+			SEQ_printf(m, "  .%-15s: %lu\n", "nr_batches",
+				   stats.nr_batches);
+			SEQ_printf(m, "  .%-15s: %lu\n", "nr_expired",
+				   stats.nr_expired);
+		}
+	}
 	SEQ_printf(m, "\n");
 }
 
@@ -260,7 +274,7 @@ static void timer_list_show_tickdevices_header(struct seq_file *m)
 
 static inline void timer_list_header(struct seq_file *m, u64 now)
 {
-	SEQ_printf(m, "Timer List Version: v0.10\n");
+	SEQ_printf(m, "Timer List Version: v0.11\n");
 	SEQ_printf(m, "HRTIMER_MAX_CLOCK_BASES: %d\n", HRTIMER_MAX_CLOCK_BASES);
 	SEQ_printf(m, "now at %Ld nsecs\n", (unsigned long long)now);
 	SEQ_printf(m, "\n");
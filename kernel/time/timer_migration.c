@@ -5,6 +5,8 @@
  * Copyright(C) 2022 linutronix GmbH
  */
 #include <linux/cpuhotplug.h>
+#include <linux/cpuidle.h>
+#include <linux/debugfs.h>
 #include <linux/slab.h>
 #include <linux/smp.h>
 #include <linux/spinlock.h>
@@ -475,6 +477,52 @@ static bool tmigr_check_lonely(struct tmigr_group *group)
 	return bitmap_weight(&active, BIT_CNT) <= 1;
 }
 
+/*
+ * Exit latency of the CPU which would act for @group's child @bit: the child
+ * CPU itself on level 0, the CPU at the end of the migrator chain otherwise.
+ * Read locklessly, only a hint for the migrator selection.
+ */
+static u64 tmigr_child_exit_latency(struct tmigr_group *group,
+				    unsigned long bit)
+{
+	union tmigr_state s;
+
+	while (group->level) {
+		group = group->children.groups[bit];
+		s.state = atomic_read(&group->migr_state);
+		if (s.migrator == TMIGR_NONE)
+			return U64_MAX;
+		bit = __ffs(s.migrator);
+	}
+
+	return sched_idle_exit_latency(group->children.cpus[bit]);
+}
+
+/*
+ * Select the new migrator out of the @active children of @group. Active
+ * children can still be in a cpuidle state with the tick running, so prefer
+ * the one whose CPU has the shortest exit latency, a running CPU first of
+ * all: the migrator expires the timers of the idle CPUs and its wakeup
+ * latency adds to theirs.
+ */
+static u8 tmigr_select_migrator(struct tmigr_group *group, unsigned long active)
+{
+	unsigned long bit, best = BIT_CNT;
+	u64 latency, best_latency = U64_MAX;
+
+	for_each_set_bit(bit, &active, BIT_CNT) {
+		latency = tmigr_child_exit_latency(group, bit);
+		if (best == BIT_CNT || latency < best_latency) {
+			best = bit;
+			best_latency = latency;
+			if (!latency)
+				break;
+		}
+	}
+
+	return best == BIT_CNT ? TMIGR_NONE : BIT(best);
+}
+
 typedef bool (*up_f)(struct tmigr_group *, struct tmigr_group *, void *);
 
 static void __walk_groups(up_f up, void *data,
@@ -1024,7 +1072,11 @@ static bool tmigr_handle_remote_up(struct tmigr_group *group,
 
 	if (evt) {
 		unsigned int remote_cpu = evt->cpu;
+		u64 latency = now - evt->nextevt.expires;
 
+		group->remote_count++;
+		group->remote_lat_total += latency;
+		group->remote_lat_max = max(group->remote_lat_max, latency);
 		raw_spin_unlock_irq(&group->lock);
 
 		tmigr_handle_remote_cpu(remote_cpu, now, jif);
@@ -1280,18 +1332,12 @@ static bool tmigr_inactive_up(struct tmigr_group *group,
 			 * group is idle!
 			 */
 			if (!childstate.active) {
-				unsigned long new_migr_bit, active = newstate.active;
-
-				new_migr_bit = find_first_bit(&active, BIT_CNT);
-
-				if (new_migr_bit != BIT_CNT) {
-					newstate.migrator = BIT(new_migr_bit);
-				} else {
-					newstate.migrator = TMIGR_NONE;
+				newstate.migrator = tmigr_select_migrator(group,
+							newstate.active);
 
-					/* Changes need to be propagated */
+				/* Changes need to be propagated */
+				if (newstate.migrator == TMIGR_NONE)
 					walk_done = false;
-				}
 			}
 		}
 
@@ -1522,6 +1568,7 @@ static void tmigr_connect_child_parent(struct tmigr_group *child,
 	raw_spin_lock_nested(&parent->lock, SINGLE_DEPTH_NESTING);
 
 	child->parent = parent;
+	parent->children.groups[parent->num_children] = child;
 	child->childmask = BIT(parent->num_children++);
 
 	raw_spin_unlock(&parent->lock);
@@ -1616,6 +1663,7 @@ static int tmigr_setup_groups(unsigned int cpu, unsigned int node)
 			raw_spin_lock_irq(&group->lock);
 
 			tmc->tmgroup = group;
+			group->children.cpus[group->num_children] = cpu;
 			tmc->childmask = BIT(group->num_children++);
 
 			raw_spin_unlock_irq(&group->lock);
@@ -1740,6 +1788,49 @@ static int tmigr_cpu_offline(unsigned int cpu)
 	return 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int tmigr_stats_show(struct seq_file *m, void *v)
+{
+	struct tmigr_group *group;
+	unsigned int lvl, i;
+
+	seq_puts(m, "# level group node active migrator remote_count remote_lat_avg_ns remote_lat_max_ns\n");
+
+	mutex_lock(&tmigr_mutex);
+	for (lvl = 0; lvl < tmigr_hierarchy_levels; lvl++) {
+		i = 0;
+		list_for_each_entry(group, &tmigr_level_list[lvl], list) {
+			union tmigr_state s;
+			u64 count, total, max;
+
+			raw_spin_lock_irq(&group->lock);
+			count = group->remote_count;
+			total = group->remote_lat_total;
+			max = group->remote_lat_max;
+			raw_spin_unlock_irq(&group->lock);
+
+			s.state = atomic_read(&group->migr_state);
+			seq_printf(m, "%u %u %d %#04x %#04x %llu %llu %llu\n",
+				   lvl, i++, group->numa_node, s.active,
+				   s.migrator, count,
+				   count ? div64_u64(total, count) : 0, max);
+		}
+	}
+	mutex_unlock(&tmigr_mutex);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(tmigr_stats);
+
+static void __init tmigr_debugfs_init(void)
+{
+	debugfs_create_file("timer_migration", 0444, NULL, NULL,
+			    &tmigr_stats_fops);
+}
+#else
+static inline void tmigr_debugfs_init(void) { }
+#endif
+
 static int __init tmigr_init(void)
 {
 	unsigned int cpulvl, nodelvl, cpus_per_node, i;
@@ -1801,6 +1892,7 @@ static int __init tmigr_init(void)
 	if (ret)
 		goto err;
 
+	tmigr_debugfs_init();
 	return 0;
 
 err:
@@ -48,6 +48,14 @@ struct tmigr_event {
  *			tmigr_level_list; is required during setup when a
  *			new group needs to be connected to the existing
  *			hierarchy groups
+ * @children:		The CPUs (level 0) or groups (other levels) per
+ *			childmask bit; is set during setup and will never
+ *			change; used to prefer migrators which can be woken
+ *			up quickly
+ * @remote_count:	Number of remote CPU expiries done through the group
+ * @remote_lat_total:	Sum of the delays in ns between expiry time and
+ *			remote expiry, protected by @lock
+ * @remote_lat_max:	Largest of these delays, protected by @lock
  */
 struct tmigr_group {
 	raw_spinlock_t		lock;
@@ -61,6 +69,13 @@ struct tmigr_group {
 	unsigned int		num_children;
 	u8			childmask;
 	struct list_head	list;
+	union {
+		unsigned int		cpus[TMIGR_CHILDREN_PER_GROUP];
+		struct tmigr_group	*groups[TMIGR_CHILDREN_PER_GROUP];
+	} children;
+	u64			remote_count;
+	u64			remote_lat_total;
+	u64			remote_lat_max;
 };
 
 /**
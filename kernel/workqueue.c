@@ -187,6 +187,7 @@ struct worker_pool {
 	unsigned int		flags;		/* L: flags */
 
 	unsigned long		watchdog_ts;	/* L: watchdog timestamp */
+	unsigned long		cm_stall_ts;	/* L: last CM stall report */
 	bool			cpu_stall;	/* WD: stalled cpu bound pool */
 
 	/*
@@ -247,6 +248,9 @@ enum pool_workqueue_stats {
 	PWQ_NR_STATS,
 };
 
+/* log2 buckets of ~1us, see wq_hist_bucket() */
+#define WQ_HIST_BUCKETS		20
+
 /*
  * The per-pool workqueue.  While queued, bits below WORK_PWQ_SHIFT
  * of work_struct->data are used for flags and the remaining high bits
@@ -286,6 +290,11 @@ struct pool_workqueue {
 	struct list_head	mayday_node;	/* MD: node on wq->maydays */
 
 	u64			stats[PWQ_NR_STATS];
+#ifdef CONFIG_WQ_LATENCY_HIST
+	/* L: log2 us buckets of queue to start and of execution time */
+	u64			lat_hist[WQ_HIST_BUCKETS];
+	u64			exec_hist[WQ_HIST_BUCKETS];
+#endif
 
 	/*
 	 * Release of unbound pwq is punted to a kthread_worker. See put_pwq()
@@ -410,6 +419,13 @@ static const char *wq_affn_names[WQ_AFFN_NR_TYPES] = {
  */
 static unsigned long wq_cpu_intensive_thresh_us = ULONG_MAX;
 module_param_named(cpu_intensive_thresh_us, wq_cpu_intensive_thresh_us, ulong, 0644);
+
+/*
+ * Warn when a concurrency-managed worker hogging its CPU has kept work items
+ * of its per-cpu pool pending for longer than this. 0 disables the check.
+ */
+static unsigned long wq_cm_stall_thresh_ms;
+module_param_named(cm_stall_thresh_ms, wq_cm_stall_thresh_ms, ulong, 0644);
 #ifdef CONFIG_WQ_CPU_INTENSIVE_REPORT
 static unsigned int wq_cpu_intensive_warning_thresh = 4;
 module_param_named(cpu_intensive_warning_thresh, wq_cpu_intensive_warning_thresh, uint, 0644);
@@ -1471,6 +1487,40 @@ void wq_worker_sleeping(struct task_struct *task)
 	raw_spin_unlock_irq(&pool->lock);
 }
 
+/*
+ * A concurrency-managed worker keeps the other work items of its per-cpu pool
+ * waiting until it sleeps or is marked CPU_INTENSIVE. Report once per stall
+ * when no work item of the pool has started for wq_cm_stall_thresh_ms while
+ * some are pending.
+ */
+static void wq_cm_stall_check(struct worker *worker, struct worker_pool *pool)
+{
+	unsigned long thresh = READ_ONCE(wq_cm_stall_thresh_ms);
+	struct work_struct *work;
+	unsigned long ts;
+
+	if (!thresh || pool->cpu < 0 || (worker->flags & WORKER_NOT_RUNNING))
+		return;
+
+	ts = READ_ONCE(pool->watchdog_ts);
+	if (time_before(jiffies, ts + msecs_to_jiffies(thresh)) ||
+	    ts == READ_ONCE(pool->cm_stall_ts) ||
+	    data_race(list_empty(&pool->worklist)))
+		return;
+
+	raw_spin_lock(&pool->lock);
+	work = list_first_entry_or_null(&pool->worklist, struct work_struct,
+					entry);
+	if (work && pool->cm_stall_ts != pool->watchdog_ts) {
+		pool->cm_stall_ts = pool->watchdog_ts;
+		pr_warn("workqueue: %ps pending for %ums on cpu%d behind %ps of %s\n",
+			work->func, jiffies_to_msecs(jiffies - pool->watchdog_ts),
+			pool->cpu, worker->current_func,
+			worker->current_pwq->wq->name);
+	}
+	raw_spin_unlock(&pool->lock);
+}
+
 /**
  * wq_worker_tick - a scheduler tick occurred while a kworker is running
  * @task: task currently running
@@ -1489,6 +1539,8 @@ void wq_worker_tick(struct task_struct *task)
 
 	pwq->stats[PWQ_STAT_CPU_TIME] += TICK_USEC;
 
+	wq_cm_stall_check(worker, pool);
+
 	if (!wq_cpu_intensive_thresh_us)
 		return;
 
@@ -2250,6 +2302,47 @@ static bool work_grab_pending(struct work_struct *work, u32 cflags,
 	goto repeat;
 }
 
+#ifdef CONFIG_WQ_LATENCY_HIST
+static inline int wq_hist_bucket(u64 ns)
+{
+	u64 us = ns >> 10;
+
+	return min_t(int, us ? ilog2(us) + 1 : 0, WQ_HIST_BUCKETS - 1);
+}
+
+static inline void wq_hist_queue(struct work_struct *work)
+{
+	work->queued_ns = ktime_get_mono_fast_ns();
+}
+
+/* Called with the pool lock held, while @work is still ours */
+static inline u64 wq_hist_start(struct pool_workqueue *pwq,
+				struct work_struct *work)
+{
+	u64 now = ktime_get_mono_fast_ns();
+
+	pwq->lat_hist[wq_hist_bucket(now - work->queued_ns)]++;
+	return now;
+}
+
+static inline u64 wq_hist_elapsed(u64 start)
+{
+	return ktime_get_mono_fast_ns() - start;
+}
+
+/* Called with the pool lock held */
+static inline void wq_hist_end(struct pool_workqueue *pwq, u64 exec_ns)
+{
+	pwq->exec_hist[wq_hist_bucket(exec_ns)]++;
+}
+#else
+static inline void wq_hist_queue(struct work_struct *work) { }
+static inline u64 wq_hist_start(struct pool_workqueue *pwq,
+				struct work_struct *work) { return 0; }
+static inline u64 wq_hist_elapsed(u64 start) { return 0; }
+static inline void wq_hist_end(struct pool_workqueue *pwq, u64 exec_ns) { }
+#endif
+
 /**
  * insert_work - insert a work into a pool
  * @pwq: pwq @work belongs to
@@ -2267,6 +2360,7 @@ static void insert_work(struct pool_workqueue *pwq, struct work_struct *work,
 			struct list_head *head, unsigned int extra_flags)
 {
 	debug_work_activate(work);
+	wq_hist_queue(work);
 
 	/* record the work call stack in order to print it in KASAN reports */
 	kasan_record_aux_stack_noalloc(work);
@@ -2353,6 +2447,10 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 			cpu = wq_select_unbound_cpu(raw_smp_processor_id());
 		else
 			cpu = raw_smp_processor_id();
+
+		/* Any CPU will do, so keep it off strictly isolated CPUs */
+		if (cpu_is_isolated_strict(cpu))
+			cpu = wq_select_unbound_cpu(cpu);
 	}
 
 	pwq = rcu_dereference(*per_cpu_ptr(wq->cpu_pwq, cpu));
@@ -2545,6 +2643,62 @@ bool queue_work_node(int node, struct workqueue_struct *wq,
 }
 EXPORT_SYMBOL_GPL(queue_work_node);
 
+/*
+ * Pick the CPU to queue hinted work on: the hint itself for unbound
+ * workqueues, which selects the pwq of the hint's pod. For per-cpu
+ * workqueues, stay local if we share a cache with the hint, otherwise going
+ * over is worth the remote wakeup.
+ */
+static int select_hinted_cpu(struct workqueue_struct *wq, int hint_cpu)
+{
+	if (hint_cpu < 0 || hint_cpu >= nr_cpu_ids || !cpu_online(hint_cpu))
+		return WORK_CPU_UNBOUND;
+
+	if (wq->flags & WQ_UNBOUND)
+		return hint_cpu;
+
+	if (cpus_share_cache(raw_smp_processor_id(), hint_cpu) ||
+	    cpu_is_isolated_strict(hint_cpu))
+		return WORK_CPU_UNBOUND;
+
+	return hint_cpu;
+}
+
+/**
+ * queue_work_hinted - queue work close to the data it works on
+ * @wq: workqueue to use
+ * @work: work to queue
+ * @hint_cpu: CPU whose caches hold the data of @work, e.g. the CPU which
+ *	submitted the I/O @work completes, or WORK_CPU_UNBOUND
+ *
+ * Like queue_work(), but run @work in the affinity scope pod of @hint_cpu
+ * for unbound workqueues and, if @hint_cpu doesn't share a cache with the
+ * current CPU, on @hint_cpu for per-cpu workqueues.
+ *
+ * This is a best effort hint. It is ignored if @hint_cpu is not online; the
+ * caller need not prevent @hint_cpu from going offline, in which case @work
+ * may run on any CPU.
+ *
+ * Return: %false if @work was already on a queue, %true otherwise.
+ */
+bool queue_work_hinted(struct workqueue_struct *wq, struct work_struct *work,
+		       int hint_cpu)
+{
+	unsigned long irq_flags;
+	bool ret = false;
+
+	local_irq_save(irq_flags);
+
+	if (!test_and_set_bit(WORK_STRUCT_PENDING_BIT, work_data_bits(work))) {
+		__queue_work(select_hinted_cpu(wq, hint_cpu), wq, work);
+		ret = true;
+	}
+
+	local_irq_restore(irq_flags);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(queue_work_hinted);
+
 void delayed_work_timer_fn(struct timer_list *t)
 {
 	struct delayed_work *dwork = from_timer(dwork, t, timer);
@@ -3183,6 +3337,7 @@ __acquires(&pool->lock)
 	unsigned long work_data;
 	int lockdep_start_depth, rcu_start_depth;
 	bool bh_draining = pool->flags & POOL_BH_DRAINING;
+	u64 start_ns, exec_ns;
 #ifdef CONFIG_LOCKDEP
 	/*
 	 * It is permissible to free the struct work_struct from
@@ -3245,6 +3400,7 @@ __acquires(&pool->lock)
 	 * PENDING and queued state changes happen together while IRQ is
 	 * disabled.
 	 */
+	start_ns = wq_hist_start(pwq, work);
 	set_work_pool_and_clear_pending(work, pool->id, 0);
 
 	pwq->stats[PWQ_STAT_STARTED]++;
@@ -3278,6 +3434,7 @@ __acquires(&pool->lock)
 	 * workqueues), so hiding them isn't a problem.
 	 */
 	lockdep_invariant_state(true);
+	isolation_log_intr(ISOL_INTR_WORK, (unsigned long)worker->current_func);
 	trace_workqueue_execute_start(work);
 	worker->current_func(work);
 	/*
@@ -3285,6 +3442,7 @@ __acquires(&pool->lock)
 	 * point will only record its address.
 	 */
 	trace_workqueue_execute_end(work, worker->current_func);
+	exec_ns = wq_hist_elapsed(start_ns);
 	pwq->stats[PWQ_STAT_COMPLETED]++;
 	lock_map_release(&lockdep_map);
 	if (!bh_draining)
@@ -3315,6 +3473,7 @@ __acquires(&pool->lock)
 		cond_resched();
 
 	raw_spin_lock_irq(&pool->lock);
+	wq_hist_end(pwq, exec_ns);
 
 	/*
 	 * In addition to %WQ_CPU_INTENSIVE, @worker may also have been marked
@@ -6917,9 +7076,44 @@ static ssize_t max_active_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(max_active);
 
+#ifdef CONFIG_WQ_LATENCY_HIST
+static ssize_t latency_hist_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	u64 lat[WQ_HIST_BUCKETS] = { }, exec[WQ_HIST_BUCKETS] = { };
+	struct pool_workqueue *pwq;
+	int i, len;
+
+	/* Racy sum over the live pwqs, released pwqs take their counts along */
+	rcu_read_lock();
+	for_each_pwq(pwq, wq) {
+		for (i = 0; i < WQ_HIST_BUCKETS; i++) {
+			lat[i] += READ_ONCE(pwq->lat_hist[i]);
+			exec[i] += READ_ONCE(pwq->exec_hist[i]);
+		}
+	}
+	rcu_read_unlock();
+
+	len = sysfs_emit(buf, "# log2 buckets: <1us <2us <4us ...\nqueued");
+	for (i = 0; i < WQ_HIST_BUCKETS; i++)
+		len += sysfs_emit_at(buf, len, " %llu", lat[i]);
+	len += sysfs_emit_at(buf, len, "\nexec");
+	for (i = 0; i < WQ_HIST_BUCKETS; i++)
+		len += sysfs_emit_at(buf, len, " %llu", exec[i]);
+	len += sysfs_emit_at(buf, len, "\n");
+
+	return len;
+}
+static DEVICE_ATTR_RO(latency_hist);
+#endif
+
 static struct attribute *wq_sysfs_attrs[] = {
 	&dev_attr_per_cpu.attr,
 	&dev_attr_max_active.attr,
+#ifdef CONFIG_WQ_LATENCY_HIST
+	&dev_attr_latency_hist.attr,
+#endif
 	NULL,
 };
 ATTRIBUTE_GROUPS(wq_sysfs);
@@ -278,6 +278,11 @@ static FORCE_INLINE int LZ4_decompress_generic(
 			 */
 			if (!partialDecoding || (cpy == oend) || (ip >= (iend - 2)))
 				break;
+		} else if (length >= LZ4_LONG_COPY) {
+			/* may overlap for in-place decompression */
+			LZ4_memmove(op, ip, length);
+			ip += length;
+			op = cpy;
 		} else {
 			/* may overwrite up to WILDCOPYLENGTH beyond cpy */
 			LZ4_wildCopy(op, ip, cpy);
@@ -437,7 +442,9 @@ static FORCE_INLINE int LZ4_decompress_generic(
 				*op++ = *match++;
 		} else {
 			LZ4_copy8(op, match);
-			if (length > 16)
+			if (length >= LZ4_LONG_COPY && offset >= length)
+				LZ4_memcpy(op + 8, match + 8, cpy - op - 8);
+			else if (length > 16)
 				LZ4_wildCopy(op + 8, match + 8, cpy);
 		}
 		op = cpy; /* wildcopy correction */
@@ -82,6 +82,12 @@ typedef uintptr_t uptrval;
  * without overflowing output buffer
  */
 #define MATCH_SAFEGUARD_DISTANCE  ((2 * WILDCOPYLENGTH) - MINMATCH)
+/*
+ * literal runs and non-overlapping matches from this length on are copied
+ * with the architecture's memcpy()/memmove() (rep movsb on FSRM CPUs)
+ * rather than 8 bytes at a time
+ */
+#define LZ4_LONG_COPY 128
 
 /* Increase this value ==> compression run slower on incompressible data */
 #define LZ4_SKIPTRIGGER 6
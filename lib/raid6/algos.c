@@ -96,6 +96,9 @@ EXPORT_SYMBOL_GPL(raid6_datap_recov);
 
 const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #ifdef CONFIG_X86
+#if defined(CONFIG_AS_AVX512) && defined(CONFIG_AS_GFNI)
+	&raid6_recov_gfni,
+#endif
 #ifdef CONFIG_AS_AVX512
 	&raid6_recov_avx512,
 #endif
@@ -131,15 +134,94 @@ const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #define RAID6_TEST_DISKS	8
 #define RAID6_TEST_DISKS_ORDER	3
 
-static inline const struct raid6_recov_calls *raid6_choose_recov(void)
+/* Throughput of @perf runs over the data disks of a benchmark */
+#define RAID6_MBPS(perf, disks)					\
+	(((perf) * HZ * ((disks) - 2)) >>			\
+	 (20 - PAGE_SHIFT + RAID6_TIME_JIFFIES_LG2))
+
+#ifdef __KERNEL__
+/* Results of the boot time benchmark, in /sys/module/raid6_pq/parameters */
+#define RAID6_MAX_BENCH		32
+
+static struct raid6_bench {
+	const char *name;
+	const char *op;
+	unsigned long mbps;
+} raid6_bench[RAID6_MAX_BENCH];
+static int raid6_nr_bench;
+
+static void raid6_record_bench(const char *name, const char *op,
+			       unsigned long mbps)
+{
+	if (raid6_nr_bench < RAID6_MAX_BENCH)
+		raid6_bench[raid6_nr_bench++] = (struct raid6_bench) {
+			.name = name, .op = op, .mbps = mbps,
+		};
+}
+
+static int raid6_bench_get(char *buffer, const struct kernel_param *kp)
+{
+	int i, len = 0;
+
+	for (i = 0; i < raid6_nr_bench; i++)
+		len += scnprintf(buffer + len, PAGE_SIZE - len,
+				 "%-10s %-7s %lu MB/s\n", raid6_bench[i].name,
+				 raid6_bench[i].op, raid6_bench[i].mbps);
+
+	return len;
+}
+
+static const struct kernel_param_ops raid6_bench_ops = {
+	.get = raid6_bench_get,
+};
+module_param_cb(benchmark, &raid6_bench_ops, NULL, 0444);
+MODULE_PARM_DESC(benchmark, "Boot time throughput of the RAID-6 algorithms");
+#else
+static inline void raid6_record_bench(const char *name, const char *op,
+				      unsigned long mbps)
+{
+}
+#endif
+
+static inline const struct raid6_recov_calls *raid6_choose_recov(
+	void *(*const dptrs)[RAID6_TEST_DISKS], const int disks)
 {
+	unsigned long perf, bestperf, j0, j1;
 	const struct raid6_recov_calls *const *algo;
 	const struct raid6_recov_calls *best;
 
-	for (best = NULL, algo = raid6_recov_algos; *algo; algo++)
-		if (!best || (*algo)->priority > best->priority)
-			if (!(*algo)->valid || (*algo)->valid())
+	for (bestperf = 0, best = NULL, algo = raid6_recov_algos; *algo; algo++) {
+		if ((*algo)->valid && !(*algo)->valid())
+			continue;
+
+		if (!IS_ENABLED(CONFIG_RAID6_PQ_BENCHMARK)) {
+			if (!best || (*algo)->priority > best->priority)
 				best = *algo;
+			continue;
+		}
+
+		/* Measure the degraded read of two data disks */
+		perf = 0;
+
+		preempt_disable();
+		j0 = jiffies;
+		while ((j1 = jiffies) == j0)
+			cpu_relax();
+		while (time_before(jiffies,
+				    j1 + (1<<RAID6_TIME_JIFFIES_LG2))) {
+			(*algo)->data2(disks, PAGE_SIZE, 0, 1, *dptrs);
+			perf++;
+		}
+		preempt_enable();
+
+		if (perf > bestperf) {
+			bestperf = perf;
+			best = *algo;
+		}
+		pr_info("raid6: %-8s 2data_recov() %5ld MB/s\n", (*algo)->name,
+			RAID6_MBPS(perf, disks));
+		raid6_record_bench((*algo)->name, "recov", RAID6_MBPS(perf, disks));
+	}
 
 	if (best) {
 		raid6_2data_recov = best->data2;
@@ -188,8 +270,9 @@ static inline const struct raid6_calls *raid6_choose_gen(
 				best = *algo;
 			}
 			pr_info("raid6: %-8s gen() %5ld MB/s\n", (*algo)->name,
-				(perf * HZ * (disks-2)) >>
-				(20 - PAGE_SHIFT + RAID6_TIME_JIFFIES_LG2));
+				RAID6_MBPS(perf, disks));
+			raid6_record_bench((*algo)->name, "gen",
+					   RAID6_MBPS(perf, disks));
 		}
 	}
 
@@ -207,9 +290,7 @@ static inline const struct raid6_calls *raid6_choose_gen(
 	}
 
 	pr_info("raid6: using algorithm %s gen() %ld MB/s\n",
-		best->name,
-		(bestgenperf * HZ * (disks - 2)) >>
-		(20 - PAGE_SHIFT + RAID6_TIME_JIFFIES_LG2));
+		best->name, RAID6_MBPS(bestgenperf, disks));
 
 	if (best->xor_syndrome) {
 		perf = 0;
@@ -226,9 +307,11 @@ static inline const struct raid6_calls *raid6_choose_gen(
 		}
 		preempt_enable();
 
+		/* Only half of the data disks are xored */
 		pr_info("raid6: .... xor() %ld MB/s, rmw enabled\n",
-			(perf * HZ * (disks - 2)) >>
-			(20 - PAGE_SHIFT + RAID6_TIME_JIFFIES_LG2 + 1));
+			RAID6_MBPS(perf, disks) >> 1);
+		raid6_record_bench(best->name, "xor",
+				   RAID6_MBPS(perf, disks) >> 1);
 	}
 
 out:
@@ -272,8 +355,8 @@ int __init raid6_select_algo(void)
 	/* select raid gen_syndrome function */
 	gen_best = raid6_choose_gen(&dptrs, disks);
 
-	/* select raid recover functions */
-	rec_best = raid6_choose_recov();
+	/* select raid recover functions, they depend on gen_syndrome */
+	rec_best = gen_best ? raid6_choose_recov(&dptrs, disks) : NULL;
 
 	free_pages((unsigned long)disk_ptr, RAID6_TEST_DISKS_ORDER);
 
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * RAID-6 data recovery in dual failure mode based on the Galois Field New
+ * Instructions.
+ *
+ * vgf2p8affineqb multiplies every byte of a vector by an 8x8 bit matrix.
+ * Multiplication by a constant in GF(2^8) is linear over GF(2), so with the
+ * matrix of the constant built from the multiplication tables, each of the
+ * multiplications by the recovery coefficients is a single instruction,
+ * instead of the two table lookups and the nibble shuffling of the
+ * vpshufb based implementations.  The native vgf2p8mulb can't be used for
+ * this as it works in the field of the AES polynomial, not the RAID-6 one.
+ */
+
+#if defined(CONFIG_AS_AVX512) && defined(CONFIG_AS_GFNI)
+
+#include <linux/raid/pq.h>
+#include "x86.h"
+
+static int raid6_has_gfni(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX512F) &&
+		boot_cpu_has(X86_FEATURE_AVX512BW) &&
+		boot_cpu_has(X86_FEATURE_GFNI);
+}
+
+/*
+ * The affine matrix of the multiplication by @c: bit i of the product is
+ * the parity of the input masked with byte 7 - i of the matrix.
+ */
+static u64 raid6_gfni_matrix(u8 c)
+{
+	u64 matrix = 0;
+	int i, j;
+
+	for (i = 0; i < 8; i++) {
+		u8 row = 0;
+
+		for (j = 0; j < 8; j++)
+			if (raid6_gfmul[c][1 << j] & (1 << i))
+				row |= 1 << j;
+		matrix |= (u64)row << (8 * (7 - i));
+	}
+
+	return matrix;
+}
+
+static void raid6_2data_recov_gfni(int disks, size_t bytes, int faila,
+				   int failb, void **ptrs)
+{
+	u8 *p, *q, *dp, *dq;
+	u64 pbmat;		/* P multiplier matrix for B data */
+	u64 qmat;		/* Q multiplier matrix (for both) */
+
+	p = (u8 *)ptrs[disks-2];
+	q = (u8 *)ptrs[disks-1];
+
+	/*
+	 * Compute syndrome with zero for the missing data pages
+	 * Use the dead data pages as temporary storage for
+	 * delta p and delta q
+	 */
+
+	dp = (u8 *)ptrs[faila];
+	ptrs[faila] = (void *)raid6_empty_zero_page;
+	ptrs[disks-2] = dp;
+	dq = (u8 *)ptrs[failb];
+	ptrs[failb] = (void *)raid6_empty_zero_page;
+	ptrs[disks-1] = dq;
+
+	raid6_call.gen_syndrome(disks, bytes, ptrs);
+
+	/* Restore pointer table */
+	ptrs[faila]   = dp;
+	ptrs[failb]   = dq;
+	ptrs[disks-2] = p;
+	ptrs[disks-1] = q;
+
+	/* Now, build the proper matrices */
+	pbmat = raid6_gfni_matrix(raid6_gfexi[failb-faila]);
+	qmat  = raid6_gfni_matrix(raid6_gfinv[raid6_gfexp[faila] ^
+				  raid6_gfexp[failb]]);
+
+	kernel_fpu_begin();
+
+	asm volatile("vpbroadcastq %0, %%zmm6\n\t"
+		     "vpbroadcastq %1, %%zmm7"
+		     :
+		     : "m" (qmat), "m" (pbmat));
+
+	while (bytes) {
+		asm volatile("vmovdqa64 %0, %%zmm1\n\t"
+			     "vmovdqa64 %1, %%zmm0\n\t"
+			     "vpxorq %2, %%zmm1, %%zmm1\n\t"
+			     "vpxorq %3, %%zmm0, %%zmm0"
+			     :
+			     : "m" (*q), "m" (*p), "m" (*dq), "m" (*dp));
+
+		/* 1 = dq ^ q;  0 = px = dp ^ p */
+
+		asm volatile("vgf2p8affineqb $0, %%zmm6, %%zmm1, %%zmm1\n\t"
+			     "vgf2p8affineqb $0, %%zmm7, %%zmm0, %%zmm2\n\t"
+			     "vpxorq %%zmm2, %%zmm1, %%zmm1\n\t"
+			     "vpxorq %%zmm1, %%zmm0, %%zmm0"
+			     :
+			     : );
+
+		/* 1 = db = qmul[dq ^ q] ^ pbmul[px];  0 = da = db ^ px */
+
+		asm volatile("vmovdqa64 %%zmm1, %0\n\t"
+			     "vmovdqa64 %%zmm0, %1"
+			     :
+			     : "m" (dq[0]), "m" (dp[0]));
+
+		bytes -= 64;
+		p += 64;
+		q += 64;
+		dp += 64;
+		dq += 64;
+	}
+
+	kernel_fpu_end();
+}
+
+static void raid6_datap_recov_gfni(int disks, size_t bytes, int faila,
+				   void **ptrs)
+{
+	u8 *p, *q, *dq;
+	u64 qmat;		/* Q multiplier matrix */
+
+	p = (u8 *)ptrs[disks-2];
+	q = (u8 *)ptrs[disks-1];
+
+	/*
+	 * Compute syndrome with zero for the missing data page
+	 * Use the dead data page as temporary storage for delta q
+	 */
+
+	dq = (u8 *)ptrs[faila];
+	ptrs[faila] = (void *)raid6_empty_zero_page;
+	ptrs[disks-1] = dq;
+
+	raid6_call.gen_syndrome(disks, bytes, ptrs);
+
+	/* Restore pointer table */
+	ptrs[faila]   = dq;
+	ptrs[disks-1] = q;
+
+	/* Now, build the proper matrix */
+	qmat = raid6_gfni_matrix(raid6_gfinv[raid6_gfexp[faila]]);
+
+	kernel_fpu_begin();
+
+	asm volatile("vpbroadcastq %0, %%zmm6" : : "m" (qmat));
+
+	while (bytes) {
+		asm volatile("vmovdqa64 %0, %%zmm3\n\t"
+			     "vpxorq %1, %%zmm3, %%zmm3\n\t"
+			     "vgf2p8affineqb $0, %%zmm6, %%zmm3, %%zmm1\n\t"
+			     "vpxorq %2, %%zmm1, %%zmm2"
+			     :
+			     : "m" (dq[0]), "m" (q[0]), "m" (p[0]));
+
+		/* 1 = qmul[q ^ dq];  2 = p ^ qmul[q ^ dq] */
+
+		asm volatile("vmovdqa64 %%zmm1, %0\n\t"
+			     "vmovdqa64 %%zmm2, %1"
+			     :
+			     : "m" (dq[0]), "m" (p[0]));
+
+		bytes -= 64;
+		p += 64;
+		q += 64;
+		dq += 64;
+	}
+
+	kernel_fpu_end();
+}
+
+const struct raid6_recov_calls raid6_recov_gfni = {
+	.data2 = raid6_2data_recov_gfni,
+	.datap = raid6_datap_recov_gfni,
+	.valid = raid6_has_gfni,
+	.name = "gfni",
+	.priority = 4,
+};
+
+#endif
@@ -10,8 +10,12 @@
  */
 
 #include <linux/kernel.h>
+#include <linux/local_lock.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
 #include <linux/string.h>
+#include <linux/vmalloc.h>
 #include <linux/zstd.h>
 
 #include "common/zstd_deps.h"
@@ -59,6 +63,110 @@ size_t zstd_decompress_dctx(zstd_dctx *dctx, void *dst, size_t dst_capacity,
 }
 EXPORT_SYMBOL(zstd_decompress_dctx);
 
+size_t zstd_ddict_workspace_bound(size_t dict_size)
+{
+	return ZSTD_estimateDDictSize(dict_size, ZSTD_dlm_byRef);
+}
+EXPORT_SYMBOL(zstd_ddict_workspace_bound);
+
+const zstd_ddict *zstd_init_ddict(void *workspace, size_t workspace_size,
+	const void *dict, size_t dict_size)
+{
+	if (workspace == NULL)
+		return NULL;
+	return ZSTD_initStaticDDict(workspace, workspace_size, dict, dict_size,
+				    ZSTD_dlm_byRef, ZSTD_dct_auto);
+}
+EXPORT_SYMBOL(zstd_init_ddict);
+
+size_t zstd_decompress_using_ddict(zstd_dctx *dctx, void *dst,
+	size_t dst_capacity, const void *src, size_t src_size,
+	const zstd_ddict *ddict)
+{
+	return ZSTD_decompress_usingDDict(dctx, dst, dst_capacity,
+					  src, src_size, ddict);
+}
+EXPORT_SYMBOL(zstd_decompress_using_ddict);
+
+/* Shared per-CPU single-pass decompression contexts. */
+
+struct zstd_percpu_dctx {
+	local_lock_t lock;
+	void *workspace;
+	zstd_dctx *dctx;
+};
+
+static DEFINE_PER_CPU(struct zstd_percpu_dctx, zstd_percpu_dctxs) = {
+	.lock = INIT_LOCAL_LOCK(lock),
+};
+static DEFINE_MUTEX(zstd_percpu_mutex);
+static unsigned int zstd_percpu_users;
+
+static void zstd_percpu_dctx_free(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct zstd_percpu_dctx *p = per_cpu_ptr(&zstd_percpu_dctxs, cpu);
+
+		vfree(p->workspace);
+		p->workspace = NULL;
+		p->dctx = NULL;
+	}
+}
+
+int zstd_percpu_dctx_get(void)
+{
+	size_t size = zstd_dctx_workspace_bound();
+	int cpu, ret = 0;
+
+	mutex_lock(&zstd_percpu_mutex);
+	if (zstd_percpu_users++)
+		goto out;
+
+	for_each_possible_cpu(cpu) {
+		struct zstd_percpu_dctx *p = per_cpu_ptr(&zstd_percpu_dctxs, cpu);
+
+		p->workspace = vmalloc_node(size, cpu_to_node(cpu));
+		p->dctx = zstd_init_dctx(p->workspace, size);
+		if (!p->dctx) {
+			zstd_percpu_dctx_free();
+			zstd_percpu_users--;
+			ret = -ENOMEM;
+			break;
+		}
+	}
+out:
+	mutex_unlock(&zstd_percpu_mutex);
+	return ret;
+}
+EXPORT_SYMBOL(zstd_percpu_dctx_get);
+
+void zstd_percpu_dctx_put(void)
+{
+	mutex_lock(&zstd_percpu_mutex);
+	if (!--zstd_percpu_users)
+		zstd_percpu_dctx_free();
+	mutex_unlock(&zstd_percpu_mutex);
+}
+EXPORT_SYMBOL(zstd_percpu_dctx_put);
+
+size_t zstd_decompress_percpu(void *dst, size_t dst_capacity,
+	const void *src, size_t src_size, const zstd_ddict *ddict)
+{
+	struct zstd_percpu_dctx *p;
+	size_t ret;
+
+	local_lock(&zstd_percpu_dctxs.lock);
+	p = this_cpu_ptr(&zstd_percpu_dctxs);
+	ret = ZSTD_decompress_usingDDict(p->dctx, dst, dst_capacity,
+					 src, src_size, ddict);
+	local_unlock(&zstd_percpu_dctxs.lock);
+
+	return ret;
+}
+EXPORT_SYMBOL(zstd_decompress_percpu);
+
 size_t zstd_dstream_workspace_bound(size_t max_window_size)
 {
 	return ZSTD_estimateDStreamSize(max_window_size);
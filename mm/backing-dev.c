@@ -329,6 +329,33 @@ static ssize_t strict_limit_show(struct device *dev,
 }
 static DEVICE_ATTR_RW(strict_limit);
 
+static ssize_t dirty_latency_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int msecs;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &msecs);
+	if (ret < 0)
+		return ret;
+
+	ret = bdi_set_dirty_latency(bdi, msecs);
+	if (!ret)
+		ret = count;
+
+	return ret;
+}
+
+static ssize_t dirty_latency_ms_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(bdi->dirty_latency_ms));
+}
+static DEVICE_ATTR_RW(dirty_latency_ms);
+
 static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
 	&dev_attr_min_ratio.attr,
@@ -339,6 +366,7 @@ static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_max_bytes.attr,
 	&dev_attr_stable_pages_required.attr,
 	&dev_attr_strict_limit.attr,
+	&dev_attr_dirty_latency_ms.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(bdi_dev);
@@ -1432,6 +1432,30 @@ static bool suitable_migration_source(struct compact_control *cc,
 		return block_mt == cc->migratetype;
 }
 
+/*
+ * Use the free page counts of the buddy allocator to skip pageblocks not
+ * worth scanning as migration source: a completely free block has nothing
+ * to migrate, and async direct compaction for a pageblock sized allocation
+ * has to empty the whole block, so it only goes for mostly free ones.
+ */
+static bool suitable_migration_source_free(struct compact_control *cc,
+					   unsigned long pfn)
+{
+	long nr_free = pageblock_free_pages(cc->zone, pfn);
+
+	if (nr_free < 0)
+		return true;
+
+	if (nr_free >= pageblock_nr_pages)
+		return false;
+
+	if (cc->mode == MIGRATE_ASYNC && cc->direct_compaction &&
+	    cc->order >= pageblock_order)
+		return nr_free >= pageblock_nr_pages / 2;
+
+	return true;
+}
+
 /* Returns true if the page is within a block suitable for migration to */
 static bool suitable_migration_target(struct compact_control *cc,
 							struct page *page)
@@ -1802,6 +1826,10 @@ static void isolate_freepages(struct compact_control *cc)
 		if (!isolation_suitable(cc, page))
 			continue;
 
+		/* Nothing to isolate, don't scan the whole block to find out */
+		if (!pageblock_free_pages(cc->zone, block_start_pfn))
+			continue;
+
 		/* Found a block suitable for isolating free pages from. */
 		nr_isolated = isolate_freepages_block(cc, &isolate_start_pfn,
 					block_end_pfn, cc->freepages, stride, false);
@@ -2182,6 +2210,9 @@ static isolate_migrate_t isolate_migratepages(struct compact_control *cc)
 			continue;
 		}
 
+		if (!suitable_migration_source_free(cc, block_start_pfn))
+			continue;
+
 		/* Perform the isolation */
 		if (isolate_migratepages_block(cc, low_pfn, block_end_pfn,
 						isolate_mode))
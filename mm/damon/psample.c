@@ -0,0 +1,268 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DAMON Primitives for The Physical Address Space, fed by hardware access
+ * samples
+ *
+ * Instead of clearing and checking Accessed bits, this operations set opens
+ * a precise memory access sampling perf event on each online CPU and treats
+ * every region that received a sample within a sampling interval as
+ * accessed.  No page table is walked or modified, so the cost of monitoring
+ * depends on the sampling rate, not on the size of the monitored memory.
+ *
+ * The event is hardware specific and given by the parameters below, which
+ * have the same meaning as in &struct perf_event_attr.  For example, Intel
+ * PEBS load latency sampling is ``perf_type=4 perf_config=0x1cd
+ * perf_config1=3 precise_ip=2``, and AMD IBS op sampling is ``perf_type=``
+ * the type of the ``ibs_op`` PMU with ``precise_ip=0``.  The event must be
+ * able to provide %PERF_SAMPLE_PHYS_ADDR.
+ */
+
+#define pr_fmt(fmt) "damon-psample: " fmt
+
+#include <linux/module.h>
+#include <linux/perf_event.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+
+#include "ops-common.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "damon_psample."
+
+/* The perf event to sample memory accesses with */
+static unsigned int perf_type __read_mostly = PERF_TYPE_RAW;
+module_param(perf_type, uint, 0600);
+
+static unsigned long long perf_config __read_mostly;
+module_param(perf_config, ullong, 0600);
+
+static unsigned long long perf_config1 __read_mostly;
+module_param(perf_config1, ullong, 0600);
+
+static unsigned int precise_ip __read_mostly = 2;
+module_param(precise_ip, uint, 0600);
+
+/* Number of events between two samples */
+static unsigned long sample_period __read_mostly = 10007;
+module_param(sample_period, ulong, 0600);
+
+/* Samples beyond this number per CPU and sampling interval are dropped */
+#define DAMON_PSAMPLE_BUF_SIZE	256
+
+struct damon_psample_buf {
+	unsigned int nr;
+	unsigned long addrs[DAMON_PSAMPLE_BUF_SIZE];
+};
+
+/* Sampling state of a monitoring context, &damon_ctx.ops_private */
+struct damon_psample_ctx {
+	struct damon_psample_buf __percpu *bufs;
+	struct perf_event * __percpu *events;
+	/* The samples collected from all CPUs */
+	unsigned long *addrs;
+};
+
+/*
+ * Called in NMI context.  The buffer has a single writer, its CPU;
+ * damon_psample_drain() resets it from another CPU, in which case the
+ * sample is simply dropped.
+ */
+static void damon_psample_overflow(struct perf_event *event,
+		struct perf_sample_data *data, struct pt_regs *regs)
+{
+	struct damon_psample_ctx *pctx = event->overflow_handler_context;
+	struct damon_psample_buf *buf = this_cpu_ptr(pctx->bufs);
+	unsigned int nr;
+
+	perf_prepare_sample(data, event, regs);
+	if (!(data->sample_flags & PERF_SAMPLE_PHYS_ADDR) || !data->phys_addr)
+		return;
+
+	nr = READ_ONCE(buf->nr);
+	if (nr >= DAMON_PSAMPLE_BUF_SIZE)
+		return;
+
+	buf->addrs[nr] = data->phys_addr;
+	cmpxchg(&buf->nr, nr, nr + 1);
+}
+
+static unsigned int damon_psample_drain(struct damon_psample_ctx *pctx)
+{
+	unsigned long *addrs = pctx->addrs;
+	unsigned int total = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct damon_psample_buf *buf = per_cpu_ptr(pctx->bufs, cpu);
+		unsigned int nr;
+
+		do {
+			nr = READ_ONCE(buf->nr);
+			memcpy(addrs + total, buf->addrs, nr * sizeof(*addrs));
+		} while (cmpxchg(&buf->nr, nr, 0) != nr);
+
+		total += nr;
+	}
+
+	return total;
+}
+
+static void damon_psample_free(struct damon_psample_ctx *pctx)
+{
+	int cpu;
+
+	if (pctx->events) {
+		for_each_possible_cpu(cpu) {
+			struct perf_event *event = *per_cpu_ptr(pctx->events,
+					cpu);
+
+			if (event)
+				perf_event_release_kernel(event);
+		}
+		free_percpu(pctx->events);
+	}
+	free_percpu(pctx->bufs);
+	kvfree(pctx->addrs);
+	kfree(pctx);
+}
+
+static void damon_psample_init(struct damon_ctx *ctx)
+{
+	struct perf_event_attr attr = {
+		.type = perf_type,
+		.size = sizeof(attr),
+		.config = perf_config,
+		.config1 = perf_config1,
+		.sample_period = sample_period,
+		.sample_type = PERF_SAMPLE_ADDR | PERF_SAMPLE_PHYS_ADDR,
+		.precise_ip = precise_ip,
+		.exclude_hv = 1,
+	};
+	struct damon_psample_ctx *pctx;
+	int cpu, nr_events = 0;
+
+	pctx = kzalloc(sizeof(*pctx), GFP_KERNEL);
+	if (!pctx)
+		return;
+
+	pctx->bufs = alloc_percpu(struct damon_psample_buf);
+	pctx->events = alloc_percpu(struct perf_event *);
+	pctx->addrs = kvmalloc_array(num_possible_cpus() *
+			DAMON_PSAMPLE_BUF_SIZE, sizeof(*pctx->addrs),
+			GFP_KERNEL);
+	if (!pctx->bufs || !pctx->events || !pctx->addrs)
+		goto fail;
+
+	cpus_read_lock();
+	for_each_online_cpu(cpu) {
+		struct perf_event *event;
+
+		event = perf_event_create_kernel_counter(&attr, cpu, NULL,
+				damon_psample_overflow, pctx);
+		if (IS_ERR(event)) {
+			pr_warn_once("cannot create sampling event (%ld)\n",
+					PTR_ERR(event));
+			continue;
+		}
+		*per_cpu_ptr(pctx->events, cpu) = event;
+		nr_events++;
+	}
+	cpus_read_unlock();
+
+	if (nr_events) {
+		ctx->ops_private = pctx;
+		return;
+	}
+fail:
+	damon_psample_free(pctx);
+}
+
+/*
+ * Called when kdamond terminates and again from damon_destroy_ctx(), which
+ * leaves destroying the targets to us when @cleanup is set.
+ */
+static void damon_psample_cleanup(struct damon_ctx *ctx)
+{
+	struct damon_target *t, *next_t;
+
+	if (ctx->ops_private) {
+		damon_psample_free(ctx->ops_private);
+		ctx->ops_private = NULL;
+	}
+
+	damon_for_each_target_safe(t, next_t, ctx)
+		damon_destroy_target(t);
+}
+
+static void damon_psample_prepare_access_checks(struct damon_ctx *ctx)
+{
+	struct damon_psample_ctx *pctx = ctx->ops_private;
+
+	/* Discard samples that were taken before this sampling interval */
+	if (pctx)
+		damon_psample_drain(pctx);
+}
+
+static int damon_psample_cmp(const void *a, const void *b)
+{
+	unsigned long l = *(const unsigned long *)a;
+	unsigned long r = *(const unsigned long *)b;
+
+	return l < r ? -1 : l > r;
+}
+
+static unsigned int damon_psample_check_accesses(struct damon_ctx *ctx)
+{
+	struct damon_psample_ctx *pctx = ctx->ops_private;
+	unsigned int max_nr_accesses = 0;
+	unsigned long *addrs = NULL;
+	struct damon_target *t;
+	struct damon_region *r;
+	unsigned int nr = 0;
+
+	if (pctx) {
+		addrs = pctx->addrs;
+		nr = damon_psample_drain(pctx);
+		sort(addrs, nr, sizeof(*addrs), damon_psample_cmp, NULL);
+	}
+
+	damon_for_each_target(t, ctx) {
+		unsigned int i = 0;
+
+		/* Both the regions and the samples are sorted by address */
+		damon_for_each_region(r, t) {
+			bool accessed;
+
+			while (i < nr && addrs[i] < r->ar.start)
+				i++;
+			accessed = i < nr && addrs[i] < r->ar.end;
+
+			damon_update_region_access_rate(r, accessed, &ctx->attrs);
+			max_nr_accesses = max(r->nr_accesses, max_nr_accesses);
+		}
+	}
+
+	return max_nr_accesses;
+}
+
+static int __init damon_psample_initcall(void)
+{
+	struct damon_operations ops = {
+		.id = DAMON_OPS_PSAMPLE,
+		.init = damon_psample_init,
+		.update = NULL,
+		.prepare_access_checks = damon_psample_prepare_access_checks,
+		.check_accesses = damon_psample_check_accesses,
+		.reset_aggregated = NULL,
+		.target_valid = NULL,
+		.cleanup = damon_psample_cleanup,
+		.apply_scheme = damon_pa_apply_scheme,
+		.get_scheme_score = damon_pa_scheme_score,
+	};
+
+	return damon_register_ops(&ops);
+};
+
+subsys_initcall(damon_psample_initcall);
@@ -27,6 +27,7 @@
 #include <linux/pagemap.h>
 #include <linux/file.h>
 #include <linux/uio.h>
+#include <linux/iov_iter.h>
 #include <linux/error-injection.h>
 #include <linux/hash.h>
 #include <linux/writeback.h>
@@ -2469,6 +2470,25 @@ static int filemap_create_folio(struct file *file,
 	return error;
 }
 
+/*
+ * Readahead is disabled or did not bring in anything.  Rather than
+ * instantiating and reading the missing folios of a multi-page read one by
+ * one, add the range in one pass under a single invalidate_lock hold and
+ * submit it with one ->readahead call.  A private readahead state is used,
+ * so this neither sets up a window nor reads beyond what was asked for.
+ */
+static void filemap_create_folios(struct file *file,
+		struct address_space *mapping, pgoff_t index,
+		pgoff_t last_index)
+{
+	struct file_ra_state ra = { };
+	DEFINE_READAHEAD(ractl, file, &ra, mapping, index);
+	unsigned long max_pages = max_t(unsigned long,
+			inode_to_bdi(mapping->host)->io_pages, PAGEVEC_SIZE);
+
+	page_cache_ra_unbounded(&ractl, min(last_index - index, max_pages), 0);
+}
+
 static int filemap_readahead(struct kiocb *iocb, struct file *file,
 		struct address_space *mapping, struct folio *folio,
 		pgoff_t last_index)
@@ -2509,6 +2529,13 @@ static int filemap_get_pages(struct kiocb *iocb, size_t count,
 	if (!folio_batch_count(fbatch)) {
 		if (iocb->ki_flags & (IOCB_NOWAIT | IOCB_WAITQ))
 			return -EAGAIN;
+		if (last_index - index > 1) {
+			filemap_create_folios(filp, mapping, index, last_index);
+			filemap_get_read_batch(mapping, index, last_index - 1,
+					fbatch);
+			if (folio_batch_count(fbatch))
+				goto got_batch;
+		}
 		err = filemap_create_folio(filp, mapping,
 				iocb->ki_pos >> PAGE_SHIFT, fbatch);
 		if (err == AOP_TRUNCATED_PAGE)
@@ -2516,6 +2543,7 @@ static int filemap_get_pages(struct kiocb *iocb, size_t count,
 		return err;
 	}
 
+got_batch:
 	folio = fbatch->folios[folio_batch_count(fbatch) - 1];
 	if (folio_test_readahead(folio)) {
 		err = filemap_readahead(iocb, filp, mapping, folio, last_index);
@@ -3934,12 +3962,56 @@ generic_file_direct_write(struct kiocb *iocb, struct iov_iter *from)
 }
 EXPORT_SYMBOL(generic_file_direct_write);
 
+/*
+ * Writes of at least this size to files marked POSIX_FADV_NOREUSE are copied
+ * into the page cache with non-temporal stores. The CPU is not going to read
+ * the data again soon, writeback hands it to the device by DMA, so pulling
+ * the destination pages into the cache only evicts data that is being used.
+ */
+#define FILEMAP_NOCACHE_WRITE_MIN	SZ_256K
+
+static size_t filemap_copy_from_user_nocache(void __user *iter_from,
+		size_t progress, size_t len, void *to, void *priv2)
+{
+	return __copy_from_user_inatomic_nocache(to + progress, iter_from, len);
+}
+
+static size_t filemap_copy_from_kernel(void *iter_from, size_t progress,
+		size_t len, void *to, void *priv2)
+{
+	memcpy(to + progress, iter_from, len);
+	return 0;
+}
+
+static size_t filemap_copy_from_iter_nocache(struct page *page,
+		unsigned long offset, size_t bytes, struct iov_iter *i)
+{
+	char *kaddr = kmap_local_page(page);
+	size_t copied;
+
+	/* Like copy_page_from_iter_atomic(), the page is locked: never fault */
+	pagefault_disable();
+	copied = iterate_and_advance(i, bytes, kaddr + offset,
+				     filemap_copy_from_user_nocache,
+				     filemap_copy_from_kernel);
+	pagefault_enable();
+	kunmap_local(kaddr);
+	return copied;
+}
+
+static bool filemap_write_nocache(struct file *file, struct iov_iter *i)
+{
+	return (file->f_mode & FMODE_NOREUSE) && user_backed_iter(i) &&
+	       iov_iter_count(i) >= FILEMAP_NOCACHE_WRITE_MIN;
+}
+
 ssize_t generic_perform_write(struct kiocb *iocb, struct iov_iter *i)
 {
 	struct file *file = iocb->ki_filp;
 	loff_t pos = iocb->ki_pos;
 	struct address_space *mapping = file->f_mapping;
 	const struct address_space_operations *a_ops = mapping->a_ops;
+	bool nocache = filemap_write_nocache(file, i);
 	long status = 0;
 	ssize_t written = 0;
 
@@ -3979,7 +4051,12 @@ ssize_t generic_perform_write(struct kiocb *iocb, struct iov_iter *i)
 		if (mapping_writably_mapped(mapping))
 			flush_dcache_page(page);
 
-		copied = copy_page_from_iter_atomic(page, offset, bytes, i);
+		if (nocache)
+			copied = filemap_copy_from_iter_nocache(page, offset,
+								bytes, i);
+		else
+			copied = copy_page_from_iter_atomic(page, offset,
+							    bytes, i);
 		flush_dcache_page(page);
 
 		status = a_ops->write_end(file, mapping, pos, bytes, copied,
@@ -641,6 +641,32 @@ void init_cma_reserved_pageblock(struct page *page);
 
 #endif /* CONFIG_COMPACTION || CONFIG_CMA */
 
+#ifdef CONFIG_COMPACTION
+/*
+ * Number of free pages in the buddy allocator within the pageblock of @pfn,
+ * or -1 when not known. Read without zone->lock, so only a hint.
+ */
+static inline long pageblock_free_pages(struct zone *zone, unsigned long pfn)
+{
+	unsigned int *pageblock_free = smp_load_acquire(&zone->pageblock_free);
+	unsigned long idx;
+
+	if (!pageblock_free)
+		return -1;
+
+	idx = (pfn - zone->pageblock_free_base) >> pageblock_order;
+	if (idx >= zone->pageblock_free_nr)
+		return -1;
+
+	return READ_ONCE(pageblock_free[idx]);
+}
+#else
+static inline long pageblock_free_pages(struct zone *zone, unsigned long pfn)
+{
+	return -1;
+}
+#endif
+
 int find_suitable_fallback(struct free_area *area, unsigned int order,
 			int migratetype, bool only_stealable, bool *can_steal);
 
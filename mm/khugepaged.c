@@ -76,6 +76,8 @@ static unsigned int khugepaged_scan_sleep_millisecs __read_mostly = 10000;
 /* during fragmentation poll the hugepage allocator once every minute */
 static unsigned int khugepaged_alloc_sleep_millisecs __read_mostly = 60000;
 static unsigned long khugepaged_sleep_expire;
+/* number of boosted mm_slots not yet fully scanned */
+static unsigned int khugepaged_nr_boosted;
 static DEFINE_SPINLOCK(khugepaged_mm_lock);
 static DECLARE_WAIT_QUEUE_HEAD(khugepaged_wait);
 /*
@@ -107,9 +109,13 @@ struct collapse_control {
 /**
  * struct khugepaged_mm_slot - khugepaged information per mm that is being scanned
  * @slot: hash lookup from mm to mm_slot
+ * @boosted: queued to be scanned next, see __khugepaged_boost()
+ * @last_boost: jiffies of the last boost
  */
 struct khugepaged_mm_slot {
 	struct mm_slot slot;
+	bool boosted;
+	unsigned long last_boost;
 };
 
 /**
@@ -368,6 +374,7 @@ int hugepage_madvise(struct vm_area_struct *vma,
 		 * may not happen any time soon.
 		 */
 		khugepaged_enter_vma(vma, *vm_flags);
+		khugepaged_boost(vma->vm_mm);
 		break;
 	case MADV_NOHUGEPAGE:
 		*vm_flags &= ~VM_HUGEPAGE;
@@ -448,6 +455,53 @@ void __khugepaged_enter(struct mm_struct *mm)
 		wake_up_interruptible(&khugepaged_wait);
 }
 
+static void khugepaged_unboost(struct khugepaged_mm_slot *mm_slot)
+{
+	lockdep_assert_held(&khugepaged_mm_lock);
+
+	if (mm_slot->boosted) {
+		mm_slot->boosted = false;
+		WRITE_ONCE(khugepaged_nr_boosted, khugepaged_nr_boosted - 1);
+	}
+}
+
+/*
+ * The mm had THP faults fall back to small pages, or asked for THPs with
+ * MADV_HUGEPAGE: move it right behind the scanning cursor, so it is scanned
+ * next, and keep khugepaged scanning without its sleeps between passes until
+ * the whole mm was visited. This lets a starting service get its huge pages
+ * without waiting for the scan to go through all the idle processes first.
+ * An mm is boosted at most once per scan_sleep_millisecs.
+ */
+void __khugepaged_boost(struct mm_struct *mm)
+{
+	struct khugepaged_mm_slot *mm_slot;
+	struct mm_slot *slot;
+	bool wakeup = false;
+
+	spin_lock(&khugepaged_mm_lock);
+	slot = mm_slot_lookup(mm_slots_hash, mm);
+	mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
+	if (mm_slot && !mm_slot->boosted && khugepaged_scan.mm_slot != mm_slot &&
+	    (!mm_slot->last_boost ||
+	     time_after(jiffies, mm_slot->last_boost +
+			msecs_to_jiffies(khugepaged_scan_sleep_millisecs)))) {
+		if (khugepaged_scan.mm_slot)
+			list_move(&slot->mm_node,
+				  &khugepaged_scan.mm_slot->slot.mm_node);
+		else
+			list_move(&slot->mm_node, &khugepaged_scan.mm_head);
+		mm_slot->boosted = true;
+		mm_slot->last_boost = jiffies;
+		WRITE_ONCE(khugepaged_nr_boosted, khugepaged_nr_boosted + 1);
+		wakeup = true;
+	}
+	spin_unlock(&khugepaged_mm_lock);
+
+	if (wakeup)
+		wake_up_interruptible(&khugepaged_wait);
+}
+
 void khugepaged_enter_vma(struct vm_area_struct *vma,
 			  unsigned long vm_flags)
 {
@@ -469,6 +523,7 @@ void __khugepaged_exit(struct mm_struct *mm)
 	slot = mm_slot_lookup(mm_slots_hash, mm);
 	mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
 	if (mm_slot && khugepaged_scan.mm_slot != mm_slot) {
+		khugepaged_unboost(mm_slot);
 		hash_del(&slot->hash);
 		list_del(&slot->mm_node);
 		free = 1;
@@ -2460,6 +2515,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 		 * khugepaged runs here, khugepaged_exit will find
 		 * mm_slot not pointing to the exiting mm.
 		 */
+		khugepaged_unboost(mm_slot);
 		if (slot->mm_node.next != &khugepaged_scan.mm_head) {
 			slot = list_entry(slot->mm_node.next,
 					  struct mm_slot, mm_node);
@@ -2533,7 +2589,7 @@ static void khugepaged_do_scan(struct collapse_control *cc)
 
 static bool khugepaged_should_wakeup(void)
 {
-	return kthread_should_stop() ||
+	return kthread_should_stop() || READ_ONCE(khugepaged_nr_boosted) ||
 	       time_after_eq(jiffies, khugepaged_sleep_expire);
 }
 
@@ -2543,6 +2599,9 @@ static void khugepaged_wait_work(void)
 		const unsigned long scan_sleep_jiffies =
 			msecs_to_jiffies(khugepaged_scan_sleep_millisecs);
 
+		if (READ_ONCE(khugepaged_nr_boosted))
+			return;
+
 		if (!scan_sleep_jiffies)
 			return;
 
@@ -2572,8 +2631,10 @@ static int khugepaged(void *none)
 	spin_lock(&khugepaged_mm_lock);
 	mm_slot = khugepaged_scan.mm_slot;
 	khugepaged_scan.mm_slot = NULL;
-	if (mm_slot)
+	if (mm_slot) {
+		khugepaged_unboost(mm_slot);
 		collect_mm_slot(mm_slot);
+	}
 	spin_unlock(&khugepaged_mm_lock);
 	return 0;
 }
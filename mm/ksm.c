@@ -180,6 +180,7 @@ struct ksm_stable_node {
 	 */
 #define STABLE_NODE_CHAIN -1024
 	int rmap_hlist_len;
+	u32 checksum;	/* of the KSM page, for the stable filter */
 #ifdef CONFIG_NUMA
 	int nid;
 #endif
@@ -301,6 +302,17 @@ atomic_long_t ksm_zero_pages = ATOMIC_LONG_INIT(0);
 /* The number of pages that have been skipped due to "smart scanning" */
 static unsigned long ksm_pages_skipped;
 
+/*
+ * Counting filter over the checksums of all KSM pages. A page whose
+ * checksum has no entry here cannot be in the stable tree, so the tree
+ * walk and its memcmps can be skipped. Saturated counters stick.
+ */
+static u8 *ksm_stable_filter __read_mostly;
+static unsigned long ksm_stable_filter_mask __read_mostly;
+
+/* The number of stable tree searches avoided by the stable filter */
+static unsigned long ksm_stable_filter_skipped;
+
 /* Don't scan more than max pages per batch. */
 static unsigned long ksm_advisor_max_pages_to_scan = 30000;
 
@@ -592,10 +604,44 @@ static inline struct ksm_stable_node *alloc_stable_node(void)
 	return kmem_cache_alloc(stable_node_cache, GFP_KERNEL | __GFP_HIGH);
 }
 
+static void stable_filter_add(u32 checksum)
+{
+	u8 *cnt;
+
+	if (!ksm_stable_filter)
+		return;
+
+	cnt = &ksm_stable_filter[checksum & ksm_stable_filter_mask];
+	if (*cnt != U8_MAX)
+		WRITE_ONCE(*cnt, *cnt + 1);
+}
+
+static void stable_filter_del(u32 checksum)
+{
+	u8 *cnt;
+
+	if (!ksm_stable_filter)
+		return;
+
+	cnt = &ksm_stable_filter[checksum & ksm_stable_filter_mask];
+	if (*cnt && *cnt != U8_MAX)
+		WRITE_ONCE(*cnt, *cnt - 1);
+}
+
+static bool stable_filter_may_contain(u32 checksum)
+{
+	if (!ksm_stable_filter)
+		return true;
+
+	return READ_ONCE(ksm_stable_filter[checksum & ksm_stable_filter_mask]);
+}
+
 static inline void free_stable_node(struct ksm_stable_node *stable_node)
 {
 	VM_BUG_ON(stable_node->rmap_hlist_len &&
 		  !is_stable_node_chain(stable_node));
+	if (!is_stable_node_chain(stable_node))
+		stable_filter_del(stable_node->checksum);
 	kmem_cache_free(stable_node_cache, stable_node);
 }
 
@@ -2148,6 +2194,8 @@ static struct ksm_stable_node *stable_tree_insert(struct page *kpage)
 	stable_node_dup->kpfn = kpfn;
 	set_page_stable_node(kpage, stable_node_dup);
 	stable_node_dup->rmap_hlist_len = 0;
+	stable_node_dup->checksum = calc_checksum(kpage);
+	stable_filter_add(stable_node_dup->checksum);
 	DO_NUMA(stable_node_dup->nid = nid);
 	if (!need_chain) {
 		rb_link_node(&stable_node_dup->node, parent, new);
@@ -2305,6 +2353,7 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	struct ksm_stable_node *stable_node;
 	struct page *kpage;
 	unsigned int checksum;
+	bool checksum_valid = false;
 	int err;
 	bool max_page_sharing_bypass = false;
 
@@ -2328,8 +2377,20 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 			max_page_sharing_bypass = true;
 	}
 
-	/* We first start with searching the page inside the stable tree */
-	kpage = stable_tree_search(page);
+	/*
+	 * We first start with searching the page inside the stable tree,
+	 * unless its checksum rules out that an identical KSM page exists.
+	 */
+	if (!stable_node) {
+		checksum = calc_checksum(page);
+		checksum_valid = true;
+	}
+	if (checksum_valid && !stable_filter_may_contain(checksum)) {
+		ksm_stable_filter_skipped++;
+		kpage = NULL;
+	} else {
+		kpage = stable_tree_search(page);
+	}
 	if (kpage == page && rmap_item->head == stable_node) {
 		put_page(kpage);
 		return;
@@ -2362,7 +2423,8 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	 * don't want to insert it in the unstable tree, and we don't want
 	 * to waste our time searching for something identical to it there.
 	 */
-	checksum = calc_checksum(page);
+	if (!checksum_valid)
+		checksum = calc_checksum(page);
 	if (rmap_item->oldchecksum != checksum) {
 		rmap_item->oldchecksum = checksum;
 		return;
@@ -3653,6 +3715,13 @@ static ssize_t pages_skipped_show(struct kobject *kobj,
 }
 KSM_ATTR_RO(pages_skipped);
 
+static ssize_t stable_filter_skipped_show(struct kobject *kobj,
+					  struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%lu\n", ksm_stable_filter_skipped);
+}
+KSM_ATTR_RO(stable_filter_skipped);
+
 static ssize_t ksm_zero_pages_show(struct kobject *kobj,
 				struct kobj_attribute *attr, char *buf)
 {
@@ -3875,6 +3944,7 @@ static struct attribute *ksm_attrs[] = {
 	&pages_unshared_attr.attr,
 	&pages_volatile_attr.attr,
 	&pages_skipped_attr.attr,
+	&stable_filter_skipped_attr.attr,
 	&ksm_zero_pages_attr.attr,
 	&full_scans_attr.attr,
 #ifdef CONFIG_NUMA
@@ -3901,6 +3971,20 @@ static const struct attribute_group ksm_attr_group = {
 };
 #endif /* CONFIG_SYSFS */
 
+/*
+ * Size the stable filter at one counter per 64 pages of memory. It is an
+ * optimization only: without it every page walks the stable tree.
+ */
+static void __init ksm_stable_filter_init(void)
+{
+	unsigned long nr = clamp(totalram_pages() >> 6, 1UL << 12, 1UL << 24);
+
+	nr = roundup_pow_of_two(nr);
+	ksm_stable_filter = kvzalloc(nr, GFP_KERNEL);
+	if (ksm_stable_filter)
+		ksm_stable_filter_mask = nr - 1;
+}
+
 static int __init ksm_init(void)
 {
 	struct task_struct *ksm_thread;
@@ -3915,6 +3999,8 @@ static int __init ksm_init(void)
 	if (err)
 		goto out;
 
+	ksm_stable_filter_init();
+
 	ksm_thread = kthread_run(ksm_scan_thread, NULL, "ksmd");
 	if (IS_ERR(ksm_thread)) {
 		pr_err("ksm: creating kthread failed\n");
@@ -3941,6 +4027,8 @@ static int __init ksm_init(void)
 	return 0;
 
 out_free:
+	kvfree(ksm_stable_filter);
+	ksm_stable_filter = NULL;
 	ksm_slab_free();
 out:
 	return err;
@@ -634,10 +634,12 @@ struct memcg_vmstats_percpu {
 	/* Local (CPU and cgroup) page state & events */
 	long			state[MEMCG_NR_STAT];
 	unsigned long		events[NR_MEMCG_EVENTS];
+	unsigned long		refault_dist[NR_REFAULT_DIST];
 
 	/* Delta calculation for lockless upward propagation */
 	long			state_prev[MEMCG_NR_STAT];
 	unsigned long		events_prev[NR_MEMCG_EVENTS];
+	unsigned long		refault_dist_prev[NR_REFAULT_DIST];
 
 	/* Cgroup1: threshold notifications & softlimit tree updates */
 	unsigned long		nr_page_events;
@@ -657,8 +659,15 @@ struct memcg_vmstats {
 	long			state_pending[MEMCG_NR_STAT];
 	unsigned long		events_pending[NR_MEMCG_EVENTS];
 
+	/* Aggregated (CPU and subtree) memory.refault_distance */
+	unsigned long		refault_dist[NR_REFAULT_DIST];
+	unsigned long		refault_dist_pending[NR_REFAULT_DIST];
+
 	/* Stats updates since the last flush */
 	atomic64_t		stats_updates;
+
+	/* jiffies_64 of the last flush rooted at this memcg */
+	u64			last_flush;
 };
 
 /*
@@ -675,12 +684,19 @@ struct memcg_vmstats {
  *    (MEMCG_CHARGE_BATCH * nr_cpus) update events. Though this optimization
  *    will let stats be out of sync by atmost (MEMCG_CHARGE_BATCH * nr_cpus) but
  *    only for 2 seconds due to (1).
+ *
+ * 3) Optionally skip the synchronous flush altogether if the subtree, or one
+ *    of its ancestors, was flushed less than memory.stat_staleness_ms ago, so
+ *    that frequent readers on hosts with many cgroups are served the last
+ *    flushed state instead of walking the rstat tree.
  */
 static void flush_memcg_stats_dwork(struct work_struct *w);
 static DECLARE_DEFERRABLE_WORK(stats_flush_dwork, flush_memcg_stats_dwork);
 static u64 flush_last_time;
+static unsigned int memcg_stats_staleness_ms __read_mostly;
 
 #define FLUSH_TIME (2UL*HZ)
+#define MEMCG_STATS_STALENESS_MAX_MS 10000
 
 /*
  * Accessors to ensure that preemption is disabled on PREEMPT_RT because it can
@@ -743,6 +759,28 @@ static void do_flush_stats(struct mem_cgroup *memcg)
 		WRITE_ONCE(flush_last_time, jiffies_64);
 
 	cgroup_rstat_flush(memcg->css.cgroup);
+	WRITE_ONCE(memcg->vmstats->last_flush, get_jiffies_64());
+}
+
+/*
+ * A flush of @memcg or any of its ancestors also flushed @memcg; check
+ * whether the most recent one is within the configured staleness tolerance.
+ */
+static bool memcg_vmstats_fresh(struct mem_cgroup *memcg)
+{
+	unsigned int staleness = READ_ONCE(memcg_stats_staleness_ms);
+	u64 cutoff;
+
+	if (!staleness)
+		return false;
+
+	cutoff = get_jiffies_64() - msecs_to_jiffies(staleness);
+	for (; memcg; memcg = parent_mem_cgroup(memcg)) {
+		if (time_after64(READ_ONCE(memcg->vmstats->last_flush), cutoff))
+			return true;
+	}
+
+	return false;
 }
 
 /*
@@ -752,7 +790,8 @@ static void do_flush_stats(struct mem_cgroup *memcg)
  * Flushing is serialized by the underlying global rstat lock. There is also a
  * minimum amount of work to be done even if there are no stat updates to flush.
  * Hence, we only flush the stats if the updates delta exceeds a threshold. This
- * avoids unnecessary work and contention on the underlying lock.
+ * avoids unnecessary work and contention on the underlying lock. The flush is
+ * also skipped if the stats are within the staleness tolerance.
  */
 void mem_cgroup_flush_stats(struct mem_cgroup *memcg)
 {
@@ -762,7 +801,8 @@ void mem_cgroup_flush_stats(struct mem_cgroup *memcg)
 	if (!memcg)
 		memcg = root_mem_cgroup;
 
-	if (memcg_vmstats_needs_flush(memcg->vmstats))
+	if (memcg_vmstats_needs_flush(memcg->vmstats) &&
+	    !memcg_vmstats_fresh(memcg))
 		do_flush_stats(memcg);
 }
 
@@ -2253,10 +2293,19 @@ void folio_memcg_unlock(struct folio *folio)
 	__folio_memcg_unlock(folio_memcg(folio));
 }
 
+/*
+ * Number of memcgs whose charges a cpu can stock at the same time, so that
+ * a cpu interleaving between a few containers does not drain its stock on
+ * every switch.
+ */
+#define NR_MEMCG_STOCK 7
+
 struct memcg_stock_pcp {
 	local_lock_t stock_lock;
-	struct mem_cgroup *cached; /* this never be root cgroup */
-	unsigned int nr_pages;
+	struct mem_cgroup *cached[NR_MEMCG_STOCK]; /* these never be root cgroup */
+	unsigned int nr_pages[NR_MEMCG_STOCK];
+	unsigned int last_used[NR_MEMCG_STOCK]; /* for LRU replacement */
+	unsigned int tick;
 
 #ifdef CONFIG_MEMCG_KMEM
 	struct obj_cgroup *cached_objcg;
@@ -2301,9 +2350,9 @@ static void memcg_account_kmem(struct mem_cgroup *memcg, int nr_pages)
  * @memcg: memcg to consume from.
  * @nr_pages: how many pages to charge.
  *
- * The charges will only happen if @memcg matches the current cpu's memcg
- * stock, and at least @nr_pages are available in that stock.  Failure to
- * service an allocation will refill the stock.
+ * The charges will only happen if @memcg is one of the memcgs stocked on the
+ * current cpu, and at least @nr_pages are available in its stock.  Failure
+ * to service an allocation will refill the stock.
  *
  * returns true if successful, false otherwise.
  */
@@ -2312,6 +2361,7 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	struct memcg_stock_pcp *stock;
 	unsigned long flags;
 	bool ret = false;
+	int i;
 
 	if (nr_pages > MEMCG_CHARGE_BATCH)
 		return ret;
@@ -2319,9 +2369,15 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	local_lock_irqsave(&memcg_stock.stock_lock, flags);
 
 	stock = this_cpu_ptr(&memcg_stock);
-	if (memcg == READ_ONCE(stock->cached) && stock->nr_pages >= nr_pages) {
-		stock->nr_pages -= nr_pages;
-		ret = true;
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		if (memcg != READ_ONCE(stock->cached[i]))
+			continue;
+		if (stock->nr_pages[i] >= nr_pages) {
+			stock->nr_pages[i] -= nr_pages;
+			stock->last_used[i] = ++stock->tick;
+			ret = true;
+		}
+		break;
 	}
 
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
@@ -2330,24 +2386,35 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 }
 
 /*
- * Returns stocks cached in percpu and reset cached information.
+ * Returns the charges stocked for one memcg and resets its slot.
  */
-static void drain_stock(struct memcg_stock_pcp *stock)
+static void drain_stock_slot(struct memcg_stock_pcp *stock, int i)
 {
-	struct mem_cgroup *old = READ_ONCE(stock->cached);
+	struct mem_cgroup *old = READ_ONCE(stock->cached[i]);
 
 	if (!old)
 		return;
 
-	if (stock->nr_pages) {
-		page_counter_uncharge(&old->memory, stock->nr_pages);
+	if (stock->nr_pages[i]) {
+		page_counter_uncharge(&old->memory, stock->nr_pages[i]);
 		if (do_memsw_account())
-			page_counter_uncharge(&old->memsw, stock->nr_pages);
-		stock->nr_pages = 0;
+			page_counter_uncharge(&old->memsw, stock->nr_pages[i]);
+		WRITE_ONCE(stock->nr_pages[i], 0);
 	}
 
 	css_put(&old->css);
-	WRITE_ONCE(stock->cached, NULL);
+	WRITE_ONCE(stock->cached[i], NULL);
+}
+
+/*
+ * Returns stocks cached in percpu and reset cached information.
+ */
+static void drain_stock(struct memcg_stock_pcp *stock)
+{
+	int i;
+
+	for (i = 0; i < NR_MEMCG_STOCK; i++)
+		drain_stock_slot(stock, i);
 }
 
 static void drain_local_stock(struct work_struct *dummy)
@@ -2380,17 +2447,32 @@ static void drain_local_stock(struct work_struct *dummy)
 static void __refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 {
 	struct memcg_stock_pcp *stock;
+	int i, victim = -1;
 
 	stock = this_cpu_ptr(&memcg_stock);
-	if (READ_ONCE(stock->cached) != memcg) { /* reset if necessary */
-		drain_stock(stock);
-		css_get(&memcg->css);
-		WRITE_ONCE(stock->cached, memcg);
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		struct mem_cgroup *cached = READ_ONCE(stock->cached[i]);
+
+		if (cached == memcg)
+			goto found;
+		/* Prefer a free slot, else the least recently used one */
+		if (victim >= 0 && !READ_ONCE(stock->cached[victim]))
+			continue;
+		if (!cached || victim < 0 ||
+		    (int)(stock->last_used[i] - stock->last_used[victim]) < 0)
+			victim = i;
 	}
-	stock->nr_pages += nr_pages;
 
-	if (stock->nr_pages > MEMCG_CHARGE_BATCH)
-		drain_stock(stock);
+	i = victim;
+	drain_stock_slot(stock, i);
+	css_get(&memcg->css);
+	WRITE_ONCE(stock->cached[i], memcg);
+found:
+	WRITE_ONCE(stock->nr_pages[i], stock->nr_pages[i] + nr_pages);
+	stock->last_used[i] = ++stock->tick;
+
+	if (stock->nr_pages[i] > MEMCG_CHARGE_BATCH)
+		drain_stock_slot(stock, i);
 }
 
 static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
@@ -2425,13 +2507,18 @@ static void drain_all_stock(struct mem_cgroup *root_memcg)
 		struct memcg_stock_pcp *stock = &per_cpu(memcg_stock, cpu);
 		struct mem_cgroup *memcg;
 		bool flush = false;
+		int i;
 
 		rcu_read_lock();
-		memcg = READ_ONCE(stock->cached);
-		if (memcg && stock->nr_pages &&
-		    mem_cgroup_is_descendant(memcg, root_memcg))
-			flush = true;
-		else if (obj_stock_flush_required(stock, root_memcg))
+		for (i = 0; i < NR_MEMCG_STOCK; i++) {
+			memcg = READ_ONCE(stock->cached[i]);
+			if (memcg && READ_ONCE(stock->nr_pages[i]) &&
+			    mem_cgroup_is_descendant(memcg, root_memcg)) {
+				flush = true;
+				break;
+			}
+		}
+		if (!flush && obj_stock_flush_required(stock, root_memcg))
 			flush = true;
 		rcu_read_unlock();
 
@@ -5812,6 +5899,27 @@ static void mem_cgroup_css_rstat_flush(struct cgroup_subsys_state *css, int cpu)
 		}
 	}
 
+	for (i = 0; i < NR_REFAULT_DIST; i++) {
+		unsigned long *ppending = parent ?
+			parent->vmstats->refault_dist_pending : NULL;
+
+		delta = memcg->vmstats->refault_dist_pending[i];
+		if (delta)
+			memcg->vmstats->refault_dist_pending[i] = 0;
+
+		v = READ_ONCE(statc->refault_dist[i]);
+		if (v != statc->refault_dist_prev[i]) {
+			delta += v - statc->refault_dist_prev[i];
+			statc->refault_dist_prev[i] = v;
+		}
+
+		if (delta) {
+			memcg->vmstats->refault_dist[i] += delta;
+			if (ppending)
+				ppending[i] += delta;
+		}
+	}
+
 	for_each_node_state(nid, N_MEMORY) {
 		struct mem_cgroup_per_node *pn = memcg->nodeinfo[nid];
 		struct mem_cgroup_per_node *ppn = NULL;
@@ -6884,6 +6992,22 @@ static int memory_events_local_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+static u64 memory_stat_staleness_read(struct cgroup_subsys_state *css,
+				      struct cftype *cft)
+{
+	return READ_ONCE(memcg_stats_staleness_ms);
+}
+
+static int memory_stat_staleness_write(struct cgroup_subsys_state *css,
+				       struct cftype *cft, u64 val)
+{
+	if (val > MEMCG_STATS_STALENESS_MAX_MS)
+		return -EINVAL;
+
+	WRITE_ONCE(memcg_stats_staleness_ms, val);
+	return 0;
+}
+
 static int memory_stat_show(struct seq_file *m, void *v)
 {
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
@@ -6937,6 +7061,92 @@ static int memory_numa_stat_show(struct seq_file *m, void *v)
 }
 #endif
 
+/**
+ * mem_cgroup_record_refault - account a refault distance
+ * @memcg: the memcg the folio was evicted from
+ * @file: whether the folio is file backed
+ * @distance: the refault distance in pages
+ * @nr_pages: the number of pages refaulting
+ *
+ * Bin @distance in memory.refault_distance of @memcg. The count reaches the
+ * ancestors of @memcg with the next rstat flush.
+ */
+void mem_cgroup_record_refault(struct mem_cgroup *memcg, bool file,
+			       unsigned long distance, long nr_pages)
+{
+	int bin = min_t(int, DIV_ROUND_UP(fls_long(distance), 2),
+			NR_REFAULT_DIST_BINS - 1);
+	int i = file * NR_REFAULT_DIST_BINS + bin;
+	unsigned long flags;
+
+	if (mem_cgroup_disabled())
+		return;
+
+	local_irq_save(flags);
+	__this_cpu_add(memcg->vmstats_percpu->refault_dist[i], nr_pages);
+	memcg_rstat_updated(memcg, nr_pages);
+	local_irq_restore(flags);
+}
+
+/*
+ * Refaults by how many pages had been evicted between the eviction and the
+ * refault of the folio, in bins of bytes the memcg would have needed to not
+ * refault: "<4^n pages in bytes>=<refaulted bytes>", the last bin being
+ * everything further.  Only the classic LRU measures refault distances.
+ */
+static int memory_refault_distance_show(struct seq_file *m, void *v)
+{
+	static const char *const types[ANON_AND_FILE] = { "anon", "file" };
+	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
+	unsigned long *dist = memcg->vmstats->refault_dist;
+	int type, bin;
+
+	mem_cgroup_flush_stats(memcg);
+
+	for (type = 0; type < ANON_AND_FILE; type++) {
+		seq_puts(m, types[type]);
+		for (bin = 0; bin < NR_REFAULT_DIST_BINS; bin++) {
+			int i = type * NR_REFAULT_DIST_BINS + bin;
+			u64 bytes = (u64)READ_ONCE(dist[i]) * PAGE_SIZE;
+
+			if (bin < NR_REFAULT_DIST_BINS - 1)
+				seq_printf(m, " %llu=%llu",
+					   (u64)PAGE_SIZE << (2 * bin), bytes);
+			else
+				seq_printf(m, " inf=%llu", bytes);
+		}
+		seq_putc(m, '\n');
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_LRU_GEN
+static int memory_wss_show(struct seq_file *m, void *v)
+{
+	static const char *const bins[NR_WSS_BINS] = { "1s", "10s", "60s", "older" };
+	static const char *const types[ANON_AND_FILE] = { "anon", "file" };
+	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
+	unsigned long wss[ANON_AND_FILE][NR_WSS_BINS];
+	int type, bin;
+
+	if (!lru_gen_enabled())
+		return -EOPNOTSUPP;
+
+	lru_gen_wss(memcg, wss);
+
+	for (type = 0; type < ANON_AND_FILE; type++) {
+		seq_puts(m, types[type]);
+		for (bin = 0; bin < NR_WSS_BINS; bin++)
+			seq_printf(m, " %s=%llu", bins[bin],
+				   (u64)wss[type][bin] * PAGE_SIZE);
+		seq_putc(m, '\n');
+	}
+
+	return 0;
+}
+#endif
+
 static int memory_oom_group_show(struct seq_file *m, void *v)
 {
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
@@ -7062,11 +7272,27 @@ static struct cftype memory_files[] = {
 		.name = "stat",
 		.seq_show = memory_stat_show,
 	},
+	{
+		.name = "stat_staleness_ms",
+		.flags = CFTYPE_ONLY_ON_ROOT,
+		.read_u64 = memory_stat_staleness_read,
+		.write_u64 = memory_stat_staleness_write,
+	},
 #ifdef CONFIG_NUMA
 	{
 		.name = "numa_stat",
 		.seq_show = memory_numa_stat_show,
 	},
+#endif
+	{
+		.name = "refault_distance",
+		.seq_show = memory_refault_distance_show,
+	},
+#ifdef CONFIG_LRU_GEN
+	{
+		.name = "wss",
+		.seq_show = memory_wss_show,
+	},
 #endif
 	{
 		.name = "oom.group",
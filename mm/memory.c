@@ -78,6 +78,7 @@
 #include <linux/ptrace.h>
 #include <linux/vmalloc.h>
 #include <linux/sched/sysctl.h>
+#include <linux/padata.h>
 
 #include <trace/events/kmem.h>
 
@@ -1335,11 +1336,97 @@ vma_needs_copy(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
 	return false;
 }
 
-int
-copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
+static int __copy_page_range(struct vm_area_struct *dst_vma,
+			     struct vm_area_struct *src_vma,
+			     unsigned long addr, unsigned long end)
 {
 	pgd_t *src_pgd, *dst_pgd;
 	unsigned long next;
+
+	dst_pgd = pgd_offset(dst_vma->vm_mm, addr);
+	src_pgd = pgd_offset(src_vma->vm_mm, addr);
+	do {
+		next = pgd_addr_end(addr, end);
+		if (pgd_none_or_clear_bad(src_pgd))
+			continue;
+		if (unlikely(copy_p4d_range(dst_vma, src_vma, dst_pgd, src_pgd,
+					    addr, next))) {
+			untrack_pfn_clear(dst_vma);
+			return -ENOMEM;
+		}
+	} while (dst_pgd++, src_pgd++, addr = next, addr != end);
+
+	return 0;
+}
+
+/*
+ * With PR_SET_FORK_PARALLEL, large anonymous mappings are copied at fork by
+ * several threads, each taking PMD aligned slices of the mapping, so that the
+ * fork latency of a process with a large RSS is divided by the number of
+ * threads. The forking task holds the mmap_lock of both mms and the VMA locks
+ * throughout; page table locking keeps the copies of separate ranges apart.
+ */
+#define FORK_PARALLEL_MIN_SIZE		SZ_1G
+#define FORK_PARALLEL_MAX_THREADS	16
+
+struct fork_copy_job {
+	struct vm_area_struct	*dst_vma;
+	struct vm_area_struct	*src_vma;
+	struct mem_cgroup	*memcg;
+	int			ret;
+};
+
+static void fork_copy_thread(unsigned long start, unsigned long end, void *arg)
+{
+	struct fork_copy_job *job = arg;
+	struct mem_cgroup *old_memcg;
+
+	if (READ_ONCE(job->ret))
+		return;
+
+	/* Charge the child's page tables like the forking task would */
+	old_memcg = set_active_memcg(job->memcg);
+	if (__copy_page_range(job->dst_vma, job->src_vma, start, end))
+		WRITE_ONCE(job->ret, -ENOMEM);
+	set_active_memcg(old_memcg);
+}
+
+static bool fork_copy_parallel(struct vm_area_struct *src_vma)
+{
+	return IS_ENABLED(CONFIG_PADATA) &&
+	       test_bit(MMF_FORK_PARALLEL, &src_vma->vm_mm->flags) &&
+	       vma_is_anonymous(src_vma) &&
+	       src_vma->vm_end - src_vma->vm_start >= FORK_PARALLEL_MIN_SIZE;
+}
+
+static int copy_page_range_parallel(struct vm_area_struct *dst_vma,
+				    struct vm_area_struct *src_vma)
+{
+	struct fork_copy_job job = {
+		.dst_vma	= dst_vma,
+		.src_vma	= src_vma,
+		.memcg		= get_mem_cgroup_from_mm(src_vma->vm_mm),
+	};
+	struct padata_mt_job mt_job = {
+		.thread_fn	= fork_copy_thread,
+		.fn_arg		= &job,
+		.start		= src_vma->vm_start,
+		.size		= src_vma->vm_end - src_vma->vm_start,
+		.align		= PMD_SIZE,
+		.min_chunk	= 64 * PMD_SIZE,
+		.max_threads	= min_t(int, num_online_cpus(),
+					FORK_PARALLEL_MAX_THREADS),
+	};
+
+	padata_do_multithreaded(&mt_job);
+	mem_cgroup_put(job.memcg);
+
+	return job.ret;
+}
+
+int
+copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
+{
 	unsigned long addr = src_vma->vm_start;
 	unsigned long end = src_vma->vm_end;
 	struct mm_struct *dst_mm = dst_vma->vm_mm;
@@ -1387,20 +1474,10 @@ copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
 		raw_write_seqcount_begin(&src_mm->write_protect_seq);
 	}
 
-	ret = 0;
-	dst_pgd = pgd_offset(dst_mm, addr);
-	src_pgd = pgd_offset(src_mm, addr);
-	do {
-		next = pgd_addr_end(addr, end);
-		if (pgd_none_or_clear_bad(src_pgd))
-			continue;
-		if (unlikely(copy_p4d_range(dst_vma, src_vma, dst_pgd, src_pgd,
-					    addr, next))) {
-			untrack_pfn_clear(dst_vma);
-			ret = -ENOMEM;
-			break;
-		}
-	} while (dst_pgd++, src_pgd++, addr = next, addr != end);
+	if (fork_copy_parallel(src_vma))
+		ret = copy_page_range_parallel(dst_vma, src_vma);
+	else
+		ret = __copy_page_range(dst_vma, src_vma, addr, end);
 
 	if (is_cow) {
 		raw_write_seqcount_end(&src_mm->write_protect_seq);
@@ -5058,6 +5135,7 @@ static vm_fault_t do_numa_page(struct vm_fault *vmf)
 	struct folio *folio = NULL;
 	int nid = NUMA_NO_NODE;
 	bool writable = false;
+	bool queue = false;
 	int last_cpupid;
 	int target_nid;
 	pte_t pte, old_pte;
@@ -5128,6 +5206,16 @@ static vm_fault_t do_numa_page(struct vm_fault *vmf)
 		folio_put(folio);
 		goto out_map;
 	}
+
+	/*
+	 * With batched NUMA migration, map the folio again, isolate it and
+	 * leave it to migrate_misplaced_flush() to move it along with others,
+	 * under one TLB flush.
+	 */
+	if (READ_ONCE(sysctl_numa_balancing_migrate_batch)) {
+		queue = true;
+		goto out_map;
+	}
 	pte_unmap_unlock(vmf->pte, vmf->ptl);
 	writable = false;
 
@@ -5165,6 +5253,8 @@ static vm_fault_t do_numa_page(struct vm_fault *vmf)
 	ptep_modify_prot_commit(vma, vmf->address, vmf->pte, old_pte, pte);
 	update_mmu_cache_range(vmf, vma, vmf->address, vmf->pte, 1);
 	pte_unmap_unlock(vmf->pte, vmf->ptl);
+	if (queue && !migrate_misplaced_folio_queue(folio, vma, target_nid))
+		migrate_misplaced_folio(folio, vma, target_nid);
 	goto out;
 }
 
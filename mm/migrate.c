@@ -2555,16 +2555,9 @@ static int numamigrate_isolate_folio(pg_data_t *pgdat, struct folio *folio)
  * node. Caller is expected to have an elevated reference count on
  * the folio that will be dropped by this function before returning.
  */
-int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
-			    int node)
+static bool migrate_misplaced_folio_allowed(struct folio *folio,
+					    struct vm_area_struct *vma)
 {
-	pg_data_t *pgdat = NODE_DATA(node);
-	int isolated;
-	int nr_remaining;
-	unsigned int nr_succeeded;
-	LIST_HEAD(migratepages);
-	int nr_pages = folio_nr_pages(folio);
-
 	/*
 	 * Don't migrate file folios that are mapped in multiple processes
 	 * with execute permissions as they are probably shared libraries.
@@ -2574,13 +2567,29 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	 */
 	if (folio_estimated_sharers(folio) != 1 && folio_is_file_lru(folio) &&
 	    (vma->vm_flags & VM_EXEC))
-		goto out;
+		return false;
 
 	/*
 	 * Also do not migrate dirty folios as not all filesystems can move
 	 * dirty folios in MIGRATE_ASYNC mode which is a waste of cycles.
 	 */
 	if (folio_is_file_lru(folio) && folio_test_dirty(folio))
+		return false;
+
+	return true;
+}
+
+int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
+			    int node)
+{
+	pg_data_t *pgdat = NODE_DATA(node);
+	int isolated;
+	int nr_remaining;
+	unsigned int nr_succeeded;
+	LIST_HEAD(migratepages);
+	int nr_pages = folio_nr_pages(folio);
+
+	if (!migrate_misplaced_folio_allowed(folio, vma))
 		goto out;
 
 	isolated = numamigrate_isolate_folio(pgdat, folio);
@@ -2613,5 +2622,136 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	folio_put(folio);
 	return 0;
 }
+
+/*
+ * Misplaced folios found by NUMA hinting faults, queued per task so that
+ * they are migrated together: migrate_pages() then unmaps the whole batch
+ * with a single deferred TLB flush instead of one shootdown per fault.
+ * All folios of a batch go to the same node and are isolated from the LRU
+ * when queued, as for an immediate migration, so that reclaim and compaction
+ * don't trip over them while they wait. The batch holds at most
+ * NUMA_MIGRATE_BATCH_MAX folios and is flushed at the latest by the task's
+ * next NUMA scan, or put back when it exits.
+ */
+struct numa_migrate_batch {
+	int nid;
+	unsigned int nr;
+	struct folio *folios[NUMA_MIGRATE_BATCH_MAX];
+};
+
+/*
+ * Queue a folio for migration to @node instead of migrating it right away.
+ * Returns true if the caller's reference on the folio was consumed, whether
+ * the folio could be isolated and queued or not. Returns false if batching
+ * is disabled, in which case the caller still owns the reference.
+ */
+bool migrate_misplaced_folio_queue(struct folio *folio,
+				   struct vm_area_struct *vma, int node)
+{
+	unsigned int batch = READ_ONCE(sysctl_numa_balancing_migrate_batch);
+	struct numa_migrate_batch *b = current->numa_migrate_batch;
+
+	if (!batch)
+		return false;
+
+	if (!b) {
+		b = kmalloc(sizeof(*b), GFP_KERNEL | __GFP_NOWARN);
+		if (!b)
+			return false;
+		b->nr = 0;
+		current->numa_migrate_batch = b;
+	}
+
+	if (!migrate_misplaced_folio_allowed(folio, vma)) {
+		folio_put(folio);
+		return true;
+	}
+
+	if (b->nr && b->nid != node)
+		migrate_misplaced_flush();
+
+	/* On success the isolation reference replaces the caller's one */
+	if (!numamigrate_isolate_folio(NODE_DATA(node), folio)) {
+		folio_put(folio);
+		return true;
+	}
+
+	b->nid = node;
+	b->folios[b->nr++] = folio;
+
+	if (b->nr >= min(batch, NUMA_MIGRATE_BATCH_MAX))
+		migrate_misplaced_flush();
+
+	return true;
+}
+
+/* Migrate the folios queued by the current task */
+void migrate_misplaced_flush(void)
+{
+	struct numa_migrate_batch *b = current->numa_migrate_batch;
+	unsigned int nr_succeeded = 0, nr_promote = 0;
+	pg_data_t *pgdat;
+	LIST_HEAD(migratepages);
+	LIST_HEAD(putback);
+	unsigned int i;
+
+	if (!b || !b->nr)
+		return;
+
+	pgdat = NODE_DATA(b->nid);
+	for (i = 0; i < b->nr; i++) {
+		struct folio *folio = b->folios[i];
+
+		/* Unmapped since it was queued, nothing to gain */
+		if (!folio_mapped(folio)) {
+			list_add_tail(&folio->lru, &putback);
+			continue;
+		}
+
+		list_add_tail(&folio->lru, &migratepages);
+		nr_promote += !node_is_toptier(folio_nid(folio));
+	}
+	b->nr = 0;
+
+	if (!list_empty(&putback))
+		putback_movable_pages(&putback);
+	if (list_empty(&migratepages))
+		return;
+
+	if (migrate_pages(&migratepages, alloc_misplaced_dst_folio, NULL,
+			  b->nid, MIGRATE_ASYNC, MR_NUMA_MISPLACED,
+			  &nr_succeeded))
+		putback_movable_pages(&migratepages);
+
+	if (nr_succeeded) {
+		count_vm_numa_events(NUMA_PAGE_MIGRATE, nr_succeeded);
+		current->numa_pages_migrated += nr_succeeded;
+		if (nr_promote && node_is_toptier(b->nid))
+			mod_node_page_state(pgdat, PGPROMOTE_SUCCESS,
+					    min(nr_succeeded, nr_promote));
+	}
+}
+
+/*
+ * Put the folios queued by the exiting task @p back on the LRU without
+ * migrating them. Called from do_exit(), as putting folios back needs task
+ * context.
+ */
+void migrate_misplaced_release(struct task_struct *p)
+{
+	struct numa_migrate_batch *b = p->numa_migrate_batch;
+	LIST_HEAD(putback);
+	unsigned int i;
+
+	if (!b)
+		return;
+
+	for (i = 0; i < b->nr; i++)
+		list_add_tail(&b->folios[i]->lru, &putback);
+	putback_movable_pages(&putback);
+
+	p->numa_migrate_batch = NULL;
+	kfree(b);
+}
 #endif /* CONFIG_NUMA_BALANCING */
 #endif /* CONFIG_NUMA */
@@ -2232,6 +2232,8 @@ static int __init deferred_init_memmap(void *data)
 			.min_chunk   = PAGES_PER_SECTION,
 			.max_threads = max_threads,
 			.numa_aware  = false,
+			.node_local  = true,
+			.nid         = pgdat->node_id,
 		};
 
 		padata_do_multithreaded(&job);
@@ -674,6 +674,60 @@ mprotect_fixup(struct vma_iterator *vmi, struct mmu_gather *tlb,
 	return error;
 }
 
+/*
+ * mprotect() calls that leave the protection of a single VMA unchanged are
+ * common with JIT runtimes.  They neither split nor merge the VMA and do
+ * not touch its page tables, so the mmap_lock is only taken for read.
+ * Returns false if the full path is needed, including for every error.
+ */
+static bool mprotect_unchanged_fast(unsigned long start, unsigned long end,
+		unsigned long prot, int pkey, bool rier, int *error)
+{
+	struct mm_struct *mm = current->mm;
+	unsigned long reqprot = prot;
+	struct vm_area_struct *vma;
+	unsigned long newflags;
+	bool handled = false;
+
+	/* An execute-only request may allocate a pkey, which needs the write lock */
+	if ((prot & (PROT_READ | PROT_WRITE | PROT_EXEC)) == PROT_EXEC)
+		return false;
+
+	if (mmap_read_lock_killable(mm))
+		return false;
+
+	if ((pkey != -1) && !mm_pkey_is_allocated(mm, pkey))
+		goto out;
+
+	vma = vma_lookup(mm, start);
+	if (!vma || vma->vm_end < end)
+		goto out;
+	if (vma->vm_ops && vma->vm_ops->mprotect)
+		goto out;
+
+	if (rier && (vma->vm_flags & VM_MAYEXEC))
+		prot |= PROT_EXEC;
+
+	newflags = calc_vm_prot_bits(prot,
+			arch_override_mprotect_pkey(vma, prot, pkey));
+	newflags |= (vma->vm_flags & ~(VM_ACCESS_FLAGS | VM_FLAGS_CLEAR));
+	if (newflags != vma->vm_flags)
+		goto out;
+
+	if ((newflags & ~(newflags >> 4)) & VM_ACCESS_FLAGS)
+		goto out;
+	if (map_deny_write_exec(vma, newflags))
+		goto out;
+	if (!arch_validate_flags(newflags))
+		goto out;
+
+	*error = security_file_mprotect(vma, reqprot, prot);
+	handled = true;
+out:
+	mmap_read_unlock(mm);
+	return handled;
+}
+
 /*
  * pkey==-1 when doing a legacy mprotect()
  */
@@ -708,6 +762,10 @@ static int do_mprotect_pkey(unsigned long start, size_t len,
 
 	reqprot = prot;
 
+	if (!grows && mprotect_unchanged_fast(start, end, prot, pkey, rier,
+					      &error))
+		return error;
+
 	if (mmap_write_lock_killable(current->mm))
 		return -EINTR;
 
@@ -1026,6 +1026,23 @@ SYSCALL_DEFINE5(mremap, unsigned long, addr, unsigned long, old_len,
 	if (!new_len)
 		return ret;
 
+	/*
+	 * A remap to the same size in place changes nothing; don't serialize
+	 * it against everything else on the mmap_lock held for write.
+	 */
+	if (old_len == new_len && !(flags & (MREMAP_FIXED | MREMAP_DONTUNMAP))) {
+		if (mmap_read_lock_killable(mm))
+			return -EINTR;
+		vma = vma_lookup(mm, addr);
+		if (!vma)
+			ret = -EFAULT;
+		else if (!is_vm_hugetlb_page(vma) ||
+			 !((addr | new_addr) & ~huge_page_mask(hstate_vma(vma))))
+			ret = addr;
+		mmap_read_unlock(mm);
+		return ret;
+	}
+
 	if (mmap_write_lock_killable(current->mm))
 		return -EINTR;
 	vma = vma_lookup(mm, addr);
@@ -810,6 +810,29 @@ int bdi_set_strict_limit(struct backing_dev_info *bdi, unsigned int strict_limit
 	return 0;
 }
 
+/* Upper bound for bdi->dirty_latency_ms */
+#define BDI_DIRTY_LATENCY_MAX	(60 * MSEC_PER_SEC)
+
+int bdi_set_dirty_latency(struct backing_dev_info *bdi, unsigned int msecs)
+{
+	if (msecs > BDI_DIRTY_LATENCY_MAX)
+		return -EINVAL;
+
+	WRITE_ONCE(bdi->dirty_latency_ms, msecs);
+	return 0;
+}
+
+/*
+ * A bdi with a latency target is throttled against its own limit, just like
+ * with strict_limit, so that it cannot use up the global dirty budget before
+ * its writers get throttled.
+ */
+static inline bool bdi_strictlimit(struct backing_dev_info *bdi)
+{
+	return (bdi->capabilities & BDI_CAP_STRICTLIMIT) ||
+		READ_ONCE(bdi->dirty_latency_ms);
+}
+
 static unsigned long dirty_freerun_ceiling(unsigned long thresh,
 					   unsigned long bg_thresh)
 {
@@ -854,6 +877,9 @@ static void mdtc_calc_avail(struct dirty_throttle_control *mdtc,
  *
  * The wb's share of dirty limit will be adapting to its throughput and
  * bounded by the bdi->min_ratio and/or bdi->max_ratio parameters, if set.
+ * With bdi->dirty_latency_ms set, it is further capped to the amount of
+ * dirty data the wb can write back within that time at its estimated write
+ * bandwidth.
  *
  * Return: @wb's dirty limit in pages. The term "dirty" in the context of
  * dirty balancing includes all PG_dirty and PG_writeback pages.
@@ -865,6 +891,7 @@ static unsigned long __wb_calc_thresh(struct dirty_throttle_control *dtc)
 	u64 wb_thresh;
 	unsigned long numerator, denominator;
 	unsigned long wb_min_ratio, wb_max_ratio;
+	unsigned int latency_ms;
 
 	/*
 	 * Calculate this BDI's share of the thresh ratio.
@@ -882,6 +909,16 @@ static unsigned long __wb_calc_thresh(struct dirty_throttle_control *dtc)
 	if (wb_thresh > (thresh * wb_max_ratio) / (100 * BDI_RATIO_SCALE))
 		wb_thresh = thresh * wb_max_ratio / (100 * BDI_RATIO_SCALE);
 
+	latency_ms = READ_ONCE(dtc->wb->bdi->dirty_latency_ms);
+	if (latency_ms) {
+		u64 latency_thresh;
+
+		latency_thresh = (u64)READ_ONCE(dtc->wb->avg_write_bandwidth) *
+				 latency_ms;
+		latency_thresh = div_u64(latency_thresh, MSEC_PER_SEC);
+		wb_thresh = min(wb_thresh, max(latency_thresh, 1ULL));
+	}
+
 	return wb_thresh;
 }
 
@@ -1050,7 +1087,7 @@ static void wb_position_ratio(struct dirty_throttle_control *dtc)
 	 * much earlier than global "freerun" is reached (~23MB vs. ~2.3GB
 	 * in the example above).
 	 */
-	if (unlikely(wb->bdi->capabilities & BDI_CAP_STRICTLIMIT)) {
+	if (unlikely(bdi_strictlimit(wb->bdi))) {
 		long long wb_pos_ratio;
 
 		if (dtc->wb_dirty < 8) {
@@ -1397,7 +1434,7 @@ static void wb_update_dirty_ratelimit(struct dirty_throttle_control *dtc,
 	 * it's possible that wb_thresh is close to zero due to inactivity
 	 * of backing device.
 	 */
-	if (unlikely(wb->bdi->capabilities & BDI_CAP_STRICTLIMIT)) {
+	if (unlikely(bdi_strictlimit(wb->bdi))) {
 		dirty = dtc->wb_dirty;
 		if (dtc->wb_dirty < 8)
 			setpoint = dtc->wb_dirty + 1;
@@ -1685,7 +1722,7 @@ static int balance_dirty_pages(struct bdi_writeback *wb,
 	unsigned long task_ratelimit;
 	unsigned long dirty_ratelimit;
 	struct backing_dev_info *bdi = wb->bdi;
-	bool strictlimit = bdi->capabilities & BDI_CAP_STRICTLIMIT;
+	bool strictlimit = bdi_strictlimit(bdi);
 	unsigned long start_time = jiffies;
 	int ret = 0;
 
@@ -666,6 +666,81 @@ compaction_capture(struct capture_control *capc, struct page *page,
 }
 #endif /* CONFIG_COMPACTION */
 
+#ifdef CONFIG_COMPACTION
+/* Count free pages per pageblock for compaction, see pageblock_free_pages() */
+static inline void account_pageblock_free(struct zone *zone, struct page *page,
+					  unsigned int order, bool add)
+{
+	unsigned int *pageblock_free = zone->pageblock_free;
+	unsigned long idx, nr = 1;
+	unsigned int delta = 1 << order;
+
+	if (!pageblock_free)
+		return;
+
+	idx = (page_to_pfn(page) - zone->pageblock_free_base) >> pageblock_order;
+	if (order > pageblock_order) {
+		nr = 1UL << (order - pageblock_order);
+		delta = pageblock_nr_pages;
+	}
+
+	for (; nr && idx < zone->pageblock_free_nr; nr--, idx++) {
+		if (add)
+			pageblock_free[idx] += delta;
+		else
+			pageblock_free[idx] -= delta;
+	}
+}
+
+/*
+ * The counts are only set up once the buddy allocator is populated, from the
+ * free lists, and then updated along with them.
+ */
+static int __init pageblock_free_init(void)
+{
+	struct zone *zone;
+
+	for_each_populated_zone(zone) {
+		unsigned long base = pageblock_start_pfn(zone->zone_start_pfn);
+		unsigned long nr = (pageblock_align(zone_end_pfn(zone)) - base) >>
+				   pageblock_order;
+		unsigned int *pageblock_free;
+		unsigned long flags;
+		unsigned int order;
+		int mt;
+
+		pageblock_free = kvcalloc(nr, sizeof(*pageblock_free), GFP_KERNEL);
+		if (!pageblock_free)
+			continue;
+
+		spin_lock_irqsave(&zone->lock, flags);
+		zone->pageblock_free_base = base;
+		zone->pageblock_free_nr = nr;
+		smp_store_release(&zone->pageblock_free, pageblock_free);
+		for (order = 0; order < NR_PAGE_ORDERS; order++) {
+			for (mt = 0; mt < MIGRATE_TYPES; mt++) {
+				struct page *page;
+
+				list_for_each_entry(page,
+					&zone->free_area[order].free_list[mt],
+					buddy_list)
+					account_pageblock_free(zone, page,
+							       order, true);
+			}
+		}
+		spin_unlock_irqrestore(&zone->lock, flags);
+	}
+
+	return 0;
+}
+core_initcall(pageblock_free_init);
+#else
+static inline void account_pageblock_free(struct zone *zone, struct page *page,
+					  unsigned int order, bool add)
+{
+}
+#endif /* CONFIG_COMPACTION */
+
 /* Used for pages not on another list */
 static inline void add_to_free_list(struct page *page, struct zone *zone,
 				    unsigned int order, int migratetype)
@@ -674,6 +749,7 @@ static inline void add_to_free_list(struct page *page, struct zone *zone,
 
 	list_add(&page->buddy_list, &area->free_list[migratetype]);
 	area->nr_free++;
+	account_pageblock_free(zone, page, order, true);
 }
 
 /* Used for pages not on another list */
@@ -684,6 +760,7 @@ static inline void add_to_free_list_tail(struct page *page, struct zone *zone,
 
 	list_add_tail(&page->buddy_list, &area->free_list[migratetype]);
 	area->nr_free++;
+	account_pageblock_free(zone, page, order, true);
 }
 
 /*
@@ -710,6 +787,7 @@ static inline void del_page_from_free_list(struct page *page, struct zone *zone,
 	__ClearPageBuddy(page);
 	set_page_private(page, 0);
 	zone->free_area[order].nr_free--;
+	account_pageblock_free(zone, page, order, false);
 }
 
 static inline struct page *get_page_from_free_area(struct free_area *area,
@@ -2125,17 +2203,21 @@ __rmqueue(struct zone *zone, unsigned int order, int migratetype,
 /*
  * Obtain a specified number of elements from the buddy allocator, and relax the
  * zone lock when needed. Add them to the supplied list. Returns the number of
- * new pages which were placed at *list.
+ * new pages which were placed at *list. *contended is set if the zone lock
+ * could not be taken right away.
  */
 static int rmqueue_bulk(struct zone *zone, unsigned int order,
 			unsigned long count, struct list_head *list,
-			int migratetype, unsigned int alloc_flags)
+			int migratetype, unsigned int alloc_flags,
+			bool *contended)
 {
 	const bool can_resched = !preempt_count() && !irqs_disabled();
 	unsigned long flags;
 	int i, last_mod = 0;
 
-	spin_lock_irqsave(&zone->lock, flags);
+	*contended = !spin_trylock_irqsave(&zone->lock, flags);
+	if (*contended)
+		spin_lock_irqsave(&zone->lock, flags);
 	for (i = 0; i < count; ++i) {
 		struct page *page = __rmqueue(zone, order, migratetype,
 								alloc_flags);
@@ -2812,6 +2894,14 @@ static int nr_pcp_alloc(struct per_cpu_pages *pcp, struct zone *zone, int order)
 		if (batch <= max_nr_alloc &&
 		    pcp->alloc_factor < CONFIG_PCP_BATCH_SCALE_MAX)
 			pcp->alloc_factor++;
+		/*
+		 * Ramp up twice as fast while refills keep finding the zone
+		 * lock contended, to amortize the lock over more pages.
+		 */
+		if ((pcp->flags & PCPF_REFILL_CONTENDED) &&
+		    (batch << 1) <= max_nr_alloc &&
+		    pcp->alloc_factor < CONFIG_PCP_BATCH_SCALE_MAX)
+			pcp->alloc_factor++;
 		batch = min(batch, max_nr_alloc);
 	}
 
@@ -2840,12 +2930,21 @@ struct page *__rmqueue_pcplist(struct zone *zone, unsigned int order,
 	do {
 		if (list_empty(list)) {
 			int batch = nr_pcp_alloc(pcp, zone, order);
+			bool contended;
 			int alloced;
 
 			alloced = rmqueue_bulk(zone, order,
 					batch, list,
-					migratetype, alloc_flags);
-
+					migratetype, alloc_flags,
+					&contended);
+
+			pcp->refills++;
+			if (contended) {
+				pcp->refills_contended++;
+				pcp->flags |= PCPF_REFILL_CONTENDED;
+			} else {
+				pcp->flags &= ~PCPF_REFILL_CONTENDED;
+			}
 			pcp->count += alloced << order;
 			if (unlikely(list_empty(list)))
 				return NULL;
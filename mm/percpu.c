@@ -84,6 +84,7 @@
 #include <linux/vmalloc.h>
 #include <linux/workqueue.h>
 #include <linux/kmemleak.h>
+#include <linux/local_lock.h>
 #include <linux/sched.h>
 #include <linux/sched/mm.h>
 #include <linux/memcontrol.h>
@@ -1699,6 +1700,117 @@ static void pcpu_memcg_free_hook(struct pcpu_chunk *chunk, int off, size_t size)
 }
 #endif /* CONFIG_MEMCG_KMEM */
 
+/*
+ * Small percpu areas are allocated and freed at a high rate by some
+ * subsystems, and each of those allocations has to serialize on pcpu_lock.
+ * When enabled with "percpu_area_cache=on" on the kernel command line, each
+ * cpu keeps a few preallocated areas of every size class up to
+ * PCPU_AREA_CACHE_MAX_SIZE so that most small allocations are handed out
+ * without touching pcpu_lock.  Refills grab a whole batch under one lock
+ * hold.  Areas are freed through the regular path.
+ */
+#define PCPU_AREA_CACHE_ALIGN		8
+#define PCPU_AREA_CACHE_MAX_SIZE	64
+#define PCPU_AREA_CACHE_CLASSES		(PCPU_AREA_CACHE_MAX_SIZE / PCPU_AREA_CACHE_ALIGN)
+#define PCPU_AREA_CACHE_BATCH		8
+
+struct pcpu_area_cache {
+	local_lock_t lock;
+	unsigned char nr[PCPU_AREA_CACHE_CLASSES];
+	void __percpu *areas[PCPU_AREA_CACHE_CLASSES][PCPU_AREA_CACHE_BATCH];
+};
+
+static DEFINE_PER_CPU(struct pcpu_area_cache, pcpu_area_cache) = {
+	.lock = INIT_LOCAL_LOCK(lock),
+};
+
+static bool pcpu_area_cache_param __initdata;
+static bool pcpu_area_cache_enabled __ro_after_init;
+
+static int __init percpu_area_cache_setup(char *str)
+{
+	return kstrtobool(str, &pcpu_area_cache_param);
+}
+early_param("percpu_area_cache", percpu_area_cache_setup);
+
+static bool pcpu_area_cache_eligible(size_t size, size_t align, bool reserved)
+{
+	return pcpu_area_cache_enabled && !reserved &&
+	       size <= PCPU_AREA_CACHE_MAX_SIZE &&
+	       align <= PCPU_AREA_CACHE_ALIGN;
+}
+
+/*
+ * Fill @class of @cache from populated free space.  Only populated pages
+ * are considered so that this can be done from any context; if nothing
+ * fits, the caller falls back to pcpu_alloc()'s regular path.
+ */
+static void pcpu_area_cache_refill(struct pcpu_area_cache *cache, int class,
+				   size_t size)
+{
+	int bits = size >> PCPU_MIN_ALLOC_SHIFT;
+	int bit_align = PCPU_AREA_CACHE_ALIGN >> PCPU_MIN_ALLOC_SHIFT;
+	struct pcpu_chunk *chunk, *next;
+	unsigned long flags;
+	int slot, off;
+
+	spin_lock_irqsave(&pcpu_lock, flags);
+
+	for (slot = pcpu_size_to_slot(size); slot <= pcpu_free_slot; slot++) {
+		list_for_each_entry_safe(chunk, next, &pcpu_chunk_lists[slot],
+					 list) {
+			while (cache->nr[class] < PCPU_AREA_CACHE_BATCH) {
+				off = pcpu_find_block_fit(chunk, bits,
+							  bit_align, true);
+				if (off < 0)
+					break;
+
+				off = pcpu_alloc_area(chunk, bits, bit_align,
+						      off);
+				if (off < 0)
+					break;
+
+				pcpu_reintegrate_chunk(chunk);
+				pcpu_stats_area_alloc(chunk, size);
+				cache->areas[class][cache->nr[class]++] =
+					__addr_to_pcpu_ptr(chunk->base_addr + off);
+			}
+
+			if (cache->nr[class] == PCPU_AREA_CACHE_BATCH)
+				goto out_unlock;
+		}
+	}
+
+out_unlock:
+	spin_unlock_irqrestore(&pcpu_lock, flags);
+
+	if (pcpu_nr_empty_pop_pages < PCPU_EMPTY_POP_PAGES_LOW)
+		pcpu_schedule_balance_work();
+}
+
+/*
+ * Hand out a cached area of @size bytes, which must be a multiple of
+ * PCPU_AREA_CACHE_ALIGN.  Returns NULL if none could be found.
+ */
+static void __percpu *pcpu_area_cache_alloc(size_t size)
+{
+	int class = size / PCPU_AREA_CACHE_ALIGN - 1;
+	struct pcpu_area_cache *cache;
+	void __percpu *ptr = NULL;
+	unsigned long flags;
+
+	local_lock_irqsave(&pcpu_area_cache.lock, flags);
+	cache = this_cpu_ptr(&pcpu_area_cache);
+
+	if (!cache->nr[class])
+		pcpu_area_cache_refill(cache, class, size);
+	if (cache->nr[class])
+		ptr = cache->areas[class][--cache->nr[class]];
+
+	local_unlock_irqrestore(&pcpu_area_cache.lock, flags);
+	return ptr;
+}
+
 /**
  * pcpu_alloc - the percpu allocator
  * @size: size of area to allocate in bytes
@@ -1745,6 +1857,9 @@ static void __percpu *pcpu_alloc(size_t size, size_t align, bool reserved,
 		align = PCPU_MIN_ALLOC_SIZE;
 
 	size = ALIGN(size, PCPU_MIN_ALLOC_SIZE);
+	/* cached areas come in size classes, account the whole class */
+	if (pcpu_area_cache_eligible(size, align, reserved))
+		size = ALIGN(size, PCPU_AREA_CACHE_ALIGN);
 	bits = size >> PCPU_MIN_ALLOC_SHIFT;
 	bit_align = align >> PCPU_MIN_ALLOC_SHIFT;
 
@@ -1758,6 +1873,17 @@ static void __percpu *pcpu_alloc(size_t size, size_t align, bool reserved,
 	if (unlikely(!pcpu_memcg_pre_alloc_hook(size, gfp, &objcg)))
 		return NULL;
 
+	if (pcpu_area_cache_eligible(size, align, reserved)) {
+		ptr = pcpu_area_cache_alloc(size);
+		if (ptr) {
+			void *addr = __pcpu_ptr_to_addr(ptr);
+
+			chunk = pcpu_chunk_addr_search(addr);
+			off = addr - chunk->base_addr;
+			goto area_ready;
+		}
+	}
+
 	if (!is_atomic) {
 		/*
 		 * pcpu_balance_workfn() allocates memory under this mutex,
@@ -1868,6 +1994,7 @@ static void __percpu *pcpu_alloc(size_t size, size_t align, bool reserved,
 	if (pcpu_nr_empty_pop_pages < PCPU_EMPTY_POP_PAGES_LOW)
 		pcpu_schedule_balance_work();
 
+area_ready:
 	/* clear the areas and return address relative to base address */
 	for_each_possible_cpu(cpu)
 		memset((void *)pcpu_chunk_addr(chunk, cpu, 0) + off, 0, size);
@@ -3456,6 +3583,7 @@ unsigned long pcpu_nr_pages(void)
 static int __init percpu_enable_async(void)
 {
 	pcpu_async_enabled = true;
+	pcpu_area_cache_enabled = pcpu_area_cache_param;
 	return 0;
 }
 subsys_initcall(percpu_enable_async);
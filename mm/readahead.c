@@ -143,6 +143,37 @@ file_ra_state_init(struct file_ra_state *ra, struct address_space *mapping)
 }
 EXPORT_SYMBOL_GPL(file_ra_state_init);
 
+/*
+ * The readahead state lives in struct file and is lost on close, so files
+ * that are repeatedly opened, read sequentially and closed would ramp up
+ * from the initial window every time.  Remember the window size and folio
+ * order of the last sequential stream in the address_space, so that a new
+ * open can start from where the previous one left off.
+ */
+#define RA_HINT_SIZE_MASK	0xffffU
+#define RA_HINT_ORDER_SHIFT	16
+#define RA_HINT_ORDER_MASK	0xffU
+#define RA_HINT_SEQ		(1U << 31)
+
+static void ra_hint_save(struct address_space *mapping, unsigned int size,
+		unsigned int order)
+{
+	unsigned int hint = RA_HINT_SEQ;
+
+	hint |= min(size, RA_HINT_SIZE_MASK);
+	hint |= min(order, RA_HINT_ORDER_MASK) << RA_HINT_ORDER_SHIFT;
+
+	/* Avoid dirtying a shared cacheline on every window */
+	if (READ_ONCE(mapping->ra_hint) != hint)
+		WRITE_ONCE(mapping->ra_hint, hint);
+}
+
+static void ra_hint_clear(struct address_space *mapping)
+{
+	if (READ_ONCE(mapping->ra_hint) & RA_HINT_SEQ)
+		WRITE_ONCE(mapping->ra_hint, 0);
+}
+
 static void read_pages(struct readahead_control *rac)
 {
 	const struct address_space_operations *aops = rac->mapping->a_ops;
@@ -580,6 +611,7 @@ static void ondemand_readahead(struct readahead_control *ractl,
 		ra->start += ra->size;
 		ra->size = get_next_ra_size(ra, max_pages);
 		ra->async_size = ra->size;
+		ra_hint_save(ractl->mapping, ra->size, order);
 		goto readit;
 	}
 
@@ -635,12 +667,28 @@ static void ondemand_readahead(struct readahead_control *ractl,
 	 * standalone, small random read
 	 * Read as is, and do not pollute the readahead state.
 	 */
+	ra_hint_clear(ractl->mapping);
 	do_page_cache_ra(ractl, req_size, 0);
 	return;
 
 initial_readahead:
 	ra->start = index;
 	ra->size = get_init_ra_size(req_size, max_pages);
+	/*
+	 * First read from the start of a freshly opened file: resume the
+	 * window and folio order of the last sequential reader.
+	 */
+	if (!index && ra->prev_pos == -1) {
+		unsigned int hint = READ_ONCE(ractl->mapping->ra_hint);
+
+		if (hint & RA_HINT_SEQ) {
+			ra->size = max_t(unsigned long, ra->size,
+				min_t(unsigned long, hint & RA_HINT_SIZE_MASK,
+				      max_pages));
+			order = max(order, (hint >> RA_HINT_ORDER_SHIFT) &
+					   RA_HINT_ORDER_MASK);
+		}
+	}
 	ra->async_size = ra->size > req_size ? ra->size - req_size : ra->size;
 
 readit:
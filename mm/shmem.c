@@ -119,6 +119,7 @@ struct shmem_options {
 	umode_t mode;
 	bool full_inums;
 	int huge;
+	unsigned long huge_orders;
 	int seen;
 	bool noswap;
 	unsigned short quota_types;
@@ -129,6 +130,7 @@ struct shmem_options {
 #define SHMEM_SEEN_INUMS 8
 #define SHMEM_SEEN_NOSWAP 16
 #define SHMEM_SEEN_QUOTA 32
+#define SHMEM_SEEN_HUGE_ORDERS 64
 };
 
 #ifdef CONFIG_TMPFS
@@ -573,6 +575,66 @@ bool shmem_is_huge(struct inode *inode, pgoff_t index, bool shmem_huge_force,
 	}
 }
 
+/*
+ * Large folio orders a shmem allocation at @index may try, highest first.
+ * Orders set to "always" in hugepages-<size>kB/shmem_enabled are used
+ * regardless of the huge= policy; when that policy allows huge folios here
+ * (@huge), the orders given with the huge_sizes= mount option are added,
+ * or the "inherit" ones if the mount did not specify any.
+ */
+static unsigned long shmem_allowable_huge_orders(struct inode *inode,
+		struct mm_struct *mm, unsigned long vm_flags, bool huge)
+{
+	unsigned long orders;
+
+	if (!S_ISREG(inode->i_mode) || shmem_huge == SHMEM_HUGE_DENY)
+		return 0;
+	if (mm && ((vm_flags & VM_NOHUGEPAGE) ||
+		   test_bit(MMF_DISABLE_THP, &mm->flags)))
+		return 0;
+
+	orders = READ_ONCE(huge_shmem_orders_always);
+	if (huge)
+		orders |= READ_ONCE(SHMEM_SB(inode->i_sb)->huge_orders) ?:
+			  READ_ONCE(huge_shmem_orders_inherit);
+
+	return orders & THP_ORDERS_ALL_ANON;
+}
+
+#ifdef CONFIG_TMPFS
+/*
+ * Parse the huge_sizes= mount option: a ':' separated list of folio sizes,
+ * e.g. "64K:2M", or "inherit" to follow the sysfs settings.
+ */
+static int shmem_parse_huge_sizes(char *str, unsigned long *orders)
+{
+	unsigned long mask = 0;
+	char *p;
+
+	if (!strcmp(str, "inherit")) {
+		*orders = 0;
+		return 0;
+	}
+
+	while ((p = strsep(&str, ":")) != NULL) {
+		unsigned long long size;
+		char *rest;
+		int order;
+
+		size = memparse(p, &rest);
+		if (*rest || size < PAGE_SIZE || !is_power_of_2(size))
+			return -EINVAL;
+		order = ilog2(size) - PAGE_SHIFT;
+		if (order >= BITS_PER_LONG || !(BIT(order) & THP_ORDERS_ALL_ANON))
+			return -EINVAL;
+		mask |= BIT(order);
+	}
+
+	*orders = mask;
+	return 0;
+}
+#endif
+
 #if defined(CONFIG_SYSFS)
 static int shmem_parse_huge(const char *str)
 {
@@ -748,6 +810,19 @@ static long shmem_unused_huge_count(struct super_block *sb,
 
 #define shmem_huge SHMEM_HUGE_DENY
 
+static unsigned long shmem_allowable_huge_orders(struct inode *inode,
+		struct mm_struct *mm, unsigned long vm_flags, bool huge)
+{
+	return 0;
+}
+
+#ifdef CONFIG_TMPFS
+static int shmem_parse_huge_sizes(char *str, unsigned long *orders)
+{
+	return -EINVAL;
+}
+#endif
+
 static unsigned long shmem_unused_huge_shrink(struct shmem_sb_info *sbinfo,
 		struct shrink_control *sc, unsigned long nr_to_split)
 {
@@ -1604,14 +1679,14 @@ static gfp_t limit_gfp_mask(gfp_t huge_gfp, gfp_t limit_gfp)
 }
 
 static struct folio *shmem_alloc_hugefolio(gfp_t gfp,
-		struct shmem_inode_info *info, pgoff_t index)
+		struct shmem_inode_info *info, pgoff_t index, int order)
 {
 	struct mempolicy *mpol;
 	pgoff_t ilx;
 	struct page *page;
 
-	mpol = shmem_get_pgoff_policy(info, index, HPAGE_PMD_ORDER, &ilx);
-	page = alloc_pages_mpol(gfp, HPAGE_PMD_ORDER, mpol, ilx, numa_node_id());
+	mpol = shmem_get_pgoff_policy(info, index, order, &ilx);
+	page = alloc_pages_mpol(gfp, order, mpol, ilx, numa_node_id());
 	mpol_cond_put(mpol);
 
 	return page_rmappable_folio(page);
@@ -1633,22 +1708,23 @@ static struct folio *shmem_alloc_folio(gfp_t gfp,
 
 static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		struct inode *inode, pgoff_t index,
-		struct mm_struct *fault_mm, bool huge)
+		struct mm_struct *fault_mm, unsigned long orders)
 {
 	struct address_space *mapping = inode->i_mapping;
 	struct shmem_inode_info *info = SHMEM_I(inode);
-	struct folio *folio;
+	struct folio *folio = NULL;
 	long pages;
 	int error;
 
 	if (!IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE))
-		huge = false;
+		orders = 0;
 
-	if (huge) {
-		pages = HPAGE_PMD_NR;
-		index = round_down(index, HPAGE_PMD_NR);
+	if (orders) {
+		pgoff_t start = index, first;
+		int order;
 
 		/*
+		 * Try the allowed orders from the highest down.
 		 * Check for conflict before waiting on a huge allocation.
 		 * Conflict might be that a huge page has just been allocated
 		 * and added to page cache by a racing thread, or that there
@@ -1656,13 +1732,24 @@ static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		 * Be careful to retry when appropriate, but not forever!
 		 * Elsewhere -EEXIST would be the right code, but not here.
 		 */
-		if (xa_find(&mapping->i_pages, &index,
-				index + HPAGE_PMD_NR - 1, XA_PRESENT))
-			return ERR_PTR(-E2BIG);
-
-		folio = shmem_alloc_hugefolio(gfp, info, index);
+		order = highest_order(orders);
+		while (orders) {
+			pages = 1L << order;
+			start = first = round_down(index, pages);
+			if (!xa_find(&mapping->i_pages, &first,
+					start + pages - 1, XA_PRESENT)) {
+				folio = shmem_alloc_hugefolio(gfp, info,
+							      start, order);
+				if (folio)
+					break;
+				if (order == HPAGE_PMD_ORDER)
+					count_vm_event(THP_FILE_FALLBACK);
+			}
+			order = next_order(&orders, order);
+		}
 		if (!folio)
-			count_vm_event(THP_FILE_FALLBACK);
+			return ERR_PTR(-E2BIG);
+		index = start;
 	} else {
 		pages = 1;
 		folio = shmem_alloc_folio(gfp, info, index);
@@ -1679,7 +1766,7 @@ static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		if (xa_find(&mapping->i_pages, &index,
 				index + pages - 1, XA_PRESENT)) {
 			error = -EEXIST;
-		} else if (huge) {
+		} else if (folio_test_pmd_mappable(folio)) {
 			count_vm_event(THP_FILE_FALLBACK);
 			count_vm_event(THP_FILE_FALLBACK_CHARGE);
 		}
@@ -1963,6 +2050,7 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 	struct vm_area_struct *vma = vmf ? vmf->vma : NULL;
 	struct mm_struct *fault_mm;
 	struct folio *folio;
+	unsigned long orders;
 	int error;
 	bool alloced;
 
@@ -2036,23 +2124,27 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 		return 0;
 	}
 
-	if (shmem_is_huge(inode, index, false, fault_mm,
-			  vma ? vma->vm_flags : 0)) {
+	orders = shmem_allowable_huge_orders(inode, fault_mm,
+			vma ? vma->vm_flags : 0,
+			shmem_is_huge(inode, index, false, fault_mm,
+				      vma ? vma->vm_flags : 0));
+	if (orders) {
 		gfp_t huge_gfp;
 
 		huge_gfp = vma_thp_gfp_mask(vma);
 		huge_gfp = limit_gfp_mask(huge_gfp, gfp);
 		folio = shmem_alloc_and_add_folio(huge_gfp,
-				inode, index, fault_mm, true);
+				inode, index, fault_mm, orders);
 		if (!IS_ERR(folio)) {
-			count_vm_event(THP_FILE_ALLOC);
+			if (folio_test_pmd_mappable(folio))
+				count_vm_event(THP_FILE_ALLOC);
 			goto alloced;
 		}
 		if (PTR_ERR(folio) == -EEXIST)
 			goto repeat;
 	}
 
-	folio = shmem_alloc_and_add_folio(gfp, inode, index, fault_mm, false);
+	folio = shmem_alloc_and_add_folio(gfp, inode, index, fault_mm, 0);
 	if (IS_ERR(folio)) {
 		error = PTR_ERR(folio);
 		if (error == -EEXIST)
@@ -3877,6 +3969,7 @@ static const struct export_operations shmem_export_ops = {
 enum shmem_param {
 	Opt_gid,
 	Opt_huge,
+	Opt_huge_sizes,
 	Opt_mode,
 	Opt_mpol,
 	Opt_nr_blocks,
@@ -3906,6 +3999,7 @@ static const struct constant_table shmem_param_enums_huge[] = {
 const struct fs_parameter_spec shmem_fs_parameters[] = {
 	fsparam_u32   ("gid",		Opt_gid),
 	fsparam_enum  ("huge",		Opt_huge,  shmem_param_enums_huge),
+	fsparam_string("huge_sizes",	Opt_huge_sizes),
 	fsparam_u32oct("mode",		Opt_mode),
 	fsparam_string("mpol",		Opt_mpol),
 	fsparam_string("nr_blocks",	Opt_nr_blocks),
@@ -4006,6 +4100,14 @@ static int shmem_parse_one(struct fs_context *fc, struct fs_parameter *param)
 			goto unsupported_parameter;
 		ctx->seen |= SHMEM_SEEN_HUGE;
 		break;
+	case Opt_huge_sizes:
+		if (!(IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE) &&
+		      has_transparent_hugepage()))
+			goto unsupported_parameter;
+		if (shmem_parse_huge_sizes(param->string, &ctx->huge_orders))
+			goto bad_value;
+		ctx->seen |= SHMEM_SEEN_HUGE_ORDERS;
+		break;
 	case Opt_mpol:
 		if (IS_ENABLED(CONFIG_NUMA)) {
 			mpol_put(ctx->mpol);
@@ -4212,6 +4314,8 @@ static int shmem_reconfigure(struct fs_context *fc)
 
 	if (ctx->seen & SHMEM_SEEN_HUGE)
 		sbinfo->huge = ctx->huge;
+	if (ctx->seen & SHMEM_SEEN_HUGE_ORDERS)
+		WRITE_ONCE(sbinfo->huge_orders, ctx->huge_orders);
 	if (ctx->seen & SHMEM_SEEN_INUMS)
 		sbinfo->full_inums = ctx->full_inums;
 	if (ctx->seen & SHMEM_SEEN_BLOCKS)
@@ -4285,6 +4389,15 @@ static int shmem_show_options(struct seq_file *seq, struct dentry *root)
 	/* Rightly or wrongly, show huge mount option unmasked by shmem_huge */
 	if (sbinfo->huge)
 		seq_printf(seq, ",huge=%s", shmem_format_huge(sbinfo->huge));
+	if (sbinfo->huge_orders) {
+		const char *sep = ",huge_sizes=";
+		int order;
+
+		for_each_set_bit(order, &sbinfo->huge_orders, BITS_PER_LONG) {
+			seq_printf(seq, "%s%luK", sep, (PAGE_SIZE << order) >> 10);
+			sep = ":";
+		}
+	}
 #endif
 	mpol = shmem_get_sbmpol(sbinfo);
 	shmem_show_mpol(seq, mpol);
@@ -4378,6 +4491,7 @@ static int shmem_fill_super(struct super_block *sb, struct fs_context *fc)
 	sbinfo->full_inums = ctx->full_inums;
 	sbinfo->mode = ctx->mode;
 	sbinfo->huge = ctx->huge;
+	sbinfo->huge_orders = ctx->huge_orders;
 	sbinfo->mpol = ctx->mpol;
 	ctx->mpol = NULL;
 
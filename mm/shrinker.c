@@ -3,6 +3,7 @@
 #include <linux/rwsem.h>
 #include <linux/shrinker.h>
 #include <linux/rculist.h>
+#include <linux/sched/clock.h>
 #include <trace/events/vmscan.h>
 
 #include "internal.h"
@@ -366,6 +367,39 @@ static long add_nr_deferred(long nr, struct shrinker *shrinker,
 
 #define SHRINK_BATCH 128
 
+#ifdef CONFIG_SHRINKER_DEBUG
+static inline u64 shrinker_stats_start(void)
+{
+	return local_clock();
+}
+
+static void shrinker_stats_account(struct shrinker *shrinker,
+				   unsigned long scanned, unsigned long freed,
+				   u64 start)
+{
+	s64 ns = local_clock() - start;
+	s64 max = atomic64_read(&shrinker->max_ns);
+
+	atomic_long_inc(&shrinker->nr_calls);
+	atomic_long_add(scanned, &shrinker->nr_scanned);
+	atomic_long_add(freed, &shrinker->nr_freed);
+	atomic64_add(ns, &shrinker->total_ns);
+	while (ns > max && !atomic64_try_cmpxchg(&shrinker->max_ns, &max, ns))
+		;
+}
+#else
+static inline u64 shrinker_stats_start(void)
+{
+	return 0;
+}
+
+static inline void shrinker_stats_account(struct shrinker *shrinker,
+					  unsigned long scanned,
+					  unsigned long freed, u64 start)
+{
+}
+#endif
+
 static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
 				    struct shrinker *shrinker, int priority)
 {
@@ -378,6 +412,7 @@ static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
 	long batch_size = shrinker->batch ? shrinker->batch
 					  : SHRINK_BATCH;
 	long scanned = 0, next_deferred;
+	u64 start = shrinker_stats_start();
 
 	freeable = shrinker->count_objects(shrinker, shrinkctl);
 	if (freeable == 0 || freeable == SHRINK_EMPTY)
@@ -460,6 +495,7 @@ static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
 	new_nr = add_nr_deferred(next_deferred, shrinker, shrinkctl);
 
 	trace_mm_shrink_slab_end(shrinker, shrinkctl->nid, freed, nr, new_nr, total_scan);
+	shrinker_stats_account(shrinker, scanned, freed, start);
 	return freed;
 }
 
@@ -159,6 +159,58 @@ static const struct file_operations shrinker_debugfs_scan_fops = {
 	.write	 = shrinker_debugfs_scan_write,
 };
 
+/*
+ * How much time shrink_slab() spent in the shrinker and how well that paid
+ * off, to find the shrinkers that stall reclaim.  Writing clears them.
+ */
+static int shrinker_debugfs_stats_show(struct seq_file *m, void *v)
+{
+	struct shrinker *shrinker = m->private;
+	unsigned long calls = atomic_long_read(&shrinker->nr_calls);
+	unsigned long freed = atomic_long_read(&shrinker->nr_freed);
+	u64 total_ns = atomic64_read(&shrinker->total_ns);
+
+	seq_printf(m, "calls %lu\n", calls);
+	seq_printf(m, "scanned %lu\n", atomic_long_read(&shrinker->nr_scanned));
+	seq_printf(m, "freed %lu\n", freed);
+	seq_printf(m, "total_ns %llu\n", total_ns);
+	seq_printf(m, "max_ns %lld\n", atomic64_read(&shrinker->max_ns));
+	seq_printf(m, "avg_ns %llu\n", calls ? div64_ul(total_ns, calls) : 0);
+	seq_printf(m, "ns_per_freed %llu\n",
+		   freed ? div64_ul(total_ns, freed) : 0);
+
+	return 0;
+}
+
+static int shrinker_debugfs_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, shrinker_debugfs_stats_show, inode->i_private);
+}
+
+static ssize_t shrinker_debugfs_stats_write(struct file *file,
+					    const char __user *buf,
+					    size_t count, loff_t *pos)
+{
+	struct shrinker *shrinker = file_inode(file)->i_private;
+
+	atomic_long_set(&shrinker->nr_calls, 0);
+	atomic_long_set(&shrinker->nr_scanned, 0);
+	atomic_long_set(&shrinker->nr_freed, 0);
+	atomic64_set(&shrinker->total_ns, 0);
+	atomic64_set(&shrinker->max_ns, 0);
+
+	return count;
+}
+
+static const struct file_operations shrinker_debugfs_stats_fops = {
+	.owner	 = THIS_MODULE,
+	.open	 = shrinker_debugfs_stats_open,
+	.read	 = seq_read,
+	.write	 = shrinker_debugfs_stats_write,
+	.llseek	 = seq_lseek,
+	.release = single_release,
+};
+
 int shrinker_debugfs_add(struct shrinker *shrinker)
 {
 	struct dentry *entry;
@@ -190,6 +242,8 @@ int shrinker_debugfs_add(struct shrinker *shrinker)
 			    &shrinker_debugfs_count_fops);
 	debugfs_create_file("scan", 0220, entry, shrinker,
 			    &shrinker_debugfs_scan_fops);
+	debugfs_create_file("stats", 0640, entry, shrinker,
+			    &shrinker_debugfs_stats_fops);
 	return 0;
 }
 
@@ -251,6 +251,7 @@ struct kmem_cache_order_objects {
 struct kmem_cache {
 #ifndef CONFIG_SLUB_TINY
 	struct kmem_cache_cpu __percpu *cpu_slab;
+	struct slub_percpu_sheaves __percpu *cpu_sheaves;
 #endif
 	/* Used for retrieving partial slabs, etc. */
 	slab_flags_t flags;
@@ -453,7 +454,8 @@ static inline bool is_kmalloc_cache(struct kmem_cache *s)
 
 #define SLAB_CACHE_FLAGS (SLAB_NOLEAKTRACE | SLAB_RECLAIM_ACCOUNT | \
 			  SLAB_TEMPORARY | SLAB_ACCOUNT | \
-			  SLAB_NO_USER_FLAGS | SLAB_KMALLOC | SLAB_NO_MERGE)
+			  SLAB_NO_USER_FLAGS | SLAB_KMALLOC | SLAB_NO_MERGE | \
+			  SLAB_SHEAVES)
 
 /* Common flags available with current configuration */
 #define CACHE_CREATE_MASK (SLAB_CORE_FLAGS | SLAB_DEBUG_FLAGS | SLAB_CACHE_FLAGS)
@@ -471,6 +473,7 @@ static inline bool is_kmalloc_cache(struct kmem_cache *s)
 			      SLAB_ACCOUNT | \
 			      SLAB_KMALLOC | \
 			      SLAB_NO_MERGE | \
+			      SLAB_SHEAVES | \
 			      SLAB_NO_USER_FLAGS)
 
 bool __kmem_cache_empty(struct kmem_cache *);
@@ -500,6 +503,25 @@ void slabinfo_show_stats(struct seq_file *m, struct kmem_cache *s);
 ssize_t slabinfo_write(struct file *file, const char __user *buffer,
 		       size_t count, loff_t *ppos);
 
+#ifdef CONFIG_KMALLOC_PROFILING
+DECLARE_STATIC_KEY_FALSE(kmalloc_profiling_key);
+void __kmalloc_profile(unsigned long caller, size_t requested,
+		       size_t allocated);
+
+static __always_inline void kmalloc_profile(unsigned long caller,
+					    const void *ptr, size_t requested,
+					    size_t allocated)
+{
+	if (static_branch_unlikely(&kmalloc_profiling_key) && ptr)
+		__kmalloc_profile(caller, requested, allocated);
+}
+#else
+static inline void kmalloc_profile(unsigned long caller, const void *ptr,
+				   size_t requested, size_t allocated)
+{
+}
+#endif
+
 #ifdef CONFIG_SLUB_DEBUG
 #ifdef CONFIG_SLUB_DEBUG_ON
 DECLARE_STATIC_KEY_TRUE(slub_debug_enabled);
@@ -53,7 +53,7 @@ static DECLARE_WORK(slab_caches_to_rcu_destroy_work,
 		SLAB_FAILSLAB | SLAB_NO_MERGE)
 
 #define SLAB_MERGE_SAME (SLAB_RECLAIM_ACCOUNT | SLAB_CACHE_DMA | \
-			 SLAB_CACHE_DMA32 | SLAB_ACCOUNT)
+			 SLAB_CACHE_DMA32 | SLAB_ACCOUNT | SLAB_SHEAVES)
 
 /*
  * Merge control. If this is set then no merging of slab caches will occur.
@@ -1169,6 +1169,188 @@ module_init(slab_proc_init);
 
 #endif /* CONFIG_SLUB_DEBUG */
 
+#ifdef CONFIG_KMALLOC_PROFILING
+/*
+ * Per callsite accounting of requested versus allocated kmalloc bytes, to
+ * find the callers losing most memory to the rounding up to kmalloc caches.
+ * Callsites are kept in a small open addressing table, the counters are per
+ * cpu and only summed up when /proc/kmallocinfo is read.
+ */
+#define KMALLOC_PROF_BITS	10
+#define KMALLOC_PROF_SITES	(1 << KMALLOC_PROF_BITS)
+#define KMALLOC_PROF_PROBES	8
+#define KMALLOC_PROF_BUCKETS	BITS_PER_LONG
+
+struct kmalloc_prof_stat {
+	unsigned long calls;
+	unsigned long requested;
+	unsigned long allocated;
+};
+
+struct kmalloc_prof_cpu {
+	struct kmalloc_prof_stat site[KMALLOC_PROF_SITES];
+	/* indexed by ilog2() of the allocated size */
+	struct kmalloc_prof_stat bucket[KMALLOC_PROF_BUCKETS];
+};
+
+DEFINE_STATIC_KEY_FALSE(kmalloc_profiling_key);
+
+static unsigned long kmalloc_prof_sites[KMALLOC_PROF_SITES];
+static struct kmalloc_prof_cpu __percpu *kmalloc_prof;
+static atomic_long_t kmalloc_prof_dropped;
+static DEFINE_MUTEX(kmalloc_prof_mutex);
+static bool kmalloc_prof_boot __initdata;
+
+static int __init setup_kmalloc_profiling(char *str)
+{
+	kmalloc_prof_boot = true;
+	return 1;
+}
+__setup("kmalloc_profiling", setup_kmalloc_profiling);
+
+void __kmalloc_profile(unsigned long caller, size_t requested,
+		       size_t allocated)
+{
+	unsigned int slot = hash_long(caller, KMALLOC_PROF_BITS);
+	unsigned int bucket = ilog2(allocated);
+	int i;
+
+	this_cpu_inc(kmalloc_prof->bucket[bucket].calls);
+	this_cpu_add(kmalloc_prof->bucket[bucket].requested, requested);
+	this_cpu_add(kmalloc_prof->bucket[bucket].allocated, allocated);
+
+	for (i = 0; i < KMALLOC_PROF_PROBES; i++) {
+		unsigned long ip = READ_ONCE(kmalloc_prof_sites[slot]);
+
+		if (!ip)
+			ip = cmpxchg(&kmalloc_prof_sites[slot], 0, caller) ? : caller;
+		if (ip == caller) {
+			this_cpu_inc(kmalloc_prof->site[slot].calls);
+			this_cpu_add(kmalloc_prof->site[slot].requested, requested);
+			this_cpu_add(kmalloc_prof->site[slot].allocated, allocated);
+			return;
+		}
+		slot = (slot + 1) & (KMALLOC_PROF_SITES - 1);
+	}
+
+	atomic_long_inc(&kmalloc_prof_dropped);
+}
+
+static void kmalloc_prof_sum(struct kmalloc_prof_stat *sum, size_t offset)
+{
+	int cpu;
+
+	memset(sum, 0, sizeof(*sum));
+
+	for_each_possible_cpu(cpu) {
+		struct kmalloc_prof_stat *stat;
+
+		stat = (void *)per_cpu_ptr(kmalloc_prof, cpu) + offset;
+		sum->calls += READ_ONCE(stat->calls);
+		sum->requested += READ_ONCE(stat->requested);
+		sum->allocated += READ_ONCE(stat->allocated);
+	}
+}
+
+static int kmallocinfo_show(struct seq_file *m, void *v)
+{
+	struct kmalloc_prof_stat sum;
+	int i;
+
+	seq_printf(m, "profiling: %s dropped: %ld\n",
+		   static_key_enabled(&kmalloc_profiling_key) ? "on" : "off",
+		   atomic_long_read(&kmalloc_prof_dropped));
+
+	if (!kmalloc_prof)
+		return 0;
+
+	seq_printf(m, "%-12s %14s %16s %16s %16s\n", "# size",
+		   "calls", "requested", "allocated", "wasted");
+	for (i = 0; i < KMALLOC_PROF_BUCKETS; i++) {
+		kmalloc_prof_sum(&sum, offsetof(struct kmalloc_prof_cpu, bucket[i]));
+		if (!sum.calls)
+			continue;
+		seq_printf(m, "%-12lu %14lu %16lu %16lu %16lu\n", 1UL << i,
+			   sum.calls, sum.requested, sum.allocated,
+			   sum.allocated - sum.requested);
+	}
+
+	seq_printf(m, "%-12s %14s %16s %16s %16s\n", "# callsite",
+		   "calls", "requested", "allocated", "wasted");
+	for (i = 0; i < KMALLOC_PROF_SITES; i++) {
+		unsigned long ip = READ_ONCE(kmalloc_prof_sites[i]);
+
+		if (!ip)
+			continue;
+		kmalloc_prof_sum(&sum, offsetof(struct kmalloc_prof_cpu, site[i]));
+		seq_printf(m, "%-12s %14lu %16lu %16lu %16lu %pS\n", "",
+			   sum.calls, sum.requested, sum.allocated,
+			   sum.allocated - sum.requested, (void *)ip);
+	}
+
+	return 0;
+}
+
+static int kmalloc_prof_set(bool enable)
+{
+	int ret = 0;
+
+	mutex_lock(&kmalloc_prof_mutex);
+	if (enable && !kmalloc_prof) {
+		/* never freed, the static key may still have callers in flight */
+		kmalloc_prof = alloc_percpu(struct kmalloc_prof_cpu);
+		if (!kmalloc_prof)
+			ret = -ENOMEM;
+	}
+	if (!ret) {
+		if (enable)
+			static_branch_enable(&kmalloc_profiling_key);
+		else
+			static_branch_disable(&kmalloc_profiling_key);
+	}
+	mutex_unlock(&kmalloc_prof_mutex);
+
+	return ret;
+}
+
+static ssize_t kmallocinfo_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(buf, count, &enable);
+	if (ret)
+		return ret;
+
+	ret = kmalloc_prof_set(enable);
+
+	return ret ? : count;
+}
+
+static int kmallocinfo_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, kmallocinfo_show, NULL);
+}
+
+static const struct proc_ops kmallocinfo_proc_ops = {
+	.proc_open	= kmallocinfo_open,
+	.proc_read	= seq_read,
+	.proc_write	= kmallocinfo_write,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+};
+
+static int __init kmalloc_prof_init(void)
+{
+	proc_create("kmallocinfo", 0600, NULL, &kmallocinfo_proc_ops);
+	if (kmalloc_prof_boot)
+		kmalloc_prof_set(true);
+	return 0;
+}
+late_initcall(kmalloc_prof_init);
+#endif /* CONFIG_KMALLOC_PROFILING */
+
 static __always_inline __realloc_size(2) void *
 __do_krealloc(const void *p, size_t new_size, gfp_t flags)
 {
@@ -373,6 +373,11 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	ALLOC_PCS,		/* Allocation from percpu sheaf */
+	FREE_PCS,		/* Free to percpu sheaf */
+	BARN_GET,		/* Full sheaf taken from the barn */
+	BARN_PUT,		/* Full sheaf put to the barn */
+	SHEAF_FLUSH,		/* Objects flushed from a sheaf to slabs */
 	NR_SLUB_STAT_ITEMS
 };
 
@@ -398,6 +403,36 @@ struct kmem_cache_cpu {
 	unsigned int stat[NR_SLUB_STAT_ITEMS];
 #endif
 };
+
+/*
+ * Sheaves are arrays of free objects that caches created with SLAB_SHEAVES
+ * keep per cpu, in front of the cpu slab. Alloc and free only move a pointer
+ * in and out of the array, regardless of which slab the object belongs to,
+ * so frees of objects allocated on other cpus avoid the cmpxchg on the slab
+ * freelist. Full and empty sheaves are exchanged with a per-node barn.
+ */
+#define SHEAF_CAPACITY		32
+#define BARN_MAX_SHEAVES	16
+
+struct slab_sheaf {
+	struct list_head barn_list;
+	unsigned int size;
+	void *objects[SHEAF_CAPACITY];
+};
+
+struct slub_percpu_sheaves {
+	local_lock_t lock;
+	struct slab_sheaf *main;	/* never NULL when sheaves are enabled */
+	struct slab_sheaf *spare;	/* empty or full, may be NULL */
+};
+
+struct node_barn {
+	spinlock_t lock;
+	struct list_head sheaves_full;
+	struct list_head sheaves_empty;
+	unsigned int nr_full;
+	unsigned int nr_empty;
+};
 #endif /* CONFIG_SLUB_TINY */
 
 static inline void stat(const struct kmem_cache *s, enum stat_item si)
@@ -431,6 +466,9 @@ struct kmem_cache_node {
 	atomic_long_t total_objects;
 	struct list_head full;
 #endif
+#ifndef CONFIG_SLUB_TINY
+	struct node_barn barn;
+#endif
 };
 
 static inline struct kmem_cache_node *get_node(struct kmem_cache *s, int node)
@@ -2996,6 +3034,315 @@ static inline void put_partials_cpu(struct kmem_cache *s,
 
 #endif	/* CONFIG_SLUB_CPU_PARTIAL */
 
+static void __kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p);
+
+static struct node_barn *get_barn(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n = get_node(s, numa_mem_id());
+
+	return n ? &n->barn : NULL;
+}
+
+static struct slab_sheaf *alloc_empty_sheaf(gfp_t gfp)
+{
+	return kzalloc(sizeof(struct slab_sheaf), gfp);
+}
+
+/* Return the objects of a sheaf to their slabs, leaving it empty */
+static void sheaf_flush(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+	if (!sheaf->size)
+		return;
+
+	stat_add(s, SHEAF_FLUSH, sheaf->size);
+	__kmem_cache_free_bulk(s, sheaf->size, &sheaf->objects[0]);
+	sheaf->size = 0;
+}
+
+static void barn_shrink(struct kmem_cache *s, struct node_barn *barn)
+{
+	struct slab_sheaf *sheaf, *next;
+	unsigned long flags;
+	LIST_HEAD(full);
+	LIST_HEAD(empty);
+
+	spin_lock_irqsave(&barn->lock, flags);
+	list_splice_init(&barn->sheaves_full, &full);
+	list_splice_init(&barn->sheaves_empty, &empty);
+	barn->nr_full = 0;
+	barn->nr_empty = 0;
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	list_for_each_entry_safe(sheaf, next, &full, barn_list) {
+		sheaf_flush(s, sheaf);
+		kfree(sheaf);
+	}
+
+	list_for_each_entry_safe(sheaf, next, &empty, barn_list)
+		kfree(sheaf);
+}
+
+static void flush_all_barns(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n;
+	int node;
+
+	if (!s->cpu_sheaves)
+		return;
+
+	for_each_kmem_cache_node(s, node, n)
+		barn_shrink(s, &n->barn);
+}
+
+/*
+ * Flush the sheaves of a cpu. The caller has to make sure the cpu does not
+ * use them concurrently, by holding the local lock or because it is dead.
+ */
+static void __pcs_flush_cpu(struct kmem_cache *s, int cpu)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	sheaf_flush(s, pcs->main);
+	if (pcs->spare)
+		sheaf_flush(s, pcs->spare);
+}
+
+static void pcs_flush(struct kmem_cache *s)
+{
+	unsigned long flags;
+
+	if (!s->cpu_sheaves)
+		return;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	__pcs_flush_cpu(s, smp_processor_id());
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+}
+
+static bool pcs_has_objects(int cpu, struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs;
+
+	if (!s->cpu_sheaves)
+		return false;
+
+	pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	return pcs->main->size || (pcs->spare && pcs->spare->size);
+}
+
+/*
+ * The main sheaf is empty: swap in a full spare or get a full sheaf from the
+ * barn. Called with the local lock held, returns false if no objects are
+ * cached on this cpu or node.
+ */
+static bool __pcs_replace_empty_main(struct kmem_cache *s,
+				     struct slub_percpu_sheaves *pcs)
+{
+	struct slab_sheaf *full, *to_free = NULL;
+	struct node_barn *barn;
+
+	if (pcs->spare && pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return true;
+	}
+
+	barn = get_barn(s);
+	if (!barn || !READ_ONCE(barn->nr_full))
+		return false;
+
+	spin_lock(&barn->lock);
+	if (!barn->nr_full) {
+		spin_unlock(&barn->lock);
+		return false;
+	}
+
+	full = list_first_entry(&barn->sheaves_full, struct slab_sheaf,
+				barn_list);
+	list_del(&full->barn_list);
+	barn->nr_full--;
+
+	if (!pcs->spare) {
+		pcs->spare = pcs->main;
+	} else if (barn->nr_empty < BARN_MAX_SHEAVES) {
+		list_add(&pcs->main->barn_list, &barn->sheaves_empty);
+		barn->nr_empty++;
+	} else {
+		to_free = pcs->main;
+	}
+	spin_unlock(&barn->lock);
+
+	pcs->main = full;
+	kfree(to_free);
+	stat(s, BARN_GET);
+
+	return true;
+}
+
+/*
+ * The main sheaf is full: swap in an empty spare, or hand a full sheaf to the
+ * barn in exchange for an empty one. If the barn already holds enough full
+ * sheaves, return the objects of the main sheaf to their slabs in one go.
+ * Called with the local lock held.
+ */
+static void __pcs_replace_full_main(struct kmem_cache *s,
+				    struct slub_percpu_sheaves *pcs)
+{
+	struct slab_sheaf *empty = NULL;
+	struct node_barn *barn;
+
+	if (pcs->spare && !pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return;
+	}
+
+	barn = get_barn(s);
+	if (!barn)
+		goto flush;
+
+	spin_lock(&barn->lock);
+	if (pcs->spare && barn->nr_full >= BARN_MAX_SHEAVES) {
+		spin_unlock(&barn->lock);
+		goto flush;
+	}
+
+	if (barn->nr_empty) {
+		empty = list_first_entry(&barn->sheaves_empty,
+					 struct slab_sheaf, barn_list);
+		list_del(&empty->barn_list);
+		barn->nr_empty--;
+	}
+	spin_unlock(&barn->lock);
+
+	if (!empty)
+		empty = alloc_empty_sheaf(GFP_NOWAIT | __GFP_NOWARN);
+	if (!empty)
+		goto flush;
+
+	if (!pcs->spare) {
+		pcs->spare = pcs->main;
+	} else {
+		spin_lock(&barn->lock);
+		list_add(&pcs->main->barn_list, &barn->sheaves_full);
+		barn->nr_full++;
+		spin_unlock(&barn->lock);
+		stat(s, BARN_PUT);
+	}
+	pcs->main = empty;
+	return;
+
+flush:
+	sheaf_flush(s, pcs->main);
+}
+
+static __fastpath_inline void *alloc_from_pcs(struct kmem_cache *s, int node)
+{
+	struct slub_percpu_sheaves *pcs;
+	unsigned long flags;
+	void *object;
+
+	if (!s->cpu_sheaves)
+		return NULL;
+
+	/* Sheaves only hold objects from the local node */
+	if (node != NUMA_NO_NODE && node != numa_mem_id())
+		return NULL;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(!pcs->main->size) && !__pcs_replace_empty_main(s, pcs)) {
+		local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+		return NULL;
+	}
+
+	object = pcs->main->objects[--pcs->main->size];
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	stat(s, ALLOC_PCS);
+
+	return object;
+}
+
+static __fastpath_inline bool free_to_pcs(struct kmem_cache *s,
+					  struct slab *slab, void *object)
+{
+	struct slub_percpu_sheaves *pcs;
+	unsigned long flags;
+
+	if (!s->cpu_sheaves)
+		return false;
+
+	/*
+	 * Remote node objects go back to their slabs so that sheaves keep
+	 * allocations node local, and pfmemalloc objects so they are not
+	 * handed out to allocations without access to the reserves.
+	 */
+	if (unlikely(slab_nid(slab) != numa_mem_id() ||
+		     slab_test_pfmemalloc(slab)))
+		return false;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(pcs->main->size == SHEAF_CAPACITY))
+		__pcs_replace_full_main(s, pcs);
+
+	pcs->main->objects[pcs->main->size++] = object;
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	stat(s, FREE_PCS);
+
+	return true;
+}
+
+static int init_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	if (!(s->flags & SLAB_SHEAVES))
+		return 0;
+
+	/* Debugging needs every free to reach the slab */
+	if (kmem_cache_debug(s) || slab_state < UP) {
+		s->flags &= ~SLAB_SHEAVES;
+		return 0;
+	}
+
+	s->cpu_sheaves = alloc_percpu(struct slub_percpu_sheaves);
+	if (!s->cpu_sheaves)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		local_lock_init(&pcs->lock);
+		pcs->main = alloc_empty_sheaf(GFP_KERNEL);
+		if (!pcs->main)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void free_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	if (!s->cpu_sheaves)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		kfree(pcs->main);
+		kfree(pcs->spare);
+	}
+
+	free_percpu(s->cpu_sheaves);
+	s->cpu_sheaves = NULL;
+}
+
 static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 {
 	unsigned long flags;
@@ -3025,6 +3372,9 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 	void *freelist = c->freelist;
 	struct slab *slab = c->slab;
 
+	if (s->cpu_sheaves)
+		__pcs_flush_cpu(s, cpu);
+
 	c->slab = NULL;
 	c->freelist = NULL;
 	c->tid = next_tid(c->tid);
@@ -3057,6 +3407,10 @@ static void flush_cpu_slab(struct work_struct *w)
 	sfw = container_of(w, struct slub_flush_work, work);
 
 	s = sfw->s;
+
+	/* Sheaves first, their objects may land in the cpu slab */
+	pcs_flush(s);
+
 	c = this_cpu_ptr(s->cpu_slab);
 
 	if (c->slab)
@@ -3069,7 +3423,7 @@ static bool has_cpu_slab(int cpu, struct kmem_cache *s)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
-	return c->slab || slub_percpu_partial(c);
+	return c->slab || slub_percpu_partial(c) || pcs_has_objects(cpu, s);
 }
 
 static DEFINE_MUTEX(flush_lock);
@@ -3083,6 +3437,9 @@ static void flush_all_cpus_locked(struct kmem_cache *s)
 	lockdep_assert_cpus_held();
 	mutex_lock(&flush_lock);
 
+	/* Before the cpus, objects freed from the barns may go to cpu slabs */
+	flush_all_barns(s);
+
 	for_each_online_cpu(cpu) {
 		sfw = &per_cpu(slub_flush, cpu);
 		if (!has_cpu_slab(cpu, s)) {
@@ -3132,6 +3489,11 @@ static inline void flush_all_cpus_locked(struct kmem_cache *s) { }
 static inline void flush_all(struct kmem_cache *s) { }
 static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu) { }
 static inline int slub_cpu_dead(unsigned int cpu) { return 0; }
+static inline void *alloc_from_pcs(struct kmem_cache *s, int node) { return NULL; }
+static inline bool free_to_pcs(struct kmem_cache *s, struct slab *slab,
+			       void *object) { return false; }
+static inline int init_percpu_sheaves(struct kmem_cache *s) { return 0; }
+static inline void free_percpu_sheaves(struct kmem_cache *s) { }
 #endif /* CONFIG_SLUB_TINY */
 
 /*
@@ -3838,7 +4200,9 @@ static __fastpath_inline void *slab_alloc_node(struct kmem_cache *s, struct list
 	if (unlikely(object))
 		goto out;
 
-	object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
+	object = alloc_from_pcs(s, node);
+	if (!object)
+		object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
 
 	maybe_wipe_obj_freeptr(s, object);
 	init = slab_want_init_on_alloc(gfpflags, s);
@@ -3935,6 +4299,7 @@ void *kmalloc_large(size_t size, gfp_t flags)
 
 	trace_kmalloc(_RET_IP_, ret, size, PAGE_SIZE << get_order(size),
 		      flags, NUMA_NO_NODE);
+	kmalloc_profile(_RET_IP_, ret, size, PAGE_SIZE << get_order(size));
 	return ret;
 }
 EXPORT_SYMBOL(kmalloc_large);
@@ -3945,6 +4310,7 @@ void *kmalloc_large_node(size_t size, gfp_t flags, int node)
 
 	trace_kmalloc(_RET_IP_, ret, size, PAGE_SIZE << get_order(size),
 		      flags, node);
+	kmalloc_profile(_RET_IP_, ret, size, PAGE_SIZE << get_order(size));
 	return ret;
 }
 EXPORT_SYMBOL(kmalloc_large_node);
@@ -3960,6 +4326,7 @@ void *__do_kmalloc_node(size_t size, gfp_t flags, int node,
 		ret = __kmalloc_large_node(size, flags, node);
 		trace_kmalloc(caller, ret, size,
 			      PAGE_SIZE << get_order(size), flags, node);
+		kmalloc_profile(caller, ret, size, PAGE_SIZE << get_order(size));
 		return ret;
 	}
 
@@ -3971,6 +4338,7 @@ void *__do_kmalloc_node(size_t size, gfp_t flags, int node,
 	ret = slab_alloc_node(s, NULL, flags, node, caller, size);
 	ret = kasan_kmalloc(s, ret, size, flags);
 	trace_kmalloc(caller, ret, size, s->size, flags, node);
+	kmalloc_profile(caller, ret, size, s->size);
 	return ret;
 }
 
@@ -3999,6 +4367,7 @@ void *kmalloc_trace(struct kmem_cache *s, gfp_t gfpflags, size_t size)
 					    _RET_IP_, size);
 
 	trace_kmalloc(_RET_IP_, ret, size, s->size, gfpflags, NUMA_NO_NODE);
+	kmalloc_profile(_RET_IP_, ret, size, s->size);
 
 	ret = kasan_kmalloc(s, ret, size, gfpflags);
 	return ret;
@@ -4011,6 +4380,7 @@ void *kmalloc_node_trace(struct kmem_cache *s, gfp_t gfpflags,
 	void *ret = slab_alloc_node(s, NULL, gfpflags, node, _RET_IP_, size);
 
 	trace_kmalloc(_RET_IP_, ret, size, s->size, gfpflags, node);
+	kmalloc_profile(_RET_IP_, ret, size, s->size);
 
 	ret = kasan_kmalloc(s, ret, size, gfpflags);
 	return ret;
@@ -4283,7 +4653,8 @@ void slab_free(struct kmem_cache *s, struct slab *slab, void *object,
 {
 	memcg_slab_free_hook(s, slab, &object, 1);
 
-	if (likely(slab_free_hook(s, object, slab_want_init_on_free(s))))
+	if (likely(slab_free_hook(s, object, slab_want_init_on_free(s))) &&
+	    !free_to_pcs(s, slab, object))
 		do_slab_free(s, slab, object, object, 1, addr);
 }
 
@@ -4793,6 +5164,13 @@ init_kmem_cache_node(struct kmem_cache_node *n)
 	atomic_long_set(&n->total_objects, 0);
 	INIT_LIST_HEAD(&n->full);
 #endif
+#ifndef CONFIG_SLUB_TINY
+	spin_lock_init(&n->barn.lock);
+	INIT_LIST_HEAD(&n->barn.sheaves_full);
+	INIT_LIST_HEAD(&n->barn.sheaves_empty);
+	n->barn.nr_full = 0;
+	n->barn.nr_empty = 0;
+#endif
 }
 
 #ifndef CONFIG_SLUB_TINY
@@ -4883,6 +5261,7 @@ static void free_kmem_cache_nodes(struct kmem_cache *s)
 void __kmem_cache_release(struct kmem_cache *s)
 {
 	cache_random_seq_destroy(s);
+	free_percpu_sheaves(s);
 #ifndef CONFIG_SLUB_TINY
 	free_percpu(s->cpu_slab);
 #endif
@@ -5139,7 +5518,7 @@ static int kmem_cache_open(struct kmem_cache *s, slab_flags_t flags)
 	if (!init_kmem_cache_nodes(s))
 		goto error;
 
-	if (alloc_kmem_cache_cpus(s))
+	if (alloc_kmem_cache_cpus(s) && !init_percpu_sheaves(s))
 		return 0;
 
 error:
@@ -6526,6 +6905,11 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(ALLOC_PCS, alloc_cpu_sheaf);
+STAT_ATTR(FREE_PCS, free_cpu_sheaf);
+STAT_ATTR(BARN_GET, barn_get);
+STAT_ATTR(BARN_PUT, barn_put);
+STAT_ATTR(SHEAF_FLUSH, sheaf_flush);
 #endif	/* CONFIG_SLUB_STATS */
 
 #ifdef CONFIG_KFENCE
@@ -6613,6 +6997,11 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&alloc_cpu_sheaf_attr.attr,
+	&free_cpu_sheaf_attr.attr,
+	&barn_get_attr.attr,
+	&barn_put_attr.attr,
+	&sheaf_flush_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
@@ -16,6 +16,7 @@
 
 #include <linux/mm.h>
 #include <linux/sched.h>
+#include <linux/sched/isolation.h>
 #include <linux/kernel_stat.h>
 #include <linux/swap.h>
 #include <linux/mman.h>
@@ -901,6 +902,14 @@ static inline void __lru_add_drain_all(bool force_all_cpus)
 	for_each_online_cpu(cpu) {
 		struct work_struct *work = &per_cpu(lru_add_drain_work, cpu);
 
+		/*
+		 * The batches can't be drained remotely. In strict isolation
+		 * mode, leave those of isolated CPUs alone unless the caller
+		 * needs them all drained, as lru_cache_disable() does.
+		 */
+		if (!force_all_cpus && cpu_is_isolated_strict(cpu))
+			continue;
+
 		if (cpu_needs_drain(cpu)) {
 			INIT_WORK(work, lru_add_drain_per_cpu);
 			queue_work_on(cpu, mm_percpu_wq, work);
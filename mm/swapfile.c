@@ -558,10 +558,12 @@ static void free_cluster(struct swap_info_struct *si, unsigned long idx)
 
 /*
  * The cluster corresponding to page_nr will be used. The cluster will be
- * removed from free cluster list and its usage counter will be increased.
+ * removed from free cluster list and its usage counter will be increased by
+ * count.
  */
-static void inc_cluster_info_page(struct swap_info_struct *p,
-	struct swap_cluster_info *cluster_info, unsigned long page_nr)
+static void add_cluster_info_page(struct swap_info_struct *p,
+	struct swap_cluster_info *cluster_info, unsigned long page_nr,
+	unsigned long count)
 {
 	unsigned long idx = page_nr / SWAPFILE_CLUSTER;
 
@@ -570,9 +572,21 @@ static void inc_cluster_info_page(struct swap_info_struct *p,
 	if (cluster_is_free(&cluster_info[idx]))
 		alloc_cluster(p, idx);
 
-	VM_BUG_ON(cluster_count(&cluster_info[idx]) >= SWAPFILE_CLUSTER);
+	if (WARN_ON_ONCE(cluster_count(&cluster_info[idx]) + count >
+			 SWAPFILE_CLUSTER))
+		return;
 	cluster_set_count(&cluster_info[idx],
-		cluster_count(&cluster_info[idx]) + 1);
+		cluster_count(&cluster_info[idx]) + count);
+}
+
+/*
+ * The cluster corresponding to page_nr will be used. The cluster will be
+ * removed from free cluster list and its usage counter will be increased by 1.
+ */
+static void inc_cluster_info_page(struct swap_info_struct *p,
+	struct swap_cluster_info *cluster_info, unsigned long page_nr)
+{
+	add_cluster_info_page(p, cluster_info, page_nr, 1);
 }
 
 /*
@@ -602,7 +616,7 @@ static void dec_cluster_info_page(struct swap_info_struct *p,
  */
 static bool
 scan_swap_map_ssd_cluster_conflict(struct swap_info_struct *si,
-	unsigned long offset)
+	unsigned long offset, int order)
 {
 	struct percpu_cluster *percpu_cluster;
 	bool conflict;
@@ -616,27 +630,42 @@ scan_swap_map_ssd_cluster_conflict(struct swap_info_struct *si,
 		return false;
 
 	percpu_cluster = this_cpu_ptr(si->percpu_cluster);
-	cluster_set_null(&percpu_cluster->index);
+	percpu_cluster->next[order] = SWAP_NEXT_INVALID;
+	return true;
+}
+
+static inline bool swap_range_empty(unsigned char *swap_map,
+				    unsigned long start, unsigned int nr_pages)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr_pages; i++) {
+		if (swap_map[start + i])
+			return false;
+	}
+
 	return true;
 }
 
 /*
- * Try to get a swap entry from current cpu's swap entry pool (a cluster). This
- * might involve allocating a new cluster for current CPU too.
+ * Try to get swap entries with specified order from current cpu's swap entry
+ * pool (a cluster). This might involve allocating a new cluster for current CPU
+ * too.
  */
 static bool scan_swap_map_try_ssd_cluster(struct swap_info_struct *si,
-	unsigned long *offset, unsigned long *scan_base)
+	unsigned long *offset, unsigned long *scan_base, int order)
 {
+	unsigned int nr_pages = 1 << order;
 	struct percpu_cluster *cluster;
 	struct swap_cluster_info *ci;
 	unsigned long tmp, max;
 
 new_cluster:
 	cluster = this_cpu_ptr(si->percpu_cluster);
-	if (cluster_is_null(&cluster->index)) {
+	tmp = cluster->next[order];
+	if (tmp == SWAP_NEXT_INVALID) {
 		if (!cluster_list_empty(&si->free_clusters)) {
-			cluster->index = si->free_clusters.head;
-			cluster->next = cluster_next(&cluster->index) *
+			tmp = cluster_next(&si->free_clusters.head) *
 					SWAPFILE_CLUSTER;
 		} else if (!cluster_list_empty(&si->discard_clusters)) {
 			/*
@@ -654,27 +683,27 @@ static bool scan_swap_map_try_ssd_cluster(struct swap_info_struct *si,
 
 	/*
 	 * Other CPUs can use our cluster if they can't find a free cluster,
-	 * check if there is still free entry in the cluster
+	 * check if there is still free entry in the cluster, maintaining
+	 * natural alignment.
 	 */
-	tmp = cluster->next;
-	max = min_t(unsigned long, si->max,
-		    (cluster_next(&cluster->index) + 1) * SWAPFILE_CLUSTER);
+	max = min_t(unsigned long, si->max, ALIGN(tmp + 1, SWAPFILE_CLUSTER));
 	if (tmp < max) {
 		ci = lock_cluster(si, tmp);
 		while (tmp < max) {
-			if (!si->swap_map[tmp])
+			if (swap_range_empty(si->swap_map, tmp, nr_pages))
 				break;
-			tmp++;
+			tmp += nr_pages;
 		}
 		unlock_cluster(ci);
 	}
 	if (tmp >= max) {
-		cluster_set_null(&cluster->index);
+		cluster->next[order] = SWAP_NEXT_INVALID;
 		goto new_cluster;
 	}
-	cluster->next = tmp + 1;
 	*offset = tmp;
 	*scan_base = tmp;
+	tmp += nr_pages;
+	cluster->next[order] = tmp < max ? tmp : SWAP_NEXT_INVALID;
 	return true;
 }
 
@@ -839,7 +868,7 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 
 	/* SSD algorithm */
 	if (si->cluster_info) {
-		if (!scan_swap_map_try_ssd_cluster(si, &offset, &scan_base))
+		if (!scan_swap_map_try_ssd_cluster(si, &offset, &scan_base, 0))
 			goto scan;
 	} else if (unlikely(!si->cluster_nr--)) {
 		if (si->pages - si->inuse_pages < SWAPFILE_CLUSTER) {
@@ -882,12 +911,12 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 
 checks:
 	if (si->cluster_info) {
-		while (scan_swap_map_ssd_cluster_conflict(si, offset)) {
+		while (scan_swap_map_ssd_cluster_conflict(si, offset, 0)) {
 		/* take a break if we already got some slots */
 			if (n_ret)
 				goto done;
 			if (!scan_swap_map_try_ssd_cluster(si, &offset,
-							&scan_base))
+							&scan_base, 0))
 				goto scan;
 		}
 	}
@@ -944,7 +973,7 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 
 	/* try to get more slots in cluster */
 	if (si->cluster_info) {
-		if (scan_swap_map_try_ssd_cluster(si, &offset, &scan_base))
+		if (scan_swap_map_try_ssd_cluster(si, &offset, &scan_base, 0))
 			goto checks;
 	} else if (si->cluster_nr && !si->swap_map[++offset]) {
 		/* non-ssd case, still more slots in cluster? */
@@ -1005,6 +1034,97 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 	return n_ret;
 }
 
+/*
+ * Find a naturally aligned run of 1 << order free entries on a device
+ * without cluster info, starting from si->cluster_next so that swap-out stays
+ * mostly sequential. si->lock is held, which serializes all swap_map updates
+ * on such devices, and it is not dropped, so the search is bounded.
+ */
+static bool scan_swap_map_try_range(struct swap_info_struct *si,
+	unsigned long *offset, int order)
+{
+	unsigned int nr_pages = 1 << order;
+	unsigned long lowest = ALIGN(si->lowest_bit, nr_pages);
+	unsigned long start, tmp;
+	int latency_ration = LATENCY_LIMIT;
+	bool wrapped = false;
+
+	start = ALIGN(max_t(unsigned long, si->cluster_next, lowest), nr_pages);
+	tmp = start;
+	for (;;) {
+		if (wrapped && tmp >= start)
+			return false;
+		if (tmp + nr_pages - 1 > si->highest_bit) {
+			if (wrapped)
+				return false;
+			wrapped = true;
+			tmp = lowest;
+			continue;
+		}
+		if (swap_range_empty(si->swap_map, tmp, nr_pages)) {
+			*offset = tmp;
+			si->cluster_next = tmp + nr_pages;
+			return true;
+		}
+		if (--latency_ration < 0)
+			return false;
+		tmp += nr_pages;
+	}
+}
+
+/*
+ * Allocate one naturally aligned run of 1 << order entries smaller than a
+ * cluster, so that a large folio can be swapped out without being split.
+ * SSDs take the run from the per-cpu cluster for that order, other block
+ * devices search for it near the current allocation point.
+ */
+static int scan_swap_map_large(struct swap_info_struct *si,
+			       unsigned char usage, swp_entry_t *slot,
+			       int order)
+{
+	unsigned int nr_pages = 1 << order;
+	struct swap_cluster_info *ci;
+	unsigned long offset, scan_base;
+	int n_ret = 0;
+
+	if (!IS_ENABLED(CONFIG_THP_SWAP) || nr_pages >= SWAPFILE_CLUSTER) {
+		VM_WARN_ON_ONCE(1);
+		return 0;
+	}
+
+	/* Large entries of a swapfile may not be contiguous on disk */
+	if (!(si->flags & SWP_BLKDEV))
+		return 0;
+
+	si->flags += SWP_SCANNING;
+	if (si->cluster_info) {
+		offset = scan_base = this_cpu_read(*si->cluster_next_cpu);
+		do {
+			if (!scan_swap_map_try_ssd_cluster(si, &offset,
+							   &scan_base, order))
+				goto out;
+		} while (scan_swap_map_ssd_cluster_conflict(si, offset, order));
+	} else if (!scan_swap_map_try_range(si, &offset, order)) {
+		goto out;
+	}
+
+	/* si->lock may have been dropped while discarding clusters */
+	if (!(si->flags & SWP_WRITEOK))
+		goto out;
+
+	ci = lock_cluster(si, offset);
+	memset(si->swap_map + offset, usage, nr_pages);
+	add_cluster_info_page(si, si->cluster_info, offset, nr_pages);
+	unlock_cluster(ci);
+
+	swap_range_alloc(si, offset, nr_pages);
+	*slot = swp_entry(si->type, offset);
+	n_ret = 1;
+out:
+	si->flags -= SWP_SCANNING;
+	return n_ret;
+}
+
 static int swap_alloc_cluster(struct swap_info_struct *si, swp_entry_t *slot)
 {
 	unsigned long idx;
@@ -1058,8 +1178,8 @@ int get_swap_pages(int n_goal, swp_entry_t swp_entries[], int entry_size)
 	int n_ret = 0;
 	int node;
 
-	/* Only single cluster request supported */
-	WARN_ON_ONCE(n_goal > 1 && size == SWAPFILE_CLUSTER);
+	/* Only single large entry request supported */
+	WARN_ON_ONCE(n_goal > 1 && size > 1);
 
 	spin_lock(&swap_avail_lock);
 
@@ -1099,11 +1219,14 @@ int get_swap_pages(int n_goal, swp_entry_t swp_entries[], int entry_size)
 		if (size == SWAPFILE_CLUSTER) {
 			if (si->flags & SWP_BLKDEV)
 				n_ret = swap_alloc_cluster(si, swp_entries);
-		} else
+		} else if (size > 1)
+			n_ret = scan_swap_map_large(si, SWAP_HAS_CACHE,
+						    swp_entries, ilog2(size));
+		else
 			n_ret = scan_swap_map_slots(si, SWAP_HAS_CACHE,
 						    n_goal, swp_entries);
 		spin_unlock(&si->lock);
-		if (n_ret || size == SWAPFILE_CLUSTER)
+		if (n_ret || size > 1)
 			goto check_out;
 		cond_resched();
 
@@ -1518,11 +1641,17 @@ int swp_swapcount(swp_entry_t entry)
 	return count;
 }
 
+/*
+ * Check whether any of the entries backing a large folio of 1 << order pages
+ * containing @entry is still referenced. Entries of a huge cluster are always
+ * checked as a whole.
+ */
 static bool swap_page_trans_huge_swapped(struct swap_info_struct *si,
-					 swp_entry_t entry)
+					 swp_entry_t entry, int order)
 {
 	struct swap_cluster_info *ci;
 	unsigned char *map = si->swap_map;
+	unsigned int nr_pages = 1 << order;
 	unsigned long roffset = swp_offset(entry);
 	unsigned long offset = round_down(roffset, SWAPFILE_CLUSTER);
 	int i;
@@ -1530,8 +1659,13 @@ static bool swap_page_trans_huge_swapped(struct swap_info_struct *si,
 
 	ci = lock_cluster_or_swap_info(si, offset);
 	if (!ci || !cluster_is_huge(ci)) {
-		if (swap_count(map[roffset]))
-			ret = true;
+		roffset = round_down(roffset, nr_pages);
+		for (i = 0; i < nr_pages; i++) {
+			if (swap_count(map[roffset + i])) {
+				ret = true;
+				break;
+			}
+		}
 		goto unlock_out;
 	}
 	for (i = 0; i < SWAPFILE_CLUSTER; i++) {
@@ -1556,7 +1690,7 @@ static bool folio_swapped(struct folio *folio)
 	if (!IS_ENABLED(CONFIG_THP_SWAP) || likely(!folio_test_large(folio)))
 		return swap_swapcount(si, entry) != 0;
 
-	return swap_page_trans_huge_swapped(si, entry);
+	return swap_page_trans_huge_swapped(si, entry, folio_order(folio));
 }
 
 /**
@@ -1623,7 +1757,7 @@ int free_swap_and_cache(swp_entry_t entry)
 
 		count = __swap_entry_free(p, entry);
 		if (count == SWAP_HAS_CACHE &&
-		    !swap_page_trans_huge_swapped(p, entry))
+		    !swap_page_trans_huge_swapped(p, entry, 0))
 			__try_to_reclaim_swap(p, swp_offset(entry),
 					      TTRS_UNMAPPED | TTRS_FULL);
 		put_swap_device(p);
@@ -3097,7 +3231,7 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 		p->flags |= SWP_SYNCHRONOUS_IO;
 
 	if (p->bdev && bdev_nonrot(p->bdev)) {
-		int cpu;
+		int cpu, i;
 		unsigned long ci, nr_cluster;
 
 		p->flags |= SWP_SOLIDSTATE;
@@ -3133,8 +3267,10 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 		}
 		for_each_possible_cpu(cpu) {
 			struct percpu_cluster *cluster;
+
 			cluster = per_cpu_ptr(p->percpu_cluster, cpu);
-			cluster_set_null(&cluster->index);
+			for (i = 0; i < SWAP_NR_ORDERS; i++)
+				cluster->next[i] = SWAP_NEXT_INVALID;
 		}
 	} else {
 		atomic_inc(&nr_rotate_swap);
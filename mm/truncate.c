@@ -459,6 +459,7 @@ void truncate_inode_pages_final(struct address_space *mapping)
 	 * final truncate has begun.
 	 */
 	mapping_set_exiting(mapping);
+	mapping->ra_hint = 0;
 
 	if (!mapping_empty(mapping)) {
 		/*
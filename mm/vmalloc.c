@@ -892,6 +892,24 @@ static struct vmap_node *vmap_nodes = &single;
 static __read_mostly unsigned int nr_vmap_nodes = 1;
 static __read_mostly unsigned int vmap_zone_size = 1;
 
+/*
+ * Small VAs, such as vmapped stacks or BPF programs, are recycled at a
+ * high rate. Each CPU keeps a few of them per size in front of its node
+ * pool, so that the node's pool_lock, which is shared by all CPUs mapped
+ * to that node, is taken once per batch instead of once per allocation.
+ * A per-CPU cache is only ever filled from, and drained to, the node its
+ * CPU maps to.
+ */
+#define VMAP_PCP_CLASSES 8
+#define VMAP_PCP_BATCH 4
+
+struct vmap_pcp_cache {
+	spinlock_t lock;
+	struct vmap_pool pool[VMAP_PCP_CLASSES];
+};
+
+static DEFINE_PER_CPU(struct vmap_pcp_cache, vmap_pcp_cache);
+
 static inline unsigned int
 addr_to_node_id(unsigned long addr)
 {
@@ -1898,12 +1916,93 @@ node_pool_del_va(struct vmap_node *vn, unsigned long size,
 	return va;
 }
 
+static struct vmap_area *
+pcp_pool_del_va(unsigned int cpu, struct vmap_node *vn, unsigned long size,
+		unsigned long align, unsigned long vstart,
+		unsigned long vend)
+{
+	unsigned int idx = (size - 1) / PAGE_SIZE;
+	struct vmap_pcp_cache *pcp;
+	struct vmap_area *va, *n;
+	struct vmap_pool *vp;
+
+	if (idx >= VMAP_PCP_CLASSES)
+		return node_pool_del_va(vn, size, align, vstart, vend);
+
+	pcp = per_cpu_ptr(&vmap_pcp_cache, cpu);
+	vp = &pcp->pool[idx];
+
+	spin_lock(&pcp->lock);
+	if (list_empty(&vp->head) && !list_empty(&vn->pool[idx].head)) {
+		/* Refill a batch under one pool_lock hold. */
+		spin_lock(&vn->pool_lock);
+		list_for_each_entry_safe(va, n, &vn->pool[idx].head, list) {
+			list_move_tail(&va->list, &vp->head);
+			WRITE_ONCE(vn->pool[idx].len, vn->pool[idx].len - 1);
+
+			if (++vp->len == VMAP_PCP_BATCH)
+				break;
+		}
+		spin_unlock(&vn->pool_lock);
+	}
+
+	va = list_first_entry_or_null(&vp->head, struct vmap_area, list);
+	if (va) {
+		if (IS_ALIGNED(va->va_start, align) &&
+				!WARN_ON_ONCE(va_size(va) != size ||
+					va->va_start < vstart || va->va_end > vend)) {
+			list_del_init(&va->list);
+			vp->len--;
+		} else {
+			va = NULL;
+		}
+	}
+	spin_unlock(&pcp->lock);
+
+	return va;
+}
+
+static void
+pcp_pool_drain(unsigned int cpu)
+{
+	struct vmap_pcp_cache *pcp = per_cpu_ptr(&vmap_pcp_cache, cpu);
+	struct vmap_node *vn = id_to_node(cpu);
+	int i;
+
+	spin_lock(&pcp->lock);
+	for (i = 0; i < VMAP_PCP_CLASSES; i++) {
+		if (!pcp->pool[i].len)
+			continue;
+
+		spin_lock(&vn->pool_lock);
+		list_splice_init(&pcp->pool[i].head, &vn->pool[i].head);
+		WRITE_ONCE(vn->pool[i].len, vn->pool[i].len + pcp->pool[i].len);
+		spin_unlock(&vn->pool_lock);
+
+		pcp->pool[i].len = 0;
+	}
+	spin_unlock(&pcp->lock);
+}
+
+static void
+pcp_pool_drain_all(void)
+{
+	unsigned int cpu;
+
+	if (nr_vmap_nodes == 1)
+		return;
+
+	for_each_possible_cpu(cpu)
+		pcp_pool_drain(cpu);
+}
+
 static struct vmap_area *
 node_alloc(unsigned long size, unsigned long align,
 		unsigned long vstart, unsigned long vend,
 		unsigned long *addr, unsigned int *vn_id)
 {
 	struct vmap_area *va;
+	unsigned int cpu;
 
 	*vn_id = 0;
 	*addr = vend;
@@ -1916,8 +2015,9 @@ node_alloc(unsigned long size, unsigned long align,
 			nr_vmap_nodes == 1)
 		return NULL;
 
-	*vn_id = raw_smp_processor_id() % nr_vmap_nodes;
-	va = node_pool_del_va(id_to_node(*vn_id), size, align, vstart, vend);
+	cpu = raw_smp_processor_id();
+	*vn_id = cpu % nr_vmap_nodes;
+	va = pcp_pool_del_va(cpu, id_to_node(*vn_id), size, align, vstart, vend);
 	*vn_id = encode_vn_id(*vn_id);
 
 	if (va)
@@ -2216,6 +2316,10 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 	 */
 	purge_nodes = CPU_MASK_NONE;
 
+	/* Hand cached VAs back to their nodes, so they can be released. */
+	if (full_pool_decay)
+		pcp_pool_drain_all();
+
 	for (i = 0; i < nr_vmap_nodes; i++) {
 		vn = &vmap_nodes[i];
 
@@ -5062,6 +5166,8 @@ vmap_node_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 {
 	int i;
 
+	pcp_pool_drain_all();
+
 	for (i = 0; i < nr_vmap_nodes; i++)
 		decay_va_pool_node(&vmap_nodes[i], true);
 
@@ -5082,8 +5188,10 @@ void __init vmalloc_init(void)
 	vmap_area_cachep = KMEM_CACHE(vmap_area, SLAB_PANIC);
 
 	for_each_possible_cpu(i) {
+		struct vmap_pcp_cache *pcp;
 		struct vmap_block_queue *vbq;
 		struct vfree_deferred *p;
+		int j;
 
 		vbq = &per_cpu(vmap_block_queue, i);
 		spin_lock_init(&vbq->lock);
@@ -5092,6 +5200,11 @@ void __init vmalloc_init(void)
 		init_llist_head(&p->list);
 		INIT_WORK(&p->wq, delayed_vfree_work);
 		xa_init(&vbq->vmap_blocks);
+
+		pcp = &per_cpu(vmap_pcp_cache, i);
+		spin_lock_init(&pcp->lock);
+		for (j = 0; j < VMAP_PCP_CLASSES; j++)
+			INIT_LIST_HEAD(&pcp->pool[j].head);
 	}
 
 	/*
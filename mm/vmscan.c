@@ -1205,11 +1205,13 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 					if (!can_split_folio(folio, NULL))
 						goto activate_locked;
 					/*
-					 * Split folios without a PMD map right
+					 * Split partially mapped folios right
 					 * away. Chances are some or all of the
 					 * tail pages can be freed without IO.
+					 * Fully mapped ones are swapped out
+					 * whole if swap has room for them.
 					 */
-					if (!folio_entire_mapcount(folio) &&
+					if (data_race(!list_empty(&folio->_deferred_list)) &&
 					    split_folio_to_list(folio,
 								folio_list))
 						goto activate_locked;
@@ -3826,12 +3828,98 @@ static bool inc_max_seq(struct lruvec *lruvec, unsigned long seq,
 	return success;
 }
 
+/*
+ * Aging workers walk the mm_list alongside the reclaimer that started an
+ * iteration, each taking the next mm from mm_state->head the same way
+ * concurrent reclaimers do, and recording into the same Bloom filters.
+ */
+#define MAX_AGING_WORKERS	8
+
+struct lru_gen_aging_worker {
+	struct work_struct work;
+	struct lru_gen_mm_walk walk;
+	/* whether this worker ended the iteration */
+	bool last;
+};
+
+struct lru_gen_aging {
+	/* held by the reclaimer the workers are helping */
+	unsigned long busy;
+	struct lru_gen_aging_worker workers[MAX_AGING_WORKERS];
+};
+
+static unsigned int lru_gen_aging_workers __read_mostly;
+static struct lru_gen_aging *lru_gen_aging[MAX_NUMNODES];
+static struct workqueue_struct *lru_gen_aging_wq;
+
+static void lru_gen_aging_work(struct work_struct *work)
+{
+	struct lru_gen_aging_worker *worker =
+		container_of(work, struct lru_gen_aging_worker, work);
+	struct mm_struct *mm = NULL;
+
+	do {
+		worker->last = iterate_mm_list(&worker->walk, &mm);
+		if (mm)
+			walk_mm(mm, &worker->walk);
+	} while (mm);
+}
+
+static int lru_gen_aging_start(struct lru_gen_mm_walk *walk,
+			       struct lru_gen_aging **agingp)
+{
+	int i, nid = lruvec_pgdat(walk->lruvec)->node_id;
+	int nr = READ_ONCE(lru_gen_aging_workers);
+	struct lru_gen_aging *aging;
+
+	if (!nr)
+		return 0;
+
+	/* pairs with smp_store_release() in aging_workers_store() */
+	aging = smp_load_acquire(&lru_gen_aging[nid]);
+	if (!aging || test_and_set_bit_lock(0, &aging->busy))
+		return 0;
+
+	for (i = 0; i < nr; i++) {
+		struct lru_gen_aging_worker *worker = &aging->workers[i];
+
+		worker->walk.lruvec = walk->lruvec;
+		worker->walk.seq = walk->seq;
+		worker->walk.can_swap = walk->can_swap;
+		worker->walk.force_scan = walk->force_scan;
+		worker->last = false;
+		queue_work_node(nid, lru_gen_aging_wq, &worker->work);
+	}
+
+	*agingp = aging;
+
+	return nr;
+}
+
+/* the caller holds the lruvec alive, so it waits for its workers */
+static bool lru_gen_aging_wait(struct lru_gen_aging *aging, int nr)
+{
+	int i;
+	bool last = false;
+
+	for (i = 0; i < nr; i++) {
+		flush_work(&aging->workers[i].work);
+		last |= aging->workers[i].last;
+	}
+
+	clear_bit_unlock(0, &aging->busy);
+
+	return last;
+}
+
 static bool try_to_inc_max_seq(struct lruvec *lruvec, unsigned long seq,
 			       bool can_swap, bool force_scan)
 {
 	bool success;
 	struct lru_gen_mm_walk *walk;
 	struct mm_struct *mm = NULL;
+	struct lru_gen_aging *aging;
+	int nr_workers;
 	struct lru_gen_folio *lrugen = &lruvec->lrugen;
 	struct lru_gen_mm_state *mm_state = get_mm_state(lruvec);
 
@@ -3866,11 +3954,17 @@ static bool try_to_inc_max_seq(struct lruvec *lruvec, unsigned long seq,
 	walk->can_swap = can_swap;
 	walk->force_scan = force_scan;
 
+	nr_workers = lru_gen_aging_start(walk, &aging);
+
 	do {
 		success = iterate_mm_list(walk, &mm);
 		if (mm)
 			walk_mm(mm, walk);
 	} while (mm);
+
+	/* only one walker can end an iteration, it may be a worker */
+	if (nr_workers && lru_gen_aging_wait(aging, nr_workers))
+		success = true;
 done:
 	if (success) {
 		success = inc_max_seq(lruvec, seq, can_swap, force_scan);
@@ -5158,9 +5252,67 @@ static ssize_t enabled_store(struct kobject *kobj, struct kobj_attribute *attr,
 
 static struct kobj_attribute lru_gen_enabled_attr = __ATTR_RW(enabled);
 
+static ssize_t aging_workers_show(struct kobject *kobj, struct kobj_attribute *attr,
+				  char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(lru_gen_aging_workers));
+}
+
+/* the number of kworkers helping each page table walk, 0 to disable */
+static ssize_t aging_workers_store(struct kobject *kobj, struct kobj_attribute *attr,
+				   const char *buf, size_t len)
+{
+	static DEFINE_MUTEX(aging_mutex);
+
+	int i, nid;
+	unsigned int nr;
+	ssize_t ret = len;
+
+	if (kstrtouint(buf, 0, &nr) || nr > MAX_AGING_WORKERS)
+		return -EINVAL;
+
+	mutex_lock(&aging_mutex);
+
+	if (nr && !lru_gen_aging_wq) {
+		lru_gen_aging_wq = alloc_workqueue("lru_gen_aging",
+						   WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+		if (!lru_gen_aging_wq) {
+			ret = -ENOMEM;
+			goto unlock;
+		}
+	}
+
+	for_each_node_state(nid, N_MEMORY) {
+		struct lru_gen_aging *aging;
+
+		if (!nr || lru_gen_aging[nid])
+			continue;
+
+		aging = kzalloc_node(sizeof(*aging), GFP_KERNEL, nid);
+		if (!aging) {
+			ret = -ENOMEM;
+			goto unlock;
+		}
+
+		for (i = 0; i < MAX_AGING_WORKERS; i++)
+			INIT_WORK(&aging->workers[i].work, lru_gen_aging_work);
+
+		smp_store_release(&lru_gen_aging[nid], aging);
+	}
+
+	WRITE_ONCE(lru_gen_aging_workers, nr);
+unlock:
+	mutex_unlock(&aging_mutex);
+
+	return ret;
+}
+
+static struct kobj_attribute lru_gen_aging_workers_attr = __ATTR_RW(aging_workers);
+
 static struct attribute *lru_gen_attrs[] = {
 	&lru_gen_min_ttl_attr.attr,
 	&lru_gen_enabled_attr.attr,
+	&lru_gen_aging_workers_attr.attr,
 	NULL
 };
 
@@ -5606,6 +5758,55 @@ void lru_gen_exit_memcg(struct mem_cgroup *memcg)
 	}
 }
 
+static const unsigned int lru_gen_wss_bins_ms[NR_WSS_BINS - 1] = {
+	MSEC_PER_SEC, 10 * MSEC_PER_SEC, 60 * MSEC_PER_SEC,
+};
+
+/*
+ * Sum the pages of each generation in the hierarchy under memcg into the bin
+ * matching the age of that generation. Only the per-generation counters are
+ * read, so this neither walks page tables nor takes any mmap_lock.
+ */
+void lru_gen_wss(struct mem_cgroup *memcg, unsigned long wss[ANON_AND_FILE][NR_WSS_BINS])
+{
+	int nid;
+	struct mem_cgroup *iter;
+
+	memset(wss, 0, sizeof(unsigned long) * ANON_AND_FILE * NR_WSS_BINS);
+
+	iter = mem_cgroup_iter(memcg, NULL, NULL);
+	do {
+		for_each_node_state(nid, N_MEMORY) {
+			unsigned long seq;
+			struct lruvec *lruvec = get_lruvec(iter, nid);
+			struct lru_gen_folio *lrugen = &lruvec->lrugen;
+			DEFINE_MAX_SEQ(lruvec);
+			DEFINE_MIN_SEQ(lruvec);
+
+			for (seq = min(min_seq[LRU_GEN_ANON], min_seq[LRU_GEN_FILE]);
+			     seq <= max_seq; seq++) {
+				int type, zone, bin;
+				int gen = lru_gen_from_seq(seq);
+				unsigned long birth = READ_ONCE(lrugen->timestamps[gen]);
+				unsigned int age = jiffies_to_msecs(jiffies - birth);
+
+				for (bin = 0; bin < NR_WSS_BINS - 1; bin++) {
+					if (age < lru_gen_wss_bins_ms[bin])
+						break;
+				}
+
+				for (type = 0; type < ANON_AND_FILE; type++) {
+					if (seq < min_seq[type])
+						continue;
+
+					for (zone = 0; zone < MAX_NR_ZONES; zone++)
+						wss[type][bin] += max(READ_ONCE(lrugen->nr_pages[gen][type][zone]), 0L);
+				}
+			}
+		}
+	} while ((iter = mem_cgroup_iter(memcg, iter, NULL)));
+}
+
 #endif /* CONFIG_MEMCG */
 
 static int __init init_lru_gen(void)
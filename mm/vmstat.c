@@ -1743,11 +1743,17 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 			   "\n    cpu: %i"
 			   "\n              count: %i"
 			   "\n              high:  %i"
-			   "\n              batch: %i",
+			   "\n              batch: %i"
+			   "\n              alloc_factor: %u"
+			   "\n              refills: %lu"
+			   "\n              refills_contended: %lu",
 			   i,
 			   pcp->count,
 			   pcp->high,
-			   pcp->batch);
+			   pcp->batch,
+			   pcp->alloc_factor,
+			   pcp->refills,
+			   pcp->refills_contended);
 #ifdef CONFIG_SMP
 		pzstats = per_cpu_ptr(zone->per_cpu_zonestats, i);
 		seq_printf(m, "\n  vm stats threshold: %d",
@@ -1884,6 +1890,40 @@ static void refresh_vm_stats(struct work_struct *work)
 	refresh_cpu_vm_stats(true);
 }
 
+/*
+ * schedule_on_each_cpu(refresh_vm_stats), minus the CPUs left alone in
+ * strict isolation mode: their differentials stay where they are until
+ * they fold them themselves.
+ */
+static int refresh_vm_stats_all(void)
+{
+	struct work_struct __percpu *works;
+	int cpu;
+
+	if (!housekeeping_strict_enabled())
+		return schedule_on_each_cpu(refresh_vm_stats);
+
+	works = alloc_percpu(struct work_struct);
+	if (!works)
+		return -ENOMEM;
+
+	cpus_read_lock();
+	for_each_online_cpu(cpu) {
+		if (cpu_is_isolated(cpu))
+			continue;
+		INIT_WORK(per_cpu_ptr(works, cpu), refresh_vm_stats);
+		schedule_work_on(cpu, per_cpu_ptr(works, cpu));
+	}
+	for_each_online_cpu(cpu) {
+		if (!cpu_is_isolated(cpu))
+			flush_work(per_cpu_ptr(works, cpu));
+	}
+	cpus_read_unlock();
+	free_percpu(works);
+
+	return 0;
+}
+
 int vmstat_refresh(struct ctl_table *table, int write,
 		   void *buffer, size_t *lenp, loff_t *ppos)
 {
@@ -1903,7 +1943,7 @@ int vmstat_refresh(struct ctl_table *table, int write,
 	 * transiently negative values, report an error here if any of
 	 * the stats is negative, so we know to go looking for imbalance.
 	 */
-	err = schedule_on_each_cpu(refresh_vm_stats);
+	err = refresh_vm_stats_all();
 	if (err)
 		return err;
 	for (i = 0; i < NR_VM_ZONE_STAT_ITEMS; i++) {
@@ -404,18 +404,9 @@ void *workingset_eviction(struct folio *folio, struct mem_cgroup *target_memcg)
 				folio_test_workingset(folio));
 }
 
-/**
- * workingset_test_recent - tests if the shadow entry is for a folio that was
- * recently evicted. Also fills in @workingset with the value unpacked from
- * shadow.
- * @shadow: the shadow entry to be tested.
- * @file: whether the corresponding folio is from the file lru.
- * @workingset: where the workingset value unpacked from shadow should
- * be stored.
- *
- * Return: true if the shadow is for a recently evicted folio; false otherwise.
- */
-bool workingset_test_recent(void *shadow, bool file, bool *workingset)
+/* Accounts the refault distance of @nr_refault pages if not 0 */
+static bool __workingset_test_recent(void *shadow, bool file, bool *workingset,
+				     long nr_refault)
 {
 	struct mem_cgroup *eviction_memcg;
 	struct lruvec *eviction_lruvec;
@@ -492,6 +483,9 @@ bool workingset_test_recent(void *shadow, bool file, bool *workingset)
 	 * leading to pressure on the active list is not a problem.
 	 */
 	refault_distance = (refault - eviction) & EVICTION_MASK;
+	if (nr_refault)
+		mem_cgroup_record_refault(eviction_memcg, file,
+					  refault_distance, nr_refault);
 
 	/*
 	 * Compare the distance to the existing workingset size. We
@@ -518,6 +512,22 @@ bool workingset_test_recent(void *shadow, bool file, bool *workingset)
 	return refault_distance <= workingset_size;
 }
 
+/**
+ * workingset_test_recent - tests if the shadow entry is for a folio that was
+ * recently evicted. Also fills in @workingset with the value unpacked from
+ * shadow.
+ * @shadow: the shadow entry to be tested.
+ * @file: whether the corresponding folio is from the file lru.
+ * @workingset: where the workingset value unpacked from shadow should
+ * be stored.
+ *
+ * Return: true if the shadow is for a recently evicted folio; false otherwise.
+ */
+bool workingset_test_recent(void *shadow, bool file, bool *workingset)
+{
+	return __workingset_test_recent(shadow, file, workingset, 0);
+}
+
 /**
  * workingset_refault - Evaluate the refault of a previously evicted folio.
  * @folio: The freshly allocated replacement folio.
@@ -558,7 +568,7 @@ void workingset_refault(struct folio *folio, void *shadow)
 
 	mod_lruvec_state(lruvec, WORKINGSET_REFAULT_BASE + file, nr);
 
-	if (!workingset_test_recent(shadow, file, &workingset))
+	if (!__workingset_test_recent(shadow, file, &workingset, nr))
 		return;
 
 	folio_set_active(folio);
@@ -62,6 +62,7 @@
 #include <linux/pagemap.h>
 #include <linux/fs.h>
 #include <linux/local_lock.h>
+#include <linux/workqueue.h>
 
 #define ZSPAGE_MAGIC	0x58
 
@@ -181,6 +182,15 @@ static struct dentry *zs_stat_root;
 
 static size_t huge_class_size;
 
+/*
+ * A size class is compacted in the background once this percentage of its
+ * allocated objects is unused, and compacting it would free at least
+ * ZS_BG_COMPACT_MIN_PAGES pages. 0 leaves compaction to zs_compact() callers.
+ */
+static unsigned int bg_compact_percent = 25;
+module_param(bg_compact_percent, uint, 0644);
+#define ZS_BG_COMPACT_MIN_PAGES	32
+
 struct size_class {
 	struct list_head fullness_list[NR_FULLNESS_GROUPS];
 	/*
@@ -238,6 +248,8 @@ struct zs_pool {
 #endif
 	spinlock_t lock;
 	atomic_t compaction_in_progress;
+	/* compacts the classes found fragmented by zs_free() */
+	struct work_struct compact_work;
 };
 
 struct zspage {
@@ -1412,12 +1424,15 @@ static void obj_free(int class_size, unsigned long obj)
 	mod_zspage_inuse(zspage, -1);
 }
 
+static bool zs_class_fragmented(struct size_class *class);
+
 void zs_free(struct zs_pool *pool, unsigned long handle)
 {
 	struct zspage *zspage;
 	struct page *f_page;
 	unsigned long obj;
 	struct size_class *class;
+	bool fragmented;
 	int fullness;
 
 	if (IS_ERR_OR_NULL((void *)handle))
@@ -1439,9 +1454,13 @@ void zs_free(struct zs_pool *pool, unsigned long handle)
 	fullness = fix_fullness_group(class, zspage);
 	if (fullness == ZS_INUSE_RATIO_0)
 		free_zspage(pool, class, zspage);
+	fragmented = zs_class_fragmented(class);
 
 	spin_unlock(&pool->lock);
 	cache_free_handle(pool, handle);
+
+	if (fragmented)
+		queue_work(system_unbound_wq, &pool->compact_work);
 }
 EXPORT_SYMBOL_GPL(zs_free);
 
@@ -1914,6 +1933,25 @@ static unsigned long zs_can_compact(struct size_class *class)
 	return obj_wasted * class->pages_per_zspage;
 }
 
+/*
+ * Check whether @class has crossed the background compaction threshold.
+ * Called with pool->lock held.
+ */
+static bool zs_class_fragmented(struct size_class *class)
+{
+	unsigned long obj_allocated = zs_stat_get(class, ZS_OBJS_ALLOCATED);
+	unsigned long obj_used = zs_stat_get(class, ZS_OBJS_INUSE);
+	unsigned int percent = READ_ONCE(bg_compact_percent);
+
+	if (!percent || obj_allocated <= obj_used)
+		return false;
+
+	if ((obj_allocated - obj_used) * 100 < obj_allocated * percent)
+		return false;
+
+	return zs_can_compact(class) >= ZS_BG_COMPACT_MIN_PAGES;
+}
+
 static unsigned long __zs_compact(struct zs_pool *pool,
 				  struct size_class *class)
 {
@@ -1951,7 +1989,7 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 		src_zspage = NULL;
 
 		if (get_fullness_group(class, dst_zspage) == ZS_INUSE_RATIO_100
-		    || spin_is_contended(&pool->lock)) {
+		    || spin_is_contended(&pool->lock) || need_resched()) {
 			putback_zspage(class, dst_zspage);
 			dst_zspage = NULL;
 
@@ -2000,6 +2038,41 @@ unsigned long zs_compact(struct zs_pool *pool)
 }
 EXPORT_SYMBOL_GPL(zs_compact);
 
+/*
+ * Compact only the classes over the threshold. __zs_compact() drops
+ * pool->lock whenever it is contended, so zs_map_object() and zs_free()
+ * callers wait for at most one zspage migration.
+ */
+static void zs_compact_work(struct work_struct *work)
+{
+	struct zs_pool *pool = container_of(work, struct zs_pool,
+					    compact_work);
+	unsigned long pages_freed = 0;
+	struct size_class *class;
+	bool fragmented;
+	int i;
+
+	/* A manual or shrinker compaction is already on it */
+	if (atomic_xchg(&pool->compaction_in_progress, 1))
+		return;
+
+	for (i = ZS_SIZE_CLASSES - 1; i >= 0; i--) {
+		class = pool->size_class[i];
+		if (class->index != i)
+			continue;
+
+		spin_lock(&pool->lock);
+		fragmented = zs_class_fragmented(class);
+		spin_unlock(&pool->lock);
+
+		if (fragmented)
+			pages_freed += __zs_compact(pool, class);
+		cond_resched();
+	}
+	atomic_long_add(pages_freed, &pool->stats.pages_compacted);
+	atomic_set(&pool->compaction_in_progress, 0);
+}
+
 void zs_pool_stats(struct zs_pool *pool, struct zs_pool_stats *stats)
 {
 	memcpy(stats, &pool->stats, sizeof(struct zs_pool_stats));
@@ -2106,6 +2179,7 @@ struct zs_pool *zs_create_pool(const char *name)
 	init_deferred_free(pool);
 	spin_lock_init(&pool->lock);
 	atomic_set(&pool->compaction_in_progress, 0);
+	INIT_WORK(&pool->compact_work, zs_compact_work);
 
 	pool->name = kstrdup(name, GFP_KERNEL);
 	if (!pool->name)
@@ -2211,6 +2285,7 @@ void zs_destroy_pool(struct zs_pool *pool)
 	int i;
 
 	zs_unregister_shrinker(pool);
+	cancel_work_sync(&pool->compact_work);
 	zs_flush_migration(pool);
 	zs_pool_stat_destroy(pool);
 
@@ -36,6 +36,10 @@
 #include <linux/pagemap.h>
 #include <linux/workqueue.h>
 #include <linux/list_lru.h>
+#include <linux/blkdev.h>
+#include <linux/sort.h>
+#include <linux/zstd.h>
+#include <linux/kernel_read_file.h>
 
 #include "swap.h"
 #include "internal.h"
@@ -117,6 +121,16 @@ static const struct kernel_param_ops zswap_zpool_param_ops = {
 };
 module_param_cb(zpool, &zswap_zpool_param_ops, &zswap_zpool_type, 0644);
 
+#ifdef CONFIG_ZSWAP_ZSTD_DICT
+/*
+ * Path of a zstd dictionary. It is loaded when a zstd pool is created, so
+ * a change takes effect on the next compressor switch; each pool keeps the
+ * dictionary it was created with for the lifetime of its entries.
+ */
+static char *zswap_zstd_dict = ZSWAP_PARAM_UNSET;
+module_param_named(zstd_dict, zswap_zstd_dict, charp, 0644);
+#endif
+
 /* The maximum percentage of memory that the compressed pool can occupy */
 static unsigned int zswap_max_pool_percent = 20;
 module_param_named(max_pool_percent, zswap_max_pool_percent, uint, 0644);
@@ -163,6 +177,13 @@ struct crypto_acomp_ctx {
 	u8 *buffer;
 	struct mutex mutex;
 	bool is_sleepable;
+#ifdef CONFIG_ZSWAP_ZSTD_DICT
+	/* used instead of ->acomp when the pool has a zstd dictionary */
+	void *cwksp;
+	void *dwksp;
+	zstd_cctx *cctx;
+	zstd_dctx *dctx;
+#endif
 };
 
 /*
@@ -179,6 +200,15 @@ struct zswap_pool {
 	struct work_struct release_work;
 	struct hlist_node node;
 	char tfm_name[CRYPTO_MAX_ALG_NAME];
+#ifdef CONFIG_ZSWAP_ZSTD_DICT
+	void *dict;
+	size_t dict_size;
+	zstd_parameters zstd_params;
+	void *cdict_mem;
+	void *ddict_mem;
+	const zstd_cdict *cdict;
+	const zstd_ddict *ddict;
+#endif
 };
 
 /* Global LRU lists shared by all zswap pools. */
@@ -309,6 +339,76 @@ static void zswap_update_total_size(void)
 **********************************/
 static void __zswap_pool_empty(struct percpu_ref *ref);
 
+#ifdef CONFIG_ZSWAP_ZSTD_DICT
+/* Same level the crypto zstd backend compresses at */
+#define ZSWAP_ZSTD_LEVEL	3
+#define ZSWAP_ZSTD_DICT_MAX_SIZE	(1 << 20)
+
+static bool zswap_pool_has_dict(struct zswap_pool *pool)
+{
+	return pool->cdict;
+}
+
+static void zswap_pool_free_dict(struct zswap_pool *pool)
+{
+	kvfree(pool->cdict_mem);
+	kvfree(pool->ddict_mem);
+	vfree(pool->dict);
+	pool->cdict_mem = NULL;
+	pool->ddict_mem = NULL;
+	pool->dict = NULL;
+	pool->cdict = NULL;
+	pool->ddict = NULL;
+}
+
+/*
+ * Load and digest the zstd_dict file for a new zstd pool. A dictionary that
+ * can't be used is not fatal, the pool then compresses without one.
+ */
+static void zswap_pool_load_dict(struct zswap_pool *pool)
+{
+	ssize_t sz;
+	size_t csz, dsz;
+
+	if (strcmp(pool->tfm_name, "zstd") ||
+	    !strcmp(zswap_zstd_dict, ZSWAP_PARAM_UNSET))
+		return;
+
+	sz = kernel_read_file_from_path(zswap_zstd_dict, 0, &pool->dict,
+					ZSWAP_ZSTD_DICT_MAX_SIZE, NULL,
+					READING_UNKNOWN);
+	if (sz < 0) {
+		pr_err("could not read zstd dictionary %s: %zd\n",
+		       zswap_zstd_dict, sz);
+		pool->dict = NULL;
+		return;
+	}
+	pool->dict_size = sz;
+
+	pool->zstd_params = zstd_get_params(ZSWAP_ZSTD_LEVEL, PAGE_SIZE);
+	csz = zstd_cdict_workspace_bound(sz, &pool->zstd_params.cParams);
+	dsz = zstd_ddict_workspace_bound(sz);
+	pool->cdict_mem = kvmalloc(csz, GFP_KERNEL);
+	pool->ddict_mem = kvmalloc(dsz, GFP_KERNEL);
+
+	pool->cdict = zstd_init_cdict(pool->cdict_mem, csz, pool->dict, sz,
+				      &pool->zstd_params.cParams);
+	pool->ddict = zstd_init_ddict(pool->ddict_mem, dsz, pool->dict, sz);
+	if (!pool->cdict || !pool->ddict) {
+		pr_err("could not load zstd dictionary %s\n", zswap_zstd_dict);
+		zswap_pool_free_dict(pool);
+		return;
+	}
+
+	pr_info("using zstd dictionary %s (%zu bytes)\n", zswap_zstd_dict,
+		pool->dict_size);
+}
+#else
+static bool zswap_pool_has_dict(struct zswap_pool *pool) { return false; }
+static void zswap_pool_free_dict(struct zswap_pool *pool) {}
+static void zswap_pool_load_dict(struct zswap_pool *pool) {}
+#endif
+
 static struct zswap_pool *zswap_pool_create(char *type, char *compressor)
 {
 	int i;
@@ -346,6 +446,7 @@ static struct zswap_pool *zswap_pool_create(char *type, char *compressor)
 	pr_debug("using %s zpool\n", zpool_get_type(pool->zpools[0]));
 
 	strscpy(pool->tfm_name, compressor, sizeof(pool->tfm_name));
+	zswap_pool_load_dict(pool);
 
 	pool->acomp_ctx = alloc_percpu(*pool->acomp_ctx);
 	if (!pool->acomp_ctx) {
@@ -376,6 +477,7 @@ static struct zswap_pool *zswap_pool_create(char *type, char *compressor)
 error:
 	if (pool->acomp_ctx)
 		free_percpu(pool->acomp_ctx);
+	zswap_pool_free_dict(pool);
 	while (i--)
 		zpool_destroy_pool(pool->zpools[i]);
 	kfree(pool);
@@ -432,6 +534,7 @@ static void zswap_pool_destroy(struct zswap_pool *pool)
 
 	cpuhp_state_remove_instance(CPUHP_MM_ZSWP_POOL_PREPARE, &pool->node);
 	free_percpu(pool->acomp_ctx);
+	zswap_pool_free_dict(pool);
 
 	for (i = 0; i < ZSWAP_NR_ZPOOLS; i++)
 		zpool_destroy_pool(pool->zpools[i]);
@@ -930,6 +1033,93 @@ static void zswap_invalidate_entry(struct zswap_tree *tree,
 /*********************************
 * compressed storage functions
 **********************************/
+#ifdef CONFIG_ZSWAP_ZSTD_DICT
+static int zswap_cpu_zstd_prepare(struct zswap_pool *pool,
+				  struct crypto_acomp_ctx *acomp_ctx, int cpu)
+{
+	size_t csz = zstd_cctx_workspace_bound(&pool->zstd_params.cParams);
+	size_t dsz = zstd_dctx_workspace_bound();
+
+	acomp_ctx->cwksp = vzalloc_node(csz, cpu_to_node(cpu));
+	acomp_ctx->dwksp = vzalloc_node(dsz, cpu_to_node(cpu));
+	if (!acomp_ctx->cwksp || !acomp_ctx->dwksp)
+		goto fail;
+
+	acomp_ctx->cctx = zstd_init_cctx(acomp_ctx->cwksp, csz);
+	acomp_ctx->dctx = zstd_init_dctx(acomp_ctx->dwksp, dsz);
+	if (!acomp_ctx->cctx || !acomp_ctx->dctx)
+		goto fail;
+
+	return 0;
+
+fail:
+	vfree(acomp_ctx->cwksp);
+	vfree(acomp_ctx->dwksp);
+	acomp_ctx->cwksp = acomp_ctx->dwksp = NULL;
+	return -ENOMEM;
+}
+
+static void zswap_cpu_zstd_dead(struct crypto_acomp_ctx *acomp_ctx)
+{
+	vfree(acomp_ctx->cwksp);
+	vfree(acomp_ctx->dwksp);
+}
+
+static int zswap_zstd_compress(struct zswap_pool *pool,
+			       struct crypto_acomp_ctx *acomp_ctx,
+			       struct page *page, unsigned int *dlen)
+{
+	void *src = kmap_local_page(page);
+	size_t ret;
+
+	ret = zstd_compress_using_cdict(acomp_ctx->cctx, acomp_ctx->buffer,
+					*dlen, src, PAGE_SIZE, pool->cdict);
+	kunmap_local(src);
+
+	if (zstd_is_error(ret))
+		return zstd_get_error_code(ret) == ZSTD_error_dstSize_tooSmall ?
+			-ENOSPC : -EINVAL;
+
+	*dlen = ret;
+	return 0;
+}
+
+static int zswap_zstd_decompress(struct zswap_pool *pool,
+				 struct crypto_acomp_ctx *acomp_ctx,
+				 const void *src, unsigned int slen,
+				 struct page *page)
+{
+	void *dst = kmap_local_page(page);
+	size_t ret;
+
+	ret = zstd_decompress_using_ddict(acomp_ctx->dctx, dst, PAGE_SIZE,
+					  src, slen, pool->ddict);
+	kunmap_local(dst);
+
+	return zstd_is_error(ret) || ret != PAGE_SIZE ? -EINVAL : 0;
+}
+#else
+static int zswap_cpu_zstd_prepare(struct zswap_pool *pool,
+				  struct crypto_acomp_ctx *acomp_ctx, int cpu)
+{
+	return -EINVAL;
+}
+static void zswap_cpu_zstd_dead(struct crypto_acomp_ctx *acomp_ctx) {}
+static int zswap_zstd_compress(struct zswap_pool *pool,
+			       struct crypto_acomp_ctx *acomp_ctx,
+			       struct page *page, unsigned int *dlen)
+{
+	return -EINVAL;
+}
+static int zswap_zstd_decompress(struct zswap_pool *pool,
+				 struct crypto_acomp_ctx *acomp_ctx,
+				 const void *src, unsigned int slen,
+				 struct page *page)
+{
+	return -EINVAL;
+}
+#endif
+
 static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 {
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
@@ -944,6 +1134,13 @@ static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 	if (!acomp_ctx->buffer)
 		return -ENOMEM;
 
+	if (zswap_pool_has_dict(pool)) {
+		ret = zswap_cpu_zstd_prepare(pool, acomp_ctx, cpu);
+		if (ret)
+			kfree(acomp_ctx->buffer);
+		return ret;
+	}
+
 	acomp = crypto_alloc_acomp_node(pool->tfm_name, 0, 0, cpu_to_node(cpu));
 	if (IS_ERR(acomp)) {
 		pr_err("could not alloc crypto acomp %s : %ld\n",
@@ -991,13 +1188,14 @@ static int zswap_cpu_comp_dead(unsigned int cpu, struct hlist_node *node)
 			acomp_request_free(acomp_ctx->req);
 		if (!IS_ERR_OR_NULL(acomp_ctx->acomp))
 			crypto_free_acomp(acomp_ctx->acomp);
+		zswap_cpu_zstd_dead(acomp_ctx);
 		kfree(acomp_ctx->buffer);
 	}
 
 	return 0;
 }
 
-static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
+static bool zswap_compress(struct page *page, struct zswap_entry *entry)
 {
 	struct crypto_acomp_ctx *acomp_ctx;
 	struct scatterlist input, output;
@@ -1014,8 +1212,16 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	mutex_lock(&acomp_ctx->mutex);
 
 	dst = acomp_ctx->buffer;
+	if (zswap_pool_has_dict(entry->pool)) {
+		comp_ret = zswap_zstd_compress(entry->pool, acomp_ctx,
+					       page, &dlen);
+		if (comp_ret)
+			goto unlock;
+		goto store;
+	}
+
 	sg_init_table(&input, 1);
-	sg_set_page(&input, &folio->page, PAGE_SIZE, 0);
+	sg_set_page(&input, page, PAGE_SIZE, 0);
 
 	/*
 	 * We need PAGE_SIZE * 2 here since there maybe over-compression case,
@@ -1042,6 +1248,7 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	if (comp_ret)
 		goto unlock;
 
+store:
 	zpool = zswap_find_zpool(entry);
 	gfp = __GFP_NORETRY | __GFP_NOWARN | __GFP_KSWAPD_RECLAIM;
 	if (zpool_malloc_support_movable(zpool))
@@ -1069,7 +1276,7 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	return comp_ret == 0 && alloc_ret == 0;
 }
 
-static void zswap_decompress(struct zswap_entry *entry, struct page *page)
+static bool zswap_decompress(struct zswap_entry *entry, struct page *page)
 {
 	struct zpool *zpool = zswap_find_zpool(entry);
 	struct scatterlist input, output;
@@ -1080,6 +1287,16 @@ static void zswap_decompress(struct zswap_entry *entry, struct page *page)
 	mutex_lock(&acomp_ctx->mutex);
 
 	src = zpool_map_handle(zpool, entry->handle, ZPOOL_MM_RO);
+	/* zstd neither sleeps nor needs a linear mapping */
+	if (zswap_pool_has_dict(entry->pool)) {
+		int err = zswap_zstd_decompress(entry->pool, acomp_ctx, src,
+						entry->length, page);
+
+		zpool_unmap_handle(zpool, entry->handle);
+		mutex_unlock(&acomp_ctx->mutex);
+		return !WARN_ON_ONCE(err);
+	}
+
 	/*
 	 * If zpool_map_handle is atomic, we cannot reliably utilize its mapped buffer
 	 * to do crypto_acomp_decompress() which might sleep. In such cases, we must
@@ -1106,6 +1323,7 @@ static void zswap_decompress(struct zswap_entry *entry, struct page *page)
 
 	if (src != acomp_ctx->buffer)
 		zpool_unmap_handle(zpool, entry->handle);
+	return true;
 }
 
 /*********************************
@@ -1172,11 +1390,22 @@ static int zswap_writeback_entry(struct zswap_entry *entry,
 		return -ENOMEM;
 	}
 
-	/* Safe to deref entry after the entry is verified above. */
-	zswap_rb_erase(&tree->rbroot, entry);
 	spin_unlock(&tree->lock);
 
-	zswap_decompress(entry, &folio->page);
+	/*
+	 * Safe to deref entry after the entry is verified above: the
+	 * locked swapcache folio keeps it from being invalidated.
+	 */
+	if (!zswap_decompress(entry, &folio->page)) {
+		delete_from_swap_cache(folio);
+		folio_unlock(folio);
+		folio_put(folio);
+		return -EIO;
+	}
+
+	spin_lock(&tree->lock);
+	zswap_rb_erase(&tree->rbroot, entry);
+	spin_unlock(&tree->lock);
 
 	count_vm_event(ZSWPWB);
 	if (entry->objcg)
@@ -1200,20 +1429,37 @@ static int zswap_writeback_entry(struct zswap_entry *entry,
 /*********************************
 * shrinker functions
 **********************************/
+/*
+ * Number of LRU-cold entries the shrinkers collect before writing them
+ * back. Kept small, the batch lives on the stack of reclaim.
+ */
+#define ZSWAP_WB_BATCH		16
+
+struct zswap_wb_slot {
+	struct zswap_entry *entry;
+	swp_entry_t swpentry;
+};
+
+struct zswap_wb_batch {
+	unsigned int nr;
+	struct zswap_wb_slot slots[ZSWAP_WB_BATCH];
+};
+
 static enum lru_status shrink_memcg_cb(struct list_head *item, struct list_lru_one *l,
 				       spinlock_t *lock, void *arg)
 {
 	struct zswap_entry *entry = container_of(item, struct zswap_entry, lru);
-	bool *encountered_page_in_swapcache = (bool *)arg;
-	swp_entry_t swpentry;
-	enum lru_status ret = LRU_REMOVED_RETRY;
-	int writeback_result;
+	struct zswap_wb_batch *batch = arg;
+
+	/* The walk came around to the entries already rotated for us */
+	if (batch->nr && batch->slots[0].entry == entry)
+		return LRU_STOP;
 
 	/*
-	 * As soon as we drop the LRU lock, the entry can be freed by
+	 * As soon as the LRU lock is dropped, the entry can be freed by
 	 * a concurrent invalidation. This means the following:
 	 *
-	 * 1. We extract the swp_entry_t to the stack, allowing
+	 * 1. We extract the swp_entry_t into the batch, allowing
 	 *    zswap_writeback_entry() to pin the swap entry and
 	 *    then validate the zwap entry against that swap entry's
 	 *    tree using pointer value comparison. Only when that
@@ -1224,7 +1470,7 @@ static enum lru_status shrink_memcg_cb(struct list_head *item, struct list_lru_o
 	 *    for whatever reason, we have no means of knowing if the
 	 *    entry is alive to put it back on the LRU.
 	 *
-	 *    So rotate it before dropping the lock. If the entry is
+	 *    So rotate it while we hold the lock. If the entry is
 	 *    written back or invalidated, the free path will unlink
 	 *    it. For failures, rotation is the right thing as well.
 	 *
@@ -1236,40 +1482,94 @@ static enum lru_status shrink_memcg_cb(struct list_head *item, struct list_lru_o
 	 */
 	list_move_tail(item, &l->list);
 
-	/*
-	 * Once the lru lock is dropped, the entry might get freed. The
-	 * swpentry is copied to the stack, and entry isn't deref'd again
-	 * until the entry is verified to still be alive in the tree.
-	 */
-	swpentry = entry->swpentry;
+	batch->slots[batch->nr].entry = entry;
+	batch->slots[batch->nr].swpentry = entry->swpentry;
+	batch->nr++;
 
-	/*
-	 * It's safe to drop the lock here because we return either
-	 * LRU_REMOVED_RETRY or LRU_RETRY.
-	 */
-	spin_unlock(lock);
+	return batch->nr == ZSWAP_WB_BATCH ? LRU_STOP : LRU_SKIP;
+}
 
-	writeback_result = zswap_writeback_entry(entry, swpentry);
+static int zswap_wb_cmp(const void *a, const void *b)
+{
+	const struct zswap_wb_slot *x = a, *y = b;
 
-	if (writeback_result) {
-		zswap_reject_reclaim_fail++;
-		ret = LRU_RETRY;
+	if (x->swpentry.val < y->swpentry.val)
+		return -1;
+	return x->swpentry.val > y->swpentry.val;
+}
 
+/*
+ * Write back the entries collected by shrink_memcg_cb() in swap slot order
+ * and under a single plug, so that neighbouring slots reach the device as
+ * merged bios rather than as a storm of random 4K writes. Returns the
+ * number of entries written back.
+ */
+static unsigned long zswap_wb_batch_flush(struct zswap_wb_batch *batch,
+					  bool *encountered_page_in_swapcache)
+{
+	unsigned long written = 0;
+	struct blk_plug plug;
+	unsigned int i;
+	int ret;
+
+	sort(batch->slots, batch->nr, sizeof(batch->slots[0]),
+	     zswap_wb_cmp, NULL);
+
+	blk_start_plug(&plug);
+	for (i = 0; i < batch->nr; i++) {
+		ret = zswap_writeback_entry(batch->slots[i].entry,
+					    batch->slots[i].swpentry);
+		if (!ret) {
+			zswap_written_back_pages++;
+			written++;
+			continue;
+		}
+
+		zswap_reject_reclaim_fail++;
 		/*
 		 * Encountering a page already in swap cache is a sign that we are shrinking
 		 * into the warmer region. We should terminate shrinking (if we're in the dynamic
 		 * shrinker context).
 		 */
-		if (writeback_result == -EEXIST && encountered_page_in_swapcache) {
-			ret = LRU_STOP;
+		if (ret == -EEXIST && encountered_page_in_swapcache)
 			*encountered_page_in_swapcache = true;
-		}
-	} else {
-		zswap_written_back_pages++;
 	}
+	blk_finish_plug(&plug);
 
-	spin_lock(lock);
-	return ret;
+	batch->nr = 0;
+	return written;
+}
+
+/*
+ * Write back up to @nr_to_walk entries from the cold end of a memcg's LRU
+ * on @nid, ZSWAP_WB_BATCH at a time.
+ */
+static unsigned long zswap_shrink_lru(int nid, struct mem_cgroup *memcg,
+				      unsigned long *nr_to_walk,
+				      bool *encountered_page_in_swapcache)
+{
+	struct zswap_wb_batch batch;
+	unsigned long written = 0;
+
+	batch.nr = 0;
+	while (*nr_to_walk) {
+		unsigned long nr = min_t(unsigned long, *nr_to_walk,
+					 ZSWAP_WB_BATCH);
+
+		*nr_to_walk -= nr;
+		list_lru_walk_one(&zswap_list_lru, nid, memcg,
+				  &shrink_memcg_cb, &batch, &nr);
+		if (!batch.nr)
+			break;
+
+		written += zswap_wb_batch_flush(&batch,
+						encountered_page_in_swapcache);
+		if (encountered_page_in_swapcache &&
+		    *encountered_page_in_swapcache)
+			break;
+	}
+
+	return written;
 }
 
 static unsigned long zswap_shrinker_scan(struct shrinker *shrinker,
@@ -1304,8 +1604,8 @@ static unsigned long zswap_shrinker_scan(struct shrinker *shrinker,
 		return SHRINK_STOP;
 	}
 
-	shrink_ret = list_lru_shrink_walk(&zswap_list_lru, sc, &shrink_memcg_cb,
-		&encountered_page_in_swapcache);
+	shrink_ret = zswap_shrink_lru(sc->nid, sc->memcg, &sc->nr_to_scan,
+				      &encountered_page_in_swapcache);
 
 	if (encountered_page_in_swapcache)
 		return SHRINK_STOP;
@@ -1400,10 +1700,9 @@ static int shrink_memcg(struct mem_cgroup *memcg)
 		return -ENOENT;
 
 	for_each_node_state(nid, N_NORMAL_MEMORY) {
-		unsigned long nr_to_walk = 1;
+		unsigned long nr_to_walk = ZSWAP_WB_BATCH;
 
-		shrunk += list_lru_walk_one(&zswap_list_lru, nid, memcg,
-					    &shrink_memcg_cb, NULL, &nr_to_walk);
+		shrunk += zswap_shrink_lru(nid, memcg, &nr_to_walk, NULL);
 	}
 	return shrunk ? 0 : -EAGAIN;
 }
@@ -1495,61 +1794,31 @@ static void zswap_fill_page(void *ptr, unsigned long value)
 	memset_l(page, value, PAGE_SIZE / sizeof(unsigned long));
 }
 
-bool zswap_store(struct folio *folio)
+/*
+ * Store the @index'th page of @folio as its own entry. The entry takes
+ * its own references on @objcg and @pool.
+ */
+static bool zswap_store_page(struct folio *folio, long index,
+			     struct obj_cgroup *objcg, struct zswap_pool *pool)
 {
-	swp_entry_t swp = folio->swap;
-	pgoff_t offset = swp_offset(swp);
+	swp_entry_t swp = swp_entry(swp_type(folio->swap),
+				    swp_offset(folio->swap) + index);
 	struct zswap_tree *tree = swap_zswap_tree(swp);
+	struct page *page = folio_page(folio, index);
 	struct zswap_entry *entry, *dupentry;
-	struct obj_cgroup *objcg = NULL;
-	struct mem_cgroup *memcg = NULL;
-
-	VM_WARN_ON_ONCE(!folio_test_locked(folio));
-	VM_WARN_ON_ONCE(!folio_test_swapcache(folio));
-
-	/* Large folios aren't supported */
-	if (folio_test_large(folio))
-		return false;
-
-	if (!zswap_enabled)
-		goto check_old;
-
-	objcg = get_obj_cgroup_from_folio(folio);
-	if (objcg && !obj_cgroup_may_zswap(objcg)) {
-		memcg = get_mem_cgroup_from_objcg(objcg);
-		if (shrink_memcg(memcg)) {
-			mem_cgroup_put(memcg);
-			goto reject;
-		}
-		mem_cgroup_put(memcg);
-	}
-
-	/* reclaim space if needed */
-	if (zswap_is_full()) {
-		zswap_pool_limit_hit++;
-		zswap_pool_reached_full = true;
-		goto shrink;
-	}
-
-	if (zswap_pool_reached_full) {
-	       if (!zswap_can_accept())
-			goto shrink;
-		else
-			zswap_pool_reached_full = false;
-	}
 
 	/* allocate entry */
 	entry = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
 	if (!entry) {
 		zswap_reject_kmemcache_fail++;
-		goto reject;
+		return false;
 	}
 
 	if (zswap_same_filled_pages_enabled) {
 		unsigned long value;
 		u8 *src;
 
-		src = kmap_local_folio(folio, 0);
+		src = kmap_local_page(page);
 		if (zswap_is_page_same_filled(src, &value)) {
 			kunmap_local(src);
 			entry->length = 0;
@@ -1564,26 +1833,18 @@ bool zswap_store(struct folio *folio)
 		goto freepage;
 
 	/* if entry is successfully added, it keeps the reference */
-	entry->pool = zswap_pool_current_get();
-	if (!entry->pool)
+	if (!zswap_pool_get(pool))
 		goto freepage;
+	entry->pool = pool;
 
-	if (objcg) {
-		memcg = get_mem_cgroup_from_objcg(objcg);
-		if (memcg_list_lru_alloc(memcg, &zswap_list_lru, GFP_KERNEL)) {
-			mem_cgroup_put(memcg);
-			goto put_pool;
-		}
-		mem_cgroup_put(memcg);
-	}
-
-	if (!zswap_compress(folio, entry))
+	if (!zswap_compress(page, entry))
 		goto put_pool;
 
 insert_entry:
 	entry->swpentry = swp;
 	entry->objcg = objcg;
 	if (objcg) {
+		obj_cgroup_get(objcg);
 		obj_cgroup_charge_zswap(objcg, entry->length);
 		/* Account before objcg ref is moved to tree */
 		count_objcg_event(objcg, ZSWPOUT);
@@ -1614,28 +1875,108 @@ bool zswap_store(struct folio *folio)
 	return true;
 
 put_pool:
-	zswap_pool_put(entry->pool);
+	zswap_pool_put(pool);
 freepage:
 	zswap_entry_cache_free(entry);
-reject:
+	return false;
+}
+
+/*
+ * Large folios are stored page by page, each page as an entry of its own
+ * swap slot, so that reclaim needn't split them first. The store is all or
+ * nothing: if any page fails, the entries of the others are invalidated.
+ */
+bool zswap_store(struct folio *folio)
+{
+	long nr_pages = folio_nr_pages(folio);
+	swp_entry_t swp = folio->swap;
+	pgoff_t offset = swp_offset(swp);
+	struct obj_cgroup *objcg = NULL;
+	struct mem_cgroup *memcg = NULL;
+	struct zswap_pool *pool;
+	struct zswap_tree *tree;
+	struct zswap_entry *entry;
+	bool ret = false;
+	long index;
+
+	VM_WARN_ON_ONCE(!folio_test_locked(folio));
+	VM_WARN_ON_ONCE(!folio_test_swapcache(folio));
+
+	if (!zswap_enabled)
+		goto check_old;
+
+	objcg = get_obj_cgroup_from_folio(folio);
+	if (objcg && !obj_cgroup_may_zswap(objcg)) {
+		memcg = get_mem_cgroup_from_objcg(objcg);
+		if (shrink_memcg(memcg)) {
+			mem_cgroup_put(memcg);
+			goto put_objcg;
+		}
+		mem_cgroup_put(memcg);
+	}
+
+	/* reclaim space if needed */
+	if (zswap_is_full()) {
+		zswap_pool_limit_hit++;
+		zswap_pool_reached_full = true;
+		goto shrink;
+	}
+
+	if (zswap_pool_reached_full) {
+	       if (!zswap_can_accept())
+			goto shrink;
+		else
+			zswap_pool_reached_full = false;
+	}
+
+	pool = zswap_pool_current_get();
+	if (!pool)
+		goto put_objcg;
+
+	if (objcg) {
+		memcg = get_mem_cgroup_from_objcg(objcg);
+		if (memcg_list_lru_alloc(memcg, &zswap_list_lru, GFP_KERNEL)) {
+			mem_cgroup_put(memcg);
+			goto put_pool;
+		}
+		mem_cgroup_put(memcg);
+	}
+
+	for (index = 0; index < nr_pages; index++) {
+		if (!zswap_store_page(folio, index, objcg, pool))
+			goto put_pool;
+	}
+
+	ret = true;
+
+put_pool:
+	zswap_pool_put(pool);
+put_objcg:
 	if (objcg)
 		obj_cgroup_put(objcg);
 check_old:
 	/*
 	 * If the zswap store fails or zswap is disabled, we must invalidate the
-	 * possibly stale entry which was previously stored at this offset.
-	 * Otherwise, writeback could overwrite the new data in the swapfile.
+	 * possibly stale entries which were previously stored at the offsets
+	 * of this folio. Otherwise, writeback could overwrite the new data in
+	 * the swapfile.
 	 */
-	spin_lock(&tree->lock);
-	entry = zswap_rb_search(&tree->rbroot, offset);
-	if (entry)
-		zswap_invalidate_entry(tree, entry);
-	spin_unlock(&tree->lock);
-	return false;
+	if (!ret) {
+		for (index = 0; index < nr_pages; index++) {
+			tree = swap_zswap_tree(swp_entry(swp_type(swp),
+							 offset + index));
+			spin_lock(&tree->lock);
+			entry = zswap_rb_search(&tree->rbroot, offset + index);
+			if (entry)
+				zswap_invalidate_entry(tree, entry);
+			spin_unlock(&tree->lock);
+		}
+	}
+	return ret;
 
 shrink:
 	queue_work(shrink_wq, &zswap_shrink_work);
-	goto reject;
+	goto put_objcg;
 }
 
 bool zswap_load(struct folio *folio)
@@ -1646,9 +1987,12 @@ bool zswap_load(struct folio *folio)
 	bool swapcache = folio_test_swapcache(folio);
 	struct zswap_tree *tree = swap_zswap_tree(swp);
 	struct zswap_entry *entry;
+	bool ok = true;
 	u8 *dst;
 
 	VM_WARN_ON_ONCE(!folio_test_locked(folio));
+	/* Swap-in allocates order-0 folios, only the store side is large */
+	VM_WARN_ON_ONCE(folio_test_large(folio));
 
 	spin_lock(&tree->lock);
 	entry = zswap_rb_search(&tree->rbroot, offset);
@@ -1656,6 +2000,29 @@ bool zswap_load(struct folio *folio)
 		spin_unlock(&tree->lock);
 		return false;
 	}
+	/*
+	 * Leave the entry in the tree until it is decompressed. The
+	 * locked folio keeps it from being invalidated or written back
+	 * in the meantime.
+	 */
+	spin_unlock(&tree->lock);
+
+	if (entry->length)
+		ok = zswap_decompress(entry, page);
+	else {
+		dst = kmap_local_page(page);
+		zswap_fill_page(dst, entry->value);
+		kunmap_local(dst);
+	}
+
+	/*
+	 * The swap device holds no copy of the data, so don't let the
+	 * caller read from it. Leave the folio !uptodate and the entry
+	 * in place; the swapin fails with an IO error.
+	 */
+	if (!ok)
+		return true;
+
 	/*
 	 * When reading into the swapcache, invalidate our entry. The
 	 * swapcache can be the authoritative owner of the page and
@@ -1668,16 +2035,10 @@ bool zswap_load(struct folio *folio)
 	 * files, which reads into a private page and may free it if
 	 * the fault fails. We remain the primary owner of the entry.)
 	 */
-	if (swapcache)
+	if (swapcache) {
+		spin_lock(&tree->lock);
 		zswap_rb_erase(&tree->rbroot, entry);
-	spin_unlock(&tree->lock);
-
-	if (entry->length)
-		zswap_decompress(entry, page);
-	else {
-		dst = kmap_local_page(page);
-		zswap_fill_page(dst, entry->value);
-		kunmap_local(dst);
+		spin_unlock(&tree->lock);
 	}
 
 	count_vm_event(ZSWPIN);
@@ -1689,6 +2050,7 @@ bool zswap_load(struct folio *folio)
 		folio_mark_dirty(folio);
 	}
 
+	folio_mark_uptodate(folio);
 	return true;
 }
 
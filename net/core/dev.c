@@ -4407,6 +4407,69 @@ int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 }
 EXPORT_SYMBOL(__dev_direct_xmit);
 
+/*
+ * Like __dev_direct_xmit(), for a list of skbs linked through skb->next which
+ * are handed to the driver under a single lock with xmit_more set on all but
+ * the last one. Skbs that fail validation are dropped. The skbs that could
+ * not be sent, if any, are returned still linked in @unsent and are left to
+ * the caller.
+ */
+int __dev_direct_xmit_list(struct sk_buff *skb, u16 queue_id,
+			   struct sk_buff **unsent)
+{
+	struct net_device *dev = skb->dev;
+	struct sk_buff *next, *head = NULL, **tail = &head;
+	struct netdev_queue *txq;
+	int ret = NETDEV_TX_BUSY;
+	bool again = false;
+
+	*unsent = NULL;
+	if (unlikely(!netif_running(dev) ||
+		     !netif_carrier_ok(dev))) {
+		for (next = skb; next; next = next->next)
+			dev_core_stats_tx_dropped_inc(dev);
+		kfree_skb_list(skb);
+		return NET_XMIT_DROP;
+	}
+
+	for (; skb; skb = next) {
+		struct sk_buff *orig_skb = skb;
+
+		next = skb->next;
+		skb_mark_not_on_list(skb);
+		skb = validate_xmit_skb_list(skb, dev, &again);
+		if (skb != orig_skb) {
+			dev_core_stats_tx_dropped_inc(dev);
+			kfree_skb_list(skb);
+			continue;
+		}
+
+		skb_set_queue_mapping(skb, queue_id);
+		*tail = skb;
+		tail = &skb->next;
+	}
+
+	if (!head)
+		return NET_XMIT_DROP;
+
+	txq = skb_get_tx_queue(dev, head);
+
+	local_bh_disable();
+
+	dev_xmit_recursion_inc();
+	HARD_TX_LOCK(dev, txq, smp_processor_id());
+	if (!netif_xmit_frozen_or_drv_stopped(txq))
+		head = dev_hard_start_xmit(head, dev, txq, &ret);
+	HARD_TX_UNLOCK(dev, txq);
+	dev_xmit_recursion_dec();
+
+	local_bh_enable();
+
+	*unsent = head;
+	return ret;
+}
+EXPORT_SYMBOL(__dev_direct_xmit_list);
+
 /*************************************************************************
  *			Receiver routines
  *************************************************************************/
@@ -6364,6 +6427,56 @@ void napi_busy_loop(unsigned int napi_id,
 }
 EXPORT_SYMBOL(napi_busy_loop);
 
+/**
+ * napi_suspend_irqs - keep the IRQs of a NAPI masked after a busy poll
+ * @napi_id: the NAPI that was busy polled
+ *
+ * To be called by a preferred busy poll user which found data, and is about
+ * to process it before polling again. With defer_hard_irqs and
+ * gro_flush_timeout set, busy_poll_stop() leaves the device IRQs masked, and
+ * this pushes the NAPI watchdog out to irq_suspend_timeout. As long as the
+ * application polls again within that time, the device doesn't raise an IRQ.
+ */
+void napi_suspend_irqs(unsigned int napi_id)
+{
+	struct napi_struct *napi;
+
+	rcu_read_lock();
+	napi = napi_by_id(napi_id);
+	if (napi) {
+		unsigned long timeout = READ_ONCE(napi->irq_suspend_timeout);
+
+		if (timeout)
+			hrtimer_start(&napi->timer, ns_to_ktime(timeout),
+				      HRTIMER_MODE_REL_PINNED);
+	}
+	rcu_read_unlock();
+}
+EXPORT_SYMBOL(napi_suspend_irqs);
+
+/**
+ * napi_resume_irqs - give the IRQs of a NAPI back to the device
+ * @napi_id: the NAPI that was busy polled
+ *
+ * To be called when a busy poll which suspended IRQs found no data and is
+ * about to block. A regular poll then completes the NAPI and re-arms the
+ * device IRQ instead of waiting for the watchdog.
+ */
+void napi_resume_irqs(unsigned int napi_id)
+{
+	struct napi_struct *napi;
+
+	rcu_read_lock();
+	napi = napi_by_id(napi_id);
+	if (napi && READ_ONCE(napi->irq_suspend_timeout)) {
+		local_bh_disable();
+		napi_schedule(napi);
+		local_bh_enable();
+	}
+	rcu_read_unlock();
+}
+EXPORT_SYMBOL(napi_resume_irqs);
+
 #endif /* CONFIG_NET_RX_BUSY_POLL */
 
 static void napi_hash_add(struct napi_struct *napi)
@@ -6421,10 +6534,17 @@ static void init_gro_hash(struct napi_struct *napi)
 	int i;
 
 	for (i = 0; i < GRO_HASH_BUCKETS; i++) {
-		INIT_LIST_HEAD(&napi->gro_hash[i].list);
-		napi->gro_hash[i].count = 0;
+		INIT_LIST_HEAD(&napi->gro_hash_inline[i].list);
+		napi->gro_hash_inline[i].count = 0;
 	}
+	napi->gro_hash = napi->gro_hash_inline;
+	napi->gro_hash_mask = GRO_HASH_BUCKETS - 1;
+	napi->gro_hash_shift = 0;
+	napi->gro_hash_evicted = 0;
 	napi->gro_bitmask = 0;
+	napi->gro_aggregates = 0;
+	napi->gro_segments = 0;
+	napi->gro_evictions = 0;
 }
 
 int dev_set_threaded(struct net_device *dev, bool threaded)
@@ -6518,6 +6638,7 @@ void netif_napi_add_weight(struct net_device *dev, struct napi_struct *napi,
 	napi->skb = NULL;
 	INIT_LIST_HEAD(&napi->rx_list);
 	napi->rx_count = 0;
+	napi->irq_suspend_timeout = 0;
 	napi->poll = poll;
 	if (weight > NAPI_POLL_WEIGHT)
 		netdev_err_once(dev, "%s() called with weight %d\n", __func__,
@@ -6590,15 +6711,22 @@ EXPORT_SYMBOL(napi_enable);
 
 static void flush_gro_hash(struct napi_struct *napi)
 {
-	int i;
+	unsigned int i;
 
-	for (i = 0; i < GRO_HASH_BUCKETS; i++) {
+	for (i = 0; i <= napi->gro_hash_mask; i++) {
 		struct sk_buff *skb, *n;
 
 		list_for_each_entry_safe(skb, n, &napi->gro_hash[i].list, list)
 			kfree_skb(skb);
 		napi->gro_hash[i].count = 0;
 	}
+
+	if (napi->gro_hash != napi->gro_hash_inline) {
+		kfree(napi->gro_hash);
+		napi->gro_hash = napi->gro_hash_inline;
+		napi->gro_hash_mask = GRO_HASH_BUCKETS - 1;
+		napi->gro_hash_shift = 0;
+	}
 }
 
 /* Must be called in process context */
@@ -43,6 +43,18 @@ static void dissector_set_key(struct flow_dissector *flow_dissector,
 	flow_dissector->used_keys |= (1ULL << key_id);
 }
 
+/* Keys which __skb_flow_dissect_fast() either fills or never needs to */
+#define FLOW_DISSECTOR_FAST_KEYS					\
+	(BIT_ULL(FLOW_DISSECTOR_KEY_CONTROL) |				\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_BASIC) |				\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_IPV4_ADDRS) |			\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_IPV6_ADDRS) |			\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_TIPC) |				\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_PORTS) |				\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_VLAN) |				\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_FLOW_LABEL) |			\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_GRE_KEYID))
+
 void skb_flow_dissector_init(struct flow_dissector *flow_dissector,
 			     const struct flow_dissector_key *key,
 			     unsigned int key_count)
@@ -70,6 +82,9 @@ void skb_flow_dissector_init(struct flow_dissector *flow_dissector,
 				   FLOW_DISSECTOR_KEY_CONTROL));
 	BUG_ON(!dissector_uses_key(flow_dissector,
 				   FLOW_DISSECTOR_KEY_BASIC));
+
+	flow_dissector->fast_path =
+		!(flow_dissector->used_keys & ~FLOW_DISSECTOR_FAST_KEYS);
 }
 EXPORT_SYMBOL(skb_flow_dissector_init);
 
@@ -1002,6 +1017,141 @@ static bool is_pppoe_ses_hdr_valid(const struct pppoe_hdr *hdr)
 	return hdr->ver == 1 && hdr->type == 1 && hdr->code == 0;
 }
 
+/*
+ * Fast path for dissectors limited to FLOW_DISSECTOR_FAST_KEYS, such as the
+ * ones behind skb_get_hash() and RPS, for the common case of TCP or UDP over
+ * IPv4 or IPv6, optionally behind an offloaded VLAN tag. It fills the keys
+ * exactly as __skb_flow_dissect() would. Anything else, including IPv4
+ * fragments and IPv6 extension headers, returns -1 before touching the
+ * target so that the generic dissector can take over.
+ */
+static int __skb_flow_dissect_fast(const struct sk_buff *skb,
+				   struct flow_dissector *flow_dissector,
+				   void *target_container, const void *data,
+				   __be16 proto, int nhoff, int hlen,
+				   unsigned int flags)
+{
+	struct flow_dissector_key_control *key_control;
+	struct flow_dissector_key_basic *key_basic;
+	struct flow_dissector_key_addrs *key_addrs;
+	__be16 vlan_tpid = 0;
+	bool l4 = true;
+	u8 ip_proto;
+
+	if (skb && skb_vlan_tag_present(skb) && proto == skb->vlan_proto) {
+		vlan_tpid = proto;
+		proto = skb->protocol;
+	}
+
+	if (proto == htons(ETH_P_IP)) {
+		const struct iphdr *iph;
+		struct iphdr _iph;
+
+		iph = __skb_header_pointer(skb, nhoff, sizeof(_iph), data, hlen,
+					   &_iph);
+		if (!iph || iph->ihl < 5 || ip_is_fragment(iph))
+			return -1;
+
+		ip_proto = iph->protocol;
+		if (ip_proto != IPPROTO_TCP && ip_proto != IPPROTO_UDP)
+			return -1;
+		nhoff += iph->ihl * 4;
+
+		key_control = skb_flow_dissector_target(flow_dissector,
+							FLOW_DISSECTOR_KEY_CONTROL,
+							target_container);
+		if (dissector_uses_key(flow_dissector,
+				       FLOW_DISSECTOR_KEY_IPV4_ADDRS)) {
+			key_addrs = skb_flow_dissector_target(flow_dissector,
+							      FLOW_DISSECTOR_KEY_IPV4_ADDRS,
+							      target_container);
+			memcpy(&key_addrs->v4addrs.src, &iph->saddr,
+			       sizeof(key_addrs->v4addrs.src));
+			memcpy(&key_addrs->v4addrs.dst, &iph->daddr,
+			       sizeof(key_addrs->v4addrs.dst));
+			key_control->addr_type = FLOW_DISSECTOR_KEY_IPV4_ADDRS;
+		}
+	} else if (proto == htons(ETH_P_IPV6)) {
+		const struct ipv6hdr *iph;
+		struct ipv6hdr _iph;
+		__be32 flow_label;
+
+		iph = __skb_header_pointer(skb, nhoff, sizeof(_iph), data, hlen,
+					   &_iph);
+		if (!iph)
+			return -1;
+
+		ip_proto = iph->nexthdr;
+		if (ip_proto != IPPROTO_TCP && ip_proto != IPPROTO_UDP)
+			return -1;
+		nhoff += sizeof(struct ipv6hdr);
+
+		key_control = skb_flow_dissector_target(flow_dissector,
+							FLOW_DISSECTOR_KEY_CONTROL,
+							target_container);
+		if (dissector_uses_key(flow_dissector,
+				       FLOW_DISSECTOR_KEY_IPV6_ADDRS)) {
+			key_addrs = skb_flow_dissector_target(flow_dissector,
+							      FLOW_DISSECTOR_KEY_IPV6_ADDRS,
+							      target_container);
+			memcpy(&key_addrs->v6addrs.src, &iph->saddr,
+			       sizeof(key_addrs->v6addrs.src));
+			memcpy(&key_addrs->v6addrs.dst, &iph->daddr,
+			       sizeof(key_addrs->v6addrs.dst));
+			key_control->addr_type = FLOW_DISSECTOR_KEY_IPV6_ADDRS;
+		}
+
+		flow_label = ip6_flowlabel(iph);
+		if (flow_label) {
+			if (dissector_uses_key(flow_dissector,
+					       FLOW_DISSECTOR_KEY_FLOW_LABEL)) {
+				struct flow_dissector_key_tags *key_tags;
+
+				key_tags = skb_flow_dissector_target(flow_dissector,
+								     FLOW_DISSECTOR_KEY_FLOW_LABEL,
+								     target_container);
+				key_tags->flow_label = ntohl(flow_label);
+			}
+			if (flags & FLOW_DISSECTOR_F_STOP_AT_FLOW_LABEL)
+				l4 = false;
+		}
+	} else {
+		return -1;
+	}
+
+	if (vlan_tpid &&
+	    dissector_uses_key(flow_dissector, FLOW_DISSECTOR_KEY_VLAN)) {
+		struct flow_dissector_key_vlan *key_vlan;
+
+		key_vlan = skb_flow_dissector_target(flow_dissector,
+						     FLOW_DISSECTOR_KEY_VLAN,
+						     target_container);
+		key_vlan->vlan_id = skb_vlan_tag_get_id(skb);
+		key_vlan->vlan_priority = skb_vlan_tag_get_prio(skb);
+		key_vlan->vlan_tpid = vlan_tpid;
+		key_vlan->vlan_eth_type = proto;
+	}
+
+	if (l4 && dissector_uses_key(flow_dissector, FLOW_DISSECTOR_KEY_PORTS)) {
+		struct flow_dissector_key_ports *key_ports;
+
+		key_ports = skb_flow_dissector_target(flow_dissector,
+						      FLOW_DISSECTOR_KEY_PORTS,
+						      target_container);
+		key_ports->ports = __skb_flow_get_ports(skb, nhoff, ip_proto,
+							data, hlen);
+	}
+
+	key_basic = skb_flow_dissector_target(flow_dissector,
+					      FLOW_DISSECTOR_KEY_BASIC,
+					      target_container);
+	key_control->thoff = min_t(u16, nhoff, skb ? skb->len : hlen);
+	key_basic->n_proto = proto;
+	key_basic->ip_proto = ip_proto;
+
+	return 1;
+}
+
 /**
  * __skb_flow_dissect - extract the flow_keys struct and return it
  * @net: associated network namespace, derived from @skb if NULL
@@ -1158,6 +1308,11 @@ bool __skb_flow_dissect(const struct net *net,
 		key_num_of_vlans->num_of_vlans = 0;
 	}
 
+	if (flow_dissector->fast_path &&
+	    __skb_flow_dissect_fast(skb, flow_dissector, target_container,
+				    data, proto, nhoff, hlen, flags) > 0)
+		return true;
+
 proto_again:
 	fdret = FLOW_DISSECT_RET_CONTINUE;
 
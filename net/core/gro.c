@@ -6,6 +6,9 @@
 
 #define MAX_GRO_SKBS 8
 
+/* Grow the gro hash once a poll cycle evicts this many flows */
+#define GRO_HASH_GROW_EVICTIONS 8
+
 /* This should be increased if a protocol with a bigger head is added. */
 #define GRO_MAX_HEAD (MAX_HEADER + 128)
 
@@ -240,6 +243,9 @@ static void napi_gro_complete(struct napi_struct *napi, struct sk_buff *skb)
 
 	BUILD_BUG_ON(sizeof(struct napi_gro_cb) > sizeof(skb->cb));
 
+	napi->gro_aggregates++;
+	napi->gro_segments += NAPI_GRO_CB(skb)->count;
+
 	if (NAPI_GRO_CB(skb)->count == 1) {
 		skb_shinfo(skb)->gso_size = 0;
 		goto out;
@@ -280,24 +286,74 @@ static void __napi_gro_flush_chain(struct napi_struct *napi, u32 index,
 		napi_gro_complete(napi, skb);
 		napi->gro_hash[index].count--;
 	}
-
-	if (!napi->gro_hash[index].count)
-		__clear_bit(index, &napi->gro_bitmask);
 }
 
 /* napi->gro_hash[].list contains packets ordered by age.
  * youngest packets at the head of it.
  * Complete skbs in reverse order to reduce latencies.
  */
-void napi_gro_flush(struct napi_struct *napi, bool flush_old)
+static void __napi_gro_flush(struct napi_struct *napi, bool flush_old)
 {
 	unsigned long bitmask = napi->gro_bitmask;
-	unsigned int i, base = ~0U;
+	unsigned int shift = napi->gro_hash_shift;
+	unsigned int i, index;
+
+	for_each_set_bit(i, &bitmask, BITS_PER_LONG) {
+		bool empty = true;
+
+		for (index = i << shift; index < (i + 1) << shift; index++) {
+			if (!napi->gro_hash[index].count)
+				continue;
+			__napi_gro_flush_chain(napi, index, flush_old);
+			if (napi->gro_hash[index].count)
+				empty = false;
+		}
 
-	while ((i = ffs(bitmask)) != 0) {
-		bitmask >>= i;
-		base += i;
-		__napi_gro_flush_chain(napi, base, flush_old);
+		if (empty)
+			__clear_bit(i, &napi->gro_bitmask);
+	}
+}
+
+/*
+ * Too many flows for the gro hash to hold: make it larger. Held packets are
+ * hashed to the old buckets, so they are all completed first.
+ */
+static void gro_hash_grow(struct napi_struct *napi)
+{
+	unsigned int i, size = napi->gro_hash_mask + 1;
+	struct gro_list *hash;
+
+	if (size >= GRO_HASH_BUCKETS_MAX)
+		return;
+
+	size = min(size * 4, GRO_HASH_BUCKETS_MAX);
+	hash = kmalloc_array(size, sizeof(*hash), GFP_ATOMIC | __GFP_NOWARN);
+	if (!hash)
+		return;
+
+	for (i = 0; i < size; i++) {
+		INIT_LIST_HEAD(&hash[i].list);
+		hash[i].count = 0;
+	}
+
+	__napi_gro_flush(napi, false);
+	WARN_ON_ONCE(napi->gro_bitmask);
+
+	if (napi->gro_hash != napi->gro_hash_inline)
+		kfree(napi->gro_hash);
+	napi->gro_hash = hash;
+	WRITE_ONCE(napi->gro_hash_mask, size - 1);
+	napi->gro_hash_shift = ilog2(size) - ilog2(min(size, BITS_PER_LONG));
+}
+
+void napi_gro_flush(struct napi_struct *napi, bool flush_old)
+{
+	__napi_gro_flush(napi, flush_old);
+
+	if (unlikely(napi->gro_hash_evicted)) {
+		if (napi->gro_hash_evicted >= GRO_HASH_GROW_EVICTIONS)
+			gro_hash_grow(napi);
+		napi->gro_hash_evicted = 0;
 	}
 }
 EXPORT_SYMBOL(napi_gro_flush);
@@ -437,11 +493,14 @@ static void gro_flush_oldest(struct napi_struct *napi, struct list_head *head)
 	 */
 	skb_list_del_init(oldest);
 	napi_gro_complete(napi, oldest);
+	napi->gro_hash_evicted++;
+	napi->gro_evictions++;
 }
 
 static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff *skb)
 {
-	u32 bucket = skb_get_hash_raw(skb) & (GRO_HASH_BUCKETS - 1);
+	u32 bucket = skb_get_hash_raw(skb) & napi->gro_hash_mask;
+	u32 group = bucket >> napi->gro_hash_shift;
 	struct gro_list *gro_list = &napi->gro_hash[bucket];
 	struct list_head *head = &net_hotdata.offload_base;
 	struct packet_offload *ptype;
@@ -532,11 +591,15 @@ static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff
 	list_add(&skb->list, &gro_list->list);
 	ret = GRO_HELD;
 ok:
+	/*
+	 * A bit shared by several buckets can't be cleared here without
+	 * checking them all, it is left to napi_gro_flush() instead.
+	 */
 	if (gro_list->count) {
-		if (!test_bit(bucket, &napi->gro_bitmask))
-			__set_bit(bucket, &napi->gro_bitmask);
-	} else if (test_bit(bucket, &napi->gro_bitmask)) {
-		__clear_bit(bucket, &napi->gro_bitmask);
+		if (!test_bit(group, &napi->gro_bitmask))
+			__set_bit(group, &napi->gro_bitmask);
+	} else if (!napi->gro_hash_shift && test_bit(group, &napi->gro_bitmask)) {
+		__clear_bit(group, &napi->gro_bitmask);
 	}
 
 	return ret;
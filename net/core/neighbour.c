@@ -943,12 +943,18 @@ static void neigh_connect(struct neighbour *neigh)
 	WRITE_ONCE(neigh->output, neigh->ops->connected_output);
 }
 
+/* neigh_periodic_work() scans the hash table in this many slices, one per
+ * run, rather than all of it at once.
+ */
+#define NEIGH_GC_SLICES	16
+
 static void neigh_periodic_work(struct work_struct *work)
 {
 	struct neigh_table *tbl = container_of(work, struct neigh_table, gc_work.work);
+	unsigned long delay = NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1;
 	struct neighbour *n;
 	struct neighbour __rcu **np;
-	unsigned int i;
+	unsigned int i, end, size;
 	struct neigh_hash_table *nht;
 
 	NEIGH_CACHE_STAT_INC(tbl, periodic_gc_runs);
@@ -970,10 +976,19 @@ static void neigh_periodic_work(struct work_struct *work)
 				neigh_rand_reach_time(NEIGH_VAR(p, BASE_REACHABLE_TIME));
 	}
 
-	if (atomic_read(&tbl->entries) < READ_ONCE(tbl->gc_thresh1))
+	if (atomic_read(&tbl->entries) < READ_ONCE(tbl->gc_thresh1)) {
+		tbl->gc_pos = 0;
 		goto out;
+	}
 
-	for (i = 0 ; i < (1 << nht->hash_shift); i++) {
+	/* The table may have been resized since the previous slice */
+	size = 1 << nht->hash_shift;
+	i = tbl->gc_pos < size ? tbl->gc_pos : 0;
+	end = min(size, i + max(size / NEIGH_GC_SLICES, 1U));
+	tbl->gc_pos = end < size ? end : 0;
+	delay = max(delay / NEIGH_GC_SLICES, 1UL);
+
+	for (; i < end; i++) {
 		np = &nht->hash_buckets[i];
 
 		while ((n = rcu_dereference_protected(*np,
@@ -1019,14 +1034,14 @@ static void neigh_periodic_work(struct work_struct *work)
 		write_lock_bh(&tbl->lock);
 		nht = rcu_dereference_protected(tbl->nht,
 						lockdep_is_held(&tbl->lock));
+		end = min(end, 1U << nht->hash_shift);
 	}
 out:
-	/* Cycle through all hash buckets every BASE_REACHABLE_TIME/2 ticks.
-	 * ARP entry timeouts range from 1/2 BASE_REACHABLE_TIME to 3/2
-	 * BASE_REACHABLE_TIME.
+	/* Cycle through all hash buckets every BASE_REACHABLE_TIME/2 ticks,
+	 * one slice at a time. ARP entry timeouts range from 1/2
+	 * BASE_REACHABLE_TIME to 3/2 BASE_REACHABLE_TIME.
 	 */
-	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work,
-			      NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1);
+	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work, delay);
 	write_unlock_bh(&tbl->lock);
 }
 
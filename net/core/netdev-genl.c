@@ -188,6 +188,19 @@ netdev_nl_napi_fill_one(struct sk_buff *rsp, struct napi_struct *napi,
 			goto nla_put_failure;
 	}
 
+	/* Updated locklessly by the poller, good enough for statistics */
+	if (nla_put_u32(rsp, NETDEV_A_NAPI_GRO_BUCKETS,
+			READ_ONCE(napi->gro_hash_mask) + 1) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_AGGREGATES,
+			 READ_ONCE(napi->gro_aggregates)) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_SEGMENTS,
+			 READ_ONCE(napi->gro_segments)) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_EVICTIONS,
+			 READ_ONCE(napi->gro_evictions)) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_IRQ_SUSPEND_TIMEOUT,
+			 READ_ONCE(napi->irq_suspend_timeout)))
+		goto nla_put_failure;
+
 	genlmsg_end(rsp, hdr);
 
 	return 0;
@@ -233,6 +246,33 @@ int netdev_nl_napi_get_doit(struct sk_buff *skb, struct genl_info *info)
 	return err;
 }
 
+int netdev_nl_napi_set_doit(struct sk_buff *skb, struct genl_info *info)
+{
+	struct napi_struct *napi;
+	u32 napi_id;
+	int err = 0;
+
+	if (GENL_REQ_ATTR_CHECK(info, NETDEV_A_NAPI_ID))
+		return -EINVAL;
+
+	napi_id = nla_get_u32(info->attrs[NETDEV_A_NAPI_ID]);
+
+	rtnl_lock();
+
+	napi = napi_by_id(napi_id);
+	if (!napi) {
+		NL_SET_BAD_ATTR(info->extack, info->attrs[NETDEV_A_NAPI_ID]);
+		err = -ENOENT;
+	} else if (info->attrs[NETDEV_A_NAPI_IRQ_SUSPEND_TIMEOUT]) {
+		WRITE_ONCE(napi->irq_suspend_timeout,
+			   nla_get_uint(info->attrs[NETDEV_A_NAPI_IRQ_SUSPEND_TIMEOUT]));
+	}
+
+	rtnl_unlock();
+
+	return err;
+}
+
 static int
 netdev_nl_napi_dump_one(struct net_device *netdev, struct sk_buff *rsp,
 			const struct genl_info *info,
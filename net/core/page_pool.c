@@ -60,6 +60,8 @@ static const char pp_stats[][ETH_GSTRING_LEN] = {
 	"rx_pp_recycle_ring",
 	"rx_pp_recycle_ring_full",
 	"rx_pp_recycle_released_ref",
+	"rx_pp_recycle_remote",
+	"rx_pp_recycle_remote_flush",
 };
 
 /**
@@ -98,6 +100,8 @@ bool page_pool_get_stats(const struct page_pool *pool,
 		stats->recycle_stats.ring += pcpu->ring;
 		stats->recycle_stats.ring_full += pcpu->ring_full;
 		stats->recycle_stats.released_refcnt += pcpu->released_refcnt;
+		stats->recycle_stats.remote += pcpu->remote;
+		stats->recycle_stats.remote_flush += pcpu->remote_flush;
 	}
 
 	return true;
@@ -138,6 +142,8 @@ u64 *page_pool_ethtool_stats_get(u64 *data, void *stats)
 	*data++ = pool_stats->recycle_stats.ring;
 	*data++ = pool_stats->recycle_stats.ring_full;
 	*data++ = pool_stats->recycle_stats.released_refcnt;
+	*data++ = pool_stats->recycle_stats.remote;
+	*data++ = pool_stats->recycle_stats.remote_flush;
 
 	return data;
 }
@@ -638,6 +644,132 @@ static bool page_pool_recycle_in_ring(struct page_pool *pool, struct page *page)
 	return false;
 }
 
+/* Pages freed away from the CPU running the pool's NAPI are batched in a
+ * per-cpu return cache, and go to the ptr_ring in bulk under a single
+ * producer lock. The cache holds pages of one pool at a time, it is flushed
+ * when full, when a page of another pool is freed on the CPU, and by pool
+ * destruction, whose inflight pages may sit in it.
+ */
+#define PP_REMOTE_CACHE_SIZE	32
+
+struct page_pool_remote_cache {
+	struct page_pool *pool;
+	unsigned int count;
+	struct page *pages[PP_REMOTE_CACHE_SIZE];
+	struct work_struct flush_work;
+};
+
+static DEFINE_PER_CPU(struct page_pool_remote_cache, pp_remote_caches);
+
+/* Called with BH disabled */
+static void page_pool_remote_flush(struct page_pool_remote_cache *c)
+{
+	struct page_pool *pool = c->pool;
+	unsigned int i, count = c->count;
+	bool in_softirq;
+
+	if (!count)
+		return;
+
+	in_softirq = page_pool_producer_lock(pool);
+	for (i = 0; i < count; i++) {
+		if (__ptr_ring_produce(&pool->ring, c->pages[i]))
+			break;
+	}
+	page_pool_producer_unlock(pool, in_softirq);
+
+	c->count = 0;
+	recycle_stat_add(pool, ring, i);
+	recycle_stat_inc(pool, remote_flush);
+	if (i < count)
+		recycle_stat_add(pool, ring_full, count - i);
+
+	/* The pool may go away with the last page, see page_pool_return_page() */
+	for (; i < count; i++)
+		page_pool_return_page(pool, c->pages[i]);
+}
+
+static void page_pool_remote_flush_work(struct work_struct *work)
+{
+	struct page_pool_remote_cache *c;
+
+	c = container_of(work, struct page_pool_remote_cache, flush_work);
+	local_bh_disable();
+	page_pool_remote_flush(c);
+	local_bh_enable();
+}
+
+/* Kick the flush of the return caches holding pages of @pool */
+static void page_pool_remote_kick(struct page_pool *pool)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct page_pool_remote_cache *c = per_cpu_ptr(&pp_remote_caches,
+							       cpu);
+
+		if (READ_ONCE(c->pool) == pool && READ_ONCE(c->count))
+			schedule_work_on(cpu, &c->flush_work);
+	}
+}
+
+/* Whether a page of @pool freed on this CPU can go to the return cache.
+ * That needs a known consumer CPU, from the pool's NAPI or pool->cpuid, and
+ * this CPU not being it. Pools without one would have every free treated as
+ * remote, and their allocations would starve on the cached pages.
+ */
+static bool page_pool_can_batch_remote(const struct page_pool *pool)
+{
+	const struct napi_struct *napi = READ_ONCE(pool->p.napi);
+	int cpuid = READ_ONCE(pool->cpuid);
+	int this_cpu = smp_processor_id();
+
+	if (napi) {
+		int owner = READ_ONCE(napi->list_owner);
+
+		return owner != -1 && owner != this_cpu && cpuid != this_cpu;
+	}
+
+	return cpuid != -1 && cpuid != this_cpu;
+}
+
+static bool page_pool_recycle_remote(struct page_pool *pool, struct page *page)
+{
+	struct page_pool_remote_cache *c;
+	bool ret = false;
+
+	local_bh_disable();
+	if (!page_pool_can_batch_remote(pool))
+		goto out;
+
+	c = this_cpu_ptr(&pp_remote_caches);
+	if (c->pool != pool) {
+		page_pool_remote_flush(c);
+		WRITE_ONCE(c->pool, pool);
+	}
+
+	c->pages[c->count] = page;
+	WRITE_ONCE(c->count, c->count + 1);
+	recycle_stat_inc(pool, remote);
+	if (c->count == PP_REMOTE_CACHE_SIZE)
+		page_pool_remote_flush(c);
+	ret = true;
+out:
+	local_bh_enable();
+	return ret;
+}
+
+static int __init page_pool_remote_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		INIT_WORK(&per_cpu_ptr(&pp_remote_caches, cpu)->flush_work,
+			  page_pool_remote_flush_work);
+	return 0;
+}
+core_initcall(page_pool_remote_init);
+
 /* Only allow direct recycling in special circumstances, into the
  * alloc side cache.  E.g. during RX-NAPI processing for XDP_DROP use-case.
  *
@@ -720,7 +852,8 @@ void page_pool_put_unrefed_page(struct page_pool *pool, struct page *page,
 				unsigned int dma_sync_size, bool allow_direct)
 {
 	page = __page_pool_put_page(pool, page, dma_sync_size, allow_direct);
-	if (page && !page_pool_recycle_in_ring(pool, page)) {
+	if (page && !page_pool_recycle_remote(pool, page) &&
+	    !page_pool_recycle_in_ring(pool, page)) {
 		/* Cache full, fallback to free pages */
 		recycle_stat_inc(pool, ring_full);
 		page_pool_return_page(pool, page);
@@ -924,6 +1057,7 @@ static int page_pool_release(struct page_pool *pool)
 {
 	int inflight;
 
+	page_pool_remote_kick(pool);
 	page_pool_scrub(pool);
 	inflight = page_pool_inflight(pool, true);
 	if (!inflight)
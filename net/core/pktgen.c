@@ -240,6 +240,10 @@ static char *pkt_flag_names[] = {
 #define PKTGEN_MAGIC 0xbe9be955
 #define PG_PROC_DIR "pktgen"
 #define PGCTRL	    "pgctrl"
+#define PGRX	    "pgrx"
+
+/* Receive latency histogram, bucket n counts latencies below 2^n us */
+#define PG_RX_HIST_BUCKETS 24
 
 #define MAX_CFLOWS  65536
 
@@ -445,11 +449,27 @@ struct pktgen_hdr {
 
 static unsigned int pg_net_id __read_mostly;
 
+struct pktgen_rx_stats {
+	u64 packets;
+	u64 bytes;
+	u64 lat_samples;
+	u64 lat_sum_us;
+	u64 lat_max_us;
+	u64 lat_hist[PG_RX_HIST_BUCKETS];
+};
+
 struct pktgen_net {
 	struct net		*net;
 	struct proc_dir_entry	*proc_dir;
 	struct list_head	pktgen_threads;
 	bool			pktgen_exiting;
+
+	/* Receive side, counts the pktgen packets arriving in this netns */
+	bool			rx_running;
+	ktime_t			rx_started;
+	struct pktgen_rx_stats __percpu *rx_stats;
+	struct packet_type	rx_pt4;
+	struct packet_type	rx_pt6;
 };
 
 struct pktgen_thread {
@@ -558,6 +578,231 @@ static const struct proc_ops pktgen_proc_ops = {
 	.proc_release	= single_release,
 };
 
+/*
+ * Receive side: packets carrying a pktgen header are counted at delivery
+ * from NAPI, and the latency from their transmit timestamp goes into a
+ * histogram. Sender and receiver clocks must be synchronized, as they are
+ * when both run on the same host.
+ */
+static int pktgen_rx(struct sk_buff *skb, struct net_device *dev,
+		     struct packet_type *pt, struct net_device *orig_dev)
+{
+	struct pktgen_net *pn = pt->af_packet_priv;
+	struct pktgen_hdr _pgh, *pgh;
+	struct pktgen_rx_stats *stats;
+	struct timespec64 now;
+	int off;
+
+	if (skb->pkt_type == PACKET_OTHERHOST || !net_eq(dev_net(dev), pn->net))
+		goto out;
+
+	if (skb->protocol == htons(ETH_P_IP)) {
+		struct iphdr _iph, *iph;
+
+		iph = skb_header_pointer(skb, 0, sizeof(_iph), &_iph);
+		if (!iph || iph->ihl < 5 || iph->protocol != IPPROTO_UDP ||
+		    ip_is_fragment(iph))
+			goto out;
+		off = iph->ihl * 4;
+	} else {
+		struct ipv6hdr _ip6h, *ip6h;
+
+		ip6h = skb_header_pointer(skb, 0, sizeof(_ip6h), &_ip6h);
+		if (!ip6h || ip6h->nexthdr != IPPROTO_UDP)
+			goto out;
+		off = sizeof(*ip6h);
+	}
+
+	pgh = skb_header_pointer(skb, off + sizeof(struct udphdr),
+				 sizeof(_pgh), &_pgh);
+	if (!pgh || pgh->pgh_magic != htonl(PKTGEN_MAGIC))
+		goto out;
+
+	/* Called from the receive path with BHs disabled */
+	stats = this_cpu_ptr(pn->rx_stats);
+	stats->packets++;
+	stats->bytes += skb->len;
+
+	if (pgh->tv_sec || pgh->tv_usec) {
+		s64 lat;
+		int b;
+
+		ktime_get_real_ts64(&now);
+		lat = (s64)(s32)((u32)now.tv_sec - ntohl(pgh->tv_sec)) *
+		      USEC_PER_SEC + now.tv_nsec / NSEC_PER_USEC -
+		      ntohl(pgh->tv_usec);
+		if (lat >= 0) {
+			b = lat ? min_t(int, ilog2(lat) + 1,
+					PG_RX_HIST_BUCKETS - 1) : 0;
+			stats->lat_samples++;
+			stats->lat_sum_us += lat;
+			stats->lat_max_us = max_t(u64, stats->lat_max_us, lat);
+			stats->lat_hist[b]++;
+		}
+	}
+out:
+	consume_skb(skb);
+	return NET_RX_SUCCESS;
+}
+
+static int pktgen_rx_start(struct pktgen_net *pn)
+{
+	int cpu;
+
+	if (pn->rx_running)
+		return 0;
+
+	if (!pn->rx_stats) {
+		pn->rx_stats = alloc_percpu(struct pktgen_rx_stats);
+		if (!pn->rx_stats)
+			return -ENOMEM;
+	}
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(pn->rx_stats, cpu), 0,
+		       sizeof(struct pktgen_rx_stats));
+
+	pn->rx_pt4.type = htons(ETH_P_IP);
+	pn->rx_pt4.func = pktgen_rx;
+	pn->rx_pt4.af_packet_priv = pn;
+	pn->rx_pt6.type = htons(ETH_P_IPV6);
+	pn->rx_pt6.func = pktgen_rx;
+	pn->rx_pt6.af_packet_priv = pn;
+
+	pn->rx_started = ktime_get();
+	dev_add_pack(&pn->rx_pt4);
+	dev_add_pack(&pn->rx_pt6);
+	pn->rx_running = true;
+	return 0;
+}
+
+static void pktgen_rx_stop(struct pktgen_net *pn)
+{
+	if (!pn->rx_running)
+		return;
+
+	dev_remove_pack(&pn->rx_pt6);
+	dev_remove_pack(&pn->rx_pt4);
+	pn->rx_running = false;
+}
+
+static int pgrx_show(struct seq_file *seq, void *v)
+{
+	static const unsigned int pct[] = { 500, 900, 990, 999 };
+	struct pktgen_net *pn = seq->private;
+	struct pktgen_rx_stats sum = {};
+	u64 elapsed, cum;
+	int cpu, b, i;
+
+	mutex_lock(&pktgen_thread_lock);
+	seq_printf(seq, "rx: %s\n", pn->rx_running ? "running" : "stopped");
+	if (!pn->rx_stats)
+		goto unlock;
+
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), pn->rx_started));
+	for_each_possible_cpu(cpu) {
+		const struct pktgen_rx_stats *s = per_cpu_ptr(pn->rx_stats, cpu);
+		u64 packets = READ_ONCE(s->packets);
+
+		if (packets)
+			seq_printf(seq, "cpu%d: pkts %llu pps %llu\n", cpu,
+				   packets, elapsed ? div64_u64(packets *
+				   NSEC_PER_SEC, elapsed) : 0);
+		sum.packets += packets;
+		sum.bytes += READ_ONCE(s->bytes);
+		sum.lat_samples += READ_ONCE(s->lat_samples);
+		sum.lat_sum_us += READ_ONCE(s->lat_sum_us);
+		sum.lat_max_us = max(sum.lat_max_us, READ_ONCE(s->lat_max_us));
+		for (b = 0; b < PG_RX_HIST_BUCKETS; b++)
+			sum.lat_hist[b] += READ_ONCE(s->lat_hist[b]);
+	}
+
+	seq_printf(seq, "pkts: %llu bytes: %llu pps: %llu\n", sum.packets,
+		   sum.bytes, elapsed ? div64_u64(sum.packets * NSEC_PER_SEC,
+						  elapsed) : 0);
+	if (!sum.lat_samples)
+		goto unlock;
+
+	seq_printf(seq, "latency_us: samples %llu avg %llu max %llu\n",
+		   sum.lat_samples, div64_u64(sum.lat_sum_us, sum.lat_samples),
+		   sum.lat_max_us);
+
+	/* Percentiles are given as the upper bound of their bucket */
+	seq_puts(seq, "latency_us_percentiles:");
+	for (i = 0, b = 0, cum = 0; i < ARRAY_SIZE(pct); i++) {
+		for (; b < PG_RX_HIST_BUCKETS - 1; b++) {
+			if ((cum + sum.lat_hist[b]) * 1000 >=
+			    sum.lat_samples * pct[i])
+				break;
+			cum += sum.lat_hist[b];
+		}
+		seq_printf(seq, " p%u.%u<%llu", pct[i] / 10, pct[i] % 10,
+			   1ULL << b);
+	}
+	seq_puts(seq, "\nlatency_us_hist:");
+	for (b = 0; b < PG_RX_HIST_BUCKETS; b++)
+		seq_printf(seq, " %llu", sum.lat_hist[b]);
+	seq_putc(seq, '\n');
+unlock:
+	mutex_unlock(&pktgen_thread_lock);
+	return 0;
+}
+
+static ssize_t pgrx_write(struct file *file, const char __user *buf,
+			  size_t count, loff_t *ppos)
+{
+	struct seq_file *seq = file->private_data;
+	struct pktgen_net *pn = seq->private;
+	char data[128];
+	int ret = 0;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	if (count == 0)
+		return -EINVAL;
+
+	if (count > sizeof(data))
+		count = sizeof(data);
+
+	if (copy_from_user(data, buf, count))
+		return -EFAULT;
+
+	data[count - 1] = 0;	/* Strip trailing '\n' and terminate string */
+
+	mutex_lock(&pktgen_thread_lock);
+	if (!strcmp(data, "start")) {
+		ret = pktgen_rx_start(pn);
+	} else if (!strcmp(data, "stop")) {
+		pktgen_rx_stop(pn);
+	} else if (!strcmp(data, "reset")) {
+		if (pn->rx_running) {
+			pktgen_rx_stop(pn);
+			ret = pktgen_rx_start(pn);
+		} else {
+			free_percpu(pn->rx_stats);
+			pn->rx_stats = NULL;
+		}
+	} else {
+		ret = -EINVAL;
+	}
+	mutex_unlock(&pktgen_thread_lock);
+
+	return ret ? : count;
+}
+
+static int pgrx_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pgrx_show, pde_data(inode));
+}
+
+static const struct proc_ops pktgen_rx_proc_ops = {
+	.proc_open	= pgrx_open,
+	.proc_read	= seq_read,
+	.proc_lseek	= seq_lseek,
+	.proc_write	= pgrx_write,
+	.proc_release	= single_release,
+};
+
 static int pktgen_if_show(struct seq_file *seq, void *v)
 {
 	const struct pktgen_dev *pkt_dev = seq->private;
@@ -3988,6 +4233,13 @@ static int __net_init pg_net_init(struct net *net)
 		ret = -EINVAL;
 		goto remove;
 	}
+	pe = proc_create_data(PGRX, 0600, pn->proc_dir, &pktgen_rx_proc_ops,
+			      pn);
+	if (pe == NULL) {
+		pr_err("cannot create %s procfs entry\n", PGRX);
+		ret = -EINVAL;
+		goto remove_ctrl;
+	}
 
 	for_each_online_cpu(cpu) {
 		int err;
@@ -4007,6 +4259,8 @@ static int __net_init pg_net_init(struct net *net)
 	return 0;
 
 remove_entry:
+	remove_proc_entry(PGRX, pn->proc_dir);
+remove_ctrl:
 	remove_proc_entry(PGCTRL, pn->proc_dir);
 remove:
 	remove_proc_entry(PG_PROC_DIR, pn->net->proc_net);
@@ -4034,6 +4288,14 @@ static void __net_exit pg_net_exit(struct net *net)
 		kfree(t);
 	}
 
+	mutex_lock(&pktgen_thread_lock);
+	pktgen_rx_stop(pn);
+	mutex_unlock(&pktgen_thread_lock);
+
+	/* No pgrx reader can see the stats once the entry is gone */
+	remove_proc_entry(PGRX, pn->proc_dir);
+	free_percpu(pn->rx_stats);
+	pn->rx_stats = NULL;
 	remove_proc_entry(PGCTRL, pn->proc_dir);
 	remove_proc_entry(PG_PROC_DIR, pn->net->proc_net);
 }
@@ -1260,6 +1260,25 @@ struct skb_free_array {
 	void *skb_array[KFREE_SKB_BULK_SIZE];
 };
 
+static void napi_skb_cache_put(struct sk_buff *skb);
+
+/* Recycle the heads through the per-cpu NAPI cache when BH can be disabled */
+static void kfree_skb_flush_bulk(struct skb_free_array *sa)
+{
+	unsigned int i;
+
+	if (in_hardirq() || irqs_disabled()) {
+		kmem_cache_free_bulk(net_hotdata.skbuff_cache, sa->skb_count,
+				     sa->skb_array);
+	} else {
+		local_bh_disable();
+		for (i = 0; i < sa->skb_count; i++)
+			napi_skb_cache_put(sa->skb_array[i]);
+		local_bh_enable();
+	}
+	sa->skb_count = 0;
+}
+
 static void kfree_skb_add_bulk(struct sk_buff *skb,
 			       struct skb_free_array *sa,
 			       enum skb_drop_reason reason)
@@ -1273,11 +1292,8 @@ static void kfree_skb_add_bulk(struct sk_buff *skb,
 	skb_release_all(skb, reason, false);
 	sa->skb_array[sa->skb_count++] = skb;
 
-	if (unlikely(sa->skb_count == KFREE_SKB_BULK_SIZE)) {
-		kmem_cache_free_bulk(net_hotdata.skbuff_cache, KFREE_SKB_BULK_SIZE,
-				     sa->skb_array);
-		sa->skb_count = 0;
-	}
+	if (unlikely(sa->skb_count == KFREE_SKB_BULK_SIZE))
+		kfree_skb_flush_bulk(sa);
 }
 
 void __fix_address
@@ -1299,7 +1315,7 @@ kfree_skb_list_reason(struct sk_buff *segs, enum skb_drop_reason reason)
 	}
 
 	if (sa.skb_count)
-		kmem_cache_free_bulk(net_hotdata.skbuff_cache, sa.skb_count, sa.skb_array);
+		kfree_skb_flush_bulk(&sa);
 }
 EXPORT_SYMBOL(kfree_skb_list_reason);
 
@@ -1514,6 +1530,50 @@ void napi_consume_skb(struct sk_buff *skb, int budget)
 }
 EXPORT_SYMBOL(napi_consume_skb);
 
+/**
+ *	napi_consume_skb_bulk - free an array of transmitted skbs
+ *	@skbs: the skbs to free
+ *	@count: number of skbs in @skbs
+ *	@budget: NAPI budget, 0 when not called from NAPI
+ *
+ *	Bulk variant of napi_consume_skb() for TX completion. The skb heads
+ *	go to the per-cpu cache RX allocations are served from, instead of
+ *	back to the slab one at a time. Unlike napi_consume_skb(), it can
+ *	also be called outside of NAPI as long as BH can be disabled, and
+ *	falls back to dev_consume_skb_any() otherwise.
+ */
+void napi_consume_skb_bulk(struct sk_buff **skbs, unsigned int count,
+			   int budget)
+{
+	unsigned int i;
+
+	if (unlikely(in_hardirq() || irqs_disabled())) {
+		for (i = 0; i < count; i++)
+			dev_consume_skb_any(skbs[i]);
+		return;
+	}
+
+	local_bh_disable();
+	for (i = 0; i < count; i++) {
+		struct sk_buff *skb = skbs[i];
+
+		if (!skb_unref(skb))
+			continue;
+
+		trace_consume_skb(skb, __builtin_return_address(0));
+
+		if (skb->fclone != SKB_FCLONE_UNAVAILABLE) {
+			__kfree_skb(skb);
+			continue;
+		}
+
+		skb_release_all(skb, SKB_CONSUMED, !!budget);
+		napi_skb_cache_put(skb);
+	}
+	local_bh_enable();
+}
+EXPORT_SYMBOL(napi_consume_skb_bulk);
+
 /* Make sure a field is contained by headers group */
 #define CHECK_SKB_FIELD(field) \
 	BUILD_BUG_ON(offsetof(struct sk_buff, field) !=		\
@@ -5014,7 +5074,7 @@ void __init skb_init(void)
 					      sizeof(struct sk_buff),
 					      0,
 					      SLAB_HWCACHE_ALIGN|SLAB_PANIC|
-						FLAG_SKB_NO_MERGE,
+						SLAB_SHEAVES|FLAG_SKB_NO_MERGE,
 					      offsetof(struct sk_buff, cb),
 					      sizeof_field(struct sk_buff, cb),
 					      NULL);
@@ -1466,6 +1466,9 @@ int sk_setsockopt(struct sock *sk, int level, int optname,
 			      (sk->sk_type == SOCK_DGRAM &&
 			       sk->sk_protocol == IPPROTO_UDP)))
 				ret = -EOPNOTSUPP;
+		} else if (sk->sk_family == PF_UNIX) {
+			if (sk->sk_type != SOCK_STREAM)
+				ret = -EOPNOTSUPP;
 		} else if (sk->sk_family != PF_RDS) {
 			ret = -EOPNOTSUPP;
 		}
@@ -4155,20 +4158,38 @@ subsys_initcall(proto_init);
 #endif /* PROC_FS */
 
 #ifdef CONFIG_NET_RX_BUSY_POLL
-bool sk_busy_loop_end(void *p, unsigned long start_time)
+static bool sk_busy_loop_has_data(struct sock *sk)
 {
-	struct sock *sk = p;
-
 	if (!skb_queue_empty_lockless(&sk->sk_receive_queue))
 		return true;
 
-	if (sk_is_udp(sk) &&
-	    !skb_queue_empty_lockless(&udp_sk(sk)->reader_queue))
+	return sk_is_udp(sk) &&
+	       !skb_queue_empty_lockless(&udp_sk(sk)->reader_queue);
+}
+
+bool sk_busy_loop_end(void *p, unsigned long start_time)
+{
+	struct sock *sk = p;
+
+	if (sk_busy_loop_has_data(sk))
 		return true;
 
 	return sk_busy_loop_timeout(sk, start_time);
 }
 EXPORT_SYMBOL(sk_busy_loop_end);
+
+/*
+ * After a preferred busy poll: keep the NAPI's IRQs suspended while it keeps
+ * delivering data, give them back once the application is about to block.
+ */
+void sk_busy_loop_irq_suspend(struct sock *sk, unsigned int napi_id)
+{
+	if (sk_busy_loop_has_data(sk))
+		napi_suspend_irqs(napi_id);
+	else
+		napi_resume_irqs(napi_id);
+}
+EXPORT_SYMBOL(sk_busy_loop_irq_suspend);
 #endif /* CONFIG_NET_RX_BUSY_POLL */
 
 int sock_bind_add(struct sock *sk, struct sockaddr *addr, int addr_len)
@@ -4280,6 +4301,7 @@ static int __init sock_struct_check(void)
 	CACHELINE_ASSERT_GROUP_MEMBER(struct sock, sock_write_tx, sk_frag);
 	CACHELINE_ASSERT_GROUP_MEMBER(struct sock, sock_write_tx, sk_timer);
 	CACHELINE_ASSERT_GROUP_MEMBER(struct sock, sock_write_tx, sk_pacing_rate);
+	CACHELINE_ASSERT_GROUP_MEMBER(struct sock, sock_write_tx, sk_pacing_next_ns);
 	CACHELINE_ASSERT_GROUP_MEMBER(struct sock, sock_write_tx, sk_zckey);
 	CACHELINE_ASSERT_GROUP_MEMBER(struct sock, sock_write_tx, sk_tskey);
 
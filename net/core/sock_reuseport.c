@@ -556,6 +556,56 @@ static struct sock *reuseport_select_sock_by_hash(struct sock_reuseport *reuse,
 	return first_valid_sk;
 }
 
+/* Accept queue fill level of a listener, in percent of its backlog */
+static unsigned int reuseport_acceptq_load(const struct sock *sk)
+{
+	unsigned int max = READ_ONCE(sk->sk_max_ack_backlog);
+
+	return max ? READ_ONCE(sk->sk_ack_backlog) * 100U / max : 100U;
+}
+
+/*
+ * With net.ipv4.tcp_reuseport_overload set, a listener whose accept queue is
+ * filled beyond that percentage of its backlog gives new connections to the
+ * least loaded listener of the group instead, so that an application thread
+ * falling behind, or a flash crowd hitting one RX queue, does not turn into
+ * SYN drops while other listeners are idle. Preference for the listener on
+ * the RX CPU (SO_INCOMING_CPU) is kept as long as it can keep up.
+ */
+static struct sock *reuseport_balance_overload(struct sock_reuseport *reuse,
+					       struct sock *sk, u16 num_socks)
+{
+	unsigned int thresh, load, min_load;
+	struct sock *min_sk = sk;
+	int i;
+
+	if (sk->sk_protocol != IPPROTO_TCP || sk->sk_state != TCP_LISTEN)
+		return sk;
+
+	thresh = READ_ONCE(sock_net(sk)->ipv4.sysctl_tcp_reuseport_overload);
+	if (!thresh)
+		return sk;
+
+	min_load = reuseport_acceptq_load(sk);
+	if (min_load < thresh)
+		return sk;
+
+	for (i = 0; i < num_socks; i++) {
+		struct sock *sk2 = reuse->socks[i];
+
+		if (sk2->sk_state != TCP_LISTEN)
+			continue;
+
+		load = reuseport_acceptq_load(sk2);
+		if (load < min_load) {
+			min_load = load;
+			min_sk = sk2;
+		}
+	}
+
+	return min_sk;
+}
+
 /**
  *  reuseport_select_sock - Select a socket from an SO_REUSEPORT group.
  *  @sk: First socket in the group.
@@ -599,8 +649,12 @@ struct sock *reuseport_select_sock(struct sock *sk,
 
 select_by_hash:
 		/* no bpf or invalid bpf result: fall back to hash usage */
-		if (!sk2)
+		if (!sk2) {
 			sk2 = reuseport_select_sock_by_hash(reuse, hash, socks);
+			if (sk2)
+				sk2 = reuseport_balance_overload(reuse, sk2,
+								 socks);
+		}
 	}
 
 out:
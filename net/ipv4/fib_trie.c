@@ -61,6 +61,7 @@
 #include <linux/export.h>
 #include <linux/vmalloc.h>
 #include <linux/notifier.h>
+#include <linux/workqueue.h>
 #include <net/net_namespace.h>
 #include <net/inet_dscp.h>
 #include <net/ip.h>
@@ -164,11 +165,32 @@ struct trie_stat {
 	unsigned int nodesizes[MAX_STAT_DEPTH];
 };
 
+/* Where fib_table_lookup() would be after looking at the top ACCEL_BITS
+ * bits of the key only, for every value of those bits. This skips the
+ * first levels of the trie, which are the same for all keys of a /16.
+ */
+#define ACCEL_BITS	16
+
+struct fib_trie_accel_ent {
+	struct key_vector *n;
+	struct key_vector *pn;
+	t_key cindex;
+};
+
+struct fib_trie_accel {
+	struct rcu_head rcu;
+	unsigned int gen;	/* trie generation it was built for */
+	struct fib_trie_accel_ent ent[1 << ACCEL_BITS];
+};
+
 struct trie {
 	struct key_vector kv[1];
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	struct trie_use_stats __percpu *stats;
 #endif
+	struct fib_trie_accel __rcu *accel;
+	unsigned int gen;	/* bumped under RTNL before any change */
+	struct delayed_work accel_work;
 };
 
 static struct key_vector *resize(struct trie *t, struct key_vector *tn);
@@ -183,6 +205,9 @@ unsigned int sysctl_fib_sync_mem = 512 * 1024;
 unsigned int sysctl_fib_sync_mem_min = 64 * 1024;
 unsigned int sysctl_fib_sync_mem_max = 64 * 1024 * 1024;
 
+/* Build the direct index of the first lookup levels, see fib_trie_accel */
+int sysctl_fib_trie_accel __read_mostly;
+
 static struct kmem_cache *fn_alias_kmem __ro_after_init;
 static struct kmem_cache *trie_leaf_kmem __ro_after_init;
 
@@ -1213,6 +1238,89 @@ static void fib_remove_alias(struct trie *t, struct key_vector *tp,
 			     struct key_vector *l, struct fib_alias *old);
 
 /* Caller must hold RTNL. */
+static void fib_trie_accel_build(struct trie *t)
+{
+	struct fib_trie_accel *acc = NULL, *old = rtnl_dereference(t->accel);
+	struct key_vector *root = get_child(t->kv, 0);
+	unsigned long i;
+
+	/* Nothing to skip if the first node already looks at the low bits */
+	if (READ_ONCE(sysctl_fib_trie_accel) && root &&
+	    root->pos >= KEYLENGTH - ACCEL_BITS)
+		acc = kvmalloc(sizeof(*acc), GFP_KERNEL);
+
+	if (acc) {
+		acc->gen = t->gen;
+		for (i = 0; i < (1ul << ACCEL_BITS); i++) {
+			t_key key = (t_key)i << (KEYLENGTH - ACCEL_BITS);
+			struct key_vector *n = root, *pn = t->kv, *c;
+			unsigned long index;
+			t_key cindex = 0;
+
+			/* Same descent as fib_table_lookup(), stopping at the
+			 * first node whose check depends on the low bits.
+			 */
+			while (IS_TNODE(n) && n->pos >= KEYLENGTH - ACCEL_BITS) {
+				index = get_cindex(key, n);
+				if (index >= (1ul << n->bits))
+					break;
+				c = get_child(n, index);
+				if (!c)
+					break;
+				if (n->slen > n->pos) {
+					pn = n;
+					cindex = index;
+				}
+				n = c;
+			}
+
+			acc->ent[i].n = n;
+			acc->ent[i].pn = pn;
+			acc->ent[i].cindex = cindex;
+		}
+	}
+
+	rcu_assign_pointer(t->accel, acc);
+	if (old)
+		kvfree_rcu(old, rcu);
+}
+
+static void fib_trie_accel_work(struct work_struct *work)
+{
+	struct trie *t = container_of(to_delayed_work(work), struct trie,
+				      accel_work);
+
+	/* fib_trie_accel_stop() cancels us with RTNL held */
+	if (!rtnl_trylock()) {
+		schedule_delayed_work(&t->accel_work, 1);
+		return;
+	}
+	fib_trie_accel_build(t);
+	rtnl_unlock();
+}
+
+static void fib_trie_accel_stop(struct fib_table *tb)
+{
+	struct trie *t = (struct trie *)tb->tb_data;
+
+	if (tb->tb_data == tb->__data)
+		cancel_delayed_work_sync(&t->accel_work);
+}
+
+/* Must be called under RTNL before the trie is modified: the direct index
+ * points into it, so it is not used again by lookups until it is rebuilt
+ * for the new generation. Rebuilds are batched.
+ */
+static void trie_changed(struct trie *t)
+{
+	WRITE_ONCE(t->gen, t->gen + 1);
+	/* Lookups seeing the old generation predate any node free */
+	smp_mb();
+
+	if (READ_ONCE(sysctl_fib_trie_accel) || rtnl_dereference(t->accel))
+		schedule_delayed_work(&t->accel_work, HZ / 10);
+}
+
 int fib_table_insert(struct net *net, struct fib_table *tb,
 		     struct fib_config *cfg, struct netlink_ext_ack *extack)
 {
@@ -1234,6 +1342,8 @@ int fib_table_insert(struct net *net, struct fib_table *tb,
 
 	pr_debug("Insert table=%u %08x/%d\n", tb->tb_id, key, plen);
 
+	trie_changed(t);
+
 	fi = fib_create_info(cfg, extack);
 	if (IS_ERR(fi)) {
 		err = PTR_ERR(fi);
@@ -1450,18 +1560,29 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 	struct trie_use_stats __percpu *stats = t->stats;
 #endif
 	const t_key key = ntohl(flp->daddr);
+	struct fib_trie_accel *acc;
 	struct key_vector *n, *pn;
 	struct fib_alias *fa;
 	unsigned long index;
 	t_key cindex;
 
-	pn = t->kv;
-	cindex = 0;
+	acc = rcu_dereference_rtnl(t->accel);
+	if (acc && acc->gen == READ_ONCE(t->gen)) {
+		const struct fib_trie_accel_ent *e;
 
-	n = get_child_rcu(pn, cindex);
-	if (!n) {
-		trace_fib_table_lookup(tb->tb_id, flp, NULL, -EAGAIN);
-		return -EAGAIN;
+		e = &acc->ent[key >> (KEYLENGTH - ACCEL_BITS)];
+		n = e->n;
+		pn = e->pn;
+		cindex = e->cindex;
+	} else {
+		pn = t->kv;
+		cindex = 0;
+
+		n = get_child_rcu(pn, cindex);
+		if (!n) {
+			trace_fib_table_lookup(tb->tb_id, flp, NULL, -EAGAIN);
+			return -EAGAIN;
+		}
 	}
 
 #ifdef CONFIG_IP_FIB_TRIE_STATS
@@ -1726,6 +1847,8 @@ int fib_table_delete(struct net *net, struct fib_table *tb,
 	if (!fib_valid_key_len(key, plen, extack))
 		return -EINVAL;
 
+	trie_changed(t);
+
 	l = fib_find_node(t, &tp, key);
 	if (!l)
 		return -ESRCH;
@@ -1891,6 +2014,8 @@ static void fib_trie_free(struct fib_table *tb)
 		node_free(n);
 	}
 
+	fib_trie_accel_stop(tb);
+	kvfree(rcu_dereference_protected(t->accel, 1));
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	free_percpu(t->stats);
 #endif
@@ -1964,6 +2089,8 @@ void fib_table_flush_external(struct fib_table *tb)
 	struct hlist_node *tmp;
 	struct fib_alias *fa;
 
+	trie_changed(t);
+
 	/* walk trie in reverse order */
 	for (;;) {
 		unsigned char slen = 0;
@@ -2035,6 +2162,8 @@ int fib_table_flush(struct net *net, struct fib_table *tb, bool flush_all)
 	struct fib_alias *fa;
 	int found = 0;
 
+	trie_changed(t);
+
 	/* walk trie in reverse order */
 	for (;;) {
 		unsigned char slen = 0;
@@ -2252,17 +2381,20 @@ int fib_notify(struct net *net, struct notifier_block *nb,
 static void __trie_free_rcu(struct rcu_head *head)
 {
 	struct fib_table *tb = container_of(head, struct fib_table, rcu);
-#ifdef CONFIG_IP_FIB_TRIE_STATS
 	struct trie *t = (struct trie *)tb->tb_data;
 
-	if (tb->tb_data == tb->__data)
+	if (tb->tb_data == tb->__data) {
+		kvfree(rcu_dereference_protected(t->accel, 1));
+#ifdef CONFIG_IP_FIB_TRIE_STATS
 		free_percpu(t->stats);
 #endif /* CONFIG_IP_FIB_TRIE_STATS */
+	}
 	kfree(tb);
 }
 
 void fib_free_table(struct fib_table *tb)
 {
+	fib_trie_accel_stop(tb);
 	call_rcu(&tb->rcu, __trie_free_rcu);
 }
 
@@ -2431,6 +2563,7 @@ struct fib_table *fib_trie_table(u32 id, struct fib_table *alias)
 	t = (struct trie *) tb->tb_data;
 	t->kv[0].pos = KEYLENGTH;
 	t->kv[0].slen = KEYLENGTH;
+	INIT_DELAYED_WORK(&t->accel_work, fib_trie_accel_work);
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	t->stats = alloc_percpu(struct trie_use_stats);
 	if (!t->stats) {
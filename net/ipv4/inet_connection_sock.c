@@ -983,6 +983,8 @@ static bool reqsk_queue_unlink(struct request_sock *req)
 
 		spin_lock(lock);
 		found = __sk_nulls_del_node_init_rcu(sk);
+		if (found)
+			inet_ehash_count_add(hashinfo, -1);
 		spin_unlock(lock);
 	}
 	if (timer_pending(&req->rsk_timer) && del_timer_sync(&req->rsk_timer))
@@ -1183,15 +1183,19 @@ void inet_diag_dump_icsk(struct inet_hashinfo *hashinfo, struct sk_buff *skb,
 	if (!(idiag_states & ~TCPF_LISTEN))
 		goto out;
 
-	for (i = s_i; i <= hashinfo->ehash_mask; i++) {
-		struct inet_ehash_bucket *head = &hashinfo->ehash[i];
+	for (i = s_i; i <= inet_ehash_mask(hashinfo); i++) {
 		spinlock_t *lock = inet_ehash_lockp(hashinfo, i);
 		struct hlist_nulls_node *node;
 		struct sock *sk_arr[SKARR_SZ];
 		int num_arr[SKARR_SZ];
 		int idx, accum, res;
+		bool empty;
 
-		if (hlist_nulls_empty(&head->chain))
+		/* ehash may be growing, RCU keeps the current one around */
+		rcu_read_lock();
+		empty = hlist_nulls_empty(&READ_ONCE(hashinfo->ehash)[i].chain);
+		rcu_read_unlock();
+		if (empty)
 			continue;
 
 		if (i > s_i)
@@ -1201,7 +1205,7 @@ void inet_diag_dump_icsk(struct inet_hashinfo *hashinfo, struct sk_buff *skb,
 		num = 0;
 		accum = 0;
 		spin_lock_bh(lock);
-		sk_nulls_for_each(sk, node, &head->chain) {
+		sk_nulls_for_each(sk, node, &hashinfo->ehash[i].chain) {
 			int state;
 
 			if (!net_eq(sock_net(sk), net))
@@ -9,6 +9,7 @@
  * Authors:	Lotsa people, from code originally in tcp
  */
 
+#include <linux/kmemleak.h>
 #include <linux/module.h>
 #include <linux/random.h>
 #include <linux/sched.h>
@@ -502,10 +503,12 @@ struct sock *__inet_lookup_established(struct net *net,
 	 * have wildcards anyways.
 	 */
 	unsigned int hash = inet_ehashfn(net, daddr, hnum, saddr, sport);
-	unsigned int slot = hash & hashinfo->ehash_mask;
-	struct inet_ehash_bucket *head = &hashinfo->ehash[slot];
+	struct inet_ehash_bucket *head;
+	unsigned int seq, slot;
 
 begin:
+	seq = read_seqcount_begin(&hashinfo->ehash_seq);
+	head = __inet_ehash_bucket(hashinfo, hash, &slot);
 	sk_nulls_for_each_rcu(sk, node, &head->chain) {
 		if (sk->sk_hash != hash)
 			continue;
@@ -527,6 +530,9 @@ struct sock *__inet_lookup_established(struct net *net,
 	 */
 	if (get_nulls_value(node) != slot)
 		goto begin;
+	/* ehash is growing, and the socket may have been moved meanwhile */
+	if (unlikely(read_seqcount_retry(&hashinfo->ehash_seq, seq)))
+		goto begin;
 out:
 	sk = NULL;
 found:
@@ -550,13 +556,14 @@ static int __inet_check_established(struct inet_timewait_death_row *death_row,
 	const __portpair ports = INET_COMBINED_PORTS(inet->inet_dport, lport);
 	unsigned int hash = inet_ehashfn(net, daddr, lport,
 					 saddr, inet->inet_dport);
-	struct inet_ehash_bucket *head = inet_ehash_bucket(hinfo, hash);
 	spinlock_t *lock = inet_ehash_lockp(hinfo, hash);
+	struct inet_ehash_bucket *head;
 	struct sock *sk2;
 	const struct hlist_nulls_node *node;
 	struct inet_timewait_sock *tw = NULL;
 
 	spin_lock(lock);
+	head = inet_ehash_bucket(hinfo, hash);
 
 	sk_nulls_for_each(sk2, node, &head->chain) {
 		if (sk2->sk_hash != hash)
@@ -583,9 +590,13 @@ static int __inet_check_established(struct inet_timewait_death_row *death_row,
 	if (tw) {
 		sk_nulls_del_node_init_rcu((struct sock *)tw);
 		__NET_INC_STATS(net, LINUX_MIB_TIMEWAITRECYCLED);
+	} else {
+		inet_ehash_count_add(hinfo, 1);
 	}
 	spin_unlock(lock);
 	sock_prot_inuse_add(sock_net(sk), sk->sk_prot, 1);
+	if (!tw)
+		inet_ehash_maybe_grow(hinfo, sk);
 
 	if (twp) {
 		*twp = tw;
@@ -663,11 +674,11 @@ bool inet_ehash_insert(struct sock *sk, struct sock *osk, bool *found_dup_sk)
 	WARN_ON_ONCE(!sk_unhashed(sk));
 
 	sk->sk_hash = sk_ehashfn(sk);
-	head = inet_ehash_bucket(hashinfo, sk->sk_hash);
-	list = &head->chain;
 	lock = inet_ehash_lockp(hashinfo, sk->sk_hash);
 
 	spin_lock(lock);
+	head = inet_ehash_bucket(hashinfo, sk->sk_hash);
+	list = &head->chain;
 	if (osk) {
 		WARN_ON_ONCE(sk->sk_hash != osk->sk_hash);
 		ret = sk_nulls_del_node_init_rcu(osk);
@@ -679,9 +690,13 @@ bool inet_ehash_insert(struct sock *sk, struct sock *osk, bool *found_dup_sk)
 
 	if (ret)
 		__sk_nulls_add_node_rcu(sk, list);
+	if (ret && !osk)
+		inet_ehash_count_add(hashinfo, 1);
 
 	spin_unlock(lock);
 
+	if (ret && !osk)
+		inet_ehash_maybe_grow(hashinfo, sk);
 	return ret;
 }
 
@@ -805,6 +820,7 @@ void inet_unhash(struct sock *sk)
 			return;
 		}
 		__sk_nulls_del_node_init_rcu(sk);
+		inet_ehash_count_add(hashinfo, -1);
 		sock_prot_inuse_add(sock_net(sk), sk->sk_prot, -1);
 		spin_unlock_bh(lock);
 	}
@@ -1136,6 +1152,7 @@ int __inet_hash_connect(struct inet_timewait_death_row *death_row,
 
 		spin_lock(lock);
 		__sk_nulls_del_node_init_rcu(sk);
+		inet_ehash_count_add(hinfo, -1);
 		spin_unlock(lock);
 
 		sk->sk_hash = 0;
@@ -1225,11 +1242,142 @@ int inet_hashinfo2_init_mod(struct inet_hashinfo *h)
 }
 EXPORT_SYMBOL_GPL(inet_hashinfo2_init_mod);
 
+DEFINE_MUTEX(inet_ehash_resize_mutex);
+
+static void inet_ehash_free(struct inet_ehash_bucket *ehash,
+			    unsigned int entries)
+{
+	if (is_vmalloc_addr(ehash)) {
+		vfree(ehash);
+	} else {
+		/* From alloc_large_system_hash() for tcp_hashinfo */
+		kmemleak_free(ehash);
+		free_pages_exact(ehash, entries * sizeof(*ehash));
+	}
+}
+
+static void inet_ehash_move_chain(struct inet_ehash_bucket *head,
+				  struct inet_ehash_bucket *future,
+				  unsigned int future_mask)
+{
+	struct hlist_nulls_node *node;
+	struct sock *sk;
+
+	while (!hlist_nulls_empty(&head->chain)) {
+		node = head->chain.first;
+		sk = hlist_nulls_entry(node, struct sock, sk_nulls_node);
+		hlist_nulls_del_rcu(node);
+		hlist_nulls_add_head_rcu(node,
+					 &future[sk->sk_hash & future_mask].chain);
+	}
+}
+
+/*
+ * Grow ehash to ehash_resize_target buckets.
+ *
+ * The number of bucket locks does not change and never exceeds the number of
+ * buckets, so all the buckets a lock covers in the new table come from the
+ * buckets it covers in the current one. Their chains are moved under that
+ * lock, inside an ehash_seq write section, and ehash_resize_pos then tells
+ * lock holders and lockless lookups to use the new table for that lock.
+ * Lookups which raced with the move see ehash_seq change and retry.
+ */
+static void inet_ehash_resize_work(struct work_struct *work)
+{
+	struct inet_hashinfo *hashinfo = container_of(work, struct inet_hashinfo,
+						      ehash_resize_work);
+	unsigned int old_size, size, nlocks, lock, i;
+	struct inet_ehash_bucket *old, *new;
+
+	mutex_lock(&inet_ehash_resize_mutex);
+	old = hashinfo->ehash;
+	old_size = hashinfo->ehash_mask + 1;
+	size = READ_ONCE(hashinfo->ehash_resize_target);
+	if (size <= old_size)
+		goto unlock;
+
+	new = vmalloc_huge(size * sizeof(*new), GFP_KERNEL);
+	if (!new) {
+		pr_warn_ratelimited("TCP: failed to grow established hash to %u entries\n",
+				    size);
+		goto unlock;
+	}
+	for (i = 0; i < size; i++)
+		INIT_HLIST_NULLS_HEAD(&new[i].chain, i);
+
+	WRITE_ONCE(hashinfo->ehash_resize_pos, 0);
+	WRITE_ONCE(hashinfo->ehash_future_mask, size - 1);
+	smp_store_release(&hashinfo->ehash_future, new);
+
+	nlocks = hashinfo->ehash_locks_mask + 1;
+	for (lock = 0; lock < nlocks; lock++) {
+		spin_lock_bh(&hashinfo->ehash_locks[lock]);
+		preempt_disable();
+		write_seqcount_begin(&hashinfo->ehash_seq);
+		for (i = lock; i < old_size; i += nlocks)
+			inet_ehash_move_chain(&old[i], new, size - 1);
+		WRITE_ONCE(hashinfo->ehash_resize_pos, lock + 1);
+		write_seqcount_end(&hashinfo->ehash_seq);
+		preempt_enable();
+		spin_unlock_bh(&hashinfo->ehash_locks[lock]);
+		cond_resched();
+	}
+
+	preempt_disable();
+	write_seqcount_begin(&hashinfo->ehash_seq);
+	WRITE_ONCE(hashinfo->ehash, new);
+	smp_store_release(&hashinfo->ehash_mask, size - 1);
+	smp_store_release(&hashinfo->ehash_future, NULL);
+	write_seqcount_end(&hashinfo->ehash_seq);
+	preempt_enable();
+	WRITE_ONCE(hashinfo->ehash_resizes, hashinfo->ehash_resizes + 1);
+
+	synchronize_rcu();
+	inet_ehash_free(old, old_size);
+unlock:
+	mutex_unlock(&inet_ehash_resize_mutex);
+}
+
+/*
+ * Called after adding a socket to ehash: grow the TCP ehash to a load factor
+ * of at most one once it goes over two, up to net.ipv4.tcp_ehash_max_entries
+ * (of init_net for the global ehash).
+ */
+void inet_ehash_maybe_grow(struct inet_hashinfo *hashinfo,
+			   const struct sock *sk)
+{
+	const struct net *net = hashinfo->pernet ? sock_net(sk) : &init_net;
+	unsigned int max = READ_ONCE(net->ipv4.sysctl_tcp_ehash_max_entries);
+	unsigned int size = READ_ONCE(hashinfo->ehash_mask) + 1;
+	s64 count;
+
+	if (likely(size >= max) || sk->sk_protocol != IPPROTO_TCP)
+		return;
+
+	count = percpu_counter_read_positive(&hashinfo->ehash_count);
+	if (likely(count <= 2 * (s64)size))
+		return;
+
+	max = rounddown_pow_of_two(max);
+	WRITE_ONCE(hashinfo->ehash_resize_target,
+		   count >= max ? max : roundup_pow_of_two(count));
+	if (!work_pending(&hashinfo->ehash_resize_work))
+		queue_work(system_unbound_wq, &hashinfo->ehash_resize_work);
+}
+
 int inet_ehash_locks_alloc(struct inet_hashinfo *hashinfo)
 {
 	unsigned int locksz = sizeof(spinlock_t);
 	unsigned int i, nblocks = 1;
 
+	if (percpu_counter_init(&hashinfo->ehash_count, 0, GFP_KERNEL))
+		return -ENOMEM;
+	hashinfo->ehash_future = NULL;
+	hashinfo->ehash_resize_target = 0;
+	hashinfo->ehash_resizes = 0;
+	seqcount_init(&hashinfo->ehash_seq);
+	INIT_WORK(&hashinfo->ehash_resize_work, inet_ehash_resize_work);
+
 	if (locksz != 0) {
 		/* allocate 2 cache lines or at least one spinlock per cpu */
 		nblocks = max(2U * L1_CACHE_BYTES / locksz, 1U);
@@ -1239,8 +1387,10 @@ int inet_ehash_locks_alloc(struct inet_hashinfo *hashinfo)
 		nblocks = min(nblocks, hashinfo->ehash_mask + 1);
 
 		hashinfo->ehash_locks = kvmalloc_array(nblocks, locksz, GFP_KERNEL);
-		if (!hashinfo->ehash_locks)
+		if (!hashinfo->ehash_locks) {
+			percpu_counter_destroy(&hashinfo->ehash_count);
 			return -ENOMEM;
+		}
 
 		for (i = 0; i < nblocks; i++)
 			spin_lock_init(&hashinfo->ehash_locks[i]);
@@ -1292,7 +1442,7 @@ void inet_pernet_hashinfo_free(struct inet_hashinfo *hashinfo)
 		return;
 
 	inet_ehash_locks_free(hashinfo);
-	vfree(hashinfo->ehash);
+	inet_ehash_free(hashinfo->ehash, hashinfo->ehash_mask + 1);
 	kfree(hashinfo);
 }
 EXPORT_SYMBOL_GPL(inet_pernet_hashinfo_free);
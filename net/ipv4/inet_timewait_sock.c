@@ -52,7 +52,8 @@ static void inet_twsk_kill(struct inet_timewait_sock *tw)
 	struct inet_bind_hashbucket *bhead, *bhead2;
 
 	spin_lock(lock);
-	sk_nulls_del_node_init_rcu((struct sock *)tw);
+	if (sk_nulls_del_node_init_rcu((struct sock *)tw))
+		inet_ehash_count_add(hashinfo, -1);
 	spin_unlock(lock);
 
 	/* Disassociate with bind bucket. */
@@ -102,8 +103,8 @@ void inet_twsk_hashdance(struct inet_timewait_sock *tw, struct sock *sk,
 {
 	const struct inet_sock *inet = inet_sk(sk);
 	const struct inet_connection_sock *icsk = inet_csk(sk);
-	struct inet_ehash_bucket *ehead = inet_ehash_bucket(hashinfo, sk->sk_hash);
 	spinlock_t *lock = inet_ehash_lockp(hashinfo, sk->sk_hash);
+	struct inet_ehash_bucket *ehead;
 	struct inet_bind_hashbucket *bhead, *bhead2;
 
 	/* Step 1: Put TW into bind hash. Original socket stays there too.
@@ -129,11 +130,14 @@ void inet_twsk_hashdance(struct inet_timewait_sock *tw, struct sock *sk,
 
 	spin_lock(lock);
 
+	ehead = inet_ehash_bucket(hashinfo, sk->sk_hash);
 	inet_twsk_add_node_rcu(tw, &ehead->chain);
 
 	/* Step 3: Remove SK from hash chain */
 	if (__sk_nulls_del_node_init_rcu(sk))
 		sock_prot_inuse_add(sock_net(sk), sk->sk_prot, -1);
+	else
+		inet_ehash_count_add(hashinfo, 1);
 
 	spin_unlock(lock);
 
@@ -270,6 +274,8 @@ void inet_twsk_purge(struct inet_hashinfo *hashinfo, int family)
 	unsigned int slot;
 	struct sock *sk;
 
+	/* Sockets must not be moved to a grown ehash behind our back */
+	mutex_lock(&inet_ehash_resize_mutex);
 	for (slot = 0; slot <= hashinfo->ehash_mask; slot++) {
 		struct inet_ehash_bucket *head = &hashinfo->ehash[slot];
 restart_rcu:
@@ -317,5 +323,6 @@ void inet_twsk_purge(struct inet_hashinfo *hashinfo, int family)
 			goto restart;
 		rcu_read_unlock();
 	}
+	mutex_unlock(&inet_ehash_resize_mutex);
 }
 EXPORT_SYMBOL_GPL(inet_twsk_purge);
@@ -50,6 +50,8 @@ static int ip_metrics_convert(struct net *net, struct nlattr *fc_mx,
 			val = 65535 - 15;
 		if (type == RTAX_HOPLIMIT && val > 255)
 			val = 255;
+		if (type == RTAX_ACK_FREQ && val > TCP_ACK_FREQ_MAX)
+			val = TCP_ACK_FREQ_MAX;
 		if (type == RTAX_FEATURES && (val & ~RTAX_FEATURE_MASK)) {
 			NL_SET_ERR_MSG(extack, "Unknown flag set in feature mask in metrics attribute");
 			return -EINVAL;
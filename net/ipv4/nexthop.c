@@ -1801,12 +1801,17 @@ static bool nh_res_bucket_migrate(struct nh_res_table *res_table,
 
 #define NH_RES_UPKEEP_DW_MINIMUM_INTERVAL (HZ / 2)
 
-static void nh_res_table_upkeep(struct nh_res_table *res_table,
-				bool notify, bool notify_nl)
+/* Buckets scanned per DW invocation. RTNL writers synchronously cancel the
+ * DW, so this bounds how long they can wait for it.
+ */
+#define NH_RES_UPKEEP_DW_BATCH 4096
+
+static void __nh_res_table_upkeep(struct nh_res_table *res_table,
+				  bool notify, bool notify_nl, bool batch)
 {
 	unsigned long now = jiffies;
 	unsigned long deadline;
-	u16 i;
+	u32 i, end;
 
 	/* Deadline is the next time that upkeep should be run. It is the
 	 * earliest time at which one of the buckets might be migrated.
@@ -1820,7 +1825,19 @@ static void nh_res_table_upkeep(struct nh_res_table *res_table,
 	else
 		deadline = now + res_table->idle_timer;
 
-	for (i = 0; i < res_table->num_nh_buckets; i++) {
+	/* Carry on with a run started by a previous DW invocation */
+	i = 0;
+	if (batch && res_table->upkeep_pos) {
+		i = res_table->upkeep_pos;
+		nh_res_time_set_deadline(res_table->upkeep_deadline, &deadline);
+	}
+	res_table->upkeep_pos = 0;
+
+	end = res_table->num_nh_buckets;
+	if (batch && end - i > NH_RES_UPKEEP_DW_BATCH)
+		end = i + NH_RES_UPKEEP_DW_BATCH;
+
+	for (; i < end; i++) {
 		struct nh_res_bucket *bucket = &res_table->nh_buckets[i];
 		bool force;
 
@@ -1845,6 +1862,14 @@ static void nh_res_table_upkeep(struct nh_res_table *res_table,
 		}
 	}
 
+	if (end < res_table->num_nh_buckets) {
+		res_table->upkeep_pos = end;
+		res_table->upkeep_deadline = deadline;
+		queue_delayed_work(system_power_efficient_wq,
+				   &res_table->upkeep_dw, 0);
+		return;
+	}
+
 	/* If the group is still unbalanced, schedule the next upkeep to
 	 * either the deadline computed above, or the minimum deadline,
 	 * whichever comes later.
@@ -1862,13 +1887,19 @@ static void nh_res_table_upkeep(struct nh_res_table *res_table,
 	}
 }
 
+static void nh_res_table_upkeep(struct nh_res_table *res_table,
+				bool notify, bool notify_nl)
+{
+	__nh_res_table_upkeep(res_table, notify, notify_nl, false);
+}
+
 static void nh_res_table_upkeep_dw(struct work_struct *work)
 {
 	struct delayed_work *dw = to_delayed_work(work);
 	struct nh_res_table *res_table;
 
 	res_table = container_of(dw, struct nh_res_table, upkeep_dw);
-	nh_res_table_upkeep(res_table, true, true);
+	__nh_res_table_upkeep(res_table, true, true, true);
 }
 
 static void nh_res_table_cancel_upkeep(struct nh_res_table *res_table)
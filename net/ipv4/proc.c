@@ -74,6 +74,22 @@ static int sockstat_seq_show(struct seq_file *seq, void *v)
 	return 0;
 }
 
+/*
+ *	Report the size and use of the TCP established hash of the netns,
+ *	which may be shared with other netns
+ */
+static int tcp_ehash_seq_show(struct seq_file *seq, void *v)
+{
+	struct net *net = seq->private;
+	struct inet_hashinfo *hinfo = net->ipv4.tcp_death_row.hashinfo;
+
+	seq_printf(seq, "buckets %u\n", READ_ONCE(hinfo->ehash_mask) + 1);
+	seq_printf(seq, "entries %lld\n",
+		   percpu_counter_sum_positive(&hinfo->ehash_count));
+	seq_printf(seq, "resizes %u\n", READ_ONCE(hinfo->ehash_resizes));
+	return 0;
+}
+
 /* snmp items */
 static const struct snmp_mib snmp4_ipstats_list[] = {
 	SNMP_MIB_ITEM("InReceives", IPSTATS_MIB_INPKTS),
@@ -537,9 +553,14 @@ static __net_init int ip_proc_init_net(struct net *net)
 	if (!proc_create_net_single("snmp", 0444, net->proc_net, snmp_seq_show,
 			NULL))
 		goto out_snmp;
+	if (!proc_create_net_single("tcp_ehash", 0444, net->proc_net,
+			tcp_ehash_seq_show, NULL))
+		goto out_tcp_ehash;
 
 	return 0;
 
+out_tcp_ehash:
+	remove_proc_entry("snmp", net->proc_net);
 out_snmp:
 	remove_proc_entry("netstat", net->proc_net);
 out_netstat:
@@ -550,6 +571,7 @@ static __net_init int ip_proc_init_net(struct net *net)
 
 static __net_exit void ip_proc_exit_net(struct net *net)
 {
+	remove_proc_entry("tcp_ehash", net->proc_net);
 	remove_proc_entry("snmp", net->proc_net);
 	remove_proc_entry("netstat", net->proc_net);
 	remove_proc_entry("sockstat", net->proc_net);
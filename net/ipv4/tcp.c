@@ -1453,8 +1453,8 @@ void __tcp_cleanup_rbuf(struct sock *sk, int copied)
 	if (inet_csk_ack_scheduled(sk)) {
 		const struct inet_connection_sock *icsk = inet_csk(sk);
 
-		if (/* Once-per-two-segments ACK was not sent by tcp_input.c */
-		    tp->rcv_nxt - tp->rcv_wup > icsk->icsk_ack.rcv_mss ||
+		if (/* Once-per-N-segments ACK was not sent by tcp_input.c */
+		    tp->rcv_nxt - tp->rcv_wup > tcp_ack_thresh(sk) ||
 		    /*
 		     * If this read emptied read buffer, we send ACK, if
 		     * connection is not bidirectional, user drained
@@ -3726,6 +3726,12 @@ int do_tcp_setsockopt(struct sock *sk, int level, int optname,
 			tcp_enable_tx_delay();
 		WRITE_ONCE(tp->tcp_tx_delay, val);
 		break;
+	case TCP_ACK_FREQUENCY:
+		if (val < 0 || val > TCP_ACK_FREQ_MAX)
+			err = -EINVAL;
+		else
+			WRITE_ONCE(tp->ack_freq, val);
+		break;
 	default:
 		err = -ENOPROTOOPT;
 		break;
@@ -4219,6 +4225,9 @@ int do_tcp_getsockopt(struct sock *sk, int level,
 	case TCP_TX_DELAY:
 		val = READ_ONCE(tp->tcp_tx_delay);
 		break;
+	case TCP_ACK_FREQUENCY:
+		val = READ_ONCE(tp->ack_freq);
+		break;
 
 	case TCP_TIMESTAMP:
 		val = tcp_clock_ts(tp->tcp_usec_ts) + READ_ONCE(tp->tsoffset);
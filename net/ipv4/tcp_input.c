@@ -5679,6 +5679,34 @@ static inline void tcp_data_snd_check(struct sock *sk)
 	tcp_check_space(sk);
 }
 
+/* Unacknowledged data beyond which an ACK is due.
+ *
+ * By default (RFC 1122) that is every second full-sized segment. Bulk
+ * receivers on high-BDP paths can ask for one ACK every N segments through
+ * TCP_ACK_FREQUENCY or the route's RTAX_ACK_FREQ metric, which also means one
+ * ACK per GRO packet as long as these hold at least N segments. No more than
+ * a quarter of the receive window is ever held back, so that senders limited
+ * by it are still clocked, and the cumulative ACKs keep delivery rate samples
+ * correct.
+ */
+u32 tcp_ack_thresh(const struct sock *sk)
+{
+	u32 rcv_mss = inet_csk(sk)->icsk_ack.rcv_mss;
+	const struct tcp_sock *tp = tcp_sk(sk);
+	u32 freq = tp->ack_freq;
+
+	if (!freq) {
+		const struct dst_entry *dst = __sk_dst_get(sk);
+
+		if (dst)
+			freq = dst_metric(dst, RTAX_ACK_FREQ);
+		if (!freq)
+			return rcv_mss;
+	}
+
+	return min((freq - 1) * rcv_mss, max(tp->rcv_wnd >> 2, rcv_mss));
+}
+
 /*
  * Check if sending an ack is needed.
  */
@@ -5687,8 +5715,8 @@ static void __tcp_ack_snd_check(struct sock *sk, int ofo_possible)
 	struct tcp_sock *tp = tcp_sk(sk);
 	unsigned long rtt, delay;
 
-	    /* More than one full frame received... */
-	if (((tp->rcv_nxt - tp->rcv_wup) > inet_csk(sk)->icsk_ack.rcv_mss &&
+	    /* Enough full frames received... */
+	if (((tp->rcv_nxt - tp->rcv_wup) > tcp_ack_thresh(sk) &&
 	     (tp->fast_ack_mode == 1 ||
 	     /* ... and right edge of window advances far enough.
 	      * (tcp_recvmsg() will send ACK otherwise).
@@ -2650,7 +2650,13 @@ static void *listening_get_idx(struct seq_file *seq, loff_t *pos)
 static inline bool empty_bucket(struct inet_hashinfo *hinfo,
 				const struct tcp_iter_state *st)
 {
-	return hlist_nulls_empty(&hinfo->ehash[st->bucket].chain);
+	bool empty;
+
+	/* ehash may be growing, RCU keeps the current one around */
+	rcu_read_lock();
+	empty = hlist_nulls_empty(&READ_ONCE(hinfo->ehash)[st->bucket].chain);
+	rcu_read_unlock();
+	return empty;
 }
 
 /*
@@ -2663,7 +2669,7 @@ static void *established_get_first(struct seq_file *seq)
 	struct tcp_iter_state *st = seq->private;
 
 	st->offset = 0;
-	for (; st->bucket <= hinfo->ehash_mask; ++st->bucket) {
+	for (; st->bucket <= inet_ehash_mask(hinfo); ++st->bucket) {
 		struct sock *sk;
 		struct hlist_nulls_node *node;
 		spinlock_t *lock = inet_ehash_lockp(hinfo, st->bucket);
@@ -3365,7 +3371,7 @@ struct proto tcp_prot = {
 	.sysctl_rmem_offset	= offsetof(struct net, ipv4.sysctl_tcp_rmem),
 	.max_header		= MAX_TCP_HEADER,
 	.obj_size		= sizeof(struct tcp_sock),
-	.slab_flags		= SLAB_TYPESAFE_BY_RCU,
+	.slab_flags		= SLAB_TYPESAFE_BY_RCU | SLAB_SHEAVES,
 	.twsk_prot		= &tcp_timewait_sock_ops,
 	.rsk_prot		= &tcp_request_sock_ops,
 	.h.hashinfo		= NULL,
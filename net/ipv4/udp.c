@@ -88,6 +88,7 @@
 #include <linux/inetdevice.h>
 #include <linux/in.h>
 #include <linux/errno.h>
+#include <linux/hash.h>
 #include <linux/timer.h>
 #include <linux/mm.h>
 #include <linux/inet.h>
@@ -1052,6 +1053,133 @@ int udp_cmsg_send(struct sock *sk, struct msghdr *msg, u16 *gso_size)
 }
 EXPORT_SYMBOL_GPL(udp_cmsg_send);
 
+/* Small direct mapped cache of the routes of unconnected sends, keyed by
+ * the flow given to ip_route_output_flow(). sk_dst_cache only serves
+ * connected sockets, so servers sending to many peers from one socket
+ * would otherwise do a full route lookup per packet. Unconnected sends
+ * do not hold the socket lock: entries are read locklessly under their
+ * seqlock, and the cached routes are validated with dst_check() as for
+ * sk_dst_cache, which catches rt_genid bumps and exceptions.
+ */
+#define UDP_DST_CACHE_BITS	3
+
+struct udp_dst_cache_entry {
+	seqlock_t		lock;
+	struct flowi4		key;	/* flow before the lookup */
+	struct flowi4		fl4;	/* and after */
+	struct dst_entry	*dst;
+};
+
+struct udp_dst_cache {
+	struct udp_dst_cache_entry e[1 << UDP_DST_CACHE_BITS];
+};
+
+static bool udp_dst_cache_match(const struct flowi4 *a, const struct flowi4 *b)
+{
+	return a->daddr == b->daddr && a->saddr == b->saddr &&
+	       a->fl4_dport == b->fl4_dport &&
+	       a->flowi4_oif == b->flowi4_oif &&
+	       a->flowi4_mark == b->flowi4_mark &&
+	       a->flowi4_tos == b->flowi4_tos &&
+	       a->flowi4_scope == b->flowi4_scope &&
+	       a->flowi4_flags == b->flowi4_flags &&
+	       uid_eq(a->flowi4_uid, b->flowi4_uid);
+}
+
+static struct udp_dst_cache_entry *udp_dst_cache_entry(struct sock *sk,
+						       const struct flowi4 *key)
+{
+	struct udp_dst_cache *cache = READ_ONCE(udp_sk(sk)->dst_cache);
+	int i;
+
+#ifdef CONFIG_XFRM
+	/*
+	 * Per socket policies are looked up with the route, and can be set
+	 * at any time, so bypass the cache whenever there is one.
+	 */
+	if (rcu_access_pointer(sk->sk_policy[1]))
+		return NULL;
+#endif
+
+	if (!cache) {
+		if (!READ_ONCE(sock_net(sk)->ipv4.sysctl_udp_dst_cache))
+			return NULL;
+		cache = kzalloc(sizeof(*cache), sk->sk_allocation);
+		if (!cache)
+			return NULL;
+		for (i = 0; i < ARRAY_SIZE(cache->e); i++)
+			seqlock_init(&cache->e[i].lock);
+		if (cmpxchg(&udp_sk(sk)->dst_cache, NULL, cache)) {
+			kfree(cache);
+			cache = READ_ONCE(udp_sk(sk)->dst_cache);
+		}
+	}
+
+	return &cache->e[hash_32((__force u32)key->daddr ^
+				 (__force u32)key->fl4_dport,
+				 UDP_DST_CACHE_BITS)];
+}
+
+static struct rtable *udp_dst_cache_get(struct udp_dst_cache_entry *e,
+					const struct flowi4 *key,
+					struct flowi4 *fl4)
+{
+	struct dst_entry *dst;
+	unsigned int seq;
+	bool hit;
+
+	rcu_read_lock();
+	do {
+		seq = read_seqbegin(&e->lock);
+		dst = READ_ONCE(e->dst);
+		hit = dst && udp_dst_cache_match(&e->key, key);
+		if (hit)
+			*fl4 = e->fl4;
+	} while (read_seqretry(&e->lock, seq));
+
+	/* dst entries are freed after an RCU grace period */
+	if (hit && !dst_hold_safe(dst))
+		hit = false;
+	rcu_read_unlock();
+
+	if (hit && !dst_check(dst, 0)) {
+		dst_release(dst);
+		hit = false;
+	}
+
+	return hit ? dst_rtable(dst) : NULL;
+}
+
+static void udp_dst_cache_set(struct udp_dst_cache_entry *e,
+			      const struct flowi4 *key,
+			      const struct flowi4 *fl4, struct rtable *rt)
+{
+	struct dst_entry *old;
+
+	write_seqlock_bh(&e->lock);
+	old = e->dst;
+	e->key = *key;
+	e->fl4 = *fl4;
+	e->dst = dst_clone(&rt->dst);
+	write_sequnlock_bh(&e->lock);
+
+	dst_release(old);
+}
+
+static void udp_dst_cache_free(struct sock *sk)
+{
+	struct udp_dst_cache *cache = udp_sk(sk)->dst_cache;
+	int i;
+
+	if (!cache)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(cache->e); i++)
+		dst_release(cache->e[i].dst);
+	kfree(cache);
+	udp_sk(sk)->dst_cache = NULL;
+}
+
 int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 {
 	struct inet_sock *inet = inet_sk(sk);
@@ -1223,6 +1351,8 @@ int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 	if (!rt) {
 		struct net *net = sock_net(sk);
 		__u8 flow_flags = inet_sk_flowi_flags(sk);
+		struct udp_dst_cache_entry *e = NULL;
+		struct flowi4 key;
 
 		fl4 = &fl4_stack;
 
@@ -1231,13 +1361,26 @@ int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 				   dport, inet->inet_sport, sk->sk_uid);
 
 		security_sk_classify_flow(sk, flowi4_to_flowi_common(fl4));
-		rt = ip_route_output_flow(net, fl4, sk);
-		if (IS_ERR(rt)) {
-			err = PTR_ERR(rt);
-			rt = NULL;
-			if (err == -ENETUNREACH)
-				IP_INC_STATS(net, IPSTATS_MIB_OUTNOROUTES);
-			goto out;
+
+		if (!connected && !ipv4_is_multicast(daddr)) {
+			e = udp_dst_cache_entry(sk, fl4);
+			if (e) {
+				key = *fl4;
+				rt = udp_dst_cache_get(e, &key, fl4);
+			}
+		}
+
+		if (!rt) {
+			rt = ip_route_output_flow(net, fl4, sk);
+			if (IS_ERR(rt)) {
+				err = PTR_ERR(rt);
+				rt = NULL;
+				if (err == -ENETUNREACH)
+					IP_INC_STATS(net, IPSTATS_MIB_OUTNOROUTES);
+				goto out;
+			}
+			if (e)
+				udp_dst_cache_set(e, &key, fl4, rt);
 		}
 
 		err = -EACCES;
@@ -1588,6 +1731,7 @@ void udp_destruct_common(struct sock *sk)
 		kfree_skb(skb);
 	}
 	udp_rmem_release(sk, total, 0, true);
+	udp_dst_cache_free(sk);
 }
 EXPORT_SYMBOL_GPL(udp_destruct_common);
 
@@ -1774,6 +1918,56 @@ struct sk_buff *__skb_recv_udp(struct sock *sk, unsigned int flags,
 }
 EXPORT_SYMBOL(__skb_recv_udp);
 
+static void udp_recv_batch_flush(struct sock *sk, struct msg_recv_batch *batch)
+{
+	struct sk_buff_head *queue = &udp_sk(sk)->reader_queue;
+
+	spin_lock_bh(&queue->lock);
+	/* What was not received, e.g. on timeout or error, goes back in front */
+	skb_queue_splice_init(&batch->queue, queue);
+	if (batch->size)
+		udp_rmem_release(sk, batch->size, 1, false);
+	spin_unlock_bh(&queue->lock);
+}
+
+/*
+ * recvmmsg(MSG_BATCH): dequeue the datagrams for all the messages left under
+ * a single reader_queue lock, and release their memory at once when the batch
+ * is flushed. When nothing is queued, wait like any other receiver.
+ */
+static struct sk_buff *udp_recv_batched(struct sock *sk,
+					struct msg_recv_batch *batch,
+					unsigned int flags, int *err)
+{
+	struct sk_buff_head *sk_queue = &sk->sk_receive_queue;
+	struct sk_buff_head *queue = &udp_sk(sk)->reader_queue;
+	struct sk_buff *skb;
+	int off = 0;
+
+	if (skb_queue_empty(&batch->queue) && batch->max > 1) {
+		spin_lock_bh(&queue->lock);
+		if (skb_queue_empty(queue)) {
+			spin_lock(&sk_queue->lock);
+			skb_queue_splice_tail_init(sk_queue, queue);
+			spin_unlock(&sk_queue->lock);
+		}
+		while (skb_queue_len(&batch->queue) < batch->max &&
+		       (skb = __skb_dequeue(queue)))
+			__skb_queue_tail(&batch->queue, skb);
+		spin_unlock_bh(&queue->lock);
+
+		batch->sk = sk;
+		batch->flush = udp_recv_batch_flush;
+	}
+
+	skb = __skb_dequeue(&batch->queue);
+	if (!skb)
+		return __skb_recv_udp(sk, flags, &off, err);
+
+	batch->size += udp_skb_truesize(skb);
+	return skb;
+}
+
 int udp_read_skb(struct sock *sk, skb_read_actor_t recv_actor)
 {
 	struct sk_buff *skb;
@@ -1821,7 +2015,10 @@ int udp_recvmsg(struct sock *sk, struct msghdr *msg, size_t len, int flags,
 
 try_again:
 	off = sk_peek_offset(sk, flags);
-	skb = __skb_recv_udp(sk, flags, &off, &err);
+	if ((flags & (MSG_BATCH | MSG_PEEK)) == MSG_BATCH && msg->msg_batch)
+		skb = udp_recv_batched(sk, msg->msg_batch, flags, &err);
+	else
+		skb = __skb_recv_udp(sk, flags, &off, &err);
 	if (!skb)
 		return err;
 
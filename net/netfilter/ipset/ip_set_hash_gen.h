@@ -32,9 +32,12 @@
  * Readers and resizing
  *
  * Resizing can be triggered by userspace command only, and those
- * are serialized by the nfnl mutex. During resizing the set is
- * read-locked, so the only possible concurrent operations are
- * the kernel side readers. Those must be protected by proper RCU locking.
+ * are serialized by the nfnl mutex. The only possible concurrent
+ * operations are the kernel side ones, which must be protected by
+ * proper RCU locking. Readers keep using the old table, which stays
+ * complete, until the new one is published: kernel side add/del still
+ * go to the old table and are replayed on the new one afterwards.
+ * The copy yields between regions, so it does not hold up the CPU.
  */
 
 /* Number of elements to store in an initial array block */
@@ -751,6 +754,10 @@ mtype_resize(struct ip_set *set, bool retried)
 			}
 		}
 		rcu_read_unlock_bh();
+		/* Large sets have thousands of regions: let the packet
+		 * path and others run between them.
+		 */
+		cond_resched();
 	}
 
 	/* There can't be any other writer. */
@@ -4344,6 +4344,17 @@ static char *alloc_one_pg_vec_page(unsigned long order)
 	if (buffer)
 		return buffer;
 
+	/* Large blocks are worth some compaction: unlike vmalloc memory,
+	 * physically contiguous blocks are written by the kernel through the
+	 * huge pages of the linear map.
+	 */
+	if (order > PAGE_ALLOC_COSTLY_ORDER) {
+		buffer = (char *) __get_free_pages((gfp_flags & ~__GFP_NORETRY) |
+						   __GFP_RETRY_MAYFAIL, order);
+		if (buffer)
+			return buffer;
+	}
+
 	/* __get_free_pages failed, fall back to vmalloc */
 	buffer = vzalloc(array_size((1 << order), PAGE_SIZE));
 	if (buffer)
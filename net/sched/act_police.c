@@ -35,6 +35,7 @@ static const struct nla_policy police_policy[TCA_POLICE_MAX + 1] = {
 	[TCA_POLICE_PEAKRATE64] = { .type = NLA_U64 },
 	[TCA_POLICE_PKTRATE64]  = { .type = NLA_U64, .min = 1 },
 	[TCA_POLICE_PKTBURST64] = { .type = NLA_U64, .min = 1 },
+	[TCA_POLICE_EDT_HORIZON] = { .type = NLA_U32, .min = 1 },
 };
 
 static int tcf_police_init(struct net *net, struct nlattr *nla,
@@ -151,6 +152,14 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 		goto failure;
 	}
 
+	if (tb[TCA_POLICE_EDT_HORIZON] &&
+	    (!R_tab || P_tab || tb[TCA_POLICE_AVRATE])) {
+		NL_SET_ERR_MSG(extack,
+			       "EDT mode needs a byte-per-second rate and no peak or average rate");
+		err = -EINVAL;
+		goto failure;
+	}
+
 	new = kzalloc(sizeof(*new), GFP_KERNEL);
 	if (unlikely(!new)) {
 		err = -ENOMEM;
@@ -200,9 +209,14 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 		psched_ppscfg_precompute(&new->ppsrate, pps);
 	}
 
+	if (tb[TCA_POLICE_EDT_HORIZON])
+		new->tcfp_edt_horizon = (s64)NSEC_PER_USEC *
+					nla_get_u32(tb[TCA_POLICE_EDT_HORIZON]);
+
 	spin_lock_bh(&police->tcf_lock);
 	spin_lock_bh(&police->tcfp_lock);
 	police->tcfp_t_c = ktime_get_ns();
+	atomic64_set(&police->tcfp_edt_next, 0);
 	police->tcfp_toks = new->tcfp_burst;
 	if (new->peak_present)
 		police->tcfp_ptoks = new->tcfp_mtu_ptoks;
@@ -244,6 +258,38 @@ static bool tcf_police_mtu_check(struct sk_buff *skb, u32 limit)
 	return len <= limit;
 }
 
+/* EDT mode: instead of dropping packets above the rate right away, give
+ * each packet the departure time at which the rate allows it, and leave
+ * the delaying to an EDT aware qdisc such as fq. The policer state is a
+ * single timestamp updated with cmpxchg, so concurrent CPUs and TX queues
+ * never serialize on tcfp_lock. Up to burst worth of idle time can be
+ * used at once. Packets that would have to wait for more than the
+ * horizon are over the limit.
+ */
+static bool tcf_police_edt(struct tcf_police *police,
+			   const struct tcf_police_params *p,
+			   struct sk_buff *skb)
+{
+	s64 len = (s64)psched_l2t_ns(&p->rate, qdisc_pkt_len(skb));
+	s64 now = ktime_get_ns();
+	s64 next, t;
+
+	next = atomic64_read(&police->tcfp_edt_next);
+	do {
+		t = max_t(s64, next, now - p->tcfp_burst);
+		if (t - now > p->tcfp_edt_horizon)
+			return false;
+	} while (!atomic64_try_cmpxchg(&police->tcfp_edt_next, &next,
+				       t + len));
+
+	/* Delivery times only make sense on egress */
+	if (t > now && !skb_at_tc_ingress(skb) &&
+	    (!skb->mono_delivery_time || t > skb->tstamp))
+		skb_set_delivery_time(skb, t, true);
+
+	return true;
+}
+
 TC_INDIRECT_SCOPE int tcf_police_act(struct sk_buff *skb,
 				     const struct tc_action *a,
 				     struct tcf_result *res)
@@ -273,6 +319,14 @@ TC_INDIRECT_SCOPE int tcf_police_act(struct sk_buff *skb,
 			goto end;
 		}
 
+		if (p->tcfp_edt_horizon) {
+			if (tcf_police_edt(police, p, skb)) {
+				ret = p->tcfp_result;
+				goto inc_drops;
+			}
+			goto inc_overlimits;
+		}
+
 		now = ktime_get_ns();
 		spin_lock_bh(&police->tcfp_lock);
 		toks = min_t(s64, now - police->tcfp_t_c, p->tcfp_burst);
@@ -390,6 +444,10 @@ static int tcf_police_dump(struct sk_buff *skb, struct tc_action *a,
 	if (p->tcfp_ewma_rate &&
 	    nla_put_u32(skb, TCA_POLICE_AVRATE, p->tcfp_ewma_rate))
 		goto nla_put_failure;
+	if (p->tcfp_edt_horizon &&
+	    nla_put_u32(skb, TCA_POLICE_EDT_HORIZON,
+			div_u64(p->tcfp_edt_horizon, NSEC_PER_USEC)))
+		goto nla_put_failure;
 
 	tcf_tm_dump(&t, &police->tcf_tm);
 	if (nla_put_64bit(skb, TCA_POLICE_TM, sizeof(t), &t, TCA_POLICE_PAD))
@@ -448,6 +506,11 @@ static int tcf_police_offload_act_setup(struct tc_action *act, void *entry_data,
 		p = rcu_dereference_protected(police->params,
 					      lockdep_is_held(&police->tcf_lock));
 
+		if (p->tcfp_edt_horizon) {
+			NL_SET_ERR_MSG_MOD(extack, "Offload not supported in EDT mode");
+			return -EOPNOTSUPP;
+		}
+
 		entry->id = FLOW_ACTION_POLICE;
 		entry->police.burst = tcf_police_burst(act);
 		entry->police.rate_bytes_ps =
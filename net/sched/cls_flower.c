@@ -102,6 +102,21 @@ struct fl_flow_tmplt {
 	struct tcf_chain *chain;
 };
 
+/* Per-CPU cache of the mask that last matched a flow, keyed by skb hash.
+ * Entries are valid for one generation of the rule set only.
+ */
+#define FL_MASK_CACHE_SIZE	256
+
+struct fl_mask_cache_entry {
+	u32 hash;
+	u64 gen;
+	struct fl_flow_mask *mask;
+};
+
+struct fl_mask_cache {
+	struct fl_mask_cache_entry entries[FL_MASK_CACHE_SIZE];
+};
+
 struct cls_fl_head {
 	struct rhashtable ht;
 	spinlock_t masks_lock; /* Protect masks list */
@@ -109,6 +124,8 @@ struct cls_fl_head {
 	struct list_head hw_filters;
 	struct rcu_work rwork;
 	struct idr handle_idr;
+	struct fl_mask_cache __percpu *mask_cache; /* TCA_FLOWER_MASK_CACHE */
+	atomic64_t mask_cache_gen;
 };
 
 struct cls_fl_filter {
@@ -310,42 +327,108 @@ static u16 fl_ct_info_to_flower_map[] = {
 					TCA_FLOWER_KEY_CT_FLAGS_NEW,
 };
 
+static struct cls_fl_filter *fl_classify_mask(struct sk_buff *skb,
+					      struct fl_flow_mask *mask,
+					      struct fl_flow_key *skb_key)
+{
+	bool post_ct = tc_skb_cb(skb)->post_ct;
+	u16 zone = tc_skb_cb(skb)->zone;
+	struct cls_fl_filter *f;
+
+	flow_dissector_init_keys(&skb_key->control, &skb_key->basic);
+	fl_clear_masked_range(skb_key, mask);
+
+	skb_flow_dissect_meta(skb, &mask->dissector, skb_key);
+	/* skb_flow_dissect() does not set n_proto in case an unknown
+	 * protocol, so do it rather here.
+	 */
+	skb_key->basic.n_proto = skb_protocol(skb, false);
+	skb_flow_dissect_tunnel_info(skb, &mask->dissector, skb_key);
+	skb_flow_dissect_ct(skb, &mask->dissector, skb_key,
+			    fl_ct_info_to_flower_map,
+			    ARRAY_SIZE(fl_ct_info_to_flower_map),
+			    post_ct, zone);
+	skb_flow_dissect_hash(skb, &mask->dissector, skb_key);
+	skb_flow_dissect(skb, &mask->dissector, skb_key,
+			 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
+
+	f = fl_mask_lookup(mask, skb_key);
+	if (f && !tc_skip_sw(f->flags))
+		return f;
+	return NULL;
+}
+
+/* Called after every change of the rule set: a flow may now match under
+ * another mask, or the cached mask may be gone.
+ */
+static void fl_mask_cache_invalidate(struct cls_fl_head *head)
+{
+	if (READ_ONCE(head->mask_cache))
+		atomic64_inc(&head->mask_cache_gen);
+}
+
+/* Turned on by the first filter that asks for it, for the whole instance */
+static int fl_mask_cache_enable(struct cls_fl_head *head)
+{
+	struct fl_mask_cache __percpu *cache;
+
+	if (READ_ONCE(head->mask_cache))
+		return 0;
+
+	cache = alloc_percpu(struct fl_mask_cache);
+	if (!cache)
+		return -ENOBUFS;
+	if (cmpxchg(&head->mask_cache, NULL, cache))
+		free_percpu(cache);
+	return 0;
+}
+
 TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 				  const struct tcf_proto *tp,
 				  struct tcf_result *res)
 {
 	struct cls_fl_head *head = rcu_dereference_bh(tp->root);
-	bool post_ct = tc_skb_cb(skb)->post_ct;
-	u16 zone = tc_skb_cb(skb)->zone;
+	struct fl_mask_cache __percpu *cache = READ_ONCE(head->mask_cache);
+	struct fl_mask_cache_entry *e = NULL;
 	struct fl_flow_key skb_key;
 	struct fl_flow_mask *mask;
 	struct cls_fl_filter *f;
+	u32 hash = 0;
+	u64 gen = 0;
 
-	list_for_each_entry_rcu(mask, &head->masks, list) {
-		flow_dissector_init_keys(&skb_key.control, &skb_key.basic);
-		fl_clear_masked_range(&skb_key, mask);
+	/* With many masks, walking all of them costs one dissection and one
+	 * lookup each. Flows of the same hash usually match under the same
+	 * mask, so try that one first.
+	 */
+	if (cache && !list_is_singular(&head->masks))
+		hash = skb_get_hash(skb);
+	if (hash) {
+		gen = atomic64_read_acquire(&head->mask_cache_gen);
+		e = &this_cpu_ptr(cache)->entries[hash &
+						  (FL_MASK_CACHE_SIZE - 1)];
+		if (e->hash == hash && e->gen == gen) {
+			f = fl_classify_mask(skb, e->mask, &skb_key);
+			if (f)
+				goto found;
+		}
+	}
 
-		skb_flow_dissect_meta(skb, &mask->dissector, &skb_key);
-		/* skb_flow_dissect() does not set n_proto in case an unknown
-		 * protocol, so do it rather here.
-		 */
-		skb_key.basic.n_proto = skb_protocol(skb, false);
-		skb_flow_dissect_tunnel_info(skb, &mask->dissector, &skb_key);
-		skb_flow_dissect_ct(skb, &mask->dissector, &skb_key,
-				    fl_ct_info_to_flower_map,
-				    ARRAY_SIZE(fl_ct_info_to_flower_map),
-				    post_ct, zone);
-		skb_flow_dissect_hash(skb, &mask->dissector, &skb_key);
-		skb_flow_dissect(skb, &mask->dissector, &skb_key,
-				 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
-
-		f = fl_mask_lookup(mask, &skb_key);
-		if (f && !tc_skip_sw(f->flags)) {
-			*res = f->res;
-			return tcf_exts_exec(skb, &f->exts, res);
+	list_for_each_entry_rcu(mask, &head->masks, list) {
+		f = fl_classify_mask(skb, mask, &skb_key);
+		if (f) {
+			if (e) {
+				e->hash = hash;
+				e->gen = gen;
+				e->mask = mask;
+			}
+			goto found;
 		}
 	}
 	return -1;
+
+found:
+	*res = f->res;
+	return tcf_exts_exec(skb, &f->exts, res);
 }
 
 static int fl_init(struct tcf_proto *tp)
@@ -564,6 +647,7 @@ static int __fl_delete(struct tcf_proto *tp, struct cls_fl_filter *f,
 	idr_remove(&head->handle_idr, f->handle);
 	list_del_rcu(&f->list);
 	spin_unlock(&tp->lock);
+	fl_mask_cache_invalidate(head);
 
 	*last = fl_mask_put(head, f->mask);
 	if (!tc_skip_hw(f->flags))
@@ -581,6 +665,7 @@ static void fl_destroy_sleepable(struct work_struct *work)
 						rwork);
 
 	rhashtable_destroy(&head->ht);
+	free_percpu(head->mask_cache);
 	kfree(head);
 	module_put(THIS_MODULE);
 }
@@ -731,6 +816,7 @@ static const struct nla_policy fl_policy[TCA_FLOWER_MAX + 1] = {
 	[TCA_FLOWER_KEY_SPI_MASK]	= { .type = NLA_U32 },
 	[TCA_FLOWER_L2_MISS]		= NLA_POLICY_MAX(NLA_U8, 1),
 	[TCA_FLOWER_KEY_CFM]		= { .type = NLA_NESTED },
+	[TCA_FLOWER_MASK_CACHE]		= { .type = NLA_FLAG },
 };
 
 static const struct nla_policy
@@ -2268,6 +2354,12 @@ static int fl_change(struct net *net, struct sk_buff *in_skb,
 		goto errout_tb;
 	}
 
+	if (tb[TCA_FLOWER_MASK_CACHE]) {
+		err = fl_mask_cache_enable(head);
+		if (err)
+			goto errout_tb;
+	}
+
 	fnew = kzalloc(sizeof(*fnew), GFP_KERNEL);
 	if (!fnew) {
 		err = -ENOBUFS;
@@ -2430,6 +2522,7 @@ static int fl_change(struct net *net, struct sk_buff *in_skb,
 		list_add_tail_rcu(&fnew->list, &fnew->mask->filters);
 		spin_unlock(&tp->lock);
 	}
+	fl_mask_cache_invalidate(head);
 
 	*arg = fnew;
 
@@ -3523,6 +3616,10 @@ static int fl_dump(struct net *net, struct tcf_proto *tp, void *fh,
 	if (f->flags && nla_put_u32(skb, TCA_FLOWER_FLAGS, f->flags))
 		goto nla_put_failure_locked;
 
+	if (READ_ONCE(fl_head_dereference(tp)->mask_cache) &&
+	    nla_put_flag(skb, TCA_FLOWER_MASK_CACHE))
+		goto nla_put_failure_locked;
+
 	spin_unlock(&tp->lock);
 
 	if (!skip_hw)
@@ -122,6 +122,7 @@ struct fq_sched_data {
 	u8		rate_enable;
 	u8		fq_trees_log;
 	u8		horizon_drop;
+	u8		shared_pacing;	/* pacing state lives in the socket */
 	u8		prio2band[(TC_PRIO_MAX + 1) >> 2];
 	u32		timer_slack; /* hrtimer slack in ns */
 
@@ -683,6 +684,13 @@ static struct sk_buff *fq_dequeue(struct Qdisc *sch)
 		u64 time_next_packet = max_t(u64, fq_skb_cb(skb)->time_to_send,
 					     f->time_next_packet);
 
+		/* Another fq instance (typically on another TX queue under
+		 * mq) may have sent the previous packet of this socket.
+		 */
+		if (q->shared_pacing && skb->sk && skb->sk == f->sk)
+			time_next_packet = max_t(u64, time_next_packet,
+						 READ_ONCE(skb->sk->sk_pacing_next_ns));
+
 		if (now < time_next_packet) {
 			head->first = f->next;
 			f->time_next_packet = time_next_packet;
@@ -753,6 +761,9 @@ static struct sk_buff *fq_dequeue(struct Qdisc *sch)
 		if (f->time_next_packet)
 			len -= min(len/2, now - f->time_next_packet);
 		f->time_next_packet = now + len;
+		if (q->shared_pacing && skb->sk && skb->sk == f->sk)
+			WRITE_ONCE(skb->sk->sk_pacing_next_ns,
+				   f->time_next_packet);
 	}
 out:
 	qdisc_bstats_update(sch, skb);
@@ -921,6 +932,7 @@ static const struct nla_policy fq_policy[TCA_FQ_MAX + 1] = {
 	[TCA_FQ_HORIZON_DROP]		= { .type = NLA_U8 },
 	[TCA_FQ_PRIOMAP]		= NLA_POLICY_EXACT_LEN(sizeof(struct tc_prio_qopt)),
 	[TCA_FQ_WEIGHTS]		= NLA_POLICY_EXACT_LEN(FQ_BANDS * sizeof(s32)),
+	[TCA_FQ_SHARED_PACING]		= { .type = NLA_U8 },
 };
 
 /* compress a u8 array with all elems <= 3 to an array of 2-bit fields */
@@ -1081,6 +1093,9 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 	if (tb[TCA_FQ_HORIZON_DROP])
 		q->horizon_drop = nla_get_u8(tb[TCA_FQ_HORIZON_DROP]);
 
+	if (tb[TCA_FQ_SHARED_PACING])
+		q->shared_pacing = nla_get_u8(tb[TCA_FQ_SHARED_PACING]);
+
 	if (!err) {
 
 		sch_tree_unlock(sch);
@@ -1193,7 +1208,8 @@ static int fq_dump(struct Qdisc *sch, struct sk_buff *skb)
 	    nla_put_u32(skb, TCA_FQ_BUCKETS_LOG, q->fq_trees_log) ||
 	    nla_put_u32(skb, TCA_FQ_TIMER_SLACK, q->timer_slack) ||
 	    nla_put_u32(skb, TCA_FQ_HORIZON, (u32)horizon) ||
-	    nla_put_u8(skb, TCA_FQ_HORIZON_DROP, q->horizon_drop))
+	    nla_put_u8(skb, TCA_FQ_HORIZON_DROP, q->horizon_drop) ||
+	    nla_put_u8(skb, TCA_FQ_SHARED_PACING, q->shared_pacing))
 		goto nla_put_failure;
 
 	fq_prio2band_decompress_crumb(q->prio2band, prio.priomap);
@@ -278,7 +278,7 @@ static void drop_func(struct sk_buff *skb, void *ctx)
 	qdisc_qstats_drop(sch);
 }
 
-static struct sk_buff *fq_codel_dequeue(struct Qdisc *sch)
+static struct sk_buff *__fq_codel_dequeue(struct Qdisc *sch)
 {
 	struct fq_codel_sched_data *q = qdisc_priv(sch);
 	struct sk_buff *skb;
@@ -314,6 +314,13 @@ static struct sk_buff *fq_codel_dequeue(struct Qdisc *sch)
 	}
 	qdisc_bstats_update(sch, skb);
 	flow->deficit -= qdisc_pkt_len(skb);
+	return skb;
+}
+
+static void fq_codel_flush_drops(struct Qdisc *sch)
+{
+	struct fq_codel_sched_data *q = qdisc_priv(sch);
+
 	/* We cant call qdisc_tree_reduce_backlog() if our qlen is 0,
 	 * or HTB crashes. Defer it for next round.
 	 */
@@ -323,9 +330,49 @@ static struct sk_buff *fq_codel_dequeue(struct Qdisc *sch)
 		q->cstats.drop_count = 0;
 		q->cstats.drop_len = 0;
 	}
+}
+
+static struct sk_buff *fq_codel_dequeue(struct Qdisc *sch)
+{
+	struct sk_buff *skb = __fq_codel_dequeue(sch);
+
+	if (skb)
+		fq_codel_flush_drops(sch);
 	return skb;
 }
 
+/* Used by dequeue_skb() instead of one fq_codel_dequeue() per packet:
+ * CoDel drops are propagated to the parents once for the whole batch.
+ */
+static struct sk_buff *fq_codel_dequeue_batch(struct Qdisc *sch,
+					      int bytelimit, int *packets)
+{
+	struct sk_buff *skb, *head, *tail;
+
+	head = __fq_codel_dequeue(sch);
+	if (!head) {
+		*packets = 0;
+		return NULL;
+	}
+
+	*packets = 1;
+	bytelimit -= head->len;
+	tail = head;
+	while (bytelimit > 0) {
+		skb = __fq_codel_dequeue(sch);
+		if (!skb)
+			break;
+		bytelimit -= skb->len; /* covers GSO len */
+		tail->next = skb;
+		tail = skb;
+		(*packets)++; /* GSO counts as one pkt */
+	}
+	skb_mark_not_on_list(tail);
+
+	fq_codel_flush_drops(sch);
+	return head;
+}
+
 static void fq_codel_flow_purge(struct fq_codel_flow *flow)
 {
 	rtnl_kfree_skbs(flow->head, flow->tail);
@@ -708,6 +755,7 @@ static struct Qdisc_ops fq_codel_qdisc_ops __read_mostly = {
 	.priv_size	=	sizeof(struct fq_codel_sched_data),
 	.enqueue	=	fq_codel_enqueue,
 	.dequeue	=	fq_codel_dequeue,
+	.dequeue_batch	=	fq_codel_dequeue_batch,
 	.peek		=	qdisc_peek_dequeued,
 	.init		=	fq_codel_init,
 	.reset		=	fq_codel_reset,
@@ -290,6 +290,11 @@ static struct sk_buff *dequeue_skb(struct Qdisc *q, bool *validate,
 			return NULL;
 		goto bulk;
 	}
+	if (q->ops->dequeue_batch && qdisc_may_bulk(q)) {
+		skb = q->ops->dequeue_batch(q, qdisc_avail_bulklimit(txq),
+					    packets);
+		goto trace;
+	}
 	skb = q->dequeue(q);
 	if (skb) {
 bulk:
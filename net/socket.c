@@ -2239,7 +2239,7 @@ int __sys_recvfrom(int fd, void __user *ubuf, size_t size, unsigned int flags,
 
 	if (sock->file->f_flags & O_NONBLOCK)
 		flags |= MSG_DONTWAIT;
-	err = sock_recvmsg(sock, &msg, flags);
+	err = sock_recvmsg(sock, &msg, flags & ~MSG_BATCH);
 
 	if (err >= 0 && addr != NULL) {
 		err2 = move_addr_to_user(&address,
@@ -2855,7 +2855,7 @@ long __sys_recvmsg_sock(struct socket *sock, struct msghdr *msg,
 			struct user_msghdr __user *umsg,
 			struct sockaddr __user *uaddr, unsigned int flags)
 {
-	return ____sys_recvmsg(sock, msg, umsg, uaddr, flags, 0);
+	return ____sys_recvmsg(sock, msg, umsg, uaddr, flags & ~MSG_BATCH, 0);
 }
 
 long __sys_recvmsg(int fd, struct user_msghdr __user *msg, unsigned int flags,
@@ -2872,7 +2872,7 @@ long __sys_recvmsg(int fd, struct user_msghdr __user *msg, unsigned int flags,
 	if (!sock)
 		goto out;
 
-	err = ___sys_recvmsg(sock, msg, &msg_sys, flags, 0);
+	err = ___sys_recvmsg(sock, msg, &msg_sys, flags & ~MSG_BATCH, 0);
 
 	fput_light(sock->file, fput_needed);
 out:
@@ -2897,6 +2897,7 @@ static int do_recvmmsg(int fd, struct mmsghdr __user *mmsg,
 	struct socket *sock;
 	struct mmsghdr __user *entry;
 	struct compat_mmsghdr __user *compat_entry;
+	struct msg_recv_batch batch;
 	struct msghdr msg_sys;
 	struct timespec64 end_time;
 	struct timespec64 timeout64;
@@ -2923,7 +2924,16 @@ static int do_recvmmsg(int fd, struct mmsghdr __user *mmsg,
 	entry = mmsg;
 	compat_entry = (struct compat_mmsghdr __user *)mmsg;
 
+	msg_sys.msg_batch = NULL;
+	if (flags & MSG_BATCH) {
+		__skb_queue_head_init(&batch.queue);
+		batch.size = 0;
+		batch.flush = NULL;
+		msg_sys.msg_batch = &batch;
+	}
+
 	while (datagrams < vlen) {
+		batch.max = vlen - datagrams;
 		/*
 		 * No need to ask LSM for more than the first datagram.
 		 */
@@ -2973,6 +2983,9 @@ static int do_recvmmsg(int fd, struct mmsghdr __user *mmsg,
 		cond_resched();
 	}
 
+	if (msg_sys.msg_batch && batch.flush)
+		batch.flush(batch.sk, &batch);
+
 	if (err == 0)
 		goto out_put;
 
@@ -36,6 +36,7 @@
  */
 
 #include <linux/bug.h>
+#include <linux/highmem.h>
 #include <linux/sched/signal.h>
 #include <linux/module.h>
 #include <linux/kernel.h>
@@ -54,6 +55,7 @@ struct tls_decrypt_arg {
 	bool async;
 	bool async_done;
 	u8 tail;
+	u16 zc_pad;
 	);
 
 	struct sk_buff *skb;
@@ -167,6 +169,9 @@ static int tls_padding_length(struct tls_prot_info *prot, struct sk_buff *skb,
 		char content_type = darg->zc ? darg->tail : 0;
 		int err;
 
+		if (darg->zc)
+			sub = darg->zc_pad;
+
 		while (content_type == 0) {
 			if (offset < prot->prepend_size)
 				return -EBADMSG;
@@ -1458,6 +1463,26 @@ tls_alloc_clrtxt_skb(struct sock *sk, struct sk_buff *skb,
  * NULL, then the decryption happens inside skb buffers itself, i.e.
  * zero-copy gets disabled and 'darg->zc' is updated.
  */
+/* Number of zeros at the end of the user pages of a zero-copy decrypt */
+static int tls_zc_padding_length(struct scatterlist *sg, int pages, u8 *tail)
+{
+	int i, j, pad = 0;
+
+	for (i = pages; i > 0; i--) {
+		u8 *p = kmap_local_page(sg_page(&sg[i])) + sg[i].offset;
+
+		for (j = sg[i].length - 1; j >= 0 && !p[j]; j--)
+			pad++;
+		if (j >= 0)
+			*tail = p[j];
+		kunmap_local(p);
+		if (j >= 0)
+			return pad;
+	}
+
+	return pad;
+}
+
 static int tls_decrypt_sg(struct sock *sk, struct iov_iter *out_iov,
 			  struct scatterlist *out_sg,
 			  struct tls_decrypt_arg *darg)
@@ -1619,6 +1644,26 @@ static int tls_decrypt_sg(struct sock *sk, struct iov_iter *out_iov,
 	if (prot->tail_size)
 		darg->tail = dctx->tail;
 
+	/* A padded TLS 1.3 record decrypted straight into the user buffer
+	 * leaves its content type and part of the padding there. Find the
+	 * content type and give the bytes past the data back to the iterator.
+	 * Records which are not data are decrypted again by the caller,
+	 * without zero-copy.
+	 */
+	if (darg->zc && out_iov && prot->version == TLS_1_3_VERSION) {
+		if (!darg->tail) {
+			int pad = tls_zc_padding_length(sgout, pages,
+							&darg->tail);
+
+			if (darg->tail == TLS_RECORD_TYPE_DATA) {
+				darg->zc_pad = pad + 1;
+				iov_iter_revert(out_iov, pad + 1);
+			}
+		}
+		if (darg->tail != TLS_RECORD_TYPE_DATA)
+			iov_iter_revert(out_iov, data_len);
+	}
+
 exit_free_pages:
 	/* Release the pages in case iov was mapped to pages */
 	for (; pages > 0; pages--)
@@ -2608,8 +2653,10 @@ void tls_update_rx_zc_capable(struct tls_context *tls_ctx)
 {
 	struct tls_sw_context_rx *rx_ctx = tls_sw_ctx_rx(tls_ctx);
 
-	rx_ctx->zc_capable = tls_ctx->rx_no_pad ||
-		tls_ctx->prot_info.version != TLS_1_3_VERSION;
+	/* TLS 1.3 records with padding are repaired after the decrypt, the
+	 * no-padding promise only saves the retry of non-data records.
+	 */
+	rx_ctx->zc_capable = true;
 }
 
 static struct tls_sw_context_tx *init_ctx_tx(struct tls_context *ctx, struct sock *sk)
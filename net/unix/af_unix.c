@@ -2242,6 +2242,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
 	struct sock *sk = sock->sk;
+	struct ubuf_info *uarg = NULL;
 	struct sock *other = NULL;
 	int err, size;
 	struct sk_buff *skb;
@@ -2279,6 +2280,19 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (READ_ONCE(sk->sk_shutdown) & SEND_SHUTDOWN)
 		goto pipe_err;
 
+	/* The pages of the sender are pinned and attached to the skbs, the
+	 * receiver copies straight from them and the completion is queued on
+	 * the error queue of the sender once the skbs are consumed.
+	 */
+	if ((msg->msg_flags & MSG_ZEROCOPY) && sock_flag(sk, SOCK_ZEROCOPY) &&
+	    !(msg->msg_flags & MSG_SPLICE_PAGES) && len) {
+		uarg = msg_zerocopy_realloc(sk, len, NULL);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	while (sent < len) {
 		size = len - sent;
 
@@ -2286,6 +2300,11 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			skb = sock_alloc_send_pskb(sk, 0, 0,
 						   msg->msg_flags & MSG_DONTWAIT,
 						   &err, 0);
+		} else if (uarg) {
+			size = min_t(int, size, (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
+			skb = sock_alloc_send_pskb(sk, 0, 0,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err, 0);
 		} else {
 			/* Keep two messages in the pipe so it schedules better */
 			size = min_t(int, size, (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
@@ -2321,6 +2340,17 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			}
 			size = err;
 			refcount_add(size, &sk->sk_wmem_alloc);
+		} else if (uarg) {
+			/* Charged to sk_wmem_alloc like the other skbs */
+			err = __zerocopy_sg_from_iter(NULL, NULL, skb,
+						      &msg->msg_iter, size);
+			if (err == -EFAULT || (err == -EMSGSIZE && !skb->len)) {
+				iov_iter_revert(&msg->msg_iter, skb->len);
+				kfree_skb(skb);
+				goto out_err;
+			}
+			size = skb->len;
+			skb_zcopy_set(skb, uarg, NULL);
 		} else {
 			skb_put(skb, size - data_len);
 			skb->data_len = data_len;
@@ -2356,6 +2386,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 #endif
 
 	scm_destroy(&scm);
+	net_zcopy_put(uarg);
 
 	return sent;
 
@@ -2368,6 +2399,10 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	err = -EPIPE;
 out_err:
 	scm_destroy(&scm);
+	if (sent)
+		net_zcopy_put(uarg);
+	else
+		net_zcopy_put_abort(uarg, true);
 	return sent ? : err;
 }
 
@@ -2549,6 +2584,12 @@ static int unix_read_skb(struct sock *sk, skb_read_actor_t recv_actor)
 	if (!skb)
 		return err;
 
+	/* The skb may outlive the zerocopy completion of its sender */
+	if (skb_orphan_frags_rx(skb, GFP_KERNEL)) {
+		kfree_skb(skb);
+		return -ENOMEM;
+	}
+
 	return recv_actor(sk, skb);
 }
 
@@ -2963,6 +3004,13 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 #ifdef CONFIG_BPF_SYSCALL
 	struct sock *sk = sock->sk;
 	const struct proto *prot = READ_ONCE(sk->sk_prot);
+#endif
+
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sock->sk, msg, size, SOL_UNIX,
+					  UNIX_RECVERR);
+
+#ifdef CONFIG_BPF_SYSCALL
 
 	if (prot != &unix_stream_proto)
 		return prot->recvmsg(sk, msg, size, flags, NULL);
@@ -2974,6 +3022,10 @@ static int unix_stream_splice_actor(struct sk_buff *skb,
 				    int skip, int chunk,
 				    struct unix_stream_read_state *state)
 {
+	/* Pipe buffers may outlive the zerocopy completion of the sender */
+	if (skb_orphan_frags_rx(skb, GFP_KERNEL))
+		return -ENOMEM;
+
 	return skb_splice_bits(skb, state->socket->sk,
 			       UNIXCB(skb).consumed + skip,
 			       state->pipe, chunk, state->splice_flags);
@@ -34,6 +34,7 @@
 
 #define TX_BATCH_SIZE 32
 #define MAX_PER_SOCKET_BUDGET (TX_BATCH_SIZE)
+#define TX_XMIT_MORE_BATCH 16
 
 static DEFINE_PER_CPU(struct list_head, xskmap_flush_list);
 
@@ -782,13 +783,55 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 	return ERR_PTR(err);
 }
 
+/*
+ * Hand the skbs built so far to the driver in one go. Those are the packets of
+ * the last descriptors released from the Tx ring, so the ones the driver did
+ * not take can be given back to the ring for user-space to retry.
+ */
+static int xsk_generic_xmit_batch(struct xdp_sock *xs, struct sk_buff *batch,
+				  bool *sent_frame)
+{
+	struct sk_buff *skb, *unsent;
+	u32 n = 0;
+	int err;
+
+	err = __dev_direct_xmit_list(batch, xs->queue_id, &unsent);
+	if (unsent != batch)
+		*sent_frame = true;
+
+	if (unsent) {
+		/* Tell user-space to retry the send */
+		for (skb = unsent; skb; skb = skb->next)
+			n += xsk_get_num_desc(skb);
+		xskq_cons_cancel_n(xs->tx, n);
+
+		while (unsent) {
+			skb = unsent;
+			unsent = skb->next;
+			skb_mark_not_on_list(skb);
+			xsk_consume_skb(skb);
+		}
+		return -EAGAIN;
+	}
+
+	/* Ignore NET_XMIT_CN as packet might have been sent */
+	if (err == NET_XMIT_DROP) {
+		/* SKB completed but not sent */
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
+	struct sk_buff *batch = NULL, **tail = &batch;
 	struct xdp_sock *xs = xdp_sk(sk);
 	u32 max_batch = TX_BATCH_SIZE;
 	bool sent_frame = false;
 	struct xdp_desc desc;
 	struct sk_buff *skb;
+	u32 nr_batch = 0;
 	int err = 0;
 
 	mutex_lock(&xs->mutex);
@@ -808,6 +851,19 @@ static int __xsk_generic_xmit(struct sock *sk)
 			goto out;
 		}
 
+		/* A pending batch is flushed before a multi-buffer packet is
+		 * started, so that the descriptors of the batch are always the
+		 * last ones released and can be given back on a partial send.
+		 */
+		if (batch && !xs->skb && xp_mb_desc(&desc)) {
+			err = xsk_generic_xmit_batch(xs, batch, &sent_frame);
+			batch = NULL;
+			tail = &batch;
+			nr_batch = 0;
+			if (err)
+				goto out;
+		}
+
 		/* This is the backpressure mechanism for the Tx path.
 		 * Reserve space in the completion queue and only proceed
 		 * if there is space in it. This avoids having to implement
@@ -832,25 +888,25 @@ static int __xsk_generic_xmit(struct sock *sk)
 			continue;
 		}
 
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
-			xsk_consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
-		}
+		xs->skb = NULL;
+		*tail = skb;
+		tail = &skb->next;
+		if (++nr_batch < TX_XMIT_MORE_BATCH)
+			continue;
 
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
-			xs->skb = NULL;
+		err = xsk_generic_xmit_batch(xs, batch, &sent_frame);
+		batch = NULL;
+		tail = &batch;
+		nr_batch = 0;
+		if (err)
 			goto out;
-		}
+	}
 
-		sent_frame = true;
-		xs->skb = NULL;
+	if (batch) {
+		err = xsk_generic_xmit_batch(xs, batch, &sent_frame);
+		batch = NULL;
+		if (err)
+			goto out;
 	}
 
 	if (xskq_has_descs(xs->tx)) {
@@ -860,6 +916,13 @@ static int __xsk_generic_xmit(struct sock *sk)
 	}
 
 out:
+	if (batch) {
+		int ret = xsk_generic_xmit_batch(xs, batch, &sent_frame);
+
+		if (!err)
+			err = ret;
+	}
+
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
 			sk->sk_write_space(sk);
@@ -0,0 +1,681 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * kernel-hotpaths.c
+ *
+ * A regression suite of kernel hot paths. Every test times single
+ * operations and reports their latency distribution:
+ *
+ *  page-fault   first touch of an anonymous page, by --threads threads
+ *               of the same process
+ *  mmap-munmap  mmap(), touch and munmap() of a 16 page region
+ *  fork         fork(), exit and waitpid() of a process with --rss MB
+ *               of touched anonymous memory
+ *  swap-in      fault back an anonymous page after MADV_PAGEOUT, from
+ *               whatever swap is configured (zram, typically)
+ *  unix-rpc     64 byte request/response over an AF_UNIX socketpair
+ *  tcp-rpc      64 byte request/response over TCP loopback
+ *  wakeup       from FUTEX_WAKE to the woken thread running
+ *
+ * Each test runs once to warm up and then --runs times. The percentiles
+ * are computed over the samples of all the runs, and the spread of the
+ * per-run medians is reported as their coefficient of variation, to tell
+ * real regressions from noise.
+ *
+ * The results can be saved as JSON with --output and compared with a
+ * saved baseline with --baseline: a test regresses when its median or
+ * 99th percentile is more than --threshold percent above the baseline's,
+ * in which case the exit status is non-zero.
+ */
+
+#include <subcmd/parse-options.h>
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/time64.h>
+#include "bench.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#ifndef MADV_PAGEOUT
+#define MADV_PAGEOUT	21
+#endif
+
+#define RPC_MSG_SIZE	64
+#define MMAP_PAGES	16
+
+static unsigned int iterations;		/* 0: per-test default */
+static unsigned int runs = 5;
+static unsigned int nr_threads = 4;
+static unsigned int rss_mb = 256;
+static unsigned int threshold = 5;
+static const char *test_list;
+static const char *output;
+static const char *baseline;
+
+static const struct option options[] = {
+	OPT_STRING('t', "tests", &test_list, "test,...", "Comma separated list of tests to run (default: all)"),
+	OPT_UINTEGER('i', "iterations", &iterations, "Samples per run (default: per test)"),
+	OPT_UINTEGER('r', "runs", &runs, "Number of runs after the warm-up run"),
+	OPT_UINTEGER('j', "threads", &nr_threads, "Threads for the page-fault test"),
+	OPT_UINTEGER('R', "rss", &rss_mb, "Touched memory in MB for the fork test"),
+	OPT_STRING('o', "output", &output, "file", "Write the results as JSON to file ('-' for stdout)"),
+	OPT_STRING('b', "baseline", &baseline, "file", "Compare with the JSON results in file"),
+	OPT_UINTEGER('T', "threshold", &threshold, "Regression threshold in percent"),
+	OPT_END()
+};
+
+static const char * const bench_kernel_hotpaths_usage[] = {
+	"perf bench kernel-hotpaths <options>",
+	NULL
+};
+
+struct hotpath_result {
+	unsigned long	nr;
+	double		mean;
+	u64		p50, p90, p99, p999, max;
+	double		cv;		/* of the per-run medians, in percent */
+};
+
+struct hotpath_test {
+	const char	*name;
+	unsigned int	iterations;
+	/*
+	 * Fill @samples with up to @nr latencies in nanoseconds and return
+	 * how many, < 0 to skip
+	 */
+	int		(*run)(u64 *samples, unsigned int nr);
+	struct hotpath_result result;
+	bool		done;
+};
+
+static long page_size;
+
+static inline u64 now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+struct fault_thread {
+	pthread_t	thread;
+	pthread_barrier_t *barrier;
+	char		*mem;
+	u64		*samples;
+	unsigned int	nr;
+};
+
+static void *fault_thread_fn(void *arg)
+{
+	struct fault_thread *ft = arg;
+	unsigned int i;
+
+	pthread_barrier_wait(ft->barrier);
+	for (i = 0; i < ft->nr; i++) {
+		u64 start = now_ns();
+
+		ft->mem[(size_t)i * page_size] = 1;
+		ft->samples[i] = now_ns() - start;
+	}
+	return NULL;
+}
+
+static int run_page_fault(u64 *samples, unsigned int nr)
+{
+	unsigned int i, threads = max(min(nr_threads, nr), 1U);
+	unsigned int per_thread = nr / threads;
+	struct fault_thread *ft;
+	pthread_barrier_t barrier;
+	size_t size;
+	char *mem;
+
+	size = (size_t)per_thread * threads * page_size;
+	mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+		return -1;
+	madvise(mem, size, MADV_NOHUGEPAGE);
+
+	ft = calloc(threads, sizeof(*ft));
+	if (!ft) {
+		munmap(mem, size);
+		return -1;
+	}
+
+	pthread_barrier_init(&barrier, NULL, threads);
+	for (i = 0; i < threads; i++) {
+		ft[i].barrier = &barrier;
+		ft[i].mem = mem + (size_t)i * per_thread * page_size;
+		ft[i].samples = samples + i * per_thread;
+		ft[i].nr = per_thread;
+		if (pthread_create(&ft[i].thread, NULL, fault_thread_fn, &ft[i]))
+			exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < threads; i++)
+		pthread_join(ft[i].thread, NULL);
+	pthread_barrier_destroy(&barrier);
+
+	free(ft);
+	munmap(mem, size);
+	/* Not @nr when it doesn't divide evenly among the threads */
+	return per_thread * threads;
+}
+
+static int run_mmap_munmap(u64 *samples, unsigned int nr)
+{
+	size_t size = MMAP_PAGES * page_size;
+	unsigned int i, j;
+
+	for (i = 0; i < nr; i++) {
+		u64 start = now_ns();
+		char *mem;
+
+		mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mem == MAP_FAILED)
+			return -1;
+		for (j = 0; j < MMAP_PAGES; j++)
+			mem[(size_t)j * page_size] = 1;
+		munmap(mem, size);
+		samples[i] = now_ns() - start;
+	}
+	return nr;
+}
+
+static int run_fork(u64 *samples, unsigned int nr)
+{
+	size_t size = (size_t)rss_mb << 20;
+	unsigned int i;
+	char *mem;
+
+	mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+		return -1;
+	memset(mem, 1, size);
+
+	for (i = 0; i < nr; i++) {
+		u64 start = now_ns();
+		pid_t pid = fork();
+
+		if (pid < 0) {
+			munmap(mem, size);
+			return -1;
+		}
+		if (!pid)
+			_exit(0);
+		waitpid(pid, NULL, 0);
+		samples[i] = now_ns() - start;
+	}
+
+	munmap(mem, size);
+	return nr;
+}
+
+static int run_swap_in(u64 *samples, unsigned int nr)
+{
+	unsigned int i;
+	unsigned char vec;
+	char *mem;
+
+	mem = mmap(NULL, page_size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+		return -1;
+
+	for (i = 0; i < nr; i++) {
+		u64 start;
+
+		WRITE_ONCE(mem[0], i);
+		if (madvise(mem, page_size, MADV_PAGEOUT) ||
+		    mincore(mem, page_size, &vec) || (vec & 1)) {
+			fprintf(stderr, "swap-in: page was not swapped out, is swap configured?\n");
+			munmap(mem, page_size);
+			return -1;
+		}
+
+		start = now_ns();
+		(void)READ_ONCE(mem[0]);
+		samples[i] = now_ns() - start;
+	}
+
+	munmap(mem, page_size);
+	return nr;
+}
+
+static void *rpc_echo_fn(void *arg)
+{
+	int fd = (long)arg;
+	char buf[RPC_MSG_SIZE];
+
+	while (read(fd, buf, sizeof(buf)) == sizeof(buf)) {
+		if (write(fd, buf, sizeof(buf)) != sizeof(buf))
+			break;
+	}
+	return NULL;
+}
+
+static int rpc_loop(int client, int server, u64 *samples, unsigned int nr)
+{
+	char buf[RPC_MSG_SIZE] = { 0 };
+	pthread_t thread;
+	unsigned int i;
+	int ret = 0;
+
+	if (pthread_create(&thread, NULL, rpc_echo_fn, (void *)(long)server))
+		return -1;
+
+	for (i = 0; i < nr; i++) {
+		u64 start = now_ns();
+
+		if (write(client, buf, sizeof(buf)) != sizeof(buf) ||
+		    read(client, buf, sizeof(buf)) != sizeof(buf)) {
+			ret = -1;
+			break;
+		}
+		samples[i] = now_ns() - start;
+	}
+
+	shutdown(client, SHUT_RDWR);
+	pthread_join(thread, NULL);
+	close(client);
+	close(server);
+	return ret < 0 ? ret : (int)nr;
+}
+
+static int run_unix_rpc(u64 *samples, unsigned int nr)
+{
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+		return -1;
+	return rpc_loop(sv[0], sv[1], samples, nr);
+}
+
+static int run_tcp_rpc(u64 *samples, unsigned int nr)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+	socklen_t len = sizeof(addr);
+	int lfd, client, server, one = 1;
+
+	lfd = socket(AF_INET, SOCK_STREAM, 0);
+	if (lfd < 0)
+		return -1;
+	if (bind(lfd, (struct sockaddr *)&addr, len) || listen(lfd, 1) ||
+	    getsockname(lfd, (struct sockaddr *)&addr, &len)) {
+		close(lfd);
+		return -1;
+	}
+
+	client = socket(AF_INET, SOCK_STREAM, 0);
+	if (client < 0) {
+		close(lfd);
+		return -1;
+	}
+	if (connect(client, (struct sockaddr *)&addr, len)) {
+		close(client);
+		close(lfd);
+		return -1;
+	}
+	server = accept(lfd, NULL, NULL);
+	close(lfd);
+	if (server < 0) {
+		close(client);
+		return -1;
+	}
+
+	setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return rpc_loop(client, server, samples, nr);
+}
+
+static inline long hotpath_futex(uint32_t *uaddr, int op, uint32_t val)
+{
+	return syscall(SYS_futex, uaddr, op | FUTEX_PRIVATE_FLAG, val, NULL, NULL, 0);
+}
+
+struct wakeup_state {
+	uint32_t	word;		/* 1: wake up */
+	uint32_t	ack;		/* 1: woken and about to wait again */
+	u64		wake_ns;
+	u64		*samples;
+	unsigned int	nr;
+};
+
+static void *wakeup_thread_fn(void *arg)
+{
+	struct wakeup_state *ws = arg;
+	unsigned int i;
+
+	for (i = 0; i < ws->nr; i++) {
+		while (!__atomic_load_n(&ws->word, __ATOMIC_ACQUIRE))
+			hotpath_futex(&ws->word, FUTEX_WAIT, 0);
+		ws->samples[i] = now_ns() - ws->wake_ns;
+
+		__atomic_store_n(&ws->word, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&ws->ack, 1, __ATOMIC_RELEASE);
+		hotpath_futex(&ws->ack, FUTEX_WAKE, 1);
+	}
+	return NULL;
+}
+
+static int run_wakeup(u64 *samples, unsigned int nr)
+{
+	struct wakeup_state ws = {
+		.samples = samples,
+		.nr = nr,
+	};
+	pthread_t thread;
+	unsigned int i;
+
+	if (pthread_create(&thread, NULL, wakeup_thread_fn, &ws))
+		return -1;
+
+	for (i = 0; i < nr; i++) {
+		/* Give the thread time to block in FUTEX_WAIT */
+		usleep(50);
+
+		ws.wake_ns = now_ns();
+		__atomic_store_n(&ws.word, 1, __ATOMIC_RELEASE);
+		hotpath_futex(&ws.word, FUTEX_WAKE, 1);
+
+		while (!__atomic_load_n(&ws.ack, __ATOMIC_ACQUIRE))
+			hotpath_futex(&ws.ack, FUTEX_WAIT, 0);
+		__atomic_store_n(&ws.ack, 0, __ATOMIC_RELAXED);
+	}
+
+	pthread_join(thread, NULL);
+	return nr;
+}
+
+static struct hotpath_test tests[] = {
+	{ .name = "page-fault",		.iterations = 100000,	.run = run_page_fault	},
+	{ .name = "mmap-munmap",	.iterations = 20000,	.run = run_mmap_munmap	},
+	{ .name = "fork",		.iterations = 200,	.run = run_fork		},
+	{ .name = "swap-in",		.iterations = 5000,	.run = run_swap_in	},
+	{ .name = "unix-rpc",		.iterations = 50000,	.run = run_unix_rpc	},
+	{ .name = "tcp-rpc",		.iterations = 50000,	.run = run_tcp_rpc	},
+	{ .name = "wakeup",		.iterations = 10000,	.run = run_wakeup	},
+};
+
+static int cmp_u64(const void *a, const void *b)
+{
+	u64 l = *(const u64 *)a, r = *(const u64 *)b;
+
+	return l < r ? -1 : l > r;
+}
+
+static u64 percentile(const u64 *sorted, unsigned long nr, double pct)
+{
+	unsigned long idx = (unsigned long)(pct / 100.0 * (nr - 1) + 0.5);
+
+	return sorted[min(idx, nr - 1)];
+}
+
+static bool test_selected(const char *name)
+{
+	const char *p = test_list;
+	size_t len = strlen(name);
+
+	if (!p)
+		return true;
+
+	while (p && *p) {
+		if (!strncmp(p, name, len) && (p[len] == ',' || !p[len]))
+			return true;
+		p = strchr(p, ',');
+		if (p)
+			p++;
+	}
+	return false;
+}
+
+static int run_test(struct hotpath_test *t)
+{
+	unsigned int nr = iterations ?: t->iterations;
+	struct hotpath_result *res = &t->result;
+	double sum = 0, msum = 0, msq = 0;
+	unsigned long total = 0;
+	u64 *samples, *run_sorted;
+	unsigned int r;
+	unsigned long i;
+	int n;
+
+	samples = calloc((unsigned long)nr * runs, sizeof(*samples));
+	run_sorted = calloc(nr, sizeof(*run_sorted));
+	if (!samples || !run_sorted)
+		goto fail;
+
+	/* Warm-up run, discarded */
+	if (t->run(samples, nr) < 0)
+		goto fail;
+
+	/* Runs may take fewer than @nr samples, pack them */
+	for (r = 0; r < runs; r++) {
+		u64 *s = samples + total;
+		double median;
+
+		n = t->run(s, nr);
+		if (n <= 0)
+			goto fail;
+
+		memcpy(run_sorted, s, n * sizeof(*s));
+		qsort(run_sorted, n, sizeof(*run_sorted), cmp_u64);
+		median = percentile(run_sorted, n, 50);
+		msum += median;
+		msq += median * median;
+		total += n;
+	}
+
+	qsort(samples, total, sizeof(*samples), cmp_u64);
+	for (i = 0; i < total; i++)
+		sum += samples[i];
+
+	res->nr = total;
+	res->mean = sum / total;
+	res->p50 = percentile(samples, total, 50);
+	res->p90 = percentile(samples, total, 90);
+	res->p99 = percentile(samples, total, 99);
+	res->p999 = percentile(samples, total, 99.9);
+	res->max = samples[total - 1];
+	res->cv = 0;
+	if (runs > 1 && msum > 0) {
+		double mean = msum / runs;
+		double var = (msq - msum * mean) / (runs - 1);
+
+		res->cv = (var > 0 ? sqrt(var) : 0) / mean * 100.0;
+	}
+	t->done = true;
+
+	free(run_sorted);
+	free(samples);
+	return 0;
+
+fail:
+	free(run_sorted);
+	free(samples);
+	return -1;
+}
+
+static void print_result(const struct hotpath_test *t)
+{
+	const struct hotpath_result *res = &t->result;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf(" %-12s %10.0f %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+		       " %10" PRIu64 " %12" PRIu64 " %7.2f%%\n",
+		       t->name, res->mean, res->p50, res->p90, res->p99,
+		       res->p999, res->max, res->cv);
+		break;
+	case BENCH_FORMAT_SIMPLE:
+		printf("%s %" PRIu64 "\n", t->name, res->p50);
+		break;
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+	}
+}
+
+/* One test per line, so that the baseline can be read back line by line */
+static int write_json(const char *path)
+{
+	FILE *fp = strcmp(path, "-") ? fopen(path, "w") : stdout;
+	bool first = true;
+	size_t i;
+
+	if (!fp) {
+		fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	fprintf(fp, "{\n");
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		const struct hotpath_test *t = &tests[i];
+		const struct hotpath_result *res = &t->result;
+
+		if (!t->done)
+			continue;
+		fprintf(fp, "%s  \"%s\": { \"unit\": \"ns\", \"samples\": %lu, "
+			"\"mean\": %.1f, \"p50\": %" PRIu64 ", \"p90\": %" PRIu64
+			", \"p99\": %" PRIu64 ", \"p99.9\": %" PRIu64
+			", \"max\": %" PRIu64 ", \"cv_pct\": %.2f }",
+			first ? "" : ",\n", t->name, res->nr, res->mean,
+			res->p50, res->p90, res->p99, res->p999, res->max,
+			res->cv);
+		first = false;
+	}
+	fprintf(fp, "\n}\n");
+
+	if (fp != stdout)
+		fclose(fp);
+	return 0;
+}
+
+static bool json_field(const char *line, const char *key, u64 *val)
+{
+	char pattern[32];
+	const char *p;
+
+	snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+	p = strstr(line, pattern);
+	if (!p)
+		return false;
+	*val = strtoull(p + strlen(pattern), NULL, 10);
+	return true;
+}
+
+static bool regressed(const char *name, const char *what, u64 base, u64 cur)
+{
+	if (!base || cur * 100 <= base * (100 + threshold))
+		return false;
+
+	printf("# REGRESSION %s %s: %" PRIu64 " ns -> %" PRIu64 " ns (+%.1f%%)\n",
+	       name, what, base, cur, ((double)cur / base - 1) * 100);
+	return true;
+}
+
+static int compare_baseline(const char *path)
+{
+	char line[512], name[64];
+	int nr_regressed = 0;
+	FILE *fp;
+	size_t i;
+
+	fp = fopen(path, "r");
+	if (!fp) {
+		fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		u64 p50, p99;
+
+		if (sscanf(line, " \"%63[^\"]\":", name) != 1 ||
+		    !json_field(line, "p50", &p50) ||
+		    !json_field(line, "p99", &p99))
+			continue;
+
+		for (i = 0; i < ARRAY_SIZE(tests); i++) {
+			const struct hotpath_test *t = &tests[i];
+
+			if (!t->done || strcmp(t->name, name))
+				continue;
+			nr_regressed += regressed(name, "p50", p50, t->result.p50);
+			nr_regressed += regressed(name, "p99", p99, t->result.p99);
+		}
+	}
+	fclose(fp);
+
+	if (nr_regressed)
+		printf("# %d regression(s) above %u%% against %s\n",
+		       nr_regressed, threshold, path);
+	else
+		printf("# No regression above %u%% against %s\n", threshold, path);
+
+	return nr_regressed ? 1 : 0;
+}
+
+int bench_kernel_hotpaths(int argc, const char **argv)
+{
+	int ret = 0;
+	size_t i;
+
+	argc = parse_options(argc, argv, options, bench_kernel_hotpaths_usage, 0);
+	if (argc) {
+		usage_with_options(bench_kernel_hotpaths_usage, options);
+		exit(EXIT_FAILURE);
+	}
+	if (!runs)
+		runs = 1;
+
+	page_size = sysconf(_SC_PAGESIZE);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT) {
+		printf("# %u runs, latencies in ns, cv: variation of the per-run medians\n", runs);
+		printf(" %-12s %10s %10s %10s %10s %10s %12s %8s\n", "test",
+		       "mean", "p50", "p90", "p99", "p99.9", "max", "cv");
+	}
+
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		struct hotpath_test *t = &tests[i];
+
+		if (!test_selected(t->name))
+			continue;
+		errno = 0;
+		if (run_test(t)) {
+			fprintf(stderr, "%s: skipped (%s)\n", t->name,
+				errno ? strerror(errno) : "not supported");
+			continue;
+		}
+		print_result(t);
+	}
+
+	if (output && write_json(output))
+		ret = -1;
+	if (baseline && !ret)
+		ret = compare_baseline(baseline);
+
+	return ret;
+}
@@ -21,6 +21,19 @@ static char *directions[] = {
 	"FROM_DEVICE",
 };
 
+static char *modes[] = {
+	"SINGLE",
+	"SG",
+};
+
+static char *iommu_modes[] = {
+	"none",
+	"passthrough",
+	"strict",
+	"lazy",
+	"other",
+};
+
 int main(int argc, char **argv)
 {
 	struct map_benchmark map;
@@ -29,13 +42,13 @@ int main(int argc, char **argv)
 	int threads = 1, seconds = 20, node = -1;
 	/* default dma mask 32bit, bidirectional DMA */
 	int bits = 32, xdelay = 0, dir = DMA_MAP_BIDIRECTIONAL;
-	/* default granule 1 PAGESIZE */
-	int granule = 1;
+	/* default granule 1 PAGESIZE, mapped with dma_map_single */
+	int granule = 1, mode = DMA_MAP_SINGLE_MODE;
 
 	int cmd = DMA_MAP_BENCHMARK;
 	char *p;
 
-	while ((opt = getopt(argc, argv, "t:s:n:b:d:x:g:")) != -1) {
+	while ((opt = getopt(argc, argv, "t:s:n:b:d:x:g:m:")) != -1) {
 		switch (opt) {
 		case 't':
 			threads = atoi(optarg);
@@ -58,6 +71,9 @@ int main(int argc, char **argv)
 		case 'g':
 			granule = atoi(optarg);
 			break;
+		case 'm':
+			mode = atoi(optarg);
+			break;
 		default:
 			return -1;
 		}
@@ -98,6 +114,11 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (mode != DMA_MAP_SINGLE_MODE && mode != DMA_MAP_SG_MODE) {
+		fprintf(stderr, "invalid mapping mode, must be 0 (single) or 1 (sg)\n");
+		exit(1);
+	}
+
 	fd = open("/sys/kernel/debug/dma_map_benchmark", O_RDWR);
 	if (fd == -1) {
 		perror("open");
@@ -112,18 +133,23 @@ int main(int argc, char **argv)
 	map.dma_dir = dir;
 	map.dma_trans_ns = xdelay;
 	map.granule = granule;
+	map.mode = mode;
 
 	if (ioctl(fd, cmd, &map)) {
 		perror("ioctl");
 		exit(1);
 	}
 
-	printf("dma mapping benchmark: threads:%d seconds:%d node:%d dir:%s granule: %d\n",
-			threads, seconds, node, dir[directions], granule);
-	printf("average map latency(us):%.1f standard deviation:%.1f\n",
-			map.avg_map_100ns/10.0, map.map_stddev/10.0);
-	printf("average unmap latency(us):%.1f standard deviation:%.1f\n",
-			map.avg_unmap_100ns/10.0, map.unmap_stddev/10.0);
+	printf("dma mapping benchmark: threads:%d seconds:%d node:%d dir:%s granule: %d mode:%s iommu:%s\n",
+			threads, seconds, node, dir[directions], granule,
+			modes[mode], map.iommu_mode <= DMA_MAP_IOMMU_OTHER ?
+			iommu_modes[map.iommu_mode] : "unknown");
+	printf("average map latency(us):%.1f standard deviation:%.1f p50:<=%.1f p99:<=%.1f\n",
+			map.avg_map_100ns/10.0, map.map_stddev/10.0,
+			map.map_p50_100ns/10.0, map.map_p99_100ns/10.0);
+	printf("average unmap latency(us):%.1f standard deviation:%.1f p50:<=%.1f p99:<=%.1f\n",
+			map.avg_unmap_100ns/10.0, map.unmap_stddev/10.0,
+			map.unmap_p50_100ns/10.0, map.unmap_p99_100ns/10.0);
 
 	return 0;
 }
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * vdso_test_getrandom.c: Test vDSO getrandom()
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/auxv.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <linux/random.h>
+
+#include "../kselftest.h"
+#include "parse_vdso.h"
+
+#ifndef MADV_WIPEONFORK
+#define MADV_WIPEONFORK 18
+#endif
+
+typedef ssize_t (*vgetrandom_t)(void *, size_t, unsigned int, void *, size_t);
+
+static vgetrandom_t vgetrandom;
+static void *state;
+static size_t state_len;
+
+static int check_fill(uint8_t *buf, size_t len)
+{
+	uint8_t zero[64] = { 0 };
+	ssize_t ret;
+
+	ret = vgetrandom(buf, len, 0, state, state_len);
+	if (ret != (ssize_t)len) {
+		printf("getrandom(%zu) returned %zd\n", len, ret);
+		return -1;
+	}
+	if (len >= sizeof(zero) && !memcmp(buf, zero, sizeof(zero))) {
+		printf("getrandom(%zu) returned zeros\n", len);
+		return -1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct vgetrandom_opaque_params params;
+	uint8_t parent[64], child[64], buf[4096];
+	unsigned long sysinfo_ehdr;
+	int pipefd[2], status;
+	size_t len;
+	pid_t pid;
+
+	ksft_print_header();
+	ksft_set_plan(3);
+
+	sysinfo_ehdr = getauxval(AT_SYSINFO_EHDR);
+	if (!sysinfo_ehdr)
+		ksft_exit_skip("AT_SYSINFO_EHDR is not present!\n");
+
+	vdso_init_from_sysinfo_ehdr(sysinfo_ehdr);
+	vgetrandom = (vgetrandom_t)vdso_sym("LINUX_2.6", "__vdso_getrandom");
+	if (!vgetrandom)
+		ksft_exit_skip("__vdso_getrandom is not present\n");
+
+	if (vgetrandom(NULL, 0, 0, &params, ~0UL))
+		ksft_exit_fail_msg("could not get the state parameters\n");
+
+	state_len = params.size_of_opaque_state;
+	state = mmap(NULL, getpagesize(), params.mmap_prot, params.mmap_flags,
+		     -1, 0);
+	if (state == MAP_FAILED)
+		ksft_exit_fail_msg("mmap failed\n");
+	if (madvise(state, getpagesize(), MADV_WIPEONFORK))
+		ksft_exit_fail_msg("madvise failed\n");
+
+	/* Cover the batch, whole blocks, and both together */
+	for (len = 1; len <= sizeof(buf); len = len * 3 + 1) {
+		if (check_fill(buf, len))
+			break;
+	}
+	ksft_test_result(len > sizeof(buf), "fill\n");
+
+	ksft_test_result(vgetrandom(buf, 16, ~0U, state, state_len) < 0,
+			 "unknown flags\n");
+
+	if (pipe(pipefd))
+		ksft_exit_fail_msg("pipe failed\n");
+
+	pid = fork();
+	if (pid < 0)
+		ksft_exit_fail_msg("fork failed\n");
+	if (!pid) {
+		if (check_fill(child, sizeof(child)) ||
+		    write(pipefd[1], child, sizeof(child)) != sizeof(child))
+			exit(1);
+		exit(0);
+	}
+	if (check_fill(parent, sizeof(parent)) ||
+	    read(pipefd[0], child, sizeof(child)) != sizeof(child))
+		memcpy(child, parent, sizeof(child));
+	waitpid(pid, &status, 0);
+	ksft_test_result(WIFEXITED(status) && !WEXITSTATUS(status) &&
+			 memcmp(parent, child, sizeof(child)),
+			 "fork\n");
+
+	ksft_finished();
+}
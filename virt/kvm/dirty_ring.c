@@ -191,6 +191,28 @@ void kvm_dirty_ring_push(struct kvm_vcpu *vcpu, u32 slot, u64 offset)
 		kvm_make_request(KVM_REQ_DIRTY_RING_SOFT_FULL, vcpu);
 }
 
+/*
+ * Userspace may have harvested entries of the ring, e.g. from a separate
+ * reaper thread, before calling KVM_RESET_DIRTY_RINGS.  Reset them from the
+ * VCPU instead of exiting, as long as that doesn't wait for the ioctl.
+ */
+static bool kvm_dirty_ring_try_reset(struct kvm_vcpu *vcpu)
+{
+	struct kvm *kvm = vcpu->kvm;
+	int cleared;
+
+	if (!mutex_trylock(&kvm->slots_lock))
+		return false;
+
+	cleared = kvm_dirty_ring_reset(kvm, &vcpu->dirty_ring);
+	mutex_unlock(&kvm->slots_lock);
+
+	if (cleared)
+		kvm_flush_remote_tlbs(kvm);
+
+	return !kvm_dirty_ring_soft_full(&vcpu->dirty_ring);
+}
+
 bool kvm_dirty_ring_check_request(struct kvm_vcpu *vcpu)
 {
 	/*
@@ -200,7 +222,8 @@ bool kvm_dirty_ring_check_request(struct kvm_vcpu *vcpu)
 	 * the dirty ring is reset by userspace.
 	 */
 	if (kvm_check_request(KVM_REQ_DIRTY_RING_SOFT_FULL, vcpu) &&
-	    kvm_dirty_ring_soft_full(&vcpu->dirty_ring)) {
+	    kvm_dirty_ring_soft_full(&vcpu->dirty_ring) &&
+	    !kvm_dirty_ring_try_reset(vcpu)) {
 		kvm_make_request(KVM_REQ_DIRTY_RING_SOFT_FULL, vcpu);
 		vcpu->run->exit_reason = KVM_EXIT_DIRTY_RING_FULL;
 		trace_kvm_dirty_ring_exit(vcpu);
@@ -96,6 +96,13 @@ unsigned int halt_poll_ns_shrink;
 module_param(halt_poll_ns_shrink, uint, 0644);
 EXPORT_SYMBOL_GPL(halt_poll_ns_shrink);
 
+/*
+ * Only poll if at least this many of the last 8 halts of the vCPU were short
+ * enough to be caught by polling; 0 always polls.
+ */
+static unsigned int halt_poll_predict;
+module_param(halt_poll_predict, uint, 0644);
+
 /*
  * Ordering of locks:
  *
@@ -3848,7 +3855,9 @@ void kvm_vcpu_halt(struct kvm_vcpu *vcpu)
 	if (vcpu->halt_poll_ns > max_halt_poll_ns)
 		vcpu->halt_poll_ns = max_halt_poll_ns;
 
-	do_halt_poll = halt_poll_allowed && vcpu->halt_poll_ns;
+	do_halt_poll = halt_poll_allowed && vcpu->halt_poll_ns &&
+		       hweight8(vcpu->halt_poll_history) >=
+		       min(READ_ONCE(halt_poll_predict), 8U);
 
 	start = cur = poll_end = ktime_get();
 	if (do_halt_poll) {
@@ -3887,6 +3896,10 @@ void kvm_vcpu_halt(struct kvm_vcpu *vcpu)
 		/* Recompute the max halt poll time in case it changed. */
 		max_halt_poll_ns = kvm_vcpu_max_halt_poll_ns(vcpu);
 
+		vcpu->halt_poll_history <<= 1;
+		if (vcpu_valid_wakeup(vcpu) && halt_ns <= max_halt_poll_ns)
+			vcpu->halt_poll_history |= 1;
+
 		if (!vcpu_valid_wakeup(vcpu)) {
 			shrink_halt_poll_ns(vcpu);
 		} else if (max_halt_poll_ns) {